@@ -117,6 +117,33 @@ void	zbx_socket_timeout_set(zbx_socket_t *s, int timeout);
 #define ZBX_TCP_COMPRESS		0x02
 #define ZBX_TCP_LARGE			0x04
 
+#define ZBX_TCP_HEADER_DATA		"ZBXD"
+#define ZBX_TCP_HEADER_LEN		ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA)
+/* header data, protocol flags, large data length and reserved fields */
+#define ZBX_TCP_HEADER_SIZE_MAX		(ZBX_TCP_HEADER_LEN + 1 + 2 * sizeof(zbx_uint64_t))
+
+/* the next expected part of received message */
+#define ZBX_TCP_EXPECT_HEADER		1
+#define ZBX_TCP_EXPECT_VERSION		2
+#define ZBX_TCP_EXPECT_VERSION_VALIDATE	3
+#define ZBX_TCP_EXPECT_LENGTH		4
+#define ZBX_TCP_EXPECT_SIZE		5
+
+typedef struct
+{
+	unsigned char	expect;
+	unsigned char	protocol;
+	/* data length and uncompressed data length of compressed data */
+	zbx_uint64_t	len;
+	zbx_uint64_t	reserved;
+	/* the number of header bytes parsed */
+	size_t		size;
+}
+zbx_tcp_header_t;
+
+size_t	zbx_tcp_header_write(char *buf, unsigned char flags, zbx_uint64_t len, zbx_uint64_t reserved);
+int	zbx_tcp_header_read(const char *buf, size_t len, unsigned char flags, zbx_tcp_header_t *header);
+
 #define ZBX_TCP_SEC_UNENCRYPTED		1		/* do not use encryption with this socket */
 #define ZBX_TCP_SEC_TLS_PSK		2		/* use TLS with pre-shared key (PSK) with this socket */
 #define ZBX_TCP_SEC_TLS_CERT		4		/* use TLS with certificate with this socket */
@@ -538,6 +538,10 @@ DB_ROW		DBfetch(DB_RESULT result);
 int		DBis_null(const char *field);
 void		DBbegin(void);
 int		DBcommit(void);
+#ifdef HAVE_POSTGRESQL
+void		DBcommit_send(void);
+int		DBcommit_result(void);
+#endif
 void		DBrollback(void);
 int		DBend(int ret);
 
@@ -742,6 +746,29 @@ void	zbx_db_insert_add_values(zbx_db_insert_t *self, ...);
 int	zbx_db_insert_execute(zbx_db_insert_t *self);
 void	zbx_db_insert_clean(zbx_db_insert_t *self);
 void	zbx_db_insert_autoincrement(zbx_db_insert_t *self, const char *field_name);
+
+#ifdef HAVE_POSTGRESQL
+/* database bulk load data */
+typedef struct
+{
+	/* the target table */
+	const ZBX_TABLE		*table;
+	/* the fields to load (pointers to the ZBX_FIELD structures from database schema) */
+	zbx_vector_ptr_t	fields;
+	/* the rows encoded in PostgreSQL binary copy format */
+	char			*data;
+	size_t			data_alloc;
+	size_t			data_offset;
+	int			rows_num;
+}
+zbx_db_copy_t;
+
+void	zbx_db_copy_prepare(zbx_db_copy_t *self, const char *table, ...);
+void	zbx_db_copy_add_values(zbx_db_copy_t *self, ...);
+int	zbx_db_copy_execute(zbx_db_copy_t *self);
+void	zbx_db_copy_clean(zbx_db_copy_t *self);
+#endif
+
 int	zbx_db_get_database_type(void);
 
 /* agent (ZABBIX, SNMP, IPMI, JMX) availability data */
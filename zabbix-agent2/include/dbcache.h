@@ -42,7 +42,8 @@
 
 #define MAX_JAVA_ITEMS		32
 #define MAX_SNMP_ITEMS		128
-#define MAX_POLLER_ITEMS	128	/* MAX(MAX_JAVA_ITEMS, MAX_SNMP_ITEMS) */
+#define MAX_AGENT_ITEMS		128
+#define MAX_POLLER_ITEMS	128	/* MAX(MAX_JAVA_ITEMS, MAX_SNMP_ITEMS, MAX_AGENT_ITEMS) */
 #define MAX_PINGER_ITEMS	128
 
 #define ZBX_TRIGGER_DEPENDENCY_LEVELS_MAX	32
@@ -66,6 +67,7 @@ extern int	CONFIG_JAVAPOLLER_FORKS;
 extern int	CONFIG_PINGER_FORKS;
 extern int	CONFIG_UNREACHABLE_PERIOD;
 extern int	CONFIG_UNREACHABLE_DELAY;
+extern int	CONFIG_ASYNC_AGENT_CHECKS;
 extern int	CONFIG_PROXYCONFIG_FREQUENCY;
 extern int	CONFIG_PROXYDATA_FREQUENCY;
 extern int	CONFIG_HISTORYPOLLER_FORKS;
@@ -699,6 +701,7 @@ int	DCconfig_get_interface_by_type(DC_INTERFACE *interface, zbx_uint64_t hostid,
 int	DCconfig_get_interface(DC_INTERFACE *interface, zbx_uint64_t hostid, zbx_uint64_t itemid);
 int	DCconfig_get_poller_nextcheck(unsigned char poller_type);
 int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items);
+int	DCconfig_get_agent_poller_items(unsigned char poller_type, DC_ITEM *items, int max_items);
 int	DCconfig_get_ipmi_poller_items(int now, DC_ITEM *items, int items_num, int *nextcheck);
 int	DCconfig_get_snmp_interfaceids_by_addr(const char *addr, zbx_uint64_t **interfaceids);
 size_t	DCconfig_get_snmp_items_by_interfaceid(zbx_uint64_t interfaceid, DC_ITEM **items);
@@ -836,6 +839,8 @@ void	zbx_dc_correlation_rules_get(zbx_correlation_rules_t *rules);
 
 void	zbx_dc_get_nested_hostgroupids(zbx_uint64_t *groupids, int groupids_num, zbx_vector_uint64_t *nested_groupids);
 void	zbx_dc_get_hostids_by_group_name(const char *name, zbx_vector_uint64_t *hostids);
+void	zbx_dc_get_item_candidates(const zbx_vector_uint64_t *hostids, const char *key, const AGENT_REQUEST *pattern,
+		zbx_vector_uint64_pair_t *itemhosts);
 
 #define ZBX_HC_ITEM_STATUS_NORMAL	0
 #define ZBX_HC_ITEM_STATUS_BUSY		1
@@ -1036,6 +1041,49 @@ int	zbx_hc_check_proxy(zbx_uint64_t proxyid);
 
 void	zbx_dc_eval_expand_user_macros(zbx_eval_context_t *ctx);
 
+/* proxy memory buffer support */
+
+#define ZBX_PB_MODE_DISABLED	0
+#define ZBX_PB_MODE_MEMORY	1
+#define ZBX_PB_MODE_DATABASE	2
+
+/* the minimum proxy memory buffer record identifier, greater than any proxy_history record identifier */
+#define ZBX_PB_HISTORY_ID_MIN	(__UINT64_C(1) << 62)
+
+typedef struct
+{
+	zbx_uint64_t	id;
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	lastlogsize;
+	const char	*value;
+	const char	*source;
+	int		clock;
+	int		ns;
+	int		timestamp;
+	int		severity;
+	int		logeventid;
+	int		mtime;
+	int		write_clock;
+	unsigned char	state;
+	unsigned char	flags;
+}
+zbx_pb_history_t;
+
+typedef void	(*zbx_pb_history_cb_t)(const zbx_pb_history_t *history, void *cb_data);
+
+int	zbx_pb_init(char **error);
+void	zbx_pb_destroy(void);
+void	zbx_pb_flush(void);
+int	zbx_pb_history_add(const ZBX_DC_HISTORY *history, int history_num);
+void	zbx_pb_history_db_end(void);
+int	zbx_pb_history_read_start(zbx_uint64_t *db_offset);
+int	zbx_pb_history_get(zbx_uint64_t lastid, int records_max, zbx_pb_history_cb_t cb, void *cb_data);
+void	zbx_pb_history_read_end(zbx_uint64_t lastid, zbx_uint64_t mem_lastid, zbx_uint64_t db_lastid,
+		int db_update, int db_drained);
+int	zbx_pb_history_set_lastid(zbx_uint64_t lastid, zbx_uint64_t *db_lastid);
+int	zbx_pb_history_get_write_clock(zbx_uint64_t *lastid, int *write_clock);
+int	zbx_pb_history_get_count(void);
+
 void	zbx_db_trigger_explain_expression(const DB_TRIGGER *trigger, char **expression,
 		int (*eval_func_cb)(zbx_variant_t *, DC_ITEM *, const char *, const char *, const zbx_timespec_t *,
 		char **), int recovery);
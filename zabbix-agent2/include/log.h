@@ -64,6 +64,7 @@ extern int	zbx_log_level;
 int		zabbix_open_log(int type, int level, const char *filename, char **error);
 void		__zbx_zabbix_log(int level, const char *fmt, ...) __zbx_attr_format_printf(2, 3);
 void		zabbix_close_log(void);
+void		zabbix_flush_log(void);
 
 #ifndef _WINDOWS
 int		zabbix_increase_log_level(void);
@@ -48,19 +48,34 @@ typedef enum
 #endif
 	ZBX_MUTEX_MODBUS,
 	ZBX_MUTEX_TREND_FUNC,
+	ZBX_MUTEX_CONFIG_QUEUE,
+	ZBX_MUTEX_PROXY_BUFFER,
 	/* NOTE: Do not forget to sync changes here with mutex names in diag_add_locks_info()! */
 	ZBX_MUTEX_COUNT
 }
 zbx_mutex_name_t;
 
+/* the maximum number of value cache stripes, each stripe has its own lock */
+#define ZBX_RWLOCK_VALUECACHE_NUM	8
+
 typedef enum
 {
 	ZBX_RWLOCK_CONFIG = 0,
 	ZBX_RWLOCK_VALUECACHE,
+	ZBX_RWLOCK_VALUECACHE_LAST = ZBX_RWLOCK_VALUECACHE + ZBX_RWLOCK_VALUECACHE_NUM - 1,
 	ZBX_RWLOCK_COUNT,
 }
 zbx_rwlock_name_t;
 
+/* lock contention statistics */
+typedef struct
+{
+	zbx_uint64_t	locks;		/* number of times the lock was acquired */
+	zbx_uint64_t	waits;		/* number of times the lock was busy and had to be waited for */
+	double		wait_time;	/* total time spent waiting for the lock (seconds) */
+}
+zbx_lock_stats_t;
+
 #ifdef HAVE_PTHREAD_PROCESS_SHARED
 #	define ZBX_MUTEX_NULL			NULL
 #	define ZBX_RWLOCK_NULL			NULL
@@ -95,6 +110,9 @@ void		zbx_locks_destroy(void);
 int		zbx_rwlock_create(zbx_rwlock_t *rwlock, zbx_rwlock_name_t name, char **error);
 zbx_mutex_t	zbx_mutex_addr_get(zbx_mutex_name_t mutex_name);
 zbx_rwlock_t	zbx_rwlock_addr_get(zbx_rwlock_name_t rwlock_name);
+int		zbx_mutex_get_stats(zbx_mutex_name_t mutex_name, zbx_lock_stats_t *stats);
+int		zbx_rwlock_get_stats(zbx_rwlock_name_t rwlock_name, zbx_lock_stats_t *write_stats,
+		zbx_lock_stats_t *read_stats);
 #endif	/* _WINDOWS */
 #	define zbx_mutex_lock(mutex)		__zbx_mutex_lock(__FILE__, __LINE__, mutex)
 #	define zbx_mutex_unlock(mutex)		__zbx_mutex_unlock(__FILE__, __LINE__, mutex)
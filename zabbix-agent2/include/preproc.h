@@ -24,6 +24,7 @@
 #include "module.h"
 #include "dbcache.h"
 #include "zbxvariant.h"
+#include "zbxregexp.h"
 
 /* preprocessing step execution result */
 typedef struct
@@ -57,7 +58,7 @@ int	zbx_preprocessor_test(unsigned char value_type, const char *value, const zbx
 		char **preproc_error, char **error);
 
 int	zbx_preprocessor_get_diag_stats(int *total, int *queued, int *processing, int *done,
-		int *pending, char **error);
+		int *pending, zbx_regexp_cache_stats_t *regexp_stats, char **error);
 
 int	zbx_preprocessor_get_top_items(int limit, zbx_vector_ptr_t *items, char **error);
 int	zbx_preprocessor_get_top_oldest_preproc_items(int limit, zbx_vector_ptr_t *items, char **error);
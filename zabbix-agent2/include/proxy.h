@@ -37,18 +37,22 @@
 #define ZBX_PROXY_UPLOAD_DISABLED	1
 #define ZBX_PROXY_UPLOAD_ENABLED	2
 
+/* the binary history data format version supported by server, lower versions must be supported too */
+#define ZBX_HISTORY_BINARY_VERSION	1
+
 int	get_active_proxy_from_request(struct zbx_json_parse *jp, DC_PROXY *proxy, char **error);
 int	zbx_proxy_check_permissions(const DC_PROXY *proxy, const zbx_socket_t *sock, char **error);
 int	check_access_passive_proxy(zbx_socket_t *sock, int send_response, const char *req);
 
 void	update_proxy_lastaccess(const zbx_uint64_t hostid, time_t last_access);
 
-int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, struct zbx_json *j, char **error);
-void	process_proxyconfig(struct zbx_json_parse *jp_data);
+int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, const struct zbx_json_parse *jp_revision, struct zbx_json *j,
+		char **error);
+int	process_proxyconfig(struct zbx_json_parse *jp_data, struct zbx_json *revision);
 
 int	get_interface_availability_data(struct zbx_json *json, int *ts);
 
-int	proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more);
+int	proxy_get_hist_data(struct zbx_json *j, int binary_version, zbx_uint64_t *lastid, int *more);
 int	proxy_get_dhis_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more);
 int	proxy_get_areg_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more);
 void	proxy_set_hist_lastid(const zbx_uint64_t lastid);
@@ -66,6 +70,7 @@ int	proxy_get_history_count(void);
 int	proxy_get_delay(zbx_uint64_t lastid);
 
 int	zbx_get_proxy_protocol_version(struct zbx_json_parse *jp);
+int	zbx_get_history_binary_version(const struct zbx_json_parse *jp);
 void	zbx_update_proxy_data(DC_PROXY *proxy, int version, int lastaccess, int compress, zbx_uint64_t flags_add);
 
 int	process_proxy_history_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_timespec_t *ts, char **info);
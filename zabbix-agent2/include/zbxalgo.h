@@ -183,6 +183,69 @@ void	zbx_hashset_iter_reset(zbx_hashset_t *hs, zbx_hashset_iter_t *iter);
 void	*zbx_hashset_iter_next(zbx_hashset_iter_t *iter);
 void	zbx_hashset_iter_remove(zbx_hashset_iter_t *iter);
 
+/* open addressing hashset */
+
+/* Open addressing hashset stores fixed size entries directly in the slot array and            */
+/* resolves collisions with Robin Hood linear probing. It has the same interface as            */
+/* zbx_hashset_t, but entries are moved by insert, remove and reserve operations - pointers    */
+/* returned by insert and search functions are valid only until the next hashset modification. */
+
+typedef struct
+{
+	zbx_hash_t	hash;
+	zbx_uint32_t	psl;	/* probe sequence length + 1 or 0 for free slot */
+}
+zbx_ohashset_slot_t;
+
+typedef struct
+{
+	zbx_ohashset_slot_t	*slots;
+	char			*data;
+	int			num_slots;
+	int			num_data;
+	size_t			data_size;
+	zbx_hash_func_t		hash_func;
+	zbx_compare_func_t	compare_func;
+	zbx_clean_func_t	clean_func;
+	zbx_mem_malloc_func_t	mem_malloc_func;
+	zbx_mem_realloc_func_t	mem_realloc_func;
+	zbx_mem_free_func_t	mem_free_func;
+}
+zbx_ohashset_t;
+
+void	zbx_ohashset_create(zbx_ohashset_t *hs, size_t init_size, size_t data_size,
+				zbx_hash_func_t hash_func,
+				zbx_compare_func_t compare_func);
+void	zbx_ohashset_create_ext(zbx_ohashset_t *hs, size_t init_size, size_t data_size,
+				zbx_hash_func_t hash_func,
+				zbx_compare_func_t compare_func,
+				zbx_clean_func_t clean_func,
+				zbx_mem_malloc_func_t mem_malloc_func,
+				zbx_mem_realloc_func_t mem_realloc_func,
+				zbx_mem_free_func_t mem_free_func);
+void	zbx_ohashset_destroy(zbx_ohashset_t *hs);
+
+int	zbx_ohashset_reserve(zbx_ohashset_t *hs, int num_data);
+void	*zbx_ohashset_insert(zbx_ohashset_t *hs, const void *data, size_t size);
+void	*zbx_ohashset_search(zbx_ohashset_t *hs, const void *data);
+void	zbx_ohashset_remove(zbx_ohashset_t *hs, const void *data);
+void	zbx_ohashset_remove_direct(zbx_ohashset_t *hs, const void *data);
+
+void	zbx_ohashset_clear(zbx_ohashset_t *hs);
+
+typedef struct
+{
+	zbx_ohashset_t	*hashset;
+	int		start;
+	int		pos;
+	int		index;
+}
+zbx_ohashset_iter_t;
+
+void	zbx_ohashset_iter_reset(zbx_ohashset_t *hs, zbx_ohashset_iter_t *iter);
+void	*zbx_ohashset_iter_next(zbx_ohashset_iter_t *iter);
+void	zbx_ohashset_iter_remove(zbx_ohashset_iter_t *iter);
+
 /* hashmap */
 
 /* currently, we only have a very specialized hashmap */
@@ -283,6 +346,48 @@ void			zbx_binary_heap_remove_direct(zbx_binary_heap_t *heap, zbx_uint64_t key);
 
 void			zbx_binary_heap_clear(zbx_binary_heap_t *heap);
 
+/* hierarchical timer wheel */
+
+/* Timer wheel stores zbx_uint64_t keys with arbitrary auxiliary information scheduled at */
+/* the specified time (seconds). Insert, update and remove operations do not depend on    */
+/* the number of stored elements. Elements become available for retrieval in the order of */
+/* compare function after the wheel is advanced past their scheduled time.                */
+
+#define ZBX_TIMER_WHEEL_LEVELS	4
+#define ZBX_TIMER_WHEEL_SLOTS	(256 + 64 * (ZBX_TIMER_WHEEL_LEVELS - 1))
+
+typedef struct zbx_timer_wheel_node zbx_timer_wheel_node_t;
+
+typedef struct
+{
+	zbx_timer_wheel_node_t	*slots[ZBX_TIMER_WHEEL_SLOTS];
+	zbx_timer_wheel_node_t	*overflow;
+	zbx_uint64_t		bitmap[ZBX_TIMER_WHEEL_SLOTS / 64];
+	int			cursor;		/* elements scheduled before cursor are in the ready heap */
+	zbx_hashset_t		nodes;
+	zbx_binary_heap_t	ready;
+}
+zbx_timer_wheel_t;
+
+void			zbx_timer_wheel_create(zbx_timer_wheel_t *wheel, zbx_compare_func_t compare_func);
+void			zbx_timer_wheel_create_ext(zbx_timer_wheel_t *wheel, zbx_compare_func_t compare_func,
+							zbx_mem_malloc_func_t mem_malloc_func,
+							zbx_mem_realloc_func_t mem_realloc_func,
+							zbx_mem_free_func_t mem_free_func);
+void			zbx_timer_wheel_destroy(zbx_timer_wheel_t *wheel);
+
+int			zbx_timer_wheel_empty(zbx_timer_wheel_t *wheel);
+int			zbx_timer_wheel_elems_num(zbx_timer_wheel_t *wheel);
+void			zbx_timer_wheel_insert(zbx_timer_wheel_t *wheel, const zbx_binary_heap_elem_t *elem, int time);
+void			zbx_timer_wheel_update(zbx_timer_wheel_t *wheel, const zbx_binary_heap_elem_t *elem, int time);
+void			zbx_timer_wheel_remove(zbx_timer_wheel_t *wheel, zbx_uint64_t key);
+void			zbx_timer_wheel_advance(zbx_timer_wheel_t *wheel, int now);
+zbx_binary_heap_elem_t	*zbx_timer_wheel_find_min(zbx_timer_wheel_t *wheel);
+void			zbx_timer_wheel_remove_min(zbx_timer_wheel_t *wheel);
+int			zbx_timer_wheel_min_time(zbx_timer_wheel_t *wheel);
+
+void			zbx_timer_wheel_clear(zbx_timer_wheel_t *wheel);
+
 /* vector */
 
 #define ZBX_VECTOR_DECL(__id, __type)										\
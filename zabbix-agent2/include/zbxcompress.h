@@ -20,8 +20,19 @@
 #ifndef ZABBIX_COMPRESS_H
 #define ZABBIX_COMPRESS_H
 
+#include "zbxalgo.h"
+
+typedef struct zbx_uncompress_stream zbx_uncompress_stream_t;
+
 int	zbx_compress(const char *in, size_t size_in, char **out, size_t *size_out);
+int	zbx_compress_gzip(const char *in, size_t size_in, char **out, size_t *size_out);
 int	zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out);
+int	zbx_compress_chunks(const char *in, size_t size_in, size_t chunk_size, zbx_vector_ptr_t *chunks,
+		size_t *size_out);
+zbx_uncompress_stream_t	*zbx_uncompress_stream_create(char *out, size_t size_out);
+int	zbx_uncompress_stream_write(zbx_uncompress_stream_t *stream, const char *in, size_t size_in);
+int	zbx_uncompress_stream_finish(zbx_uncompress_stream_t *stream, size_t *size_out);
+void	zbx_uncompress_stream_free(zbx_uncompress_stream_t *stream);
 const char	*zbx_compress_strerror(void);
 
 #endif
@@ -91,6 +91,10 @@ void	zbx_db_close(void);
 
 int	zbx_db_begin(void);
 int	zbx_db_commit(void);
+#ifdef HAVE_POSTGRESQL
+int	zbx_db_commit_send(void);
+int	zbx_db_commit_result(void);
+#endif
 int	zbx_db_rollback(void);
 int	zbx_db_txn_level(void);
 int	zbx_db_txn_error(void);
@@ -128,6 +132,9 @@ void		zbx_db_clean_bind_context(zbx_db_bind_context_t *context);
 int		zbx_db_statement_execute(int iters);
 #endif
 int		zbx_db_vexecute(const char *fmt, va_list args);
+#ifdef HAVE_POSTGRESQL
+int		zbx_db_copy_from(const char *sql, const char *data, size_t data_len);
+#endif
 DB_RESULT	zbx_db_vselect(const char *fmt, va_list args);
 DB_RESULT	zbx_db_select_n(const char *query, int n);
 
@@ -59,6 +59,8 @@ void	zbx_history_destroy(void);
 int	zbx_history_add_values(const zbx_vector_ptr_t *history, int *ret_flush);
 int	zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
 		zbx_vector_history_record_t *values);
+int	zbx_history_get_updated_itemids(int value_type, const zbx_vector_uint64_t *itemids, int clock,
+		zbx_vector_uint64_t *updated);
 
 int	zbx_history_requires_trends(int value_type);
 void	zbx_history_check_version(struct zbx_json *json);
@@ -44,6 +44,8 @@ typedef struct
 }
 zbx_ipc_message_t;
 
+typedef struct zbx_ipc_shm zbx_ipc_shm_t;
+
 /* Messaging socket, providing blocking connections to IPC service. */
 /* The IPC socket api is used for simple write/read operations.     */
 typedef struct
@@ -55,6 +57,9 @@ typedef struct
 	unsigned char	rx_buffer[ZBX_IPC_SOCKET_BUFFER_SIZE];
 	zbx_uint32_t	rx_buffer_bytes;
 	zbx_uint32_t	rx_buffer_offset;
+
+	/* shared memory ring for large messages, NULL if not used */
+	zbx_ipc_shm_t	*shm;
 }
 zbx_ipc_socket_t;
 
@@ -116,6 +121,7 @@ int	zbx_ipc_socket_write(zbx_ipc_socket_t *csocket, zbx_uint32_t code, const uns
 		zbx_uint32_t size);
 int	zbx_ipc_socket_read(zbx_ipc_socket_t *csocket, zbx_ipc_message_t *message);
 int	zbx_ipc_socket_connected(const zbx_ipc_socket_t *csocket);
+void	zbx_ipc_socket_enable_shm(zbx_ipc_socket_t *csocket, zbx_uint32_t size);
 
 int	zbx_ipc_async_socket_open(zbx_ipc_async_socket_t *asocket, const char *service_name, int timeout, char **error);
 void	zbx_ipc_async_socket_close(zbx_ipc_async_socket_t *asocket);
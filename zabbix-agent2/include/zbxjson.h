@@ -63,6 +63,7 @@
 #define ZBX_PROTO_TAG_VERSION			"version"
 #define ZBX_PROTO_TAG_INTERFACE_AVAILABILITY	"interface availability"
 #define ZBX_PROTO_TAG_HISTORY_DATA		"history data"
+#define ZBX_PROTO_TAG_HISTORY_DATA_BINARY	"history data binary"
 #define ZBX_PROTO_TAG_DISCOVERY_DATA		"discovery data"
 #define ZBX_PROTO_TAG_AUTOREGISTRATION		"auto registration"
 #define ZBX_PROTO_TAG_MORE			"more"
@@ -180,6 +181,8 @@
 #define ZBX_PROTO_TAG_LASTACCESS		"lastaccess"
 #define ZBX_PROTO_TAG_LASTACCESS_AGE		"lastaccess_age"
 #define ZBX_PROTO_TAG_DB_TIMESTAMP		"db_timestamp"
+#define ZBX_PROTO_TAG_CONFIG_REVISION		"config_revision"
+#define ZBX_PROTO_TAG_HISTORY_BINARY		"history_binary"
 
 #define ZBX_PROTO_VALUE_FAILED		"failed"
 #define ZBX_PROTO_VALUE_SUCCESS		"success"
@@ -294,6 +297,47 @@ void		zbx_json_escape(char **string);
 int		zbx_json_open_path(const struct zbx_json_parse *jp, const char *path, struct zbx_json_parse *out);
 zbx_json_type_t	zbx_json_valuetype(const char *p);
 
+/* json object member index for repeated lookups by name */
+
+typedef struct
+{
+	const char	*name;		/* member name in json text, without quotes */
+	const char	*value;		/* member value in json text */
+	size_t		name_len;
+	zbx_uint32_t	hash;
+}
+zbx_json_index_pair_t;
+
+typedef struct
+{
+	zbx_json_index_pair_t	*pairs;
+	int			pairs_num;
+	int			pairs_alloc;
+
+	/* open addressing hash table of pair indexes increased by one, 0 - free slot */
+	int			*slots;
+	int			slots_num;
+	int			slots_alloc;
+
+	/* the indexed object */
+	struct zbx_json_parse	jp;
+
+	/* set to 1 when member names have escape sequences and must be looked up by linear scan */
+	unsigned char		linear;
+}
+zbx_json_index_t;
+
+void		zbx_json_index_init(zbx_json_index_t *index);
+void		zbx_json_index_clear(zbx_json_index_t *index);
+int		zbx_json_index_load(zbx_json_index_t *index, const struct zbx_json_parse *jp);
+const char	*zbx_json_index_pair_by_name(const zbx_json_index_t *index, const char *name);
+int		zbx_json_index_value_by_name(const zbx_json_index_t *index, const char *name, char *string,
+		size_t len, zbx_json_type_t *type);
+int		zbx_json_index_value_by_name_dyn(const zbx_json_index_t *index, const char *name, char **string,
+		size_t *string_alloc, zbx_json_type_t *type);
+int		zbx_json_index_brackets_by_name(const zbx_json_index_t *index, const char *name,
+		struct zbx_json_parse *out);
+
 /* jsonpath support */
 
 typedef struct zbx_jsonpath_segment zbx_jsonpath_segment_t;
@@ -312,5 +356,7 @@ zbx_jsonpath_t;
 void	zbx_jsonpath_clear(zbx_jsonpath_t *jsonpath);
 int	zbx_jsonpath_compile(const char *path, zbx_jsonpath_t *jsonpath);
 int	zbx_jsonpath_query(const struct zbx_json_parse *jp, const char *path, char **output);
+int	zbx_jsonpath_query_precompiled(const struct zbx_json_parse *jp, const zbx_jsonpath_t *jsonpath,
+		char **output);
 
 #endif /* ZABBIX_ZJSON_H */
@@ -20,8 +20,23 @@
 #ifndef ZABBIX_ZBXPROMETHEUS_H
 #define ZABBIX_ZBXPROMETHEUS_H
 
+#include "zbxalgo.h"
+
+/* parsed prometheus data, indexed by metric name to answer multiple */
+/* pattern queries without parsing the data again                    */
+typedef struct
+{
+	zbx_vector_ptr_t	rows;
+	zbx_hashset_t		index;
+}
+zbx_prometheus_t;
+
 int	zbx_prometheus_pattern(const char *data, const char *filter_data, const char *output, char **value,
 		char **error);
+int	zbx_prometheus_init(zbx_prometheus_t *prom, const char *data, char **error);
+void	zbx_prometheus_clear(zbx_prometheus_t *prom);
+int	zbx_prometheus_pattern_ex(zbx_prometheus_t *prom, const char *filter_data, const char *output, char **value,
+		char **error);
 int	zbx_prometheus_to_json(const char *data, const char *filter_data, char **value, char **error);
 
 int	zbx_prometheus_validate_filter(const char *pattern, char **error);
@@ -36,6 +36,16 @@ typedef struct
 }
 zbx_expression_t;
 
+/* compiled regular expression cache statistics */
+typedef struct
+{
+	zbx_uint64_t	entries;
+	zbx_uint64_t	hits;
+	zbx_uint64_t	misses;
+	zbx_uint64_t	evictions;
+}
+zbx_regexp_cache_stats_t;
+
 /* regular expressions */
 int	zbx_regexp_compile(const char *pattern, zbx_regexp_t **regexp, const char **err_msg_static);
 int	zbx_regexp_compile_ext(const char *pattern, zbx_regexp_t **regexp, int flags, const char **err_msg_static);
@@ -48,6 +58,8 @@ int	zbx_iregexp_sub(const char *string, const char *pattern, const char *output_
 int	zbx_mregexp_sub_precompiled(const char *string, const zbx_regexp_t *regexp, const char *output_template,
 		size_t limit, char **out);
 
+void	zbx_regexp_get_cache_stats(zbx_regexp_cache_stats_t *stats);
+
 void	zbx_regexp_clean_expressions(zbx_vector_ptr_t *expressions);
 
 void	add_regexp_ex(zbx_vector_ptr_t *regexps, const char *name, const char *expression, int expression_type,
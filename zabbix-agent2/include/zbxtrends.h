@@ -46,6 +46,9 @@ int	zbx_trends_eval_max(const char *table, zbx_uint64_t itemid, int start, int e
 int	zbx_trends_eval_min(const char *table, zbx_uint64_t itemid, int start, int end, double *value, char **error);
 int	zbx_trends_eval_sum(const char *table, zbx_uint64_t itemid, int start, int end, double *value, char **error);
 
+void	zbx_trends_prefetch_add(const char *table, zbx_uint64_t itemid, int start, int end, const char *function);
+void	zbx_trends_prefetch(void);
+
 /* trends function cache */
 typedef struct
 {
@@ -60,6 +63,8 @@ int	zbx_tfc_init(char **error);
 void	zbx_tfc_destroy(void);
 int	zbx_tfc_get_stats(zbx_tfc_stats_t *stats, char **error);
 void	zbx_tfc_invalidate_trends(ZBX_DC_TREND *trends, int trends_num);
+int	zbx_tfc_load(char **error);
+int	zbx_tfc_save(char **error);
 
 int	zbx_baseline_get_data(zbx_uint64_t itemid, unsigned char value_type, time_t now, const char *period,
 		int season_num, zbx_time_unit_t season_unit, int skip, zbx_vector_dbl_t *values,
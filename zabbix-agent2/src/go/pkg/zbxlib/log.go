@@ -66,6 +66,11 @@ void	zbx_handle_log(void)
 	// rotation is handled by go logger backend
 }
 
+void	zabbix_flush_log(void)
+{
+	// buffering is handled by go logger backend
+}
+
 int	zbx_redirect_stdio(const char *filename)
 {
 	// rotation is handled by go logger backend
@@ -0,0 +1,377 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "log.h"
+
+#include "zbxalgo.h"
+
+/* Robin Hood hashing with linear probing. Entries of a probe sequence are kept sorted by   */
+/* their home slot, so search can stop as soon as it meets an entry closer to its home slot */
+/* than the searched one would be. Removal shifts the following entries back instead of     */
+/* leaving tombstones.                                                                      */
+
+#define	CRIT_LOAD_FACTOR	7/8
+
+#define ZBX_OHASHSET_DEFAULT_SLOTS	16
+
+#define OHASHSET_DATA(hs, index)	((hs)->data + (size_t)(index) * (hs)->data_size)
+#define OHASHSET_NEXT(hs, index)	(((index) + 1) & ((hs)->num_slots - 1))
+#define OHASHSET_PREV(hs, index)	(((index) - 1) & ((hs)->num_slots - 1))
+
+/* private open addressing hashset functions */
+
+static void	ohashset_free_entry(zbx_ohashset_t *hs, int index)
+{
+	if (NULL != hs->clean_func)
+		hs->clean_func(OHASHSET_DATA(hs, index));
+
+	hs->slots[index].psl = 0;
+}
+
+static int	ohashset_alloc_slots(zbx_ohashset_t *hs, int num_slots)
+{
+	void	*slots;
+
+	if (NULL == (slots = hs->mem_malloc_func(NULL, (size_t)num_slots * (sizeof(zbx_ohashset_slot_t) +
+			hs->data_size))))
+	{
+		return FAIL;
+	}
+
+	hs->slots = (zbx_ohashset_slot_t *)slots;
+	hs->data = (char *)slots + (size_t)num_slots * sizeof(zbx_ohashset_slot_t);
+	hs->num_slots = num_slots;
+
+	memset(hs->slots, 0, (size_t)num_slots * sizeof(zbx_ohashset_slot_t));
+
+	return SUCCEED;
+}
+
+/* return the number of slots (power of two) required to store the specified number of entries */
+static int	ohashset_slots_required(int num_data)
+{
+	int	num_slots = ZBX_OHASHSET_DEFAULT_SLOTS;
+
+	while (num_slots * CRIT_LOAD_FACTOR < num_data)
+		num_slots *= 2;
+
+	return num_slots;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ohashset_place                                                   *
+ *                                                                            *
+ * Purpose: put new entry into its Robin Hood position                        *
+ *                                                                            *
+ * Parameters: hs   - [IN] the hashset, must have at least one free slot      *
+ *             hash - [IN] hash of the entry                                  *
+ *                                                                            *
+ * Return value: index of the slot reserved for the new entry data            *
+ *                                                                            *
+ * Comments: The entries from the insertion position up to the first free     *
+ *           slot are shifted forward by one slot.                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	ohashset_place(zbx_ohashset_t *hs, zbx_hash_t hash)
+{
+	int		index, last;
+	zbx_uint32_t	psl = 1;
+
+	index = hash & (hs->num_slots - 1);
+
+	while (0 != hs->slots[index].psl && hs->slots[index].psl >= psl)
+	{
+		index = OHASHSET_NEXT(hs, index);
+		psl++;
+	}
+
+	for (last = index; 0 != hs->slots[last].psl; last = OHASHSET_NEXT(hs, last))
+		;
+
+	while (last != index)
+	{
+		int	prev = OHASHSET_PREV(hs, last);
+
+		hs->slots[last].hash = hs->slots[prev].hash;
+		hs->slots[last].psl = hs->slots[prev].psl + 1;
+		memcpy(OHASHSET_DATA(hs, last), OHASHSET_DATA(hs, prev), hs->data_size);
+		last = prev;
+	}
+
+	hs->slots[index].hash = hash;
+	hs->slots[index].psl = psl;
+
+	return index;
+}
+
+static int	ohashset_find(zbx_ohashset_t *hs, const void *data)
+{
+	int		index;
+	zbx_uint32_t	psl = 1;
+	zbx_hash_t	hash;
+
+	if (0 == hs->num_data)
+		return FAIL;
+
+	hash = hs->hash_func(data);
+	index = hash & (hs->num_slots - 1);
+
+	while (hs->slots[index].psl >= psl)
+	{
+		if (hs->slots[index].hash == hash && 0 == hs->compare_func(OHASHSET_DATA(hs, index), data))
+			return index;
+
+		index = OHASHSET_NEXT(hs, index);
+		psl++;
+	}
+
+	return FAIL;
+}
+
+/* remove entry at the specified slot, shifting back the following entries of the probe sequence */
+static void	ohashset_remove_index(zbx_ohashset_t *hs, int index)
+{
+	int	next;
+
+	ohashset_free_entry(hs, index);
+	hs->num_data--;
+
+	for (next = OHASHSET_NEXT(hs, index); 1 < hs->slots[next].psl; next = OHASHSET_NEXT(hs, next))
+	{
+		hs->slots[index].hash = hs->slots[next].hash;
+		hs->slots[index].psl = hs->slots[next].psl - 1;
+		memcpy(OHASHSET_DATA(hs, index), OHASHSET_DATA(hs, next), hs->data_size);
+		hs->slots[next].psl = 0;
+		index = next;
+	}
+}
+
+/* public open addressing hashset interface */
+
+void	zbx_ohashset_create(zbx_ohashset_t *hs, size_t init_size, size_t data_size,
+				zbx_hash_func_t hash_func,
+				zbx_compare_func_t compare_func)
+{
+	zbx_ohashset_create_ext(hs, init_size, data_size, hash_func, compare_func, NULL,
+					ZBX_DEFAULT_MEM_MALLOC_FUNC,
+					ZBX_DEFAULT_MEM_REALLOC_FUNC,
+					ZBX_DEFAULT_MEM_FREE_FUNC);
+}
+
+void	zbx_ohashset_create_ext(zbx_ohashset_t *hs, size_t init_size, size_t data_size,
+				zbx_hash_func_t hash_func,
+				zbx_compare_func_t compare_func,
+				zbx_clean_func_t clean_func,
+				zbx_mem_malloc_func_t mem_malloc_func,
+				zbx_mem_realloc_func_t mem_realloc_func,
+				zbx_mem_free_func_t mem_free_func)
+{
+	hs->slots = NULL;
+	hs->data = NULL;
+	hs->num_slots = 0;
+	hs->num_data = 0;
+	hs->data_size = ZBX_SIZE_T_ALIGN8(data_size);
+	hs->hash_func = hash_func;
+	hs->compare_func = compare_func;
+	hs->clean_func = clean_func;
+	hs->mem_malloc_func = mem_malloc_func;
+	hs->mem_realloc_func = mem_realloc_func;
+	hs->mem_free_func = mem_free_func;
+
+	if (0 < init_size)
+		ohashset_alloc_slots(hs, ohashset_slots_required((int)init_size));
+}
+
+void	zbx_ohashset_destroy(zbx_ohashset_t *hs)
+{
+	zbx_ohashset_clear(hs);
+
+	if (NULL != hs->slots)
+	{
+		hs->mem_free_func(hs->slots);
+		hs->slots = NULL;
+		hs->data = NULL;
+	}
+
+	hs->num_slots = 0;
+	hs->hash_func = NULL;
+	hs->compare_func = NULL;
+	hs->mem_malloc_func = NULL;
+	hs->mem_realloc_func = NULL;
+	hs->mem_free_func = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ohashset_reserve                                             *
+ *                                                                            *
+ * Purpose: ensure that hashset can store the specified number of entries     *
+ *          without reallocation                                              *
+ *                                                                            *
+ * Parameters: hs       - [IN] the hashset                                    *
+ *             num_data - [IN] the number of entries                          *
+ *                                                                            *
+ * Return value: SUCCEED - the slots were reserved                            *
+ *               FAIL    - memory allocation failed                           *
+ *                                                                            *
+ * Comments: Reallocation moves all entries.                                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ohashset_reserve(zbx_ohashset_t *hs, int num_data)
+{
+	zbx_ohashset_t	old = *hs;
+	int		i, num_slots;
+
+	if ((num_slots = ohashset_slots_required(num_data)) <= hs->num_slots)
+		return SUCCEED;
+
+	if (SUCCEED != ohashset_alloc_slots(hs, num_slots))
+		return FAIL;
+
+	for (i = 0; i < old.num_slots; i++)
+	{
+		if (0 != old.slots[i].psl)
+			memcpy(OHASHSET_DATA(hs, ohashset_place(hs, old.slots[i].hash)), OHASHSET_DATA(&old, i),
+					hs->data_size);
+	}
+
+	if (NULL != old.slots)
+		hs->mem_free_func(old.slots);
+
+	return SUCCEED;
+}
+
+void	*zbx_ohashset_insert(zbx_ohashset_t *hs, const void *data, size_t size)
+{
+	int	index;
+	char	*entry;
+
+	if (hs->data_size < size)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "inserting " ZBX_FS_SIZE_T " bytes into hashset with " ZBX_FS_SIZE_T
+				" bytes entries", (zbx_fs_size_t)size, (zbx_fs_size_t)hs->data_size);
+		exit(EXIT_FAILURE);
+	}
+
+	if (FAIL != (index = ohashset_find(hs, data)))
+		return OHASHSET_DATA(hs, index);
+
+	if (SUCCEED != zbx_ohashset_reserve(hs, hs->num_data + 1))
+		return NULL;
+
+	entry = OHASHSET_DATA(hs, ohashset_place(hs, hs->hash_func(data)));
+	memcpy(entry, data, size);
+	memset(entry + size, 0, hs->data_size - size);
+	hs->num_data++;
+
+	return entry;
+}
+
+void	*zbx_ohashset_search(zbx_ohashset_t *hs, const void *data)
+{
+	int	index;
+
+	if (FAIL == (index = ohashset_find(hs, data)))
+		return NULL;
+
+	return OHASHSET_DATA(hs, index);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: remove a hashset entry using comparison with the given data       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_ohashset_remove(zbx_ohashset_t *hs, const void *data)
+{
+	int	index;
+
+	if (FAIL != (index = ohashset_find(hs, data)))
+		ohashset_remove_index(hs, index);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: remove a hashset entry using a data pointer returned to the user  *
+ *          by zbx_ohashset_insert() and zbx_ohashset_search() functions      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_ohashset_remove_direct(zbx_ohashset_t *hs, const void *data)
+{
+	ohashset_remove_index(hs, (int)(((const char *)data - hs->data) / hs->data_size));
+}
+
+void	zbx_ohashset_clear(zbx_ohashset_t *hs)
+{
+	int	i;
+
+	for (i = 0; i < hs->num_slots; i++)
+	{
+		if (0 != hs->slots[i].psl)
+			ohashset_free_entry(hs, i);
+	}
+
+	hs->num_data = 0;
+}
+
+/* Iteration starts after a free slot. Free slot never becomes occupied by removal, so the        */
+/* entries shifted back by zbx_ohashset_iter_remove() always come from the slots not visited yet. */
+
+void	zbx_ohashset_iter_reset(zbx_ohashset_t *hs, zbx_ohashset_iter_t *iter)
+{
+	iter->hashset = hs;
+	iter->pos = 0;
+	iter->index = -1;
+
+	for (iter->start = 0; iter->start < hs->num_slots && 0 != hs->slots[iter->start].psl; iter->start++)
+		;
+}
+
+void	*zbx_ohashset_iter_next(zbx_ohashset_iter_t *iter)
+{
+	zbx_ohashset_t	*hs = iter->hashset;
+
+	while (++iter->pos < hs->num_slots)
+	{
+		iter->index = (iter->start + iter->pos) & (hs->num_slots - 1);
+
+		if (0 != hs->slots[iter->index].psl)
+			return OHASHSET_DATA(hs, iter->index);
+	}
+
+	iter->index = -1;
+
+	return NULL;
+}
+
+void	zbx_ohashset_iter_remove(zbx_ohashset_iter_t *iter)
+{
+	if (-1 == iter->index || 0 == iter->hashset->slots[iter->index].psl)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "removing a hashset entry through a bad iterator");
+		exit(EXIT_FAILURE);
+	}
+
+	ohashset_remove_index(iter->hashset, iter->index);
+
+	/* the slot can now hold the next entry, visit it again */
+	iter->pos--;
+}
@@ -0,0 +1,516 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "log.h"
+
+#include "zbxalgo.h"
+
+/* Elements scheduled at or after the wheel cursor are kept in slot lists. Slot of an element is  */
+/* selected by the highest bit in which its time differs from the cursor - level 0 slots hold     */
+/* single seconds of the current 256 second range, each next level slot covers the whole range   */
+/* of the previous level. When cursor enters range of a higher level slot, its elements are       */
+/* redistributed to the lower levels. Elements scheduled before the cursor are kept in the ready  */
+/* heap, ordered by the wheel compare function.                                                   */
+
+#define TIMER_WHEEL_LEVEL0_BITS		8
+#define TIMER_WHEEL_LEVEL_BITS		6
+#define TIMER_WHEEL_LEVEL0_SLOTS	(1 << TIMER_WHEEL_LEVEL0_BITS)
+#define TIMER_WHEEL_LEVEL_SLOTS		(1 << TIMER_WHEEL_LEVEL_BITS)
+
+/* bits of time covered by the wheel, elements further in future are kept in overflow list */
+#define TIMER_WHEEL_BITS		(TIMER_WHEEL_LEVEL0_BITS + TIMER_WHEEL_LEVEL_BITS * (ZBX_TIMER_WHEEL_LEVELS - 1))
+
+#define TIMER_WHEEL_LOCATION_READY	-1
+#define TIMER_WHEEL_LOCATION_OVERFLOW	ZBX_TIMER_WHEEL_SLOTS
+
+struct zbx_timer_wheel_node
+{
+	zbx_uint64_t		key;
+	const void		*data;
+	int			time;
+	int			location;	/* slot index, TIMER_WHEEL_LOCATION_READY or _OVERFLOW */
+	zbx_timer_wheel_node_t	*prev;
+	zbx_timer_wheel_node_t	*next;
+};
+
+/* helper functions */
+
+static int	timer_wheel_level_shift(int level)
+{
+	return 0 == level ? 0 : TIMER_WHEEL_LEVEL0_BITS + TIMER_WHEEL_LEVEL_BITS * (level - 1);
+}
+
+static int	timer_wheel_level_offset(int level)
+{
+	return 0 == level ? 0 : TIMER_WHEEL_LEVEL0_SLOTS + TIMER_WHEEL_LEVEL_SLOTS * (level - 1);
+}
+
+static int	timer_wheel_level_bits(int level)
+{
+	return 0 == level ? TIMER_WHEEL_LEVEL0_BITS : TIMER_WHEEL_LEVEL_BITS;
+}
+
+static int	timer_wheel_level_mask(int level)
+{
+	return (1 << timer_wheel_level_bits(level)) - 1;
+}
+
+/* find the first non-empty slot in range [from, to] of slot indexes, returns FAIL if there is none */
+static int	timer_wheel_find_slot(const zbx_timer_wheel_t *wheel, int from, int to)
+{
+	int		index;
+	zbx_uint64_t	word;
+
+	for (index = from; index <= to;)
+	{
+		if (0 == (word = wheel->bitmap[index >> 6] >> (index & 63)))
+		{
+			index = (index | 63) + 1;
+			continue;
+		}
+
+		while (0 == (word & 1))
+		{
+			word >>= 1;
+			index++;
+		}
+
+		return index <= to ? index : FAIL;
+	}
+
+	return FAIL;
+}
+
+static void	timer_wheel_list_link(zbx_timer_wheel_t *wheel, zbx_timer_wheel_node_t *node, int location)
+{
+	zbx_timer_wheel_node_t	**head;
+
+	head = (TIMER_WHEEL_LOCATION_OVERFLOW == location ? &wheel->overflow : &wheel->slots[location]);
+
+	if (NULL == *head && TIMER_WHEEL_LOCATION_OVERFLOW != location)
+		wheel->bitmap[location >> 6] |= __UINT64_C(1) << (location & 63);
+
+	node->location = location;
+	node->prev = NULL;
+	node->next = *head;
+
+	if (NULL != *head)
+		(*head)->prev = node;
+
+	*head = node;
+}
+
+static void	timer_wheel_list_unlink(zbx_timer_wheel_t *wheel, zbx_timer_wheel_node_t *node)
+{
+	if (NULL != node->next)
+		node->next->prev = node->prev;
+
+	if (NULL != node->prev)
+	{
+		node->prev->next = node->next;
+		return;
+	}
+
+	if (TIMER_WHEEL_LOCATION_OVERFLOW == node->location)
+	{
+		wheel->overflow = node->next;
+		return;
+	}
+
+	if (NULL == (wheel->slots[node->location] = node->next))
+		wheel->bitmap[node->location >> 6] &= ~(__UINT64_C(1) << (node->location & 63));
+}
+
+/* put node in the ready heap or the slot matching its time */
+static void	timer_wheel_place(zbx_timer_wheel_t *wheel, zbx_timer_wheel_node_t *node)
+{
+	zbx_uint32_t	diff;
+	int		level;
+
+	if (node->time < wheel->cursor)
+	{
+		zbx_binary_heap_elem_t	elem = {node->key, node->data};
+
+		node->location = TIMER_WHEEL_LOCATION_READY;
+		zbx_binary_heap_insert(&wheel->ready, &elem);
+		return;
+	}
+
+	diff = (zbx_uint32_t)node->time ^ (zbx_uint32_t)wheel->cursor;
+
+	if (0 != (diff >> TIMER_WHEEL_BITS))
+	{
+		timer_wheel_list_link(wheel, node, TIMER_WHEEL_LOCATION_OVERFLOW);
+		return;
+	}
+
+	for (level = ZBX_TIMER_WHEEL_LEVELS - 1; 0 < level; level--)
+	{
+		if (0 != (diff >> timer_wheel_level_shift(level)))
+			break;
+	}
+
+	timer_wheel_list_link(wheel, node, timer_wheel_level_offset(level) +
+			(node->time >> timer_wheel_level_shift(level) & timer_wheel_level_mask(level)));
+}
+
+static void	timer_wheel_unplace(zbx_timer_wheel_t *wheel, zbx_timer_wheel_node_t *node)
+{
+	if (TIMER_WHEEL_LOCATION_READY == node->location)
+		zbx_binary_heap_remove_direct(&wheel->ready, node->key);
+	else
+		timer_wheel_list_unlink(wheel, node);
+}
+
+/* re-place all nodes of the specified list relative to the current cursor */
+static void	timer_wheel_cascade(zbx_timer_wheel_t *wheel, int location)
+{
+	zbx_timer_wheel_node_t	*node, *next;
+
+	if (TIMER_WHEEL_LOCATION_OVERFLOW == location)
+	{
+		node = wheel->overflow;
+		wheel->overflow = NULL;
+	}
+	else
+	{
+		node = wheel->slots[location];
+		wheel->slots[location] = NULL;
+		wheel->bitmap[location >> 6] &= ~(__UINT64_C(1) << (location & 63));
+	}
+
+	for (; NULL != node; node = next)
+	{
+		next = node->next;
+		timer_wheel_place(wheel, node);
+	}
+}
+
+/* move cursor forward, elements before the new cursor position must be already moved to ready heap */
+static void	timer_wheel_set_cursor(zbx_timer_wheel_t *wheel, int cursor)
+{
+	zbx_uint32_t	diff;
+	int		level;
+
+	if (cursor <= wheel->cursor)
+		return;
+
+	diff = (zbx_uint32_t)cursor ^ (zbx_uint32_t)wheel->cursor;
+	wheel->cursor = cursor;
+
+	if (0 != (diff >> TIMER_WHEEL_BITS))
+		timer_wheel_cascade(wheel, TIMER_WHEEL_LOCATION_OVERFLOW);
+
+	for (level = ZBX_TIMER_WHEEL_LEVELS - 1; 0 < level; level--)
+	{
+		if (0 == (diff >> timer_wheel_level_shift(level)))
+			continue;
+
+		timer_wheel_cascade(wheel, timer_wheel_level_offset(level) +
+				(cursor >> timer_wheel_level_shift(level) & timer_wheel_level_mask(level)));
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: timer_wheel_next_slot                                            *
+ *                                                                            *
+ * Purpose: find the earliest non-empty slot after cursor                     *
+ *                                                                            *
+ * Parameters: wheel    - [IN] the timer wheel                                *
+ *             location - [OUT] the slot index or overflow list location      *
+ *                                                                            *
+ * Return value: The start time of the slot - all elements in the slot are    *
+ *               scheduled at or after this time. FAIL if the wheel slots are *
+ *               empty.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	timer_wheel_next_slot(const zbx_timer_wheel_t *wheel, int *location)
+{
+	int		level, shift, from, index;
+	zbx_uint32_t	range;
+
+	for (level = 0; level < ZBX_TIMER_WHEEL_LEVELS; level++)
+	{
+		shift = timer_wheel_level_shift(level);
+		from = (wheel->cursor >> shift & timer_wheel_level_mask(level));
+
+		/* the current higher level slot elements are always distributed to lower levels */
+		if (0 != level)
+			from++;
+
+		if (FAIL == (index = timer_wheel_find_slot(wheel, timer_wheel_level_offset(level) + from,
+				timer_wheel_level_offset(level) + timer_wheel_level_mask(level))))
+		{
+			continue;
+		}
+
+		*location = index;
+		index -= timer_wheel_level_offset(level);
+		shift += timer_wheel_level_bits(level);
+
+		return (int)((zbx_uint32_t)wheel->cursor >> shift << shift |
+				(zbx_uint32_t)index << timer_wheel_level_shift(level));
+	}
+
+	if (NULL == wheel->overflow)
+		return FAIL;
+
+	*location = TIMER_WHEEL_LOCATION_OVERFLOW;
+
+	/* overflow elements belong to the following wheel ranges */
+	if (INT_MAX < (range = (((zbx_uint32_t)wheel->cursor >> TIMER_WHEEL_BITS) + 1) << TIMER_WHEEL_BITS))
+		return INT_MAX;
+
+	return (int)range;
+}
+
+static int	timer_wheel_overflow_min_time(const zbx_timer_wheel_t *wheel)
+{
+	const zbx_timer_wheel_node_t	*node;
+	int				time;
+
+	time = wheel->overflow->time;
+
+	for (node = wheel->overflow->next; NULL != node; node = node->next)
+	{
+		if (node->time < time)
+			time = node->time;
+	}
+
+	return time;
+}
+
+/* public timer wheel interface */
+
+void	zbx_timer_wheel_create(zbx_timer_wheel_t *wheel, zbx_compare_func_t compare_func)
+{
+	zbx_timer_wheel_create_ext(wheel, compare_func,
+					ZBX_DEFAULT_MEM_MALLOC_FUNC,
+					ZBX_DEFAULT_MEM_REALLOC_FUNC,
+					ZBX_DEFAULT_MEM_FREE_FUNC);
+}
+
+void	zbx_timer_wheel_create_ext(zbx_timer_wheel_t *wheel, zbx_compare_func_t compare_func,
+					zbx_mem_malloc_func_t mem_malloc_func,
+					zbx_mem_realloc_func_t mem_realloc_func,
+					zbx_mem_free_func_t mem_free_func)
+{
+	memset(wheel->slots, 0, sizeof(wheel->slots));
+	memset(wheel->bitmap, 0, sizeof(wheel->bitmap));
+	wheel->overflow = NULL;
+	wheel->cursor = 0;
+
+	zbx_hashset_create_ext(&wheel->nodes, 512,
+					ZBX_DEFAULT_UINT64_HASH_FUNC,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+					NULL,
+					mem_malloc_func,
+					mem_realloc_func,
+					mem_free_func);
+
+	zbx_binary_heap_create_ext(&wheel->ready, compare_func, ZBX_BINARY_HEAP_OPTION_DIRECT,
+					mem_malloc_func,
+					mem_realloc_func,
+					mem_free_func);
+}
+
+void	zbx_timer_wheel_destroy(zbx_timer_wheel_t *wheel)
+{
+	zbx_binary_heap_destroy(&wheel->ready);
+	zbx_hashset_destroy(&wheel->nodes);
+}
+
+int	zbx_timer_wheel_empty(zbx_timer_wheel_t *wheel)
+{
+	return (0 == wheel->nodes.num_data ? SUCCEED : FAIL);
+}
+
+int	zbx_timer_wheel_elems_num(zbx_timer_wheel_t *wheel)
+{
+	return wheel->nodes.num_data;
+}
+
+void	zbx_timer_wheel_insert(zbx_timer_wheel_t *wheel, const zbx_binary_heap_elem_t *elem, int time)
+{
+	zbx_timer_wheel_node_t	node_local, *node;
+
+	node_local.key = elem->key;
+
+	if (NULL != zbx_hashset_search(&wheel->nodes, &node_local))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "inserting a duplicate key into a timer wheel");
+		exit(EXIT_FAILURE);
+	}
+
+	node_local.data = elem->data;
+	node_local.time = time;
+
+	node = (zbx_timer_wheel_node_t *)zbx_hashset_insert(&wheel->nodes, &node_local, sizeof(node_local));
+	timer_wheel_place(wheel, node);
+}
+
+void	zbx_timer_wheel_update(zbx_timer_wheel_t *wheel, const zbx_binary_heap_elem_t *elem, int time)
+{
+	zbx_timer_wheel_node_t	*node;
+
+	if (NULL == (node = (zbx_timer_wheel_node_t *)zbx_hashset_search(&wheel->nodes, &elem->key)))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "element with key " ZBX_FS_UI64 " not found in timer wheel for update",
+				elem->key);
+		exit(EXIT_FAILURE);
+	}
+
+	node->data = elem->data;
+
+	if (TIMER_WHEEL_LOCATION_READY == node->location && time < wheel->cursor)
+	{
+		zbx_binary_heap_elem_t	elem_local = {node->key, node->data};
+
+		node->time = time;
+		zbx_binary_heap_update_direct(&wheel->ready, &elem_local);
+		return;
+	}
+
+	timer_wheel_unplace(wheel, node);
+	node->time = time;
+	timer_wheel_place(wheel, node);
+}
+
+void	zbx_timer_wheel_remove(zbx_timer_wheel_t *wheel, zbx_uint64_t key)
+{
+	zbx_timer_wheel_node_t	*node;
+
+	if (NULL == (node = (zbx_timer_wheel_node_t *)zbx_hashset_search(&wheel->nodes, &key)))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "element with key " ZBX_FS_UI64 " not found in timer wheel for remove",
+				key);
+		exit(EXIT_FAILURE);
+	}
+
+	timer_wheel_unplace(wheel, node);
+	zbx_hashset_remove_direct(&wheel->nodes, node);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_timer_wheel_advance                                          *
+ *                                                                            *
+ * Purpose: move elements scheduled up to the specified time to ready heap    *
+ *                                                                            *
+ * Parameters: wheel - [IN] the timer wheel                                   *
+ *             now   - [IN] the current time                                  *
+ *                                                                            *
+ * Comments: Only elements moved to ready heap can be retrieved with          *
+ *           zbx_timer_wheel_find_min() function.                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_timer_wheel_advance(zbx_timer_wheel_t *wheel, int now)
+{
+	int	location, time;
+
+	while (wheel->cursor <= now)
+	{
+		if (FAIL == (time = timer_wheel_next_slot(wheel, &location)) || time > now)
+		{
+			timer_wheel_set_cursor(wheel, now + 1);
+			break;
+		}
+
+		if (location < TIMER_WHEEL_LEVEL0_SLOTS)
+		{
+			/* move past the slot, its elements are now before cursor and go to ready heap */
+			timer_wheel_set_cursor(wheel, time + 1);
+			timer_wheel_cascade(wheel, location);
+			continue;
+		}
+
+		/* jump directly to the earliest overflow element instead of stepping through empty ranges */
+		if (TIMER_WHEEL_LOCATION_OVERFLOW == location && (time = timer_wheel_overflow_min_time(wheel)) > now)
+			time = now + 1;
+
+		/* entering higher level slot range distributes its elements to lower levels */
+		timer_wheel_set_cursor(wheel, time);
+	}
+}
+
+zbx_binary_heap_elem_t	*zbx_timer_wheel_find_min(zbx_timer_wheel_t *wheel)
+{
+	if (SUCCEED == zbx_binary_heap_empty(&wheel->ready))
+		return NULL;
+
+	return zbx_binary_heap_find_min(&wheel->ready);
+}
+
+void	zbx_timer_wheel_remove_min(zbx_timer_wheel_t *wheel)
+{
+	zbx_uint64_t	key;
+
+	if (SUCCEED == zbx_binary_heap_empty(&wheel->ready))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "removing a minimum from an empty timer wheel ready heap");
+		exit(EXIT_FAILURE);
+	}
+
+	key = zbx_binary_heap_find_min(&wheel->ready)->key;
+	zbx_binary_heap_remove_min(&wheel->ready);
+	zbx_hashset_remove(&wheel->nodes, &key);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_timer_wheel_min_time                                         *
+ *                                                                            *
+ * Purpose: get the time of the earliest element                              *
+ *                                                                            *
+ * Parameters: wheel - [IN] the timer wheel                                   *
+ *                                                                            *
+ * Return value: The earliest scheduled time or FAIL if the wheel is empty.   *
+ *                                                                            *
+ * Comments: For elements outside the current 256 second range only the       *
+ *           lower bound of their time is known without scanning the slot,    *
+ *           so start time of the earliest non-empty slot is returned.        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_timer_wheel_min_time(zbx_timer_wheel_t *wheel)
+{
+	const zbx_timer_wheel_node_t	*node;
+	int				location;
+
+	if (FAIL == zbx_binary_heap_empty(&wheel->ready))
+	{
+		node = (const zbx_timer_wheel_node_t *)zbx_hashset_search(&wheel->nodes,
+				&zbx_binary_heap_find_min(&wheel->ready)->key);
+
+		return node->time;
+	}
+
+	return timer_wheel_next_slot(wheel, &location);
+}
+
+void	zbx_timer_wheel_clear(zbx_timer_wheel_t *wheel)
+{
+	memset(wheel->slots, 0, sizeof(wheel->slots));
+	memset(wheel->bitmap, 0, sizeof(wheel->bitmap));
+	wheel->overflow = NULL;
+
+	zbx_binary_heap_clear(&wheel->ready);
+	zbx_hashset_clear(&wheel->nodes);
+}
@@ -791,6 +791,181 @@ static ssize_t	zbx_tcp_write(zbx_socket_t *s, const char *buf, size_t len)
 	return res;
 }
 
+#define ZBX_TLS_MAX_REC_LEN		16384
+
+/* the size of chunks the message is compressed into when sending */
+#define ZBX_TCP_COMPRESS_CHUNK_SIZE	(64 * ZBX_KIBIBYTE)
+
+/******************************************************************************
+ *                                                                            *
+ * Function: tcp_send_data                                                    *
+ *                                                                            *
+ * Purpose: send data buffer, splitting it into TLS records if necessary      *
+ *                                                                            *
+ * Return value: SUCCEED - success                                            *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	tcp_send_data(zbx_socket_t *s, const char *data, size_t len)
+{
+	ssize_t	bytes_sent;
+	size_t	send_bytes, written = 0;
+
+	while (written < len)
+	{
+		if (ZBX_TCP_SEC_UNENCRYPTED == s->connection_type)
+			send_bytes = len - written;
+		else
+			send_bytes = MIN(ZBX_TLS_MAX_REC_LEN, len - written);
+
+		if (ZBX_PROTO_ERROR == (bytes_sent = zbx_tcp_write(s, data + written, send_bytes)))
+			return FAIL;
+
+		written += (size_t)bytes_sent;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_header_write                                             *
+ *                                                                            *
+ * Purpose: write Zabbix protocol header                                      *
+ *                                                                            *
+ * Parameters: buf      - [OUT] the output buffer, must have room for         *
+ *                              ZBX_TCP_HEADER_SIZE_MAX bytes                 *
+ *             flags    - [IN] the protocol flags                             *
+ *             len      - [IN] the data length                                *
+ *             reserved - [IN] the uncompressed data length of compressed     *
+ *                             data, 0 otherwise                              *
+ *                                                                            *
+ * Return value: the header size                                              *
+ *                                                                            *
+ ******************************************************************************/
+size_t	zbx_tcp_header_write(char *buf, unsigned char flags, zbx_uint64_t len, zbx_uint64_t reserved)
+{
+	size_t	offset;
+
+	memcpy(buf, ZBX_TCP_HEADER_DATA, ZBX_TCP_HEADER_LEN);
+	offset = ZBX_TCP_HEADER_LEN;
+
+	buf[offset++] = (char)flags;
+
+	if (0 != (flags & ZBX_TCP_LARGE))
+	{
+		zbx_uint64_t	len64_le;
+
+		len64_le = zbx_htole_uint64(len);
+		memcpy(buf + offset, &len64_le, sizeof(len64_le));
+		offset += sizeof(len64_le);
+
+		len64_le = zbx_htole_uint64(reserved);
+		memcpy(buf + offset, &len64_le, sizeof(len64_le));
+		offset += sizeof(len64_le);
+	}
+	else
+	{
+		zbx_uint32_t	len32_le;
+
+		len32_le = zbx_htole_uint32((zbx_uint32_t)len);
+		memcpy(buf + offset, &len32_le, sizeof(len32_le));
+		offset += sizeof(len32_le);
+
+		len32_le = zbx_htole_uint32((zbx_uint32_t)reserved);
+		memcpy(buf + offset, &len32_le, sizeof(len32_le));
+		offset += sizeof(len32_le);
+	}
+
+	return offset;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_header_read                                              *
+ *                                                                            *
+ * Purpose: parse Zabbix protocol header from the beginning of received data  *
+ *                                                                            *
+ * Parameters: buf    - [IN] the received data                                *
+ *             len    - [IN] the received data length                         *
+ *             flags  - [IN] the accepted protocol flags in addition to       *
+ *                           ZBX_TCP_PROTOCOL and ZBX_TCP_COMPRESS            *
+ *             header - [OUT] the parsed header                               *
+ *                                                                            *
+ * Return value: SUCCEED - the received part of header is valid               *
+ *               FAIL    - invalid header or unsupported protocol version     *
+ *                                                                            *
+ * Comments: header->expect is set to the header part to be received next or  *
+ *           to ZBX_TCP_EXPECT_SIZE when the whole header has been parsed.    *
+ *           With unsupported protocol version it is set to                   *
+ *           ZBX_TCP_EXPECT_VERSION_VALIDATE.                                 *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_header_read(const char *buf, size_t len, unsigned char flags, zbx_tcp_header_t *header)
+{
+	header->expect = ZBX_TCP_EXPECT_HEADER;
+	header->size = 0;
+
+	if (ZBX_TCP_HEADER_LEN > len)
+		return 0 == strncmp(buf, ZBX_TCP_HEADER_DATA, len) ? SUCCEED : FAIL;
+
+	if (0 != strncmp(buf, ZBX_TCP_HEADER_DATA, ZBX_TCP_HEADER_LEN))
+		return FAIL;
+
+	header->expect = ZBX_TCP_EXPECT_VERSION;
+	header->size = ZBX_TCP_HEADER_LEN;
+
+	if (header->size + 1 > len)
+		return SUCCEED;
+
+	header->protocol = (unsigned char)buf[header->size];
+
+	if (0 == (header->protocol & ZBX_TCP_PROTOCOL) ||
+			header->protocol > (ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS | flags))
+	{
+		header->expect = ZBX_TCP_EXPECT_VERSION_VALIDATE;
+		return FAIL;
+	}
+
+	header->expect = ZBX_TCP_EXPECT_LENGTH;
+	header->size++;
+
+	if (0 != (header->protocol & ZBX_TCP_LARGE))
+	{
+		zbx_uint64_t	len64_le;
+
+		if (header->size + 2 * sizeof(len64_le) > len)
+			return SUCCEED;
+
+		memcpy(&len64_le, buf + header->size, sizeof(len64_le));
+		header->size += sizeof(len64_le);
+		header->len = zbx_letoh_uint64(len64_le);
+
+		memcpy(&len64_le, buf + header->size, sizeof(len64_le));
+		header->size += sizeof(len64_le);
+		header->reserved = zbx_letoh_uint64(len64_le);
+	}
+	else
+	{
+		zbx_uint32_t	len32_le;
+
+		if (header->size + 2 * sizeof(len32_le) > len)
+			return SUCCEED;
+
+		memcpy(&len32_le, buf + header->size, sizeof(len32_le));
+		header->size += sizeof(len32_le);
+		header->len = zbx_letoh_uint32(len32_le);
+
+		memcpy(&len32_le, buf + header->size, sizeof(len32_le));
+		header->size += sizeof(len32_le);
+		header->reserved = zbx_letoh_uint32(len32_le);
+	}
+
+	header->expect = ZBX_TCP_EXPECT_SIZE;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_tcp_send_ext                                                 *
@@ -812,22 +987,22 @@ static ssize_t	zbx_tcp_write(zbx_socket_t *s, const char *buf, size_t len)
  *     of the message into one block of up to 16384 bytes for efficiency.     *
  *     The same is applied for sending unencrypted messages.                  *
  *                                                                            *
+ *     Messages compressed by this function are kept in fixed size chunks     *
+ *     instead of a single worst case sized buffer.                           *
+ *                                                                            *
  ******************************************************************************/
 
-#define ZBX_TCP_HEADER_DATA	"ZBXD"
-#define ZBX_TCP_HEADER_LEN	ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA)
-
 int	zbx_tcp_send_ext(zbx_socket_t *s, const char *data, size_t len, size_t reserved, unsigned char flags,
 		int timeout)
 {
-#define ZBX_TLS_MAX_REC_LEN	16384
-
 	ssize_t			bytes_sent, written = 0;
 	size_t			send_bytes, offset, send_len = len;
-	int			ret = SUCCEED;
-	char			*compressed_data = NULL;
+	int			ret = SUCCEED, i;
+	zbx_vector_ptr_t	chunks;
 	const zbx_uint64_t	max_uint32 = ~(zbx_uint32_t)0;
 
+	zbx_vector_ptr_create(&chunks);
+
 	if (0 != timeout)
 		zbx_socket_timeout_set(s, timeout);
 
@@ -860,50 +1035,23 @@ int	zbx_tcp_send_ext(zbx_socket_t *s, const char *data, size_t len, size_t reser
 			/* compress if not compressed yet */
 			if (0 == reserved)
 			{
-				if (SUCCEED != zbx_compress(data, len, &compressed_data, &send_len))
+				if (SUCCEED != zbx_compress_chunks(data, len, ZBX_TCP_COMPRESS_CHUNK_SIZE, &chunks,
+						&send_len))
 				{
 					zbx_set_socket_strerror("cannot compress data: %s", zbx_compress_strerror());
 					ret = FAIL;
 					goto cleanup;
 				}
 
-				data = compressed_data;
+				data = (const char *)chunks.values[0];
 				reserved = len;
 			}
 		}
 
-		memcpy(header_buf, ZBX_TCP_HEADER_DATA, ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA));
-		offset = ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA);
-
 		if (max_uint32 <= len || max_uint32 <= reserved)
 			flags |= ZBX_TCP_LARGE;
 
-		header_buf[offset++] = flags;
-
-		if (0 != (flags & ZBX_TCP_LARGE))
-		{
-			zbx_uint64_t	len64_le;
-
-			len64_le = zbx_htole_uint64((zbx_uint64_t)send_len);
-			memcpy(header_buf + offset, &len64_le, sizeof(len64_le));
-			offset += sizeof(len64_le);
-
-			len64_le = zbx_htole_uint64((zbx_uint64_t)reserved);
-			memcpy(header_buf + offset, &len64_le, sizeof(len64_le));
-			offset += sizeof(len64_le);
-		}
-		else
-		{
-			zbx_uint32_t	len32_le;
-
-			len32_le = zbx_htole_uint32((zbx_uint32_t)send_len);
-			memcpy(header_buf + offset, &len32_le, sizeof(len32_le));
-			offset += sizeof(len32_le);
-
-			len32_le = zbx_htole_uint32((zbx_uint32_t)reserved);
-			memcpy(header_buf + offset, &len32_le, sizeof(len32_le));
-			offset += sizeof(len32_le);
-		}
+		offset = zbx_tcp_header_write(header_buf, flags, send_len, reserved);
 
 		take_bytes = MIN(send_len, ZBX_TLS_MAX_REC_LEN - offset);
 		memcpy(header_buf + offset, data, take_bytes);
@@ -924,29 +1072,36 @@ int	zbx_tcp_send_ext(zbx_socket_t *s, const char *data, size_t len, size_t reser
 		written -= offset;
 	}
 
-	while (written < (ssize_t)send_len)
+	if (0 == chunks.values_num)
 	{
-		if (ZBX_TCP_SEC_UNENCRYPTED == s->connection_type)
-			send_bytes = send_len - (size_t)written;
+		ret = tcp_send_data(s, data + written, send_len - (size_t)written);
+		goto cleanup;
+	}
+
+	/* the header block was taken from the first chunk, which is larger than a TLS record */
+	for (i = 0; i < chunks.values_num; i++)
+	{
+		if (i == chunks.values_num - 1)
+			send_bytes = send_len - (size_t)i * ZBX_TCP_COMPRESS_CHUNK_SIZE;
 		else
-			send_bytes = MIN(ZBX_TLS_MAX_REC_LEN, send_len - (size_t)written);
+			send_bytes = ZBX_TCP_COMPRESS_CHUNK_SIZE;
 
-		if (ZBX_PROTO_ERROR == (bytes_sent = zbx_tcp_write(s, data + written, send_bytes)))
+		if (SUCCEED != (ret = tcp_send_data(s, (const char *)chunks.values[i] + written,
+				send_bytes - (size_t)written)))
 		{
-			ret = FAIL;
-			goto cleanup;
+			break;
 		}
-		written += bytes_sent;
+
+		written = 0;
 	}
 cleanup:
-	zbx_free(compressed_data);
+	zbx_vector_ptr_clear_ext(&chunks, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&chunks);
 
 	if (0 != timeout)
 		zbx_socket_timeout_cleanup(s);
 
 	return ret;
-
-#undef ZBX_TLS_MAX_REC_LEN
 }
 
 /******************************************************************************
@@ -1779,17 +1934,11 @@ static ssize_t	zbx_tcp_read(zbx_socket_t *s, char *buf, size_t len)
  ******************************************************************************/
 ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout, unsigned char flags)
 {
-#define ZBX_TCP_EXPECT_HEADER		1
-#define ZBX_TCP_EXPECT_VERSION		2
-#define ZBX_TCP_EXPECT_VERSION_VALIDATE	3
-#define ZBX_TCP_EXPECT_LENGTH		4
-#define ZBX_TCP_EXPECT_SIZE		5
-
-	ssize_t		nbytes;
-	size_t		buf_dyn_bytes = 0, buf_stat_bytes = 0, offset = 0;
-	zbx_uint64_t	expected_len = 16 * ZBX_MEBIBYTE, reserved = 0, max_len;
-	unsigned char	expect = ZBX_TCP_EXPECT_HEADER;
-	int		protocol_version;
+	ssize_t			nbytes;
+	size_t			buf_dyn_bytes = 0, buf_stat_bytes = 0, offset = 0;
+	zbx_uint64_t		expected_len = 16 * ZBX_MEBIBYTE, reserved = 0, max_len;
+	zbx_tcp_header_t	header;
+	zbx_uncompress_stream_t	*stream = NULL;
 #if defined(_WINDOWS)
 	max_len = ZBX_MAX_RECV_DATA_SIZE;
 #else
@@ -1804,6 +1953,9 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout, unsigned char flags)
 	s->buf_type = ZBX_BUF_TYPE_STAT;
 	s->buffer = s->buf_stat;
 
+	header.expect = ZBX_TCP_EXPECT_HEADER;
+	header.protocol = 0;
+
 	while (0 != (nbytes = zbx_tcp_read(s, s->buf_stat + buf_stat_bytes, sizeof(s->buf_stat) - buf_stat_bytes)))
 	{
 		if (ZBX_PROTO_ERROR == nbytes)
@@ -1814,86 +1966,37 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout, unsigned char flags)
 		else
 		{
 			if (buf_dyn_bytes + nbytes <= expected_len)
-				memcpy(s->buffer + buf_dyn_bytes, s->buf_stat, nbytes);
+			{
+				if (NULL == stream)
+				{
+					memcpy(s->buffer + buf_dyn_bytes, s->buf_stat, nbytes);
+				}
+				else if (SUCCEED != zbx_uncompress_stream_write(stream, s->buf_stat, (size_t)nbytes))
+				{
+					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
+			}
 			buf_dyn_bytes += nbytes;
 		}
 
 		if (buf_stat_bytes + buf_dyn_bytes >= expected_len)
 			break;
 
-		if (ZBX_TCP_EXPECT_HEADER == expect)
+		if (ZBX_TCP_EXPECT_SIZE != header.expect)
 		{
-			if (ZBX_TCP_HEADER_LEN > buf_stat_bytes)
-			{
-				if (0 == strncmp(s->buf_stat, ZBX_TCP_HEADER_DATA, buf_stat_bytes))
-					continue;
-
+			/* abort receiving on invalid header or protocol version */
+			if (SUCCEED != zbx_tcp_header_read(s->buf_stat, buf_stat_bytes, flags, &header))
 				break;
-			}
-			else
-			{
-				if (0 != strncmp(s->buf_stat, ZBX_TCP_HEADER_DATA, ZBX_TCP_HEADER_LEN))
-				{
-					/* invalid header, abort receiving */
-					break;
-				}
-
-				expect = ZBX_TCP_EXPECT_VERSION;
-				offset += ZBX_TCP_HEADER_LEN;
-			}
-		}
 
-		if (ZBX_TCP_EXPECT_VERSION == expect)
-		{
-			if (offset + 1 > buf_stat_bytes)
+			if (ZBX_TCP_EXPECT_SIZE != header.expect)
 				continue;
 
-			expect = ZBX_TCP_EXPECT_VERSION_VALIDATE;
-			protocol_version = s->buf_stat[ZBX_TCP_HEADER_LEN];
-
-			if (0 == (protocol_version & ZBX_TCP_PROTOCOL) ||
-					protocol_version > (ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS | flags))
-			{
-				/* invalid protocol version, abort receiving */
-				break;
-			}
-			s->protocol = protocol_version;
-			expect = ZBX_TCP_EXPECT_LENGTH;
-			offset++;
-		}
-
-		if (ZBX_TCP_EXPECT_LENGTH == expect)
-		{
-			if (0 != (protocol_version & ZBX_TCP_LARGE))
-			{
-				zbx_uint64_t	len64_le;
-
-				if (offset + 2 * sizeof(len64_le) > buf_stat_bytes)
-					continue;
-
-				memcpy(&len64_le, s->buf_stat + offset, sizeof(len64_le));
-				offset += sizeof(len64_le);
-				expected_len = zbx_letoh_uint64(len64_le);
-
-				memcpy(&len64_le, s->buf_stat + offset, sizeof(len64_le));
-				offset += sizeof(len64_le);
-				reserved = zbx_letoh_uint64(len64_le);
-			}
-			else
-			{
-				zbx_uint32_t	len32_le;
-
-				if (offset + 2 * sizeof(len32_le) > buf_stat_bytes)
-					continue;
-
-				memcpy(&len32_le, s->buf_stat + offset, sizeof(len32_le));
-				offset += sizeof(len32_le);
-				expected_len = zbx_letoh_uint32(len32_le);
-
-				memcpy(&len32_le, s->buf_stat + offset, sizeof(len32_le));
-				offset += sizeof(len32_le);
-				reserved = zbx_letoh_uint32(len32_le);
-			}
+			s->protocol = header.protocol;
+			offset = header.size;
+			expected_len = header.len;
+			reserved = header.reserved;
 
 			if (max_len < expected_len)
 			{
@@ -1914,7 +2017,24 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout, unsigned char flags)
 				goto out;
 			}
 
-			if (sizeof(s->buf_stat) > expected_len)
+			if (0 != (header.protocol & ZBX_TCP_COMPRESS))
+			{
+				/* uncompress data while receiving, so the compressed message is not stored */
+				s->buf_type = ZBX_BUF_TYPE_DYN;
+				s->buffer = (char *)zbx_malloc(NULL, reserved + 1);
+				buf_dyn_bytes = buf_stat_bytes - offset;
+				buf_stat_bytes = 0;
+
+				if (NULL == (stream = zbx_uncompress_stream_create(s->buffer, reserved)) ||
+						(buf_dyn_bytes <= expected_len && SUCCEED !=
+						zbx_uncompress_stream_write(stream, s->buf_stat + offset, buf_dyn_bytes)))
+				{
+					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
+			}
+			else if (sizeof(s->buf_stat) > expected_len)
 			{
 				buf_stat_bytes -= offset;
 				memmove(s->buf_stat, s->buf_stat + offset, buf_stat_bytes);
@@ -1928,26 +2048,21 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout, unsigned char flags)
 				memcpy(s->buffer, s->buf_stat + offset, buf_dyn_bytes);
 			}
 
-			expect = ZBX_TCP_EXPECT_SIZE;
-
 			if (buf_stat_bytes + buf_dyn_bytes >= expected_len)
 				break;
 		}
 	}
 
-	if (ZBX_TCP_EXPECT_SIZE == expect)
+	if (ZBX_TCP_EXPECT_SIZE == header.expect)
 	{
 		if (buf_stat_bytes + buf_dyn_bytes == expected_len)
 		{
-			if (0 != (protocol_version & ZBX_TCP_COMPRESS))
+			if (NULL != stream)
 			{
-				char	*out;
-				size_t	out_size = reserved;
+				size_t	out_size;
 
-				out = (char *)zbx_malloc(NULL, reserved + 1);
-				if (FAIL == zbx_uncompress(s->buffer, buf_stat_bytes + buf_dyn_bytes, out, &out_size))
+				if (FAIL == zbx_uncompress_stream_finish(stream, &out_size))
 				{
-					zbx_free(out);
 					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
 					nbytes = ZBX_PROTO_ERROR;
 					goto out;
@@ -1955,17 +2070,11 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout, unsigned char flags)
 
 				if (out_size != reserved)
 				{
-					zbx_free(out);
 					zbx_set_socket_strerror("size of uncompressed data is less than expected");
 					nbytes = ZBX_PROTO_ERROR;
 					goto out;
 				}
 
-				if (ZBX_BUF_TYPE_DYN == s->buf_type)
-					zbx_free(s->buffer);
-
-				s->buf_type = ZBX_BUF_TYPE_DYN;
-				s->buffer = out;
 				s->read_bytes = reserved;
 
 				zabbix_log(LOG_LEVEL_TRACE, "%s(): received " ZBX_FS_SIZE_T " bytes with"
@@ -1994,21 +2103,21 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout, unsigned char flags)
 			nbytes = ZBX_PROTO_ERROR;
 		}
 	}
-	else if (ZBX_TCP_EXPECT_LENGTH == expect)
+	else if (ZBX_TCP_EXPECT_LENGTH == header.expect)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "Message from %s is missing data length. Message ignored.", s->peer);
 		nbytes = ZBX_PROTO_ERROR;
 	}
-	else if (ZBX_TCP_EXPECT_VERSION == expect)
+	else if (ZBX_TCP_EXPECT_VERSION == header.expect)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "Message from %s is missing protocol version. Message ignored.",
 				s->peer);
 		nbytes = ZBX_PROTO_ERROR;
 	}
-	else if (ZBX_TCP_EXPECT_VERSION_VALIDATE == expect)
+	else if (ZBX_TCP_EXPECT_VERSION_VALIDATE == header.expect)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "Message from %s is using unsupported protocol version \"%d\"."
-				" Message ignored.", s->peer, protocol_version);
+				" Message ignored.", s->peer, (int)header.protocol);
 		nbytes = ZBX_PROTO_ERROR;
 	}
 	else if (0 != buf_stat_bytes)
@@ -2022,14 +2131,13 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout, unsigned char flags)
 		s->buffer[s->read_bytes] = '\0';
 	}
 out:
+	if (NULL != stream)
+		zbx_uncompress_stream_free(stream);
+
 	if (0 != timeout)
 		zbx_socket_timeout_cleanup(s);
 
 	return (ZBX_PROTO_ERROR == nbytes ? FAIL : (ssize_t)(s->read_bytes + offset));
-
-#undef ZBX_TCP_EXPECT_HEADER
-#undef ZBX_TCP_EXPECT_LENGTH
-#undef ZBX_TCP_EXPECT_SIZE
 }
 
 /******************************************************************************
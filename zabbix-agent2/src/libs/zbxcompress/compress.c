@@ -26,6 +26,17 @@
 
 #define ZBX_COMPRESS_STRERROR_LEN	512
 
+/* the maximum number of bytes passed to zlib at once, as zlib stream buffer sizes are unsigned int */
+#define ZBX_ZLIB_BLOCK_MAX		ZBX_GIBIBYTE
+
+struct zbx_uncompress_stream
+{
+	z_stream	strm;
+	char		*out;
+	size_t		out_left;	/* the output buffer size not yet given to zlib */
+	int		ended;
+};
+
 static int	zbx_zlib_errno = 0;
 
 /******************************************************************************
@@ -99,6 +110,65 @@ int	zbx_compress(const char *in, size_t size_in, char **out, size_t *size_out)
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_compress_gzip                                                *
+ *                                                                            *
+ * Purpose: compress data in gzip format                                      *
+ *                                                                            *
+ * Parameters: in       - [IN] the data to compress                           *
+ *             size_in  - [IN] the input data size                            *
+ *             out      - [OUT] the compressed data                           *
+ *             size_out - [OUT] the compressed data size                      *
+ *                                                                            *
+ * Return value: SUCCEED - the data was compressed successfully               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: In the case of success the output buffer must be freed by the    *
+ *           caller.                                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_compress_gzip(const char *in, size_t size_in, char **out, size_t *size_out)
+{
+	z_stream	strm;
+	uLong		buf_size;
+	Bytef		*buf;
+
+	memset(&strm, 0, sizeof(strm));
+
+	/* adding 16 to window bits selects gzip header and trailer instead of zlib */
+	if (Z_OK != (zbx_zlib_errno = deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8,
+			Z_DEFAULT_STRATEGY)))
+	{
+		return FAIL;
+	}
+
+	buf_size = deflateBound(&strm, size_in);
+	buf = (Bytef *)zbx_malloc(NULL, buf_size);
+
+	strm.next_in = (Bytef *)in;
+	strm.avail_in = size_in;
+	strm.next_out = buf;
+	strm.avail_out = buf_size;
+
+	if (Z_STREAM_END != (zbx_zlib_errno = deflate(&strm, Z_FINISH)))
+	{
+		if (Z_OK == zbx_zlib_errno)
+			zbx_zlib_errno = Z_BUF_ERROR;
+
+		deflateEnd(&strm);
+		zbx_free(buf);
+		return FAIL;
+	}
+
+	*out = (char *)buf;
+	*size_out = strm.total_out;
+
+	deflateEnd(&strm);
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_uncompress                                                   *
@@ -126,6 +196,203 @@ int	zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_compress_chunks                                              *
+ *                                                                            *
+ * Purpose: compress data into fixed size chunks                              *
+ *                                                                            *
+ * Parameters: in         - [IN] the data to compress                         *
+ *             size_in    - [IN] the input data size                          *
+ *             chunk_size - [IN] the chunk size                               *
+ *             chunks     - [OUT] the compressed data chunks                  *
+ *             size_out   - [OUT] the compressed data size                    *
+ *                                                                            *
+ * Return value: SUCCEED - the data was compressed successfully               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The compressed data is the same as produced by zbx_compress()    *
+ *           function. All chunks except the last one are filled completely,  *
+ *           so only compressed data size is allocated instead of the worst   *
+ *           case buffer. In the case of success the chunks must be freed by  *
+ *           the caller.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_compress_chunks(const char *in, size_t size_in, size_t chunk_size, zbx_vector_ptr_t *chunks,
+		size_t *size_out)
+{
+	z_stream	strm;
+	Bytef		*chunk;
+
+	memset(&strm, 0, sizeof(strm));
+
+	if (Z_OK != (zbx_zlib_errno = deflateInit(&strm, Z_DEFAULT_COMPRESSION)))
+		return FAIL;
+
+	strm.next_in = (Bytef *)in;
+
+	do
+	{
+		if (0 == strm.avail_out)
+		{
+			chunk = (Bytef *)zbx_malloc(NULL, chunk_size);
+			zbx_vector_ptr_append(chunks, chunk);
+
+			strm.next_out = chunk;
+			strm.avail_out = (uInt)chunk_size;
+		}
+
+		if (0 == strm.avail_in && 0 != size_in)
+		{
+			strm.avail_in = (uInt)MIN(size_in, ZBX_ZLIB_BLOCK_MAX);
+			size_in -= strm.avail_in;
+		}
+
+		zbx_zlib_errno = deflate(&strm, 0 == size_in ? Z_FINISH : Z_NO_FLUSH);
+	}
+	while (Z_OK == zbx_zlib_errno);
+
+	deflateEnd(&strm);
+
+	if (Z_STREAM_END != zbx_zlib_errno)
+	{
+		zbx_vector_ptr_clear_ext(chunks, zbx_ptr_free);
+		return FAIL;
+	}
+
+	*size_out = (size_t)chunks->values_num * chunk_size - strm.avail_out;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_uncompress_stream_create                                     *
+ *                                                                            *
+ * Purpose: create stream to uncompress data received in parts                *
+ *                                                                            *
+ * Parameters: out      - [IN] the output buffer                              *
+ *             size_out - [IN] the output buffer size                         *
+ *                                                                            *
+ * Return value: the uncompress stream or NULL if it cannot be created        *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uncompress_stream_t	*zbx_uncompress_stream_create(char *out, size_t size_out)
+{
+	zbx_uncompress_stream_t	*stream;
+
+	stream = (zbx_uncompress_stream_t *)zbx_malloc(NULL, sizeof(zbx_uncompress_stream_t));
+	memset(stream, 0, sizeof(zbx_uncompress_stream_t));
+
+	if (Z_OK != (zbx_zlib_errno = inflateInit(&stream->strm)))
+	{
+		zbx_free(stream);
+		return NULL;
+	}
+
+	stream->out = out;
+	stream->strm.next_out = (Bytef *)out;
+	stream->out_left = size_out;
+
+	return stream;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_uncompress_stream_write                                      *
+ *                                                                            *
+ * Purpose: uncompress the next part of data into the output buffer           *
+ *                                                                            *
+ * Parameters: stream  - [IN] the uncompress stream                           *
+ *             in      - [IN] the data to uncompress                          *
+ *             size_in - [IN] the input data size                             *
+ *                                                                            *
+ * Return value: SUCCEED - the data was uncompressed successfully             *
+ *               FAIL    - the data is corrupted or does not fit into output  *
+ *                         buffer                                             *
+ *                                                                            *
+ * Comments: Data following the end of compressed stream is ignored.          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_uncompress_stream_write(zbx_uncompress_stream_t *stream, const char *in, size_t size_in)
+{
+	z_stream	*strm = &stream->strm;
+
+	strm->next_in = (Bytef *)in;
+
+	while (0 == stream->ended && (0 != size_in || 0 != strm->avail_in))
+	{
+		if (0 == strm->avail_in)
+		{
+			strm->avail_in = (uInt)MIN(size_in, ZBX_ZLIB_BLOCK_MAX);
+			size_in -= strm->avail_in;
+		}
+
+		if (0 == strm->avail_out)
+		{
+			strm->avail_out = (uInt)MIN(stream->out_left, ZBX_ZLIB_BLOCK_MAX);
+			stream->out_left -= strm->avail_out;
+		}
+
+		switch (zbx_zlib_errno = inflate(strm, Z_NO_FLUSH))
+		{
+			case Z_STREAM_END:
+				stream->ended = 1;
+				break;
+			case Z_OK:
+				break;
+			case Z_NEED_DICT:
+				zbx_zlib_errno = Z_DATA_ERROR;
+				return FAIL;
+			default:
+				return FAIL;
+		}
+	}
+
+	strm->avail_in = 0;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_uncompress_stream_finish                                     *
+ *                                                                            *
+ * Purpose: check that all compressed data was uncompressed                   *
+ *                                                                            *
+ * Parameters: stream   - [IN] the uncompress stream                          *
+ *             size_out - [OUT] the uncompressed data size                    *
+ *                                                                            *
+ * Return value: SUCCEED - the end of compressed data was reached             *
+ *               FAIL    - the compressed data is incomplete                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_uncompress_stream_finish(zbx_uncompress_stream_t *stream, size_t *size_out)
+{
+	if (0 == stream->ended)
+	{
+		zbx_zlib_errno = Z_DATA_ERROR;
+		return FAIL;
+	}
+
+	*size_out = (size_t)((char *)stream->strm.next_out - stream->out);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_uncompress_stream_free                                       *
+ *                                                                            *
+ * Purpose: free uncompress stream                                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_uncompress_stream_free(zbx_uncompress_stream_t *stream)
+{
+	inflateEnd(&stream->strm);
+	zbx_free(stream);
+}
+
 #else
 
 int zbx_compress(const char *in, size_t size_in, char **out, size_t *size_out)
@@ -137,6 +404,15 @@ int zbx_compress(const char *in, size_t size_in, char **out, size_t *size_out)
 	return FAIL;
 }
 
+int zbx_compress_gzip(const char *in, size_t size_in, char **out, size_t *size_out)
+{
+	ZBX_UNUSED(in);
+	ZBX_UNUSED(size_in);
+	ZBX_UNUSED(out);
+	ZBX_UNUSED(size_out);
+	return FAIL;
+}
+
 int zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
 {
 	ZBX_UNUSED(in);
@@ -146,6 +422,44 @@ int zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
 	return FAIL;
 }
 
+int	zbx_compress_chunks(const char *in, size_t size_in, size_t chunk_size, zbx_vector_ptr_t *chunks,
+		size_t *size_out)
+{
+	ZBX_UNUSED(in);
+	ZBX_UNUSED(size_in);
+	ZBX_UNUSED(chunk_size);
+	ZBX_UNUSED(chunks);
+	ZBX_UNUSED(size_out);
+	return FAIL;
+}
+
+zbx_uncompress_stream_t	*zbx_uncompress_stream_create(char *out, size_t size_out)
+{
+	ZBX_UNUSED(out);
+	ZBX_UNUSED(size_out);
+	return NULL;
+}
+
+int	zbx_uncompress_stream_write(zbx_uncompress_stream_t *stream, const char *in, size_t size_in)
+{
+	ZBX_UNUSED(stream);
+	ZBX_UNUSED(in);
+	ZBX_UNUSED(size_in);
+	return FAIL;
+}
+
+int	zbx_uncompress_stream_finish(zbx_uncompress_stream_t *stream, size_t *size_out)
+{
+	ZBX_UNUSED(stream);
+	ZBX_UNUSED(size_out);
+	return FAIL;
+}
+
+void	zbx_uncompress_stream_free(zbx_uncompress_stream_t *stream)
+{
+	ZBX_UNUSED(stream);
+}
+
 const char	*zbx_compress_strerror(void)
 {
 	return "";
@@ -30,6 +30,7 @@ char	*CONFIG_LOG_TYPE_STR	= NULL;
 int	CONFIG_LOG_TYPE		= LOG_TYPE_UNDEFINED;
 char	*CONFIG_LOG_FILE	= NULL;
 int	CONFIG_LOG_FILE_SIZE	= 1;
+int	CONFIG_LOG_BUFFER	= 0;
 int	CONFIG_ALLOW_ROOT	= 0;
 int	CONFIG_TIMEOUT		= 3;
 
@@ -1096,6 +1096,121 @@ int	zbx_db_commit(void)
 	return rc;
 }
 
+#ifdef HAVE_POSTGRESQL
+static double	commit_sec;	/* the time commit was sent, used for slow query logging */
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_commit_send                                               *
+ *                                                                            *
+ * Purpose: send transaction commit without waiting for its result            *
+ *                                                                            *
+ * Return value: ZBX_DB_OK - the commit was sent                              *
+ *               ZBX_DB_FAIL, ZBX_DB_DOWN - otherwise                         *
+ *                                                                            *
+ * Comments: The commit result must be retrieved with zbx_db_commit_result()  *
+ *           before executing any other query.                                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_commit_send(void)
+{
+	int	rc = ZBX_DB_OK;
+
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+		commit_sec = zbx_time();
+
+	if (0 == txn_level)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "ERROR: commit without transaction."
+				" Please report it to Zabbix Team.");
+		assert(0);
+	}
+
+	if (ZBX_DB_OK != txn_error)
+		return ZBX_DB_FAIL; /* commit called on failed transaction */
+
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [commit;] sent", txn_level);
+
+	if (1 != PQsendQuery(conn, "commit;"))
+	{
+		zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(conn), "commit;");
+		rc = (CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+		txn_error = rc;
+	}
+
+	return rc;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_commit_result                                             *
+ *                                                                            *
+ * Purpose: wait for the result of commit sent by zbx_db_commit_send()        *
+ *                                                                            *
+ * Return value: ZBX_DB_OK - the transaction was committed                    *
+ *               ZBX_DB_FAIL, ZBX_DB_DOWN - otherwise                         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_commit_result(void)
+{
+	int		rc = ZBX_DB_OK, results_num = 0;
+	PGresult	*result;
+	char		*error = NULL;
+
+	if (ZBX_DB_OK != txn_error)
+		return ZBX_DB_FAIL; /* commit was not sent */
+
+	while (NULL != (result = PQgetResult(conn)))
+	{
+		if (0 == results_num++ && PGRES_COMMAND_OK != PQresultStatus(result))
+		{
+			zbx_err_codes_t	errcode;
+
+			zbx_postgresql_error(&error, result);
+
+			/* deferred constraints are checked on commit */
+			if (0 == zbx_strcmp_null(PQresultErrorField(result, PG_DIAG_SQLSTATE), "23505"))
+				errcode = ERR_Z3008;
+			else
+				errcode = ERR_Z3005;
+
+			zbx_db_errlog(errcode, 0, error, "commit;");
+			zbx_free(error);
+
+			rc = (SUCCEED == is_recoverable_postgresql_error(conn, result) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+		}
+
+		PQclear(result);
+	}
+
+	if (0 == results_num)
+	{
+		zbx_db_errlog(ERR_Z3005, 0, "result is NULL", "commit;");
+		rc = (CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+	}
+
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+	{
+		double	sec = zbx_time() - commit_sec;
+
+		if (sec > (double)CONFIG_LOG_SLOW_QUERIES / 1000.0)
+			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"commit;\"", sec);
+	}
+
+	if (ZBX_DB_OK != rc)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "query [commit;] failed, setting transaction as failed");
+		txn_error = rc;
+		return rc;
+	}
+
+	txn_level--;
+	txn_end_error = ZBX_DB_OK;
+
+	return rc;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_db_rollback                                                  *
@@ -1605,6 +1720,106 @@ clean:
 	return ret;
 }
 
+#ifdef HAVE_POSTGRESQL
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_copy_from                                                 *
+ *                                                                            *
+ * Purpose: execute copy from stdin statement and send the data               *
+ *                                                                            *
+ * Parameters: sql      - [IN] the copy ... from stdin statement              *
+ *             data     - [IN] the data in the format specified by statement  *
+ *             data_len - [IN] the data length                                *
+ *                                                                            *
+ * Return value: the number of copied rows, ZBX_DB_FAIL or ZBX_DB_DOWN        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_copy_from(const char *sql, const char *data, size_t data_len)
+{
+	int		ret = ZBX_DB_OK;
+	double		sec = 0;
+	PGresult	*result;
+	char		*error = NULL;
+
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+		sec = zbx_time();
+
+	if (0 == txn_level)
+		zabbix_log(LOG_LEVEL_DEBUG, "query without transaction detected");
+
+	if (ZBX_DB_OK != txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level,
+				sql);
+		return ZBX_DB_FAIL;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s] data:" ZBX_FS_SIZE_T " bytes", txn_level, sql,
+			(zbx_fs_size_t)data_len);
+
+	result = PQexec(conn, sql);
+
+	if (NULL != result && PGRES_COPY_IN == PQresultStatus(result))
+	{
+		PQclear(result);
+
+		/* the data is sent in one piece, libpq splits it into protocol messages itself */
+		if (1 != PQputCopyData(conn, data, (int)data_len))
+			PQputCopyEnd(conn, PQerrorMessage(conn));
+		else
+			PQputCopyEnd(conn, NULL);
+
+		result = PQgetResult(conn);
+	}
+
+	if (NULL == result)
+	{
+		zbx_db_errlog(ERR_Z3005, 0, "result is NULL", sql);
+		ret = (CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+	}
+	else if (PGRES_COMMAND_OK != PQresultStatus(result))
+	{
+		zbx_err_codes_t	errcode;
+
+		zbx_postgresql_error(&error, result);
+
+		if (0 == zbx_strcmp_null(PQresultErrorField(result, PG_DIAG_SQLSTATE), "23505"))
+			errcode = ERR_Z3008;
+		else
+			errcode = ERR_Z3005;
+
+		zbx_db_errlog(errcode, 0, error, sql);
+		zbx_free(error);
+
+		ret = (SUCCEED == is_recoverable_postgresql_error(conn, result) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+	}
+
+	if (ZBX_DB_OK == ret)
+		ret = atoi(PQcmdTuples(result));
+
+	PQclear(result);
+
+	/* the copy command can be followed only by the terminating NULL result */
+	while (NULL != (result = PQgetResult(conn)))
+		PQclear(result);
+
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+	{
+		sec = zbx_time() - sec;
+		if (sec > (double)CONFIG_LOG_SLOW_QUERIES / 1000.0)
+			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"%s\"", sec, sql);
+	}
+
+	if (ZBX_DB_FAIL == ret && 0 < txn_level)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "query [%s] failed, setting transaction as failed", sql);
+		txn_error = ZBX_DB_FAIL;
+	}
+
+	return ret;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_db_vselect                                                   *
@@ -63,6 +63,7 @@ static size_t		sql_alloc = 4 * ZBX_KIBIBYTE;
 extern unsigned char	program_type;
 extern int		CONFIG_DOUBLE_PRECISION;
 extern char		*CONFIG_EXPORT_DIR;
+extern int		CONFIG_HISTORY_PIPELINED_COMMIT;
 
 #define ZBX_IDS_SIZE	10
 
@@ -92,6 +93,21 @@ extern char		*CONFIG_EXPORT_DIR;
 #define ZBX_HC_PROXYQUEUE_STATE_NORMAL 0
 #define ZBX_HC_PROXYQUEUE_STATE_WAIT 1
 
+/* history cache ingestion rings require atomic memory access builtins */
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+#	define ZBX_HC_RING_ENABLED
+#endif
+
+/* the number of rings and the part of history cache reserved for them */
+#define ZBX_HC_RING_NUM		4
+#define ZBX_HC_RING_CACHE_PART	8
+#define ZBX_HC_RING_SIZE_MIN	(64 * ZBX_KIBIBYTE)
+#define ZBX_HC_RING_SIZE_MAX	ZBX_MEBIBYTE
+#define ZBX_HC_RING_LINE_SIZE	64
+
+/* the maximum number of values added from rings to history cache while it is locked by one call */
+#define ZBX_HC_RING_DRAIN_MAX	(ZBX_HC_SYNC_MAX * 4)
+
 typedef struct
 {
 	char		table_name[ZBX_TABLENAME_LEN_MAX];
@@ -107,6 +123,39 @@ ZBX_DC_IDS;
 
 static ZBX_DC_IDS	*ids = NULL;
 
+/* Single producer, single consumer ring buffer of local history cache batches. A process     */
+/* adding history claims a free ring and writes batches without locking the history cache.    */
+/* The ring is kept only while it holds values not yet drained and is released by its owner   */
+/* once found empty, so the rings move to processes actively adding history. The rings are    */
+/* drained into history cache by the process holding the cache lock, so there is always only  */
+/* one consumer.                                                                              */
+typedef struct
+{
+	char		*buffer;
+	zbx_uint64_t	size;
+	pid_t		owner;
+	char		pad1[ZBX_HC_RING_LINE_SIZE];
+
+	/* the total number of bytes written, updated by producer */
+	zbx_uint64_t	head;
+	char		pad2[ZBX_HC_RING_LINE_SIZE - sizeof(zbx_uint64_t)];
+
+	/* the total number of bytes read, updated by consumer */
+	zbx_uint64_t	tail;
+	/* the number of values already added from the record at the tail position */
+	zbx_uint32_t	values_done;
+	/* the partially cloned value when history cache ran out of memory */
+	zbx_hc_data_t	*pending;
+}
+zbx_hc_ring_t;
+
+typedef struct
+{
+	zbx_uint32_t	size;		/* record size including the header */
+	zbx_uint32_t	values_num;	/* 0 for the record padding the end of ring buffer */
+}
+zbx_hc_ring_record_t;
+
 typedef struct
 {
 	zbx_list_t	list;
@@ -132,6 +181,10 @@ typedef struct
 	unsigned char		db_trigger_queue_lock;
 
 	zbx_hc_proxyqueue_t     proxyqueue;
+
+	zbx_hc_ring_t		*rings;
+	int			rings_num;
+	int			rings_next;
 }
 ZBX_DC_CACHE;
 
@@ -181,6 +234,13 @@ static dc_item_value_t	*item_values = NULL;
 static size_t		item_values_alloc = 0, item_values_num = 0;
 
 static void	hc_add_item_values(dc_item_value_t *values, int values_num);
+static int	hc_ring_write(const dc_item_value_t *values, int values_num, const char *strings,
+		size_t strings_len);
+static void	hc_ring_flush(void);
+static void	hc_ring_release(void);
+static void	hc_drain_rings(void);
+static int	hc_rings_pending(void);
+static void	hc_init_rings(void);
 static void	hc_pop_items(zbx_vector_ptr_t *history_items);
 static void	hc_get_item_values(ZBX_DC_HISTORY *history, zbx_vector_ptr_t *history_items);
 static void	hc_push_items(zbx_vector_ptr_t *history_items);
@@ -3114,14 +3174,34 @@ static void	sync_proxy_history(int *total_num, int *more)
 
 		DCmass_proxy_prepare_itemdiff(history, history_num, &item_diff);
 
-		do
+		if (SUCCEED == zbx_pb_history_add(history, history_num))
 		{
-			DBbegin();
+			if (0 != item_diff.values_num)
+			{
+				do
+				{
+					DBbegin();
+					DBmass_proxy_update_items(&item_diff);
+				}
+				while (ZBX_DB_DOWN == (txn_rc = DBcommit()));
+			}
 
-			DBmass_proxy_add_history(history, history_num);
-			DBmass_proxy_update_items(&item_diff);
+			/* values are already buffered and must not be synced again */
+			txn_rc = ZBX_DB_OK;
+		}
+		else
+		{
+			do
+			{
+				DBbegin();
+
+				DBmass_proxy_add_history(history, history_num);
+				DBmass_proxy_update_items(&item_diff);
+			}
+			while (ZBX_DB_DOWN == (txn_rc = DBcommit()));
+
+			zbx_pb_history_db_end();
 		}
-		while (ZBX_DB_DOWN == (txn_rc = DBcommit()));
 
 		LOCK_CACHE;
 
@@ -3134,7 +3214,7 @@ static void	sync_proxy_history(int *total_num, int *more)
 
 			cache->history_num -= history_num;
 
-			if (0 != hc_queue_get_size())
+			if (0 != hc_queue_get_size() || SUCCEED == hc_rings_pending())
 				*more = ZBX_SYNC_MORE;
 
 			UNLOCK_CACHE;
@@ -3162,6 +3242,191 @@ static void	sync_proxy_history(int *total_num, int *more)
 	zbx_vector_ptr_destroy(&history_items);
 }
 
+/* history synchronization batch */
+typedef struct
+{
+	ZBX_DC_HISTORY		history[ZBX_HC_SYNC_MAX];
+	zbx_vector_ptr_t	history_items;
+	zbx_vector_uint64_t	itemids;
+	zbx_vector_uint64_t	triggerids;
+	DC_ITEM			*items;
+	int			*errcodes;
+	int			history_num;
+	int			popped;
+}
+zbx_hc_sync_batch_t;
+
+static void	hc_sync_batch_create(zbx_hc_sync_batch_t *batch)
+{
+	zbx_vector_ptr_create(&batch->history_items);
+	zbx_vector_ptr_reserve(&batch->history_items, ZBX_HC_SYNC_MAX);
+
+	zbx_vector_uint64_create(&batch->itemids);
+
+	zbx_vector_uint64_create(&batch->triggerids);
+	zbx_vector_uint64_reserve(&batch->triggerids, ZBX_HC_SYNC_MAX);
+
+	batch->items = NULL;
+	batch->errcodes = NULL;
+	batch->history_num = 0;
+	batch->popped = 0;
+}
+
+static void	hc_sync_batch_destroy(zbx_hc_sync_batch_t *batch)
+{
+	zbx_vector_uint64_destroy(&batch->triggerids);
+	zbx_vector_uint64_destroy(&batch->itemids);
+	zbx_vector_ptr_destroy(&batch->history_items);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_sync_batch_pop                                                *
+ *                                                                            *
+ * Purpose: pops the next batch of history items from cache, locks their      *
+ *          triggers and gets item values and configuration                   *
+ *                                                                            *
+ * Parameters: batch              - [OUT] the history synchronization batch   *
+ *             item_retrieve_mode - [IN] the item configuration retrieve mode *
+ *                                                                            *
+ * Comments: This function accesses only the caches, so it can be called      *
+ *           while a database query is in progress.                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_sync_batch_pop(zbx_hc_sync_batch_t *batch, unsigned int item_retrieve_mode)
+{
+	int	i;
+
+	batch->popped = 1;
+
+	LOCK_CACHE;
+	hc_pop_items(&batch->history_items);		/* select and take items out of history cache */
+	UNLOCK_CACHE;
+
+	if (0 != batch->history_items.values_num)
+	{
+		if (0 == (batch->history_num = DCconfig_lock_triggers_by_history_items(&batch->history_items,
+				&batch->triggerids)))
+		{
+			LOCK_CACHE;
+			hc_push_items(&batch->history_items);
+			UNLOCK_CACHE;
+			zbx_vector_ptr_clear(&batch->history_items);
+		}
+	}
+	else
+		batch->history_num = 0;
+
+	if (0 == batch->history_num)
+		return;
+
+	hc_get_item_values(batch->history, &batch->history_items);	/* copy item data from history cache */
+
+	batch->items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * (size_t)batch->history_num);
+	batch->errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)batch->history_num);
+
+	zbx_vector_uint64_reserve(&batch->itemids, batch->history_num);
+
+	for (i = 0; i < batch->history_num; i++)
+		zbx_vector_uint64_append(&batch->itemids, batch->history[i].itemid);
+
+	zbx_vector_uint64_sort(&batch->itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	DCconfig_get_items_by_itemids_partial(batch->items, batch->itemids.values, batch->errcodes,
+			batch->history_num, item_retrieve_mode);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_sync_batch_clear                                              *
+ *                                                                            *
+ * Purpose: releases history synchronization batch resources                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_sync_batch_clear(zbx_hc_sync_batch_t *batch)
+{
+	if (0 != batch->history_num)
+	{
+		DCconfig_clean_items(batch->items, batch->errcodes, batch->history_num);
+		zbx_free(batch->errcodes);
+		zbx_free(batch->items);
+
+		hc_free_item_values(batch->history, batch->history_num);
+		batch->history_num = 0;
+	}
+
+	zbx_vector_ptr_clear(&batch->history_items);
+	zbx_vector_uint64_clear(&batch->itemids);
+	batch->popped = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_sync_batch_return                                             *
+ *                                                                            *
+ * Purpose: returns unprocessed batch items back to history cache             *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_sync_batch_return(zbx_hc_sync_batch_t *batch)
+{
+	int	i;
+
+	if (0 != batch->history_items.values_num)
+	{
+		/* busy items are returned to history queue without removing their values */
+		for (i = 0; i < batch->history_items.values_num; i++)
+			((zbx_hc_item_t *)batch->history_items.values[i])->status = ZBX_HC_ITEM_STATUS_BUSY;
+
+		LOCK_CACHE;
+		hc_push_items(&batch->history_items);
+		UNLOCK_CACHE;
+	}
+
+	if (0 != batch->triggerids.values_num)
+	{
+		DCconfig_unlock_triggers(&batch->triggerids);
+		zbx_vector_uint64_clear(&batch->triggerids);
+	}
+
+	hc_sync_batch_clear(batch);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_sync_commit                                                   *
+ *                                                                            *
+ * Purpose: commits history synchronization transaction, popping the next     *
+ *          batch while the commit is in progress                             *
+ *                                                                            *
+ * Parameters: next               - [OUT] the next batch to pop, NULL if the  *
+ *                                        next batch must not be popped       *
+ *             item_retrieve_mode - [IN] the item configuration retrieve mode *
+ *                                                                            *
+ * Return value: the same as DBcommit()                                       *
+ *                                                                            *
+ * Comments: On high latency database connections popping the next batch      *
+ *           during commit round trip hides part of the latency. Used only    *
+ *           when enabled by HistoryPipelinedCommit configuration parameter.  *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_sync_commit(zbx_hc_sync_batch_t *next, unsigned int item_retrieve_mode)
+{
+#ifdef HAVE_POSTGRESQL
+	if (1 != CONFIG_HISTORY_PIPELINED_COMMIT || NULL == next || 0 != next->popped)
+		return DBcommit();
+
+	DBcommit_send();
+	hc_sync_batch_pop(next, item_retrieve_mode);
+
+	return DBcommit_result();
+#else
+	ZBX_UNUSED(next);
+	ZBX_UNUSED(item_retrieve_mode);
+
+	return DBcommit();
+#endif
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: sync_server_history                                              *
@@ -3184,6 +3449,8 @@ static void	sync_proxy_history(int *total_num, int *more)
  *            a) history cache is empty or less than 10% of batch values were *
  *               processed (the other items were locked by triggers)          *
  *            b) less than 500 (full batch) timer triggers were processed     *
+ *           When a full batch is processed the next batch is popped while    *
+ *           trigger changes are being committed.                             *
  *                                                                            *
  ******************************************************************************/
 static void	sync_server_history(int *values_num, int *triggers_num, int *more)
@@ -3197,10 +3464,9 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 					history_text_num, history_log_num, txn_error, compression_age;
 	unsigned int			item_retrieve_mode;
 	time_t				sync_start;
-	zbx_vector_uint64_t		triggerids ;
-	zbx_vector_ptr_t		history_items, trigger_diff, item_diff, inventory_values, trigger_timers;
+	zbx_vector_ptr_t		trigger_diff, item_diff, inventory_values, trigger_timers;
 	zbx_vector_uint64_pair_t	trends_diff, proxy_subscribtions;
-	ZBX_DC_HISTORY			history[ZBX_HC_SYNC_MAX];
+	zbx_hc_sync_batch_t		batches[2], *batch = &batches[0], *next = &batches[1], *tmp;
 
 	item_retrieve_mode = NULL == CONFIG_EXPORT_DIR ? ZBX_ITEM_GET_SYNC : ZBX_ITEM_GET_SYNC_EXPORT;
 
@@ -3242,14 +3508,11 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 	zbx_vector_uint64_pair_create(&trends_diff);
 	zbx_vector_uint64_pair_create(&proxy_subscribtions);
 
-	zbx_vector_uint64_create(&triggerids);
-	zbx_vector_uint64_reserve(&triggerids, ZBX_HC_SYNC_MAX);
-
 	zbx_vector_ptr_create(&trigger_timers);
 	zbx_vector_ptr_reserve(&trigger_timers, ZBX_HC_TIMER_MAX);
 
-	zbx_vector_ptr_create(&history_items);
-	zbx_vector_ptr_reserve(&history_items, ZBX_HC_SYNC_MAX);
+	hc_sync_batch_create(&batches[0]);
+	hc_sync_batch_create(&batches[1]);
 
 	sync_start = time(NULL);
 
@@ -3257,48 +3520,33 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 	{
 		DC_ITEM			*items;
 		int			*errcodes, trends_num = 0, timers_num = 0, ret = SUCCEED;
-		zbx_vector_uint64_t	itemids;
+		ZBX_DC_HISTORY		*history;
 		ZBX_DC_TREND		*trends = NULL;
-
-		zbx_vector_uint64_create(&itemids);
+		zbx_hc_sync_batch_t	*prefetch;
 
 		*more = ZBX_SYNC_DONE;
 
-		LOCK_CACHE;
-		hc_pop_items(&history_items);		/* select and take items out of history cache */
-		UNLOCK_CACHE;
+		/* pop again if the batch popped during the last commit had all items locked */
+		if (0 == batch->popped || 0 == batch->history_items.values_num)
+			hc_sync_batch_pop(batch, item_retrieve_mode);
 
-		if (0 != history_items.values_num)
+		history = batch->history;
+		history_num = batch->history_num;
+		items = batch->items;
+		errcodes = batch->errcodes;
+
+		/* pop the next batch during commit only if this batch is full and sync is not going to time out */
+		if (ZBX_HC_SYNC_MAX == batch->history_items.values_num &&
+				ZBX_HC_SYNC_TIME_MAX > time(NULL) - sync_start)
 		{
-			if (0 == (history_num = DCconfig_lock_triggers_by_history_items(&history_items, &triggerids)))
-			{
-				LOCK_CACHE;
-				hc_push_items(&history_items);
-				UNLOCK_CACHE;
-				zbx_vector_ptr_clear(&history_items);
-			}
+			prefetch = next;
 		}
 		else
-			history_num = 0;
+			prefetch = NULL;
 
 		if (0 != history_num)
 		{
-			hc_get_item_values(history, &history_items);	/* copy item data from history cache */
-
-			items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * (size_t)history_num);
-			errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)history_num);
-
-			zbx_vector_uint64_reserve(&itemids, history_num);
-
-			for (i = 0; i < history_num; i++)
-				zbx_vector_uint64_append(&itemids, history[i].itemid);
-
-			zbx_vector_uint64_sort(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-
-			DCconfig_get_items_by_itemids_partial(items, itemids.values, errcodes, history_num,
-					item_retrieve_mode);
-
-			DCmass_prepare_history(history, &itemids, items, errcodes, history_num, &item_diff,
+			DCmass_prepare_history(history, &batch->itemids, items, errcodes, history_num, &item_diff,
 					&inventory_values, compression_age, &proxy_subscribtions);
 
 			if (FAIL != (ret = DBmass_add_history(history, history_num)))
@@ -3356,22 +3604,22 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 					zbx_trigger_timer_t	*timer = (zbx_trigger_timer_t *)trigger_timers.values[i];
 
 					if (0 != timer->lock)
-						zbx_vector_uint64_append(&triggerids, timer->triggerid);
+						zbx_vector_uint64_append(&batch->triggerids, timer->triggerid);
 				}
 
 				do
 				{
 					DBbegin();
 
-					recalculate_triggers(history, history_num, &itemids, items, errcodes,
+					recalculate_triggers(history, history_num, &batch->itemids, items, errcodes,
 							&trigger_timers, &trigger_diff);
 
 					/* process trigger events generated by recalculate_triggers() */
-					zbx_process_events(&trigger_diff, &triggerids);
+					zbx_process_events(&trigger_diff, &batch->triggerids);
 					if (0 != trigger_diff.values_num)
 						zbx_db_save_trigger_changes(&trigger_diff);
 
-					if (ZBX_DB_OK == (txn_error = DBcommit()))
+					if (ZBX_DB_OK == (txn_error = hc_sync_commit(prefetch, item_retrieve_mode)))
 						DCconfig_triggers_apply_changes(&trigger_diff);
 					else
 						zbx_clean_events();
@@ -3385,11 +3633,11 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 			}
 		}
 
-		if (0 != triggerids.values_num)
+		if (0 != batch->triggerids.values_num)
 		{
-			*triggers_num += triggerids.values_num;
-			DCconfig_unlock_triggers(&triggerids);
-			zbx_vector_uint64_clear(&triggerids);
+			*triggers_num += batch->triggerids.values_num;
+			DCconfig_unlock_triggers(&batch->triggerids);
+			zbx_vector_uint64_clear(&batch->triggerids);
 		}
 
 		if (0 != trigger_timers.values_num)
@@ -3408,17 +3656,18 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 		if (0 != history_num)
 		{
 			LOCK_CACHE;
-			hc_push_items(&history_items);	/* return items to history cache */
+			hc_push_items(&batch->history_items);	/* return items to history cache */
 			cache->history_num -= history_num;
 
-			if (0 != hc_queue_get_size())
+			if (0 != hc_queue_get_size() || SUCCEED == hc_rings_pending() ||
+					0 != next->history_items.values_num)
 			{
 				/* Continue sync if enough of sync candidates were processed       */
 				/* (meaning most of sync candidates are not locked by triggers).   */
 				/* Otherwise better to wait a bit for other syncers to unlock      */
 				/* items rather than trying and failing to sync locked items over  */
 				/* and over again.                                                 */
-				if (ZBX_HC_SYNC_MIN_PCNT <= history_num * 100 / history_items.values_num)
+				if (ZBX_HC_SYNC_MIN_PCNT <= history_num * 100 / batch->history_items.values_num)
 					*more = ZBX_SYNC_MORE;
 			}
 
@@ -3458,7 +3707,7 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 
 				if (NULL != phistory || NULL != ptrends)
 				{
-					DCexport_history_and_trends(phistory, history_num_loc, &itemids, items,
+					DCexport_history_and_trends(phistory, history_num_loc, &batch->itemids, items,
 							errcodes, ptrends, trends_num_loc);
 				}
 			}
@@ -3470,25 +3719,25 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 		if (0 != history_num || 0 != timers_num)
 			zbx_clean_events();
 
-		if (0 != history_num)
-		{
-			zbx_free(trends);
-			DCconfig_clean_items(items, errcodes, history_num);
-			zbx_free(errcodes);
-			zbx_free(items);
-
-			zbx_vector_ptr_clear(&history_items);
-			hc_free_item_values(history, history_num);
-		}
+		zbx_free(trends);
+		hc_sync_batch_clear(batch);
 
-		zbx_vector_uint64_destroy(&itemids);
+		tmp = batch;
+		batch = next;
+		next = tmp;
 
 		/* Exit from sync loop if we have spent too much time here.       */
 		/* This is done to allow syncer process to update its statistics. */
 	}
 	while (ZBX_SYNC_MORE == *more && ZBX_HC_SYNC_TIME_MAX >= time(NULL) - sync_start);
 
-	zbx_vector_ptr_destroy(&history_items);
+	/* return the batch popped during the last commit if the sync was stopped */
+	if (0 != batch->popped)
+		hc_sync_batch_return(batch);
+
+	hc_sync_batch_destroy(&batches[0]);
+	hc_sync_batch_destroy(&batches[1]);
+
 	zbx_vector_ptr_destroy(&inventory_values);
 	zbx_vector_ptr_destroy(&item_diff);
 	zbx_vector_ptr_destroy(&trigger_diff);
@@ -3496,7 +3745,6 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 	zbx_vector_uint64_pair_destroy(&proxy_subscribtions);
 
 	zbx_vector_ptr_destroy(&trigger_timers);
-	zbx_vector_uint64_destroy(&triggerids);
 }
 
 /******************************************************************************
@@ -3552,7 +3800,9 @@ static void	sync_history_cache_full(void)
 		}
 	}
 
-	if (0 != hc_queue_get_size())
+	hc_drain_rings();
+
+	if (0 != hc_queue_get_size() || SUCCEED == hc_rings_pending())
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "syncing history data...");
 
@@ -3566,7 +3816,7 @@ static void	sync_history_cache_full(void)
 			zabbix_log(LOG_LEVEL_WARNING, "syncing history data... " ZBX_FS_DBL "%%",
 					(double)values_num / (cache->history_num + values_num) * 100);
 		}
-		while (0 != hc_queue_get_size());
+		while (0 != hc_queue_get_size() || SUCCEED == hc_rings_pending());
 
 		zabbix_log(LOG_LEVEL_WARNING, "syncing history data done");
 	}
@@ -4002,16 +4252,24 @@ void	dc_add_history(zbx_uint64_t itemid, unsigned char item_value_type, unsigned
 
 void	dc_flush_history(void)
 {
+	/* give the drained ring back, so it can be claimed by other processes */
+	hc_ring_release();
+
 	if (0 == item_values_num)
 		return;
 
-	LOCK_CACHE;
+	if (SUCCEED != hc_ring_write(item_values, (int)item_values_num, string_values, string_values_offset))
+	{
+		LOCK_CACHE;
 
-	hc_add_item_values(item_values, item_values_num);
+		/* values queued in the ring must be added first to keep the order of item values */
+		hc_ring_flush();
+		hc_add_item_values(item_values, item_values_num);
 
-	cache->history_num += item_values_num;
+		cache->history_num += item_values_num;
 
-	UNLOCK_CACHE;
+		UNLOCK_CACHE;
+	}
 
 	item_values_num = 0;
 	string_values_offset = 0;
@@ -4142,19 +4400,20 @@ static zbx_hc_item_t	*hc_add_item(zbx_uint64_t itemid, zbx_hc_data_t *data)
  *                                                                            *
  * Purpose: copies string value to history cache                              *
  *                                                                            *
- * Parameters: str - [IN] the string value                                    *
+ * Parameters: str     - [IN] the string value                                *
+ *             strings - [IN] the buffer holding string data                  *
  *                                                                            *
  * Return value: the copied string or NULL if there was not enough memory     *
  *                                                                            *
  ******************************************************************************/
-static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
+static char	*hc_mem_value_str_dup(const dc_value_str_t *str, const char *strings)
 {
 	char	*ptr;
 
 	if (NULL == (ptr = (char *)__hc_mem_malloc_func(NULL, str->len)))
 		return NULL;
 
-	memcpy(ptr, &string_values[str->pvalue], str->len - 1);
+	memcpy(ptr, &strings[str->pvalue], str->len - 1);
 	ptr[str->len - 1] = '\0';
 
 	return ptr;
@@ -4166,8 +4425,9 @@ static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
  *                                                                            *
  * Purpose: clones string value into history data memory                      *
  *                                                                            *
- * Parameters: dst - [IN/OUT] a reference to the cloned value                 *
- *             str - [IN] the string value to clone                           *
+ * Parameters: dst     - [IN/OUT] a reference to the cloned value             *
+ *             str     - [IN] the string value to clone                       *
+ *             strings - [IN] the buffer holding string data                  *
  *                                                                            *
  * Return value: SUCCESS - either there was no need to clone the string       *
  *                         (it was empty or already cloned) or the string was *
@@ -4178,7 +4438,7 @@ static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
  *           until it finishes cloning string value.                          *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
+static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str, const char *strings)
 {
 	if (0 == str->len)
 		return SUCCEED;
@@ -4186,7 +4446,7 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
 	if (NULL != *dst)
 		return SUCCEED;
 
-	if (NULL != (*dst = hc_mem_value_str_dup(str)))
+	if (NULL != (*dst = hc_mem_value_str_dup(str, strings)))
 		return SUCCEED;
 
 	return FAIL;
@@ -4200,6 +4460,7 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
  *                                                                            *
  * Parameters: dst        - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the log value to clone                       *
+ *             strings    - [IN] the buffer holding string data               *
  *                                                                            *
  * Return value: SUCCESS - the log value was cloned successfully              *
  *               FAIL    - not enough memory                                  *
@@ -4208,7 +4469,8 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
  *           until it finishes cloning log value.                             *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_t *item_value)
+static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_t *item_value,
+		const char *strings)
 {
 	if (NULL == *dst)
 	{
@@ -4219,10 +4481,10 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
 		memset(*dst, 0, sizeof(zbx_log_value_t));
 	}
 
-	if (SUCCEED != hc_clone_history_str_data(&(*dst)->value, &item_value->value.value_str))
+	if (SUCCEED != hc_clone_history_str_data(&(*dst)->value, &item_value->value.value_str, strings))
 		return FAIL;
 
-	if (SUCCEED != hc_clone_history_str_data(&(*dst)->source, &item_value->source))
+	if (SUCCEED != hc_clone_history_str_data(&(*dst)->source, &item_value->source, strings))
 		return FAIL;
 
 	(*dst)->logeventid = item_value->logeventid;
@@ -4240,6 +4502,7 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
  *                                                                            *
  * Parameters: data       - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the item value                               *
+ *             strings    - [IN] the buffer holding string data               *
  *                                                                            *
  * Return value: SUCCESS - the item value was cloned successfully             *
  *               FAIL    - not enough memory                                  *
@@ -4248,7 +4511,8 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
  *           until it finishes cloning item value.                            *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *item_value)
+static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *item_value,
+		const char *strings)
 {
 	if (NULL == *data)
 	{
@@ -4270,7 +4534,7 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 	if (ITEM_STATE_NOTSUPPORTED == item_value->state)
 	{
-		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str)))
+		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str, strings)))
 			return FAIL;
 
 		(*data)->value_type = item_value->value_type;
@@ -4281,7 +4545,7 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 	if (0 != (ZBX_DC_FLAG_LLD & item_value->flags))
 	{
-		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str)))
+		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str, strings)))
 			return FAIL;
 
 		(*data)->value_type = ITEM_VALUE_TYPE_TEXT;
@@ -4304,20 +4568,20 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 				break;
 			case ITEM_VALUE_TYPE_STR:
 				if (SUCCEED != hc_clone_history_str_data(&(*data)->value.str,
-						&item_value->value.value_str))
+						&item_value->value.value_str, strings))
 				{
 					return FAIL;
 				}
 				break;
 			case ITEM_VALUE_TYPE_TEXT:
 				if (SUCCEED != hc_clone_history_str_data(&(*data)->value.str,
-						&item_value->value.value_str))
+						&item_value->value.value_str, strings))
 				{
 					return FAIL;
 				}
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				if (SUCCEED != hc_clone_history_log_data(&(*data)->value.log, item_value))
+				if (SUCCEED != hc_clone_history_log_data(&(*data)->value.log, item_value, strings))
 					return FAIL;
 				break;
 		}
@@ -4349,6 +4613,62 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_add_item_value                                                *
+ *                                                                            *
+ * Purpose: adds item value to the history cache                              *
+ *                                                                            *
+ * Parameters: item_value - [IN] the item value to add                        *
+ *             strings    - [IN] the buffer holding item value string data    *
+ *             data       - [IN/OUT] the partially cloned value, must be NULL *
+ *                                   on the first call                        *
+ *                                                                            *
+ * Return value: SUCCEED - the value was added                                *
+ *               FAIL    - not enough memory, the function must be called     *
+ *                         again with the same data after memory is freed     *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_add_item_value(const dc_item_value_t *item_value, const char *strings, zbx_hc_data_t **data)
+{
+	zbx_hc_item_t	*item;
+
+	item = hc_get_item(item_value->itemid);
+
+	/* a record with metadata and no value can be dropped if  */
+	/* the metadata update is copied to the last queued value */
+	if (NULL == *data && NULL != item && 0 != (item_value->flags & ZBX_DC_FLAG_NOVALUE) &&
+			0 != (item_value->flags & ZBX_DC_FLAG_META))
+	{
+		/* skip metadata updates when only one value is queued, */
+		/* because the item might be already being processed    */
+		if (item->head != item->tail)
+		{
+			item->head->lastlogsize = item_value->lastlogsize;
+			item->head->mtime = item_value->mtime;
+			item->head->flags |= ZBX_DC_FLAG_META;
+			return SUCCEED;
+		}
+	}
+
+	if (SUCCEED != hc_clone_history_data(data, item_value, strings))
+		return FAIL;
+
+	if (NULL == item)
+	{
+		item = hc_add_item(item_value->itemid, *data);
+		hc_queue_item(item);
+	}
+	else
+	{
+		item->head->next = *data;
+		item->head = *data;
+	}
+	item->values_num++;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: hc_add_item_values                                               *
@@ -4365,63 +4685,398 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
  ******************************************************************************/
 static void	hc_add_item_values(dc_item_value_t *values, int values_num)
 {
-	dc_item_value_t	*item_value;
-	int		i;
-	zbx_hc_item_t	*item;
+	int	i;
 
 	for (i = 0; i < values_num; i++)
 	{
 		zbx_hc_data_t	*data = NULL;
 
-		item_value = &values[i];
-
-		/* a record with metadata and no value can be dropped if  */
-		/* the metadata update is copied to the last queued value */
-		if (NULL != (item = hc_get_item(item_value->itemid)) &&
-				0 != (item_value->flags & ZBX_DC_FLAG_NOVALUE) &&
-				0 != (item_value->flags & ZBX_DC_FLAG_META))
+		while (SUCCEED != hc_add_item_value(&values[i], string_values, &data))
 		{
-			/* skip metadata updates when only one value is queued, */
-			/* because the item might be already being processed    */
-			if (item->head != item->tail)
-			{
-				item->head->lastlogsize = item_value->lastlogsize;
-				item->head->mtime = item_value->mtime;
-				item->head->flags |= ZBX_DC_FLAG_META;
-				continue;
-			}
+			UNLOCK_CACHE;
+
+			zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
+			sleep(1);
+
+			LOCK_CACHE;
 		}
+	}
+}
 
-		if (SUCCEED != hc_clone_history_data(&data, item_value))
-		{
-			do
-			{
-				UNLOCK_CACHE;
+/******************************************************************************
+ *                                                                            *
+ * history cache ingestion rings                                              *
+ *                                                                            *
+ ******************************************************************************/
 
-				zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
-				sleep(1);
+#ifdef ZBX_HC_RING_ENABLED
 
-				LOCK_CACHE;
-			}
-			while (SUCCEED != hc_clone_history_data(&data, item_value));
+static zbx_hc_ring_t	*hc_ring = NULL;
+static pid_t		hc_ring_pid = 0;
 
-			item = hc_get_item(item_value->itemid);
-		}
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_ring_get                                                      *
+ *                                                                            *
+ * Purpose: returns ring owned by the current process, claiming a free ring   *
+ *          if the process does not own one                                   *
+ *                                                                            *
+ * Return value: the ring or NULL if all rings are claimed by other processes *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_hc_ring_t	*hc_ring_get(void)
+{
+	pid_t	pid;
+	int	i, start;
+
+	/* the ring might have been claimed by parent process before forking */
+	if (hc_ring_pid != (pid = getpid()))
+	{
+		hc_ring = NULL;
+		hc_ring_pid = pid;
+	}
 
-		if (NULL == item)
+	if (NULL != hc_ring || 0 == cache->rings_num)
+		return hc_ring;
+
+	/* spread processes over rings rather than contending for the first one */
+	start = (int)(pid % cache->rings_num);
+
+	for (i = 0; i < cache->rings_num; i++)
+	{
+		zbx_hc_ring_t	*ring = &cache->rings[(start + i) % cache->rings_num];
+		pid_t		owner = 0;
+
+		if (0 != __atomic_compare_exchange_n(&ring->owner, &owner, pid, 0, __ATOMIC_ACQ_REL,
+				__ATOMIC_ACQUIRE))
 		{
-			item = hc_add_item(item_value->itemid, data);
-			hc_queue_item(item);
+			hc_ring = ring;
+			break;
 		}
-		else
+	}
+
+	return hc_ring;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_ring_release                                                  *
+ *                                                                            *
+ * Purpose: releases ring owned by the current process if all values written  *
+ *          into it have been added to history cache                          *
+ *                                                                            *
+ * Comments: A ring with pending values is kept, otherwise the next values of *
+ *           the same item could be written into another ring and added to    *
+ *           history cache before the older ones.                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_ring_release(void)
+{
+	if (NULL == hc_ring || hc_ring_pid != getpid())
+		return;
+
+	if (hc_ring->head != __atomic_load_n(&hc_ring->tail, __ATOMIC_ACQUIRE))
+		return;
+
+	__atomic_store_n(&hc_ring->owner, 0, __ATOMIC_RELEASE);
+	hc_ring = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_ring_reclaim                                                  *
+ *                                                                            *
+ * Purpose: releases drained ring owned by a terminated process               *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring                                           *
+ *                                                                            *
+ * Comments: History cache must be locked.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_ring_reclaim(zbx_hc_ring_t *ring)
+{
+	pid_t	owner;
+
+	if (0 == (owner = __atomic_load_n(&ring->owner, __ATOMIC_ACQUIRE)))
+		return;
+
+	if (ring->tail != __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE))
+		return;
+
+	if (-1 == kill(owner, 0) && ESRCH == errno)
+		__atomic_compare_exchange_n(&ring->owner, &owner, 0, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_ring_write                                                    *
+ *                                                                            *
+ * Purpose: writes local history cache batch into the ring owned by the       *
+ *          current process without locking history cache                     *
+ *                                                                            *
+ * Parameters: values      - [IN] the item values                             *
+ *             values_num  - [IN] the number of item values                   *
+ *             strings     - [IN] the buffer holding item value string data   *
+ *             strings_len - [IN] the length of string data                   *
+ *                                                                            *
+ * Return value: SUCCEED - the values were written                            *
+ *               FAIL    - the process has no ring or there is not enough     *
+ *                         free space in it                                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_ring_write(const dc_item_value_t *values, int values_num, const char *strings,
+		size_t strings_len)
+{
+	zbx_hc_ring_t		*ring;
+	zbx_hc_ring_record_t	*record;
+	zbx_uint64_t		head, tail, offset, size, skip = 0;
+	size_t			values_size;
+
+	if (NULL == (ring = hc_ring_get()))
+		return FAIL;
+
+	values_size = sizeof(dc_item_value_t) * (size_t)values_num;
+	size = ZBX_SIZE_T_ALIGN8(sizeof(zbx_hc_ring_record_t) + values_size + strings_len);
+
+	head = ring->head;
+	tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	offset = head % ring->size;
+
+	/* records are not wrapped around the end of buffer */
+	if (ring->size - offset < size)
+		skip = ring->size - offset;
+
+	if (size + skip > ring->size - (head - tail))
+		return FAIL;
+
+	if (0 != skip)
+	{
+		record = (zbx_hc_ring_record_t *)(ring->buffer + offset);
+		record->size = (zbx_uint32_t)skip;
+		record->values_num = 0;
+		offset = 0;
+	}
+
+	record = (zbx_hc_ring_record_t *)(ring->buffer + offset);
+	record->size = (zbx_uint32_t)size;
+	record->values_num = (zbx_uint32_t)values_num;
+	memcpy(record + 1, values, values_size);
+	memcpy((char *)(record + 1) + values_size, strings, strings_len);
+
+	__atomic_store_n(&ring->head, head + skip + size, __ATOMIC_RELEASE);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_ring_drain                                                    *
+ *                                                                            *
+ * Purpose: adds values written into the ring to history cache                *
+ *                                                                            *
+ * Parameters: ring       - [IN] the ring                                     *
+ *             values_max - [IN/OUT] the maximum number of values to add,     *
+ *                                   decreased by the number of added values  *
+ *                                                                            *
+ * Return value: SUCCEED - the ring was drained                               *
+ *               FAIL    - history cache is full or the maximum number of     *
+ *                         values was added                                   *
+ *                                                                            *
+ * Comments: History cache must be locked.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_ring_drain(zbx_hc_ring_t *ring, int *values_max)
+{
+	zbx_uint64_t	head, tail;
+
+	tail = ring->tail;
+	head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+	while (tail != head)
+	{
+		const zbx_hc_ring_record_t	*record;
+		const dc_item_value_t		*values;
+
+		record = (const zbx_hc_ring_record_t *)(ring->buffer + tail % ring->size);
+		values = (const dc_item_value_t *)(record + 1);
+
+		for (; ring->values_done < record->values_num; ring->values_done++)
 		{
-			item->head->next = data;
-			item->head = data;
+			if (0 == *values_max)
+				return FAIL;
+
+			if (SUCCEED != hc_add_item_value(&values[ring->values_done],
+					(const char *)(values + record->values_num), &ring->pending))
+			{
+				return FAIL;
+			}
+
+			ring->pending = NULL;
+			cache->history_num++;
+			(*values_max)--;
 		}
-		item->values_num++;
+
+		ring->values_done = 0;
+		tail += record->size;
+
+		/* release the record memory to producer */
+		__atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_ring_flush                                                    *
+ *                                                                            *
+ * Purpose: adds all values written into the ring owned by the current        *
+ *          process to history cache                                          *
+ *                                                                            *
+ * Comments: History cache must be locked. If history cache is full this      *
+ *           function will wait until history syncers free enough space.      *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_ring_flush(void)
+{
+	int	values_max = INT_MAX;
+
+	if (NULL == hc_ring || hc_ring_pid != getpid())
+		return;
+
+	while (SUCCEED != hc_ring_drain(hc_ring, &values_max))
+	{
+		UNLOCK_CACHE;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
+		sleep(1);
+
+		LOCK_CACHE;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_drain_rings                                                   *
+ *                                                                            *
+ * Purpose: adds values written into rings to history cache                   *
+ *                                                                            *
+ * Comments: History cache must be locked. Cache memory can be allocated only *
+ *           while holding the lock, so the number of values added by one     *
+ *           call is limited to ZBX_HC_RING_DRAIN_MAX. Draining stops when    *
+ *           the limit is reached or history cache is full and the next call  *
+ *           continues with the same ring, so all rings are served.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_drain_rings(void)
+{
+	int	i, values_max = ZBX_HC_RING_DRAIN_MAX;
+
+	for (i = 0; i < cache->rings_num; i++)
+	{
+		zbx_hc_ring_t	*ring = &cache->rings[cache->rings_next];
+
+		if (SUCCEED != hc_ring_drain(ring, &values_max))
+			break;
+
+		hc_ring_reclaim(ring);
+		cache->rings_next = (cache->rings_next + 1) % cache->rings_num;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_rings_pending                                                 *
+ *                                                                            *
+ * Purpose: checks if there are values written into rings and not yet         *
+ *          added to history cache                                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_rings_pending(void)
+{
+	int	i;
+
+	for (i = 0; i < cache->rings_num; i++)
+	{
+		if (cache->rings[i].tail != __atomic_load_n(&cache->rings[i].head, __ATOMIC_ACQUIRE))
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_init_rings                                                    *
+ *                                                                            *
+ * Purpose: allocates ingestion rings in history cache                        *
+ *                                                                            *
+ * Comments: Rings are not created if history cache is too small.             *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_init_rings(void)
+{
+	zbx_uint64_t	size;
+	int		i;
+
+	size = CONFIG_HISTORY_CACHE_SIZE / ZBX_HC_RING_CACHE_PART / ZBX_HC_RING_NUM;
+
+	if (ZBX_HC_RING_SIZE_MIN > size)
+		return;
+
+	if (ZBX_HC_RING_SIZE_MAX < size)
+		size = ZBX_HC_RING_SIZE_MAX;
+
+	size &= ~(zbx_uint64_t)7;
+
+	cache->rings = (zbx_hc_ring_t *)__hc_mem_malloc_func(NULL, sizeof(zbx_hc_ring_t) * ZBX_HC_RING_NUM);
+	memset(cache->rings, 0, sizeof(zbx_hc_ring_t) * ZBX_HC_RING_NUM);
+
+	for (i = 0; i < ZBX_HC_RING_NUM; i++)
+	{
+		cache->rings[i].buffer = (char *)__hc_mem_malloc_func(NULL, size);
+		cache->rings[i].size = size;
 	}
+
+	cache->rings_num = ZBX_HC_RING_NUM;
+}
+
+#else
+
+static int	hc_ring_write(const dc_item_value_t *values, int values_num, const char *strings,
+		size_t strings_len)
+{
+	ZBX_UNUSED(values);
+	ZBX_UNUSED(values_num);
+	ZBX_UNUSED(strings);
+	ZBX_UNUSED(strings_len);
+
+	return FAIL;
 }
 
+static void	hc_ring_flush(void)
+{
+}
+
+static void	hc_ring_release(void)
+{
+}
+
+static void	hc_drain_rings(void)
+{
+}
+
+static int	hc_rings_pending(void)
+{
+	return FAIL;
+}
+
+static void	hc_init_rings(void)
+{
+}
+
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: hc_copy_history_data                                             *
@@ -4503,6 +5158,8 @@ static void	hc_pop_items(zbx_vector_ptr_t *history_items)
 	zbx_binary_heap_elem_t	*elem;
 	zbx_hc_item_t		*item;
 
+	hc_drain_rings();
+
 	while (ZBX_HC_SYNC_MAX > history_items->values_num && FAIL == zbx_binary_heap_empty(&cache->history_queue))
 	{
 		elem = zbx_binary_heap_find_min(&cache->history_queue);
@@ -4736,6 +5393,8 @@ int	init_database_cache(char **error)
 			goto out;
 	}
 
+	hc_init_rings();
+
 	cache->history_num_total = 0;
 	cache->history_progress_ts = 0;
 
@@ -5158,3 +5817,7 @@ out:
 
 	return ret;
 }
+
+#ifdef HAVE_TESTS
+#	include "../../../tests/libs/zbxdbcache/dc_flush_history_test.c"
+#endif
@@ -50,6 +50,45 @@ int	sync_in_progress = 0;
 #define START_SYNC	WRLOCK_CACHE; sync_in_progress = 1
 #define FINISH_SYNC	sync_in_progress = 0; UNLOCK_CACHE
 
+/* Item scheduling data (poller queues, item nextcheck, location, poller_type, queue_priority, */
+/* schedulable and interface disable_until) can be changed either under configuration cache    */
+/* write lock or under read lock together with the queue lock, so it also can be read only     */
+/* under write lock or under read lock together with the queue lock. The queue lock must       */
+/* always be taken after the configuration cache lock.                                         */
+#define LOCK_QUEUE					\
+							\
+do							\
+{							\
+	if (0 == sync_in_progress)			\
+		zbx_mutex_lock(config_queue_lock);	\
+}							\
+while (0)
+
+#define UNLOCK_QUEUE					\
+							\
+do							\
+{							\
+	if (0 == sync_in_progress)			\
+		zbx_mutex_unlock(config_queue_lock);	\
+}							\
+while (0)
+
+/* The exceptions are item nextcheck and interface disable_until, which are also copied by     */
+/* functions holding only the read lock. Under the read lock they are always changed and read  */
+/* atomically, so these functions do not need to wait for the queue lock. Without atomic       */
+/* memory access builtins these functions take the queue lock with LOCK_SCHEDULE.              */
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+#	define DC_SCHEDULE_GET(field)		__atomic_load_n(&(field), __ATOMIC_RELAXED)
+#	define DC_SCHEDULE_SET(field, value)	__atomic_store_n(&(field), (value), __ATOMIC_RELAXED)
+#	define LOCK_SCHEDULE
+#	define UNLOCK_SCHEDULE
+#else
+#	define DC_SCHEDULE_GET(field)		(field)
+#	define DC_SCHEDULE_SET(field, value)	(field) = (value)
+#	define LOCK_SCHEDULE			LOCK_QUEUE
+#	define UNLOCK_SCHEDULE			UNLOCK_QUEUE
+#endif
+
 #define ZBX_LOC_NOWHERE	0
 #define ZBX_LOC_QUEUE	1
 #define ZBX_LOC_POLLER	2
@@ -94,6 +133,7 @@ typedef int (*zbx_value_validator_func_t)(const char *macro, const char *value,
 
 ZBX_DC_CONFIG	*config = NULL;
 zbx_rwlock_t	config_lock = ZBX_RWLOCK_NULL;
+static zbx_mutex_t	config_queue_lock = ZBX_MUTEX_NULL;
 static zbx_mem_info_t	*config_mem;
 
 extern unsigned char	program_type;
@@ -370,7 +410,7 @@ static int	DCitem_nextcheck_update(ZBX_DC_ITEM *item, const ZBX_DC_INTERFACE *in
 		/* and such changes will be detected during configuration synchronization. DCsync_items()  */
 		/* detects item configuration changes affecting check scheduling and passes them in flags. */
 
-		item->nextcheck = ZBX_JAN_2038;
+		DC_SCHEDULE_SET(item->nextcheck, ZBX_JAN_2038);
 		item->schedulable = 0;
 		return FAIL;
 	}
@@ -378,15 +418,15 @@ static int	DCitem_nextcheck_update(ZBX_DC_ITEM *item, const ZBX_DC_INTERFACE *in
 	if (0 != (flags & ZBX_HOST_UNREACHABLE) && NULL != interface && 0 != (disable_until =
 			DCget_disable_until(item, interface)))
 	{
-		item->nextcheck = calculate_item_nextcheck_unreachable(simple_interval,
-				custom_intervals, disable_until);
+		DC_SCHEDULE_SET(item->nextcheck, calculate_item_nextcheck_unreachable(simple_interval,
+				custom_intervals, disable_until));
 	}
 	else
 	{
 		/* supported items and items that could not have been scheduled previously, but had */
 		/* their update interval fixed, should be scheduled using their update intervals */
-		item->nextcheck = calculate_item_nextcheck(seed, item->type, simple_interval,
-				custom_intervals, now);
+		DC_SCHEDULE_SET(item->nextcheck, calculate_item_nextcheck(seed, item->type, simple_interval,
+				custom_intervals, now));
 	}
 
 	zbx_custom_interval_free(custom_intervals);
@@ -433,7 +473,7 @@ static void	DCitem_poller_type_update(ZBX_DC_ITEM *dc_item, const ZBX_DC_HOST *d
 static void	DCincrease_disable_until(ZBX_DC_INTERFACE *interface, int now)
 {
 	if (NULL != interface && 0 != interface->errors_from)
-		interface->disable_until = now + CONFIG_TIMEOUT;
+		DC_SCHEDULE_SET(interface->disable_until, now + CONFIG_TIMEOUT);
 }
 
 /******************************************************************************
@@ -600,7 +640,7 @@ static void	DCupdate_item_queue(ZBX_DC_ITEM *item, unsigned char old_poller_type
 	if (ZBX_LOC_QUEUE == item->location && old_poller_type != item->poller_type)
 	{
 		item->location = ZBX_LOC_NOWHERE;
-		zbx_binary_heap_remove_direct(&config->queues[old_poller_type], item->itemid);
+		zbx_timer_wheel_remove(&config->queues[old_poller_type], item->itemid);
 	}
 
 	if (item->poller_type == ZBX_NO_POLLER)
@@ -615,10 +655,10 @@ static void	DCupdate_item_queue(ZBX_DC_ITEM *item, unsigned char old_poller_type
 	if (ZBX_LOC_QUEUE != item->location)
 	{
 		item->location = ZBX_LOC_QUEUE;
-		zbx_binary_heap_insert(&config->queues[item->poller_type], &elem);
+		zbx_timer_wheel_insert(&config->queues[item->poller_type], &elem, item->nextcheck);
 	}
 	else
-		zbx_binary_heap_update_direct(&config->queues[item->poller_type], &elem);
+		zbx_timer_wheel_update(&config->queues[item->poller_type], &elem, item->nextcheck);
 }
 
 static void	DCupdate_proxy_queue(ZBX_DC_PROXY *proxy)
@@ -2668,6 +2708,119 @@ static void	dc_interface_snmpitems_remove(ZBX_DC_ITEM *item)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_item_index_add                                                *
+ *                                                                            *
+ * Purpose: add item to key name -> items and hostid -> items indexes         *
+ *                                                                            *
+ * Parameters: item - [IN] the item                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_item_index_add(ZBX_DC_ITEM *item)
+{
+	zbx_dc_key_item_index_t		*key_index, key_index_local;
+	zbx_dc_host_item_index_t	*host_index;
+	int				found;
+
+	key_index_local.key_name = item->key;
+
+	if (NULL == (key_index = (zbx_dc_key_item_index_t *)zbx_hashset_search(&config->key_items_index,
+			&key_index_local)))
+	{
+		char	*key_name;
+
+		key_name = zbx_strdup(NULL, item->key);
+		key_name[strcspn(key_name, "[")] = '\0';
+		key_index_local.key_name = zbx_strpool_intern(key_name);
+		zbx_free(key_name);
+
+		key_index = (zbx_dc_key_item_index_t *)zbx_hashset_insert(&config->key_items_index, &key_index_local,
+				sizeof(zbx_dc_key_item_index_t));
+
+		zbx_vector_ptr_create_ext(&key_index->items, __config_mem_malloc_func, __config_mem_realloc_func,
+				__config_mem_free_func);
+	}
+
+	item->key_index_pos = key_index->items.values_num;
+	zbx_vector_ptr_append(&key_index->items, item);
+
+	host_index = (zbx_dc_host_item_index_t *)DCfind_id(&config->host_items_index, item->hostid,
+			sizeof(zbx_dc_host_item_index_t), &found);
+
+	if (0 == found)
+	{
+		zbx_vector_ptr_create_ext(&host_index->items, __config_mem_malloc_func, __config_mem_realloc_func,
+				__config_mem_free_func);
+	}
+
+	item->host_index_pos = host_index->items.values_num;
+	zbx_vector_ptr_append(&host_index->items, item);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_item_index_remove                                             *
+ *                                                                            *
+ * Purpose: remove item from key name -> items and hostid -> items indexes    *
+ *                                                                            *
+ * Parameters: item - [IN] the item                                           *
+ *                                                                            *
+ * Comments: The item must be removed before its host or key is changed.      *
+ *           Items are removed by their stored positions, the last item moved *
+ *           into the freed position gets its position updated.               *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_item_index_remove(ZBX_DC_ITEM *item)
+{
+	zbx_dc_key_item_index_t		*key_index, key_index_local;
+	zbx_dc_host_item_index_t	*host_index;
+	int				index;
+
+	key_index_local.key_name = item->key;
+
+	if (NULL != (key_index = (zbx_dc_key_item_index_t *)zbx_hashset_search(&config->key_items_index,
+			&key_index_local)))
+	{
+		index = item->key_index_pos;
+
+		if (index < key_index->items.values_num && item == key_index->items.values[index])
+		{
+			zbx_vector_ptr_remove_noorder(&key_index->items, index);
+
+			if (index < key_index->items.values_num)
+				((ZBX_DC_ITEM *)key_index->items.values[index])->key_index_pos = index;
+		}
+
+		if (0 == key_index->items.values_num)
+		{
+			zbx_vector_ptr_destroy(&key_index->items);
+			zbx_strpool_release(key_index->key_name);
+			zbx_hashset_remove_direct(&config->key_items_index, key_index);
+		}
+	}
+
+	if (NULL != (host_index = (zbx_dc_host_item_index_t *)zbx_hashset_search(&config->host_items_index,
+			&item->hostid)))
+	{
+		index = item->host_index_pos;
+
+		if (index < host_index->items.values_num && item == host_index->items.values[index])
+		{
+			zbx_vector_ptr_remove_noorder(&host_index->items, index);
+
+			if (index < host_index->items.values_num)
+				((ZBX_DC_ITEM *)host_index->items.values[index])->host_index_pos = index;
+		}
+
+		if (0 == host_index->items.values_num)
+		{
+			zbx_vector_ptr_destroy(&host_index->items);
+			zbx_hashset_remove_direct(&config->host_items_index, host_index);
+		}
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: dc_masteritem_remove_depitem                                     *
@@ -2787,7 +2940,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 
 	time_t			now;
 	unsigned char		status, type, value_type, old_poller_type;
-	int			found, update_index, ret, i,  old_nextcheck;
+	int			found, update_index, update_item_index, ret, i, old_nextcheck;
 	zbx_uint64_t		itemid, hostid, interfaceid;
 	zbx_vector_ptr_t	dep_items;
 
@@ -2825,11 +2978,14 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 		/* see whether we should and can update items_hk index at this point */
 
 		update_index = 0;
+		update_item_index = 0;
 
 		if (0 == found || item->hostid != hostid || 0 != strcmp(item->key, row[5]))
 		{
 			if (1 == found)
 			{
+				dc_item_index_remove(item);
+
 				item_hk_local.hostid = item->hostid;
 				item_hk_local.key = item->key;
 
@@ -2855,6 +3011,8 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 				item_hk->item_ptr = item;
 			else
 				update_index = 1;
+
+			update_item_index = 1;
 		}
 
 		/* store new information in item structure */
@@ -2939,6 +3097,11 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 			zbx_hashset_insert(&config->items_hk, &item_hk_local, sizeof(ZBX_DC_ITEM_HK));
 		}
 
+		/* update key name and host item indexes */
+
+		if (1 == update_item_index)
+			dc_item_index_add(item);
+
 		/* process item intervals and update item nextcheck */
 
 		if (SUCCEED == DCstrpool_replace(found, &item->delay, row[8]))
@@ -3562,8 +3725,10 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 			zbx_hashset_remove_direct(&config->items_hk, item_hk);
 		}
 
+		dc_item_index_remove(item);
+
 		if (ZBX_LOC_QUEUE == item->location)
-			zbx_binary_heap_remove_direct(&config->queues[item->poller_type], item->itemid);
+			zbx_timer_wheel_remove(&config->queues[item->poller_type], item->itemid);
 
 		zbx_strpool_release(item->key);
 		zbx_strpool_release(item->error);
@@ -6545,6 +6710,10 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 				config->items.num_data, config->items.num_slots);
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() items_hk   : %d (%d slots)", __func__,
 				config->items_hk.num_data, config->items_hk.num_slots);
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() key_items  : %d (%d slots)", __func__,
+				config->key_items_index.num_data, config->key_items_index.num_slots);
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() host_items : %d (%d slots)", __func__,
+				config->host_items_index.num_data, config->host_items_index.num_slots);
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() numitems   : %d (%d slots)", __func__,
 				config->numitems.num_data, config->numitems.num_slots);
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() preprocitems: %d (%d slots)", __func__,
@@ -6613,8 +6782,8 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 
 		for (i = 0; ZBX_POLLER_TYPE_COUNT > i; i++)
 		{
-			zabbix_log(LOG_LEVEL_DEBUG, "%s() queue[%d]   : %d (%d allocated)", __func__,
-					i, config->queues[i].elems_num, config->queues[i].elems_alloc);
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() queue[%d]   : %d (%d ready)", __func__,
+					i, zbx_timer_wheel_elems_num(&config->queues[i]), config->queues[i].ready.elems_num);
 		}
 
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() pqueue     : %d (%d allocated)", __func__,
@@ -6722,6 +6891,30 @@ static int	__config_item_hk_compare(const void *d1, const void *d2)
 	return item_hk_1->key == item_hk_2->key ? 0 : strcmp(item_hk_1->key, item_hk_2->key);
 }
 
+/* key names are hashed and compared up to the parameters, so full item keys can be used for lookups */
+static zbx_hash_t	__config_key_items_hash(const void *data)
+{
+	const zbx_dc_key_item_index_t	*key_index = (const zbx_dc_key_item_index_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_ALGO(key_index->key_name, strcspn(key_index->key_name, "["),
+			ZBX_DEFAULT_HASH_SEED);
+}
+
+static int	__config_key_items_compare(const void *d1, const void *d2)
+{
+	const zbx_dc_key_item_index_t	*key_index_1 = (const zbx_dc_key_item_index_t *)d1;
+	const zbx_dc_key_item_index_t	*key_index_2 = (const zbx_dc_key_item_index_t *)d2;
+	size_t				len;
+
+	if (key_index_1->key_name == key_index_2->key_name)
+		return 0;
+
+	len = strcspn(key_index_1->key_name, "[");
+	ZBX_RETURN_IF_NOT_EQUAL(len, strcspn(key_index_2->key_name, "["));
+
+	return memcmp(key_index_1->key_name, key_index_2->key_name, len);
+}
+
 static zbx_hash_t	__config_host_h_hash(const void *data)
 {
 	const ZBX_DC_HOST_H	*host_h = (const ZBX_DC_HOST_H *)data;
@@ -6840,6 +7033,35 @@ static int	__config_snmp_item_compare(const ZBX_DC_ITEM *i1, const ZBX_DC_ITEM *
 	return 0;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: __config_agent_item_compare                                      *
+ *                                                                            *
+ * Purpose: check if passive agent item can be polled in the same batch as    *
+ *          the previously taken item                                         *
+ *                                                                            *
+ * Comments: only unencrypted connections are polled asynchronously, items of *
+ *           hosts using TLS are still retrieved one at a time                *
+ *                                                                            *
+ ******************************************************************************/
+static int	__config_agent_item_compare(const ZBX_DC_ITEM *i1, const ZBX_DC_ITEM *i2)
+{
+	const ZBX_DC_HOST	*h1;
+	const ZBX_DC_HOST	*h2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(i1->type, i2->type);
+
+	if (NULL == (h1 = (const ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &i1->hostid)) ||
+			NULL == (h2 = (const ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &i2->hostid)))
+	{
+		return 0;
+	}
+
+	ZBX_RETURN_IF_NOT_EQUAL(h1->tls_connect, h2->tls_connect);
+
+	return 0;
+}
+
 static int	__config_heap_elem_compare(const void *d1, const void *d2)
 {
 	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
@@ -7019,6 +7241,9 @@ int	init_configuration_cache(char **error)
 	if (SUCCEED != (ret = zbx_rwlock_create(&config_lock, ZBX_RWLOCK_CONFIG, error)))
 		goto out;
 
+	if (SUCCEED != (ret = zbx_mutex_create(&config_queue_lock, ZBX_MUTEX_CONFIG_QUEUE, error)))
+		goto out;
+
 	if (SUCCEED != (ret = zbx_mem_create(&config_mem, CONFIG_CONF_CACHE_SIZE, "configuration cache",
 			"CacheSize", 0, error)))
 	{
@@ -7078,6 +7303,7 @@ int	init_configuration_cache(char **error)
 	CREATE_HASHSET(config->item_tags, 0);
 	CREATE_HASHSET(config->host_tags, 0);
 	CREATE_HASHSET(config->host_tags_index, 0);
+	CREATE_HASHSET(config->host_items_index, 0);
 	CREATE_HASHSET(config->correlations, 0);
 	CREATE_HASHSET(config->corr_conditions, 0);
 	CREATE_HASHSET(config->corr_operations, 0);
@@ -7094,6 +7320,7 @@ int	init_configuration_cache(char **error)
 	CREATE_HASHSET(config->maintenance_tags, 0);
 
 	CREATE_HASHSET_EXT(config->items_hk, 100, __config_item_hk_hash, __config_item_hk_compare);
+	CREATE_HASHSET_EXT(config->key_items_index, 100, __config_key_items_hash, __config_key_items_compare);
 	CREATE_HASHSET_EXT(config->hosts_h, 10, __config_host_h_hash, __config_host_h_compare);
 	CREATE_HASHSET_EXT(config->hosts_p, 0, __config_host_h_hash, __config_host_h_compare);
 	CREATE_HASHSET_EXT(config->gmacros_m, 0, __config_gmacro_m_hash, __config_gmacro_m_compare);
@@ -7113,25 +7340,22 @@ int	init_configuration_cache(char **error)
 		switch (i)
 		{
 			case ZBX_POLLER_TYPE_JAVA:
-				zbx_binary_heap_create_ext(&config->queues[i],
+				zbx_timer_wheel_create_ext(&config->queues[i],
 						__config_java_elem_compare,
-						ZBX_BINARY_HEAP_OPTION_DIRECT,
 						__config_mem_malloc_func,
 						__config_mem_realloc_func,
 						__config_mem_free_func);
 				break;
 			case ZBX_POLLER_TYPE_PINGER:
-				zbx_binary_heap_create_ext(&config->queues[i],
+				zbx_timer_wheel_create_ext(&config->queues[i],
 						__config_pinger_elem_compare,
-						ZBX_BINARY_HEAP_OPTION_DIRECT,
 						__config_mem_malloc_func,
 						__config_mem_realloc_func,
 						__config_mem_free_func);
 				break;
 			default:
-				zbx_binary_heap_create_ext(&config->queues[i],
+				zbx_timer_wheel_create_ext(&config->queues[i],
 						__config_heap_elem_compare,
-						ZBX_BINARY_HEAP_OPTION_DIRECT,
 						__config_mem_malloc_func,
 						__config_mem_realloc_func,
 						__config_mem_free_func);
@@ -7219,6 +7443,7 @@ void	free_configuration_cache(void)
 
 	zbx_mem_destroy(config_mem);
 	config_mem = NULL;
+	zbx_mutex_destroy(&config_queue_lock);
 	zbx_rwlock_destroy(&config_lock);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -7599,7 +7824,7 @@ static void	DCget_interface(DC_INTERFACE *dst_interface, const ZBX_DC_INTERFACE
 		dst_interface->type = src_interface->type;
 		dst_interface->main = src_interface->main;
 		dst_interface->available = src_interface->available;
-		dst_interface->disable_until = src_interface->disable_until;
+		dst_interface->disable_until = DC_SCHEDULE_GET(src_interface->disable_until);
 		dst_interface->errors_from = src_interface->errors_from;
 		strscpy(dst_interface->error, src_interface->error);
 	}
@@ -8129,6 +8354,7 @@ void	DCconfig_get_items_by_keys(DC_ITEM *items, zbx_host_key_t *keys, int *errco
 	const ZBX_DC_HOST	*dc_host;
 
 	RDLOCK_CACHE;
+	LOCK_SCHEDULE;
 
 	for (i = 0; i < num; i++)
 	{
@@ -8144,6 +8370,7 @@ void	DCconfig_get_items_by_keys(DC_ITEM *items, zbx_host_key_t *keys, int *errco
 		errcodes[i] = SUCCEED;
 	}
 
+	UNLOCK_SCHEDULE;
 	UNLOCK_CACHE;
 }
 
@@ -8188,6 +8415,7 @@ void	DCconfig_get_items_by_itemids(DC_ITEM *items, const zbx_uint64_t *itemids,
 	const ZBX_DC_HOST	*dc_host;
 
 	RDLOCK_CACHE;
+	LOCK_SCHEDULE;
 
 	for (i = 0; i < num; i++)
 	{
@@ -8203,6 +8431,7 @@ void	DCconfig_get_items_by_itemids(DC_ITEM *items, const zbx_uint64_t *itemids,
 		errcodes[i] = SUCCEED;
 	}
 
+	UNLOCK_SCHEDULE;
 	UNLOCK_CACHE;
 }
 
@@ -8217,6 +8446,7 @@ void	DCconfig_get_items_by_itemids_partial(DC_ITEM *items, const zbx_uint64_t *i
 	memset(errcodes, 0, sizeof(int) * (size_t)num);
 
 	RDLOCK_CACHE;
+	LOCK_SCHEDULE;
 
 	for (i = 0; i < num; i++)
 	{
@@ -8239,6 +8469,7 @@ void	DCconfig_get_items_by_itemids_partial(DC_ITEM *items, const zbx_uint64_t *i
 		DCget_item(&items[i], dc_item, mode);
 	}
 
+	UNLOCK_SCHEDULE;
 	UNLOCK_CACHE;
 
 	/* avoid unnecessary allocations inside lock if there are no error or units */
@@ -9295,9 +9526,11 @@ int	DCconfig_get_interface_by_type(DC_INTERFACE *interface, zbx_uint64_t hostid,
 	int	res;
 
 	RDLOCK_CACHE;
+	LOCK_SCHEDULE;
 
 	res = dc_get_interface_by_type(interface, hostid, type);
 
+	UNLOCK_SCHEDULE;
 	UNLOCK_CACHE;
 
 	return res;
@@ -9323,6 +9556,7 @@ int	DCconfig_get_interface(DC_INTERFACE *interface, zbx_uint64_t hostid, zbx_uin
 	const ZBX_DC_INTERFACE	*dc_interface;
 
 	RDLOCK_CACHE;
+	LOCK_SCHEDULE;
 
 	if (0 != itemid)
 	{
@@ -9355,6 +9589,7 @@ int	DCconfig_get_interface(DC_INTERFACE *interface, zbx_uint64_t hostid, zbx_uin
 	}
 
 unlock:
+	UNLOCK_SCHEDULE;
 	UNLOCK_CACHE;
 
 	return res;
@@ -9371,23 +9606,9 @@ unlock:
  * Return value: nextcheck or FAIL if no items for the specified queue        *
  *                                                                            *
  ******************************************************************************/
-static int	dc_config_get_queue_nextcheck(zbx_binary_heap_t *queue)
+static int	dc_config_get_queue_nextcheck(zbx_timer_wheel_t *queue)
 {
-	int				nextcheck;
-	const zbx_binary_heap_elem_t	*min;
-	const ZBX_DC_ITEM		*dc_item;
-
-	if (FAIL == zbx_binary_heap_empty(queue))
-	{
-		min = zbx_binary_heap_find_min(queue);
-		dc_item = (const ZBX_DC_ITEM *)min->data;
-
-		nextcheck = dc_item->nextcheck;
-	}
-	else
-		nextcheck = FAIL;
-
-	return nextcheck;
+	return zbx_timer_wheel_min_time(queue);
 }
 
 /******************************************************************************
@@ -9406,16 +9627,18 @@ static int	dc_config_get_queue_nextcheck(zbx_binary_heap_t *queue)
 int	DCconfig_get_poller_nextcheck(unsigned char poller_type)
 {
 	int			nextcheck;
-	zbx_binary_heap_t	*queue;
+	zbx_timer_wheel_t	*queue;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() poller_type:%d", __func__, (int)poller_type);
 
 	queue = &config->queues[poller_type];
 
 	RDLOCK_CACHE;
+	LOCK_QUEUE;
 
 	nextcheck = dc_config_get_queue_nextcheck(queue);
 
+	UNLOCK_QUEUE;
 	UNLOCK_CACHE;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, nextcheck);
@@ -9457,7 +9680,7 @@ static void	dc_requeue_item_at(ZBX_DC_ITEM *dc_item, ZBX_DC_HOST *dc_host, int n
 	dc_item->queue_priority = ZBX_QUEUE_PRIORITY_HIGH;
 
 	old_nextcheck = dc_item->nextcheck;
-	dc_item->nextcheck = nextcheck;
+	DC_SCHEDULE_SET(dc_item->nextcheck, nextcheck);
 
 	old_poller_type = dc_item->poller_type;
 	DCitem_poller_type_update(dc_item, dc_host, ZBX_ITEM_COLLECTED);
@@ -9467,70 +9690,83 @@ static void	dc_requeue_item_at(ZBX_DC_ITEM *dc_item, ZBX_DC_HOST *dc_host, int n
 
 /******************************************************************************
  *                                                                            *
- * Function: DCconfig_get_poller_items                                        *
+ * Function: dc_get_poller_items                                              *
  *                                                                            *
  * Purpose: Get array of items for selected poller                            *
  *                                                                            *
- * Parameters: poller_type - [IN] poller type (ZBX_POLLER_TYPE_...)           *
- *             items       - [OUT] array of items                             *
+ * Parameters: poller_type     - [IN] poller type (ZBX_POLLER_TYPE_...)       *
+ *             items           - [IN/OUT] array of items                      *
+ *             agent_items_max - [IN] the maximum number of unencrypted       *
+ *                                    passive agent items to get into the     *
+ *                                    supplied array, 0 to get the next       *
+ *                                    batch of any items                      *
  *                                                                            *
  * Return value: number of items in items array                               *
  *                                                                            *
- * Author: Alexander Vladishev, Aleksandrs Saveljevs                          *
- *                                                                            *
- * Comments: Items leave the queue only through this function. Pollers must   *
- *           always return the items they have taken using DCrequeue_items()  *
- *           or DCpoller_requeue_items().                                     *
- *                                                                            *
- *           Currently batch polling is supported only for JMX, SNMP and      *
- *           icmpping* simple checks. In other cases only single item is      *
- *           retrieved.                                                       *
- *                                                                            *
- *           IPMI poller queue are handled by DCconfig_get_ipmi_poller_items()*
- *           function.                                                        *
- *                                                                            *
  ******************************************************************************/
-int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items)
+static int	dc_get_poller_items(unsigned char poller_type, DC_ITEM **items, int agent_items_max)
 {
 	int			now, num = 0, max_items;
-	zbx_binary_heap_t	*queue;
+	zbx_timer_wheel_t	*queue;
+	zbx_binary_heap_elem_t	*min;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() poller_type:%d", __func__, (int)poller_type);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() poller_type:%d agent_items_max:%d", __func__, (int)poller_type,
+			agent_items_max);
 
 	now = time(NULL);
 
 	queue = &config->queues[poller_type];
 
-	switch (poller_type)
+	if (0 != agent_items_max)
 	{
-		case ZBX_POLLER_TYPE_JAVA:
-			max_items = MAX_JAVA_ITEMS;
-			break;
-		case ZBX_POLLER_TYPE_PINGER:
-			max_items = MAX_PINGER_ITEMS;
-			break;
-		default:
-			max_items = 1;
+		max_items = agent_items_max;
+	}
+	else
+	{
+		switch (poller_type)
+		{
+			case ZBX_POLLER_TYPE_JAVA:
+				max_items = MAX_JAVA_ITEMS;
+				break;
+			case ZBX_POLLER_TYPE_PINGER:
+				max_items = MAX_PINGER_ITEMS;
+				break;
+			default:
+				max_items = 1;
+		}
 	}
 
-	WRLOCK_CACHE;
+	RDLOCK_CACHE;
+	LOCK_QUEUE;
+
+	zbx_timer_wheel_advance(queue, now);
 
-	while (num < max_items && FAIL == zbx_binary_heap_empty(queue))
+	while (num < max_items && NULL != (min = zbx_timer_wheel_find_min(queue)))
 	{
 		int				disable_until;
-		const zbx_binary_heap_elem_t	*min;
 		ZBX_DC_HOST			*dc_host;
 		ZBX_DC_INTERFACE		*dc_interface;
 		ZBX_DC_ITEM			*dc_item;
 		static const ZBX_DC_ITEM	*dc_item_prev = NULL;
 
-		min = zbx_binary_heap_find_min(queue);
 		dc_item = (ZBX_DC_ITEM *)min->data;
 
 		if (dc_item->nextcheck > now)
 			break;
 
-		if (0 != num)
+		if (0 != agent_items_max)
+		{
+			/* other due items are left for the next batch of the poller */
+			if (ITEM_TYPE_ZABBIX != dc_item->type)
+				break;
+
+			if (NULL != (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)) &&
+					ZBX_TCP_SEC_UNENCRYPTED != dc_host->tls_connect)
+			{
+				break;
+			}
+		}
+		else if (0 != num)
 		{
 			if (ITEM_TYPE_SNMP == dc_item_prev->type)
 			{
@@ -9542,9 +9778,14 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items)
 				if (0 != __config_java_item_compare(dc_item_prev, dc_item))
 					break;
 			}
+			else if (ITEM_TYPE_ZABBIX == dc_item_prev->type)
+			{
+				if (0 != __config_agent_item_compare(dc_item_prev, dc_item))
+					break;
+			}
 		}
 
-		zbx_binary_heap_remove_min(queue);
+		zbx_timer_wheel_remove_min(queue);
 		dc_item->location = ZBX_LOC_NOWHERE;
 
 		if (NULL == (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
@@ -9591,7 +9832,7 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items)
 			}
 		}
 
-		if (0 == num)
+		if (0 == num && 0 == agent_items_max)
 		{
 			if (ZBX_POLLER_TYPE_NORMAL == poller_type && ITEM_TYPE_SNMP == dc_item->type &&
 					0 == (ZBX_FLAG_DISCOVERY_RULE & dc_item->flags))
@@ -9606,6 +9847,12 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items)
 					max_items = DCconfig_get_suggested_snmp_vars_nolock(dc_item->interfaceid, NULL);
 				}
 			}
+			else if (1 == CONFIG_ASYNC_AGENT_CHECKS && ZBX_POLLER_TYPE_NORMAL == poller_type &&
+					ITEM_TYPE_ZABBIX == dc_item->type &&
+					ZBX_TCP_SEC_UNENCRYPTED == dc_host->tls_connect)
+			{
+				max_items = MAX_AGENT_ITEMS;
+			}
 
 			if (1 < max_items)
 				*items = zbx_malloc(NULL, sizeof(DC_ITEM) * max_items);
@@ -9618,6 +9865,7 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items)
 		num++;
 	}
 
+	UNLOCK_QUEUE;
 	UNLOCK_CACHE;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, num);
@@ -9625,6 +9873,60 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items)
 	return num;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_get_poller_items                                        *
+ *                                                                            *
+ * Purpose: Get array of items for selected poller                            *
+ *                                                                            *
+ * Parameters: poller_type - [IN] poller type (ZBX_POLLER_TYPE_...)           *
+ *             items       - [OUT] array of items                             *
+ *                                                                            *
+ * Return value: number of items in items array                               *
+ *                                                                            *
+ * Author: Alexander Vladishev, Aleksandrs Saveljevs                          *
+ *                                                                            *
+ * Comments: Items leave the queue only through this function and             *
+ *           DCconfig_get_agent_poller_items(). Pollers must always return    *
+ *           the items they have taken using DCrequeue_items() or             *
+ *           DCpoller_requeue_items().                                        *
+ *                                                                            *
+ *           Currently batch polling is supported only for JMX, SNMP,         *
+ *           unencrypted passive agent items of normal pollers (when enabled  *
+ *           by AsyncAgentChecks configuration parameter) and icmpping*       *
+ *           simple checks. In other cases only single item is retrieved.     *
+ *                                                                            *
+ *           IPMI poller queue are handled by DCconfig_get_ipmi_poller_items()*
+ *           function.                                                        *
+ *                                                                            *
+ ******************************************************************************/
+int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items)
+{
+	return dc_get_poller_items(poller_type, items, 0);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_get_agent_poller_items                                  *
+ *                                                                            *
+ * Purpose: Get due unencrypted passive agent items of any hosts to fill free *
+ *          connections of asynchronous agent checks                          *
+ *                                                                            *
+ * Parameters: poller_type - [IN] poller type (ZBX_POLLER_TYPE_NORMAL)        *
+ *             items       - [OUT] array of items                             *
+ *             max_items   - [IN] the array size                              *
+ *                                                                            *
+ * Return value: number of items in items array                               *
+ *                                                                            *
+ * Comments: Stops at the first due item of other type, which is left for     *
+ *           DCconfig_get_poller_items().                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	DCconfig_get_agent_poller_items(unsigned char poller_type, DC_ITEM *items, int max_items)
+{
+	return dc_get_poller_items(poller_type, &items, max_items);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: DCconfig_get_ipmi_poller_items                                   *
@@ -9646,29 +9948,31 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM **items)
 int	DCconfig_get_ipmi_poller_items(int now, DC_ITEM *items, int items_num, int *nextcheck)
 {
 	int			num = 0;
-	zbx_binary_heap_t	*queue;
+	zbx_timer_wheel_t	*queue;
+	zbx_binary_heap_elem_t	*min;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	queue = &config->queues[ZBX_POLLER_TYPE_IPMI];
 
-	WRLOCK_CACHE;
+	RDLOCK_CACHE;
+	LOCK_QUEUE;
 
-	while (num < items_num && FAIL == zbx_binary_heap_empty(queue))
+	zbx_timer_wheel_advance(queue, now);
+
+	while (num < items_num && NULL != (min = zbx_timer_wheel_find_min(queue)))
 	{
 		int				disable_until;
-		const zbx_binary_heap_elem_t	*min;
 		ZBX_DC_HOST			*dc_host;
 		ZBX_DC_INTERFACE		*dc_interface;
 		ZBX_DC_ITEM			*dc_item;
 
-		min = zbx_binary_heap_find_min(queue);
 		dc_item = (ZBX_DC_ITEM *)min->data;
 
 		if (dc_item->nextcheck > now)
 			break;
 
-		zbx_binary_heap_remove_min(queue);
+		zbx_timer_wheel_remove_min(queue);
 		dc_item->location = ZBX_LOC_NOWHERE;
 
 		if (NULL == (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
@@ -9713,6 +10017,7 @@ int	DCconfig_get_ipmi_poller_items(int now, DC_ITEM *items, int items_num, int *
 
 	*nextcheck = dc_config_get_queue_nextcheck(&config->queues[ZBX_POLLER_TYPE_IPMI]);
 
+	UNLOCK_QUEUE;
 	UNLOCK_CACHE;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, num);
@@ -9784,6 +10089,7 @@ size_t	DCconfig_get_snmp_items_by_interfaceid(zbx_uint64_t interfaceid, DC_ITEM
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() interfaceid:" ZBX_FS_UI64, __func__, interfaceid);
 
 	RDLOCK_CACHE;
+	LOCK_SCHEDULE;
 
 	if (NULL == (dc_interface = (const ZBX_DC_INTERFACE *)zbx_hashset_search(&config->interfaces, &interfaceid)))
 		goto unlock;
@@ -9821,6 +10127,7 @@ size_t	DCconfig_get_snmp_items_by_interfaceid(zbx_uint64_t interfaceid, DC_ITEM
 		items_num++;
 	}
 unlock:
+	UNLOCK_SCHEDULE;
 	UNLOCK_CACHE;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():" ZBX_FS_SIZE_T, __func__, (zbx_fs_size_t)items_num);
@@ -9885,21 +10192,25 @@ static void	dc_requeue_items(const zbx_uint64_t *itemids, const int *lastclocks,
 void	DCrequeue_items(const zbx_uint64_t *itemids, const int *lastclocks,
 		const int *errcodes, size_t num)
 {
-	WRLOCK_CACHE;
+	RDLOCK_CACHE;
+	LOCK_QUEUE;
 
 	dc_requeue_items(itemids, lastclocks, errcodes, num);
 
+	UNLOCK_QUEUE;
 	UNLOCK_CACHE;
 }
 
 void	DCpoller_requeue_items(const zbx_uint64_t *itemids, const int *lastclocks,
 		const int *errcodes, size_t num, unsigned char poller_type, int *nextcheck)
 {
-	WRLOCK_CACHE;
+	RDLOCK_CACHE;
+	LOCK_QUEUE;
 
 	dc_requeue_items(itemids, lastclocks, errcodes, num);
 	*nextcheck = dc_config_get_queue_nextcheck(&config->queues[poller_type]);
 
+	UNLOCK_QUEUE;
 	UNLOCK_CACHE;
 }
 
@@ -9926,7 +10237,8 @@ void	zbx_dc_requeue_unreachable_items(zbx_uint64_t *itemids, size_t itemids_num)
 	ZBX_DC_HOST		*dc_host;
 	ZBX_DC_INTERFACE	*dc_interface;
 
-	WRLOCK_CACHE;
+	RDLOCK_CACHE;
+	LOCK_QUEUE;
 
 	for (i = 0; i < itemids_num; i++)
 	{
@@ -9951,6 +10263,7 @@ void	zbx_dc_requeue_unreachable_items(zbx_uint64_t *itemids, size_t itemids_num)
 				time(NULL));
 	}
 
+	UNLOCK_QUEUE;
 	UNLOCK_CACHE;
 }
 
@@ -9975,7 +10288,7 @@ static void	DCinterface_get_agent_availability(const ZBX_DC_INTERFACE *dc_interf
 	agent->available = dc_interface->available;
 	agent->error = zbx_strdup(agent->error, dc_interface->error);
 	agent->errors_from = dc_interface->errors_from;
-	agent->disable_until = dc_interface->disable_until;
+	agent->disable_until = DC_SCHEDULE_GET(dc_interface->disable_until);
 }
 
 static void	DCagent_set_availability(zbx_agent_availability_t *av,  unsigned char *available, const char **error,
@@ -11350,12 +11663,13 @@ int	DCget_item_queue(zbx_vector_ptr_t *queue, int from, int to)
 {
 	zbx_hashset_iter_t	iter;
 	const ZBX_DC_ITEM	*dc_item;
-	int			now, nitems = 0, data_expected_from, delay;
+	int			now, nitems = 0, data_expected_from, delay, nextcheck;
 	zbx_queue_item_t	*queue_item;
 
 	now = time(NULL);
 
 	RDLOCK_CACHE;
+	LOCK_SCHEDULE;
 
 	zbx_hashset_iter_reset(&config->items, &iter);
 
@@ -11405,7 +11719,9 @@ int	DCget_item_queue(zbx_vector_ptr_t *queue, int from, int to)
 
 		}
 
-		if (now - dc_item->nextcheck < from || (ZBX_QUEUE_TO_INFINITY != to && now - dc_item->nextcheck >= to))
+		nextcheck = DC_SCHEDULE_GET(dc_item->nextcheck);
+
+		if (now - nextcheck < from || (ZBX_QUEUE_TO_INFINITY != to && now - nextcheck >= to))
 			continue;
 
 		if (NULL != queue)
@@ -11413,7 +11729,7 @@ int	DCget_item_queue(zbx_vector_ptr_t *queue, int from, int to)
 			queue_item = (zbx_queue_item_t *)zbx_malloc(NULL, sizeof(zbx_queue_item_t));
 			queue_item->itemid = dc_item->itemid;
 			queue_item->type = dc_item->type;
-			queue_item->nextcheck = dc_item->nextcheck;
+			queue_item->nextcheck = nextcheck;
 			queue_item->proxy_hostid = dc_host->proxy_hostid;
 
 			zbx_vector_ptr_append(queue, queue_item);
@@ -11421,6 +11737,7 @@ int	DCget_item_queue(zbx_vector_ptr_t *queue, int from, int to)
 		nitems++;
 	}
 
+	UNLOCK_SCHEDULE;
 	UNLOCK_CACHE;
 
 	return nitems;
@@ -12386,6 +12703,7 @@ int	DCget_interfaces_availability(zbx_vector_ptr_t *interfaces, int *ts)
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	RDLOCK_CACHE;
+	LOCK_SCHEDULE;
 
 	*ts = time(NULL);
 
@@ -12399,12 +12717,13 @@ int	DCget_interfaces_availability(zbx_vector_ptr_t *interfaces, int *ts)
 			zbx_interface_availability_init(ia, interface->interfaceid);
 
 			zbx_agent_availability_init(&ia->agent, interface->available, interface->error,
-					interface->errors_from, interface->disable_until);
+					interface->errors_from, DC_SCHEDULE_GET(interface->disable_until));
 
 			zbx_vector_ptr_append(interfaces, ia);
 		}
 	}
 
+	UNLOCK_SCHEDULE;
 	UNLOCK_CACHE;
 
 	zbx_vector_ptr_sort(interfaces, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
@@ -13075,6 +13394,193 @@ void	zbx_dc_get_hostids_by_group_name(const char *name, zbx_vector_uint64_t *hos
 	zbx_vector_uint64_uniq(hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_match_item_key                                                *
+ *                                                                            *
+ * Purpose: check if item key matches the pattern                             *
+ *                                                                            *
+ * Parameters: item_key - [IN] the item key to match                          *
+ *             pattern  - [IN] the pattern, '*' parameters match any value    *
+ *                                                                            *
+ * Return value: SUCCEED - the item key matches the pattern                   *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_match_item_key(const char *item_key, const AGENT_REQUEST *pattern)
+{
+	AGENT_REQUEST	key;
+	int		i, ret = FAIL;
+
+	init_request(&key);
+
+	if (SUCCEED != parse_item_key(item_key, &key))
+		goto out;
+
+	if (pattern->nparam != key.nparam)
+		goto out;
+
+	if (0 != strcmp(pattern->key, key.key))
+		goto out;
+
+	for (i = 0; i < key.nparam; i++)
+	{
+		if (0 == strcmp(pattern->params[i], "*"))
+			continue;
+
+		if (0 != strcmp(pattern->params[i], key.params[i]))
+			goto out;
+	}
+
+	ret = SUCCEED;
+out:
+	free_request(&key);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_add_item_candidate                                            *
+ *                                                                            *
+ * Purpose: add item to candidates if it matches the specified hosts and key  *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             hostids   - [IN] the sorted hostids, NULL to match any host    *
+ *             key       - [IN] the item key, NULL to match key by pattern    *
+ *             pattern   - [IN] the item key pattern, NULL to match any key   *
+ *             itemhosts - [OUT] the itemid, hostid pairs of candidates       *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_add_item_candidate(const ZBX_DC_ITEM *item, const zbx_vector_uint64_t *hostids, const char *key,
+		const AGENT_REQUEST *pattern, zbx_vector_uint64_pair_t *itemhosts)
+{
+	zbx_uint64_pair_t	pair;
+
+	if (NULL != hostids && FAIL == zbx_vector_uint64_bsearch(hostids, item->hostid,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+	{
+		return;
+	}
+
+	if (NULL != key)
+	{
+		if (0 != strcmp(item->key, key))
+			return;
+	}
+	else if (NULL != pattern && SUCCEED != dc_match_item_key(item->key, pattern))
+		return;
+
+	pair.first = item->itemid;
+	pair.second = item->hostid;
+	zbx_vector_uint64_pair_append(itemhosts, pair);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dc_get_item_candidates                                       *
+ *                                                                            *
+ * Purpose: gets items matching the specified hosts and key                   *
+ *                                                                            *
+ * Parameters: hostids   - [IN] the sorted hostids, NULL to match any host    *
+ *             key       - [IN] the item key, NULL to match key by pattern    *
+ *             pattern   - [IN] the item key pattern where '*' parameters     *
+ *                              match any value, NULL to match any key if     *
+ *                              item key is not specified either              *
+ *             itemhosts - [OUT] the itemid, hostid pairs of matching items   *
+ *                                                                            *
+ * Comments: Items are searched in key name or host item index, depending on  *
+ *           which one has less items to check. Either hosts or the key       *
+ *           (pattern) must be specified.                                     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_get_item_candidates(const zbx_vector_uint64_t *hostids, const char *key, const AGENT_REQUEST *pattern,
+		zbx_vector_uint64_pair_t *itemhosts)
+{
+	const zbx_vector_ptr_t		*items = NULL;
+	const char			*key_name;
+	zbx_dc_key_item_index_t		*key_index, key_index_local;
+	zbx_dc_host_item_index_t	*host_index;
+	const ZBX_DC_ITEM		*item;
+	int				i, j, host_items_num = 0;
+
+	if (NULL != key)
+		key_name = key;
+	else if (NULL != pattern)
+		key_name = pattern->key;
+	else
+		key_name = NULL;
+
+	if (NULL == key_name && NULL == hostids)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return;
+	}
+
+	RDLOCK_CACHE;
+
+	if (NULL != key_name)
+	{
+		key_index_local.key_name = key_name;
+
+		if (NULL == (key_index = (zbx_dc_key_item_index_t *)zbx_hashset_search(&config->key_items_index,
+				&key_index_local)))
+		{
+			goto out;
+		}
+
+		items = &key_index->items;
+	}
+
+	if (NULL != hostids)
+	{
+		if (NULL != key && hostids->values_num < items->values_num)
+		{
+			for (i = 0; i < hostids->values_num; i++)
+			{
+				if (NULL != (item = DCfind_item(hostids->values[i], key)))
+					dc_add_item_candidate(item, NULL, key, NULL, itemhosts);
+			}
+
+			goto out;
+		}
+
+		for (i = 0; i < hostids->values_num; i++)
+		{
+			if (NULL != (host_index = (zbx_dc_host_item_index_t *)zbx_hashset_search(
+					&config->host_items_index, &hostids->values[i])))
+			{
+				host_items_num += host_index->items.values_num;
+			}
+		}
+
+		if (NULL == items || host_items_num < items->values_num)
+		{
+			for (i = 0; i < hostids->values_num; i++)
+			{
+				if (NULL == (host_index = (zbx_dc_host_item_index_t *)zbx_hashset_search(
+						&config->host_items_index, &hostids->values[i])))
+				{
+					continue;
+				}
+
+				for (j = 0; j < host_index->items.values_num; j++)
+				{
+					dc_add_item_candidate((const ZBX_DC_ITEM *)host_index->items.values[j], NULL, key,
+							pattern, itemhosts);
+				}
+			}
+
+			goto out;
+		}
+	}
+
+	for (i = 0; i < items->values_num; i++)
+		dc_add_item_candidate((const ZBX_DC_ITEM *)items->values[i], hostids, key, pattern, itemhosts);
+out:
+	UNLOCK_CACHE;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_dc_get_active_proxy_by_name                                  *
@@ -13147,6 +13653,7 @@ void	zbx_dc_items_update_nextcheck(DC_ITEM *items, zbx_agent_value_t *values, in
 	ZBX_DC_INTERFACE	*dc_interface;
 
 	RDLOCK_CACHE;
+	LOCK_QUEUE;
 
 	for (i = 0; i < values_num; i++)
 	{
@@ -13179,6 +13686,7 @@ void	zbx_dc_items_update_nextcheck(DC_ITEM *items, zbx_agent_value_t *values, in
 				NULL);
 	}
 
+	UNLOCK_QUEUE;
 	UNLOCK_CACHE;
 }
 
@@ -13502,7 +14010,8 @@ void	zbx_dc_reschedule_items(const zbx_vector_uint64_t *itemids, int nextcheck,
 	ZBX_DC_HOST	*dc_host;
 	zbx_uint64_t	proxy_hostid;
 
-	WRLOCK_CACHE;
+	RDLOCK_CACHE;
+	LOCK_QUEUE;
 
 	for (i = 0; i < itemids->values_num; i++)
 	{
@@ -13532,6 +14041,7 @@ void	zbx_dc_reschedule_items(const zbx_vector_uint64_t *itemids, int nextcheck,
 			proxy_hostids[i] = proxy_hostid;
 	}
 
+	UNLOCK_QUEUE;
 	UNLOCK_CACHE;
 }
 
@@ -14147,6 +14657,7 @@ void	zbx_get_host_interfaces_availability(zbx_uint64_t hostid, zbx_agent_availab
 		zbx_agent_availability_init(&agents[i], INTERFACE_AVAILABLE_UNKNOWN, "", 0, 0);
 
 	RDLOCK_CACHE;
+	LOCK_SCHEDULE;
 
 	zbx_hashset_iter_reset(&config->interfaces, &iter);
 
@@ -14173,6 +14684,7 @@ void	zbx_get_host_interfaces_availability(zbx_uint64_t hostid, zbx_agent_availab
 			DCinterface_get_agent_availability(interface, &agents[i]);
 	}
 
+	UNLOCK_SCHEDULE;
 	UNLOCK_CACHE;
 
 }
@@ -14222,4 +14734,5 @@ int	zbx_dc_maintenance_has_tags(void)
 #ifdef HAVE_TESTS
 #	include "../../../tests/libs/zbxdbcache/dc_item_poller_type_update_test.c"
 #	include "../../../tests/libs/zbxdbcache/dc_function_calculate_nextcheck_test.c"
+#	include "../../../tests/libs/zbxdbcache/dc_item_index_test.c"
 #endif
@@ -99,6 +99,8 @@ typedef struct
 	int			mtime;
 	int			data_expected_from;
 	int			history_sec;
+	int			key_index_pos;	/* position in config->key_items_index vector */
+	int			host_index_pos;	/* position in config->host_items_index vector */
 	unsigned char		history;
 	unsigned char		type;
 	unsigned char		value_type;
@@ -630,6 +632,22 @@ typedef struct
 }
 zbx_dc_host_tag_index_t;
 
+typedef struct
+{
+	const char		*key_name;	/* item key without parameters */
+	zbx_vector_ptr_t	items;
+		/* references to ZBX_DC_ITEM records cached in config->items hashset */
+}
+zbx_dc_key_item_index_t;
+
+typedef struct
+{
+	zbx_uint64_t		hostid;
+	zbx_vector_ptr_t	items;
+		/* references to ZBX_DC_ITEM records cached in config->items hashset */
+}
+zbx_dc_host_item_index_t;
+
 typedef struct
 {
 	const char	*tag;
@@ -802,6 +820,8 @@ typedef struct
 
 	zbx_hashset_t		items;
 	zbx_hashset_t		items_hk;		/* hostid, key */
+	zbx_hashset_t		key_items_index;	/* item index by key name */
+	zbx_hashset_t		host_items_index;	/* item index by hostid */
 	zbx_hashset_t		template_items;		/* template items selected from items table */
 	zbx_hashset_t		prototype_items;	/* item prototypes selected from items table */
 	zbx_hashset_t		numitems;
@@ -867,7 +887,7 @@ typedef struct
 							/* by PSK identity */
 #endif
 	zbx_hashset_t		data_sessions;
-	zbx_binary_heap_t	queues[ZBX_POLLER_TYPE_COUNT];
+	zbx_timer_wheel_t	queues[ZBX_POLLER_TYPE_COUNT];
 	zbx_binary_heap_t	pqueue;
 	zbx_binary_heap_t	trigger_queue;
 	ZBX_DC_CONFIG_TABLE	*config;
@@ -0,0 +1,752 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "log.h"
+#include "mutexs.h"
+#include "memalloc.h"
+#include "db.h"
+#include "dbcache.h"
+
+extern zbx_uint64_t	CONFIG_PROXY_MEMORY_BUFFER_SIZE;
+
+/*
+ * Proxy memory buffer keeps collected history values in shared memory, so data sender can send them to server
+ * without writing them into proxy_history table and reading them back.
+ *
+ * The buffer works in one of two modes:
+ *   1) memory   - history syncers store values in the buffer and data sender reads them from the buffer.
+ *                 This mode is entered only when all values in database have been sent and the buffer is empty.
+ *   2) database - history syncers write values into proxy_history table. This mode is used after startup and
+ *                 when the buffer runs out of memory, for example when server is unreachable. The values left
+ *                 in the buffer are older than the values in database, so they are sent first.
+ *
+ * The buffer records have identifiers starting with ZBX_PB_HISTORY_ID_MIN, so they are not confused with
+ * proxy_history record identifiers. Server discards values with identifiers not greater than the last value
+ * identifier received in the same data session, so database record identifiers are sent with offset, making
+ * them greater than identifiers of the buffer records sent before them and vice versa.
+ */
+
+typedef struct zbx_pb_record
+{
+	zbx_pb_history_t	history;
+	struct zbx_pb_record	*next;
+}
+zbx_pb_record_t;
+
+typedef struct
+{
+	zbx_pb_record_t	*head;
+	zbx_pb_record_t	*tail;
+	int		records_num;
+	int		mode;
+
+	/* the identifier of the next buffer record */
+	zbx_uint64_t	next_id;
+
+	/* the offset added to database record identifiers when sending them to server */
+	zbx_uint64_t	db_offset;
+
+	/* the number of history syncers writing to database and the total number of database writes */
+	int		db_writers;
+	zbx_uint64_t	db_writes;
+
+	/* the database write state when data sender started reading history */
+	int		read_db_idle;
+	zbx_uint64_t	read_db_writes;
+
+	/* the history read by data sender and waiting for server acknowledgment */
+	zbx_uint64_t	pending_lastid;
+	zbx_uint64_t	pending_mem_lastid;
+	zbx_uint64_t	pending_db_lastid;
+	int		pending_db_update;
+	int		pending_db_drained;
+}
+zbx_pb_t;
+
+static zbx_pb_t		*pb = NULL;
+static zbx_mem_info_t	*pb_mem = NULL;
+static zbx_mutex_t	pb_lock = ZBX_MUTEX_NULL;
+
+ZBX_MEM_FUNC1_IMPL_MALLOC(__pb, pb_mem)
+ZBX_MEM_FUNC1_IMPL_FREE(__pb, pb_mem)
+
+#define LOCK_PB		zbx_mutex_lock(pb_lock)
+#define UNLOCK_PB	zbx_mutex_unlock(pb_lock)
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_init                                                      *
+ *                                                                            *
+ * Purpose: initialize proxy memory buffer                                    *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the buffer was initialized successfully or it is   *
+ *                         disabled                                           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_init(char **error)
+{
+	int	ret = FAIL;
+
+	if (0 == CONFIG_PROXY_MEMORY_BUFFER_SIZE)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "%s(): proxy memory buffer disabled", __func__);
+		return SUCCEED;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (SUCCEED != zbx_mutex_create(&pb_lock, ZBX_MUTEX_PROXY_BUFFER, error))
+		goto out;
+
+	if (SUCCEED != zbx_mem_create(&pb_mem, CONFIG_PROXY_MEMORY_BUFFER_SIZE, "proxy memory buffer size",
+			"ProxyMemoryBufferSize", 1, error))
+	{
+		goto out;
+	}
+
+	if (NULL == (pb = (zbx_pb_t *)__pb_mem_malloc_func(NULL, sizeof(zbx_pb_t))))
+	{
+		*error = zbx_strdup(*error, "not enough space for proxy memory buffer header");
+		goto out;
+	}
+
+	memset(pb, 0, sizeof(zbx_pb_t));
+
+	/* there might be unsent values in database left from the previous run */
+	pb->mode = ZBX_PB_MODE_DATABASE;
+	pb->next_id = ZBX_PB_HISTORY_ID_MIN;
+
+	ret = SUCCEED;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s(): %s", __func__, ZBX_NULL2EMPTY_STR(*error));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_destroy                                                   *
+ *                                                                            *
+ * Purpose: destroy proxy memory buffer                                       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pb_destroy(void)
+{
+	if (NULL == pb_mem)
+		return;
+
+	pb = NULL;
+	zbx_mem_destroy(pb_mem);
+	pb_mem = NULL;
+	zbx_mutex_destroy(&pb_lock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_flush                                                     *
+ *                                                                            *
+ * Purpose: write the values left in proxy memory buffer into database, so    *
+ *          they are not lost on shutdown                                     *
+ *                                                                            *
+ * Comments: The database connection must be open. The flushed values are     *
+ *           sent after the unsent values already in database. If the values  *
+ *           cannot be saved they are left in the buffer.                     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pb_flush(void)
+{
+	zbx_db_insert_t	db_insert;
+	zbx_pb_record_t	*record;
+
+	if (NULL == pb)
+		return;
+
+	LOCK_PB;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() records:%d", __func__, pb->records_num);
+
+	if (NULL == pb->head)
+		goto out;
+
+	zbx_db_insert_prepare(&db_insert, "proxy_history", "itemid", "clock", "ns", "timestamp", "source", "severity",
+			"value", "logeventid", "state", "lastlogsize", "mtime", "flags", "write_clock", NULL);
+
+	for (record = pb->head; NULL != record; record = record->next)
+	{
+		const zbx_pb_history_t	*h = &record->history;
+
+		zbx_db_insert_add_values(&db_insert, h->itemid, h->clock, h->ns, h->timestamp, h->source, h->severity,
+				h->value, h->logeventid, (int)h->state, h->lastlogsize, h->mtime, (int)h->flags,
+				h->write_clock);
+	}
+
+	DBbegin();
+	zbx_db_insert_execute(&db_insert);
+
+	if (ZBX_DB_OK != DBcommit())
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot save %d values from proxy memory buffer to database",
+				pb->records_num);
+		goto clean;
+	}
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "saved %d values from proxy memory buffer to database", pb->records_num);
+
+	while (NULL != (record = pb->head))
+	{
+		pb->head = record->next;
+		__pb_mem_free_func(record);
+	}
+
+	pb->tail = NULL;
+	pb->records_num = 0;
+
+	/* the values are in database now, keep database record identifiers greater than the sent buffer records */
+	pb->db_offset = pb->next_id - 1;
+	pb->mode = ZBX_PB_MODE_DATABASE;
+clean:
+	zbx_db_insert_clean(&db_insert);
+out:
+	UNLOCK_PB;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: pb_history_prepare                                               *
+ *                                                                            *
+ * Purpose: prepare buffer record contents from history cache value in the    *
+ *          same way as it would be written into proxy_history table          *
+ *                                                                            *
+ * Parameters: h      - [IN] the history cache value                          *
+ *             ph     - [OUT] the buffer record contents                      *
+ *             buffer - [IN] the buffer for numeric value conversion          *
+ *             size   - [IN] the buffer size                                  *
+ *                                                                            *
+ * Return value: SUCCEED - the value must be stored                           *
+ *               FAIL    - the value must be skipped                          *
+ *                                                                            *
+ * Comments: see DBmass_proxy_add_history() for the database counterpart      *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_history_prepare(const ZBX_DC_HISTORY *h, zbx_pb_history_t *ph, char *buffer, size_t size)
+{
+	memset(ph, 0, sizeof(zbx_pb_history_t));
+
+	ph->itemid = h->itemid;
+	ph->clock = h->ts.sec;
+	ph->ns = h->ts.ns;
+	ph->value = "";
+	ph->source = "";
+
+	if (ITEM_STATE_NOTSUPPORTED == h->state)
+	{
+		ph->state = ITEM_STATE_NOTSUPPORTED;
+		ph->value = ZBX_NULL2EMPTY_STR(h->value.err);
+		return SUCCEED;
+	}
+
+	if (ITEM_VALUE_TYPE_LOG == h->value_type)
+	{
+		const zbx_log_value_t	*log;
+
+		if (0 != (h->flags & ZBX_DC_FLAG_NOVALUE))
+		{
+			ph->flags = PROXY_HISTORY_FLAG_META | PROXY_HISTORY_FLAG_NOVALUE;
+			ph->lastlogsize = h->lastlogsize;
+			ph->mtime = h->mtime;
+			return SUCCEED;
+		}
+
+		log = h->value.log;
+		ph->timestamp = log->timestamp;
+		ph->source = ZBX_NULL2EMPTY_STR(log->source);
+		ph->severity = log->severity;
+		ph->value = log->value;
+		ph->logeventid = log->logeventid;
+
+		if (0 != (h->flags & ZBX_DC_FLAG_META))
+		{
+			ph->flags = PROXY_HISTORY_FLAG_META;
+			ph->lastlogsize = h->lastlogsize;
+			ph->mtime = h->mtime;
+		}
+
+		return SUCCEED;
+	}
+
+	if (0 != (h->flags & ZBX_DC_FLAG_UNDEF))
+		return FAIL;
+
+	if (0 != (h->flags & ZBX_DC_FLAG_META))
+	{
+		ph->flags = PROXY_HISTORY_FLAG_META;
+		ph->lastlogsize = h->lastlogsize;
+		ph->mtime = h->mtime;
+	}
+
+	if (0 != (h->flags & ZBX_DC_FLAG_NOVALUE))
+	{
+		ph->flags |= PROXY_HISTORY_FLAG_NOVALUE;
+		return SUCCEED;
+	}
+
+	switch (h->value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			zbx_snprintf(buffer, size, ZBX_FS_DBL64, h->value.dbl);
+			ph->value = buffer;
+			break;
+		case ITEM_VALUE_TYPE_UINT64:
+			zbx_snprintf(buffer, size, ZBX_FS_UI64, h->value.ui64);
+			ph->value = buffer;
+			break;
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			ph->value = h->value.str;
+			break;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: pb_record_create                                                 *
+ *                                                                            *
+ * Purpose: allocate buffer record with its strings in shared memory          *
+ *                                                                            *
+ * Return value: The created record or NULL if the buffer is out of memory.   *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_pb_record_t	*pb_record_create(const zbx_pb_history_t *ph)
+{
+	zbx_pb_record_t	*record;
+	size_t		value_len, source_len;
+	char		*ptr;
+
+	value_len = strlen(ph->value) + 1;
+	source_len = strlen(ph->source) + 1;
+
+	if (NULL == (record = (zbx_pb_record_t *)__pb_mem_malloc_func(NULL,
+			sizeof(zbx_pb_record_t) + value_len + source_len)))
+	{
+		return NULL;
+	}
+
+	record->history = *ph;
+	record->next = NULL;
+
+	ptr = (char *)(record + 1);
+	memcpy(ptr, ph->value, value_len);
+	record->history.value = ptr;
+
+	ptr += value_len;
+	memcpy(ptr, ph->source, source_len);
+	record->history.source = ptr;
+
+	return record;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: pb_set_memory_mode                                               *
+ *                                                                            *
+ * Purpose: switch buffer to memory mode if database has no unsent values     *
+ *                                                                            *
+ * Parameters: db_lastid - [IN] the last sent proxy_history record identifier *
+ *                                                                            *
+ * Comments: This function must be called with buffer locked.                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_set_memory_mode(zbx_uint64_t db_lastid)
+{
+	if (ZBX_PB_MODE_DATABASE != pb->mode || NULL != pb->head)
+		return;
+
+	/* values written to database after data sender started reading it might be left unsent */
+	if (0 == pb->read_db_idle || pb->read_db_writes != pb->db_writes)
+		return;
+
+	if (pb->next_id <= db_lastid + pb->db_offset)
+		pb->next_id = db_lastid + pb->db_offset + 1;
+
+	pb->mode = ZBX_PB_MODE_MEMORY;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "proxy memory buffer switched to memory mode");
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_add                                               *
+ *                                                                            *
+ * Purpose: store history values in proxy memory buffer                       *
+ *                                                                            *
+ * Parameters: history     - [IN] the history values                          *
+ *             history_num - [IN] the number of history values                *
+ *                                                                            *
+ * Return value: SUCCEED - the values were stored in the buffer               *
+ *               FAIL    - the values must be written into database,          *
+ *                         zbx_pb_history_db_end() must be called afterwards  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_add(const ZBX_DC_HISTORY *history, int history_num)
+{
+	int			i, now, records_num = 0, ret = FAIL;
+	zbx_pb_record_t		*head = NULL, *tail = NULL, *record;
+	zbx_pb_history_t	ph;
+	char			buffer[64];
+
+	if (NULL == pb)
+		return FAIL;
+
+	now = (int)time(NULL);
+
+	LOCK_PB;
+
+	if (ZBX_PB_MODE_MEMORY != pb->mode)
+		goto out;
+
+	for (i = 0; i < history_num; i++)
+	{
+		if (SUCCEED != pb_history_prepare(&history[i], &ph, buffer, sizeof(buffer)))
+			continue;
+
+		ph.write_clock = now;
+
+		if (NULL == (record = pb_record_create(&ph)))
+			break;
+
+		if (NULL == tail)
+			head = record;
+		else
+			tail->next = record;
+
+		tail = record;
+		records_num++;
+	}
+
+	if (i != history_num)
+	{
+		while (NULL != head)
+		{
+			record = head;
+			head = head->next;
+			__pb_mem_free_func(record);
+		}
+
+		/* keep database record identifiers sent after the buffer records greater than them */
+		pb->db_offset = pb->next_id - 1;
+		pb->mode = ZBX_PB_MODE_DATABASE;
+
+		zabbix_log(LOG_LEVEL_WARNING, "proxy memory buffer is full, history will be stored in database");
+		goto out;
+	}
+
+	for (record = head; NULL != record; record = record->next)
+		record->history.id = pb->next_id++;
+
+	if (NULL != head)
+	{
+		if (NULL == pb->tail)
+			pb->head = head;
+		else
+			pb->tail->next = head;
+
+		pb->tail = tail;
+		pb->records_num += records_num;
+	}
+
+	ret = SUCCEED;
+out:
+	if (SUCCEED != ret)
+	{
+		pb->db_writers++;
+		pb->db_writes++;
+	}
+
+	UNLOCK_PB;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_db_end                                            *
+ *                                                                            *
+ * Purpose: notify proxy memory buffer that history syncer has finished       *
+ *          writing values into database                                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pb_history_db_end(void)
+{
+	if (NULL == pb)
+		return;
+
+	LOCK_PB;
+	pb->db_writers--;
+	UNLOCK_PB;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_read_start                                        *
+ *                                                                            *
+ * Purpose: start reading history to be sent to server                        *
+ *                                                                            *
+ * Parameters: db_offset - [OUT] the offset to add to proxy_history record    *
+ *                               identifiers when sending them                *
+ *                                                                            *
+ * Return value: ZBX_PB_MODE_DISABLED - the buffer is disabled, read history  *
+ *                                      from database                         *
+ *               ZBX_PB_MODE_MEMORY   - read history from the buffer          *
+ *               ZBX_PB_MODE_DATABASE - read history from the buffer and then *
+ *                                      from database                         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_read_start(zbx_uint64_t *db_offset)
+{
+	int	mode;
+
+	if (NULL == pb)
+	{
+		*db_offset = 0;
+		return ZBX_PB_MODE_DISABLED;
+	}
+
+	LOCK_PB;
+
+	mode = pb->mode;
+	*db_offset = pb->db_offset;
+
+	pb->read_db_idle = (0 == pb->db_writers);
+	pb->read_db_writes = pb->db_writes;
+
+	UNLOCK_PB;
+
+	return mode;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_get                                               *
+ *                                                                            *
+ * Purpose: read history values from proxy memory buffer                      *
+ *                                                                            *
+ * Parameters: lastid      - [IN] the identifier of the last read record      *
+ *             records_max - [IN] the maximum number of records to read       *
+ *             cb          - [IN] the callback to process a record            *
+ *             cb_data     - [IN] the callback data                           *
+ *                                                                            *
+ * Return value: The number of records read.                                  *
+ *                                                                            *
+ * Comments: The callback is called with buffer locked, so it must only copy  *
+ *           the record data.                                                 *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_get(zbx_uint64_t lastid, int records_max, zbx_pb_history_cb_t cb, void *cb_data)
+{
+	const zbx_pb_record_t	*record;
+	int			records_num = 0;
+
+	if (NULL == pb)
+		return 0;
+
+	LOCK_PB;
+
+	for (record = pb->head; NULL != record && records_num < records_max; record = record->next)
+	{
+		if (record->history.id <= lastid)
+			continue;
+
+		cb(&record->history, cb_data);
+		records_num++;
+	}
+
+	UNLOCK_PB;
+
+	return records_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_read_end                                          *
+ *                                                                            *
+ * Purpose: remember the read history position until server acknowledges it   *
+ *                                                                            *
+ * Parameters: lastid     - [IN] the history position returned to data sender *
+ *             mem_lastid - [IN] the identifier of the last buffer record     *
+ *                               read, 0 if none were read                    *
+ *             db_lastid  - [IN] the identifier of the last proxy_history     *
+ *                               record read                                  *
+ *             db_update  - [IN] 1 if proxy_history records were read,        *
+ *                               0 otherwise                                  *
+ *             db_drained - [IN] 1 if proxy_history has no more records,      *
+ *                               0 otherwise                                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pb_history_read_end(zbx_uint64_t lastid, zbx_uint64_t mem_lastid, zbx_uint64_t db_lastid,
+		int db_update, int db_drained)
+{
+	if (NULL == pb)
+		return;
+
+	LOCK_PB;
+
+	pb->pending_lastid = lastid;
+	pb->pending_mem_lastid = mem_lastid;
+	pb->pending_db_lastid = db_lastid;
+	pb->pending_db_update = db_update;
+	pb->pending_db_drained = db_drained;
+
+	/* nothing to acknowledge, switch mode right away */
+	if (0 == lastid && 0 != db_drained)
+		pb_set_memory_mode(db_lastid);
+
+	UNLOCK_PB;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_set_lastid                                        *
+ *                                                                            *
+ * Purpose: discard the history acknowledged by server                        *
+ *                                                                            *
+ * Parameters: lastid    - [IN] the history position returned to data sender  *
+ *             db_lastid - [OUT] the identifier of the last sent              *
+ *                               proxy_history record to store in database    *
+ *                               or 0 if it has not changed                   *
+ *                                                                            *
+ * Return value: SUCCEED - the position was processed by the buffer           *
+ *               FAIL    - the buffer is disabled                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_set_lastid(zbx_uint64_t lastid, zbx_uint64_t *db_lastid)
+{
+	zbx_pb_record_t	*record;
+
+	if (NULL == pb)
+		return FAIL;
+
+	*db_lastid = 0;
+
+	LOCK_PB;
+
+	if (0 != lastid && lastid == pb->pending_lastid)
+	{
+		while (NULL != (record = pb->head) && record->history.id <= pb->pending_mem_lastid)
+		{
+			if (NULL == (pb->head = record->next))
+				pb->tail = NULL;
+
+			__pb_mem_free_func(record);
+			pb->records_num--;
+		}
+
+		if (0 != pb->pending_db_update)
+			*db_lastid = pb->pending_db_lastid;
+
+		if (0 != pb->pending_db_drained)
+			pb_set_memory_mode(pb->pending_db_lastid);
+
+		pb->pending_lastid = 0;
+	}
+
+	UNLOCK_PB;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_get_write_clock                                   *
+ *                                                                            *
+ * Purpose: get the write time of the oldest unsent value in proxy memory     *
+ *          buffer                                                            *
+ *                                                                            *
+ * Parameters: lastid      - [IN/OUT] the history position returned to data   *
+ *                                    sender, replaced with the last read     *
+ *                                    proxy_history record identifier         *
+ *             write_clock - [OUT] the write time or 0 if there are no more   *
+ *                                 values in the buffer                       *
+ *                                                                            *
+ * Return value: SUCCEED - the buffer was checked                             *
+ *               FAIL    - the buffer is disabled                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_get_write_clock(zbx_uint64_t *lastid, int *write_clock)
+{
+	const zbx_pb_record_t	*record;
+	zbx_uint64_t		mem_lastid = 0;
+
+	if (NULL == pb)
+		return FAIL;
+
+	*write_clock = 0;
+
+	LOCK_PB;
+
+	if (0 != *lastid && *lastid == pb->pending_lastid)
+	{
+		mem_lastid = pb->pending_mem_lastid;
+		*lastid = pb->pending_db_lastid;
+	}
+
+	for (record = pb->head; NULL != record; record = record->next)
+	{
+		if (record->history.id > mem_lastid)
+		{
+			*write_clock = record->history.write_clock;
+			break;
+		}
+	}
+
+	UNLOCK_PB;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_get_count                                         *
+ *                                                                            *
+ * Purpose: get the number of unsent values in proxy memory buffer            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_get_count(void)
+{
+	int	records_num;
+
+	if (NULL == pb)
+		return 0;
+
+	LOCK_PB;
+	records_num = pb->records_num;
+	UNLOCK_PB;
+
+	return records_num;
+}
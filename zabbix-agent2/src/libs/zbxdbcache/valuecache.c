@@ -44,6 +44,12 @@
  * If an item is already being cached the new values are automatically added to the cache
  * after being written into database.
  *
+ * When value cache compression is enabled the data chunks of numeric items are packed
+ * once they are neither the newest (head) nor the oldest (tail) chunk. The timestamps
+ * are packed with delta-of-delta encoding and the values are packed by storing only the
+ * changed bits of XOR with the previous value. Packed chunks are unpacked into process
+ * local buffers when read.
+ *
  * When cache runs out of memory to store new items it enters in low memory mode.
  * In low memory mode cache continues to function as before with few restrictions:
  *   1) items that weren't accessed during the last day are removed from cache.
@@ -76,6 +82,15 @@ static int	vc_state = ZBX_VC_DISABLED;
 /* the value cache size */
 extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
 
+/* the value cache compression, 1 - pack numeric value chunks, 0 - do not pack */
+extern int	CONFIG_VALUE_CACHE_COMPRESSION;
+
+/* the sliding window aggregates, 1 - keep windows for aggregate requests, 0 - always scan values */
+extern int	CONFIG_VALUE_CACHE_AGGREGATES;
+
+/* the value cache snapshot file, NULL - snapshots are disabled */
+extern char	*CONFIG_VALUE_CACHE_FILE;
+
 ZBX_MEM_FUNC_IMPL(__vc, vc_mem)
 
 #define VC_STRPOOL_INIT_SIZE	(1000)
@@ -90,6 +105,12 @@ ZBX_MEM_FUNC_IMPL(__vc, vc_mem)
 
 #define ZBX_VC_ITEM_EXPIRE_PERIOD	SEC_PER_DAY
 
+/* the maximum number of sliding windows per item */
+#define ZBX_VC_ITEM_WINDOWS_MAX		4
+
+/* sliding windows are removed if not accessed during this period */
+#define ZBX_VC_WINDOW_EXPIRE_PERIOD	SEC_PER_HOUR
+
 /* the data chunk used to store data fragment */
 typedef struct zbx_vc_chunk
 {
@@ -108,11 +129,48 @@ typedef struct zbx_vc_chunk
 	/* the number of item value slots in chunk */
 	int			slots_num;
 
-	/* the item value data */
+	/* The size of packed item value data in bytes or 0 if the chunk */
+	/* is not packed. The head chunk is never packed.                */
+	int			packed_size;
+
+	/* the item value data, packed data is stored in place of slots */
 	zbx_history_record_t	slots[1];
 }
 zbx_vc_chunk_t;
 
+/* the size of chunk with the specified number of packed data bytes */
+#define ZBX_VC_PACKED_CHUNK_SIZE(size)	(offsetof(zbx_vc_chunk_t, slots) + (size))
+
+/* the number of chunks a process can have unpacked at the same time */
+#define ZBX_VC_UNPACKED_CHUNKS_NUM	4
+
+/* the process local buffer with unpacked chunk values */
+typedef struct
+{
+	/* the unpacked chunk or NULL if the buffer is not used */
+	const zbx_vc_chunk_t	*chunk;
+
+	/* the unpacked values with the same indexes as in chunk */
+	zbx_history_record_t	*slots;
+
+	/* the number of allocated slots */
+	int			slots_alloc;
+}
+zbx_vc_unpacked_chunk_t;
+
+static zbx_vc_unpacked_chunk_t	vc_unpacked[ZBX_VC_UNPACKED_CHUNKS_NUM];
+static int			vc_unpacked_next;
+
+/* the bit stream used to pack chunk values */
+typedef struct
+{
+	unsigned char	*data;
+
+	/* the number of bits written or read */
+	size_t		bits;
+}
+zbx_vc_bitstream_t;
+
 /* min/max number number of item history values to store in chunk */
 
 #define ZBX_VC_MIN_CHUNK_RECORDS	2
@@ -121,6 +179,60 @@ zbx_vc_chunk_t;
 #define ZBX_VC_MAX_CHUNK_RECORDS	((64 * ZBX_KIBIBYTE - sizeof(zbx_vc_chunk_t)) / \
 		sizeof(zbx_history_record_t) + 1)
 
+/* the monotonic deque of sliding window minimum or maximum candidates, */
+/* the oldest candidate is the current minimum (maximum)                */
+typedef struct
+{
+	zbx_history_record_t	*records;
+
+	/* the index of first (oldest) candidate */
+	int			first;
+
+	/* the number of candidates */
+	int			num;
+
+	/* the number of allocated records */
+	int			alloc;
+}
+zbx_vc_deque_t;
+
+/* the sliding window, aggregating item values newer than the window start */
+typedef struct zbx_vc_window
+{
+	/* the next window of the same item */
+	struct zbx_vc_window	*next;
+
+	/* the window period in seconds */
+	int			seconds;
+
+	/* the maintained aggregates, see ZBX_VC_AGGREGATE_* defines */
+	int			flags;
+
+	/* the last time the window was requested */
+	int			last_accessed;
+
+	/* the window start, values with greater timestamps are aggregated */
+	zbx_timespec_t		start;
+
+	/* the number of aggregated values */
+	int			values_num;
+
+	/* The number of values removed from sums since they were      */
+	/* recalculated. Used to limit floating point error buildup.   */
+	int			expired_num;
+
+	/* the values sum as double, also kept for unsigned values to */
+	/* calculate the average                                      */
+	double			sum_dbl;
+
+	/* the unsigned values sum */
+	zbx_uint64_t		sum_ui64;
+
+	zbx_vc_deque_t		min;
+	zbx_vc_deque_t		max;
+}
+zbx_vc_window_t;
+
 /* the value cache item data */
 typedef struct
 {
@@ -183,6 +295,9 @@ typedef struct
 
 	/* the first (oldest) chunk of item history data              */
 	zbx_vc_chunk_t	*tail;
+
+	/* the sliding windows of numeric items                       */
+	zbx_vc_window_t	*windows;
 }
 zbx_vc_item_t;
 
@@ -212,6 +327,12 @@ typedef struct
 
 	/* the string pool for str, text and log item values */
 	zbx_hashset_t	strpool;
+
+	/* the number of bytes used by packed chunk data */
+	zbx_uint64_t	packed_size;
+
+	/* the number of bytes the packed values would use if they were not packed */
+	zbx_uint64_t	unpacked_size;
 }
 zbx_vc_cache_t;
 
@@ -232,7 +353,8 @@ ZBX_VECTOR_IMPL(vc_itemweight, zbx_vc_item_weight_t)
 typedef enum
 {
 	ZBX_VC_UPDATE_STATS,
-	ZBX_VC_UPDATE_RANGE
+	ZBX_VC_UPDATE_RANGE,
+	ZBX_VC_UPDATE_WINDOW
 }
 zbx_vc_item_update_type_t;
 
@@ -248,6 +370,12 @@ enum
 	ZBX_VC_UPDATE_RANGE_NOW
 };
 
+enum
+{
+	ZBX_VC_UPDATE_WINDOW_SECONDS,
+	ZBX_VC_UPDATE_WINDOW_FLAGS
+};
+
 typedef struct
 {
 	zbx_uint64_t			itemid;
@@ -278,9 +406,115 @@ static void	vc_cache_item_update(zbx_uint64_t itemid, zbx_vc_item_update_type_t
 /* the value cache */
 static zbx_vc_cache_t	*vc_cache = NULL;
 
+/* The value cache is split into stripes by item id. Each stripe has its own shared memory     */
+/* segment, lock, items and string pool, so processes accessing items in different stripes do */
+/* not wait for each other. The vc_cache, vc_mem and vc_lock variables point to the stripe    */
+/* selected with vc_select_stripe() function.                                                 */
+typedef struct
+{
+	zbx_mem_info_t	*mem;
+	zbx_vc_cache_t	*cache;
+	zbx_rwlock_t	lock;
+}
+zbx_vc_stripe_t;
+
+static zbx_vc_stripe_t	vc_stripes[ZBX_RWLOCK_VALUECACHE_NUM];
+static int		vc_stripes_num = 0;
+
+/* the minimum stripe size, smaller caches are split into less stripes */
+#define ZBX_VC_STRIPE_SIZE_MIN	(64 * ZBX_MEBIBYTE)
+
 #define	RDLOCK_CACHE	zbx_rwlock_rdlock(vc_lock);
 #define	WRLOCK_CACHE	zbx_rwlock_wrlock(vc_lock);
-#define	UNLOCK_CACHE	zbx_rwlock_unlock(vc_lock);
+#define	UNLOCK_CACHE	vc_unlock_cache();
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_select_stripe                                                 *
+ *                                                                            *
+ * Purpose: makes the specified stripe current                                *
+ *                                                                            *
+ * Parameters: index - [IN] the stripe index                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_select_stripe(int index)
+{
+	vc_mem = vc_stripes[index].mem;
+	vc_cache = vc_stripes[index].cache;
+	vc_lock = vc_stripes[index].lock;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_get_stripe_index                                              *
+ *                                                                            *
+ * Purpose: gets index of the stripe caching the specified item               *
+ *                                                                            *
+ * Parameters: itemid - [IN] the item id                                      *
+ *                                                                            *
+ * Return value: the stripe index                                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_get_stripe_index(zbx_uint64_t itemid)
+{
+	if (1 >= vc_stripes_num)
+		return 0;
+
+	return (int)(ZBX_DEFAULT_UINT64_HASH_FUNC(&itemid) % (zbx_hash_t)vc_stripes_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_select_item_stripe                                            *
+ *                                                                            *
+ * Purpose: makes the stripe caching the specified item current               *
+ *                                                                            *
+ * Parameters: itemid - [IN] the item id                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_select_item_stripe(zbx_uint64_t itemid)
+{
+	if (1 < vc_stripes_num)
+		vc_select_stripe(vc_get_stripe_index(itemid));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_unpacked_reset                                                *
+ *                                                                            *
+ * Purpose: marks unpacked chunk buffers as unused if they contain values of  *
+ *          the specified chunk or of all chunks                              *
+ *                                                                            *
+ * Parameters: chunk - [IN] the chunk, NULL - all chunks                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_unpacked_reset(const zbx_vc_chunk_t *chunk)
+{
+	int	i;
+
+	for (i = 0; i < ZBX_VC_UNPACKED_CHUNKS_NUM; i++)
+	{
+		if (NULL == chunk || chunk == vc_unpacked[i].chunk)
+			vc_unpacked[i].chunk = NULL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_unlock_cache                                                  *
+ *                                                                            *
+ * Purpose: unlocks the current stripe                                        *
+ *                                                                            *
+ * Comments: Once the lock is released other processes can free the packed    *
+ *           chunks and reuse their memory, so the unpacked chunk buffers     *
+ *           are reset.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_unlock_cache(void)
+{
+	vc_unpacked_reset(NULL);
+	zbx_rwlock_unlock(vc_lock);
+}
 
 /* function prototypes */
 static void	vc_history_record_copy(zbx_history_record_t *dst, const zbx_history_record_t *src, int value_type);
@@ -836,12 +1070,19 @@ static size_t	vc_release_unused_items(const zbx_vc_item_t *source_item)
  ******************************************************************************/
 void	zbx_vc_housekeeping_value_cache(void)
 {
+	int	i;
+
 	if (ZBX_VC_DISABLED == vc_state)
 		return;
 
-	WRLOCK_CACHE;
-	vc_release_unused_items(NULL);
-	UNLOCK_CACHE;
+	for (i = 0; i < vc_stripes_num; i++)
+	{
+		vc_select_stripe(i);
+
+		WRLOCK_CACHE;
+		vc_release_unused_items(NULL);
+		UNLOCK_CACHE;
+	}
 }
 
 /******************************************************************************
@@ -962,7 +1203,7 @@ static void	vc_history_record_copy(zbx_history_record_t *dst, const zbx_history_
  *                                                                            *
  ******************************************************************************/
 static void	vc_history_record_vector_append(zbx_vector_history_record_t *vector, int value_type,
-		zbx_history_record_t *value)
+		const zbx_history_record_t *value)
 {
 	zbx_history_record_t	record;
 
@@ -1429,1523 +1670,3581 @@ static int	vch_item_add_chunk(zbx_vc_item_t *item, int nslots, zbx_vc_chunk_t *i
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_chunk_find_last_value_before                                 *
+ * Function: vc_bits_write                                                    *
  *                                                                            *
- * Purpose: find the index of the last value in chunk with timestamp less or  *
- *          equal to the specified timestamp.                                 *
+ * Purpose: writes the lowest bits of a value to bit stream                   *
  *                                                                            *
- * Parameters:  chunk - [IN] the chunk                                        *
- *              ts    - [IN] the target timestamp                             *
+ * Parameters: bs    - [IN/OUT] the bit stream                                *
+ *             value - [IN] the value                                         *
+ *             bits  - [IN] the number of bits to write (1-64)                *
  *                                                                            *
- * Return value: The index of the last value in chunk with timestamp less or  *
- *               equal to the specified timestamp.                            *
- *               -1 is returned in the case of failure (meaning that all      *
- *               values have timestamps greater than the target timestamp).   *
+ * Comments: The bit stream buffer must be large enough to store the bits.    *
  *                                                                            *
  ******************************************************************************/
-static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const zbx_timespec_t *ts)
+static void	vc_bits_write(zbx_vc_bitstream_t *bs, zbx_uint64_t value, int bits)
 {
-	int	start = chunk->first_value, end = chunk->last_value, middle;
-
-	/* check if the last value timestamp is already greater or equal to the specified timestamp */
-	if (0 >= zbx_timespec_compare(&chunk->slots[end].timestamp, ts))
-		return end;
-
-	/* chunk contains only one value, which did not pass the above check, return failure */
-	if (start == end)
-		return -1;
-
-	/* perform value lookup using binary search */
-	while (start != end)
+	while (0 < bits)
 	{
-		middle = start + (end - start) / 2;
+		int		offset = (int)(bs->bits & 7), n = MIN(8 - offset, bits);
+		unsigned char	byte;
 
-		if (0 < zbx_timespec_compare(&chunk->slots[middle].timestamp, ts))
-		{
-			end = middle;
-			continue;
-		}
+		byte = (unsigned char)((value >> (bits - n)) & ((1u << n) - 1));
 
-		if (0 >= zbx_timespec_compare(&chunk->slots[middle + 1].timestamp, ts))
-		{
-			start = middle;
-			continue;
-		}
+		if (0 == offset)
+			bs->data[bs->bits >> 3] = 0;
 
-		return middle;
+		bs->data[bs->bits >> 3] |= (unsigned char)(byte << (8 - offset - n));
+		bs->bits += n;
+		bits -= n;
 	}
-
-	return -1;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_get_last_value                                          *
- *                                                                            *
- * Purpose: gets the chunk and index of the last value with a timestamp less  *
- *          or equal to the specified timestamp                               *
+ * Function: vc_bits_read                                                     *
  *                                                                            *
- * Parameters:  item          - [IN] the item                                 *
- *              ts            - [IN] the target timestamp                     *
- *                                   (NULL - current time)                    *
- *              pchunk        - [OUT] the chunk containing the target value   *
- *              pindex        - [OUT] the index of the target value           *
+ * Purpose: reads bits from bit stream                                        *
  *                                                                            *
- * Return value: SUCCEED - the last value was found successfully              *
- *               FAIL - all values in cache have timestamps greater than the  *
- *                      target (timeshift) timestamp.                         *
+ * Parameters: bs    - [IN/OUT] the bit stream                                *
+ *             bits  - [IN] the number of bits to read (1-64)                 *
  *                                                                            *
- * Comments: If end_timestamp value is 0, then simply the last item value in  *
- *           cache is returned.                                               *
+ * Return value: the read bits                                                *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_get_last_value(const zbx_vc_item_t *item, const zbx_timespec_t *ts, zbx_vc_chunk_t **pchunk,
-		int *pindex)
+static zbx_uint64_t	vc_bits_read(zbx_vc_bitstream_t *bs, int bits)
 {
-	zbx_vc_chunk_t	*chunk = item->head;
-	int		index;
-
-	if (NULL == chunk)
-		return FAIL;
-
-	index = chunk->last_value;
+	zbx_uint64_t	value = 0;
 
-	if (0 < zbx_timespec_compare(&chunk->slots[index].timestamp, ts))
+	while (0 < bits)
 	{
-		while (0 < zbx_timespec_compare(&chunk->slots[chunk->first_value].timestamp, ts))
-		{
-			chunk = chunk->prev;
-			/* there are no values for requested range, return failure */
-			if (NULL == chunk)
-				return FAIL;
-		}
-		index = vch_chunk_find_last_value_before(chunk, ts);
-	}
+		int	offset = (int)(bs->bits & 7), n = MIN(8 - offset, bits);
 
-	*pchunk = chunk;
-	*pindex = index;
+		value = (value << n) | ((bs->data[bs->bits >> 3] >> (8 - offset - n)) & ((1u << n) - 1));
+		bs->bits += n;
+		bits -= n;
+	}
 
-	return SUCCEED;
+	return value;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_copy_value                                              *
- *                                                                            *
- * Purpose: copies value in the specified item's chunk slot                   *
+ * Function: vc_bits_read_signed                                              *
  *                                                                            *
- * Parameters: chunk        - [IN/OUT] the target chunk                       *
- *             index        - [IN] the target slot                            *
- *             source_value - [IN] the value to copy                          *
+ * Purpose: reads signed value from bit stream                                *
  *                                                                            *
- * Return value: SUCCEED - the value was copied successfully                  *
- *               FAIL    - the value copying failed (not enough space for     *
- *                         string, text or log type data)                     *
+ * Parameters: bs    - [IN/OUT] the bit stream                                *
+ *             bits  - [IN] the number of value bits (1-63)                   *
  *                                                                            *
- * Comments: This function is used to copy data to cache. The contents of     *
- *           str, text and log type values are stored in cache string pool.   *
+ * Return value: the read value                                               *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_copy_value(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, int index,
-		const zbx_history_record_t *source_value)
+static zbx_int64_t	vc_bits_read_signed(zbx_vc_bitstream_t *bs, int bits)
 {
-	zbx_history_record_t	*value;
-	int			ret = FAIL;
+	zbx_uint64_t	value, sign = __UINT64_C(1) << (bits - 1);
 
-	value = &chunk->slots[index];
-
-	switch (item->value_type)
-	{
-		case ITEM_VALUE_TYPE_STR:
-		case ITEM_VALUE_TYPE_TEXT:
-			if (NULL == (value->value.str = vc_item_strdup(item, source_value->value.str)))
-				goto out;
-			break;
-		case ITEM_VALUE_TYPE_LOG:
-			if (NULL == (value->value.log = vc_item_logdup(item, source_value->value.log)))
-				goto out;
-			break;
-		default:
-			value->value = source_value->value;
-	}
-	value->timestamp = source_value->timestamp;
+	value = vc_bits_read(bs, bits);
 
-	ret = SUCCEED;
-out:
-	return ret;
+	/* extend the sign bit */
+	return (zbx_int64_t)((value ^ sign) - sign);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_copy_values_at_tail                                     *
+ * Function: vc_leading_zeros                                                 *
  *                                                                            *
- * Purpose: copies values at the beginning of item tail chunk                 *
+ * Purpose: counts leading zero bits of a non zero value                      *
  *                                                                            *
- * Parameters: item       - [IN/OUT] the target item                          *
- *             values     - [IN] the values to copy                           *
- *             values_num - [IN] the number of values to copy                 *
+ ******************************************************************************/
+static int	vc_leading_zeros(zbx_uint64_t value)
+{
+	int	n = 0;
+
+	while (0 == (value & (__UINT64_C(1) << 63)))
+	{
+		value <<= 1;
+		n++;
+	}
+
+	return n;
+}
+
+/******************************************************************************
  *                                                                            *
- * Return value: SUCCEED - the values were copied successfully                *
- *               FAIL    - the value copying failed (not enough space for     *
- *                         string, text or log type data)                     *
+ * Function: vc_trailing_zeros                                                *
  *                                                                            *
- * Comments: This function is used to copy data to cache. The contents of     *
- *           str, text and log type values are stored in cache string pool.   *
+ * Purpose: counts trailing zero bits of a non zero value                     *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_copy_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+static int	vc_trailing_zeros(zbx_uint64_t value)
 {
-	int	i, ret = FAIL, first_value = item->tail->first_value;
+	int	n = 0;
 
-	switch (item->value_type)
+	while (0 == (value & 1))
 	{
-		case ITEM_VALUE_TYPE_STR:
-		case ITEM_VALUE_TYPE_TEXT:
-			for (i = values_num - 1; i >= 0; i--)
-			{
-				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
+		value >>= 1;
+		n++;
+	}
 
-				if (NULL == (value->value.str = vc_item_strdup(item, values[i].value.str)))
-					goto out;
+	return n;
+}
 
-				value->timestamp = values[i].timestamp;
-				item->tail->first_value--;
-			}
-			ret = SUCCEED;
+/* the number of bits used to store the number of packed values */
+#define ZBX_VC_PACKED_NUM_BITS		16
 
-			break;
-		case ITEM_VALUE_TYPE_LOG:
-			for (i = values_num - 1; i >= 0; i--)
-			{
-				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
+/* the number of bits used to store timestamp nanoseconds */
+#define ZBX_VC_PACKED_NS_BITS		30
 
-				if (NULL == (value->value.log = vc_item_logdup(item, values[i].value.log)))
-					goto out;
-
-				value->timestamp = values[i].timestamp;
-				item->tail->first_value--;
-			}
-			ret = SUCCEED;
-
-			break;
-		default:
-			memcpy(&item->tail->slots[item->tail->first_value - values_num], values,
-					values_num * sizeof(zbx_history_record_t));
-			item->tail->first_value -= values_num;
-			ret = SUCCEED;
-	}
-out:
-	item->values_total += first_value - item->tail->first_value;
-
-	return ret;
-}
+/* the maximum number of bytes used by one packed value */
+#define ZBX_VC_PACKED_VALUE_SIZE_MAX	22
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_free_chunk                                              *
+ * Function: vc_pack_sec_delta                                                *
  *                                                                            *
- * Purpose: frees chunk and all resources allocated to store its values       *
+ * Purpose: packs difference between the current and previous timestamp       *
+ *          second deltas                                                     *
  *                                                                            *
- * Parameters: item    - [IN] the chunk owner item                            *
- *             chunk   - [IN] the chunk to free                               *
+ * Parameters: bs    - [IN/OUT] the bit stream                                *
+ *             delta - [IN] the delta-of-delta value                          *
  *                                                                            *
- * Return value: the number of bytes freed                                    *
+ * Comments: Regular item values have zero delta-of-delta which is packed     *
+ *           into a single bit, other values use 9-68 bits depending on the   *
+ *           value range.                                                     *
  *                                                                            *
  ******************************************************************************/
-static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+static void	vc_pack_sec_delta(zbx_vc_bitstream_t *bs, zbx_int64_t delta)
 {
-	size_t	freed;
-
-	freed = sizeof(zbx_vc_chunk_t) + (chunk->slots_num - 1) * sizeof(zbx_history_record_t);
-	freed += vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->last_value);
-
-	__vc_mem_free_func(chunk);
-
-	return freed;
+	if (0 == delta)
+	{
+		vc_bits_write(bs, 0, 1);
+	}
+	else if (-64 <= delta && delta < 64)
+	{
+		vc_bits_write(bs, 2, 2);
+		vc_bits_write(bs, (zbx_uint64_t)delta, 7);
+	}
+	else if (-256 <= delta && delta < 256)
+	{
+		vc_bits_write(bs, 6, 3);
+		vc_bits_write(bs, (zbx_uint64_t)delta, 9);
+	}
+	else if (-2048 <= delta && delta < 2048)
+	{
+		vc_bits_write(bs, 14, 4);
+		vc_bits_write(bs, (zbx_uint64_t)delta, 12);
+	}
+	else
+	{
+		vc_bits_write(bs, 15, 4);
+		vc_bits_write(bs, (zbx_uint64_t)delta, 64);
+	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_remove_chunk                                            *
+ * Function: vc_unpack_sec_delta                                              *
  *                                                                            *
- * Purpose: removes item history data chunk                                   *
+ * Purpose: unpacks difference between the current and previous               *
+ *          timestamp second deltas                                           *
  *                                                                            *
- * Parameters: item    - [IN ] the chunk owner item                           *
- *             chunk   - [IN] the chunk to remove                             *
+ * Parameters: bs - [IN/OUT] the bit stream                                   *
+ *                                                                            *
+ * Return value: the delta-of-delta value                                     *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_remove_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+static zbx_int64_t	vc_unpack_sec_delta(zbx_vc_bitstream_t *bs)
 {
-	if (NULL != chunk->next)
-		chunk->next->prev = chunk->prev;
+	if (0 == vc_bits_read(bs, 1))
+		return 0;
 
-	if (NULL != chunk->prev)
-		chunk->prev->next = chunk->next;
+	if (0 == vc_bits_read(bs, 1))
+		return vc_bits_read_signed(bs, 7);
 
-	if (chunk == item->head)
-		item->head = chunk->prev;
+	if (0 == vc_bits_read(bs, 1))
+		return vc_bits_read_signed(bs, 9);
 
-	if (chunk == item->tail)
-		item->tail = chunk->next;
+	if (0 == vc_bits_read(bs, 1))
+		return vc_bits_read_signed(bs, 12);
 
-	vch_item_free_chunk(item, chunk);
+	return (zbx_int64_t)vc_bits_read(bs, 64);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_clean_cache                                             *
+ * Function: vch_chunk_pack_values                                            *
  *                                                                            *
- * Purpose: removes item history data that are outside (older) the maximum    *
- *          request range                                                     *
+ * Purpose: packs numeric chunk values                                        *
  *                                                                            *
- * Parameters:  item   - [IN] the target item                                 *
+ * Parameters: chunk - [IN] the chunk                                         *
+ *             bs    - [IN/OUT] the bit stream, must have space for           *
+ *                              ZBX_VC_PACKED_VALUE_SIZE_MAX bytes per value  *
+ *                                                                            *
+ * Comments: The timestamp seconds are packed with delta-of-delta encoding,   *
+ *           nanoseconds are packed as a single bit if they match the         *
+ *           previous value nanoseconds. The values are packed by XOR with    *
+ *           the previous value, storing only the meaningful XOR bits - a     *
+ *           single bit for the same values or the bits between the leading   *
+ *           and trailing zeros. Floating point and unsigned values are       *
+ *           packed the same way by using their bit representation.           *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_clean_cache(zbx_vc_item_t *item)
+static void	vch_chunk_pack_values(const zbx_vc_chunk_t *chunk, zbx_vc_bitstream_t *bs)
 {
-	zbx_vc_chunk_t	*next;
+	const zbx_history_record_t	*prev, *record;
+	zbx_uint64_t			xor;
+	int				i, delta, prev_delta = 0, leading = -1, trailing = 0, lz, tz;
 
-	if (0 != item->active_range)
+	prev = &chunk->slots[chunk->first_value];
+
+	vc_bits_write(bs, (zbx_uint64_t)(chunk->last_value - chunk->first_value + 1), ZBX_VC_PACKED_NUM_BITS);
+	vc_bits_write(bs, (zbx_uint64_t)prev->timestamp.sec, 32);
+	vc_bits_write(bs, (zbx_uint64_t)prev->timestamp.ns, ZBX_VC_PACKED_NS_BITS);
+	vc_bits_write(bs, prev->value.ui64, 64);
+
+	for (i = chunk->first_value + 1; i <= chunk->last_value; i++, prev = record)
 	{
-		zbx_vc_chunk_t	*tail = item->tail;
-		zbx_vc_chunk_t	*chunk = tail;
-		int		timestamp;
+		record = &chunk->slots[i];
 
-		timestamp = time(NULL) - item->active_range;
+		delta = record->timestamp.sec - prev->timestamp.sec;
+		vc_pack_sec_delta(bs, (zbx_int64_t)delta - prev_delta);
+		prev_delta = delta;
 
-		/* try to remove chunks with all history values older than maximum request range */
-		while (NULL != chunk && chunk->slots[chunk->last_value].timestamp.sec < timestamp &&
-				chunk->slots[chunk->last_value].timestamp.sec !=
-						item->head->slots[item->head->last_value].timestamp.sec)
+		if (record->timestamp.ns == prev->timestamp.ns)
 		{
-			/* don't remove the head chunk */
-			if (NULL == (next = chunk->next))
-				break;
-
-			/* Values with the same timestamps (seconds resolution) always should be either   */
-			/* kept in cache or removed together. There should not be a case when one of them */
-			/* is in cache and the second is dropped.                                         */
-			/* Here we are handling rare case, when the last value of first chunk has the     */
-			/* same timestamp (seconds resolution) as the first value in the second chunk.    */
-			/* In this case increase the first value index of the next chunk until the first  */
-			/* value timestamp is greater.                                                    */
+			vc_bits_write(bs, 0, 1);
+		}
+		else
+		{
+			vc_bits_write(bs, 1, 1);
+			vc_bits_write(bs, (zbx_uint64_t)record->timestamp.ns, ZBX_VC_PACKED_NS_BITS);
+		}
 
-			if (next->slots[next->first_value].timestamp.sec != next->slots[next->last_value].timestamp.sec)
-			{
-				while (next->slots[next->first_value].timestamp.sec ==
-						chunk->slots[chunk->last_value].timestamp.sec)
-				{
-					vc_item_free_values(item, next->slots, next->first_value, next->first_value);
-					next->first_value++;
-				}
-			}
+		if (0 == (xor = record->value.ui64 ^ prev->value.ui64))
+		{
+			vc_bits_write(bs, 0, 1);
+			continue;
+		}
 
-			/* set the database cached from timestamp to the last (oldest) removed value timestamp + 1 */
-			item->db_cached_from = chunk->slots[chunk->last_value].timestamp.sec + 1;
+		if (31 < (lz = vc_leading_zeros(xor)))
+			lz = 31;
 
-			vch_item_remove_chunk(item, chunk);
+		tz = vc_trailing_zeros(xor);
 
-			chunk = next;
+		/* reuse the previous meaningful bit range if the XOR bits fit in it */
+		if (-1 != leading && lz >= leading && tz >= trailing)
+		{
+			vc_bits_write(bs, 2, 2);
+			vc_bits_write(bs, xor >> trailing, 64 - leading - trailing);
+			continue;
 		}
 
-		/* reset the status flags if data was removed from cache */
-		if (tail != item->tail)
-			item->status = 0;
+		vc_bits_write(bs, 3, 2);
+		vc_bits_write(bs, (zbx_uint64_t)lz, 5);
+		vc_bits_write(bs, (zbx_uint64_t)(64 - lz - tz - 1), 6);
+		vc_bits_write(bs, xor >> tz, 64 - lz - tz);
+
+		leading = lz;
+		trailing = tz;
 	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_remove_values                                           *
+ * Function: vch_chunk_unpack_values                                          *
  *                                                                            *
- * Purpose: removes item history data that are older than the specified       *
- *          timestamp                                                         *
+ * Purpose: unpacks packed chunk values                                       *
  *                                                                            *
- * Parameters:  item      - [IN] the target item                              *
- *              timestamp - [IN] the timestamp (number of seconds since the   *
- *                               Epoch)                                       *
+ * Parameters: chunk - [IN] the packed chunk                                  *
+ *             slots - [OUT] the unpacked values, stored with the same        *
+ *                           indexes as the values had in chunk               *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_remove_values(zbx_vc_item_t *item, int timestamp)
+static void	vch_chunk_unpack_values(const zbx_vc_chunk_t *chunk, zbx_history_record_t *slots)
 {
-	zbx_vc_chunk_t	*chunk = item->tail;
+	zbx_vc_bitstream_t	bs = {(unsigned char *)chunk->slots, 0};
+	zbx_history_record_t	*prev, *record;
+	int			i, values_num, delta = 0, leading = 0, trailing = 0;
 
-	if (ZBX_ITEM_STATUS_CACHED_ALL == item->status)
-		item->status = 0;
+	values_num = (int)vc_bits_read(&bs, ZBX_VC_PACKED_NUM_BITS);
 
-	/* try to remove chunks with all history values older than the timestamp */
-	while (NULL != chunk && chunk->slots[chunk->first_value].timestamp.sec < timestamp)
+	prev = &slots[chunk->last_value - values_num + 1];
+	prev->timestamp.sec = (int)vc_bits_read(&bs, 32);
+	prev->timestamp.ns = (int)vc_bits_read(&bs, ZBX_VC_PACKED_NS_BITS);
+	prev->value.ui64 = vc_bits_read(&bs, 64);
+
+	for (i = 1; i < values_num; i++, prev = record)
 	{
-		zbx_vc_chunk_t	*next;
+		record = prev + 1;
 
-		/* If chunk contains values with timestamp greater or equal - remove */
-		/* only the values with less timestamp. Otherwise remove the while   */
-		/* chunk and check next one.                                         */
-		if (chunk->slots[chunk->last_value].timestamp.sec >= timestamp)
+		delta += (int)vc_unpack_sec_delta(&bs);
+		record->timestamp.sec = prev->timestamp.sec + delta;
+
+		if (0 == vc_bits_read(&bs, 1))
+			record->timestamp.ns = prev->timestamp.ns;
+		else
+			record->timestamp.ns = (int)vc_bits_read(&bs, ZBX_VC_PACKED_NS_BITS);
+
+		if (0 == vc_bits_read(&bs, 1))
 		{
-			while (chunk->slots[chunk->first_value].timestamp.sec < timestamp)
-			{
-				vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->first_value);
-				chunk->first_value++;
-			}
+			record->value.ui64 = prev->value.ui64;
+			continue;
+		}
 
-			break;
+		if (1 == vc_bits_read(&bs, 1))
+		{
+			leading = (int)vc_bits_read(&bs, 5);
+			trailing = 64 - leading - (int)vc_bits_read(&bs, 6) - 1;
 		}
 
-		next = chunk->next;
-		vch_item_remove_chunk(item, chunk);
-		chunk = next;
+		record->value.ui64 = prev->value.ui64 ^ (vc_bits_read(&bs, 64 - leading - trailing) << trailing);
 	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_add_value_at_head                                       *
+ * Function: vch_chunk_get_slots                                              *
  *                                                                            *
- * Purpose: adds one item history value at the end of current item's history  *
- *          data                                                              *
+ * Purpose: gets chunk values for reading                                     *
  *                                                                            *
- * Parameters:  item   - [IN] the item to add history data to                 *
- *              value  - [IN] the item history data value                     *
+ * Parameters: chunk - [IN] the chunk                                         *
  *                                                                            *
- * Return value: SUCCEED - the history data value was added successfully      *
- *               FAIL - failed to add history data value (not enough memory)  *
+ * Return value: the chunk value slots                                        *
  *                                                                            *
- * Comments: In the case of failure the item will be removed from cache       *
- *           later.                                                           *
+ * Comments: Packed chunks are unpacked into process local buffers, which are *
+ *           valid until the cache is unlocked or other chunks are unpacked.  *
+ *           The last ZBX_VC_UNPACKED_CHUNKS_NUM unpacked chunks are kept, so *
+ *           values of neighbouring chunks can be accessed at the same time.  *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_record_t *value)
+static const zbx_history_record_t	*vch_chunk_get_slots(const zbx_vc_chunk_t *chunk)
 {
-	int		ret = FAIL, index, sindex, nslots = 0;
-	zbx_vc_chunk_t	*chunk, *schunk;
+	zbx_vc_unpacked_chunk_t	*unpacked;
+	int			i;
 
-	if (NULL != item->head &&
-			0 < zbx_history_record_compare_asc_func(&item->head->slots[item->head->last_value], value))
+	if (0 == chunk->packed_size)
+		return chunk->slots;
+
+	for (i = 0; i < ZBX_VC_UNPACKED_CHUNKS_NUM; i++)
 	{
-		if (0 < zbx_history_record_compare_asc_func(&item->tail->slots[item->tail->first_value], value))
-		{
-			/* If the added value has the same or older timestamp as the first value in cache */
-			/* we can't add it to keep cache consistency. Additionally we must make sure no   */
-			/* values with matching timestamp seconds are kept in cache.                      */
-			vch_item_remove_values(item, value->timestamp.sec + 1);
+		if (chunk == vc_unpacked[i].chunk)
+			return vc_unpacked[i].slots;
+	}
 
-			/* empty items must be removed to avoid situation when a new value is added to cache */
-			/* while other values with matching timestamp seconds are not cached                 */
-			if (NULL == item->head)
-				goto out;
+	unpacked = &vc_unpacked[vc_unpacked_next];
+	vc_unpacked_next = (vc_unpacked_next + 1) % ZBX_VC_UNPACKED_CHUNKS_NUM;
 
-			/* if the value is newer than the database cached from timestamp we must */
-			/* adjust the cached from timestamp to exclude this value                */
-			if (item->db_cached_from <= value->timestamp.sec)
-				item->db_cached_from = value->timestamp.sec + 1;
+	if (unpacked->slots_alloc < chunk->slots_num)
+	{
+		unpacked->slots_alloc = chunk->slots_num;
+		unpacked->slots = (zbx_history_record_t *)zbx_realloc(unpacked->slots,
+				sizeof(zbx_history_record_t) * unpacked->slots_alloc);
+	}
 
-			ret = SUCCEED;
-			goto out;
-		}
+	vch_chunk_unpack_values(chunk, unpacked->slots);
+	unpacked->chunk = chunk;
 
-		sindex = item->head->last_value;
-		schunk = item->head;
+	return unpacked->slots;
+}
 
-		if (0 == item->head->slots_num - item->head->last_value - 1)
-		{
-			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
-				goto out;
-		}
-		else
-			item->head->last_value++;
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_replace_chunk                                           *
+ *                                                                            *
+ * Purpose: replaces chunk in item chunk list                                 *
+ *                                                                            *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             chunk - [IN] the chunk to replace                              *
+ *             copy  - [IN] the chunk copy with the same list links           *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_replace_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, zbx_vc_chunk_t *copy)
+{
+	if (NULL != copy->prev)
+		copy->prev->next = copy;
 
-		item->values_total++;
+	if (NULL != copy->next)
+		copy->next->prev = copy;
 
-		chunk = item->head;
-		index = item->head->last_value;
+	if (item->tail == chunk)
+		item->tail = copy;
 
-		do
-		{
-			chunk->slots[index] = schunk->slots[sindex];
+	if (item->head == chunk)
+		item->head = copy;
+}
 
-			chunk = schunk;
-			index = sindex;
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_pack_chunk                                              *
+ *                                                                            *
+ * Purpose: packs values of a sealed numeric item chunk                       *
+ *                                                                            *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             chunk - [IN] the chunk to pack                                 *
+ *                                                                            *
+ * Comments: A chunk is sealed when new values can be added neither at its    *
+ *           end (not the head chunk) nor at its beginning (not the tail      *
+ *           chunk). Packing is optional, so the chunk is left unpacked if    *
+ *           compression is disabled, there is not enough free memory to      *
+ *           allocate the packed chunk or packing does not reduce its size.   *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_pack_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+{
+	static unsigned char	*data;
+	static size_t		data_alloc;
 
-			if (--sindex < schunk->first_value)
-			{
-				if (NULL == (schunk = schunk->prev))
-				{
-					memset(&chunk->slots[index], 0, sizeof(zbx_vc_chunk_t));
-					THIS_SHOULD_NEVER_HAPPEN;
+	zbx_vc_bitstream_t	bs;
+	zbx_vc_chunk_t		*packed;
+	size_t			size, chunk_size;
 
-					goto out;
-				}
+	if (0 == CONFIG_VALUE_CACHE_COMPRESSION || 0 != chunk->packed_size)
+		return;
 
-				sindex = schunk->last_value;
-			}
-		}
-		while (0 < zbx_timespec_compare(&schunk->slots[sindex].timestamp, &value->timestamp));
-	}
-	else
-	{
-		/* find the number of free slots on the right side in last (head) chunk */
-		if (NULL != item->head)
-			nslots = item->head->slots_num - item->head->last_value - 1;
+	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
+		return;
 
-		if (0 == nslots)
-		{
-			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
-				goto out;
-		}
-		else
-			item->head->last_value++;
+	if (chunk == item->head || chunk == item->tail)
+		return;
 
-		item->values_total++;
+	size = (size_t)(chunk->last_value - chunk->first_value + 1) * ZBX_VC_PACKED_VALUE_SIZE_MAX;
 
-		chunk = item->head;
-		index = item->head->last_value;
+	if (data_alloc < size)
+	{
+		data_alloc = size;
+		data = (unsigned char *)zbx_realloc(data, data_alloc);
 	}
 
-	if (SUCCEED != vch_item_copy_value(item, chunk, index, value))
-		goto out;
+	bs.data = data;
+	bs.bits = 0;
+	vch_chunk_pack_values(chunk, &bs);
 
-	ret = SUCCEED;
-out:
-	return ret;
+	size = (bs.bits + 7) / 8;
+	chunk_size = sizeof(zbx_vc_chunk_t) + (chunk->slots_num - 1) * sizeof(zbx_history_record_t);
+
+	if (ZBX_VC_PACKED_CHUNK_SIZE(size) >= chunk_size)
+		return;
+
+	/* don't free space in cache for packed chunk, it would only shrink the cache */
+	if (NULL == (packed = (zbx_vc_chunk_t *)__vc_mem_malloc_func(NULL, ZBX_VC_PACKED_CHUNK_SIZE(size))))
+		return;
+
+	memcpy(packed, chunk, offsetof(zbx_vc_chunk_t, slots));
+	packed->packed_size = (int)size;
+	memcpy(packed->slots, data, size);
+
+	vch_item_replace_chunk(item, chunk, packed);
+
+	vc_cache->packed_size += ZBX_VC_PACKED_CHUNK_SIZE(size);
+	vc_cache->unpacked_size += chunk_size;
+
+	__vc_mem_free_func(chunk);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_add_values_at_tail                                      *
+ * Function: vch_item_unpack_chunk                                            *
  *                                                                            *
- * Purpose: adds item history values at the beginning of current item's       *
- *          history data                                                      *
+ * Purpose: replaces packed chunk with unpacked chunk, so values can be       *
+ *          modified                                                          *
  *                                                                            *
- * Parameters:  item   - [IN] the item to add history data to                 *
- *              values - [IN] the item history data values                    *
- *              num    - [IN] the number of history data values to add        *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             chunk - [IN] the packed chunk                                  *
+ *                                                                            *
+ * Return value: the unpacked chunk or NULL if there was not enough memory    *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_vc_chunk_t	*vch_item_unpack_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+{
+	zbx_vc_chunk_t	*unpacked;
+	size_t		chunk_size;
+
+	chunk_size = sizeof(zbx_vc_chunk_t) + (chunk->slots_num - 1) * sizeof(zbx_history_record_t);
+
+	if (NULL == (unpacked = (zbx_vc_chunk_t *)vc_item_malloc(item, chunk_size)))
+		return NULL;
+
+	memcpy(unpacked, chunk, offsetof(zbx_vc_chunk_t, slots));
+	unpacked->packed_size = 0;
+	vch_chunk_unpack_values(chunk, unpacked->slots);
+
+	vch_item_replace_chunk(item, chunk, unpacked);
+
+	vc_cache->packed_size -= ZBX_VC_PACKED_CHUNK_SIZE(chunk->packed_size);
+	vc_cache->unpacked_size -= chunk_size;
+
+	vc_unpacked_reset(chunk);
+	__vc_mem_free_func(chunk);
+
+	return unpacked;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_chunk_find_last_value_before                                 *
+ *                                                                            *
+ * Purpose: find the index of the last value in chunk with timestamp less or  *
+ *          equal to the specified timestamp.                                 *
+ *                                                                            *
+ * Parameters:  chunk - [IN] the chunk                                        *
+ *              ts    - [IN] the target timestamp                             *
+ *                                                                            *
+ * Return value: The index of the last value in chunk with timestamp less or  *
+ *               equal to the specified timestamp.                            *
+ *               -1 is returned in the case of failure (meaning that all      *
+ *               values have timestamps greater than the target timestamp).   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const zbx_timespec_t *ts)
+{
+	const zbx_history_record_t	*slots;
+	int				start = chunk->first_value, end = chunk->last_value, middle;
+
+	slots = vch_chunk_get_slots(chunk);
+
+	/* check if the last value timestamp is already greater or equal to the specified timestamp */
+	if (0 >= zbx_timespec_compare(&slots[end].timestamp, ts))
+		return end;
+
+	/* chunk contains only one value, which did not pass the above check, return failure */
+	if (start == end)
+		return -1;
+
+	/* perform value lookup using binary search */
+	while (start != end)
+	{
+		middle = start + (end - start) / 2;
+
+		if (0 < zbx_timespec_compare(&slots[middle].timestamp, ts))
+		{
+			end = middle;
+			continue;
+		}
+
+		if (0 >= zbx_timespec_compare(&slots[middle + 1].timestamp, ts))
+		{
+			start = middle;
+			continue;
+		}
+
+		return middle;
+	}
+
+	return -1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_last_value                                          *
+ *                                                                            *
+ * Purpose: gets the chunk and index of the last value with a timestamp less  *
+ *          or equal to the specified timestamp                               *
+ *                                                                            *
+ * Parameters:  item          - [IN] the item                                 *
+ *              ts            - [IN] the target timestamp                     *
+ *                                   (NULL - current time)                    *
+ *              pchunk        - [OUT] the chunk containing the target value   *
+ *              pindex        - [OUT] the index of the target value           *
+ *                                                                            *
+ * Return value: SUCCEED - the last value was found successfully              *
+ *               FAIL - all values in cache have timestamps greater than the  *
+ *                      target (timeshift) timestamp.                         *
+ *                                                                            *
+ * Comments: If end_timestamp value is 0, then simply the last item value in  *
+ *           cache is returned.                                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_last_value(const zbx_vc_item_t *item, const zbx_timespec_t *ts, zbx_vc_chunk_t **pchunk,
+		int *pindex)
+{
+	zbx_vc_chunk_t	*chunk = item->head;
+	int		index;
+
+	if (NULL == chunk)
+		return FAIL;
+
+	index = chunk->last_value;
+
+	if (0 < zbx_timespec_compare(&chunk->slots[index].timestamp, ts))
+	{
+		while (0 < zbx_timespec_compare(&vch_chunk_get_slots(chunk)[chunk->first_value].timestamp, ts))
+		{
+			chunk = chunk->prev;
+			/* there are no values for requested range, return failure */
+			if (NULL == chunk)
+				return FAIL;
+		}
+		index = vch_chunk_find_last_value_before(chunk, ts);
+	}
+
+	*pchunk = chunk;
+	*pindex = index;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_copy_value                                              *
+ *                                                                            *
+ * Purpose: copies value in the specified item's chunk slot                   *
+ *                                                                            *
+ * Parameters: chunk        - [IN/OUT] the target chunk                       *
+ *             index        - [IN] the target slot                            *
+ *             source_value - [IN] the value to copy                          *
+ *                                                                            *
+ * Return value: SUCCEED - the value was copied successfully                  *
+ *               FAIL    - the value copying failed (not enough space for     *
+ *                         string, text or log type data)                     *
+ *                                                                            *
+ * Comments: This function is used to copy data to cache. The contents of     *
+ *           str, text and log type values are stored in cache string pool.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_copy_value(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, int index,
+		const zbx_history_record_t *source_value)
+{
+	zbx_history_record_t	*value;
+	int			ret = FAIL;
+
+	value = &chunk->slots[index];
+
+	switch (item->value_type)
+	{
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			if (NULL == (value->value.str = vc_item_strdup(item, source_value->value.str)))
+				goto out;
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			if (NULL == (value->value.log = vc_item_logdup(item, source_value->value.log)))
+				goto out;
+			break;
+		default:
+			value->value = source_value->value;
+	}
+	value->timestamp = source_value->timestamp;
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_copy_values_at_tail                                     *
+ *                                                                            *
+ * Purpose: copies values at the beginning of item tail chunk                 *
+ *                                                                            *
+ * Parameters: item       - [IN/OUT] the target item                          *
+ *             values     - [IN] the values to copy                           *
+ *             values_num - [IN] the number of values to copy                 *
+ *                                                                            *
+ * Return value: SUCCEED - the values were copied successfully                *
+ *               FAIL    - the value copying failed (not enough space for     *
+ *                         string, text or log type data)                     *
+ *                                                                            *
+ * Comments: This function is used to copy data to cache. The contents of     *
+ *           str, text and log type values are stored in cache string pool.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_copy_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+{
+	int	i, ret = FAIL, first_value = item->tail->first_value;
+
+	switch (item->value_type)
+	{
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			for (i = values_num - 1; i >= 0; i--)
+			{
+				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
+
+				if (NULL == (value->value.str = vc_item_strdup(item, values[i].value.str)))
+					goto out;
+
+				value->timestamp = values[i].timestamp;
+				item->tail->first_value--;
+			}
+			ret = SUCCEED;
+
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			for (i = values_num - 1; i >= 0; i--)
+			{
+				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
+
+				if (NULL == (value->value.log = vc_item_logdup(item, values[i].value.log)))
+					goto out;
+
+				value->timestamp = values[i].timestamp;
+				item->tail->first_value--;
+			}
+			ret = SUCCEED;
+
+			break;
+		default:
+			memcpy(&item->tail->slots[item->tail->first_value - values_num], values,
+					values_num * sizeof(zbx_history_record_t));
+			item->tail->first_value -= values_num;
+			ret = SUCCEED;
+	}
+out:
+	item->values_total += first_value - item->tail->first_value;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_free_chunk                                              *
+ *                                                                            *
+ * Purpose: frees chunk and all resources allocated to store its values       *
+ *                                                                            *
+ * Parameters: item    - [IN] the chunk owner item                            *
+ *             chunk   - [IN] the chunk to free                               *
+ *                                                                            *
+ * Return value: the number of bytes freed                                    *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+{
+	size_t	freed;
+
+	freed = sizeof(zbx_vc_chunk_t) + (chunk->slots_num - 1) * sizeof(zbx_history_record_t);
+
+	if (0 != chunk->packed_size)
+	{
+		vc_cache->unpacked_size -= freed;
+		freed = ZBX_VC_PACKED_CHUNK_SIZE(chunk->packed_size);
+		vc_cache->packed_size -= freed;
+
+		vc_unpacked_reset(chunk);
+	}
+
+	/* packed chunks have only numeric values, so the slots are not accessed */
+	freed += vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->last_value);
+
+	__vc_mem_free_func(chunk);
+
+	return freed;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_remove_chunk                                            *
+ *                                                                            *
+ * Purpose: removes item history data chunk                                   *
+ *                                                                            *
+ * Parameters: item    - [IN ] the chunk owner item                           *
+ *             chunk   - [IN] the chunk to remove                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_remove_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+{
+	if (NULL != chunk->next)
+		chunk->next->prev = chunk->prev;
+
+	if (NULL != chunk->prev)
+		chunk->prev->next = chunk->next;
+
+	if (chunk == item->head)
+		item->head = chunk->prev;
+
+	if (chunk == item->tail)
+		item->tail = chunk->next;
+
+	vch_item_free_chunk(item, chunk);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_clean_cache                                             *
+ *                                                                            *
+ * Purpose: removes item history data that are outside (older) the maximum    *
+ *          request range                                                     *
+ *                                                                            *
+ * Parameters:  item   - [IN] the target item                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_clean_cache(zbx_vc_item_t *item)
+{
+	zbx_vc_chunk_t	*next;
+
+	if (0 != item->active_range)
+	{
+		zbx_vc_chunk_t	*tail = item->tail;
+		zbx_vc_chunk_t	*chunk = tail;
+		int		timestamp, last_sec;
+
+		timestamp = time(NULL) - item->active_range;
+
+		/* try to remove chunks with all history values older than maximum request range */
+		while (NULL != chunk && (last_sec = vch_chunk_get_slots(chunk)[chunk->last_value].timestamp.sec) <
+				timestamp && last_sec != item->head->slots[item->head->last_value].timestamp.sec)
+		{
+			const zbx_history_record_t	*slots;
+
+			/* don't remove the head chunk */
+			if (NULL == (next = chunk->next))
+				break;
+
+			/* Values with the same timestamps (seconds resolution) always should be either   */
+			/* kept in cache or removed together. There should not be a case when one of them */
+			/* is in cache and the second is dropped.                                         */
+			/* Here we are handling rare case, when the last value of first chunk has the     */
+			/* same timestamp (seconds resolution) as the first value in the second chunk.    */
+			/* In this case increase the first value index of the next chunk until the first  */
+			/* value timestamp is greater.                                                    */
+
+			slots = vch_chunk_get_slots(next);
+
+			if (slots[next->first_value].timestamp.sec != slots[next->last_value].timestamp.sec)
+			{
+				while (slots[next->first_value].timestamp.sec == last_sec)
+				{
+					vc_item_free_values(item, next->slots, next->first_value, next->first_value);
+					next->first_value++;
+				}
+			}
+
+			/* set the database cached from timestamp to the last (oldest) removed value timestamp + 1 */
+			item->db_cached_from = last_sec + 1;
+
+			vch_item_remove_chunk(item, chunk);
+
+			chunk = next;
+		}
+
+		/* reset the status flags if data was removed from cache */
+		if (tail != item->tail)
+			item->status = 0;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_remove_values                                           *
+ *                                                                            *
+ * Purpose: removes item history data that are older than the specified       *
+ *          timestamp                                                         *
+ *                                                                            *
+ * Parameters:  item      - [IN] the target item                              *
+ *              timestamp - [IN] the timestamp (number of seconds since the   *
+ *                               Epoch)                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_remove_values(zbx_vc_item_t *item, int timestamp)
+{
+	zbx_vc_chunk_t	*chunk = item->tail;
+
+	if (ZBX_ITEM_STATUS_CACHED_ALL == item->status)
+		item->status = 0;
+
+	/* try to remove chunks with all history values older than the timestamp */
+	while (NULL != chunk && vch_chunk_get_slots(chunk)[chunk->first_value].timestamp.sec < timestamp)
+	{
+		zbx_vc_chunk_t			*next;
+		const zbx_history_record_t	*slots = vch_chunk_get_slots(chunk);
+
+		/* If chunk contains values with timestamp greater or equal - remove */
+		/* only the values with less timestamp. Otherwise remove the while   */
+		/* chunk and check next one.                                         */
+		if (slots[chunk->last_value].timestamp.sec >= timestamp)
+		{
+			while (slots[chunk->first_value].timestamp.sec < timestamp)
+			{
+				vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->first_value);
+				chunk->first_value++;
+			}
+
+			break;
+		}
+
+		next = chunk->next;
+		vch_item_remove_chunk(item, chunk);
+		chunk = next;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_add_value_at_head                                       *
+ *                                                                            *
+ * Purpose: adds one item history value at the end of current item's history  *
+ *          data                                                              *
+ *                                                                            *
+ * Parameters:  item   - [IN] the item to add history data to                 *
+ *              value  - [IN] the item history data value                     *
+ *                                                                            *
+ * Return value: SUCCEED - the history data value was added successfully      *
+ *               FAIL - failed to add history data value (not enough memory)  *
+ *                                                                            *
+ * Comments: In the case of failure the item will be removed from cache       *
+ *           later.                                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_record_t *value)
+{
+	int		ret = FAIL, index, sindex, nslots = 0;
+	zbx_vc_chunk_t	*chunk, *schunk, *head = item->head;
+
+	if (NULL != item->head &&
+			0 < zbx_history_record_compare_asc_func(&item->head->slots[item->head->last_value], value))
+	{
+		if (0 < zbx_history_record_compare_asc_func(&vch_chunk_get_slots(item->tail)[item->tail->first_value],
+				value))
+		{
+			/* If the added value has the same or older timestamp as the first value in cache */
+			/* we can't add it to keep cache consistency. Additionally we must make sure no   */
+			/* values with matching timestamp seconds are kept in cache.                      */
+			vch_item_remove_values(item, value->timestamp.sec + 1);
+
+			/* empty items must be removed to avoid situation when a new value is added to cache */
+			/* while other values with matching timestamp seconds are not cached                 */
+			if (NULL == item->head)
+				goto out;
+
+			/* if the value is newer than the database cached from timestamp we must */
+			/* adjust the cached from timestamp to exclude this value                */
+			if (item->db_cached_from <= value->timestamp.sec)
+				item->db_cached_from = value->timestamp.sec + 1;
+
+			ret = SUCCEED;
+			goto out;
+		}
+
+		sindex = item->head->last_value;
+		schunk = item->head;
+
+		if (0 == item->head->slots_num - item->head->last_value - 1)
+		{
+			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
+				goto out;
+		}
+		else
+			item->head->last_value++;
+
+		item->values_total++;
+
+		chunk = item->head;
+		index = item->head->last_value;
+
+		do
+		{
+			chunk->slots[index] = schunk->slots[sindex];
+
+			chunk = schunk;
+			index = sindex;
+
+			if (--sindex < schunk->first_value)
+			{
+				if (NULL == (schunk = schunk->prev))
+				{
+					memset(&chunk->slots[index], 0, sizeof(zbx_vc_chunk_t));
+					THIS_SHOULD_NEVER_HAPPEN;
+
+					goto out;
+				}
+
+				/* values are moved to the next chunk, so packed chunks must be unpacked */
+				if (0 != schunk->packed_size && NULL == (schunk = vch_item_unpack_chunk(item, schunk)))
+					goto out;
+
+				sindex = schunk->last_value;
+			}
+		}
+		while (0 < zbx_timespec_compare(&schunk->slots[sindex].timestamp, &value->timestamp));
+	}
+	else
+	{
+		/* find the number of free slots on the right side in last (head) chunk */
+		if (NULL != item->head)
+			nslots = item->head->slots_num - item->head->last_value - 1;
+
+		if (0 == nslots)
+		{
+			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
+				goto out;
+		}
+		else
+			item->head->last_value++;
+
+		item->values_total++;
+
+		chunk = item->head;
+		index = item->head->last_value;
+	}
+
+	if (SUCCEED != vch_item_copy_value(item, chunk, index, value))
+		goto out;
+
+	/* the previous head chunk is full and can be packed if a new head chunk was added */
+	if (NULL != head && head != item->head)
+		vch_item_pack_chunk(item, head);
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_add_values_at_tail                                      *
+ *                                                                            *
+ * Purpose: adds item history values at the beginning of current item's       *
+ *          history data                                                      *
+ *                                                                            *
+ * Parameters:  item   - [IN] the item to add history data to                 *
+ *              values - [IN] the item history data values                    *
+ *              num    - [IN] the number of history data values to add        *
  *                                                                            *
  * Return value: SUCCEED - the history data values were added successfully    *
  *               FAIL - failed to add history data values (not enough memory) *
  *                                                                            *
- * Comments: In the case of failure the item is removed from cache.           *
- *           Overlapping values (by timestamp seconds) are ignored.           *
+ * Comments: In the case of failure the item is removed from cache.           *
+ *           Overlapping values (by timestamp seconds) are ignored.           *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+{
+	int 	count = values_num, ret = FAIL;
+
+	/* skip values already added to the item cache by another process */
+	if (NULL != item->tail)
+	{
+		int	sec = vch_chunk_get_slots(item->tail)[item->tail->first_value].timestamp.sec;
+
+		while (--count >= 0 && values[count].timestamp.sec >= sec)
+			;
+		++count;
+	}
+
+	while (0 != count)
+	{
+		int	copy_slots, nslots = 0;
+
+		/* find the number of free slots on the left side in first (tail) chunk, */
+		/* values are not added to packed chunks                                 */
+		if (NULL != item->tail && 0 == item->tail->packed_size)
+			nslots = item->tail->first_value;
+
+		if (0 == nslots)
+		{
+			nslots = vch_item_chunk_slot_count(item, count);
+
+			if (FAIL == vch_item_add_chunk(item, nslots, item->tail))
+				goto out;
+
+			item->tail->last_value = nslots - 1;
+			item->tail->first_value = nslots;
+
+			/* the previous tail chunk is full and can be packed */
+			if (NULL != item->tail->next)
+				vch_item_pack_chunk(item, item->tail->next);
+		}
+
+		/* copy values to chunk */
+		copy_slots = MIN(nslots, count);
+		count -= copy_slots;
+
+		if (FAIL == vch_item_copy_values_at_tail(item, values + count, copy_slots))
+			goto out;
+	}
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_cache_values_by_time                                    *
+ *                                                                            *
+ * Purpose: cache item history data for the specified time period             *
+ *                                                                            *
+ * Parameters: item        - [IN] the item                                    *
+ *             range_start - [IN] the interval start time                     *
+ *                                                                            *
+ * Return value:  >=0    - the number of values read from database            *
+ *                FAIL   - an error occurred while trying to cache values     *
+ *                                                                            *
+ * Comments: This function checks if the requested value range is cached and  *
+ *           updates cache from database if necessary.                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_cache_values_by_time(zbx_vc_item_t **item, int range_start)
+{
+	int				ret, range_end;
+	zbx_vector_history_record_t	records;
+	zbx_uint64_t			itemid;
+	unsigned char			value_type;
+
+	if (ZBX_ITEM_STATUS_CACHED_ALL == (*item)->status)
+		return SUCCEED;
+
+	/* check if the requested period is in the cached range */
+	if (0 != (*item)->db_cached_from && range_start >= (*item)->db_cached_from)
+		return SUCCEED;
+
+	/* find if the cache should be updated to cover the required range */
+	if (NULL != (*item)->tail)
+	{
+		/* we need to get item values before the first cached value, but not including it */
+		range_end = vch_chunk_get_slots((*item)->tail)[(*item)->tail->first_value].timestamp.sec - 1;
+	}
+	else
+		range_end = ZBX_JAN_2038;
+
+	/* update cache if necessary */
+	if (range_start >= range_end)
+		return SUCCEED;
+
+	zbx_vector_history_record_create(&records);
+	itemid = (*item)->itemid;
+	value_type = (*item)->value_type;
+
+	UNLOCK_CACHE;
+
+	if (SUCCEED == (ret = vc_db_read_values_by_time(itemid, value_type, &records, range_start, range_end)))
+	{
+		zbx_vector_history_record_sort(&records,
+				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
+	}
+
+	WRLOCK_CACHE;
+
+	if (SUCCEED != ret)
+		goto out;
+
+	if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+	{
+		zbx_vc_item_t	new_item = {.itemid = itemid, .value_type = value_type};
+
+		if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item, sizeof(new_item))))
+			goto out;
+	}
+
+	/* when updating cache with time based request we can always reset status flags */
+	/* flag even if the requested period contains no data                           */
+	(*item)->status = 0;
+
+	if (0 < records.values_num)
+	{
+		if (SUCCEED != (ret = vch_item_add_values_at_tail(*item, records.values, records.values_num)))
+			goto out;
+	}
+
+	ret = records.values_num;
+	vc_item_update_db_cached_from(*item, range_start);
+out:
+	zbx_history_record_vector_destroy(&records, value_type);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_cache_values_by_time_and_count                          *
+ *                                                                            *
+ * Purpose: cache the specified number of history data values for time period *
+ *          since timestamp                                                   *
+ *                                                                            *
+ * Parameters: item        - [IN] the item                                    *
+ *             range_start - [IN] the interval start time                     *
+ *             count       - [IN] the number of history values to retrieve    *
+ *             ts          - [IN] the target timestamp                        *
+ *                                                                            *
+ * Return value:  >=0    - the number of values read from database            *
+ *                FAIL   - an error occurred while trying to cache values     *
+ *                                                                            *
+ * Comments: This function checks if the requested number of values is cached *
+ *           and updates cache from database if necessary.                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int range_start, int count,
+		const zbx_timespec_t *ts)
+{
+	int				ret = SUCCEED, cached_records = 0, range_end, records_offset;
+	zbx_vector_history_record_t	records;
+	zbx_uint64_t			itemid;
+	unsigned char			value_type;
+
+	if (ZBX_ITEM_STATUS_CACHED_ALL == (*item)->status)
+		return SUCCEED;
+
+	/* check if the requested period is in the cached range */
+	if (0 != (*item)->db_cached_from && range_start >= (*item)->db_cached_from)
+		return SUCCEED;
+
+	/* find if the cache should be updated to cover the required count */
+	if (NULL != (*item)->head)
+	{
+		zbx_vc_chunk_t	*chunk;
+		int		index;
+
+		if (SUCCEED == vch_item_get_last_value(*item, ts, &chunk, &index))
+		{
+			cached_records = index - chunk->first_value + 1;
+
+			while (NULL != (chunk = chunk->prev) && cached_records < count)
+				cached_records += chunk->last_value - chunk->first_value + 1;
+		}
+	}
+
+	/* update cache if necessary */
+	if (cached_records >= count)
+		return SUCCEED;
+
+	/* get the end timestamp to which (including) the values should be cached */
+	if (NULL != (*item)->head)
+		range_end = vch_chunk_get_slots((*item)->tail)[(*item)->tail->first_value].timestamp.sec - 1;
+	else
+		range_end = ZBX_JAN_2038;
+
+	itemid = (*item)->itemid;
+	value_type = (*item)->value_type;
+	UNLOCK_CACHE;
+
+	zbx_vector_history_record_create(&records);
+
+	if (range_end > ts->sec)
+	{
+		ret = vc_db_read_values_by_time(itemid, value_type, &records, ts->sec + 1, range_end);
+		range_end = ts->sec;
+	}
+
+	records_offset = records.values_num;
+
+	if (SUCCEED == ret && SUCCEED == (ret = vc_db_read_values_by_time_and_count(itemid, value_type, &records,
+			range_start, count - cached_records, range_end, ts)))
+	{
+		zbx_vector_history_record_sort(&records,
+				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
+	}
+
+	WRLOCK_CACHE;
+
+	if (SUCCEED != ret)
+		goto out;
+
+	if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+	{
+		zbx_vc_item_t	new_item = {.itemid = itemid, .value_type = value_type};
+
+		if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item, sizeof(new_item))))
+			goto out;
+	}
+
+	if (0 < records.values_num)
+		ret = vch_item_add_values_at_tail(*item, records.values, records.values_num);
+
+	if (SUCCEED != ret)
+		goto out;
+
+	ret = records.values_num;
+
+	if (0 == range_start && count - cached_records > records.values_num - records_offset)
+	{
+		(*item)->active_range = 0;
+		(*item)->daily_range = 0;
+		(*item)->status = ZBX_ITEM_STATUS_CACHED_ALL;
+	}
+
+	if ((count <= records.values_num || 0 == range_start) && 0 != records.values_num)
+	{
+		vc_item_update_db_cached_from(*item,
+				vch_chunk_get_slots((*item)->tail)[(*item)->tail->first_value].timestamp.sec);
+	}
+	else if (0 != range_start)
+		vc_item_update_db_cached_from(*item, range_start);
+
+out:
+	zbx_history_record_vector_destroy(&records, value_type);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_values_by_time                                      *
+ *                                                                            *
+ * Purpose: retrieves item history data from cache                            *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             values    - [OUT] the item history data stored time/value      *
+ *                         pairs in undefined order                           *
+ *             seconds   - [IN] the time period to retrieve data for          *
+ *             ts        - [IN] the requested period end timestamp            *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
+		const zbx_timespec_t *ts)
+{
+	int		index, now;
+	zbx_timespec_t	start = {ts->sec - seconds, ts->ns};
+	zbx_vc_chunk_t			*chunk;
+	const zbx_history_record_t	*slots;
+
+	/* Check if maximum request range is not set and all data are cached.  */
+	/* Because that indicates there was a count based request with unknown */
+	/* range which might be greater than the current request range.        */
+	if (0 != item->active_range || ZBX_ITEM_STATUS_CACHED_ALL != item->status)
+	{
+		now = time(NULL);
+		/* add another second to include nanosecond shifts */
+		vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, seconds + now - ts->sec + 1, now);
+	}
+
+	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
+	{
+		/* Cache does not contain records for the specified timeshift & seconds range. */
+		/* Return empty vector with success.                                           */
+		return;
+	}
+
+	/* fill the values vector with item history values until the start timestamp is reached */
+	while (0 < zbx_timespec_compare(&(slots = vch_chunk_get_slots(chunk))[chunk->last_value].timestamp, &start))
+	{
+		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&slots[index].timestamp, &start))
+			vc_history_record_vector_append(values, item->value_type, &slots[index--]);
+
+		if (NULL == (chunk = chunk->prev))
+			break;
+
+		index = chunk->last_value;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_values_by_time_and_count                            *
+ *                                                                            *
+ * Purpose: retrieves item history data from cache                            *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             values    - [OUT] the item history data stored time/value      *
+ *                         pairs in undefined order, optional                 *
+ *                         If null then cache is updated if necessary, but no *
+ *                         values are returned. Used to ensure that cache     *
+ *                         contains a value of the specified timestamp.       *
+ *             seconds   - [IN] the time period                               *
+ *             count     - [IN] the number of history values to retrieve      *
+ *             timestamp - [IN] the target timestamp                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vector_history_record_t *values,
+		int seconds, int count, const zbx_timespec_t *ts)
+{
+	int		index, now, range_timestamp;
+	zbx_vc_chunk_t			*chunk;
+	const zbx_history_record_t	*slots;
+	zbx_timespec_t	start;
+
+	/* set start timestamp of the requested time period */
+	if (0 != seconds)
+	{
+		start.sec = ts->sec - seconds;
+		start.ns = ts->ns;
+	}
+	else
+	{
+		start.sec = 0;
+		start.ns = 0;
+	}
+
+	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
+	{
+		/* return empty vector with success */
+		goto out;
+	}
+
+	/* fill the values vector with item history values until the <count> values are read    */
+	/* or no more values within specified time period                                       */
+	/* fill the values vector with item history values until the start timestamp is reached */
+	while (0 < zbx_timespec_compare(&(slots = vch_chunk_get_slots(chunk))[chunk->last_value].timestamp, &start))
+	{
+		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&slots[index].timestamp, &start))
+		{
+			vc_history_record_vector_append(values, item->value_type, &slots[index--]);
+
+			if (values->values_num == count)
+				goto out;
+		}
+
+		if (NULL == (chunk = chunk->prev))
+			break;
+
+		index = chunk->last_value;
+	}
+out:
+	if (count > values->values_num)
+	{
+		if (0 == seconds)
+			return;
+
+		/* not enough data in the requested period, set the range equal to the period plus */
+		/* one second to include nanosecond shifts                                         */
+		range_timestamp = ts->sec - seconds;
+	}
+	else
+	{
+		/* the requested number of values was retrieved, set the range to the oldest value timestamp */
+		range_timestamp = values->values[values->values_num - 1].timestamp.sec - 1;
+	}
+
+	now = time(NULL);
+	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, now - range_timestamp, now);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_value_range                                         *
+ *                                                                            *
+ * Purpose: get item values for the specified range                           *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             values    - [OUT] the item history data stored time/value      *
+ *                         pairs in undefined order, optional                 *
+ *                         If null then cache is updated if necessary, but no *
+ *                         values are returned. Used to ensure that cache     *
+ *                         contains a value of the specified timestamp.       *
+ *             seconds   - [IN] the time period to retrieve data for          *
+ *             count     - [IN] the number of history values to retrieve      *
+ *             ts        - [IN] the target timestamp                          *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was retrieved successfully  *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: This function returns data from cache if necessary updating it   *
+ *           from DB. If cache update was required and failed (not enough     *
+ *           memory to cache DB values), then this function also fails.       *
+ *                                                                            *
+ *           If <count> is set then value range is defined as <count> values  *
+ *           before <timestamp>. Otherwise the range is defined as <seconds>  *
+ *           seconds before <timestamp>.                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_values(zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
+		int count, const zbx_timespec_t *ts)
+{
+	int	ret, records_read, hits, misses, range_start;
+
+	zbx_vector_history_record_clear(values);
+
+	if (0 == count)
+	{
+		if (0 > (range_start = ts->sec - seconds))
+			range_start = 0;
+
+		if (FAIL == (ret = vch_item_cache_values_by_time(&item, range_start)))
+			goto out;
+
+		records_read = ret;
+
+		vch_item_get_values_by_time(item, values, seconds, ts);
+
+		if (records_read > values->values_num)
+			records_read = values->values_num;
+	}
+	else
+	{
+		range_start = (0 == seconds ? 0 : ts->sec - seconds);
+
+		if (FAIL == (ret = vch_item_cache_values_by_time_and_count(&item, range_start, count, ts)))
+			goto out;
+
+		records_read = ret;
+
+		vch_item_get_values_by_time_and_count(item, values, seconds, count, ts);
+
+		if (records_read > values->values_num)
+			records_read = values->values_num;
+	}
+
+	hits = values->values_num - records_read;
+	misses = records_read;
+
+	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_STATS, hits, misses);
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_is_cached_after                                         *
+ *                                                                            *
+ * Purpose: checks if all item values newer than the specified timestamp are  *
+ *          cached                                                            *
+ *                                                                            *
+ * Parameters: item - [IN] the item                                           *
+ *             ts   - [IN] the timestamp                                      *
+ *                                                                            *
+ * Return value: SUCCEED - the values are cached                              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_is_cached_after(const zbx_vc_item_t *item, const zbx_timespec_t *ts)
+{
+	int	sec = ts->sec;
+
+	if (ZBX_ITEM_STATUS_CACHED_ALL == item->status)
+		return SUCCEED;
+
+	/* values from the next second are newer than timestamp with maximum nanoseconds */
+	if (VC_MAX_NANOSECONDS == ts->ns)
+		sec++;
+
+	if (0 != item->db_cached_from && sec >= item->db_cached_from)
+		return SUCCEED;
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_first_value_after                                   *
+ *                                                                            *
+ * Purpose: gets the chunk and index of the first value with a timestamp      *
+ *          greater than the specified timestamp                              *
+ *                                                                            *
+ * Parameters: item   - [IN] the item                                         *
+ *             ts     - [IN] the timestamp                                    *
+ *             pchunk - [OUT] the chunk containing the value                  *
+ *             pindex - [OUT] the index of the value                          *
+ *                                                                            *
+ * Return value: SUCCEED - the value was found                                *
+ *               FAIL    - there are no values newer than the timestamp       *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_first_value_after(const zbx_vc_item_t *item, const zbx_timespec_t *ts,
+		zbx_vc_chunk_t **pchunk, int *pindex)
+{
+	zbx_vc_chunk_t	*chunk;
+	int		index;
+
+	if (NULL == item->tail)
+		return FAIL;
+
+	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
+	{
+		/* all cached values are newer than the specified timestamp */
+		*pchunk = item->tail;
+		*pindex = item->tail->first_value;
+
+		return SUCCEED;
+	}
+
+	if (++index > chunk->last_value)
+	{
+		if (NULL == (chunk = chunk->next))
+			return FAIL;
+
+		index = chunk->first_value;
+	}
+
+	*pchunk = chunk;
+	*pindex = index;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_sum_values                                             *
+ *                                                                            *
+ * Purpose: sums item values in the specified time range                      *
+ *                                                                            *
+ * Parameters: item       - [IN] the item                                     *
+ *             from       - [IN] the range start (exclusive)                  *
+ *             to         - [IN] the range end (inclusive), NULL - all values *
+ *             values_num - [OUT] the number of values                        *
+ *             sum_dbl    - [OUT] the values sum as double                    *
+ *             sum_ui64   - [OUT] the unsigned values sum                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_window_sum_values(const zbx_vc_item_t *item, const zbx_timespec_t *from, const zbx_timespec_t *to,
+		int *values_num, double *sum_dbl, zbx_uint64_t *sum_ui64)
+{
+	zbx_vc_chunk_t	*chunk;
+	int		index;
+
+	*values_num = 0;
+	*sum_dbl = 0;
+	*sum_ui64 = 0;
+
+	if (FAIL == vch_item_get_first_value_after(item, from, &chunk, &index))
+		return;
+
+	while (1)
+	{
+		const zbx_history_record_t	*slots = vch_chunk_get_slots(chunk);
+
+		for (; index <= chunk->last_value; index++)
+		{
+			const zbx_history_record_t	*record = &slots[index];
+
+			if (NULL != to && 0 < zbx_timespec_compare(&record->timestamp, to))
+				return;
+
+			(*values_num)++;
+
+			if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
+			{
+				*sum_dbl += record->value.dbl;
+			}
+			else
+			{
+				*sum_dbl += (double)record->value.ui64;
+				*sum_ui64 += record->value.ui64;
+			}
+		}
+
+		if (NULL == (chunk = chunk->next))
+			break;
+
+		index = chunk->first_value;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_value_compare                                                 *
+ *                                                                            *
+ * Purpose: compares two numeric item values                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_value_compare(const history_value_t *v1, const history_value_t *v2, int value_type)
+{
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+	{
+		ZBX_RETURN_IF_NOT_EQUAL(v1->dbl, v2->dbl);
+	}
+	else
+	{
+		ZBX_RETURN_IF_NOT_EQUAL(v1->ui64, v2->ui64);
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_deque_push                                                    *
+ *                                                                            *
+ * Purpose: adds a value to window minimum or maximum candidates              *
+ *                                                                            *
+ * Parameters: deque      - [IN/OUT] the candidates                           *
+ *             record     - [IN] the new value, it must be newer than the     *
+ *                               existing candidates                          *
+ *             value_type - [IN] the item value type                          *
+ *             sign       - [IN] 1 - minimum candidates, -1 - maximum         *
+ *                               candidates                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the value was added                                *
+ *               FAIL    - not enough memory                                  *
+ *                                                                            *
+ * Comments: Older candidates are dropped if they are not less (greater) than *
+ *           the new value, because they will leave the window first.         *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_deque_push(zbx_vc_deque_t *deque, const zbx_history_record_t *record, int value_type, int sign)
+{
+	while (0 < deque->num && 0 <= sign * vc_value_compare(&deque->records[deque->first + deque->num - 1].value,
+			&record->value, value_type))
+	{
+		deque->num--;
+	}
+
+	if (0 == deque->num)
+		deque->first = 0;
+
+	if (deque->first + deque->num == deque->alloc)
+	{
+		if (0 != deque->first && deque->num <= deque->alloc / 2)
+		{
+			memmove(deque->records, deque->records + deque->first, sizeof(zbx_history_record_t) * deque->num);
+			deque->first = 0;
+		}
+		else
+		{
+			zbx_history_record_t	*records;
+			int			alloc = (0 == deque->alloc ? 16 : deque->alloc * 2);
+
+			if (NULL == deque->records)
+				records = (zbx_history_record_t *)__vc_mem_malloc_func(NULL, sizeof(*records) * alloc);
+			else
+				records = (zbx_history_record_t *)__vc_mem_realloc_func(deque->records, sizeof(*records) * alloc);
+
+			if (NULL == records)
+				return FAIL;
+
+			deque->records = records;
+			deque->alloc = alloc;
+		}
+	}
+
+	deque->records[deque->first + deque->num++] = *record;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_deque_get_first                                               *
+ *                                                                            *
+ * Purpose: gets the oldest candidate newer than the specified timestamp      *
+ *                                                                            *
+ * Parameters: deque - [IN] the candidates                                    *
+ *             start - [IN] the window start                                  *
+ *                                                                            *
+ * Return value: the window minimum (maximum) or NULL if the window is empty  *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_history_record_t	*vc_deque_get_first(const zbx_vc_deque_t *deque, const zbx_timespec_t *start)
+{
+	int	i;
+
+	for (i = deque->first; i < deque->first + deque->num; i++)
+	{
+		if (0 < zbx_timespec_compare(&deque->records[i].timestamp, start))
+			return &deque->records[i];
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_deque_expire                                                  *
+ *                                                                            *
+ * Purpose: removes candidates not newer than the window start                *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_deque_expire(zbx_vc_deque_t *deque, const zbx_timespec_t *start)
+{
+	while (0 < deque->num && 0 >= zbx_timespec_compare(&deque->records[deque->first].timestamp, start))
+	{
+		deque->first++;
+		deque->num--;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_free                                                   *
+ *                                                                            *
+ * Purpose: frees sliding window                                              *
+ *                                                                            *
+ * Return value: the size of freed memory (bytes)                             *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vc_window_free(zbx_vc_window_t *window)
+{
+	size_t	freed = sizeof(zbx_vc_window_t);
+
+	freed += sizeof(zbx_history_record_t) * (window->min.alloc + window->max.alloc);
+
+	__vc_mem_free_func(window->min.records);
+	__vc_mem_free_func(window->max.records);
+	__vc_mem_free_func(window);
+
+	return freed;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_add_value                                              *
+ *                                                                            *
+ * Purpose: adds a value newer than all aggregated values to sliding window   *
+ *                                                                            *
+ * Return value: SUCCEED - the value was added                                *
+ *               FAIL    - not enough memory                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_window_add_value(zbx_vc_window_t *window, int value_type, const zbx_history_record_t *record)
+{
+	window->values_num++;
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+	{
+		window->sum_dbl += record->value.dbl;
+	}
+	else
+	{
+		window->sum_dbl += (double)record->value.ui64;
+		window->sum_ui64 += record->value.ui64;
+	}
+
+	if (0 != (window->flags & ZBX_VC_AGGREGATE_MIN) &&
+			SUCCEED != vc_deque_push(&window->min, record, value_type, 1))
+	{
+		return FAIL;
+	}
+
+	if (0 != (window->flags & ZBX_VC_AGGREGATE_MAX) &&
+			SUCCEED != vc_deque_push(&window->max, record, value_type, -1))
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_expire_window                                           *
+ *                                                                            *
+ * Purpose: moves sliding window start forward, removing older values         *
+ *                                                                            *
+ * Parameters: item   - [IN] the item                                         *
+ *             window - [IN/OUT] the sliding window                           *
+ *             start  - [IN] the new window start                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_expire_window(const zbx_vc_item_t *item, zbx_vc_window_t *window, const zbx_timespec_t *start)
+{
+	int		values_num;
+	double		sum_dbl;
+	zbx_uint64_t	sum_ui64;
+
+	if (0 <= zbx_timespec_compare(&window->start, start))
+		return;
+
+	vc_window_sum_values(item, &window->start, start, &values_num, &sum_dbl, &sum_ui64);
+	window->start = *start;
+
+	vc_deque_expire(&window->min, start);
+	vc_deque_expire(&window->max, start);
+
+	window->values_num -= values_num;
+	window->sum_ui64 -= sum_ui64;
+
+	/* recalculate the sum after the window has been fully replaced, so the floating */
+	/* point error of incremental updates does not build up                         */
+	if ((window->expired_num += values_num) > window->values_num)
+	{
+		vc_window_sum_values(item, &window->start, NULL, &values_num, &window->sum_dbl, &sum_ui64);
+		window->expired_num = 0;
+	}
+	else
+		window->sum_dbl -= sum_dbl;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_window                                              *
+ *                                                                            *
+ * Purpose: finds item sliding window with the specified period               *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_vc_window_t	*vch_item_get_window(const zbx_vc_item_t *item, int seconds)
+{
+	zbx_vc_window_t	*window;
+
+	for (window = item->windows; NULL != window; window = window->next)
+	{
+		if (window->seconds == seconds)
+			break;
+	}
+
+	return window;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_remove_window                                           *
+ *                                                                            *
+ * Purpose: removes sliding window from item                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_remove_window(zbx_vc_item_t *item, zbx_vc_window_t *window)
+{
+	zbx_vc_window_t	**pwindow;
+
+	for (pwindow = &item->windows; NULL != *pwindow; pwindow = &(*pwindow)->next)
+	{
+		if (*pwindow == window)
+		{
+			*pwindow = window->next;
+			vc_window_free(window);
+			break;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_free_windows                                            *
+ *                                                                            *
+ * Purpose: frees all sliding windows of item                                 *
+ *                                                                            *
+ * Return value: the size of freed memory (bytes)                             *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_item_free_windows(zbx_vc_item_t *item)
+{
+	size_t	freed = 0;
+
+	while (NULL != item->windows)
+	{
+		zbx_vc_window_t	*window = item->windows;
+
+		item->windows = window->next;
+		freed += vc_window_free(window);
+	}
+
+	return freed;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_add_window                                              *
+ *                                                                            *
+ * Purpose: creates sliding window from the cached item values                *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *             seconds - [IN] the window period                               *
+ *             flags   - [IN] the aggregates to maintain                      *
+ *             now     - [IN] the current time                                *
+ *                                                                            *
+ * Comments: The window is not created if the values of the last period are   *
+ *           not cached or there is not enough memory. In that case the       *
+ *           aggregates will be calculated from values returned by value      *
+ *           cache.                                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_add_window(zbx_vc_item_t *item, int seconds, int flags, int now)
+{
+	zbx_vc_window_t	*window;
+	zbx_vc_chunk_t	*chunk;
+	zbx_timespec_t	start;
+	int		index, windows_num = 0;
+
+	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
+		return;
+
+	if (NULL == item->head)
+		return;
+
+	for (window = item->windows; NULL != window; window = window->next)
+		windows_num++;
+
+	if (ZBX_VC_ITEM_WINDOWS_MAX <= windows_num)
+		return;
+
+	start = item->head->slots[item->head->last_value].timestamp;
+	start.sec -= seconds;
+
+	/* start with the cached values if not all values of the last period are cached */
+	if (SUCCEED != vch_item_is_cached_after(item, &start))
+	{
+		if (0 == item->db_cached_from)
+			return;
+
+		start.sec = item->db_cached_from - 1;
+		start.ns = VC_MAX_NANOSECONDS;
+	}
+
+	if (NULL == (window = (zbx_vc_window_t *)__vc_mem_malloc_func(NULL, sizeof(zbx_vc_window_t))))
+		return;
+
+	memset(window, 0, sizeof(zbx_vc_window_t));
+	window->seconds = seconds;
+	window->flags = flags;
+	window->last_accessed = now;
+	window->start = start;
+
+	if (SUCCEED == vch_item_get_first_value_after(item, &start, &chunk, &index))
+	{
+		while (1)
+		{
+			const zbx_history_record_t	*slots = vch_chunk_get_slots(chunk);
+
+			for (; index <= chunk->last_value; index++)
+			{
+				if (SUCCEED != vc_window_add_value(window, item->value_type, &slots[index]))
+				{
+					vc_window_free(window);
+					return;
+				}
+			}
+
+			if (NULL == (chunk = chunk->next))
+				break;
+
+			index = chunk->first_value;
+		}
+	}
+
+	window->next = item->windows;
+	item->windows = window;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_update_window                                           *
+ *                                                                            *
+ * Purpose: marks sliding window as accessed, creating it if necessary        *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *             seconds - [IN] the window period                               *
+ *             flags   - [IN] the requested aggregates                        *
+ *             now     - [IN] the current time                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_update_window(zbx_vc_item_t *item, int seconds, int flags, int now)
+{
+	zbx_vc_window_t	*window;
+
+	if (NULL != (window = vch_item_get_window(item, seconds)))
+	{
+		if (flags == (window->flags & flags))
+		{
+			window->last_accessed = now;
+			return;
+		}
+
+		/* recreate the window to maintain the missing aggregates */
+		flags |= window->flags;
+		vch_item_remove_window(item, window);
+	}
+
+	vch_item_add_window(item, seconds, flags, now);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_update_windows                                          *
+ *                                                                            *
+ * Purpose: updates sliding windows after a value was added to item cache     *
+ *                                                                            *
+ * Parameters: item     - [IN] the item                                       *
+ *             record   - [IN] the added value                                *
+ *             appended - [IN] 1 - the value was added after cached values    *
+ *                             0 - the value was inserted between cached      *
+ *                                 values                                     *
+ *             now      - [IN] the current time                               *
+ *                                                                            *
+ * Comments: The windows are removed if they cannot be updated incrementally. *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_update_windows(zbx_vc_item_t *item, const zbx_history_record_t *record, int appended, int now)
+{
+	zbx_vc_window_t	**pwindow = &item->windows;
+
+	while (NULL != *pwindow)
+	{
+		zbx_vc_window_t	*window = *pwindow;
+		zbx_timespec_t	start;
+
+		if (0 == appended || window->last_accessed < now - ZBX_VC_WINDOW_EXPIRE_PERIOD ||
+				SUCCEED != vch_item_is_cached_after(item, &window->start) ||
+				SUCCEED != vc_window_add_value(window, item->value_type, record))
+		{
+			*pwindow = window->next;
+			vc_window_free(window);
+			continue;
+		}
+
+		start.sec = record->timestamp.sec - window->seconds;
+		start.ns = record->timestamp.ns;
+		vch_item_expire_window(item, window, &start);
+
+		pwindow = &window->next;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_free_cache                                              *
+ *                                                                            *
+ * Purpose: frees resources allocated for item history data                   *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *                                                                            *
+ * Return value: the size of freed memory (bytes)                             *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_item_free_cache(zbx_vc_item_t *item)
+{
+	size_t	freed = 0;
+
+	zbx_vc_chunk_t	*chunk = item->tail;
+
+	while (NULL != chunk)
+	{
+		zbx_vc_chunk_t	*next = chunk->next;
+
+		freed += vch_item_free_chunk(item, chunk);
+		chunk = next;
+	}
+	item->values_total = 0;
+	item->head = NULL;
+	item->tail = NULL;
+
+	freed += vch_item_free_windows(item);
+
+	return freed;
+}
+
+/******************************************************************************************************************
+ *                                                                                                                *
+ * Public API                                                                                                     *
+ *                                                                                                                *
+ ******************************************************************************************************************/
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_init_stripe                                                   *
+ *                                                                            *
+ * Purpose: initializes value cache stripe                                    *
+ *                                                                            *
+ * Parameters: index - [IN] the stripe index                                  *
+ *             size  - [IN] the stripe shared memory size                     *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the stripe was initialized successfully            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The initialized stripe is left selected as current stripe.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_init_stripe(int index, zbx_uint64_t size, char **error)
+{
+	zbx_vc_stripe_t	*stripe = &vc_stripes[index];
+
+	if (SUCCEED != zbx_rwlock_create(&stripe->lock, ZBX_RWLOCK_VALUECACHE + index, error))
+		return FAIL;
+
+	if (SUCCEED != zbx_mem_create(&stripe->mem, size, "value cache size", "ValueCacheSize", 1, error))
+		return FAIL;
+
+	vc_select_stripe(index);
+
+	size -= zbx_mem_required_size(1, "value cache size", "ValueCacheSize");
+
+	vc_cache = (zbx_vc_cache_t *)__vc_mem_malloc_func(vc_cache, sizeof(zbx_vc_cache_t));
+
+	if (NULL == vc_cache)
+	{
+		*error = zbx_strdup(*error, "cannot allocate value cache header");
+		return FAIL;
+	}
+	memset(vc_cache, 0, sizeof(zbx_vc_cache_t));
+
+	zbx_hashset_create_ext(&vc_cache->items, VC_ITEMS_INIT_SIZE,
+			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+			__vc_mem_malloc_func, __vc_mem_realloc_func, __vc_mem_free_func);
+
+	if (NULL == vc_cache->items.slots)
+	{
+		*error = zbx_strdup(*error, "cannot allocate value cache data storage");
+		return FAIL;
+	}
+
+	zbx_hashset_create_ext(&vc_cache->strpool, VC_STRPOOL_INIT_SIZE,
+			vc_strpool_hash_func, vc_strpool_compare_func, NULL,
+			__vc_mem_malloc_func, __vc_mem_realloc_func, __vc_mem_free_func);
+
+	if (NULL == vc_cache->strpool.slots)
+	{
+		*error = zbx_strdup(*error, "cannot allocate string pool for value cache data storage");
+		return FAIL;
+	}
+
+	/* the free space request should be 5% of stripe size, but no more than 128KB */
+	vc_cache->min_free_request = (size / 100) * 5;
+	if (vc_cache->min_free_request > 128 * ZBX_KIBIBYTE)
+		vc_cache->min_free_request = 128 * ZBX_KIBIBYTE;
+
+	stripe->cache = vc_cache;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_init                                                      *
+ *                                                                            *
+ * Purpose: initializes value cache                                           *
+ *                                                                            *
+ * Comments: The cache is split into up to ZBX_RWLOCK_VALUECACHE_NUM stripes, *
+ *           each at least ZBX_VC_STRIPE_SIZE_MIN bytes large.                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_init(char **error)
+{
+	zbx_uint64_t	size;
+	int		ret = FAIL, num;
+
+	if (0 == CONFIG_VALUE_CACHE_SIZE)
+		return SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (1 > (num = (int)MIN(CONFIG_VALUE_CACHE_SIZE / ZBX_VC_STRIPE_SIZE_MIN, ZBX_RWLOCK_VALUECACHE_NUM)))
+		num = 1;
+
+	size = CONFIG_VALUE_CACHE_SIZE / num;
+
+	for (vc_stripes_num = 0; vc_stripes_num < num; vc_stripes_num++)
+	{
+		if (SUCCEED != vc_init_stripe(vc_stripes_num, size, error))
+			goto out;
+	}
+
+	CONFIG_VALUE_CACHE_SIZE -= num * zbx_mem_required_size(1, "value cache size", "ValueCacheSize");
+
+	vc_select_stripe(0);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "value cache is split into %d stripes", vc_stripes_num);
+
+	zbx_vector_vc_itemupdate_create(&vc_itemupdates);
+	zbx_vector_vc_itemupdate_reserve(&vc_itemupdates, 256);
+
+	ret = SUCCEED;
+out:
+	zbx_vc_disable();
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_destroy                                                   *
+ *                                                                            *
+ * Purpose: destroys value cache                                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_destroy(void)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL != vc_cache)
+	{
+		int	i;
+
+		zbx_vector_vc_itemupdate_destroy(&vc_itemupdates);
+
+		for (i = 0; i < vc_stripes_num; i++)
+		{
+			vc_select_stripe(i);
+
+			zbx_hashset_destroy(&vc_cache->items);
+			zbx_hashset_destroy(&vc_cache->strpool);
+
+			__vc_mem_free_func(vc_cache);
+			zbx_mem_destroy(vc_mem);
+			zbx_rwlock_destroy(&vc_stripes[i].lock);
+
+			memset(&vc_stripes[i], 0, sizeof(zbx_vc_stripe_t));
+		}
+
+		vc_stripes_num = 0;
+		vc_cache = NULL;
+		vc_mem = NULL;
+		vc_lock = ZBX_RWLOCK_NULL;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_reset                                                     *
+ *                                                                            *
+ * Purpose: resets value cache                                                *
+ *                                                                            *
+ * Comments: All items and their historical data are removed,                 *
+ *           cache working mode, statistics reset.                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_reset(void)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL != vc_cache)
+	{
+		zbx_vc_item_t		*item;
+		zbx_hashset_iter_t	iter;
+		int			i;
+
+		for (i = 0; i < vc_stripes_num; i++)
+		{
+			vc_select_stripe(i);
+
+			WRLOCK_CACHE;
+
+			zbx_hashset_iter_reset(&vc_cache->items, &iter);
+			while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+			{
+				vch_item_free_cache(item);
+				zbx_hashset_iter_remove(&iter);
+			}
+
+			vc_cache->hits = 0;
+			vc_cache->misses = 0;
+			vc_cache->min_free_request = 0;
+			vc_cache->mode = ZBX_VC_MODE_NORMAL;
+			vc_cache->mode_time = 0;
+			vc_cache->last_warning_time = 0;
+
+			UNLOCK_CACHE;
+		}
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_add_values                                                *
+ *                                                                            *
+ * Purpose: adds item values to the history and value cache                   *
+ *                                                                            *
+ * Parameters: history - [IN] item history values                             *
+ *                                                                            *
+ * Return value: SUCCEED - the values were added successfully                 *
+ *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+int	zbx_vc_add_values(zbx_vector_ptr_t *history, int *ret_flush)
 {
-	int 	count = values_num, ret = FAIL;
+	zbx_vc_item_t		*item;
+	int			i, stripe, locked, now;
+	ZBX_DC_HISTORY		*h;
+	time_t			expire_timestamp;
 
-	/* skip values already added to the item cache by another process */
-	if (NULL != item->tail)
-	{
-		int	sec = item->tail->slots[item->tail->first_value].timestamp.sec;
+	if (SUCCEED != zbx_history_add_values(history, ret_flush))
+		return FAIL;
 
-		while (--count >= 0 && values[count].timestamp.sec >= sec)
-			;
-		++count;
-	}
+	if (ZBX_VC_DISABLED == vc_state)
+		return SUCCEED;
 
-	while (0 != count)
-	{
-		int	copy_slots, nslots = 0;
+	now = time(NULL);
+	expire_timestamp = now - ZBX_VC_ITEM_EXPIRE_PERIOD;
 
-		/* find the number of free slots on the left side in first (tail) chunk */
-		if (NULL != item->tail)
-			nslots = item->tail->first_value;
+	/* lock stripes one by one, so values of items in other stripes can be read meanwhile */
+	for (stripe = 0; stripe < vc_stripes_num; stripe++)
+	{
+		vc_select_stripe(stripe);
+		locked = 0;
 
-		if (0 == nslots)
+		for (i = 0; i < history->values_num; i++)
 		{
-			nslots = vch_item_chunk_slot_count(item, count);
+			h = (ZBX_DC_HISTORY *)history->values[i];
 
-			if (FAIL == vch_item_add_chunk(item, nslots, item->tail))
-				goto out;
+			if (stripe != vc_get_stripe_index(h->itemid))
+				continue;
 
-			item->tail->last_value = nslots - 1;
-			item->tail->first_value = nslots;
-		}
+			if (0 == locked)
+			{
+				WRLOCK_CACHE;
+				locked = 1;
+			}
 
-		/* copy values to chunk */
-		copy_slots = MIN(nslots, count);
-		count -= copy_slots;
+			if (NULL != (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &h->itemid)))
+			{
+				zbx_history_record_t	record = {h->ts, h->value};
+				zbx_vc_chunk_t		*head = item->head;
+				int			appended;
+
+				appended = (NULL == head ||
+						0 >= zbx_timespec_compare(&head->slots[head->last_value].timestamp, &h->ts));
+
+				/* If the new value type does not match the item's type in cache remove it, */
+				/* so it's cached with the correct type from correct tables when accessed   */
+				/* next time.                                                               */
+				/* Also remove item if the value adding failed. In this case we             */
+				/* won't have the latest data in cache - so the requests must go directly   */
+				/* to the database.                                                         */
+				if (item->value_type != h->value_type || item->last_accessed < expire_timestamp ||
+						FAIL == vch_item_add_value_at_head(item, &record))
+				{
+					vc_remove_item(item);
+					continue;
+				}
 
-		if (FAIL == vch_item_copy_values_at_tail(item, values + count, copy_slots))
-			goto out;
+				if (NULL != item->windows)
+					vch_item_update_windows(item, &record, appended, now);
+
+				/* try to remove old (unused) chunks if a new chunk was added */
+				if (head != item->head)
+					vch_item_clean_cache(item);
+			}
+		}
+
+		if (0 != locked)
+			UNLOCK_CACHE;
 	}
 
-	ret = SUCCEED;
-out:
-	return ret;
+	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_cache_values_by_time                                    *
+ * Function: zbx_vc_get_values                                                *
  *                                                                            *
- * Purpose: cache item history data for the specified time period             *
+ * Purpose: get item history data for the specified time period               *
  *                                                                            *
- * Parameters: item        - [IN] the item                                    *
- *             range_start - [IN] the interval start time                     *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             values     - [OUT] the item history data stored time/value     *
+ *                          pairs in descending order                         *
+ *             seconds    - [IN] the time period to retrieve data for         *
+ *             count      - [IN] the number of history values to retrieve     *
+ *             ts         - [IN] the period end timestamp                     *
  *                                                                            *
- * Return value:  >=0    - the number of values read from database            *
- *                FAIL   - an error occurred while trying to cache values     *
+ * Return value:  SUCCEED - the item history data was retrieved successfully  *
+ *                FAIL    - the item history data was not retrieved           *
  *                                                                            *
- * Comments: This function checks if the requested value range is cached and  *
- *           updates cache from database if necessary.                        *
+ * Comments: If the data is not in cache, it's read from DB, so this function *
+ *           will always return the requested data, unless some error occurs. *
+ *                                                                            *
+ *           If <count> is set then value range is defined as <count> values  *
+ *           before <timestamp>. Otherwise the range is defined as <seconds>  *
+ *           seconds before <timestamp>.                                      *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_cache_values_by_time(zbx_vc_item_t **item, int range_start)
+int	zbx_vc_get_values(zbx_uint64_t itemid, int value_type, zbx_vector_history_record_t *values, int seconds,
+		int count, const zbx_timespec_t *ts)
 {
-	int				ret, range_end;
-	zbx_vector_history_record_t	records;
-	zbx_uint64_t			itemid;
-	unsigned char			value_type;
-
-	if (ZBX_ITEM_STATUS_CACHED_ALL == (*item)->status)
-		return SUCCEED;
+	zbx_vc_item_t	*item, new_item;
+	int 		ret = FAIL, cache_used = 1;
 
-	/* check if the requested period is in the cached range */
-	if (0 != (*item)->db_cached_from && range_start >= (*item)->db_cached_from)
-		return SUCCEED;
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d count:%d period:%d end_timestamp"
+			" '%s'", __func__, itemid, value_type, count, seconds, zbx_timespec_str(ts));
 
-	/* find if the cache should be updated to cover the required range */
-	if (NULL != (*item)->tail)
-	{
-		/* we need to get item values before the first cached value, but not including it */
-		range_end = (*item)->tail->slots[(*item)->tail->first_value].timestamp.sec - 1;
-	}
-	else
-		range_end = ZBX_JAN_2038;
+	vc_select_item_stripe(itemid);
 
-	/* update cache if necessary */
-	if (range_start >= range_end)
-		return SUCCEED;
+	RDLOCK_CACHE;
 
-	zbx_vector_history_record_create(&records);
-	itemid = (*item)->itemid;
-	value_type = (*item)->value_type;
+	if (ZBX_VC_DISABLED == vc_state)
+		goto out;
 
-	UNLOCK_CACHE;
+	if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
+		vc_warn_low_memory();
 
-	if (SUCCEED == (ret = vc_db_read_values_by_time(itemid, value_type, &records, range_start, range_end)))
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
 	{
-		zbx_vector_history_record_sort(&records,
-				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
-	}
-
-	WRLOCK_CACHE;
+		if (ZBX_VC_MODE_NORMAL != vc_cache->mode)
+			goto out;
 
-	if (SUCCEED != ret)
+		memset(&new_item, 0, sizeof(new_item));
+		new_item.itemid = itemid;
+		new_item.value_type = value_type;
+		item = &new_item;
+	}
+	else if (item->value_type != value_type)
 		goto out;
 
-	if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+	ret = vch_item_get_values(item, values, seconds, count, ts);
+out:
+	if (FAIL == ret)
 	{
-		zbx_vc_item_t	new_item = {.itemid = itemid, .value_type = value_type};
+		cache_used = 0;
 
-		if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item, sizeof(new_item))))
-			goto out;
-	}
+		UNLOCK_CACHE;
+		ret = vc_db_get_values(itemid, value_type, values, seconds, count, ts);
+		WRLOCK_CACHE;
 
-	/* when updating cache with time based request we can always reset status flags */
-	/* flag even if the requested period contains no data                           */
-	(*item)->status = 0;
+		if (ZBX_VC_DISABLED != vc_state)
+			vc_remove_item_by_id(itemid);
 
-	if (0 < records.values_num)
-	{
-		if (SUCCEED != (ret = vch_item_add_values_at_tail(*item, records.values, records.values_num)))
-			goto out;
+		if (SUCCEED == ret)
+			vc_update_statistics(NULL, 0, values->values_num, time(NULL));
 	}
 
-	ret = records.values_num;
-	vc_item_update_db_cached_from(*item, range_start);
-out:
-	zbx_history_record_vector_destroy(&records, value_type);
+	UNLOCK_CACHE;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d cached:%d",
+			__func__, zbx_result_string(ret), values->values_num, cache_used);
 
 	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_cache_values_by_time_and_count                          *
+ * Function: zbx_vc_get_value                                                 *
  *                                                                            *
- * Purpose: cache the specified number of history data values for time period *
- *          since timestamp                                                   *
+ * Purpose: get the last history value with a timestamp less or equal to the  *
+ *          target timestamp                                                  *
  *                                                                            *
- * Parameters: item        - [IN] the item                                    *
- *             range_start - [IN] the interval start time                     *
- *             count       - [IN] the number of history values to retrieve    *
- *             ts          - [IN] the target timestamp                        *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             ts         - [IN] the target timestamp                         *
+ *             value      - [OUT] the value found                             *
  *                                                                            *
- * Return value:  >=0    - the number of values read from database            *
- *                FAIL   - an error occurred while trying to cache values     *
+ * Return Value: SUCCEED - the item was retrieved                             *
+ *               FAIL    - otherwise                                          *
  *                                                                            *
- * Comments: This function checks if the requested number of values is cached *
- *           and updates cache from database if necessary.                    *
+ * Comments: Depending on the value type this function might allocate memory  *
+ *           to store value data. To free it use zbx_vc_history_value_clear() *
+ *           function.                                                        *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int range_start, int count,
-		const zbx_timespec_t *ts)
+int	zbx_vc_get_value(zbx_uint64_t itemid, int value_type, const zbx_timespec_t *ts, zbx_history_record_t *value)
 {
-	int				ret = SUCCEED, cached_records = 0, range_end, records_offset;
-	zbx_vector_history_record_t	records;
-	zbx_uint64_t			itemid;
-	unsigned char			value_type;
+	zbx_vector_history_record_t	values;
+	int				ret = FAIL;
 
-	if (ZBX_ITEM_STATUS_CACHED_ALL == (*item)->status)
-		return SUCCEED;
+	zbx_history_record_vector_create(&values);
 
-	/* check if the requested period is in the cached range */
-	if (0 != (*item)->db_cached_from && range_start >= (*item)->db_cached_from)
-		return SUCCEED;
+	if (SUCCEED != zbx_vc_get_values(itemid, value_type, &values, ts->sec, 1, ts) || 0 == values.values_num)
+		goto out;
 
-	/* find if the cache should be updated to cover the required count */
-	if (NULL != (*item)->head)
-	{
-		zbx_vc_chunk_t	*chunk;
-		int		index;
+	*value = values.values[0];
 
-		if (SUCCEED == vch_item_get_last_value(*item, ts, &chunk, &index))
-		{
-			cached_records = index - chunk->first_value + 1;
+	/* reset values vector size so the returned value is not cleared when destroying the vector */
+	values.values_num = 0;
 
-			while (NULL != (chunk = chunk->prev) && cached_records < count)
-				cached_records += chunk->last_value - chunk->first_value + 1;
-		}
-	}
+	ret = SUCCEED;
+out:
+	zbx_history_record_vector_destroy(&values, value_type);
 
-	/* update cache if necessary */
-	if (cached_records >= count)
-		return SUCCEED;
+	return ret;
+}
 
-	/* get the end timestamp to which (including) the values should be cached */
-	if (NULL != (*item)->head)
-		range_end = (*item)->tail->slots[(*item)->tail->first_value].timestamp.sec - 1;
-	else
-		range_end = ZBX_JAN_2038;
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_get_aggregate                                             *
+ *                                                                            *
+ * Purpose: get aggregates of numeric item values for the specified time      *
+ *          period from the item sliding window                               *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             seconds    - [IN] the time period                              *
+ *             ts         - [IN] the period end timestamp                     *
+ *             flags      - [IN] the requested aggregates, see                *
+ *                               ZBX_VC_AGGREGATE_* defines                   *
+ *             aggregate  - [OUT] the aggregates                              *
+ *                                                                            *
+ * Return value: SUCCEED - the aggregates were retrieved                      *
+ *               FAIL    - the sliding window is not available or windows are *
+ *                         disabled, the values must be retrieved with        *
+ *                         zbx_vc_get_values()                                *
+ *                                                                            *
+ * Comments: The sliding window is created when flushing statistics after     *
+ *           the first request, so it's available for the following requests. *
+ *           The window can be used only if period end is not older than the  *
+ *           last cached item value.                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_get_aggregate(zbx_uint64_t itemid, int value_type, int seconds, const zbx_timespec_t *ts, int flags,
+		zbx_vc_aggregate_t *aggregate)
+{
+	zbx_vc_item_t			*item;
+	zbx_vc_window_t			*window;
+	const zbx_history_record_t	*record;
+	zbx_timespec_t			start = {ts->sec - seconds, ts->ns};
+	int				ret = FAIL, values_num, now;
+	double				sum_dbl;
+	zbx_uint64_t			sum_ui64;
+
+	if (ZBX_VC_DISABLED == vc_state || 0 == CONFIG_VALUE_CACHE_AGGREGATES || 0 >= seconds)
+		return FAIL;
 
-	itemid = (*item)->itemid;
-	value_type = (*item)->value_type;
-	UNLOCK_CACHE;
+	if (ITEM_VALUE_TYPE_FLOAT != value_type && ITEM_VALUE_TYPE_UINT64 != value_type)
+		return FAIL;
+
+	vc_select_item_stripe(itemid);
+
+	RDLOCK_CACHE;
 
-	zbx_vector_history_record_create(&records);
+	/* register window request, so the window is created if it does not exist yet */
+	vc_cache_item_update(itemid, ZBX_VC_UPDATE_WINDOW, seconds, flags);
 
-	if (range_end > ts->sec)
-	{
-		ret = vc_db_read_values_by_time(itemid, value_type, &records, ts->sec + 1, range_end);
-		range_end = ts->sec;
-	}
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+		goto out;
 
-	records_offset = records.values_num;
+	if (item->value_type != value_type || NULL == item->head)
+		goto out;
 
-	if (SUCCEED == ret && SUCCEED == (ret = vc_db_read_values_by_time_and_count(itemid, value_type, &records,
-			range_start, count - cached_records, range_end, ts)))
-	{
-		zbx_vector_history_record_sort(&records,
-				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
-	}
+	if (NULL == (window = vch_item_get_window(item, seconds)) || flags != (window->flags & flags))
+		goto out;
 
-	WRLOCK_CACHE;
+	/* values newer than period end would have to be excluded from window */
+	if (0 < zbx_timespec_compare(&item->head->slots[item->head->last_value].timestamp, ts))
+		goto out;
 
-	if (SUCCEED != ret)
+	/* values older than window start have been already removed from window */
+	if (0 < zbx_timespec_compare(&window->start, &start))
 		goto out;
 
-	if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
-	{
-		zbx_vc_item_t	new_item = {.itemid = itemid, .value_type = value_type};
+	if (SUCCEED != vch_item_is_cached_after(item, &window->start))
+		goto out;
 
-		if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item, sizeof(new_item))))
-			goto out;
-	}
+	/* exclude values between window start and period start */
+	vc_window_sum_values(item, &window->start, &start, &values_num, &sum_dbl, &sum_ui64);
 
-	if (0 < records.values_num)
-		ret = vch_item_add_values_at_tail(*item, records.values, records.values_num);
+	memset(aggregate, 0, sizeof(zbx_vc_aggregate_t));
 
-	if (SUCCEED != ret)
+	if (0 == (aggregate->values_num = window->values_num - values_num))
+	{
+		ret = SUCCEED;
 		goto out;
+	}
 
-	ret = records.values_num;
+	if (0 != (flags & ZBX_VC_AGGREGATE_SUM))
+	{
+		if (ITEM_VALUE_TYPE_FLOAT == value_type)
+			aggregate->sum.dbl = window->sum_dbl - sum_dbl;
+		else
+			aggregate->sum.ui64 = window->sum_ui64 - sum_ui64;
 
-	if (0 == range_start && count - cached_records > records.values_num - records_offset)
+		aggregate->avg = (window->sum_dbl - sum_dbl) / aggregate->values_num;
+	}
+
+	if (0 != (flags & ZBX_VC_AGGREGATE_MIN))
 	{
-		(*item)->active_range = 0;
-		(*item)->daily_range = 0;
-		(*item)->status = ZBX_ITEM_STATUS_CACHED_ALL;
+		if (NULL == (record = vc_deque_get_first(&window->min, &start)))
+			goto out;
+
+		aggregate->min = record->value;
 	}
 
-	if ((count <= records.values_num || 0 == range_start) && 0 != records.values_num)
+	if (0 != (flags & ZBX_VC_AGGREGATE_MAX))
 	{
-		vc_item_update_db_cached_from(*item,
-				(*item)->tail->slots[(*item)->tail->first_value].timestamp.sec);
+		if (NULL == (record = vc_deque_get_first(&window->max, &start)))
+			goto out;
+
+		aggregate->max = record->value;
 	}
-	else if (0 != range_start)
-		vc_item_update_db_cached_from(*item, range_start);
 
+	ret = SUCCEED;
 out:
-	zbx_history_record_vector_destroy(&records, value_type);
+	if (SUCCEED == ret)
+	{
+		if (0 != item->active_range || ZBX_ITEM_STATUS_CACHED_ALL != item->status)
+		{
+			now = time(NULL);
+			/* add another second to include nanosecond shifts */
+			vc_cache_item_update(itemid, ZBX_VC_UPDATE_RANGE, seconds + now - ts->sec + 1, now);
+		}
+
+		vc_cache_item_update(itemid, ZBX_VC_UPDATE_STATS, aggregate->values_num, 0);
+	}
+
+	UNLOCK_CACHE;
 
 	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_get_values_by_time                                      *
+ * Function: zbx_vc_get_statistics                                            *
  *                                                                            *
- * Purpose: retrieves item history data from cache                            *
+ * Purpose: retrieves usage cache statistics                                  *
  *                                                                            *
- * Parameters: item      - [IN] the item                                      *
- *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order                           *
- *             seconds   - [IN] the time period to retrieve data for          *
- *             ts        - [IN] the requested period end timestamp            *
+ * Parameters: stats     - [OUT] the cache usage statistics                   *
+ *                                                                            *
+ * Return value:  SUCCEED - the cache statistics were retrieved successfully  *
+ *                FAIL    - failed to retrieve cache statistics               *
+ *                          (cache was not initialized)                       *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
-		const zbx_timespec_t *ts)
+int	zbx_vc_get_statistics(zbx_vc_stats_t *stats)
 {
-	int		index, now;
-	zbx_timespec_t	start = {ts->sec - seconds, ts->ns};
-	zbx_vc_chunk_t	*chunk;
+	int		i;
+	zbx_uint64_t	packed_size = 0, unpacked_size = 0;
 
-	/* Check if maximum request range is not set and all data are cached.  */
-	/* Because that indicates there was a count based request with unknown */
-	/* range which might be greater than the current request range.        */
-	if (0 != item->active_range || ZBX_ITEM_STATUS_CACHED_ALL != item->status)
-	{
-		now = time(NULL);
-		/* add another second to include nanosecond shifts */
-		vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, seconds + now - ts->sec + 1, now);
-	}
+	if (ZBX_VC_DISABLED == vc_state)
+		return FAIL;
 
-	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
-	{
-		/* Cache does not contain records for the specified timeshift & seconds range. */
-		/* Return empty vector with success.                                           */
-		return;
-	}
+	memset(stats, 0, sizeof(zbx_vc_stats_t));
+	stats->mode = ZBX_VC_MODE_NORMAL;
 
-	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
+	for (i = 0; i < vc_stripes_num; i++)
 	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
+		vc_select_stripe(i);
 
-		if (NULL == (chunk = chunk->prev))
-			break;
+		RDLOCK_CACHE;
 
-		index = chunk->last_value;
+		stats->hits += vc_cache->hits;
+		stats->misses += vc_cache->misses;
+
+		if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
+			stats->mode = ZBX_VC_MODE_LOWMEM;
+
+		stats->total_size += vc_mem->total_size;
+		stats->free_size += vc_mem->free_size;
+
+		packed_size += vc_cache->packed_size;
+		unpacked_size += vc_cache->unpacked_size;
+
+		UNLOCK_CACHE;
 	}
+
+	stats->compression_ratio = (0 != packed_size ? (double)unpacked_size / packed_size : 1);
+
+	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_get_values_by_time_and_count                            *
+ * Function: zbx_vc_enable                                                    *
  *                                                                            *
- * Purpose: retrieves item history data from cache                            *
+ * Purpose: enables value caching for current process                         *
  *                                                                            *
- * Parameters: item      - [IN] the item                                      *
- *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order, optional                 *
- *                         If null then cache is updated if necessary, but no *
- *                         values are returned. Used to ensure that cache     *
- *                         contains a value of the specified timestamp.       *
- *             seconds   - [IN] the time period                               *
- *             count     - [IN] the number of history values to retrieve      *
- *             timestamp - [IN] the target timestamp                          *
+ ******************************************************************************/
+void	zbx_vc_enable(void)
+{
+	if (NULL != vc_cache)
+		vc_state = ZBX_VC_ENABLED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_disable                                                   *
+ *                                                                            *
+ * Purpose: disables value caching for current process                        *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vector_history_record_t *values,
-		int seconds, int count, const zbx_timespec_t *ts)
+void	zbx_vc_disable(void)
 {
-	int		index, now, range_timestamp;
-	zbx_vc_chunk_t	*chunk;
-	zbx_timespec_t	start;
+	vc_state = ZBX_VC_DISABLED;
+}
 
-	/* set start timestamp of the requested time period */
-	if (0 != seconds)
-	{
-		start.sec = ts->sec - seconds;
-		start.ns = ts->ns;
-	}
-	else
-	{
-		start.sec = 0;
-		start.ns = 0;
-	}
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hc_get_diag_stats                                            *
+ *                                                                            *
+ * Purpose: get value cache diagnostic statistics                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, int *mode)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_vc_item_t		*item;
+	int			i;
 
-	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
+	*values_num = 0;
+	*items_num = 0;
+
+	if (ZBX_VC_DISABLED == vc_state)
 	{
-		/* return empty vector with success */
-		goto out;
+		*mode = -1;
+		return;
 	}
 
-	/* fill the values vector with item history values until the <count> values are read    */
-	/* or no more values within specified time period                                       */
-	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
+	*mode = ZBX_VC_MODE_NORMAL;
+
+	for (i = 0; i < vc_stripes_num; i++)
 	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
-		{
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
+		vc_select_stripe(i);
 
-			if (values->values_num == count)
-				goto out;
-		}
+		RDLOCK_CACHE;
 
-		if (NULL == (chunk = chunk->prev))
-			break;
+		*items_num += vc_cache->items.num_data;
 
-		index = chunk->last_value;
-	}
-out:
-	if (count > values->values_num)
-	{
-		if (0 == seconds)
-			return;
+		if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
+			*mode = ZBX_VC_MODE_LOWMEM;
 
-		/* not enough data in the requested period, set the range equal to the period plus */
-		/* one second to include nanosecond shifts                                         */
-		range_timestamp = ts->sec - seconds;
-	}
-	else
-	{
-		/* the requested number of values was retrieved, set the range to the oldest value timestamp */
-		range_timestamp = values->values[values->values_num - 1].timestamp.sec - 1;
-	}
+		zbx_hashset_iter_reset(&vc_cache->items, &iter);
+		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+			*values_num += item->values_total;
 
-	now = time(NULL);
-	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, now - range_timestamp, now);
+		UNLOCK_CACHE;
+	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_get_value_range                                         *
- *                                                                            *
- * Purpose: get item values for the specified range                           *
- *                                                                            *
- * Parameters: item      - [IN] the item                                      *
- *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order, optional                 *
- *                         If null then cache is updated if necessary, but no *
- *                         values are returned. Used to ensure that cache     *
- *                         contains a value of the specified timestamp.       *
- *             seconds   - [IN] the time period to retrieve data for          *
- *             count     - [IN] the number of history values to retrieve      *
- *             ts        - [IN] the target timestamp                          *
- *                                                                            *
- * Return value:  SUCCEED - the item history data was retrieved successfully  *
- *                FAIL    - the item history data was not retrieved           *
- *                                                                            *
- * Comments: This function returns data from cache if necessary updating it   *
- *           from DB. If cache update was required and failed (not enough     *
- *           memory to cache DB values), then this function also fails.       *
+ * Function: zbx_hc_get_mem_stats                                             *
  *                                                                            *
- *           If <count> is set then value range is defined as <count> values  *
- *           before <timestamp>. Otherwise the range is defined as <seconds>  *
- *           seconds before <timestamp>.                                      *
+ * Purpose: get value cache shared memory statistics                          *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_get_values(zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
-		int count, const zbx_timespec_t *ts)
+void	zbx_vc_get_mem_stats(zbx_mem_stats_t *mem)
 {
-	int	ret, records_read, hits, misses, range_start;
-
-	zbx_vector_history_record_clear(values);
-
-	if (0 == count)
-	{
-		if (0 > (range_start = ts->sec - seconds))
-			range_start = 0;
-
-		if (FAIL == (ret = vch_item_cache_values_by_time(&item, range_start)))
-			goto out;
-
-		records_read = ret;
+	zbx_mem_stats_t	stripe_mem;
+	int		i, j;
 
-		vch_item_get_values_by_time(item, values, seconds, ts);
-
-		if (records_read > values->values_num)
-			records_read = values->values_num;
-	}
-	else
-	{
-		range_start = (0 == seconds ? 0 : ts->sec - seconds);
+	memset(mem, 0, sizeof(zbx_mem_stats_t));
 
-		if (FAIL == (ret = vch_item_cache_values_by_time_and_count(&item, range_start, count, ts)))
-			goto out;
+	if (ZBX_VC_DISABLED == vc_state)
+		return;
 
-		records_read = ret;
+	for (i = 0; i < vc_stripes_num; i++)
+	{
+		vc_select_stripe(i);
 
-		vch_item_get_values_by_time_and_count(item, values, seconds, count, ts);
+		RDLOCK_CACHE;
+		zbx_mem_get_stats(vc_mem, &stripe_mem);
+		UNLOCK_CACHE;
 
-		if (records_read > values->values_num)
-			records_read = values->values_num;
-	}
+		if (0 == i)
+		{
+			*mem = stripe_mem;
+			continue;
+		}
 
-	hits = values->values_num - records_read;
-	misses = records_read;
+		for (j = 0; j < MEM_BUCKET_COUNT; j++)
+			mem->chunks_num[j] += stripe_mem.chunks_num[j];
 
-	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_STATS, hits, misses);
+		mem->free_chunks += stripe_mem.free_chunks;
+		mem->used_chunks += stripe_mem.used_chunks;
+		mem->overhead += stripe_mem.overhead;
+		mem->free_size += stripe_mem.free_size;
+		mem->used_size += stripe_mem.used_size;
 
-	ret = SUCCEED;
-out:
-	return ret;
+		if (stripe_mem.min_chunk_size < mem->min_chunk_size)
+			mem->min_chunk_size = stripe_mem.min_chunk_size;
+
+		if (stripe_mem.max_chunk_size > mem->max_chunk_size)
+			mem->max_chunk_size = stripe_mem.max_chunk_size;
+	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_free_cache                                              *
- *                                                                            *
- * Purpose: frees resources allocated for item history data                   *
- *                                                                            *
- * Parameters: item    - [IN] the item                                        *
+ * Function: zbx_vc_get_item_stats                                            *
  *                                                                            *
- * Return value: the size of freed memory (bytes)                             *
+ * Purpose: get statistics of cached items                                    *
  *                                                                            *
  ******************************************************************************/
-static size_t	vch_item_free_cache(zbx_vc_item_t *item)
+void	zbx_vc_get_item_stats(zbx_vector_ptr_t *stats)
 {
-	size_t	freed = 0;
+	zbx_hashset_iter_t	iter;
+	zbx_vc_item_t		*item;
+	zbx_vc_item_stats_t	*item_stats;
+	int			i;
 
-	zbx_vc_chunk_t	*chunk = item->tail;
+	if (ZBX_VC_DISABLED == vc_state)
+		return;
 
-	while (NULL != chunk)
+	for (i = 0; i < vc_stripes_num; i++)
 	{
-		zbx_vc_chunk_t	*next = chunk->next;
+		vc_select_stripe(i);
 
-		freed += vch_item_free_chunk(item, chunk);
-		chunk = next;
-	}
-	item->values_total = 0;
-	item->head = NULL;
-	item->tail = NULL;
+		RDLOCK_CACHE;
 
-	return freed;
-}
+		zbx_vector_ptr_reserve(stats, stats->values_num + vc_cache->items.num_data);
 
-/******************************************************************************************************************
- *                                                                                                                *
- * Public API                                                                                                     *
- *                                                                                                                *
- ******************************************************************************************************************/
+		zbx_hashset_iter_reset(&vc_cache->items, &iter);
+		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			item_stats = (zbx_vc_item_stats_t *)zbx_malloc(NULL, sizeof(zbx_vc_item_stats_t));
+			item_stats->itemid = item->itemid;
+			item_stats->values_num = item->values_total;
+			item_stats->hourly_num = item->last_hourly_num;
+			zbx_vector_ptr_append(stats, item_stats);
+		}
+
+		UNLOCK_CACHE;
+	}
+}
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_init                                                      *
+ * Function: zbx_vc_flush_stats                                               *
  *                                                                            *
- * Purpose: initializes value cache                                           *
+ * Purpose: flush locally cached statistics                                   *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_init(char **error)
+void	zbx_vc_flush_stats(void)
 {
-	zbx_uint64_t	size_reserved;
-	int		ret = FAIL;
+	int		i, now, stripe, locked;
+	zbx_vc_item_t	*item = NULL;
+	zbx_uint64_t	itemid;
 
-	if (0 == CONFIG_VALUE_CACHE_SIZE)
-		return SUCCEED;
+	if (ZBX_VC_DISABLED == vc_state || 0 == vc_itemupdates.values_num)
+		return;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zbx_vector_vc_itemupdate_sort(&vc_itemupdates, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-	if (SUCCEED != (ret = zbx_rwlock_create(&vc_lock, ZBX_RWLOCK_VALUECACHE, error)))
-		goto out;
+	now = time(NULL);
 
-	size_reserved = zbx_mem_required_size(1, "value cache size", "ValueCacheSize");
+	for (stripe = 0; stripe < vc_stripes_num; stripe++)
+	{
+		vc_select_stripe(stripe);
+		locked = 0;
+		itemid = 0;
 
-	if (SUCCEED != zbx_mem_create(&vc_mem, CONFIG_VALUE_CACHE_SIZE, "value cache size", "ValueCacheSize", 1, error))
-		goto out;
+		for (i = 0; i < vc_itemupdates.values_num; i++)
+		{
+			zbx_vc_item_update_t	*update = &vc_itemupdates.values[i];
 
-	CONFIG_VALUE_CACHE_SIZE -= size_reserved;
+			if (itemid != update->itemid)
+			{
+				itemid = update->itemid;
 
-	vc_cache = (zbx_vc_cache_t *)__vc_mem_malloc_func(vc_cache, sizeof(zbx_vc_cache_t));
+				if (stripe != vc_get_stripe_index(itemid))
+				{
+					item = NULL;
+					continue;
+				}
 
-	if (NULL == vc_cache)
-	{
-		*error = zbx_strdup(*error, "cannot allocate value cache header");
-		goto out;
-	}
-	memset(vc_cache, 0, sizeof(zbx_vc_cache_t));
+				if (0 == locked)
+				{
+					WRLOCK_CACHE;
+					locked = 1;
+				}
 
-	zbx_hashset_create_ext(&vc_cache->items, VC_ITEMS_INIT_SIZE,
-			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__vc_mem_malloc_func, __vc_mem_realloc_func, __vc_mem_free_func);
+				item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid);
+			}
 
-	if (NULL == vc_cache->items.slots)
-	{
-		*error = zbx_strdup(*error, "cannot allocate value cache data storage");
-		goto out;
-	}
+			if (NULL == item)
+				continue;
 
-	zbx_hashset_create_ext(&vc_cache->strpool, VC_STRPOOL_INIT_SIZE,
-			vc_strpool_hash_func, vc_strpool_compare_func, NULL,
-			__vc_mem_malloc_func, __vc_mem_realloc_func, __vc_mem_free_func);
+			switch (update->type)
+			{
+				case ZBX_VC_UPDATE_RANGE:
+					vch_item_update_range(item, update->data[ZBX_VC_UPDATE_RANGE_SECONDS],
+							update->data[ZBX_VC_UPDATE_RANGE_NOW]);
+					break;
+				case ZBX_VC_UPDATE_STATS:
+					vc_update_statistics(item, update->data[ZBX_VC_UPDATE_STATS_HITS],
+							update->data[ZBX_VC_UPDATE_STATS_MISSES], now);
+					break;
+				case ZBX_VC_UPDATE_WINDOW:
+					vch_item_update_window(item, update->data[ZBX_VC_UPDATE_WINDOW_SECONDS],
+							update->data[ZBX_VC_UPDATE_WINDOW_FLAGS], now);
+					break;
+			}
+		}
 
-	if (NULL == vc_cache->strpool.slots)
-	{
-		*error = zbx_strdup(*error, "cannot allocate string pool for value cache data storage");
-		goto out;
+		if (0 != locked)
+			UNLOCK_CACHE;
 	}
 
-	/* the free space request should be 5% of cache size, but no more than 128KB */
-	vc_cache->min_free_request = (CONFIG_VALUE_CACHE_SIZE / 100) * 5;
-	if (vc_cache->min_free_request > 128 * ZBX_KIBIBYTE)
-		vc_cache->min_free_request = 128 * ZBX_KIBIBYTE;
-
-	zbx_vector_vc_itemupdate_create(&vc_itemupdates);
-	zbx_vector_vc_itemupdate_reserve(&vc_itemupdates, 256);
+	zbx_vector_vc_itemupdate_clear(&vc_itemupdates);
+}
 
-	ret = SUCCEED;
-out:
-	zbx_vc_disable();
+/* value cache snapshot file format */
+#define ZBX_VC_FILE_MAGIC	"ZBXVC"
+#define ZBX_VC_FILE_VERSION	1
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+/* the length of NULL string and the maximum length of string value in snapshot file */
+#define ZBX_VC_FILE_STR_NULL	UINT32_MAX
+#define ZBX_VC_FILE_STR_LEN_MAX	(16 * ZBX_MEBIBYTE)
 
-	return ret;
+typedef struct
+{
+	char		magic[8];
+	zbx_uint32_t	version;
+	zbx_uint32_t	items_num;
+	int		clock;		/* the snapshot creation time */
 }
+zbx_vc_file_header_t;
 
-/******************************************************************************
- *                                                                            *
- * Function: zbx_vc_destroy                                                   *
- *                                                                            *
- * Purpose: destroys value cache                                              *
- *                                                                            *
- ******************************************************************************/
-void	zbx_vc_destroy(void)
+/* the item record, followed by values_num item values from the oldest to the newest */
+typedef struct
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	if (NULL != vc_cache)
-	{
-		zbx_vector_vc_itemupdate_destroy(&vc_itemupdates);
-
-		zbx_hashset_destroy(&vc_cache->items);
-		zbx_hashset_destroy(&vc_cache->strpool);
-
-		__vc_mem_free_func(vc_cache);
-		vc_cache = NULL;
+	zbx_uint64_t	itemid;
+	unsigned char	value_type;
+	unsigned char	status;
+	int		active_range;
+	int		daily_range;
+	int		db_cached_from;
+	int		last_accessed;
+	int		values_num;
+}
+zbx_vc_file_item_t;
 
-		zbx_mem_destroy(vc_mem);
-		vc_mem = NULL;
-		zbx_rwlock_destroy(&vc_lock);
-	}
+/* the number of items read from snapshot file before checking them in history storage */
+#define ZBX_VC_FILE_LOAD_BATCH_SIZE	1000
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+typedef struct
+{
+	zbx_vc_file_item_t		record;
+	zbx_vector_history_record_t	values;
 }
+zbx_vc_file_load_item_t;
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_reset                                                     *
+ * Function: vc_file_write_str                                                *
  *                                                                            *
- * Purpose: resets value cache                                                *
+ * Purpose: writes string with its length to the snapshot file                *
  *                                                                            *
- * Comments: All items and their historical data are removed,                 *
- *           cache working mode, statistics reset.                            *
+ * Parameters: f   - [IN] the snapshot file                                   *
+ *             str - [IN] the string, can be NULL                             *
+ *                                                                            *
+ * Return value: SUCCEED - the string was written                             *
+ *               FAIL - otherwise                                             *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_reset(void)
+static int	vc_file_write_str(FILE *f, const char *str)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zbx_uint32_t	len;
 
-	if (NULL != vc_cache)
+	if (NULL == str)
 	{
-		zbx_vc_item_t		*item;
-		zbx_hashset_iter_t	iter;
-
-		WRLOCK_CACHE;
+		len = ZBX_VC_FILE_STR_NULL;
+		return 1 == fwrite(&len, sizeof(len), 1, f) ? SUCCEED : FAIL;
+	}
 
-		zbx_hashset_iter_reset(&vc_cache->items, &iter);
-		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
-		{
-			vch_item_free_cache(item);
-			zbx_hashset_iter_remove(&iter);
-		}
+	len = (zbx_uint32_t)strlen(str);
 
-		vc_cache->hits = 0;
-		vc_cache->misses = 0;
-		vc_cache->min_free_request = 0;
-		vc_cache->mode = ZBX_VC_MODE_NORMAL;
-		vc_cache->mode_time = 0;
-		vc_cache->last_warning_time = 0;
+	if (1 != fwrite(&len, sizeof(len), 1, f))
+		return FAIL;
 
-		UNLOCK_CACHE;
-	}
+	if (0 != len && 1 != fwrite(str, len, 1, f))
+		return FAIL;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_add_values                                                *
+ * Function: vc_file_read_str                                                 *
  *                                                                            *
- * Purpose: adds item values to the history and value cache                   *
+ * Purpose: reads string written by vc_file_write_str() function              *
  *                                                                            *
- * Parameters: history - [IN] item history values                             *
+ * Parameters: f   - [IN] the snapshot file                                   *
+ *             str - [OUT] the string, can be NULL                            *
  *                                                                            *
- * Return value: SUCCEED - the values were added successfully                 *
- *               FAIL    - otherwise                                          *
+ * Return value: SUCCEED - the string was read                                *
+ *               FAIL - the file is truncated or corrupted                    *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_add_values(zbx_vector_ptr_t *history, int *ret_flush)
+static int	vc_file_read_str(FILE *f, char **str)
 {
-	zbx_vc_item_t		*item;
-	int			i;
-	ZBX_DC_HISTORY		*h;
-	time_t			expire_timestamp;
+	zbx_uint32_t	len;
 
-	if (SUCCEED != zbx_history_add_values(history, ret_flush))
+	if (1 != fread(&len, sizeof(len), 1, f))
 		return FAIL;
 
-	if (ZBX_VC_DISABLED == vc_state)
+	if (ZBX_VC_FILE_STR_NULL == len)
+	{
+		*str = NULL;
 		return SUCCEED;
+	}
 
-	expire_timestamp = time(NULL) - ZBX_VC_ITEM_EXPIRE_PERIOD;
+	if (ZBX_VC_FILE_STR_LEN_MAX < len)
+		return FAIL;
 
-	WRLOCK_CACHE;
+	*str = (char *)zbx_malloc(NULL, len + 1);
 
-	for (i = 0; i < history->values_num; i++)
+	if (0 != len && 1 != fread(*str, len, 1, f))
 	{
-		h = (ZBX_DC_HISTORY *)history->values[i];
-
-		if (NULL != (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &h->itemid)))
-		{
-			zbx_history_record_t	record = {h->ts, h->value};
-			zbx_vc_chunk_t		*head = item->head;
-
-			/* If the new value type does not match the item's type in cache remove it, */
-			/* so it's cached with the correct type from correct tables when accessed   */
-			/* next time.                                                               */
-			/* Also remove item if the value adding failed. In this case we             */
-			/* won't have the latest data in cache - so the requests must go directly   */
-			/* to the database.                                                         */
-			if (item->value_type != h->value_type || item->last_accessed < expire_timestamp ||
-					FAIL == vch_item_add_value_at_head(item, &record))
-			{
-				vc_remove_item(item);
-				continue;
-			}
-
-			/* try to remove old (unused) chunks if a new chunk was added */
-			if (head != item->head)
-				vch_item_clean_cache(item);
-
-		}
+		zbx_free(*str);
+		return FAIL;
 	}
 
-	UNLOCK_CACHE;
+	(*str)[len] = '\0';
 
 	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_get_values                                                *
- *                                                                            *
- * Purpose: get item history data for the specified time period               *
- *                                                                            *
- * Parameters: itemid     - [IN] the item id                                  *
- *             value_type - [IN] the item value type                          *
- *             values     - [OUT] the item history data stored time/value     *
- *                          pairs in descending order                         *
- *             seconds    - [IN] the time period to retrieve data for         *
- *             count      - [IN] the number of history values to retrieve     *
- *             ts         - [IN] the period end timestamp                     *
+ * Function: vc_file_write_value                                              *
  *                                                                            *
- * Return value:  SUCCEED - the item history data was retrieved successfully  *
- *                FAIL    - the item history data was not retrieved           *
+ * Purpose: writes item value to the snapshot file                            *
  *                                                                            *
- * Comments: If the data is not in cache, it's read from DB, so this function *
- *           will always return the requested data, unless some error occurs. *
+ * Parameters: f          - [IN] the snapshot file                            *
+ *             value_type - [IN] the value type                               *
+ *             record     - [IN] the value                                    *
  *                                                                            *
- *           If <count> is set then value range is defined as <count> values  *
- *           before <timestamp>. Otherwise the range is defined as <seconds>  *
- *           seconds before <timestamp>.                                      *
+ * Return value: SUCCEED - the value was written                              *
+ *               FAIL - otherwise                                             *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_get_values(zbx_uint64_t itemid, int value_type, zbx_vector_history_record_t *values, int seconds,
-		int count, const zbx_timespec_t *ts)
+static int	vc_file_write_value(FILE *f, int value_type, const zbx_history_record_t *record)
 {
-	zbx_vc_item_t	*item, new_item;
-	int 		ret = FAIL, cache_used = 1;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d count:%d period:%d end_timestamp"
-			" '%s'", __func__, itemid, value_type, count, seconds, zbx_timespec_str(ts));
-
-	RDLOCK_CACHE;
-
-	if (ZBX_VC_DISABLED == vc_state)
-		goto out;
-
-	if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
-		vc_warn_low_memory();
+	const zbx_log_value_t	*log;
 
-	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
-	{
-		if (ZBX_VC_MODE_NORMAL != vc_cache->mode)
-			goto out;
-
-		memset(&new_item, 0, sizeof(new_item));
-		new_item.itemid = itemid;
-		new_item.value_type = value_type;
-		item = &new_item;
-	}
-	else if (item->value_type != value_type)
-		goto out;
+	if (1 != fwrite(&record->timestamp, sizeof(record->timestamp), 1, f))
+		return FAIL;
 
-	ret = vch_item_get_values(item, values, seconds, count, ts);
-out:
-	if (FAIL == ret)
+	switch (value_type)
 	{
-		cache_used = 0;
+		case ITEM_VALUE_TYPE_FLOAT:
+			return 1 == fwrite(&record->value.dbl, sizeof(record->value.dbl), 1, f) ? SUCCEED : FAIL;
+		case ITEM_VALUE_TYPE_UINT64:
+			return 1 == fwrite(&record->value.ui64, sizeof(record->value.ui64), 1, f) ? SUCCEED : FAIL;
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			return vc_file_write_str(f, record->value.str);
+		case ITEM_VALUE_TYPE_LOG:
+			log = record->value.log;
 
-		UNLOCK_CACHE;
-		ret = vc_db_get_values(itemid, value_type, values, seconds, count, ts);
-		WRLOCK_CACHE;
+			if (1 != fwrite(&log->timestamp, sizeof(log->timestamp), 1, f) ||
+					1 != fwrite(&log->logeventid, sizeof(log->logeventid), 1, f) ||
+					1 != fwrite(&log->severity, sizeof(log->severity), 1, f))
+			{
+				return FAIL;
+			}
 
-		if (ZBX_VC_DISABLED != vc_state)
-			vc_remove_item_by_id(itemid);
+			if (SUCCEED != vc_file_write_str(f, log->source))
+				return FAIL;
 
-		if (SUCCEED == ret)
-			vc_update_statistics(NULL, 0, values->values_num, time(NULL));
+			return vc_file_write_str(f, log->value);
 	}
 
-	UNLOCK_CACHE;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d cached:%d",
-			__func__, zbx_result_string(ret), values->values_num, cache_used);
-
-	return ret;
+	return FAIL;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_get_value                                                 *
- *                                                                            *
- * Purpose: get the last history value with a timestamp less or equal to the  *
- *          target timestamp                                                  *
+ * Function: vc_file_read_value                                               *
  *                                                                            *
- * Parameters: itemid     - [IN] the item id                                  *
- *             value_type - [IN] the item value type                          *
- *             ts         - [IN] the target timestamp                         *
- *             value      - [OUT] the value found                             *
+ * Purpose: reads item value written by vc_file_write_value() function        *
  *                                                                            *
- * Return Value: SUCCEED - the item was retrieved                             *
- *               FAIL    - otherwise                                          *
+ * Parameters: f          - [IN] the snapshot file                            *
+ *             value_type - [IN] the value type                               *
+ *             record     - [OUT] the value                                   *
  *                                                                            *
- * Comments: Depending on the value type this function might allocate memory  *
- *           to store value data. To free it use zbx_vc_history_value_clear() *
- *           function.                                                        *
+ * Return value: SUCCEED - the value was read, string and log values must be  *
+ *                         freed by the caller                                *
+ *               FAIL - the file is truncated or corrupted                    *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_get_value(zbx_uint64_t itemid, int value_type, const zbx_timespec_t *ts, zbx_history_record_t *value)
+static int	vc_file_read_value(FILE *f, int value_type, zbx_history_record_t *record)
 {
-	zbx_vector_history_record_t	values;
-	int				ret = FAIL;
+	zbx_log_value_t	*log;
 
-	zbx_history_record_vector_create(&values);
+	if (1 != fread(&record->timestamp, sizeof(record->timestamp), 1, f))
+		return FAIL;
 
-	if (SUCCEED != zbx_vc_get_values(itemid, value_type, &values, ts->sec, 1, ts) || 0 == values.values_num)
-		goto out;
+	switch (value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			return 1 == fread(&record->value.dbl, sizeof(record->value.dbl), 1, f) ? SUCCEED : FAIL;
+		case ITEM_VALUE_TYPE_UINT64:
+			return 1 == fread(&record->value.ui64, sizeof(record->value.ui64), 1, f) ? SUCCEED : FAIL;
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			if (SUCCEED != vc_file_read_str(f, &record->value.str) || NULL == record->value.str)
+				return FAIL;
 
-	*value = values.values[0];
+			return SUCCEED;
+		case ITEM_VALUE_TYPE_LOG:
+			log = (zbx_log_value_t *)zbx_malloc(NULL, sizeof(zbx_log_value_t));
+			log->source = NULL;
+			log->value = NULL;
+
+			if (1 != fread(&log->timestamp, sizeof(log->timestamp), 1, f) ||
+					1 != fread(&log->logeventid, sizeof(log->logeventid), 1, f) ||
+					1 != fread(&log->severity, sizeof(log->severity), 1, f) ||
+					SUCCEED != vc_file_read_str(f, &log->source) ||
+					SUCCEED != vc_file_read_str(f, &log->value) || NULL == log->value)
+			{
+				vc_history_logfree(log);
+				return FAIL;
+			}
 
-	/* reset values vector size so the returned value is not cleared when destroying the vector */
-	values.values_num = 0;
+			record->value.log = log;
 
-	ret = SUCCEED;
-out:
-	zbx_history_record_vector_destroy(&values, value_type);
+			return SUCCEED;
+	}
 
-	return ret;
+	return FAIL;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_get_statistics                                            *
+ * Function: vc_file_write_item                                               *
  *                                                                            *
- * Purpose: retrieves usage cache statistics                                  *
+ * Purpose: writes item with its cached values to the snapshot file           *
  *                                                                            *
- * Parameters: stats     - [OUT] the cache usage statistics                   *
+ * Parameters: f    - [IN] the snapshot file                                  *
+ *             item - [IN] the item                                           *
  *                                                                            *
- * Return value:  SUCCEED - the cache statistics were retrieved successfully  *
- *                FAIL    - failed to retrieve cache statistics               *
- *                          (cache was not initialized)                       *
+ * Return value: SUCCEED - the item was written                               *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ * Comments: The values are written from the oldest to the newest, so they    *
+ *           can be added to the item cache at tail when loading.             *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_get_statistics(zbx_vc_stats_t *stats)
+static int	vc_file_write_item(FILE *f, const zbx_vc_item_t *item)
 {
-	if (ZBX_VC_DISABLED == vc_state)
-		return FAIL;
+	zbx_vc_file_item_t	record;
+	const zbx_vc_chunk_t	*chunk;
+	int			i;
 
-	RDLOCK_CACHE;
+	memset(&record, 0, sizeof(record));
+	record.itemid = item->itemid;
+	record.value_type = item->value_type;
+	record.status = item->status;
+	record.active_range = item->active_range;
+	record.daily_range = item->daily_range;
+	record.db_cached_from = item->db_cached_from;
+	record.last_accessed = item->last_accessed;
 
-	stats->hits = vc_cache->hits;
-	stats->misses = vc_cache->misses;
-	stats->mode = vc_cache->mode;
+	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
+		record.values_num += chunk->last_value - chunk->first_value + 1;
 
-	stats->total_size = vc_mem->total_size;
-	stats->free_size = vc_mem->free_size;
+	if (1 != fwrite(&record, sizeof(record), 1, f))
+		return FAIL;
 
-	UNLOCK_CACHE;
+	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
+	{
+		const zbx_history_record_t	*slots;
+
+		slots = vch_chunk_get_slots(chunk);
+
+		for (i = chunk->first_value; i <= chunk->last_value; i++)
+		{
+			if (SUCCEED != vc_file_write_value(f, item->value_type, &slots[i]))
+				return FAIL;
+		}
+	}
 
 	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_enable                                                    *
+ * Function: vc_load_item                                                     *
  *                                                                            *
- * Purpose: enables value caching for current process                         *
+ * Purpose: adds item read from snapshot file to the value cache              *
+ *                                                                            *
+ * Parameters: record - [IN] the item                                         *
+ *             values - [IN] the item values in ascending order               *
+ *                                                                            *
+ * Return value: SUCCEED - the item was added                                 *
+ *               FAIL - the item is already cached or there is not enough     *
+ *                      memory                                                *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_enable(void)
+static int	vc_load_item(const zbx_vc_file_item_t *record, const zbx_vector_history_record_t *values)
 {
-	if (NULL != vc_cache)
-		vc_state = ZBX_VC_ENABLED;
+	zbx_vc_item_t	*item, new_item;
+	int		ret = FAIL;
+
+	vc_select_item_stripe(record->itemid);
+
+	WRLOCK_CACHE;
+
+	if (NULL != zbx_hashset_search(&vc_cache->items, &record->itemid))
+		goto out;
+
+	memset(&new_item, 0, sizeof(new_item));
+	new_item.itemid = record->itemid;
+	new_item.value_type = record->value_type;
+
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item, sizeof(new_item))))
+		goto out;
+
+	if (0 != values->values_num && SUCCEED != vch_item_add_values_at_tail(item, values->values,
+			values->values_num))
+	{
+		vc_remove_item(item);
+		goto out;
+	}
+
+	item->status = record->status;
+	item->active_range = record->active_range;
+	item->daily_range = record->daily_range;
+	item->db_cached_from = record->db_cached_from;
+	item->last_accessed = record->last_accessed;
+
+	ret = SUCCEED;
+out:
+	UNLOCK_CACHE;
+
+	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_disable                                                   *
- *                                                                            *
- * Purpose: disables value caching for current process                        *
+ * Function: vc_file_load_item_free                                           *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_disable(void)
+static void	vc_file_load_item_free(zbx_vc_file_load_item_t *item)
 {
-	vc_state = ZBX_VC_DISABLED;
+	vc_history_record_vector_clean(&item->values, item->record.value_type);
+	zbx_vector_history_record_destroy(&item->values);
+	zbx_free(item);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_hc_get_diag_stats                                            *
+ * Function: vc_load_items                                                    *
  *                                                                            *
- * Purpose: get value cache diagnostic statistics                             *
+ * Purpose: adds a batch of items read from snapshot file to the value cache  *
+ *                                                                            *
+ * Parameters: items - [IN/OUT] the items to add, the vector is cleared       *
+ *             clock - [IN] the snapshot creation time                        *
+ *                                                                            *
+ * Return value: the number of added items                                    *
+ *                                                                            *
+ * Comments: Items having values newer than the snapshot in history storage   *
+ *           are dropped. History storage is checked with one request per     *
+ *           value type for the whole batch.                                  *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, int *mode)
+static int	vc_load_items(zbx_vector_ptr_t *items, int clock)
 {
-	zbx_hashset_iter_t	iter;
-	zbx_vc_item_t		*item;
+	zbx_vector_uint64_t	itemids, stale_itemids;
+	zbx_vc_file_load_item_t	*item;
+	int			i, value_type, loaded = 0;
 
-	*values_num = 0;
+	zbx_vector_uint64_create(&itemids);
+	zbx_vector_uint64_create(&stale_itemids);
 
-	if (ZBX_VC_DISABLED == vc_state)
+	for (value_type = 0; value_type < ITEM_VALUE_TYPE_MAX; value_type++)
 	{
-		*items_num = 0;
-		*mode = -1;
-		return;
-	}
+		zbx_vector_uint64_clear(&itemids);
 
-	RDLOCK_CACHE;
+		for (i = 0; i < items->values_num; i++)
+		{
+			item = (zbx_vc_file_load_item_t *)items->values[i];
 
-	*items_num = vc_cache->items.num_data;
-	*mode = vc_cache->mode;
+			if (item->record.value_type == value_type)
+				zbx_vector_uint64_append(&itemids, item->record.itemid);
+		}
 
-	zbx_hashset_iter_reset(&vc_cache->items, &iter);
-	while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
-		*values_num += item->values_total;
+		if (0 == itemids.values_num)
+			continue;
 
-	UNLOCK_CACHE;
-}
+		/* items that cannot be checked are dropped */
+		if (SUCCEED != zbx_history_get_updated_itemids(value_type, &itemids, clock, &stale_itemids))
+			zbx_vector_uint64_append_array(&stale_itemids, itemids.values, itemids.values_num);
+	}
 
-/******************************************************************************
- *                                                                            *
- * Function: zbx_hc_get_mem_stats                                             *
- *                                                                            *
- * Purpose: get value cache shared memory statistics                          *
- *                                                                            *
- ******************************************************************************/
-void	zbx_vc_get_mem_stats(zbx_mem_stats_t *mem)
-{
-	if (ZBX_VC_DISABLED == vc_state)
+	zbx_vector_uint64_sort(&stale_itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (i = 0; i < items->values_num; i++)
 	{
-		memset(mem, 0, sizeof(zbx_mem_stats_t));
-		return;
+		item = (zbx_vc_file_load_item_t *)items->values[i];
+
+		if (FAIL != zbx_vector_uint64_bsearch(&stale_itemids, item->record.itemid,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+		{
+			continue;
+		}
+
+		if (SUCCEED == vc_load_item(&item->record, &item->values))
+			loaded++;
 	}
 
-	RDLOCK_CACHE;
-	zbx_mem_get_stats(vc_mem, mem);
-	UNLOCK_CACHE;
+	zbx_vector_ptr_clear_ext(items, (zbx_clean_func_t)vc_file_load_item_free);
+	zbx_vector_uint64_destroy(&stale_itemids);
+	zbx_vector_uint64_destroy(&itemids);
+
+	return loaded;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_get_item_stats                                            *
+ * Function: zbx_vc_save                                                      *
  *                                                                            *
- * Purpose: get statistics of cached items                                    *
+ * Purpose: write value cache contents to the snapshot file                   *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the cache was saved or snapshot file is not        *
+ *                         configured                                         *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ * Comments: The value cache contains only values already written to history  *
+ *           storage, so the snapshot can be saved after history syncers have *
+ *           been stopped. The snapshot is written to temporary file and      *
+ *           renamed to the target file.                                      *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_get_item_stats(zbx_vector_ptr_t *stats)
+int	zbx_vc_save(char **error)
 {
-	zbx_hashset_iter_t	iter;
+	FILE			*f;
+	char			*tmp_path;
+	zbx_vc_file_header_t	header;
 	zbx_vc_item_t		*item;
-	zbx_vc_item_stats_t	*item_stats;
+	zbx_hashset_iter_t	iter;
+	int			i, ret = FAIL;
 
-	if (ZBX_VC_DISABLED == vc_state)
-		return;
+	if (NULL == vc_cache || NULL == CONFIG_VALUE_CACHE_FILE)
+		return SUCCEED;
 
-	RDLOCK_CACHE;
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_vector_ptr_reserve(stats, vc_cache->items.num_data);
+	tmp_path = zbx_dsprintf(NULL, "%s.tmp", CONFIG_VALUE_CACHE_FILE);
 
-	zbx_hashset_iter_reset(&vc_cache->items, &iter);
-	while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+	if (NULL == (f = fopen(tmp_path, "wb")))
 	{
-		item_stats = (zbx_vc_item_stats_t *)zbx_malloc(NULL, sizeof(zbx_vc_item_stats_t));
-		item_stats->itemid = item->itemid;
-		item_stats->values_num = item->values_total;
-		item_stats->hourly_num = item->last_hourly_num;
-		zbx_vector_ptr_append(stats, item_stats);
+		*error = zbx_dsprintf(*error, "cannot open file \"%s\": %s", tmp_path, zbx_strerror(errno));
+		goto out;
 	}
 
-	UNLOCK_CACHE;
+	memset(&header, 0, sizeof(header));
+	zbx_strlcpy(header.magic, ZBX_VC_FILE_MAGIC, sizeof(header.magic));
+	header.version = ZBX_VC_FILE_VERSION;
+	header.clock = (int)time(NULL);
+
+	/* the header is rewritten with the number of items when all items are written */
+	if (1 != fwrite(&header, sizeof(header), 1, f))
+		goto close;
+
+	for (i = 0; i < vc_stripes_num; i++)
+	{
+		vc_select_stripe(i);
+
+		RDLOCK_CACHE;
+
+		zbx_hashset_iter_reset(&vc_cache->items, &iter);
+		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (SUCCEED != vc_file_write_item(f, item))
+				break;
+
+			header.items_num++;
+		}
+
+		UNLOCK_CACHE;
+
+		if (NULL != item)
+			goto close;
+	}
+
+	if (0 != fseek(f, 0, SEEK_SET) || 1 != fwrite(&header, sizeof(header), 1, f))
+		goto close;
+
+	ret = SUCCEED;
+close:
+	if (0 != fclose(f))
+		ret = FAIL;
+
+	if (SUCCEED != ret)
+	{
+		*error = zbx_dsprintf(*error, "cannot write file \"%s\": %s", tmp_path, zbx_strerror(errno));
+		unlink(tmp_path);
+		goto out;
+	}
+
+	if (0 != rename(tmp_path, CONFIG_VALUE_CACHE_FILE))
+	{
+		*error = zbx_dsprintf(*error, "cannot rename file \"%s\" to \"%s\": %s", tmp_path,
+				CONFIG_VALUE_CACHE_FILE, zbx_strerror(errno));
+		unlink(tmp_path);
+		ret = FAIL;
+		goto out;
+	}
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "saved %u value cache items to \"%s\"", header.items_num,
+			CONFIG_VALUE_CACHE_FILE);
+out:
+	zbx_free(tmp_path);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_flush_stats                                               *
+ * Function: zbx_vc_load                                                      *
  *                                                                            *
- * Purpose: flush locally cached statistics                                   *
+ * Purpose: warm up value cache from the snapshot file                        *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the cache was loaded or there is no snapshot file  *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ * Comments: The snapshot file is removed after loading, so a snapshot left   *
+ *           by a crashed server is never reused.                             *
+ *           Items having values newer than the snapshot in history storage,  *
+ *           for example written by another HA node, are dropped. This        *
+ *           function must be called before history syncers are started and   *
+ *           requires database connection when history is stored in database. *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_flush_stats(void)
+int	zbx_vc_load(char **error)
 {
-	int		i, now;
-	zbx_vc_item_t	*item = NULL;
-	zbx_uint64_t	itemid = 0;
+	FILE			*f;
+	zbx_vc_file_header_t	header;
+	zbx_vc_file_item_t	record;
+	zbx_vc_file_load_item_t	*item;
+	zbx_vector_ptr_t	items;
+	zbx_uint32_t		i, loaded = 0;
+	int			j, ret = FAIL;
 
-	if (ZBX_VC_DISABLED == vc_state || 0 == vc_itemupdates.values_num)
-		return;
+	if (NULL == vc_cache || NULL == CONFIG_VALUE_CACHE_FILE)
+		return SUCCEED;
 
-	zbx_vector_vc_itemupdate_sort(&vc_itemupdates, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	now = time(NULL);
+	if (NULL == (f = fopen(CONFIG_VALUE_CACHE_FILE, "rb")))
+	{
+		if (ENOENT == errno)
+		{
+			ret = SUCCEED;
+		}
+		else
+		{
+			*error = zbx_dsprintf(*error, "cannot open file \"%s\": %s", CONFIG_VALUE_CACHE_FILE,
+					zbx_strerror(errno));
+		}
 
-	WRLOCK_CACHE;
+		goto out;
+	}
+
+	zbx_vector_ptr_create(&items);
+	zbx_vector_ptr_reserve(&items, ZBX_VC_FILE_LOAD_BATCH_SIZE);
+
+	if (1 != fread(&header, sizeof(header), 1, f) ||
+			0 != strncmp(header.magic, ZBX_VC_FILE_MAGIC, sizeof(header.magic)))
+	{
+		*error = zbx_dsprintf(*error, "file \"%s\" is not a value cache snapshot", CONFIG_VALUE_CACHE_FILE);
+		goto close;
+	}
 
-	for (i = 0; i < vc_itemupdates.values_num; i++)
+	if (ZBX_VC_FILE_VERSION != header.version)
 	{
-		zbx_vc_item_update_t	*update = &vc_itemupdates.values[i];
+		*error = zbx_dsprintf(*error, "unsupported value cache snapshot version %u", header.version);
+		goto close;
+	}
 
-		if (itemid != update->itemid)
+	for (i = 0; i < header.items_num; i++)
+	{
+		if (1 != fread(&record, sizeof(record), 1, f) || ITEM_VALUE_TYPE_MAX <= record.value_type ||
+				0 > record.values_num)
 		{
-			itemid = update->itemid;
-			item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid);
+			goto truncated;
 		}
 
-		if (NULL == item)
-			continue;
+		item = (zbx_vc_file_load_item_t *)zbx_malloc(NULL, sizeof(zbx_vc_file_load_item_t));
+		item->record = record;
+		zbx_history_record_vector_create(&item->values);
+		zbx_vector_ptr_append(&items, item);
 
-		switch (update->type)
+		for (j = 0; j < record.values_num; j++)
 		{
-			case ZBX_VC_UPDATE_RANGE:
-				vch_item_update_range(item, update->data[ZBX_VC_UPDATE_RANGE_SECONDS],
-						update->data[ZBX_VC_UPDATE_RANGE_NOW]);
-				break;
-			case ZBX_VC_UPDATE_STATS:
-				vc_update_statistics(item, update->data[ZBX_VC_UPDATE_STATS_HITS],
-						update->data[ZBX_VC_UPDATE_STATS_MISSES], now);
-				break;
+			zbx_history_record_t	value;
+
+			if (SUCCEED != vc_file_read_value(f, record.value_type, &value))
+				goto truncated;
+
+			zbx_vector_history_record_append_ptr(&item->values, &value);
 		}
+
+		if (ZBX_VC_FILE_LOAD_BATCH_SIZE == items.values_num)
+			loaded += (zbx_uint32_t)vc_load_items(&items, header.clock);
 	}
 
-	UNLOCK_CACHE;
+	loaded += (zbx_uint32_t)vc_load_items(&items, header.clock);
+	ret = SUCCEED;
 
-	zbx_vector_vc_itemupdate_clear(&vc_itemupdates);
+	zabbix_log(LOG_LEVEL_INFORMATION, "loaded %u of %u value cache items from \"%s\"", loaded, header.items_num,
+			CONFIG_VALUE_CACHE_FILE);
+	goto close;
+truncated:
+	*error = zbx_dsprintf(*error, "file \"%s\" is truncated or corrupted", CONFIG_VALUE_CACHE_FILE);
+close:
+	zbx_vector_ptr_clear_ext(&items, (zbx_clean_func_t)vc_file_load_item_free);
+	zbx_vector_ptr_destroy(&items);
+
+	fclose(f);
+
+	if (0 != unlink(CONFIG_VALUE_CACHE_FILE))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot remove file \"%s\": %s", CONFIG_VALUE_CACHE_FILE,
+				zbx_strerror(errno));
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
 }
 
 #ifdef HAVE_TESTS
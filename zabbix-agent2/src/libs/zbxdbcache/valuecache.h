@@ -38,6 +38,12 @@
  *   function. To ensure proper removal of shared memory the value cache must be destroyed
  *   upon a program exit with zbx_vc_destroy() function.
  *
+ * Snapshot
+ *
+ *   When snapshot file is configured the cache contents are saved with zbx_vc_save() function
+ *   before the cache is destroyed and loaded with zbx_vc_load() function before history syncers
+ *   are started. Items having values in history storage newer than the snapshot are dropped.
+ *
  * Adding data
  *
  *   Whenever a new item value is added to system (history tables) the item value must be
@@ -50,12 +56,26 @@
  *   either zbx_history_record_vector_destroy() function (free the zbx_vc_get_values()
  *   call output) or zbx_history_record_clear() function (free the zbx_vc_get_value() call output).
  *
+ * Aggregates
+ *
+ *   Time based sum, count, average, minimum and maximum of numeric items can be retrieved
+ *   with zbx_vc_get_aggregate() function. The first request registers a sliding window
+ *   which is afterwards updated incrementally when new values are added to cache, so the
+ *   following requests do not need to scan the values. If the window cannot be used the
+ *   function fails and the caller must fall back to zbx_vc_get_values().
+ *   Windows are used only when enabled with ValueCacheAggregates parameter, otherwise
+ *   zbx_vc_get_aggregate() always fails and the values are scanned by the caller.
+ *
  * Locking
  *
  *   The cache ensures synchronization between processes by using automatic locks whenever
  *   a cache function (zbx_vc_*) is called and by providing manual cache locking functionality
  *   with zbx_vc_lock()/zbx_vc_unlock() functions.
  *
+ *   Large caches are split into stripes by item id. Each stripe has its own shared memory,
+ *   string pool and lock, so only processes accessing items in the same stripe are
+ *   serialized. Cache wide operations (housekeeping, statistics) lock the stripes one by one.
+ *
  */
 
 #define ZBX_VC_MODE_NORMAL	0
@@ -78,6 +98,10 @@ typedef struct
 	zbx_uint64_t	total_size;
 	zbx_uint64_t	free_size;
 
+	/* the ratio of numeric value chunk sizes before and after packing, */
+	/* 1 if there are no packed chunks                                 */
+	double		compression_ratio;
+
 	/* value cache operating mode - see ZBX_VC_MODE_* defines */
 	int		mode;
 }
@@ -92,6 +116,30 @@ typedef struct
 }
 zbx_vc_item_stats_t;
 
+/* sliding window aggregate flags, see zbx_vc_get_aggregate() */
+#define ZBX_VC_AGGREGATE_SUM	0x01
+#define ZBX_VC_AGGREGATE_MIN	0x02
+#define ZBX_VC_AGGREGATE_MAX	0x04
+
+/* the sliding window aggregate values */
+typedef struct
+{
+	/* the number of values in window */
+	int		values_num;
+
+	/* the values sum (ZBX_VC_AGGREGATE_SUM) */
+	history_value_t	sum;
+
+	/* the values average (ZBX_VC_AGGREGATE_SUM), valid if there are values in window */
+	double		avg;
+
+	/* the minimum and maximum values (ZBX_VC_AGGREGATE_MIN, ZBX_VC_AGGREGATE_MAX), */
+	/* valid if there are values in window                                          */
+	history_value_t	min;
+	history_value_t	max;
+}
+zbx_vc_aggregate_t;
+
 int	zbx_vc_init(char **error);
 
 void	zbx_vc_destroy(void);
@@ -102,11 +150,17 @@ void	zbx_vc_enable(void);
 
 void	zbx_vc_disable(void);
 
+int	zbx_vc_save(char **error);
+int	zbx_vc_load(char **error);
+
 int	zbx_vc_get_values(zbx_uint64_t itemid, int value_type, zbx_vector_history_record_t *values, int seconds,
 		int count, const zbx_timespec_t *ts);
 
 int	zbx_vc_get_value(zbx_uint64_t itemid, int value_type, const zbx_timespec_t *ts, zbx_history_record_t *value);
 
+int	zbx_vc_get_aggregate(zbx_uint64_t itemid, int value_type, int seconds, const zbx_timespec_t *ts, int flags,
+		zbx_vc_aggregate_t *aggregate);
+
 int	zbx_vc_add_values(zbx_vector_ptr_t *history, int *ret_flush);
 
 int	zbx_vc_get_statistics(zbx_vc_stats_t *stats);
@@ -300,6 +300,43 @@ int	DBcommit(void)
 	return zbx_db_txn_end_error();
 }
 
+#ifdef HAVE_POSTGRESQL
+/******************************************************************************
+ *                                                                            *
+ * Function: DBcommit_send                                                    *
+ *                                                                            *
+ * Purpose: start committing a transaction                                    *
+ *                                                                            *
+ * Comments: The commit errors are reported by DBcommit_result(), which must  *
+ *           be called before executing any other query.                      *
+ *                                                                            *
+ ******************************************************************************/
+void	DBcommit_send(void)
+{
+	zbx_db_commit_send();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DBcommit_result                                                  *
+ *                                                                            *
+ * Purpose: finish committing a transaction started by DBcommit_send()        *
+ *                                                                            *
+ * Return value: the same as DBcommit()                                       *
+ *                                                                            *
+ ******************************************************************************/
+int	DBcommit_result(void)
+{
+	if (ZBX_DB_OK > zbx_db_commit_result())
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "commit failed, doing a rollback instead");
+		DBrollback();
+	}
+
+	return zbx_db_txn_end_error();
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: DBrollback                                                       *
@@ -2826,38 +2863,29 @@ void	zbx_db_insert_prepare_dyn(zbx_db_insert_t *self, const ZBX_TABLE *table, co
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_db_insert_prepare                                            *
+ * Function: db_get_table_fields                                              *
  *                                                                            *
- * Purpose: prepare for database bulk insert operation                        *
+ * Purpose: find table and fields in database schema                          *
  *                                                                            *
- * Parameters: self  - [IN] the bulk insert data                              *
- *             table - [IN] the target table name                             *
- *             ...   - [IN] names of the fields to insert                     *
- *             NULL  - [IN] terminating NULL pointer                          *
+ * Parameters: table  - [IN] the table name                                   *
+ *             args   - [IN] names of the fields, terminated by NULL pointer  *
+ *             fields - [OUT] the fields (pointers to ZBX_FIELD structures)   *
  *                                                                            *
- * Comments: This is a convenience wrapper for zbx_db_insert_prepare_dyn()    *
- *           function.                                                        *
+ * Return value: the table                                                    *
  *                                                                            *
  ******************************************************************************/
-void	zbx_db_insert_prepare(zbx_db_insert_t *self, const char *table, ...)
+static const ZBX_TABLE	*db_get_table_fields(const char *table, va_list args, zbx_vector_ptr_t *fields)
 {
-	zbx_vector_ptr_t	fields;
-	va_list			args;
-	char			*field;
-	const ZBX_TABLE		*ptable;
-	const ZBX_FIELD		*pfield;
+	char		*field;
+	const ZBX_TABLE	*ptable;
+	const ZBX_FIELD	*pfield;
 
-	/* find the table and fields in database schema */
 	if (NULL == (ptable = DBget_table(table)))
 	{
 		THIS_SHOULD_NEVER_HAPPEN;
 		exit(EXIT_FAILURE);
 	}
 
-	va_start(args, table);
-
-	zbx_vector_ptr_create(&fields);
-
 	while (NULL != (field = va_arg(args, char *)))
 	{
 		if (NULL == (pfield = DBget_field(ptable, field)))
@@ -2867,9 +2895,37 @@ void	zbx_db_insert_prepare(zbx_db_insert_t *self, const char *table, ...)
 			THIS_SHOULD_NEVER_HAPPEN;
 			exit(EXIT_FAILURE);
 		}
-		zbx_vector_ptr_append(&fields, (ZBX_FIELD *)pfield);
+		zbx_vector_ptr_append(fields, (ZBX_FIELD *)pfield);
 	}
 
+	return ptable;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_insert_prepare                                            *
+ *                                                                            *
+ * Purpose: prepare for database bulk insert operation                        *
+ *                                                                            *
+ * Parameters: self  - [IN] the bulk insert data                              *
+ *             table - [IN] the target table name                             *
+ *             ...   - [IN] names of the fields to insert                     *
+ *             NULL  - [IN] terminating NULL pointer                          *
+ *                                                                            *
+ * Comments: This is a convenience wrapper for zbx_db_insert_prepare_dyn()    *
+ *           function.                                                        *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_db_insert_prepare(zbx_db_insert_t *self, const char *table, ...)
+{
+	zbx_vector_ptr_t	fields;
+	va_list			args;
+	const ZBX_TABLE		*ptable;
+
+	zbx_vector_ptr_create(&fields);
+
+	va_start(args, table);
+	ptable = db_get_table_fields(table, args, &fields);
 	va_end(args);
 
 	zbx_db_insert_prepare_dyn(self, ptable, (const ZBX_FIELD **)fields.values, fields.values_num);
@@ -3276,6 +3332,315 @@ void	zbx_db_insert_autoincrement(zbx_db_insert_t *self, const char *field_name)
 	exit(EXIT_FAILURE);
 }
 
+#ifdef HAVE_POSTGRESQL
+/* PostgreSQL binary copy format signature, followed by flags and header extension length fields */
+#define ZBX_DB_COPY_SIGNATURE		"PGCOPY\n\377\r\n"
+#define ZBX_DB_COPY_SIGNATURE_LEN	11
+
+/******************************************************************************
+ *                                                                            *
+ * Function: db_copy_reserve                                                  *
+ *                                                                            *
+ * Purpose: ensure that copy data buffer has space for the specified number   *
+ *          of bytes                                                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_copy_reserve(zbx_db_copy_t *self, size_t size)
+{
+	if (self->data_offset + size <= self->data_alloc)
+		return;
+
+	while (self->data_offset + size > self->data_alloc)
+		self->data_alloc *= 2;
+
+	self->data = (char *)zbx_realloc(self->data, self->data_alloc);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: db_copy_add_uint                                                 *
+ *                                                                            *
+ * Purpose: add unsigned integer of the specified size in network byte order  *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_copy_add_uint(zbx_db_copy_t *self, zbx_uint64_t value, int size)
+{
+	db_copy_reserve(self, (size_t)size);
+
+	while (0 < size--)
+		self->data[self->data_offset++] = (char)(value >> (size * 8));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: db_copy_add_bytes                                                *
+ *                                                                            *
+ * Purpose: add field with the specified binary value                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_copy_add_bytes(zbx_db_copy_t *self, const char *data, size_t size)
+{
+	db_copy_add_uint(self, size, 4);
+	db_copy_reserve(self, size);
+	memcpy(self->data + self->data_offset, data, size);
+	self->data_offset += size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: db_copy_add_numeric                                              *
+ *                                                                            *
+ * Purpose: add unsigned integer value of numeric field                       *
+ *                                                                            *
+ * Comments: The numeric value is sent as the number of base 10000 digits,    *
+ *           weight of the first digit, sign, display scale and the digits    *
+ *           starting with the most significant one. Trailing zero digits are *
+ *           omitted like PostgreSQL does itself.                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_copy_add_numeric(zbx_db_copy_t *self, zbx_uint64_t value)
+{
+	int	digits[5], digits_num = 0, weight = 0;	/* 64 bit integer fits in 5 base 10000 digits */
+
+	for (; 0 != value; value /= 10000)
+	{
+		if (0 != digits_num || 0 != value % 10000)
+			digits[digits_num++] = (int)(value % 10000);
+
+		if (10000 <= value)
+			weight++;
+	}
+
+	db_copy_add_uint(self, 8 + (zbx_uint64_t)digits_num * 2, 4);
+	db_copy_add_uint(self, (zbx_uint64_t)digits_num, 2);
+	db_copy_add_uint(self, (zbx_uint64_t)weight, 2);
+	db_copy_add_uint(self, 0, 2);
+	db_copy_add_uint(self, 0, 2);
+
+	while (0 < digits_num--)
+		db_copy_add_uint(self, (zbx_uint64_t)digits[digits_num], 2);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: db_copy_add_str                                                  *
+ *                                                                            *
+ * Purpose: add string value truncated to the field length                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_copy_add_str(zbx_db_copy_t *self, const ZBX_FIELD *field, const char *str)
+{
+	size_t	length;
+
+	if (ZBX_TYPE_LONGTEXT == field->type && 0 == field->length)
+		length = ZBX_SIZE_T_MAX;
+	else if (ZBX_TYPE_CUID == field->type)
+		length = CUID_LEN;
+	else
+		length = field->length;
+
+	db_copy_add_bytes(self, str, zbx_strlen_utf8_nchars(str, length));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_copy_prepare                                              *
+ *                                                                            *
+ * Purpose: prepare for database bulk load operation                          *
+ *                                                                            *
+ * Parameters: self  - [IN] the bulk load data                                *
+ *             table - [IN] the target table name                             *
+ *             ...   - [IN] names of the fields to load                       *
+ *             NULL  - [IN] terminating NULL pointer                          *
+ *                                                                            *
+ * Comments: Bulk load uses PostgreSQL copy from stdin statement with data    *
+ *           in binary format. The values are encoded when added, so unlike   *
+ *           bulk insert no SQL text is formatted and parsed for each row.    *
+ *           The binary format requires exact column types, so float fields   *
+ *           can be loaded only into double precision columns.                *
+ *                                                                            *
+ *           Usage example:                                                   *
+ *             zbx_db_copy_t copy;                                            *
+ *                                                                            *
+ *             zbx_db_copy_prepare(&copy, "history", "value", NULL);          *
+ *             zbx_db_copy_add_values(&copy, 1.0);                            *
+ *               ...                                                          *
+ *             zbx_db_copy_execute(&copy);                                    *
+ *             zbx_db_copy_clean(&copy);                                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_db_copy_prepare(zbx_db_copy_t *self, const char *table, ...)
+{
+	va_list	args;
+
+	zbx_vector_ptr_create(&self->fields);
+
+	va_start(args, table);
+	self->table = db_get_table_fields(table, args, &self->fields);
+	va_end(args);
+
+	if (0 == self->fields.values_num)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		exit(EXIT_FAILURE);
+	}
+
+	self->data_alloc = 16 * ZBX_KIBIBYTE;
+	self->data_offset = 0;
+	self->data = (char *)zbx_malloc(NULL, self->data_alloc);
+	self->rows_num = 0;
+
+	/* the signature contains zero byte, so it's copied with header fields */
+	db_copy_reserve(self, ZBX_DB_COPY_SIGNATURE_LEN);
+	memcpy(self->data, ZBX_DB_COPY_SIGNATURE, ZBX_DB_COPY_SIGNATURE_LEN);
+	self->data_offset = ZBX_DB_COPY_SIGNATURE_LEN;
+
+	db_copy_add_uint(self, 0, 4);
+	db_copy_add_uint(self, 0, 4);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_copy_add_values                                           *
+ *                                                                            *
+ * Purpose: adds row values for database bulk load operation                  *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk load data                                 *
+ *             ...  - [IN] the values to load                                 *
+ *                                                                            *
+ * Comments: The values must be listed in the same order as the field names   *
+ *           for zbx_db_copy_prepare() function and their types must conform  *
+ *           to the corresponding field types.                                *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_db_copy_add_values(zbx_db_copy_t *self, ...)
+{
+	va_list			args;
+	int			i;
+	const ZBX_FIELD		*field;
+	zbx_uint64_t		value_ui64;
+	double			value_dbl;
+
+	va_start(args, self);
+
+	db_copy_add_uint(self, (zbx_uint64_t)self->fields.values_num, 2);
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		field = (const ZBX_FIELD *)self->fields.values[i];
+
+		switch (field->type)
+		{
+			case ZBX_TYPE_CHAR:
+			case ZBX_TYPE_TEXT:
+			case ZBX_TYPE_SHORTTEXT:
+			case ZBX_TYPE_LONGTEXT:
+			case ZBX_TYPE_CUID:
+				db_copy_add_str(self, field, va_arg(args, char *));
+				break;
+			case ZBX_TYPE_INT:
+				db_copy_add_uint(self, 4, 4);
+				db_copy_add_uint(self, (zbx_uint32_t)va_arg(args, int), 4);
+				break;
+			case ZBX_TYPE_FLOAT:
+				value_dbl = va_arg(args, double);
+				memcpy(&value_ui64, &value_dbl, sizeof(value_ui64));
+				db_copy_add_uint(self, 8, 4);
+				db_copy_add_uint(self, value_ui64, 8);
+				break;
+			case ZBX_TYPE_UINT:
+				db_copy_add_numeric(self, va_arg(args, zbx_uint64_t));
+				break;
+			case ZBX_TYPE_ID:
+				db_copy_add_uint(self, 8, 4);
+				db_copy_add_uint(self, va_arg(args, zbx_uint64_t), 8);
+				break;
+			default:
+				THIS_SHOULD_NEVER_HAPPEN;
+				exit(EXIT_FAILURE);
+		}
+	}
+
+	va_end(args);
+
+	self->rows_num++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_copy_execute                                              *
+ *                                                                            *
+ * Purpose: executes the prepared database bulk load operation                *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk load data                                 *
+ *                                                                            *
+ * Return value: Returns SUCCEED if the operation completed successfully or   *
+ *               FAIL otherwise.                                              *
+ *                                                                            *
+ * Comments: The operation can be executed again, for example, when the       *
+ *           transaction must be repeated after database connection was lost. *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_copy_execute(zbx_db_copy_t *self)
+{
+	char	*sql = NULL, delim = '(';
+	size_t	sql_alloc = 0, sql_offset = 0;
+	int	i, rc;
+
+	if (0 == self->rows_num)
+		return SUCCEED;
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "copy %s ", self->table->table);
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, delim);
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ((const ZBX_FIELD *)self->fields.values[i])->name);
+		delim = ',';
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") from stdin (format binary)");
+
+	/* add trailer, it's removed afterwards so more rows can be added or the data sent again */
+	db_copy_add_uint(self, 0xffff, 2);
+
+	rc = zbx_db_copy_from(sql, self->data, self->data_offset);
+
+	while (ZBX_DB_DOWN == rc)
+	{
+		DBclose();
+		DBconnect(ZBX_DB_CONNECT_NORMAL);
+
+		if (ZBX_DB_DOWN == (rc = zbx_db_copy_from(sql, self->data, self->data_offset)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "database is down: retrying in %d seconds", ZBX_DB_WAIT_DOWN);
+			connection_failure = 1;
+			sleep(ZBX_DB_WAIT_DOWN);
+		}
+	}
+
+	self->data_offset -= 2;
+	zbx_free(sql);
+
+	return ZBX_DB_OK <= rc ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_copy_clean                                                *
+ *                                                                            *
+ * Purpose: releases resources allocated by bulk load operation               *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk load data                                 *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_db_copy_clean(zbx_db_copy_t *self)
+{
+	zbx_free(self->data);
+	zbx_vector_ptr_destroy(&self->fields);
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_db_get_database_type                                         *
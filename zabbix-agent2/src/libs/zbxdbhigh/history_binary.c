@@ -0,0 +1,589 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "base64.h"
+#include "proxy.h"
+
+#include "history_binary.h"
+
+/* Binary history data is a compact alternative to the proxy history data JSON array. It is sent as base64    */
+/* string and consists of header and columns:                                                                 */
+/*   header - format version, number of records and the byte size of every column                             */
+/*   id     - record identifier difference from the previous record identifier                                */
+/*   itemid - item identifier                                                                                 */
+/*   clock  - value timestamp seconds difference from the previous record timestamp seconds                   */
+/*   ns     - value timestamp nanoseconds                                                                     */
+/*   flags  - one byte per record, defining the record state and which of the following columns it has        */
+/*   meta   - lastlogsize and mtime of log records                                                            */
+/*   log    - log timestamp, source, severity and event identifier, only the ones set                         */
+/*   uint   - values that are unsigned integers in canonical text form                                        */
+/*   string - other values                                                                                    */
+/* Integers are stored in base 128 variable length encoding, signed differences are zigzag encoded first.     */
+/* Strings are stored as their length followed by the string bytes.                                           */
+
+#define ZBX_HB_FLAG_NOTSUPPORTED	0x01
+#define ZBX_HB_FLAG_STRING		0x02
+#define ZBX_HB_FLAG_UINT		0x04
+#define ZBX_HB_FLAG_META		0x08
+#define ZBX_HB_FLAG_TIMESTAMP		0x10
+#define ZBX_HB_FLAG_SOURCE		0x20
+#define ZBX_HB_FLAG_SEVERITY		0x40
+#define ZBX_HB_FLAG_LOGEVENTID		0x80
+
+/* the maximum number of bytes used to store 64 bit integer */
+#define ZBX_HB_VARINT_MAX	10
+
+/* the maximum number of digits in unsigned integer value stored in uint column */
+#define ZBX_HB_UINT_DIGITS_MAX	19
+
+static zbx_uint64_t	hb_zigzag_encode(zbx_int64_t value)
+{
+	return 0 > value ? (~(zbx_uint64_t)value << 1) | 1 : (zbx_uint64_t)value << 1;
+}
+
+static zbx_int64_t	hb_zigzag_decode(zbx_uint64_t value)
+{
+	return (zbx_int64_t)((value >> 1) ^ (0 - (value & 1)));
+}
+
+static void	hb_column_reserve(zbx_hb_column_t *column, size_t size)
+{
+	if (column->data_alloc - column->data_offset >= size)
+		return;
+
+	if (0 == column->data_alloc)
+		column->data_alloc = 256;
+
+	while (column->data_alloc - column->data_offset < size)
+		column->data_alloc *= 2;
+
+	column->data = (unsigned char *)zbx_realloc(column->data, column->data_alloc);
+}
+
+static void	hb_write_uint(zbx_hb_column_t *column, zbx_uint64_t value)
+{
+	hb_column_reserve(column, ZBX_HB_VARINT_MAX);
+
+	while (0x7f < value)
+	{
+		column->data[column->data_offset++] = (unsigned char)(value | 0x80);
+		value >>= 7;
+	}
+
+	column->data[column->data_offset++] = (unsigned char)value;
+}
+
+static void	hb_write_int(zbx_hb_column_t *column, zbx_int64_t value)
+{
+	hb_write_uint(column, hb_zigzag_encode(value));
+}
+
+static void	hb_write_byte(zbx_hb_column_t *column, unsigned char value)
+{
+	hb_column_reserve(column, 1);
+	column->data[column->data_offset++] = value;
+}
+
+static void	hb_write_bin(zbx_hb_column_t *column, const void *data, size_t size)
+{
+	hb_column_reserve(column, size);
+	memcpy(column->data + column->data_offset, data, size);
+	column->data_offset += size;
+}
+
+static void	hb_write_str(zbx_hb_column_t *column, const char *str)
+{
+	size_t	len;
+
+	len = strlen(str);
+	hb_write_uint(column, (zbx_uint64_t)len);
+	hb_write_bin(column, str, len);
+}
+
+static int	hb_read_uint(zbx_hb_cursor_t *cursor, zbx_uint64_t *value)
+{
+	int	shift;
+
+	*value = 0;
+
+	for (shift = 0; shift < 64; shift += 7)
+	{
+		if (cursor->ptr == cursor->end)
+			return FAIL;
+
+		*value |= (zbx_uint64_t)(*cursor->ptr & 0x7f) << shift;
+
+		if (0 == (*cursor->ptr++ & 0x80))
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
+static int	hb_read_int(zbx_hb_cursor_t *cursor, zbx_int64_t *value)
+{
+	zbx_uint64_t	encoded;
+
+	if (SUCCEED != hb_read_uint(cursor, &encoded))
+		return FAIL;
+
+	*value = hb_zigzag_decode(encoded);
+
+	return SUCCEED;
+}
+
+static int	hb_read_int32(zbx_hb_cursor_t *cursor, int *value)
+{
+	zbx_int64_t	value64;
+
+	if (SUCCEED != hb_read_int(cursor, &value64) || INT_MIN > value64 || INT_MAX < value64)
+		return FAIL;
+
+	*value = (int)value64;
+
+	return SUCCEED;
+}
+
+static int	hb_read_byte(zbx_hb_cursor_t *cursor, unsigned char *value)
+{
+	if (cursor->ptr == cursor->end)
+		return FAIL;
+
+	*value = *cursor->ptr++;
+
+	return SUCCEED;
+}
+
+static int	hb_read_str(zbx_hb_cursor_t *cursor, char **str)
+{
+	zbx_uint64_t	len;
+
+	if (SUCCEED != hb_read_uint(cursor, &len) || (zbx_uint64_t)(cursor->end - cursor->ptr) < len)
+		return FAIL;
+
+	*str = (char *)zbx_malloc(NULL, (size_t)len + 1);
+	memcpy(*str, cursor->ptr, (size_t)len);
+	(*str)[len] = '\0';
+	cursor->ptr += len;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hb_str_to_uint                                                   *
+ *                                                                            *
+ * Purpose: check if the value can be stored in uint column without changing  *
+ *          its text form                                                     *
+ *                                                                            *
+ * Parameters: str   - [IN] the value                                         *
+ *             value - [OUT] the unsigned integer value                       *
+ *                                                                            *
+ * Return value: SUCCEED - the value is unsigned integer without leading      *
+ *                         zeroes or other characters                         *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	hb_str_to_uint(const char *str, zbx_uint64_t *value)
+{
+	const char	*ptr;
+
+	for (ptr = str; '\0' != *ptr; ptr++)
+	{
+		if (0 == isdigit((unsigned char)*ptr) || ZBX_HB_UINT_DIGITS_MAX == ptr - str)
+			return FAIL;
+	}
+
+	if (ptr == str || ('0' == *str && 1 != ptr - str))
+		return FAIL;
+
+	return ZBX_STR2UINT64(*value, str);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hb_writer_init                                               *
+ *                                                                            *
+ * Purpose: initialize binary history data writer                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hb_writer_init(zbx_hb_writer_t *writer)
+{
+	memset(writer, 0, sizeof(zbx_hb_writer_t));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hb_writer_clear                                              *
+ *                                                                            *
+ * Purpose: free resources allocated by binary history data writer            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hb_writer_clear(zbx_hb_writer_t *writer)
+{
+	int	i;
+
+	for (i = 0; i < ZBX_HB_COLUMNS_NUM; i++)
+		zbx_free(writer->columns[i].data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hb_writer_add                                                *
+ *                                                                            *
+ * Purpose: add history record to binary history data                         *
+ *                                                                            *
+ * Parameters: writer - [IN/OUT] the binary history data writer               *
+ *             record - [IN] the record to add                                *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hb_writer_add(zbx_hb_writer_t *writer, const zbx_hb_record_t *record)
+{
+	zbx_hb_column_t	*columns = writer->columns;
+	unsigned char	flags = 0;
+	zbx_uint64_t	value_ui64;
+
+	hb_write_int(&columns[ZBX_HB_COLUMN_ID], (zbx_int64_t)(record->id - writer->lastid));
+	hb_write_uint(&columns[ZBX_HB_COLUMN_ITEMID], record->itemid);
+	hb_write_int(&columns[ZBX_HB_COLUMN_CLOCK], (zbx_int64_t)record->clock - writer->lastclock);
+	hb_write_uint(&columns[ZBX_HB_COLUMN_NS], (zbx_uint64_t)record->ns);
+
+	writer->lastid = record->id;
+	writer->lastclock = record->clock;
+
+	if (ITEM_STATE_NOTSUPPORTED == record->state)
+		flags |= ZBX_HB_FLAG_NOTSUPPORTED;
+
+	if (NULL != record->value)
+	{
+		if (SUCCEED == hb_str_to_uint(record->value, &value_ui64))
+		{
+			hb_write_uint(&columns[ZBX_HB_COLUMN_UINT], value_ui64);
+			flags |= ZBX_HB_FLAG_UINT;
+		}
+		else
+		{
+			hb_write_str(&columns[ZBX_HB_COLUMN_STRING], record->value);
+			flags |= ZBX_HB_FLAG_STRING;
+		}
+	}
+
+	if (0 != record->meta)
+	{
+		hb_write_uint(&columns[ZBX_HB_COLUMN_META], record->lastlogsize);
+		hb_write_int(&columns[ZBX_HB_COLUMN_META], record->mtime);
+		flags |= ZBX_HB_FLAG_META;
+	}
+
+	if (0 != record->timestamp)
+	{
+		hb_write_int(&columns[ZBX_HB_COLUMN_LOG], record->timestamp);
+		flags |= ZBX_HB_FLAG_TIMESTAMP;
+	}
+
+	if (NULL != record->source && '\0' != *record->source)
+	{
+		hb_write_str(&columns[ZBX_HB_COLUMN_LOG], record->source);
+		flags |= ZBX_HB_FLAG_SOURCE;
+	}
+
+	if (0 != record->severity)
+	{
+		hb_write_int(&columns[ZBX_HB_COLUMN_LOG], record->severity);
+		flags |= ZBX_HB_FLAG_SEVERITY;
+	}
+
+	if (0 != record->logeventid)
+	{
+		hb_write_int(&columns[ZBX_HB_COLUMN_LOG], record->logeventid);
+		flags |= ZBX_HB_FLAG_LOGEVENTID;
+	}
+
+	hb_write_byte(&columns[ZBX_HB_COLUMN_FLAGS], flags);
+
+	writer->records_num++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hb_writer_size                                               *
+ *                                                                            *
+ * Purpose: get the approximate size of encoded binary history data           *
+ *                                                                            *
+ ******************************************************************************/
+size_t	zbx_hb_writer_size(const zbx_hb_writer_t *writer)
+{
+	size_t	size = ZBX_HB_VARINT_MAX * (2 + ZBX_HB_COLUMNS_NUM);
+	int	i;
+
+	for (i = 0; i < ZBX_HB_COLUMNS_NUM; i++)
+		size += writer->columns[i].data_offset;
+
+	/* base64 encoding expands data by one third */
+	return size / 3 * 4 + 4;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hb_writer_encode                                             *
+ *                                                                            *
+ * Purpose: encode the added history records                                  *
+ *                                                                            *
+ * Parameters: writer - [IN] the binary history data writer                   *
+ *                                                                            *
+ * Return value: The base64 encoded binary history data, must be freed by the *
+ *               caller.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+char	*zbx_hb_writer_encode(const zbx_hb_writer_t *writer)
+{
+	zbx_hb_column_t	data = {0};
+	char		*text = NULL;
+	int		i;
+
+	hb_write_uint(&data, ZBX_HISTORY_BINARY_VERSION);
+	hb_write_uint(&data, (zbx_uint64_t)writer->records_num);
+
+	for (i = 0; i < ZBX_HB_COLUMNS_NUM; i++)
+		hb_write_uint(&data, (zbx_uint64_t)writer->columns[i].data_offset);
+
+	for (i = 0; i < ZBX_HB_COLUMNS_NUM; i++)
+		hb_write_bin(&data, writer->columns[i].data, writer->columns[i].data_offset);
+
+	str_base64_encode_dyn((const char *)data.data, &text, (int)data.data_offset);
+	zbx_free(data.data);
+
+	return text;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hb_reader_open                                               *
+ *                                                                            *
+ * Purpose: prepare binary history data for reading                           *
+ *                                                                            *
+ * Parameters: reader - [OUT] the binary history data reader                  *
+ *             text   - [IN] the base64 encoded binary history data           *
+ *             error  - [OUT] the error message                               *
+ *                                                                            *
+ * Return value: SUCCEED - the data header was parsed successfully            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The reader must be closed with zbx_hb_reader_close() after       *
+ *           successful open.                                                 *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_hb_reader_open(zbx_hb_reader_t *reader, const char *text, char **error)
+{
+	zbx_hb_cursor_t	header;
+	zbx_uint64_t	version, records_num, sizes[ZBX_HB_COLUMNS_NUM];
+	size_t		data_alloc;
+	int		data_size, i;
+
+	memset(reader, 0, sizeof(zbx_hb_reader_t));
+
+	data_alloc = strlen(text) / 4 * 3 + 3;
+	reader->data = (unsigned char *)zbx_malloc(NULL, data_alloc);
+	str_base64_decode(text, (char *)reader->data, (int)data_alloc, &data_size);
+
+	header.ptr = reader->data;
+	header.end = reader->data + data_size;
+
+	if (SUCCEED != hb_read_uint(&header, &version) || SUCCEED != hb_read_uint(&header, &records_num))
+	{
+		*error = zbx_strdup(*error, "cannot parse binary history data header");
+		goto fail;
+	}
+
+	if (0 == version || ZBX_HISTORY_BINARY_VERSION < version)
+	{
+		*error = zbx_dsprintf(*error, "unsupported binary history data version " ZBX_FS_UI64, version);
+		goto fail;
+	}
+
+	if (INT_MAX < records_num)
+	{
+		*error = zbx_dsprintf(*error, "invalid number of binary history data records " ZBX_FS_UI64,
+				records_num);
+		goto fail;
+	}
+
+	for (i = 0; i < ZBX_HB_COLUMNS_NUM; i++)
+	{
+		if (SUCCEED != hb_read_uint(&header, &sizes[i]))
+		{
+			*error = zbx_strdup(*error, "cannot parse binary history data header");
+			goto fail;
+		}
+	}
+
+	for (i = 0; i < ZBX_HB_COLUMNS_NUM; i++)
+	{
+		if ((zbx_uint64_t)(header.end - header.ptr) < sizes[i])
+		{
+			*error = zbx_strdup(*error, "binary history data is truncated");
+			goto fail;
+		}
+
+		reader->columns[i].ptr = header.ptr;
+		header.ptr += sizes[i];
+		reader->columns[i].end = header.ptr;
+	}
+
+	if (header.ptr != header.end)
+	{
+		*error = zbx_strdup(*error, "unexpected data after binary history data columns");
+		goto fail;
+	}
+
+	reader->records_left = (int)records_num;
+
+	return SUCCEED;
+fail:
+	zbx_hb_reader_close(reader);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hb_reader_close                                              *
+ *                                                                            *
+ * Purpose: free resources allocated by binary history data reader            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hb_reader_close(zbx_hb_reader_t *reader)
+{
+	zbx_free(reader->data);
+	reader->records_left = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hb_reader_read                                               *
+ *                                                                            *
+ * Purpose: read the next history record from binary history data             *
+ *                                                                            *
+ * Parameters: reader - [IN/OUT] the binary history data reader               *
+ *             itemid - [OUT] the item identifier                             *
+ *             av     - [OUT] the agent value                                 *
+ *             error  - [OUT] the error message                               *
+ *                                                                            *
+ * Return value: SUCCEED - the record was read successfully                   *
+ *               FAIL    - the data is malformed                              *
+ *                                                                            *
+ * Comments: This function must be called only while reader->records_left     *
+ *           is not zero. The agent value strings must be freed by the        *
+ *           caller.                                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_hb_reader_read(zbx_hb_reader_t *reader, zbx_uint64_t *itemid, zbx_agent_value_t *av, char **error)
+{
+	zbx_hb_cursor_t	*columns = reader->columns;
+	zbx_int64_t	id_diff, clock;
+	zbx_uint64_t	value_ui64, ns;
+	unsigned char	flags;
+
+	memset(av, 0, sizeof(zbx_agent_value_t));
+
+	if (SUCCEED != hb_read_int(&columns[ZBX_HB_COLUMN_ID], &id_diff) ||
+			SUCCEED != hb_read_uint(&columns[ZBX_HB_COLUMN_ITEMID], itemid) ||
+			SUCCEED != hb_read_int(&columns[ZBX_HB_COLUMN_CLOCK], &clock) ||
+			SUCCEED != hb_read_uint(&columns[ZBX_HB_COLUMN_NS], &ns) ||
+			SUCCEED != hb_read_byte(&columns[ZBX_HB_COLUMN_FLAGS], &flags))
+	{
+		goto fail;
+	}
+
+	clock += reader->lastclock;
+
+	if (0 > clock || INT_MAX < clock || 999999999 < ns)
+		goto fail;
+
+	reader->lastid += (zbx_uint64_t)id_diff;
+	reader->lastclock = (int)clock;
+
+	av->id = reader->lastid;
+	av->ts.sec = (int)clock;
+	av->ts.ns = (int)ns;
+
+	if (0 != (flags & ZBX_HB_FLAG_NOTSUPPORTED))
+		av->state = ITEM_STATE_NOTSUPPORTED;
+
+	if (0 != (flags & ZBX_HB_FLAG_UINT))
+	{
+		if (SUCCEED != hb_read_uint(&columns[ZBX_HB_COLUMN_UINT], &value_ui64))
+			goto fail;
+
+		av->value = zbx_dsprintf(NULL, ZBX_FS_UI64, value_ui64);
+	}
+	else if (0 != (flags & ZBX_HB_FLAG_STRING))
+	{
+		if (SUCCEED != hb_read_str(&columns[ZBX_HB_COLUMN_STRING], &av->value))
+			goto fail;
+	}
+
+	if (0 != (flags & ZBX_HB_FLAG_META))
+	{
+		if (SUCCEED != hb_read_uint(&columns[ZBX_HB_COLUMN_META], &av->lastlogsize) ||
+				SUCCEED != hb_read_int32(&columns[ZBX_HB_COLUMN_META], &av->mtime))
+		{
+			goto fail;
+		}
+
+		/* unsupported item meta information is ignored, the same as in history data JSON */
+		if (ITEM_STATE_NOTSUPPORTED != av->state)
+			av->meta = 1;
+		else
+			av->lastlogsize = av->mtime = 0;
+	}
+
+	if (0 != (flags & ZBX_HB_FLAG_TIMESTAMP) &&
+			SUCCEED != hb_read_int32(&columns[ZBX_HB_COLUMN_LOG], &av->timestamp))
+	{
+		goto fail;
+	}
+
+	if (0 != (flags & ZBX_HB_FLAG_SOURCE) && SUCCEED != hb_read_str(&columns[ZBX_HB_COLUMN_LOG], &av->source))
+		goto fail;
+
+	if (0 != (flags & ZBX_HB_FLAG_SEVERITY) &&
+			SUCCEED != hb_read_int32(&columns[ZBX_HB_COLUMN_LOG], &av->severity))
+	{
+		goto fail;
+	}
+
+	if (0 != (flags & ZBX_HB_FLAG_LOGEVENTID) &&
+			SUCCEED != hb_read_int32(&columns[ZBX_HB_COLUMN_LOG], &av->logeventid))
+	{
+		goto fail;
+	}
+
+	reader->records_left--;
+
+	return SUCCEED;
+fail:
+	zbx_free(av->value);
+	zbx_free(av->source);
+
+	*error = zbx_strdup(*error, "invalid binary history data record");
+
+	return FAIL;
+}
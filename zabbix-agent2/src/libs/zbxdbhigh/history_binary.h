@@ -0,0 +1,101 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_HISTORY_BINARY_H
+#define ZABBIX_HISTORY_BINARY_H
+
+#include "common.h"
+#include "dbcache.h"
+
+/* binary history data columns */
+#define ZBX_HB_COLUMN_ID	0
+#define ZBX_HB_COLUMN_ITEMID	1
+#define ZBX_HB_COLUMN_CLOCK	2
+#define ZBX_HB_COLUMN_NS	3
+#define ZBX_HB_COLUMN_FLAGS	4
+#define ZBX_HB_COLUMN_META	5
+#define ZBX_HB_COLUMN_LOG	6
+#define ZBX_HB_COLUMN_UINT	7
+#define ZBX_HB_COLUMN_STRING	8
+#define ZBX_HB_COLUMNS_NUM	9
+
+typedef struct
+{
+	unsigned char	*data;
+	size_t		data_alloc;
+	size_t		data_offset;
+}
+zbx_hb_column_t;
+
+typedef struct
+{
+	const unsigned char	*ptr;
+	const unsigned char	*end;
+}
+zbx_hb_cursor_t;
+
+/* the history record to encode, the string values are not copied */
+typedef struct
+{
+	zbx_uint64_t	id;
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	lastlogsize;
+	const char	*value;		/* NULL if the record has no value */
+	const char	*source;	/* NULL or empty if the record has no log source */
+	int		clock;
+	int		ns;
+	int		timestamp;
+	int		severity;
+	int		logeventid;
+	int		mtime;
+	unsigned char	state;
+	unsigned char	meta;		/* non-zero if the record has lastlogsize and mtime */
+}
+zbx_hb_record_t;
+
+typedef struct
+{
+	zbx_hb_column_t	columns[ZBX_HB_COLUMNS_NUM];
+	zbx_uint64_t	lastid;
+	int		lastclock;
+	int		records_num;
+}
+zbx_hb_writer_t;
+
+typedef struct
+{
+	unsigned char	*data;
+	zbx_hb_cursor_t	columns[ZBX_HB_COLUMNS_NUM];
+	zbx_uint64_t	lastid;
+	int		lastclock;
+	int		records_left;
+}
+zbx_hb_reader_t;
+
+void	zbx_hb_writer_init(zbx_hb_writer_t *writer);
+void	zbx_hb_writer_clear(zbx_hb_writer_t *writer);
+void	zbx_hb_writer_add(zbx_hb_writer_t *writer, const zbx_hb_record_t *record);
+size_t	zbx_hb_writer_size(const zbx_hb_writer_t *writer);
+char	*zbx_hb_writer_encode(const zbx_hb_writer_t *writer);
+
+int	zbx_hb_reader_open(zbx_hb_reader_t *reader, const char *text, char **error);
+void	zbx_hb_reader_close(zbx_hb_reader_t *reader);
+int	zbx_hb_reader_read(zbx_hb_reader_t *reader, zbx_uint64_t *itemid, zbx_agent_value_t *av, char **error);
+
+#endif
@@ -34,6 +34,7 @@
 #include "events.h"
 #include "zbxvault.h"
 #include "zbxavailability.h"
+#include "history_binary.h"
 
 extern char	*CONFIG_SERVER;
 extern char	*CONFIG_VAULTDBPATH;
@@ -47,6 +48,12 @@ extern char	*CONFIG_VAULTDBPATH;
 /* the maximum number of values processed in one batch */
 #define ZBX_HISTORY_VALUES_MAX		256
 
+/* the number of table rows per proxy configuration revision bucket */
+#define ZBX_PROXYCONFIG_BUCKET_ROWS	100
+#define ZBX_PROXYCONFIG_BUCKETS_MAX	4096
+/* the allowed difference between the number of buckets used by proxy and suitable for table size */
+#define ZBX_PROXYCONFIG_BUCKETS_RATIO	4
+
 typedef struct
 {
 	zbx_uint64_t		druleid;
@@ -1097,14 +1104,236 @@ static void	get_macro_secrets(const zbx_vector_ptr_t *keys_paths, struct zbx_jso
 	zbx_hashset_destroy(&kvs);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_hash                                                 *
+ *                                                                            *
+ * Purpose: calculate 64 bit hash of proxy configuration data                 *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	proxyconfig_hash(const char *data, size_t len)
+{
+	md5_state_t	state;
+	md5_byte_t	hash[MD5_DIGEST_SIZE];
+	zbx_uint64_t	value;
+
+	zbx_md5_init(&state);
+	zbx_md5_append(&state, (const md5_byte_t *)data, (int)len);
+	zbx_md5_finish(&state, hash);
+
+	memcpy(&value, hash, sizeof(value));
+
+	return value;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_get_revision                                         *
+ *                                                                            *
+ * Purpose: get table revision acknowledged by proxy                          *
+ *                                                                            *
+ * Parameters: jp_revision - [IN] the proxy configuration revision            *
+ *             table       - [IN] the table name                              *
+ *             buckets_num - [IN] the number of buckets suitable for the      *
+ *                                current table size                          *
+ *             revision    - [OUT] the bucket hashes                          *
+ *                                                                            *
+ * Return value: the number of buckets in proxy table revision or 0 if the    *
+ *               revision is missing, invalid or the number of buckets does   *
+ *               not fit the current table size                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxyconfig_get_revision(const struct zbx_json_parse *jp_revision, const char *table,
+		int buckets_num, zbx_uint64_t **revision)
+{
+	struct zbx_json_parse	jp;
+	const char		*p = NULL;
+	char			buf[MAX_ID_LEN + 1];
+	int			num = 0;
+
+	if (NULL == jp_revision || SUCCEED != zbx_json_brackets_by_name(jp_revision, table, &jp))
+		return 0;
+
+	while (NULL != (p = zbx_json_next(&jp, p)))
+		num++;
+
+	/* resynchronize the table if it has grown or shrunk too much since the last synchronization */
+	if (num < buckets_num / ZBX_PROXYCONFIG_BUCKETS_RATIO || num > buckets_num * ZBX_PROXYCONFIG_BUCKETS_RATIO ||
+			num > ZBX_PROXYCONFIG_BUCKETS_MAX)
+	{
+		return 0;
+	}
+
+	*revision = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * (size_t)num);
+
+	for (num = 0; NULL != (p = zbx_json_next_value(&jp, p, buf, sizeof(buf), NULL)); num++)
+	{
+		if (SUCCEED != is_uint64(buf, &(*revision)[num]))
+		{
+			zbx_free(*revision);
+			return 0;
+		}
+	}
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_add_table                                            *
+ *                                                                            *
+ * Purpose: add table data to proxy configuration, leaving out the rows       *
+ *          already synchronized to proxy                                     *
+ *                                                                            *
+ * Parameters: j           - [OUT] the proxy configuration                    *
+ *             table       - [IN] the table                                   *
+ *             j_table     - [IN] the full table data                         *
+ *             jp_revision - [IN] the configuration revision acknowledged by  *
+ *                                proxy (optional)                            *
+ *                                                                            *
+ * Return value: SUCCEED - the table was added successfully                   *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Table rows are split into buckets by record id modulo number of  *
+ *           buckets. The table revision is a list of bucket hashes, sent     *
+ *           together with table data. When proxy requests configuration with *
+ *           the revision it has applied, only the rows of buckets with       *
+ *           changed hashes are sent along with the list of changed buckets.  *
+ *           Proxy then replaces the rows of changed buckets, which also      *
+ *           deletes the rows removed on server.                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxyconfig_add_table(struct zbx_json *j, const ZBX_TABLE *table, const struct zbx_json *j_table,
+		const struct zbx_json_parse *jp_revision)
+{
+	struct zbx_json_parse	jp, jp_obj, jp_fields, jp_data, jp_row;
+	const char		*p;
+	char			*buf = NULL, id[MAX_ID_LEN + 1];
+	size_t			buf_alloc = 0, buf_offset;
+	int			rows_num = 0, buckets_num, i, *row_buckets = NULL, rows_sent = 0;
+	zbx_uint64_t		*revision, *revision_proxy = NULL, fields_hash, recid;
+
+	if (SUCCEED != zbx_json_open(j_table->buffer, &jp) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp, table->table, &jp_obj) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp_obj, "fields", &jp_fields) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp_obj, ZBX_PROTO_TAG_DATA, &jp_data))
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return FAIL;
+	}
+
+	for (p = NULL; NULL != (p = zbx_json_next(&jp_data, p));)
+		rows_num++;
+
+	buckets_num = MIN(MAX(1, rows_num / ZBX_PROXYCONFIG_BUCKET_ROWS), ZBX_PROXYCONFIG_BUCKETS_MAX);
+
+	if (0 != (i = proxyconfig_get_revision(jp_revision, table->table, buckets_num, &revision_proxy)))
+		buckets_num = i;
+
+	revision = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * (size_t)buckets_num);
+
+	/* include field list in bucket hashes to resynchronize all rows after table structure changes */
+	fields_hash = proxyconfig_hash(jp_fields.start, (size_t)(jp_fields.end - jp_fields.start + 1));
+
+	for (i = 0; i < buckets_num; i++)
+		revision[i] = fields_hash;
+
+	if (0 != rows_num)
+		row_buckets = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)rows_num);
+
+	for (p = NULL, i = 0; NULL != (p = zbx_json_next(&jp_data, p)); i++)
+	{
+		if (SUCCEED != zbx_json_brackets_open(p, &jp_row) ||
+				NULL == zbx_json_next_value(&jp_row, NULL, id, sizeof(id), NULL) ||
+				SUCCEED != is_uint64(id, &recid))
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			zbx_free(row_buckets);
+			zbx_free(revision);
+			zbx_free(revision_proxy);
+			return FAIL;
+		}
+
+		row_buckets[i] = (int)(recid % (zbx_uint64_t)buckets_num);
+		revision[row_buckets[i]] += proxyconfig_hash(p, (size_t)(jp_row.end - p + 1));
+	}
+
+	zbx_json_addobject(j, table->table);
+	zbx_json_addarray(j, "fields");
+
+	for (p = NULL; NULL != (p = zbx_json_next_value_dyn(&jp_fields, p, &buf, &buf_alloc, NULL));)
+		zbx_json_addstring(j, NULL, buf, ZBX_JSON_TYPE_STRING);
+
+	zbx_json_close(j);	/* fields */
+
+	zbx_json_addarray(j, ZBX_PROTO_TAG_DATA);
+
+	for (p = NULL, i = 0; NULL != (p = zbx_json_next(&jp_data, p)); i++)
+	{
+		if (NULL != revision_proxy && revision_proxy[row_buckets[i]] == revision[row_buckets[i]])
+			continue;
+
+		zbx_json_brackets_open(p, &jp_row);
+
+		buf_offset = 0;
+		zbx_strncpy_alloc(&buf, &buf_alloc, &buf_offset, p, (size_t)(jp_row.end - p + 1));
+		zbx_json_addraw(j, NULL, buf);
+		rows_sent++;
+	}
+
+	zbx_json_close(j);	/* data */
+
+	zbx_json_addarray(j, "revision");
+
+	for (i = 0; i < buckets_num; i++)
+		zbx_json_adduint64(j, NULL, revision[i]);
+
+	zbx_json_close(j);	/* revision */
+
+	if (NULL != revision_proxy)
+	{
+		zbx_json_addarray(j, "buckets");
+
+		for (i = 0; i < buckets_num; i++)
+		{
+			if (revision_proxy[i] != revision[i])
+				zbx_json_addint64(j, NULL, i);
+		}
+
+		zbx_json_close(j);	/* buckets */
+	}
+
+	zbx_json_close(j);	/* table->table */
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() table:'%s' rows:%d sent:%d buckets:%d incremental:%s", __func__,
+			table->table, rows_num, rows_sent, buckets_num, NULL != revision_proxy ? "yes" : "no");
+
+	zbx_free(buf);
+	zbx_free(row_buckets);
+	zbx_free(revision);
+	zbx_free(revision_proxy);
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: get_proxyconfig_data                                             *
  *                                                                            *
  * Purpose: prepare proxy configuration data                                  *
  *                                                                            *
+ * Parameters: proxy_hostid - [IN] the proxy identifier                       *
+ *             jp_revision  - [IN] the configuration revision acknowledged by *
+ *                                 proxy, NULL to send full configuration     *
+ *             j            - [OUT] the proxy configuration                   *
+ *             error        - [OUT] the error message                         *
+ *                                                                            *
+ * Return value: SUCCEED - the configuration was prepared successfully        *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
  ******************************************************************************/
-int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, struct zbx_json *j, char **error)
+int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, const struct zbx_json_parse *jp_revision, struct zbx_json *j,
+		char **error)
 {
 	static const char	*proxytable[] =
 	{
@@ -1139,6 +1368,7 @@ int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, struct zbx_json *j, char **e
 	zbx_vector_uint64_t	hosts, httptests;
 	zbx_hashset_t		itemids;
 	zbx_vector_ptr_t	keys_paths;
+	struct zbx_json		j_table;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() proxy_hostid:" ZBX_FS_UI64, __func__, proxy_hostid);
 
@@ -1157,16 +1387,28 @@ int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, struct zbx_json *j, char **e
 
 		if (0 == strcmp(proxytable[i], "items"))
 		{
-			ret = get_proxyconfig_table_items(proxy_hostid, j, table, &itemids);
+			zbx_json_init(&j_table, ZBX_JSON_STAT_BUF_LEN);
+			ret = get_proxyconfig_table_items(proxy_hostid, &j_table, table, &itemids);
 		}
 		else if (0 == strcmp(proxytable[i], "item_preproc") || 0 == strcmp(proxytable[i], "item_rtdata") ||
 				0 == strcmp(proxytable[i], "item_parameter"))
 		{
-			if (0 != itemids.num_data)
-				ret = get_proxyconfig_table_items_ext(proxy_hostid, &itemids, j, table);
+			if (0 == itemids.num_data)
+				continue;
+
+			zbx_json_init(&j_table, ZBX_JSON_STAT_BUF_LEN);
+			ret = get_proxyconfig_table_items_ext(proxy_hostid, &itemids, &j_table, table);
 		}
 		else
-			ret = get_proxyconfig_table(proxy_hostid, j, table, &hosts, &httptests, &keys_paths);
+		{
+			zbx_json_init(&j_table, ZBX_JSON_STAT_BUF_LEN);
+			ret = get_proxyconfig_table(proxy_hostid, &j_table, table, &hosts, &httptests, &keys_paths);
+		}
+
+		if (SUCCEED == ret)
+			ret = proxyconfig_add_table(j, table, &j_table, jp_revision);
+
+		zbx_json_free(&j_table);
 
 		if (SUCCEED != ret)
 		{
@@ -1352,6 +1594,60 @@ static int	compare_nth_field(const ZBX_FIELD **fields, const char *rec_data, int
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: get_proxyconfig_buckets                                          *
+ *                                                                            *
+ * Purpose: get the buckets of incrementally updated configuration table      *
+ *                                                                            *
+ * Parameters: jp_obj      - [IN] the table data                              *
+ *             buckets_num - [OUT] the number of buckets in table revision or *
+ *                                 0 if the table data is full                *
+ *             buckets     - [OUT] the changed buckets                        *
+ *             error       - [OUT] the error message                          *
+ *                                                                            *
+ * Return value: SUCCEED - the buckets were parsed successfully               *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_proxyconfig_buckets(const struct zbx_json_parse *jp_obj, int *buckets_num,
+		zbx_vector_uint64_t *buckets, char **error)
+{
+	struct zbx_json_parse	jp_buckets, jp_revision;
+	const char		*p = NULL;
+	char			buf[MAX_ID_LEN + 1];
+	zbx_uint64_t		bucket;
+
+	*buckets_num = 0;
+
+	if (SUCCEED != zbx_json_brackets_by_name(jp_obj, "buckets", &jp_buckets))
+		return SUCCEED;
+
+	if (SUCCEED != zbx_json_brackets_by_name(jp_obj, "revision", &jp_revision))
+	{
+		*error = zbx_strdup(*error, "missing revision of incremental table data");
+		return FAIL;
+	}
+
+	while (NULL != (p = zbx_json_next(&jp_revision, p)))
+		(*buckets_num)++;
+
+	while (NULL != (p = zbx_json_next_value(&jp_buckets, p, buf, sizeof(buf), NULL)))
+	{
+		if (SUCCEED != is_uint64(buf, &bucket) || bucket >= (zbx_uint64_t)*buckets_num)
+		{
+			*error = zbx_dsprintf(*error, "invalid table data bucket \"%s\"", buf);
+			return FAIL;
+		}
+
+		zbx_vector_uint64_append(buckets, bucket);
+	}
+
+	zbx_vector_uint64_sort(buckets, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: process_proxyconfig_table                                        *
@@ -1365,17 +1661,21 @@ static int	compare_nth_field(const ZBX_FIELD **fields, const char *rec_data, int
  * Return value: SUCCEED - processed successfully                             *
  *               FAIL - an error occurred                                     *
  *                                                                            *
+ * Comments: Incremental table data contains only the rows of changed         *
+ *           buckets, so only the existing records of these buckets are       *
+ *           updated or deleted.                                              *
+ *                                                                            *
  ******************************************************************************/
 static int	process_proxyconfig_table(const ZBX_TABLE *table, struct zbx_json_parse *jp_obj,
 		zbx_vector_uint64_t *del, char **error)
 {
 	int			f, fields_count, ret = FAIL, id_field_nr = 0, move_out = 0,
-				move_field_nr = 0;
+				move_field_nr = 0, buckets_num;
 	const ZBX_FIELD		*fields[ZBX_MAX_FIELDS];
 	struct zbx_json_parse	jp_data, jp_row;
 	const char		*p, *pf;
 	zbx_uint64_t		recid, *p_recid = NULL;
-	zbx_vector_uint64_t	ins, moves, availability_interfaceids;
+	zbx_vector_uint64_t	ins, moves, availability_interfaceids, buckets;
 	char			*buf = NULL, *esc, *sql = NULL, *recs = NULL;
 	size_t			sql_alloc = 4 * ZBX_KIBIBYTE, sql_offset,
 				recs_alloc = 20 * ZBX_KIBIBYTE, recs_offset = 0,
@@ -1392,6 +1692,8 @@ static int	process_proxyconfig_table(const ZBX_TABLE *table, struct zbx_json_par
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() table:'%s'", __func__, table->table);
 
+	zbx_vector_uint64_create(&buckets);
+
 	/************************************************************************************/
 	/* T1. RECEIVED JSON (jp_obj) DATA FORMAT                                           */
 	/************************************************************************************/
@@ -1477,6 +1779,16 @@ static int	process_proxyconfig_table(const ZBX_TABLE *table, struct zbx_json_par
 		goto out;
 	}
 
+	if (SUCCEED != get_proxyconfig_buckets(jp_obj, &buckets_num, &buckets, error))
+		goto out;
+
+	/* incremental table data without changed buckets, nothing to update */
+	if (0 != buckets_num && 0 == buckets.values_num)
+	{
+		ret = SUCCEED;
+		goto out;
+	}
+
 	/* all records will be stored in one large string */
 	recs = (char *)zbx_malloc(recs, recs_alloc);
 
@@ -1502,10 +1814,21 @@ static int	process_proxyconfig_table(const ZBX_TABLE *table, struct zbx_json_par
 	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " from ");
 	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, table->table);
 
+	if (0 != buckets_num)
+	{
+		char	*bucket_field;
+
+		bucket_field = zbx_dsprintf(NULL, ZBX_SQL_MOD(%s,%d), table->recid, buckets_num);
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " where");
+		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, bucket_field, buckets.values,
+				buckets.values_num);
+		zbx_free(bucket_field);
+	}
+
 	/* Find a number of the ID field. Usually the 1st field. */
 	id_field_nr = find_field_by_name(fields, fields_count, table->recid);
 
-	/* select all existing records */
+	/* select existing records, only of the changed buckets for incremental data */
 	result = DBselect("%s", sql);
 
 	while (NULL != (row = DBfetch(result)))
@@ -1974,6 +2297,7 @@ clean2:
 	zbx_free(sql);
 	zbx_free(recs);
 out:
+	zbx_vector_uint64_destroy(&buckets);
 	zbx_free(buf);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
@@ -1987,8 +2311,16 @@ out:
  *                                                                            *
  * Purpose: update configuration                                              *
  *                                                                            *
+ * Parameters: jp_data  - [IN] the configuration data                         *
+ *             revision - [OUT] the revision of updated configuration tables  *
+ *                              to be acknowledged in the next configuration  *
+ *                              request (optional)                            *
+ *                                                                            *
+ * Return value: SUCCEED - the configuration was updated successfully         *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
  ******************************************************************************/
-void	process_proxyconfig(struct zbx_json_parse *jp_data)
+int	process_proxyconfig(struct zbx_json_parse *jp_data, struct zbx_json *revision)
 {
 	typedef struct
 	{
@@ -1999,8 +2331,9 @@ void	process_proxyconfig(struct zbx_json_parse *jp_data)
 
 	char			buf[ZBX_TABLENAME_LEN_MAX];
 	const char		*p = NULL;
-	struct zbx_json_parse	jp_obj, jp_kvs_paths, *jp_kvs_paths_ptr = NULL;
-	char			*error = NULL;
+	struct zbx_json_parse	jp_obj, jp_kvs_paths, *jp_kvs_paths_ptr = NULL, jp_revision;
+	char			*error = NULL, *revision_buf = NULL;
+	size_t			revision_alloc = 0, revision_offset;
 	int			i, ret = SUCCEED;
 
 	table_ids_t		*table_ids;
@@ -2043,6 +2376,15 @@ void	process_proxyconfig(struct zbx_json_parse *jp_data)
 		zbx_vector_ptr_append(&tables_proxy, table_ids);
 
 		ret = process_proxyconfig_table(table, &jp_obj, &table_ids->ids, &error);
+
+		if (SUCCEED == ret && NULL != revision &&
+				SUCCEED == zbx_json_brackets_by_name(&jp_obj, "revision", &jp_revision))
+		{
+			revision_offset = 0;
+			zbx_strncpy_alloc(&revision_buf, &revision_alloc, &revision_offset, jp_revision.start,
+					(size_t)(jp_revision.end - jp_revision.start + 1));
+			zbx_json_addraw(revision, buf, revision_buf);
+		}
 	}
 
 	if (SUCCEED == ret)
@@ -2092,6 +2434,7 @@ void	process_proxyconfig(struct zbx_json_parse *jp_data)
 	{
 		zabbix_log(LOG_LEVEL_ERR, "failed to update local proxy configuration copy: %s",
 				(NULL == error ? "database error" : error));
+		ret = FAIL;
 	}
 	else
 	{
@@ -2099,9 +2442,12 @@ void	process_proxyconfig(struct zbx_json_parse *jp_data)
 		DCupdate_interfaces_availability();
 	}
 
+	zbx_free(revision_buf);
 	zbx_free(error);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
 }
 
 /******************************************************************************
@@ -2292,7 +2638,14 @@ static void	proxy_set_lastid(const char *table_name, const char *lastidfield, co
 
 void	proxy_set_hist_lastid(const zbx_uint64_t lastid)
 {
-	proxy_set_lastid("proxy_history", "history_lastid", lastid);
+	zbx_uint64_t	db_lastid;
+
+	/* with proxy memory buffer the position might refer to buffer records */
+	if (SUCCEED != zbx_pb_history_set_lastid(lastid, &db_lastid))
+		db_lastid = lastid;
+
+	if (0 != db_lastid)
+		proxy_set_lastid("proxy_history", "history_lastid", db_lastid);
 }
 
 void	proxy_set_dhis_lastid(const zbx_uint64_t lastid)
@@ -2310,12 +2663,19 @@ int	proxy_get_delay(const zbx_uint64_t lastid)
 	DB_RESULT	result;
 	DB_ROW		row;
 	char		*sql = NULL;
-	int		ts = 0;
+	int		ts = 0, write_clock;
+	zbx_uint64_t	db_lastid = lastid;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() [lastid=" ZBX_FS_UI64 "]", __func__, lastid);
 
+	if (SUCCEED == zbx_pb_history_get_write_clock(&db_lastid, &write_clock) && 0 != write_clock)
+	{
+		ts = (int)time(NULL) - write_clock;
+		goto out;
+	}
+
 	sql = zbx_dsprintf(sql, "select write_clock from proxy_history where id>" ZBX_FS_UI64 " order by id asc",
-			lastid);
+			db_lastid);
 
 	result = DBselectN(sql, 1);
 	zbx_free(sql);
@@ -2324,7 +2684,7 @@ int	proxy_get_delay(const zbx_uint64_t lastid)
 		ts = (int)time(NULL) - atoi(row[0]);
 
 	DBfree_result(result);
-
+out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
 	return ts;
@@ -2440,6 +2800,45 @@ typedef struct
 }
 zbx_history_data_t;
 
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_history_data_set_strings                                   *
+ *                                                                            *
+ * Purpose: copy history record source and value into string buffer           *
+ *                                                                            *
+ * Parameters: hd                   - [IN/OUT] the history record             *
+ *             source               - [IN] the log source                     *
+ *             value                - [IN] the value                          *
+ *             string_buffer        - [IN/OUT] the string buffer              *
+ *             string_buffer_alloc  - [IN/OUT] the size of string buffer      *
+ *             string_buffer_offset - [IN/OUT] the used size of string buffer *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_history_data_set_strings(zbx_history_data_t *hd, const char *source, const char *value,
+		char **string_buffer, size_t *string_buffer_alloc, size_t *string_buffer_offset)
+{
+	size_t	len1, len2;
+
+	len1 = strlen(source) + 1;
+	len2 = strlen(value) + 1;
+
+	if (*string_buffer_alloc < *string_buffer_offset + len1 + len2)
+	{
+		while (*string_buffer_alloc < *string_buffer_offset + len1 + len2)
+			*string_buffer_alloc += ZBX_KIBIBYTE;
+
+		*string_buffer = (char *)zbx_realloc(*string_buffer, *string_buffer_alloc);
+	}
+
+	hd->source_offset = *string_buffer_offset;
+	memcpy(*string_buffer + hd->source_offset, source, len1);
+	*string_buffer_offset += len1;
+
+	hd->value_offset = *string_buffer_offset;
+	memcpy(*string_buffer + hd->value_offset, value, len2);
+	*string_buffer_offset += len2;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: proxy_get_history_data                                           *
@@ -2539,30 +2938,12 @@ try_again:
 
 			if (0 == (hd->flags & PROXY_HISTORY_FLAG_NOVALUE))
 			{
-				size_t	len1, len2;
-
 				hd->timestamp = atoi(row[4]);
 				hd->severity = atoi(row[6]);
 				hd->logeventid = atoi(row[8]);
 
-				len1 = strlen(row[5]) + 1;
-				len2 = strlen(row[7]) + 1;
-
-				if (*string_buffer_alloc < string_buffer_offset + len1 + len2)
-				{
-					while (*string_buffer_alloc < string_buffer_offset + len1 + len2)
-						*string_buffer_alloc += ZBX_KIBIBYTE;
-
-					*string_buffer = (char *)zbx_realloc(*string_buffer, *string_buffer_alloc);
-				}
-
-				hd->source_offset = string_buffer_offset;
-				memcpy(*string_buffer + hd->source_offset, row[5], len1);
-				string_buffer_offset += len1;
-
-				hd->value_offset = string_buffer_offset;
-				memcpy(*string_buffer + hd->value_offset, row[7], len2);
-				string_buffer_offset += len2;
+				proxy_history_data_set_strings(hd, row[5], row[7], string_buffer, string_buffer_alloc,
+						&string_buffer_offset);
 			}
 
 			if (0 != (hd->flags & PROXY_HISTORY_FLAG_META))
@@ -2584,28 +2965,173 @@ try_again:
 	return data_num;
 }
 
+typedef struct
+{
+	zbx_history_data_t	**data;
+	size_t			*data_alloc;
+	size_t			data_num;
+	char			**string_buffer;
+	size_t			*string_buffer_alloc;
+	size_t			string_buffer_offset;
+}
+zbx_history_data_reader_t;
+
+typedef int	(*zbx_history_data_read_func_t)(zbx_uint64_t lastid, zbx_history_data_t **data, size_t *data_alloc,
+		char **string_buffer, size_t *string_buffer_alloc, int *more);
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_history_data_read_pb                                       *
+ *                                                                            *
+ * Purpose: copy proxy memory buffer record into proxy history data buffer    *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_history_data_read_pb(const zbx_pb_history_t *history, void *cb_data)
+{
+	zbx_history_data_reader_t	*reader = (zbx_history_data_reader_t *)cb_data;
+	zbx_history_data_t		*hd;
+
+	if (*reader->data_alloc == reader->data_num)
+	{
+		*reader->data_alloc *= 2;
+		*reader->data = (zbx_history_data_t *)zbx_realloc(*reader->data,
+				sizeof(zbx_history_data_t) * *reader->data_alloc);
+	}
+
+	hd = *reader->data + reader->data_num++;
+	hd->id = history->id;
+	hd->itemid = history->itemid;
+	hd->flags = history->flags;
+	hd->clock = history->clock;
+	hd->ns = history->ns;
+
+	if (PROXY_HISTORY_FLAG_NOVALUE != (hd->flags & PROXY_HISTORY_MASK_NOVALUE))
+	{
+		hd->state = history->state;
+
+		if (0 == (hd->flags & PROXY_HISTORY_FLAG_NOVALUE))
+		{
+			hd->timestamp = history->timestamp;
+			hd->severity = history->severity;
+			hd->logeventid = history->logeventid;
+
+			proxy_history_data_set_strings(hd, history->source, history->value, reader->string_buffer,
+					reader->string_buffer_alloc, &reader->string_buffer_offset);
+		}
+
+		if (0 != (hd->flags & PROXY_HISTORY_FLAG_META))
+		{
+			hd->lastlogsize = history->lastlogsize;
+			hd->mtime = history->mtime;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_get_history_data_pb                                        *
+ *                                                                            *
+ * Purpose: read proxy history data from proxy memory buffer                  *
+ *                                                                            *
+ * Parameters: see proxy_get_history_data()                                   *
+ *                                                                            *
+ * Return value: The number of records read.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxy_get_history_data_pb(zbx_uint64_t lastid, zbx_history_data_t **data, size_t *data_alloc,
+		char **string_buffer, size_t *string_buffer_alloc, int *more)
+{
+	zbx_history_data_reader_t	reader = {data, data_alloc, 0, string_buffer, string_buffer_alloc, 0};
+
+	if (ZBX_MAX_HRECORDS != zbx_pb_history_get(lastid, ZBX_MAX_HRECORDS, proxy_history_data_read_pb, &reader))
+		*more = ZBX_PROXY_DATA_DONE;
+
+	return (int)reader.data_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_hist_data_size                                             *
+ *                                                                            *
+ * Purpose: get the approximate size of gathered history data                 *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	proxy_hist_data_size(const struct zbx_json *j, const zbx_hb_writer_t *writer)
+{
+	if (NULL == writer)
+		return j->buffer_offset;
+
+	return j->buffer_offset + zbx_hb_writer_size(writer);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_hist_data_prepare_record                                   *
+ *                                                                            *
+ * Purpose: prepare history record for binary history data with the same      *
+ *          fields as added to history data json                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_hist_data_prepare_record(const zbx_history_data_t *hd, const char *string_buffer,
+		zbx_uint64_t id_offset, zbx_hb_record_t *record)
+{
+	memset(record, 0, sizeof(zbx_hb_record_t));
+
+	record->id = hd->id + id_offset;
+	record->itemid = hd->itemid;
+	record->clock = hd->clock;
+	record->ns = hd->ns;
+
+	if (PROXY_HISTORY_FLAG_NOVALUE == (hd->flags & PROXY_HISTORY_MASK_NOVALUE))
+		return;
+
+	record->state = hd->state;
+
+	if (0 == (hd->flags & PROXY_HISTORY_FLAG_NOVALUE))
+	{
+		record->timestamp = hd->timestamp;
+		record->source = string_buffer + hd->source_offset;
+		record->severity = hd->severity;
+		record->logeventid = hd->logeventid;
+		record->value = string_buffer + hd->value_offset;
+	}
+
+	if (0 != (hd->flags & PROXY_HISTORY_FLAG_META))
+	{
+		record->meta = 1;
+		record->lastlogsize = hd->lastlogsize;
+		record->mtime = hd->mtime;
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: proxy_add_hist_data                                              *
  *                                                                            *
- * Purpose: add history records to output json                                *
+ * Purpose: add history records to output json or binary history data         *
  *                                                                            *
  * Parameters: j             - [IN] the json output buffer                    *
+ *             writer        - [IN] the binary history data writer, NULL to   *
+ *                                  add records to json                       *
  *             records_num   - [IN] the total number of records added         *
  *             dc_items      - [IN] the item configuration data               *
  *             errcodes      - [IN] the item configuration status codes       *
  *             records       - [IN] the records to add                        *
  *             string_buffer - [IN] the string buffer holding string values   *
+ *             id_offset     - [IN] the offset to add to record ids when      *
+ *                                  sending them                              *
  *             lastid        - [OUT] the id of last added record              *
  *                                                                            *
  * Return value: The total number of records added.                           *
  *                                                                            *
  ******************************************************************************/
-static int	proxy_add_hist_data(struct zbx_json *j, int records_num, const DC_ITEM *dc_items, const int *errcodes,
-		const zbx_vector_ptr_t *records, const char *string_buffer, zbx_uint64_t *lastid)
+static int	proxy_add_hist_data(struct zbx_json *j, zbx_hb_writer_t *writer, int records_num,
+		const DC_ITEM *dc_items, const int *errcodes, const zbx_vector_ptr_t *records, const char *string_buffer,
+		zbx_uint64_t id_offset, zbx_uint64_t *lastid)
 {
 	int				i;
 	const zbx_history_data_t	*hd;
+	zbx_hb_record_t			record;
 
 	for (i = records->values_num - 1; i >= 0; i--)
 	{
@@ -2627,11 +3153,24 @@ static int	proxy_add_hist_data(struct zbx_json *j, int records_num, const DC_ITE
 				continue;
 		}
 
+		if (NULL != writer)
+		{
+			proxy_hist_data_prepare_record(hd, string_buffer, id_offset, &record);
+			zbx_hb_writer_add(writer, &record);
+			records_num++;
+
+			/* stop gathering data to avoid exceeding the maximum packet size */
+			if (ZBX_DATA_JSON_RECORD_LIMIT < proxy_hist_data_size(j, writer))
+				break;
+
+			continue;
+		}
+
 		if (0 == records_num)
 			zbx_json_addarray(j, ZBX_PROTO_TAG_HISTORY_DATA);
 
 		zbx_json_addobject(j, NULL);
-		zbx_json_adduint64(j, ZBX_PROTO_TAG_ID, hd->id);
+		zbx_json_adduint64(j, ZBX_PROTO_TAG_ID, hd->id + id_offset);
 		zbx_json_adduint64(j, ZBX_PROTO_TAG_ITEMID, hd->itemid);
 		zbx_json_adduint64(j, ZBX_PROTO_TAG_CLOCK, hd->clock);
 		zbx_json_adduint64(j, ZBX_PROTO_TAG_NS, hd->ns);
@@ -2680,19 +3219,45 @@ static int	proxy_add_hist_data(struct zbx_json *j, int records_num, const DC_ITE
 	return records_num;
 }
 
-int	proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_get_hist_data                                              *
+ *                                                                            *
+ * Purpose: add unsent history data to the data sent to server                *
+ *                                                                            *
+ * Parameters: j              - [IN/OUT] the json output buffer               *
+ *             binary_version - [IN] the binary history data format version   *
+ *                                   supported by server, 0 to send history   *
+ *                                   data as json                             *
+ *             lastid         - [OUT] the history position to acknowledge     *
+ *             more           - [OUT] ZBX_PROXY_DATA_MORE if there is more    *
+ *                                    history data to send                    *
+ *                                                                            *
+ * Return value: The number of added records.                                 *
+ *                                                                            *
+ ******************************************************************************/
+int	proxy_get_hist_data(struct zbx_json *j, int binary_version, zbx_uint64_t *lastid, int *more)
 {
-	int			records_num = 0, data_num, i, *errcodes = NULL, items_alloc = 0;
-	zbx_uint64_t		id;
-	zbx_hashset_t		itemids_added;
-	zbx_history_data_t	*data;
-	char			*string_buffer;
-	size_t			data_alloc = 16, string_buffer_alloc = ZBX_KIBIBYTE;
-	zbx_vector_uint64_t	itemids;
-	zbx_vector_ptr_t	records;
-	DC_ITEM			*dc_items = 0;
+	int				records_num = 0, data_num, i, t, *errcodes = NULL, items_alloc = 0, pb_mode,
+					tiers[2], tiers_num = 0, tier_more = ZBX_PROXY_DATA_MORE, db_drained = 0;
+	zbx_uint64_t			id, id_offset, db_offset, db_lastid, db_lastid_start, mem_lastid = 0;
+	zbx_hashset_t			itemids_added;
+	zbx_history_data_t		*data;
+	char				*string_buffer;
+	size_t				data_alloc = 16, string_buffer_alloc = ZBX_KIBIBYTE;
+	zbx_vector_uint64_t		itemids;
+	zbx_vector_ptr_t		records;
+	DC_ITEM				*dc_items = 0;
+	zbx_history_data_read_func_t	read_func;
+	zbx_hb_writer_t			hb_writer, *writer = NULL;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() binary_version:%d", __func__, binary_version);
+
+	if (0 != binary_version)
+	{
+		zbx_hb_writer_init(&hb_writer);
+		writer = &hb_writer;
+	}
 
 	zbx_vector_uint64_create(&itemids);
 	zbx_vector_ptr_create(&records);
@@ -2700,62 +3265,126 @@ int	proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 	string_buffer = (char *)zbx_malloc(NULL, string_buffer_alloc);
 
 	*more = ZBX_PROXY_DATA_MORE;
-	proxy_get_lastid("proxy_history", "history_lastid", &id);
+	proxy_get_lastid("proxy_history", "history_lastid", &db_lastid_start);
+	db_lastid = db_lastid_start;
+
+	/* the values left in proxy memory buffer in database mode are older than the values in database, */
+	/* while in memory mode all values in database have been already sent                             */
+	if (ZBX_PB_MODE_DISABLED != (pb_mode = zbx_pb_history_read_start(&db_offset)))
+		tiers[tiers_num++] = ZBX_PB_MODE_MEMORY;
+
+	if (ZBX_PB_MODE_MEMORY != pb_mode)
+		tiers[tiers_num++] = ZBX_PB_MODE_DATABASE;
 
 	zbx_hashset_create(&itemids_added, data_alloc, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-	/* get history data in batches by ZBX_MAX_HRECORDS records and stop if: */
-	/*   1) there are no more data to read                                  */
-	/*   2) we have retrieved more than the total maximum number of records */
-	/*   3) we have gathered more than half of the maximum packet size      */
-	while (ZBX_DATA_JSON_BATCH_LIMIT > j->buffer_offset && ZBX_MAX_HRECORDS_TOTAL > records_num &&
-			0 != (data_num = proxy_get_history_data(id, &data, &data_alloc, &string_buffer,
-					&string_buffer_alloc, more)))
+	for (t = 0; t < tiers_num; t++)
 	{
-		zbx_vector_uint64_reserve(&itemids, data_num);
-		zbx_vector_ptr_reserve(&records, data_num);
+		if (ZBX_PB_MODE_MEMORY == tiers[t])
+		{
+			read_func = proxy_get_history_data_pb;
+			id = mem_lastid;
+			id_offset = 0;
+		}
+		else
+		{
+			read_func = proxy_get_history_data;
+			id = db_lastid;
+			id_offset = db_offset;
+		}
+
+		tier_more = ZBX_PROXY_DATA_MORE;
 
-		/* filter out duplicate novalue updates */
-		for (i = data_num - 1; i >= 0; i--)
+		/* get history data in batches by ZBX_MAX_HRECORDS records and stop if: */
+		/*   1) there are no more data to read                                  */
+		/*   2) we have retrieved more than the total maximum number of records */
+		/*   3) we have gathered more than half of the maximum packet size      */
+		while (ZBX_DATA_JSON_BATCH_LIMIT > proxy_hist_data_size(j, writer) &&
+				ZBX_MAX_HRECORDS_TOTAL > records_num &&
+				0 != (data_num = read_func(id, &data, &data_alloc, &string_buffer, &string_buffer_alloc,
+						&tier_more)))
 		{
-			if (PROXY_HISTORY_FLAG_NOVALUE == (data[i].flags & PROXY_HISTORY_MASK_NOVALUE))
+			zbx_vector_uint64_reserve(&itemids, data_num);
+			zbx_vector_ptr_reserve(&records, data_num);
+
+			/* filter out duplicate novalue updates */
+			for (i = data_num - 1; i >= 0; i--)
 			{
-				if (NULL != zbx_hashset_search(&itemids_added, &data[i].itemid))
-					continue;
+				if (PROXY_HISTORY_FLAG_NOVALUE == (data[i].flags & PROXY_HISTORY_MASK_NOVALUE))
+				{
+					if (NULL != zbx_hashset_search(&itemids_added, &data[i].itemid))
+						continue;
+
+					zbx_hashset_insert(&itemids_added, &data[i].itemid, sizeof(data[i].itemid));
+				}
 
-				zbx_hashset_insert(&itemids_added, &data[i].itemid, sizeof(data[i].itemid));
+				zbx_vector_ptr_append(&records, &data[i]);
+				zbx_vector_uint64_append(&itemids, data[i].itemid);
 			}
 
-			zbx_vector_ptr_append(&records, &data[i]);
-			zbx_vector_uint64_append(&itemids, data[i].itemid);
-		}
+			/* append history records to json */
+
+			if (itemids.values_num > items_alloc)
+			{
+				items_alloc = itemids.values_num;
+				dc_items = (DC_ITEM *)zbx_realloc(dc_items, items_alloc * sizeof(DC_ITEM));
+				errcodes = (int *)zbx_realloc(errcodes, items_alloc * sizeof(int));
+			}
 
-		/* append history records to json */
+			DCconfig_get_items_by_itemids(dc_items, itemids.values, errcodes, itemids.values_num);
 
-		if (itemids.values_num > items_alloc)
+			records_num = proxy_add_hist_data(j, writer, records_num, dc_items, errcodes, &records,
+					string_buffer, id_offset, &id);
+			DCconfig_clean_items(dc_items, errcodes, itemids.values_num);
+
+			zbx_vector_uint64_clear(&itemids);
+			zbx_vector_ptr_clear(&records);
+			zbx_hashset_clear(&itemids_added);
+
+			/* got less data than requested - either no more data to read or the history is full of */
+			/* holes. In this case send retrieved data before attempting to read/wait for more data */
+			if (ZBX_MAX_HRECORDS > data_num)
+				break;
+		}
+
+		if (ZBX_PB_MODE_MEMORY == tiers[t])
 		{
-			items_alloc = itemids.values_num;
-			dc_items = (DC_ITEM *)zbx_realloc(dc_items, items_alloc * sizeof(DC_ITEM));
-			errcodes = (int *)zbx_realloc(errcodes, items_alloc * sizeof(int));
+			mem_lastid = id;
+		}
+		else
+		{
+			db_lastid = id;
+			db_drained = (ZBX_PROXY_DATA_DONE == tier_more);
 		}
 
-		DCconfig_get_items_by_itemids(dc_items, itemids.values, errcodes, itemids.values_num);
+		if (ZBX_PROXY_DATA_DONE != tier_more)
+			break;
+	}
 
-		records_num = proxy_add_hist_data(j, records_num, dc_items, errcodes, &records, string_buffer, lastid);
-		DCconfig_clean_items(dc_items, errcodes, itemids.values_num);
+	if (t == tiers_num)
+		*more = ZBX_PROXY_DATA_DONE;
 
-		/* got less data than requested - either no more data to read or the history is full of */
-		/* holes. In this case send retrieved data before attempting to read/wait for more data */
-		if (ZBX_MAX_HRECORDS > data_num)
-			break;
+	if (0 != mem_lastid)
+		*lastid = mem_lastid;
+	else if (db_lastid != db_lastid_start)
+		*lastid = db_lastid;
 
-		zbx_vector_uint64_clear(&itemids);
-		zbx_vector_ptr_clear(&records);
-		zbx_hashset_clear(&itemids_added);
-		id = *lastid;
-	}
+	zbx_pb_history_read_end(*lastid, mem_lastid, db_lastid, db_lastid != db_lastid_start, db_drained);
 
-	if (0 != records_num)
+	if (NULL != writer)
+	{
+		if (0 != records_num)
+		{
+			char	*text;
+
+			text = zbx_hb_writer_encode(writer);
+			zbx_json_addstring(j, ZBX_PROTO_TAG_HISTORY_DATA_BINARY, text, ZBX_JSON_TYPE_STRING);
+			zbx_free(text);
+		}
+
+		zbx_hb_writer_clear(writer);
+	}
+	else if (0 != records_num)
 		zbx_json_close(j);
 
 	zbx_hashset_destroy(&itemids_added);
@@ -3184,7 +3813,7 @@ static void	log_client_timediff(int level, struct zbx_json_parse *jp, const zbx_
  *                                                                            *
  * Purpose: parses agent value from history data json row                     *
  *                                                                            *
- * Parameters: jp_row       - [IN] JSON with history data row                 *
+ * Parameters: index        - [IN] the history data row member index          *
  *             unique_shift - [IN/OUT] auto increment nanoseconds to ensure   *
  *                                     unique value of timestamps             *
  *             av           - [OUT] the agent value                           *
@@ -3193,7 +3822,7 @@ static void	log_client_timediff(int level, struct zbx_json_parse *jp, const zbx_
  *                FAIL    - otherwise                                         *
  *                                                                            *
  ******************************************************************************/
-static int	parse_history_data_row_value(const struct zbx_json_parse *jp_row, zbx_timespec_t *unique_shift,
+static int	parse_history_data_row_value(const zbx_json_index_t *index, zbx_timespec_t *unique_shift,
 		zbx_agent_value_t *av)
 {
 	char	*tmp = NULL;
@@ -3202,12 +3831,12 @@ static int	parse_history_data_row_value(const struct zbx_json_parse *jp_row, zbx
 
 	memset(av, 0, sizeof(zbx_agent_value_t));
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_CLOCK, &tmp, &tmp_alloc, NULL))
+	if (SUCCEED == zbx_json_index_value_by_name_dyn(index, ZBX_PROTO_TAG_CLOCK, &tmp, &tmp_alloc, NULL))
 	{
 		if (FAIL == is_uint31(tmp, &av->ts.sec))
 			goto out;
 
-		if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_NS, &tmp, &tmp_alloc, NULL))
+		if (SUCCEED == zbx_json_index_value_by_name_dyn(index, ZBX_PROTO_TAG_NS, &tmp, &tmp_alloc, NULL))
 		{
 			if (FAIL == is_uint_n_range(tmp, tmp_alloc, &av->ts.ns, sizeof(av->ts.ns),
 				0LL, 999999999LL))
@@ -3232,40 +3861,44 @@ static int	parse_history_data_row_value(const struct zbx_json_parse *jp_row, zbx
 	else
 		zbx_timespec(&av->ts);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_STATE, &tmp, &tmp_alloc, NULL))
+	if (SUCCEED == zbx_json_index_value_by_name_dyn(index, ZBX_PROTO_TAG_STATE, &tmp, &tmp_alloc, NULL))
 		av->state = (unsigned char)atoi(tmp);
 
 	/* Unsupported item meta information must be ignored for backwards compatibility. */
 	/* New agents will not send meta information for items in unsupported state.      */
 	if (ITEM_STATE_NOTSUPPORTED != av->state)
 	{
-		if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LASTLOGSIZE, &tmp, &tmp_alloc, NULL))
+		if (SUCCEED == zbx_json_index_value_by_name_dyn(index, ZBX_PROTO_TAG_LASTLOGSIZE, &tmp, &tmp_alloc,
+				NULL))
 		{
 			av->meta = 1;	/* contains meta information */
 
 			is_uint64(tmp, &av->lastlogsize);
 
-			if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_MTIME, &tmp, &tmp_alloc, NULL))
+			if (SUCCEED == zbx_json_index_value_by_name_dyn(index, ZBX_PROTO_TAG_MTIME, &tmp, &tmp_alloc,
+					NULL))
+			{
 				av->mtime = atoi(tmp);
+			}
 		}
 	}
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_VALUE, &tmp, &tmp_alloc, NULL))
+	if (SUCCEED == zbx_json_index_value_by_name_dyn(index, ZBX_PROTO_TAG_VALUE, &tmp, &tmp_alloc, NULL))
 		av->value = zbx_strdup(av->value, tmp);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGTIMESTAMP, &tmp, &tmp_alloc, NULL))
+	if (SUCCEED == zbx_json_index_value_by_name_dyn(index, ZBX_PROTO_TAG_LOGTIMESTAMP, &tmp, &tmp_alloc, NULL))
 		av->timestamp = atoi(tmp);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGSOURCE, &tmp, &tmp_alloc, NULL))
+	if (SUCCEED == zbx_json_index_value_by_name_dyn(index, ZBX_PROTO_TAG_LOGSOURCE, &tmp, &tmp_alloc, NULL))
 		av->source = zbx_strdup(av->source, tmp);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGSEVERITY, &tmp, &tmp_alloc, NULL))
+	if (SUCCEED == zbx_json_index_value_by_name_dyn(index, ZBX_PROTO_TAG_LOGSEVERITY, &tmp, &tmp_alloc, NULL))
 		av->severity = atoi(tmp);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGEVENTID, &tmp, &tmp_alloc, NULL))
+	if (SUCCEED == zbx_json_index_value_by_name_dyn(index, ZBX_PROTO_TAG_LOGEVENTID, &tmp, &tmp_alloc, NULL))
 		av->logeventid = atoi(tmp);
 
-	if (SUCCEED != zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_ID, &tmp, &tmp_alloc, NULL) ||
+	if (SUCCEED != zbx_json_index_value_by_name_dyn(index, ZBX_PROTO_TAG_ID, &tmp, &tmp_alloc, NULL) ||
 			SUCCEED != is_uint64(tmp, &av->id))
 	{
 		av->id = 0;
@@ -3284,18 +3917,18 @@ out:
  *                                                                            *
  * Purpose: parses item identifier from history data json row                 *
  *                                                                            *
- * Parameters: jp_row - [IN] JSON with history data row                       *
+ * Parameters: index  - [IN] the history data row member index                *
  *             itemid - [OUT] the item identifier                             *
  *                                                                            *
  * Return value:  SUCCEED - the item identifier was parsed successfully       *
  *                FAIL    - otherwise                                         *
  *                                                                            *
  ******************************************************************************/
-static int	parse_history_data_row_itemid(const struct zbx_json_parse *jp_row, zbx_uint64_t *itemid)
+static int	parse_history_data_row_itemid(const zbx_json_index_t *index, zbx_uint64_t *itemid)
 {
 	char	buffer[MAX_ID_LEN + 1];
 
-	if (SUCCEED != zbx_json_value_by_name(jp_row, ZBX_PROTO_TAG_ITEMID, buffer, sizeof(buffer), NULL))
+	if (SUCCEED != zbx_json_index_value_by_name(index, ZBX_PROTO_TAG_ITEMID, buffer, sizeof(buffer), NULL))
 		return FAIL;
 
 	if (SUCCEED != is_uint64(buffer, itemid))
@@ -3309,27 +3942,27 @@ static int	parse_history_data_row_itemid(const struct zbx_json_parse *jp_row, zb
  *                                                                            *
  * Purpose: parses host,key pair from history data json row                   *
  *                                                                            *
- * Parameters: jp_row - [IN] JSON with history data row                       *
+ * Parameters: index  - [IN] the history data row member index                *
  *             hk     - [OUT] the host,key pair                               *
  *                                                                            *
  * Return value:  SUCCEED - the host,key pair was parsed successfully         *
  *                FAIL    - otherwise                                         *
  *                                                                            *
  ******************************************************************************/
-static int	parse_history_data_row_hostkey(const struct zbx_json_parse *jp_row, zbx_host_key_t *hk)
+static int	parse_history_data_row_hostkey(const zbx_json_index_t *index, zbx_host_key_t *hk)
 {
 	size_t str_alloc;
 
 	str_alloc = 0;
 	zbx_free(hk->host);
 
-	if (SUCCEED != zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_HOST, &hk->host, &str_alloc, NULL))
+	if (SUCCEED != zbx_json_index_value_by_name_dyn(index, ZBX_PROTO_TAG_HOST, &hk->host, &str_alloc, NULL))
 		return FAIL;
 
 	str_alloc = 0;
 	zbx_free(hk->key);
 
-	if (SUCCEED != zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_KEY, &hk->key, &str_alloc, NULL))
+	if (SUCCEED != zbx_json_index_value_by_name_dyn(index, ZBX_PROTO_TAG_KEY, &hk->key, &str_alloc, NULL))
 	{
 		zbx_free(hk->host);
 		return FAIL;
@@ -3364,10 +3997,13 @@ static int	parse_history_data(struct zbx_json_parse *jp_data, const char **pnext
 		zbx_host_key_t *hostkeys, int *values_num, int *parsed_num, zbx_timespec_t *unique_shift)
 {
 	struct zbx_json_parse	jp_row;
+	zbx_json_index_t	index;
 	int			ret = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	zbx_json_index_init(&index);
+
 	*values_num = 0;
 	*parsed_num = 0;
 
@@ -3391,10 +4027,13 @@ static int	parse_history_data(struct zbx_json_parse *jp_data, const char **pnext
 
 		(*parsed_num)++;
 
-		if (SUCCEED != parse_history_data_row_hostkey(&jp_row, &hostkeys[*values_num]))
+		if (SUCCEED != zbx_json_index_load(&index, &jp_row))
+			continue;
+
+		if (SUCCEED != parse_history_data_row_hostkey(&index, &hostkeys[*values_num]))
 			continue;
 
-		if (SUCCEED != parse_history_data_row_value(&jp_row, unique_shift, &values[*values_num]))
+		if (SUCCEED != parse_history_data_row_value(&index, unique_shift, &values[*values_num]))
 			continue;
 
 		(*values_num)++;
@@ -3403,6 +4042,8 @@ static int	parse_history_data(struct zbx_json_parse *jp_data, const char **pnext
 
 	ret = SUCCEED;
 out:
+	zbx_json_index_clear(&index);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s processed:%d/%d", __func__, zbx_result_string(ret),
 			*values_num, *parsed_num);
 
@@ -3441,10 +4082,13 @@ static int	parse_history_data_by_itemids(struct zbx_json_parse *jp_data, const c
 		zbx_timespec_t *unique_shift, char **error)
 {
 	struct zbx_json_parse	jp_row;
+	zbx_json_index_t	index;
 	int			ret = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	zbx_json_index_init(&index);
+
 	*values_num = 0;
 	*parsed_num = 0;
 
@@ -3468,10 +4112,13 @@ static int	parse_history_data_by_itemids(struct zbx_json_parse *jp_data, const c
 
 		(*parsed_num)++;
 
-		if (SUCCEED != parse_history_data_row_itemid(&jp_row, &itemids[*values_num]))
+		if (SUCCEED != zbx_json_index_load(&index, &jp_row))
+			continue;
+
+		if (SUCCEED != parse_history_data_row_itemid(&index, &itemids[*values_num]))
 			continue;
 
-		if (SUCCEED != parse_history_data_row_value(&jp_row, unique_shift, &values[*values_num]))
+		if (SUCCEED != parse_history_data_row_value(&index, unique_shift, &values[*values_num]))
 			continue;
 
 		(*values_num)++;
@@ -3480,12 +4127,57 @@ static int	parse_history_data_by_itemids(struct zbx_json_parse *jp_data, const c
 
 	ret = SUCCEED;
 out:
+	zbx_json_index_clear(&index);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s processed:%d/%d", __func__, zbx_result_string(ret),
 			*values_num, *parsed_num);
 
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: parse_history_data_binary                                        *
+ *                                                                            *
+ * Purpose: parses up to ZBX_HISTORY_VALUES_MAX item values and item          *
+ *          identifiers from binary history data                              *
+ *                                                                            *
+ * Parameters: reader     - [IN/OUT] the binary history data reader           *
+ *             values     - [OUT] the item values                             *
+ *             itemids    - [OUT] the corresponding item identifiers          *
+ *             values_num - [OUT] number of elements in values and itemids    *
+ *                                arrays                                      *
+ *             parsed_num - [OUT] the number of values parsed                 *
+ *             error      - [OUT] the error message                           *
+ *                                                                            *
+ * Return value:  SUCCEED - values were parsed successfully                   *
+ *                FAIL    - an error occurred                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	parse_history_data_binary(zbx_hb_reader_t *reader, zbx_agent_value_t *values, zbx_uint64_t *itemids,
+		int *values_num, int *parsed_num, char **error)
+{
+	int	ret = SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	for (*values_num = 0; 0 != reader->records_left && *values_num < ZBX_HISTORY_VALUES_MAX; (*values_num)++)
+	{
+		if (SUCCEED != (ret = zbx_hb_reader_read(reader, &itemids[*values_num], &values[*values_num], error)))
+		{
+			zbx_agent_values_clean(values, (size_t)*values_num);
+			*values_num = 0;
+			break;
+		}
+	}
+
+	*parsed_num = *values_num;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s processed:%d", __func__, zbx_result_string(ret), *values_num);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: proxy_item_validator                                             *
@@ -3527,6 +4219,8 @@ static int	proxy_item_validator(DC_ITEM *item, zbx_socket_t *sock, void *args, c
  *                                                                            *
  * Parameters: proxy      - [IN] the proxy                                    *
  *             jp_data    - [IN] JSON with history data array                 *
+ *             reader     - [IN] the binary history data reader, used instead *
+ *                               of jp_data if not NULL                       *
  *             session    - [IN] the data session                             *
  *             nodata_win - [OUT] counter of delayed values                   *
  *             info       - [OUT] address of a pointer to the info            *
@@ -3543,8 +4237,8 @@ static int	proxy_item_validator(DC_ITEM *item, zbx_socket_t *sock, void *args, c
  *                                                                            *
  ******************************************************************************/
 static int	process_history_data_by_itemids(zbx_socket_t *sock, zbx_client_item_validator_t validator_func,
-		void *validator_args, struct zbx_json_parse *jp_data, zbx_data_session_t *session,
-		zbx_proxy_suppress_t *nodata_win, char **info, unsigned int mode)
+		void *validator_args, struct zbx_json_parse *jp_data, zbx_hb_reader_t *reader,
+		zbx_data_session_t *session, zbx_proxy_suppress_t *nodata_win, char **info, unsigned int mode)
 {
 	const char		*pnext = NULL;
 	int			ret = SUCCEED, processed_num = 0, total_num = 0, values_num, read_num, i, *errcodes;
@@ -3562,8 +4256,11 @@ static int	process_history_data_by_itemids(zbx_socket_t *sock, zbx_client_item_v
 
 	sec = zbx_time();
 
-	while (SUCCEED == parse_history_data_by_itemids(jp_data, &pnext, values, itemids, &values_num, &read_num,
-			&unique_shift, &error) && 0 != values_num)
+	while (SUCCEED == (NULL == reader ?
+			parse_history_data_by_itemids(jp_data, &pnext, values, itemids, &values_num, &read_num,
+					&unique_shift, &error) :
+			parse_history_data_binary(reader, values, itemids, &values_num, &read_num, &error)) &&
+			0 != values_num)
 	{
 		DCconfig_get_items_by_itemids_partial(items, itemids, errcodes, (size_t)values_num, mode);
 
@@ -3603,7 +4300,7 @@ static int	process_history_data_by_itemids(zbx_socket_t *sock, zbx_client_item_v
 		DCconfig_clean_items(items, errcodes, values_num);
 		zbx_agent_values_clean(values, values_num);
 
-		if (NULL == pnext)
+		if (NULL == reader && NULL == pnext)
 			break;
 	}
 
@@ -3907,7 +4604,7 @@ static int	process_client_history_data(zbx_socket_t *sock, struct zbx_json_parse
 			session = zbx_dc_get_or_create_data_session(hostid, token);
 
 		if (SUCCEED != (ret = process_history_data_by_itemids(sock, validator_func, validator_args, &jp_data,
-				session, NULL, info, ZBX_ITEM_GET_ALL)))
+				NULL, session, NULL, info, ZBX_ITEM_GET_ALL)))
 		{
 			goto out;
 		}
@@ -4526,7 +5223,7 @@ int	proxy_get_history_count(void)
 
 	DBfree_result(result);
 
-	return count;
+	return count + zbx_pb_history_get_count();
 }
 
 /******************************************************************************
@@ -4557,6 +5254,33 @@ int	zbx_get_proxy_protocol_version(struct zbx_json_parse *jp)
 		return ZBX_COMPONENT_VERSION(3, 2);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_get_history_binary_version                                   *
+ *                                                                            *
+ * Purpose: extracts binary history data format version supported by server   *
+ *          from json data                                                    *
+ *                                                                            *
+ * Parameters: jp - [IN] JSON with server request or response                 *
+ *                                                                            *
+ * Return value: The binary history data format version to use or 0 if        *
+ *               history data must be sent as json.                           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_get_history_binary_version(const struct zbx_json_parse *jp)
+{
+	char	value[MAX_ID_LEN + 1];
+	int	version;
+
+	if (NULL == jp || SUCCEED != zbx_json_value_by_name(jp, ZBX_PROTO_TAG_HISTORY_BINARY, value, sizeof(value),
+			NULL) || SUCCEED != is_uint31(value, &version))
+	{
+		return 0;
+	}
+
+	return MIN(version, ZBX_HISTORY_BINARY_VERSION);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: process_tasks_contents                                           *
@@ -4689,14 +5413,23 @@ int	process_proxy_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_tim
 		unsigned char proxy_status, int *more, char **error)
 {
 	struct zbx_json_parse	jp_data;
-	int			ret = SUCCEED, flags_old;
-	char			*error_step = NULL, value[MAX_STRING_LEN];
-	size_t			error_alloc = 0, error_offset = 0;
+	int			ret = SUCCEED, flags_old, history_json, history_binary = FAIL;
+	char			*error_step = NULL, value[MAX_STRING_LEN], *history_text = NULL;
+	size_t			error_alloc = 0, error_offset = 0, history_text_alloc = 0;
 	zbx_proxy_diff_t	proxy_diff;
-
+	zbx_json_index_t	index;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	/* index the proxy data members to avoid scanning over large history data on each lookup */
+	zbx_json_index_init(&index);
+
+	if (SUCCEED != (ret = zbx_json_index_load(&index, jp)))
+	{
+		*error = zbx_strdup(*error, zbx_json_strerror());
+		goto out;
+	}
+
 	proxy_diff.flags = ZBX_FLAGS_PROXY_DIFF_UNSET;
 	proxy_diff.hostid = proxy->hostid;
 
@@ -4708,7 +5441,7 @@ int	process_proxy_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_tim
 		goto out;
 	}
 
-	if (SUCCEED == zbx_json_value_by_name(jp, ZBX_PROTO_TAG_MORE, value, sizeof(value), NULL))
+	if (SUCCEED == zbx_json_index_value_by_name(&index, ZBX_PROTO_TAG_MORE, value, sizeof(value), NULL))
 		proxy_diff.more_data = atoi(value);
 	else
 		proxy_diff.more_data = ZBX_PROXY_DATA_DONE;
@@ -4716,7 +5449,7 @@ int	process_proxy_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_tim
 	if (NULL != more)
 		*more = proxy_diff.more_data;
 
-	if (SUCCEED == zbx_json_value_by_name(jp, ZBX_PROTO_TAG_PROXY_DELAY, value, sizeof(value), NULL))
+	if (SUCCEED == zbx_json_index_value_by_name(&index, ZBX_PROTO_TAG_PROXY_DELAY, value, sizeof(value), NULL))
 		proxy_diff.proxy_delay = atoi(value);
 	else
 		proxy_diff.proxy_delay = 0;
@@ -4734,7 +5467,7 @@ int	process_proxy_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_tim
 	if (ZBX_FLAGS_PROXY_DIFF_UNSET != proxy_diff.flags)
 		zbx_dc_update_proxy(&proxy_diff);
 
-	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_INTERFACE_AVAILABILITY, &jp_data))
+	if (SUCCEED == zbx_json_index_brackets_by_name(&index, ZBX_PROTO_TAG_INTERFACE_AVAILABILITY, &jp_data))
 	{
 		if (SUCCEED != (ret = process_interfaces_availability_contents(&jp_data, &error_step)))
 			zbx_strcatnl_alloc(error, &error_alloc, &error_offset, error_step);
@@ -4742,11 +5475,18 @@ int	process_proxy_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_tim
 
 	flags_old = proxy_diff.nodata_win.flags;
 
-	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_HISTORY_DATA, &jp_data))
+	if (SUCCEED != (history_json = zbx_json_index_brackets_by_name(&index, ZBX_PROTO_TAG_HISTORY_DATA, &jp_data)))
+	{
+		history_binary = zbx_json_index_value_by_name_dyn(&index, ZBX_PROTO_TAG_HISTORY_DATA_BINARY,
+				&history_text, &history_text_alloc, NULL);
+	}
+
+	if (SUCCEED == history_json || SUCCEED == history_binary)
 	{
 		zbx_data_session_t	*session = NULL;
+		zbx_hb_reader_t		reader, *preader = NULL;
 
-		if (SUCCEED == zbx_json_value_by_name(jp, ZBX_PROTO_TAG_SESSION, value, sizeof(value), NULL))
+		if (SUCCEED == zbx_json_index_value_by_name(&index, ZBX_PROTO_TAG_SESSION, value, sizeof(value), NULL))
 		{
 			size_t	token_len;
 
@@ -4760,12 +5500,26 @@ int	process_proxy_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_tim
 			session = zbx_dc_get_or_create_data_session(proxy->hostid, value);
 		}
 
+		if (SUCCEED == history_binary)
+		{
+			if (SUCCEED != (ret = zbx_hb_reader_open(&reader, history_text, &error_step)))
+			{
+				zbx_strcatnl_alloc(error, &error_alloc, &error_offset, error_step);
+				goto out;
+			}
+
+			preader = &reader;
+		}
+
 		if (SUCCEED != (ret = process_history_data_by_itemids(NULL, proxy_item_validator,
-				(void *)&proxy->hostid, &jp_data, session, &proxy_diff.nodata_win, &error_step,
+				(void *)&proxy->hostid, &jp_data, preader, session, &proxy_diff.nodata_win, &error_step,
 				ZBX_ITEM_GET_PROCESS)))
 		{
 			zbx_strcatnl_alloc(error, &error_alloc, &error_offset, error_step);
 		}
+
+		if (NULL != preader)
+			zbx_hb_reader_close(preader);
 	}
 
 	if (0 != (proxy_diff.nodata_win.flags & ZBX_PROXY_SUPPRESS_ACTIVE))
@@ -4783,22 +5537,24 @@ int	process_proxy_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_tim
 	if (ZBX_FLAGS_PROXY_DIFF_UNSET != proxy_diff.flags)
 		zbx_dc_update_proxy(&proxy_diff);
 
-	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_DISCOVERY_DATA, &jp_data))
+	if (SUCCEED == zbx_json_index_brackets_by_name(&index, ZBX_PROTO_TAG_DISCOVERY_DATA, &jp_data))
 	{
 		if (SUCCEED != (ret = process_discovery_data_contents(&jp_data, &error_step)))
 			zbx_strcatnl_alloc(error, &error_alloc, &error_offset, error_step);
 	}
 
-	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_AUTOREGISTRATION, &jp_data))
+	if (SUCCEED == zbx_json_index_brackets_by_name(&index, ZBX_PROTO_TAG_AUTOREGISTRATION, &jp_data))
 	{
 		if (SUCCEED != (ret = process_autoregistration_contents(&jp_data, proxy->hostid, &error_step)))
 			zbx_strcatnl_alloc(error, &error_alloc, &error_offset, error_step);
 	}
 
-	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_TASKS, &jp_data))
+	if (SUCCEED == zbx_json_index_brackets_by_name(&index, ZBX_PROTO_TAG_TASKS, &jp_data))
 		process_tasks_contents(&jp_data);
 
 out:
+	zbx_json_index_clear(&index);
+	zbx_free(history_text);
 	zbx_free(error_step);
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
@@ -4989,3 +5745,7 @@ int	zbx_check_protocol_version(DC_PROXY *proxy, int version)
 out:
 	return ret;
 }
+
+#ifdef HAVE_TESTS
+#	include "../../../tests/libs/zbxdbhigh/proxyconfig_test.c"
+#endif
@@ -399,9 +399,11 @@ int	diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *json
 	double			time1, time2, time_total = 0;
 	zbx_uint64_t		fields;
 	zbx_diag_map_t		field_map[] = {
-					{"", ZBX_DIAG_PREPROC_VALUES | ZBX_DIAG_PREPROC_VALUES_PREPROC},
+					{"", ZBX_DIAG_PREPROC_VALUES | ZBX_DIAG_PREPROC_VALUES_PREPROC |
+							ZBX_DIAG_PREPROC_REGEXP},
 					{"values", ZBX_DIAG_PREPROC_VALUES},
 					{"preproc.values", ZBX_DIAG_PREPROC_VALUES_PREPROC},
+					{"regexp", ZBX_DIAG_PREPROC_REGEXP},
 					{NULL, 0}
 					};
 
@@ -413,11 +415,12 @@ int	diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *json
 
 		if (0 != (fields & ZBX_DIAG_PREPROC_SIMPLE))
 		{
-			int	total, queued, processing, done, pending;
+			int				total, queued, processing, done, pending;
+			zbx_regexp_cache_stats_t	regexp_stats;
 
 			time1 = zbx_time();
 			if (FAIL == (ret = zbx_preprocessor_get_diag_stats(&total, &queued, &processing, &done,
-					&pending, error)))
+					&pending, &regexp_stats, error)))
 			{
 				goto out;
 			}
@@ -436,6 +439,13 @@ int	diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *json
 				zbx_json_addint64(json, "processing", processing);
 				zbx_json_addint64(json, "pending", pending);
 			}
+			if (0 != (fields & ZBX_DIAG_PREPROC_REGEXP))
+			{
+				zbx_json_adduint64(json, "regexp.cache.entries", regexp_stats.entries);
+				zbx_json_adduint64(json, "regexp.cache.hits", regexp_stats.hits);
+				zbx_json_adduint64(json, "regexp.cache.misses", regexp_stats.misses);
+				zbx_json_adduint64(json, "regexp.cache.evictions", regexp_stats.evictions);
+			}
 		}
 
 		if (0 != tops.values_num)
@@ -501,6 +511,35 @@ static void	zbx_json_addhex(struct zbx_json *j, const char *name, zbx_uint64_t v
 	zbx_json_addstring(j, name, buffer, ZBX_JSON_TYPE_STRING);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: diag_add_lock_stats                                              *
+ *                                                                            *
+ * Purpose: add lock contention statistics to json data                       *
+ *                                                                            *
+ * Parameters: json       - [IN/OUT] the json to update                       *
+ *             stats      - [IN] the mutex or write lock statistics           *
+ *             read_stats - [IN] the read lock statistics, NULL for mutexes   *
+ *                                                                            *
+ ******************************************************************************/
+static void	diag_add_lock_stats(struct zbx_json *json, const zbx_lock_stats_t *stats,
+		const zbx_lock_stats_t *read_stats)
+{
+	if (NULL == read_stats)
+	{
+		zbx_json_adduint64(json, "locks", stats->locks);
+		zbx_json_adduint64(json, "waits", stats->waits);
+		zbx_json_addfloat(json, "wait.time", stats->wait_time);
+		return;
+	}
+
+	zbx_json_adduint64(json, "locks.write", stats->locks);
+	zbx_json_adduint64(json, "waits.write", stats->waits);
+	zbx_json_addfloat(json, "wait.time.write", stats->wait_time);
+	zbx_json_adduint64(json, "waits.read", read_stats->waits);
+	zbx_json_addfloat(json, "wait.time.read", read_stats->wait_time);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: diag_add_locks_info                                              *
@@ -512,19 +551,20 @@ static void	zbx_json_addhex(struct zbx_json *j, const char *name, zbx_uint64_t v
  ******************************************************************************/
 void	diag_add_locks_info(struct zbx_json *json)
 {
-	int		i;
+	int			i;
+	zbx_lock_stats_t	stats, read_stats;
 #ifdef HAVE_VMINFO_T_UPDATES
-	const char	*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
+	const char		*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
 				"ZBX_MUTEX_CACHE_IDS", "ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS", "ZBX_MUTEX_DISKSTATS",
 				"ZBX_MUTEX_VALUECACHE", "ZBX_MUTEX_VMWARE", "ZBX_MUTEX_SQLITE3",
 				"ZBX_MUTEX_PROCSTAT", "ZBX_MUTEX_PROXY_HISTORY", "ZBX_MUTEX_KSTAT", "ZBX_MUTEX_MODBUS",
-				"ZBX_MUTEX_TREND_FUNC"};
+				"ZBX_MUTEX_TREND_FUNC", "ZBX_MUTEX_CONFIG_QUEUE", "ZBX_MUTEX_PROXY_BUFFER"};
 #else
-	const char	*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
+	const char		*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
 				"ZBX_MUTEX_CACHE_IDS", "ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS", "ZBX_MUTEX_DISKSTATS",
 				"ZBX_MUTEX_VALUECACHE", "ZBX_MUTEX_VMWARE", "ZBX_MUTEX_SQLITE3",
 				"ZBX_MUTEX_PROCSTAT", "ZBX_MUTEX_PROXY_HISTORY", "ZBX_MUTEX_MODBUS",
-				"ZBX_MUTEX_TREND_FUNC"};
+				"ZBX_MUTEX_TREND_FUNC", "ZBX_MUTEX_CONFIG_QUEUE", "ZBX_MUTEX_PROXY_BUFFER"};
 #endif
 	zbx_json_addarray(json, ZBX_DIAG_LOCKS);
 
@@ -532,15 +572,39 @@ void	diag_add_locks_info(struct zbx_json *json)
 	{
 		zbx_json_addobject(json, NULL);
 		zbx_json_addhex(json, names[i], (zbx_uint64_t)zbx_mutex_addr_get(i));
+
+		if (SUCCEED == zbx_mutex_get_stats(i, &stats))
+			diag_add_lock_stats(json, &stats, NULL);
+
 		zbx_json_close(json);
 	}
 
 	zbx_json_addobject(json, NULL);
 	zbx_json_addhex(json, "ZBX_RWLOCK_CONFIG", (zbx_uint64_t)zbx_rwlock_addr_get(ZBX_RWLOCK_CONFIG));
+
+	if (SUCCEED == zbx_rwlock_get_stats(ZBX_RWLOCK_CONFIG, &stats, &read_stats))
+		diag_add_lock_stats(json, &stats, &read_stats);
+
 	zbx_json_close(json);
-	zbx_json_addobject(json, NULL);
-	zbx_json_addhex(json, "ZBX_RWLOCK_VALUECACHE", (zbx_uint64_t)zbx_rwlock_addr_get(ZBX_RWLOCK_VALUECACHE));
-	zbx_json_close(json);
+
+	/* the first value cache stripe lock keeps the name used before the cache was split into stripes */
+	for (i = 0; i < ZBX_RWLOCK_VALUECACHE_NUM; i++)
+	{
+		char	name[32];
+
+		if (0 == i)
+			zbx_strlcpy(name, "ZBX_RWLOCK_VALUECACHE", sizeof(name));
+		else
+			zbx_snprintf(name, sizeof(name), "ZBX_RWLOCK_VALUECACHE_%d", i);
+
+		zbx_json_addobject(json, NULL);
+		zbx_json_addhex(json, name, (zbx_uint64_t)zbx_rwlock_addr_get(ZBX_RWLOCK_VALUECACHE + i));
+
+		if (SUCCEED == zbx_rwlock_get_stats(ZBX_RWLOCK_VALUECACHE + i, &stats, &read_stats))
+			diag_add_lock_stats(json, &stats, &read_stats);
+
+		zbx_json_close(json);
+	}
 
 	zbx_json_close(json);
 }
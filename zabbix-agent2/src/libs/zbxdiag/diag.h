@@ -51,9 +51,11 @@
 
 #define ZBX_DIAG_PREPROC_VALUES			0x00000001
 #define ZBX_DIAG_PREPROC_VALUES_PREPROC		0x00000002
+#define ZBX_DIAG_PREPROC_REGEXP			0x00000004
 
 #define ZBX_DIAG_PREPROC_SIMPLE		(ZBX_DIAG_PREPROC_VALUES | \
-					ZBX_DIAG_PREPROC_VALUES_PREPROC)
+					ZBX_DIAG_PREPROC_VALUES_PREPROC | \
+					ZBX_DIAG_PREPROC_REGEXP)
 
 #define ZBX_DIAG_LLD_RULES		0x00000001
 #define ZBX_DIAG_LLD_VALUES		0x00000002
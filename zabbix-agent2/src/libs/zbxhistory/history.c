@@ -182,6 +182,62 @@ int	zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int c
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: zbx_history_get_updated_itemids                                        *
+ *                                                                                  *
+ * Purpose: gets items having values newer than the specified time                  *
+ *                                                                                  *
+ * Parameters: value_type - [IN] the value type of items                            *
+ *             itemids    - [IN] the items to check                                 *
+ *             clock      - [IN] the time                                           *
+ *             updated    - [OUT] the items having values after the specified time  *
+ *                                                                                  *
+ * Return value: SUCCEED - the items were checked successfully                      *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: History storage that cannot check multiple items at once is queried    *
+ *           for the last value of each item.                                       *
+ *                                                                                  *
+ ************************************************************************************/
+int	zbx_history_get_updated_itemids(int value_type, const zbx_vector_uint64_t *itemids, int clock,
+		zbx_vector_uint64_t *updated)
+{
+	int				i, ret = SUCCEED;
+	zbx_history_iface_t		*writer = &history_ifaces[value_type];
+	zbx_vector_history_record_t	values;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() value_type:%d items:%d clock:%d", __func__, value_type,
+			itemids->values_num, clock);
+
+	if (NULL != writer->get_updated_itemids)
+	{
+		ret = writer->get_updated_itemids(writer, itemids, clock, updated);
+		goto out;
+	}
+
+	zbx_history_record_vector_create(&values);
+
+	for (i = 0; i < itemids->values_num; i++)
+	{
+		if (SUCCEED != (ret = writer->get_values(writer, itemids->values[i], clock, 1, ZBX_JAN_2038, &values)))
+			break;
+
+		if (0 != values.values_num)
+		{
+			zbx_vector_uint64_append(updated, itemids->values[i]);
+			zbx_history_record_vector_clean(&values, value_type);
+		}
+	}
+
+	zbx_history_record_vector_destroy(&values, value_type);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s updated:%d", __func__, zbx_result_string(ret),
+			updated->values_num);
+
+	return ret;
+}
+
 /************************************************************************************
  *                                                                                  *
  * Function: zbx_history_requires_trends                                            *
@@ -32,6 +32,8 @@ typedef int (*zbx_history_add_values_func_t)(struct zbx_history_iface *hist, con
 typedef int (*zbx_history_get_values_func_t)(struct zbx_history_iface *hist, zbx_uint64_t itemid, int start,
 		int count, int end, zbx_vector_history_record_t *values);
 typedef int (*zbx_history_flush_func_t)(struct zbx_history_iface *hist);
+typedef int (*zbx_history_get_updated_itemids_func_t)(struct zbx_history_iface *hist,
+		const zbx_vector_uint64_t *itemids, int clock, zbx_vector_uint64_t *updated);
 
 struct zbx_history_iface
 {
@@ -43,6 +45,9 @@ struct zbx_history_iface
 	zbx_history_add_values_func_t	add_values;
 	zbx_history_get_values_func_t	get_values;
 	zbx_history_flush_func_t	flush;
+
+	/* optional, when not set the items are checked with get_values function */
+	zbx_history_get_updated_itemids_func_t	get_updated_itemids;
 };
 
 /* SQL hist */
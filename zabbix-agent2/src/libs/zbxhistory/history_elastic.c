@@ -23,6 +23,7 @@
 #include "dbcache.h"
 #include "zbxhistory.h"
 #include "zbxself.h"
+#include "zbxcompress.h"
 #include "history.h"
 
 /* curl_multi_wait() is supported starting with version 7.28.0 (0x071c00) */
@@ -33,6 +34,12 @@
 #define		ZBX_IDX_JSON_ALLOCATE		256
 #define		ZBX_JSON_ALLOCATE		2048
 
+/* the maximum uncompressed size of bulk request body, larger batches are split into several requests */
+#define		ZBX_ELASTIC_BULK_SIZE_MAX	ZBX_MEBIBYTE
+
+/* the maximum number of bulk requests per value type being sent at the same time */
+#define		ZBX_ELASTIC_BULK_REQUESTS_MAX	4
+
 const char	*value_type_str[] = {"dbl", "str", "log", "uint", "text"};
 
 extern char	*CONFIG_HISTORY_STORAGE_URL;
@@ -44,22 +51,11 @@ typedef struct
 {
 	char	*base_url;
 	char	*post_url;
-	char	*buf;
+	char	*bulk_url;
 	CURL	*handle;
 }
 zbx_elastic_data_t;
 
-typedef struct
-{
-	unsigned char		initialized;
-	zbx_vector_ptr_t	ifaces;
-
-	CURLM			*handle;
-}
-zbx_elastic_writer_t;
-
-static zbx_elastic_writer_t	writer;
-
 typedef struct
 {
 	char	*data;
@@ -70,14 +66,38 @@ zbx_httppage_t;
 
 static zbx_httppage_t	page_r;
 
+/* bulk request, the body contains index action and source lines of every document */
 typedef struct
 {
-	zbx_httppage_t	page;
-	char		errbuf[CURL_ERROR_SIZE];
+	zbx_history_iface_t	*hist;
+	CURL			*handle;
+	char			*body;
+	size_t			body_alloc;
+	size_t			body_offset;
+	zbx_vector_uint64_t	docs;		/* the body offsets of documents */
+	char			*gzip;		/* the compressed body */
+	size_t			gzip_size;
+	zbx_httppage_t		page;
+	char			errbuf[CURL_ERROR_SIZE];
 }
-zbx_curlpage_t;
+zbx_elastic_request_t;
 
-static zbx_curlpage_t	page_w[ITEM_VALUE_TYPE_MAX];
+typedef struct
+{
+	unsigned char		initialized;
+	zbx_vector_ptr_t	queue;		/* the requests waiting to be sent */
+	zbx_vector_ptr_t	sending;	/* the requests being sent */
+	zbx_vector_ptr_t	retries;	/* the failed requests to be sent again */
+	int			active[ITEM_VALUE_TYPE_MAX];	/* the number of requests being sent per type */
+	struct curl_slist	*headers;
+	struct curl_slist	*headers_gzip;
+
+	/* the multi handle is kept between flushes to reuse its keep-alive connections */
+	CURLM			*handle;
+}
+zbx_elastic_writer_t;
+
+static zbx_elastic_writer_t	writer;
 
 static size_t	curl_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
@@ -231,102 +251,345 @@ static void	elastic_close(zbx_history_iface_t *hist)
 {
 	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
 
-	zbx_free(data->buf);
 	zbx_free(data->post_url);
 
 	if (NULL != data->handle)
 	{
-		if (NULL != writer.handle)
-			curl_multi_remove_handle(writer.handle, data->handle);
-
 		curl_easy_cleanup(data->handle);
 		data->handle = NULL;
 	}
 }
 
-/******************************************************************************
- *                                                                            *
- * Function: elastic_is_error_present                                         *
- *                                                                            *
- * Purpose: check a error from Elastic json response                          *
- *                                                                            *
- * Parameters: page - [IN]  the buffer with json response                     *
- *             err  - [OUT] the parse error message. If the error value is    *
- *                           set it must be freed by caller after it has      *
- *                           been used.                                       *
- *                                                                            *
- * Return value: SUCCEED - the response contains an error                     *
- *               FAIL    - otherwise                                          *
- *                                                                            *
- ******************************************************************************/
-static int	elastic_is_error_present(zbx_httppage_t *page, char **err)
+/******************************************************************************************************************
+ *                                                                                                                *
+ * common sql service support                                                                                     *
+ *                                                                                                                *
+ ******************************************************************************************************************/
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_request_create                                                 *
+ *                                                                                  *
+ * Purpose: creates bulk request                                                    *
+ *                                                                                  *
+ * Parameters: hist - [IN] the history storage interface                            *
+ *                                                                                  *
+ * Return value: the created bulk request                                           *
+ *                                                                                  *
+ ************************************************************************************/
+static zbx_elastic_request_t	*elastic_request_create(zbx_history_iface_t *hist)
+{
+	zbx_elastic_request_t	*request;
+
+	request = (zbx_elastic_request_t *)zbx_malloc(NULL, sizeof(zbx_elastic_request_t));
+	memset(request, 0, sizeof(zbx_elastic_request_t));
+	request->hist = hist;
+	zbx_vector_uint64_create(&request->docs);
+
+	return request;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_request_free                                                   *
+ *                                                                                  *
+ * Purpose: frees bulk request                                                      *
+ *                                                                                  *
+ * Parameters: request - [IN] the bulk request                                      *
+ *                                                                                  *
+ * Comments: The request must not be added to writer multi handle.                  *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_request_free(zbx_elastic_request_t *request)
+{
+	if (NULL != request->handle)
+		curl_easy_cleanup(request->handle);
+
+	zbx_vector_uint64_destroy(&request->docs);
+	zbx_free(request->page.data);
+	zbx_free(request->gzip);
+	zbx_free(request->body);
+	zbx_free(request);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_request_add_doc                                                *
+ *                                                                                  *
+ * Purpose: adds document to bulk request body                                      *
+ *                                                                                  *
+ * Parameters: request - [IN] the bulk request                                      *
+ *             doc     - [IN] the document index action and source lines            *
+ *             doc_len - [IN] the document length                                   *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_request_add_doc(zbx_elastic_request_t *request, const char *doc, size_t doc_len)
+{
+	zbx_vector_uint64_append(&request->docs, request->body_offset);
+	zbx_strncpy_alloc(&request->body, &request->body_alloc, &request->body_offset, doc, doc_len);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_request_start                                                  *
+ *                                                                                  *
+ * Purpose: starts sending bulk request                                             *
+ *                                                                                  *
+ * Parameters: request - [IN] the bulk request                                      *
+ *                                                                                  *
+ * Return value: SUCCEED - the request was added to writer multi handle             *
+ *               FAIL    - otherwise                                                *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_request_start(zbx_elastic_request_t *request)
+{
+	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)request->hist->data;
+	CURLoption		opt;
+	CURLcode		err;
+	const char		*body;
+	size_t			body_size;
+	struct curl_slist	*headers;
+
+	if (NULL == (request->handle = curl_easy_init()))
+	{
+		zabbix_log(LOG_LEVEL_ERR, "cannot initialize cURL session");
+		return FAIL;
+	}
+
+	/* bodies are compressed once and sent compressed again if the whole request must be retried */
+	if (NULL == request->gzip && SUCCEED != zbx_compress_gzip(request->body, request->body_offset,
+			&request->gzip, &request->gzip_size))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot compress bulk request: %s", zbx_compress_strerror());
+	}
+
+	if (NULL != request->gzip)
+	{
+		body = request->gzip;
+		body_size = request->gzip_size;
+		headers = writer.headers_gzip;
+	}
+	else
+	{
+		body = request->body;
+		body_size = request->body_offset;
+		headers = writer.headers;
+	}
+
+	if (CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_URL, data->bulk_url)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_POST, 1L)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_POSTFIELDSIZE,
+					(long)body_size)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_POSTFIELDS, body)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_HTTPHEADER, headers)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_WRITEFUNCTION,
+					curl_write_cb)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_WRITEDATA,
+					&request->page)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_FAILONERROR, 1L)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_ERRORBUFFER,
+					request->errbuf)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_PRIVATE, request)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->handle, opt = ZBX_CURLOPT_ACCEPT_ENCODING, "")))
+	{
+		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
+		goto out;
+	}
+
+	*request->errbuf = '\0';
+	request->page.offset = 0;
+
+	if (0 < request->page.alloc)
+		*request->page.data = '\0';
+
+	zabbix_log(LOG_LEVEL_DEBUG, "sending %s", request->body);
+
+	if (CURLM_OK != curl_multi_add_handle(writer.handle, request->handle))
+	{
+		zabbix_log(LOG_LEVEL_ERR, "cannot add cURL handle to multi handle");
+		goto out;
+	}
+
+	writer.active[request->hist->value_type]++;
+	zbx_vector_ptr_append(&writer.sending, request);
+
+	return SUCCEED;
+out:
+	curl_easy_cleanup(request->handle);
+	request->handle = NULL;
+
+	return FAIL;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_request_check                                                  *
+ *                                                                                  *
+ * Purpose: checks bulk response for failed documents                               *
+ *                                                                                  *
+ * Parameters: request - [IN] the completed bulk request                            *
+ *                                                                                  *
+ * Return value: the request with failed documents to be sent again or NULL         *
+ *                                                                                  *
+ * Comments: Documents rejected with 400 status code are malformed, so there is no  *
+ *           sense in sending them again. Other errors are caused by elastic        *
+ *           internal problems (for example an index became read-only) and the      *
+ *           documents are retried.                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+static zbx_elastic_request_t	*elastic_request_check(const zbx_elastic_request_t *request)
 {
 	struct zbx_json_parse	jp, jp_values, jp_index, jp_error, jp_items, jp_item;
 	const char		*errors, *p = NULL;
 	char			*index = NULL, *status = NULL, *type = NULL, *reason = NULL;
-	size_t			index_alloc = 0, status_alloc = 0, type_alloc = 0, reason_alloc = 0;
-	int			rc_js = SUCCEED;
+	size_t			index_alloc = 0, status_alloc = 0, type_alloc = 0, reason_alloc = 0, doc_end;
+	int			rc_js = SUCCEED, doc_num = 0, failed_num = 0;
+	zbx_elastic_request_t	*retry = NULL;
 
-	zabbix_log(LOG_LEVEL_TRACE, "%s() raw json: %s", __func__, ZBX_NULL2EMPTY_STR(page->data));
+	zabbix_log(LOG_LEVEL_TRACE, "%s() raw json: %s", __func__, ZBX_NULL2EMPTY_STR(request->page.data));
 
-	if (SUCCEED != zbx_json_open(page->data, &jp) || SUCCEED != zbx_json_brackets_open(jp.start, &jp_values))
-		return FAIL;
+	if (SUCCEED != zbx_json_open(request->page.data, &jp) ||
+			SUCCEED != zbx_json_brackets_open(jp.start, &jp_values))
+	{
+		return NULL;
+	}
 
 	if (NULL == (errors = zbx_json_pair_by_name(&jp_values, "errors")) || 0 != strncmp("true", errors, 4))
-		return FAIL;
+		return NULL;
+
+	if (SUCCEED != zbx_json_brackets_by_name(&jp, "items", &jp_items))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "%s() cannot send data to elasticsearch: elasticsearch version is not"
+				" fully compatible with zabbix server", __func__);
+		return NULL;
+	}
 
-	if (SUCCEED == zbx_json_brackets_by_name(&jp, "items", &jp_items))
+	for (; NULL != (p = zbx_json_next(&jp_items, p)); doc_num++)
 	{
-		while (NULL != (p = zbx_json_next(&jp_items, p)))
+		if (doc_num >= request->docs.values_num)
+			break;
+
+		if (SUCCEED != zbx_json_brackets_open(p, &jp_item) ||
+				SUCCEED != zbx_json_brackets_by_name(&jp_item, "index", &jp_index) ||
+				SUCCEED != zbx_json_brackets_by_name(&jp_index, "error", &jp_error))
 		{
-			if (SUCCEED == zbx_json_brackets_open(p, &jp_item) &&
-					SUCCEED == zbx_json_brackets_by_name(&jp_item, "index", &jp_index) &&
-					SUCCEED == zbx_json_brackets_by_name(&jp_index, "error", &jp_error))
-			{
-				if (SUCCEED != zbx_json_value_by_name_dyn(&jp_error, "type", &type, &type_alloc, NULL))
-					rc_js = FAIL;
-				if (SUCCEED != zbx_json_value_by_name_dyn(&jp_error, "reason", &reason, &reason_alloc, NULL))
-					rc_js = FAIL;
-			}
-			else
-				continue;
+			continue;
+		}
+
+		if (SUCCEED != zbx_json_value_by_name_dyn(&jp_index, "status", &status, &status_alloc, NULL))
+			rc_js = FAIL;
 
-			if (SUCCEED != zbx_json_value_by_name_dyn(&jp_index, "status", &status, &status_alloc, NULL))
+		/* remember the first error for logging */
+		if (0 == failed_num++)
+		{
+			if (SUCCEED != zbx_json_value_by_name_dyn(&jp_error, "type", &type, &type_alloc, NULL))
+				rc_js = FAIL;
+			if (SUCCEED != zbx_json_value_by_name_dyn(&jp_error, "reason", &reason, &reason_alloc, NULL))
 				rc_js = FAIL;
 			if (SUCCEED != zbx_json_value_by_name_dyn(&jp_index, "_index", &index, &index_alloc, NULL))
 				rc_js = FAIL;
 
-			break;
+			zabbix_log(LOG_LEVEL_WARNING, "%s() cannot send data to elasticsearch: index:%s status:%s"
+					" type:%s reason:%s%s", __func__, ZBX_NULL2EMPTY_STR(index),
+					ZBX_NULL2EMPTY_STR(status), ZBX_NULL2EMPTY_STR(type),
+					ZBX_NULL2EMPTY_STR(reason), FAIL == rc_js ? " / elasticsearch version is not"
+					" fully compatible with zabbix server" : "");
 		}
+
+		if (NULL != status && 0 == strcmp(status, "400"))
+			continue;
+
+		if (NULL == retry)
+			retry = elastic_request_create(request->hist);
+
+		if (doc_num + 1 < request->docs.values_num)
+			doc_end = (size_t)request->docs.values[doc_num + 1];
+		else
+			doc_end = request->body_offset;
+
+		elastic_request_add_doc(retry, request->body + request->docs.values[doc_num],
+				doc_end - (size_t)request->docs.values[doc_num]);
 	}
-	else
-		rc_js = FAIL;
 
-	*err = zbx_dsprintf(NULL,"index:%s status:%s type:%s reason:%s%s", ZBX_NULL2EMPTY_STR(index),
-			ZBX_NULL2EMPTY_STR(status), ZBX_NULL2EMPTY_STR(type), ZBX_NULL2EMPTY_STR(reason),
-			FAIL == rc_js ? " / elasticsearch version is not fully compatible with zabbix server" : "");
+	if (1 < failed_num)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "%s() cannot send %d of %d documents to elasticsearch, %d will be"
+				" sent again", __func__, failed_num, request->docs.values_num,
+				NULL == retry ? 0 : retry->docs.values_num);
+	}
 
 	zbx_free(status);
 	zbx_free(type);
 	zbx_free(reason);
 	zbx_free(index);
 
-	return SUCCEED;
+	return retry;
 }
 
-/******************************************************************************************************************
- *                                                                                                                *
- * common sql service support                                                                                     *
- *                                                                                                                *
- ******************************************************************************************************************/
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_request_done                                                   *
+ *                                                                                  *
+ * Purpose: processes completed bulk request                                        *
+ *                                                                                  *
+ * Parameters: request - [IN] the bulk request                                      *
+ *             result  - [IN] the transfer result                                   *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_request_done(zbx_elastic_request_t *request, CURLcode result)
+{
+	zbx_elastic_request_t	*retry;
 
+	/* If the error is due to malformed data, there is no sense on re-trying to send. */
+	/* That's why we actually check for transport and curl errors separately */
+	if (CURLE_HTTP_RETURNED_ERROR == result)
+	{
+		if ('\0' != *request->errbuf)
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot send data to elasticsearch, HTTP error message: %s",
+					request->errbuf);
+		}
+		else
+		{
+			char		http_status[MAX_STRING_LEN];
+			long int	response_code;
 
+			if (CURLE_OK == curl_easy_getinfo(request->handle, CURLINFO_RESPONSE_CODE, &response_code))
+				zbx_snprintf(http_status, sizeof(http_status), "HTTP status code: %ld", response_code);
+			else
+				zbx_strlcpy(http_status, "unknown HTTP status code", sizeof(http_status));
+
+			zabbix_log(LOG_LEVEL_ERR, "cannot send data to elasticsearch, %s", http_status);
+		}
+
+		elastic_request_free(request);
+	}
+	else if (CURLE_OK != result)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send data to elasticsearch: %s",
+				'\0' != *request->errbuf ? request->errbuf : curl_easy_strerror(result));
+
+		/* If the error is due to curl internal problems or unrelated */
+		/* problems with HTTP, the whole request is sent again        */
+		curl_easy_cleanup(request->handle);
+		request->handle = NULL;
+		zbx_vector_ptr_append(&writer.retries, request);
+	}
+	else
+	{
+		/* only the documents failed due to elastic internal problems are sent again */
+		if (NULL != (retry = elastic_request_check(request)))
+			zbx_vector_ptr_append(&writer.retries, retry);
+
+		elastic_request_free(request);
+	}
+}
 
 /************************************************************************************
  *                                                                                  *
  * Function: elastic_writer_init                                                    *
  *                                                                                  *
- * Purpose: initializes elastic writer for a new batch of history values            *
+ * Purpose: initializes elastic writer                                              *
  *                                                                                  *
  ************************************************************************************/
 static void	elastic_writer_init(void)
@@ -334,7 +597,10 @@ static void	elastic_writer_init(void)
 	if (0 != writer.initialized)
 		return;
 
-	zbx_vector_ptr_create(&writer.ifaces);
+	zbx_vector_ptr_create(&writer.queue);
+	zbx_vector_ptr_create(&writer.sending);
+	zbx_vector_ptr_create(&writer.retries);
+	memset(writer.active, 0, sizeof(writer.active));
 
 	if (NULL == (writer.handle = curl_multi_init()))
 	{
@@ -342,9 +608,39 @@ static void	elastic_writer_init(void)
 		exit(EXIT_FAILURE);
 	}
 
+	writer.headers = curl_slist_append(NULL, "Content-Type: application/x-ndjson");
+	writer.headers_gzip = curl_slist_append(NULL, "Content-Type: application/x-ndjson");
+	writer.headers_gzip = curl_slist_append(writer.headers_gzip, "Content-Encoding: gzip");
+
 	writer.initialized = 1;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_writer_clear                                                   *
+ *                                                                                  *
+ * Purpose: drops all requests of elastic writer                                    *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_writer_clear(void)
+{
+	int			i;
+	zbx_elastic_request_t	*request;
+
+	for (i = 0; i < writer.sending.values_num; i++)
+	{
+		request = (zbx_elastic_request_t *)writer.sending.values[i];
+		curl_multi_remove_handle(writer.handle, request->handle);
+		elastic_request_free(request);
+	}
+
+	zbx_vector_ptr_clear(&writer.sending);
+	memset(writer.active, 0, sizeof(writer.active));
+
+	zbx_vector_ptr_clear_ext(&writer.queue, (zbx_clean_func_t)elastic_request_free);
+	zbx_vector_ptr_clear_ext(&writer.retries, (zbx_clean_func_t)elastic_request_free);
+}
+
 /************************************************************************************
  *                                                                                  *
  * Function: elastic_writer_release                                                 *
@@ -355,78 +651,120 @@ static void	elastic_writer_init(void)
  ************************************************************************************/
 static void	elastic_writer_release(void)
 {
-	int	i;
+	if (0 == writer.initialized)
+		return;
 
-	for (i = 0; i < writer.ifaces.values_num; i++)
-		elastic_close((zbx_history_iface_t *)writer.ifaces.values[i]);
+	elastic_writer_clear();
 
 	curl_multi_cleanup(writer.handle);
 	writer.handle = NULL;
 
-	zbx_vector_ptr_destroy(&writer.ifaces);
+	curl_slist_free_all(writer.headers);
+	curl_slist_free_all(writer.headers_gzip);
+
+	zbx_vector_ptr_destroy(&writer.retries);
+	zbx_vector_ptr_destroy(&writer.sending);
+	zbx_vector_ptr_destroy(&writer.queue);
 
 	writer.initialized = 0;
 }
 
 /************************************************************************************
  *                                                                                  *
- * Function: elastic_writer_add_iface                                               *
+ * Function: elastic_writer_perform                                                 *
+ *                                                                                  *
+ * Purpose: starts queued requests and processes completed ones                     *
  *                                                                                  *
- * Purpose: adds history storage interface to be flushed later                      *
+ * Parameters: timeout - [IN] the time to wait for network activity in              *
+ *                            milliseconds, 0 - do not wait                         *
  *                                                                                  *
- * Parameters: db_insert - [IN] bulk insert data                                    *
+ * Return value: SUCCEED - the requests were processed                              *
+ *               FAIL    - cURL multi handle error                                  *
  *                                                                                  *
  ************************************************************************************/
-static void	elastic_writer_add_iface(zbx_history_iface_t *hist)
+static int	elastic_writer_perform(int timeout)
 {
-	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
-	CURLoption		opt;
-	CURLcode		err;
-
-	elastic_writer_init();
+	int			i, running, msgnum, fds;
+	CURLMsg			*msg;
+	CURLMcode		code;
+	zbx_elastic_request_t	*request;
 
-	if (NULL == (data->handle = curl_easy_init()))
+	/* start queued requests in the order of queueing, limiting concurrent requests per value type */
+	for (i = 0; i < writer.queue.values_num;)
 	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot initialize cURL session");
-		return;
+		request = (zbx_elastic_request_t *)writer.queue.values[i];
+
+		if (ZBX_ELASTIC_BULK_REQUESTS_MAX <= writer.active[request->hist->value_type])
+		{
+			i++;
+			continue;
+		}
+
+		zbx_vector_ptr_remove(&writer.queue, i);
+
+		if (SUCCEED != elastic_request_start(request))
+			elastic_request_free(request);
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_URL, data->post_url)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POST, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, data->buf)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEFUNCTION,
-					curl_write_cb)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEDATA,
-					&page_w[hist->value_type].page)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_FAILONERROR, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_ERRORBUFFER,
-					page_w[hist->value_type].errbuf)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = ZBX_CURLOPT_ACCEPT_ENCODING, "")))
+	if (CURLM_OK != (code = curl_multi_perform(writer.handle, &running)))
 	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
-		goto out;
+		zabbix_log(LOG_LEVEL_ERR, "cannot perform on curl multi handle: %s", curl_multi_strerror(code));
+		return FAIL;
 	}
 
-	*page_w[hist->value_type].errbuf = '\0';
-
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_PRIVATE, &page_w[hist->value_type])))
+	while (NULL != (msg = curl_multi_info_read(writer.handle, &msgnum)))
 	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
-		goto out;
+		if (CURLMSG_DONE != msg->msg)
+			continue;
+
+		if (CURLE_OK != curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&request))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot get request of cURL handle");
+			return FAIL;
+		}
+
+		curl_multi_remove_handle(writer.handle, msg->easy_handle);
+
+		if (FAIL != (i = zbx_vector_ptr_search(&writer.sending, request, ZBX_DEFAULT_PTR_COMPARE_FUNC)))
+			zbx_vector_ptr_remove_noorder(&writer.sending, i);
+
+		writer.active[request->hist->value_type]--;
+
+		elastic_request_done(request, msg->data.result);
 	}
 
-	page_w[hist->value_type].page.offset = 0;
+	if (0 != timeout && 0 != writer.sending.values_num && 0 == writer.queue.values_num)
+	{
+		if (CURLM_OK != (code = curl_multi_wait(writer.handle, NULL, 0, timeout, &fds)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot wait on curl multi handle: %s", curl_multi_strerror(code));
+			return FAIL;
+		}
+	}
 
-	if (0 < page_w[hist->value_type].page.alloc)
-		*page_w[hist->value_type].page.data = '\0';
+	return SUCCEED;
+}
 
-	curl_multi_add_handle(writer.handle, data->handle);
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_writer_add_request                                             *
+ *                                                                                  *
+ * Purpose: queues bulk request and starts sending it if possible                   *
+ *                                                                                  *
+ * Parameters: request - [IN] the bulk request                                      *
+ *                                                                                  *
+ * Comments: The request is sent while the next requests are being prepared, the    *
+ *           sending is finished by elastic_writer_flush() function.                *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_writer_add_request(zbx_elastic_request_t *request)
+{
+	elastic_writer_init();
 
-	zbx_vector_ptr_append(&writer.ifaces, hist);
+	zbx_vector_ptr_append(&writer.queue, request);
 
-	return;
-out:
-	elastic_close(hist);
+	if (SUCCEED != elastic_writer_perform(0))
+		elastic_writer_clear();
 }
 
 /************************************************************************************
@@ -438,156 +776,35 @@ out:
  ************************************************************************************/
 static int	elastic_writer_flush(void)
 {
-	struct curl_slist	*curl_headers = NULL;
-	int			i, running, previous, msgnum;
-	CURLMsg			*msg;
-	zbx_vector_ptr_t	retries;
-	CURLcode		err;
-	int			ret = SUCCEED;
+	int	ret = SUCCEED;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	/* The writer might be uninitialized only if the history */
-	/* was already flushed. In that case, return SUCCEED */
+	/* The writer might be uninitialized only if no history */
+	/* was sent yet. In that case, return SUCCEED */
 	if (0 == writer.initialized)
 		goto end;
 
-	zbx_vector_ptr_create(&retries);
-
-	curl_headers = curl_slist_append(curl_headers, "Content-Type: application/x-ndjson");
-
-	for (i = 0; i < writer.ifaces.values_num; i++)
+	while (0 != writer.queue.values_num || 0 != writer.sending.values_num || 0 != writer.retries.values_num)
 	{
-		zbx_history_iface_t	*hist = (zbx_history_iface_t *)writer.ifaces.values[i];
-		zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
-
-		if (CURLE_OK != (err = curl_easy_setopt(data->handle, CURLOPT_HTTPHEADER, curl_headers)))
+		/* When all requests are completed and there are failed requests, we put them back in */
+		/* the queue and try sending the data again after sleeping for                        */
+		/* ZBX_HISTORY_STORAGE_DOWN / 1000 (seconds)                                          */
+		if (0 == writer.queue.values_num && 0 == writer.sending.values_num)
 		{
-			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)CURLOPT_HTTPHEADER,
-					curl_easy_strerror(err));
-			ret = FAIL;
-			goto clean;
-		}
-
-		zabbix_log(LOG_LEVEL_DEBUG, "sending %s", data->buf);
-	}
-
-try_again:
-	previous = 0;
-
-	do
-	{
-		int		fds;
-		CURLMcode	code;
-		char		*error;
-		zbx_curlpage_t	*curl_page;
+			sleep(ZBX_HISTORY_STORAGE_DOWN / 1000);
 
-		if (CURLM_OK != (code = curl_multi_perform(writer.handle, &running)))
-		{
-			zabbix_log(LOG_LEVEL_ERR, "cannot perform on curl multi handle: %s", curl_multi_strerror(code));
-			break;
+			zbx_vector_ptr_append_array(&writer.queue, writer.retries.values, writer.retries.values_num);
+			zbx_vector_ptr_clear(&writer.retries);
 		}
 
-		if (CURLM_OK != (code = curl_multi_wait(writer.handle, NULL, 0, ZBX_HISTORY_STORAGE_DOWN, &fds)))
+		if (SUCCEED != elastic_writer_perform(ZBX_HISTORY_STORAGE_DOWN))
 		{
-			zabbix_log(LOG_LEVEL_ERR, "cannot wait on curl multi handle: %s", curl_multi_strerror(code));
+			elastic_writer_clear();
+			ret = FAIL;
 			break;
 		}
-
-		if (previous == running)
-			continue;
-
-		while (NULL != (msg = curl_multi_info_read(writer.handle, &msgnum)))
-		{
-			/* If the error is due to malformed data, there is no sense on re-trying to send. */
-			/* That's why we actually check for transport and curl errors separately */
-			if (CURLE_HTTP_RETURNED_ERROR == msg->data.result)
-			{
-				if (CURLE_OK == curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE,
-						(char **)&curl_page) && '\0' != *curl_page->errbuf)
-				{
-					zabbix_log(LOG_LEVEL_ERR, "cannot send data to elasticsearch, HTTP error"
-							" message: %s", curl_page->errbuf);
-				}
-				else
-				{
-					char		http_status[MAX_STRING_LEN];
-					long int	response_code;
-
-					if (CURLE_OK == curl_easy_getinfo(msg->easy_handle,
-							CURLINFO_RESPONSE_CODE, &response_code))
-					{
-						zbx_snprintf(http_status, sizeof(http_status), "HTTP status code: %ld",
-								response_code);
-					}
-					else
-					{
-						zbx_strlcpy(http_status, "unknown HTTP status code",
-								sizeof(http_status));
-					}
-
-					zabbix_log(LOG_LEVEL_ERR, "cannot send data to elasticsearch, %s", http_status);
-				}
-			}
-			else if (CURLE_OK != msg->data.result)
-			{
-				if (CURLE_OK == curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE,
-						(char **)&curl_page) && '\0' != *curl_page->errbuf)
-				{
-					zabbix_log(LOG_LEVEL_WARNING, "cannot send data to elasticsearch: %s",
-							curl_page->errbuf);
-				}
-				else
-				{
-					zabbix_log(LOG_LEVEL_WARNING, "cannot send data to elasticsearch: %s",
-							curl_easy_strerror(msg->data.result));
-				}
-
-				/* If the error is due to curl internal problems or unrelated */
-				/* problems with HTTP, we put the handle in a retry list and */
-				/* remove it from the current execution loop */
-				zbx_vector_ptr_append(&retries, msg->easy_handle);
-				curl_multi_remove_handle(writer.handle, msg->easy_handle);
-			}
-			else if (CURLE_OK == curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&curl_page)
-					&& SUCCEED == elastic_is_error_present(&curl_page->page, &error))
-			{
-				zabbix_log(LOG_LEVEL_WARNING, "%s() cannot send data to elasticsearch: %s",
-						__func__, error);
-				zbx_free(error);
-
-				/* If the error is due to elastic internal problems (for example an index */
-				/* became read-only), we put the handle in a retry list and */
-				/* remove it from the current execution loop */
-				zbx_vector_ptr_append(&retries, msg->easy_handle);
-				curl_multi_remove_handle(writer.handle, msg->easy_handle);
-			}
-		}
-
-		previous = running;
-	}
-	while (running);
-
-	/* We check if we have handles to retry. If yes, we put them back in the multi */
-	/* handle and go to the beginning of the do while() for try sending the data again */
-	/* after sleeping for ZBX_HISTORY_STORAGE_DOWN / 1000 (seconds) */
-	if (0 < retries.values_num)
-	{
-		for (i = 0; i < retries.values_num; i++)
-			curl_multi_add_handle(writer.handle, retries.values[i]);
-
-		zbx_vector_ptr_clear(&retries);
-
-		sleep(ZBX_HISTORY_STORAGE_DOWN / 1000);
-		goto try_again;
 	}
-clean:
-	curl_slist_free_all(curl_headers);
-
-	zbx_vector_ptr_destroy(&retries);
-
-	elastic_writer_release();
-
 end:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
@@ -614,7 +831,9 @@ static void	elastic_destroy(zbx_history_iface_t *hist)
 	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
 
 	elastic_close(hist);
+	elastic_writer_release();
 
+	zbx_free(data->bulk_url);
 	zbx_free(data->base_url);
 	zbx_free(data);
 }
@@ -880,12 +1099,12 @@ out:
  ************************************************************************************/
 static int	elastic_add_values(zbx_history_iface_t *hist, const zbx_vector_ptr_t *history)
 {
-	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
 	int			i, num = 0;
 	ZBX_DC_HISTORY		*h;
 	struct zbx_json		json_idx, json;
-	size_t			buf_alloc = 0, buf_offset = 0;
-	char			pipeline[14]; /* index name length + suffix "-pipeline" */
+	char			*doc = NULL, pipeline[14]; /* index name length + suffix "-pipeline" */
+	size_t			doc_alloc = 0, doc_offset;
+	zbx_elastic_request_t	*request = NULL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -934,19 +1153,30 @@ static int	elastic_add_values(zbx_history_iface_t *hist, const zbx_vector_ptr_t
 
 		zbx_json_close(&json);
 
-		zbx_snprintf_alloc(&data->buf, &buf_alloc, &buf_offset, "%s\n%s\n", json_idx.buffer, json.buffer);
+		doc_offset = 0;
+		zbx_snprintf_alloc(&doc, &doc_alloc, &doc_offset, "%s\n%s\n", json_idx.buffer, json.buffer);
 
 		zbx_json_free(&json);
 
+		/* send the request when it's full, so the bulk body size is limited */
+		if (NULL != request && ZBX_ELASTIC_BULK_SIZE_MAX < request->body_offset + doc_offset)
+		{
+			elastic_writer_add_request(request);
+			request = NULL;
+		}
+
+		if (NULL == request)
+			request = elastic_request_create(hist);
+
+		elastic_request_add_doc(request, doc, doc_offset);
+
 		num++;
 	}
 
-	if (num > 0)
-	{
-		data->post_url = zbx_dsprintf(NULL, "%s/_bulk?refresh=true", data->base_url);
-		elastic_writer_add_iface(hist);
-	}
+	if (NULL != request)
+		elastic_writer_add_request(request);
 
+	zbx_free(doc);
 	zbx_json_free(&json_idx);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -1001,7 +1231,7 @@ int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type
 	memset(data, 0, sizeof(zbx_elastic_data_t));
 	data->base_url = zbx_strdup(NULL, CONFIG_HISTORY_STORAGE_URL);
 	zbx_rtrim(data->base_url, "/");
-	data->buf = NULL;
+	data->bulk_url = zbx_dsprintf(NULL, "%s/_bulk?refresh=true", data->base_url);
 	data->post_url = NULL;
 	data->handle = NULL;
 
@@ -1011,6 +1241,7 @@ int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type
 	hist->add_values = elastic_add_values;
 	hist->flush = elastic_flush;
 	hist->get_values = elastic_get_values;
+	hist->get_updated_itemids = NULL;
 	hist->requires_trends = 0;
 
 	return SUCCEED;
@@ -29,11 +29,17 @@ typedef struct
 {
 	unsigned char		initialized;
 	zbx_vector_ptr_t	dbinserts;
+#ifdef HAVE_POSTGRESQL
+	zbx_vector_ptr_t	dbcopies;
+#endif
 }
 zbx_sql_writer_t;
 
 static zbx_sql_writer_t	writer;
 
+extern int	CONFIG_DOUBLE_PRECISION;
+extern int	CONFIG_HISTORY_BULK_LOAD;
+
 typedef void (*vc_str2value_func_t)(history_value_t *value, DB_ROW row);
 
 /* history table data */
@@ -107,6 +113,9 @@ static void	sql_writer_init(void)
 		return;
 
 	zbx_vector_ptr_create(&writer.dbinserts);
+#ifdef HAVE_POSTGRESQL
+	zbx_vector_ptr_create(&writer.dbcopies);
+#endif
 
 	writer.initialized = 1;
 }
@@ -133,6 +142,18 @@ static void	sql_writer_release(void)
 	zbx_vector_ptr_clear(&writer.dbinserts);
 	zbx_vector_ptr_destroy(&writer.dbinserts);
 
+#ifdef HAVE_POSTGRESQL
+	for (i = 0; i < writer.dbcopies.values_num; i++)
+	{
+		zbx_db_copy_t	*db_copy = (zbx_db_copy_t *)writer.dbcopies.values[i];
+
+		zbx_db_copy_clean(db_copy);
+		zbx_free(db_copy);
+	}
+	zbx_vector_ptr_clear(&writer.dbcopies);
+	zbx_vector_ptr_destroy(&writer.dbcopies);
+#endif
+
 	writer.initialized = 0;
 }
 
@@ -151,6 +172,23 @@ static void	sql_writer_add_dbinsert(zbx_db_insert_t *db_insert)
 	zbx_vector_ptr_append(&writer.dbinserts, db_insert);
 }
 
+#ifdef HAVE_POSTGRESQL
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_writer_add_dbcopy                                                  *
+ *                                                                                  *
+ * Purpose: adds bulk load data to be flushed later                                 *
+ *                                                                                  *
+ * Parameters: db_copy - [IN] bulk load data                                        *
+ *                                                                                  *
+ ************************************************************************************/
+static void	sql_writer_add_dbcopy(zbx_db_copy_t *db_copy)
+{
+	sql_writer_init();
+	zbx_vector_ptr_append(&writer.dbcopies, db_copy);
+}
+#endif
+
 /************************************************************************************
  *                                                                                  *
  * Function: sql_writer_flush                                                       *
@@ -176,6 +214,13 @@ static int	sql_writer_flush(void)
 			zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)writer.dbinserts.values[i];
 			zbx_db_insert_execute(db_insert);
 		}
+#ifdef HAVE_POSTGRESQL
+		for (i = 0; i < writer.dbcopies.values_num; i++)
+		{
+			zbx_db_copy_t	*db_copy = (zbx_db_copy_t *)writer.dbcopies.values[i];
+			zbx_db_copy_execute(db_copy);
+		}
+#endif
 	}
 	while (ZBX_DB_DOWN == (txn_error = DBcommit()));
 
@@ -337,6 +382,135 @@ static void	add_history_log(zbx_vector_ptr_t *history)
 	sql_writer_add_dbinsert(db_insert);
 }
 
+#ifdef HAVE_POSTGRESQL
+/******************************************************************************************************************
+ *                                                                                                                *
+ * database bulk loading support, values are sent in binary format with copy from stdin statement               *
+ *                                                                                                                *
+ ******************************************************************************************************************/
+
+/******************************************************************************
+ *                                                                            *
+ * Function: copy_history_dbl                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	copy_history_dbl(const zbx_vector_ptr_t *history)
+{
+	int		i;
+	zbx_db_copy_t	*db_copy;
+
+	db_copy = (zbx_db_copy_t *)zbx_malloc(NULL, sizeof(zbx_db_copy_t));
+	zbx_db_copy_prepare(db_copy, "history", "itemid", "clock", "ns", "value", NULL);
+
+	for (i = 0; i < history->values_num; i++)
+	{
+		const ZBX_DC_HISTORY	*h = (ZBX_DC_HISTORY *)history->values[i];
+
+		if (ITEM_VALUE_TYPE_FLOAT != h->value_type)
+			continue;
+
+		zbx_db_copy_add_values(db_copy, h->itemid, h->ts.sec, h->ts.ns, h->value.dbl);
+	}
+
+	sql_writer_add_dbcopy(db_copy);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: copy_history_uint                                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	copy_history_uint(const zbx_vector_ptr_t *history)
+{
+	int		i;
+	zbx_db_copy_t	*db_copy;
+
+	db_copy = (zbx_db_copy_t *)zbx_malloc(NULL, sizeof(zbx_db_copy_t));
+	zbx_db_copy_prepare(db_copy, "history_uint", "itemid", "clock", "ns", "value", NULL);
+
+	for (i = 0; i < history->values_num; i++)
+	{
+		const ZBX_DC_HISTORY	*h = (ZBX_DC_HISTORY *)history->values[i];
+
+		if (ITEM_VALUE_TYPE_UINT64 != h->value_type)
+			continue;
+
+		zbx_db_copy_add_values(db_copy, h->itemid, h->ts.sec, h->ts.ns, h->value.ui64);
+	}
+
+	sql_writer_add_dbcopy(db_copy);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: copy_history_str                                                 *
+ *                                                                            *
+ * Purpose: bulk load string values into history_str or history_text table    *
+ *                                                                            *
+ ******************************************************************************/
+static void	copy_history_str_ext(const zbx_vector_ptr_t *history, unsigned char value_type, const char *table)
+{
+	int		i;
+	zbx_db_copy_t	*db_copy;
+
+	db_copy = (zbx_db_copy_t *)zbx_malloc(NULL, sizeof(zbx_db_copy_t));
+	zbx_db_copy_prepare(db_copy, table, "itemid", "clock", "ns", "value", NULL);
+
+	for (i = 0; i < history->values_num; i++)
+	{
+		const ZBX_DC_HISTORY	*h = (ZBX_DC_HISTORY *)history->values[i];
+
+		if (value_type != h->value_type)
+			continue;
+
+		zbx_db_copy_add_values(db_copy, h->itemid, h->ts.sec, h->ts.ns, h->value.str);
+	}
+
+	sql_writer_add_dbcopy(db_copy);
+}
+
+static void	copy_history_str(const zbx_vector_ptr_t *history)
+{
+	copy_history_str_ext(history, ITEM_VALUE_TYPE_STR, "history_str");
+}
+
+static void	copy_history_text(const zbx_vector_ptr_t *history)
+{
+	copy_history_str_ext(history, ITEM_VALUE_TYPE_TEXT, "history_text");
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: copy_history_log                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	copy_history_log(const zbx_vector_ptr_t *history)
+{
+	int		i;
+	zbx_db_copy_t	*db_copy;
+
+	db_copy = (zbx_db_copy_t *)zbx_malloc(NULL, sizeof(zbx_db_copy_t));
+	zbx_db_copy_prepare(db_copy, "history_log", "itemid", "clock", "ns", "timestamp", "source", "severity",
+			"value", "logeventid", NULL);
+
+	for (i = 0; i < history->values_num; i++)
+	{
+		const ZBX_DC_HISTORY	*h = (ZBX_DC_HISTORY *)history->values[i];
+		const zbx_log_value_t	*log;
+
+		if (ITEM_VALUE_TYPE_LOG != h->value_type)
+			continue;
+
+		log = h->value.log;
+
+		zbx_db_copy_add_values(db_copy, h->itemid, h->ts.sec, h->ts.ns, log->timestamp,
+				ZBX_NULL2EMPTY_STR(log->source), log->severity, log->value, log->logeventid);
+	}
+
+	sql_writer_add_dbcopy(db_copy);
+}
+#endif
+
 /******************************************************************************************************************
  *                                                                                                                *
  * database reading support                                                                                       *
@@ -664,6 +838,52 @@ static int	sql_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, int st
 	return db_read_values_by_time_and_count(itemid, hist->value_type, values, end - start, count, end);
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_get_updated_itemids                                                *
+ *                                                                                  *
+ * Purpose: gets items having values newer than the specified time                  *
+ *                                                                                  *
+ * Parameters:  hist    - [IN] the history storage interface                        *
+ *              itemids - [IN] the items to check                                   *
+ *              clock   - [IN] the time                                             *
+ *              updated - [OUT] the items having values after the specified time    *
+ *                                                                                  *
+ * Return value: SUCCEED - the items were checked successfully                      *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ ************************************************************************************/
+static int	sql_get_updated_itemids(zbx_history_iface_t *hist, const zbx_vector_uint64_t *itemids, int clock,
+		zbx_vector_uint64_t *updated)
+{
+	char			*sql = NULL;
+	size_t	 		sql_alloc = 0, sql_offset = 0;
+	DB_RESULT		result;
+	DB_ROW			row;
+	zbx_uint64_t		itemid;
+	zbx_vc_history_table_t	*table = &vc_history_tables[hist->value_type];
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select distinct itemid from %s where clock>%d and",
+			table->name, clock);
+	DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids->values, itemids->values_num);
+
+	result = DBselect("%s", sql);
+
+	zbx_free(sql);
+
+	if (NULL == result)
+		return FAIL;
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		ZBX_STR2UINT64(itemid, row[0]);
+		zbx_vector_uint64_append(updated, itemid);
+	}
+	DBfree_result(result);
+
+	return SUCCEED;
+}
+
 /************************************************************************************
  *                                                                                  *
  * Function: sql_add_values                                                         *
@@ -738,6 +958,7 @@ int	zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, ch
 	hist->add_values = sql_add_values;
 	hist->flush = sql_flush;
 	hist->get_values = sql_get_values;
+	hist->get_updated_itemids = sql_get_updated_itemids;
 
 	switch (value_type)
 	{
@@ -758,6 +979,33 @@ int	zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, ch
 			break;
 	}
 
+#ifdef HAVE_POSTGRESQL
+	/* when enabled history is bulk loaded with binary copy instead of multi-row inserts */
+	if (1 == CONFIG_HISTORY_BULK_LOAD)
+	{
+		switch (value_type)
+		{
+			case ITEM_VALUE_TYPE_FLOAT:
+				/* binary double values can be loaded only into double precision columns */
+				if (ZBX_DB_DBL_PRECISION_ENABLED == CONFIG_DOUBLE_PRECISION)
+					hist->data = (void *)copy_history_dbl;
+				break;
+			case ITEM_VALUE_TYPE_UINT64:
+				hist->data = (void *)copy_history_uint;
+				break;
+			case ITEM_VALUE_TYPE_STR:
+				hist->data = (void *)copy_history_str;
+				break;
+			case ITEM_VALUE_TYPE_TEXT:
+				hist->data = (void *)copy_history_text;
+				break;
+			case ITEM_VALUE_TYPE_LOG:
+				hist->data = (void *)copy_history_log;
+				break;
+		}
+	}
+#endif
+
 	hist->requires_trends = 1;
 
 	return SUCCEED;
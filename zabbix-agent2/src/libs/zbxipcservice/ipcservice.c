@@ -1,3 +1,12 @@
+#include "config.h"
+
+#ifdef HAVE_SYS_SOCKET_H
+#	if !defined(_GNU_SOURCE)
+#		define _GNU_SOURCE	/* required for getting peer credentials */
+#	endif
+#	include <sys/socket.h>
+#endif
+
 #include "common.h"
 
 #ifdef HAVE_IPCSERVICE
@@ -62,6 +71,53 @@ struct zbx_ipc_client
 #define ZBX_IPC_MESSAGE_CODE	0
 #define ZBX_IPC_MESSAGE_SIZE	1
 
+/* reserved message codes of the shared memory transport, handled internally and never passed to users */
+#define ZBX_IPC_CODE_SHM_ATTACH		0xfffffffe
+#define ZBX_IPC_CODE_SHM_MESSAGE	0xffffffff
+
+/* smaller messages are written to socket with a single system call and are not worth the ring */
+#define ZBX_IPC_SHM_MESSAGE_MIN		ZBX_IPC_SOCKET_BUFFER_SIZE
+
+#define ZBX_IPC_SHM_LINE_SIZE		64
+
+#define ZBX_IPC_SHM_STATE_NONE		0
+#define ZBX_IPC_SHM_STATE_PENDING	1
+#define ZBX_IPC_SHM_STATE_READY		2
+#define ZBX_IPC_SHM_STATE_DISABLED	3
+
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+#	define ZBX_IPC_SHM_ENABLED
+#endif
+
+/* Shared memory segment header, followed by the ring data. Client copies large messages into */
+/* the ring and sends only doorbell messages with the message code and size through socket.   */
+typedef struct
+{
+	/* set by service after attaching to the segment */
+	zbx_uint32_t	attached;
+	char		pad1[ZBX_IPC_SHM_LINE_SIZE - sizeof(zbx_uint32_t)];
+
+	/* the total number of bytes read by service */
+	zbx_uint32_t	tail;
+	char		pad2[ZBX_IPC_SHM_LINE_SIZE - sizeof(zbx_uint32_t)];
+}
+zbx_ipc_shm_header_t;
+
+struct zbx_ipc_shm
+{
+	int			shmid;
+	zbx_ipc_shm_header_t	*header;
+	unsigned char		*buffer;
+
+	/* the ring size, power of two */
+	zbx_uint32_t		size;
+
+	/* the total number of bytes written (client side) or read (service side) */
+	zbx_uint32_t		position;
+
+	unsigned char		state;
+};
+
 #if !defined(LIBEVENT_VERSION_NUMBER) || LIBEVENT_VERSION_NUMBER < 0x2000000
 typedef int evutil_socket_t;
 
@@ -512,6 +568,380 @@ out:
 	return ret;
 }
 
+#if defined(ZBX_IPC_SHM_ENABLED)
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_free                                                     *
+ *                                                                            *
+ * Purpose: detaches socket from the shared memory ring                       *
+ *                                                                            *
+ * Parameters: csocket - [IN/OUT] the IPC socket                              *
+ *                                                                            *
+ * Comments: The segment is marked for removal when both sides have attached  *
+ *           to it. If service did not attach yet, the segment is removed     *
+ *           here.                                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_shm_free(zbx_ipc_socket_t *csocket)
+{
+	zbx_ipc_shm_t	*shm = csocket->shm;
+
+	if (NULL == shm)
+		return;
+
+	if (NULL != shm->header)
+		(void)shmdt((void *)shm->header);
+
+	if (ZBX_IPC_SHM_STATE_PENDING == shm->state)
+		(void)shmctl(shm->shmid, IPC_RMID, NULL);
+
+	zbx_free(csocket->shm);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_create                                                   *
+ *                                                                            *
+ * Purpose: creates shared memory ring and asks service to attach to it       *
+ *                                                                            *
+ * Parameters: csocket - [IN/OUT] the IPC socket                              *
+ *                                                                            *
+ * Comments: The ring is not used until service has attached to it, messages  *
+ *           are sent through socket meanwhile. On failure the shared memory  *
+ *           transport is disabled for this socket.                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_shm_create(zbx_ipc_socket_t *csocket)
+{
+	zbx_ipc_shm_t	*shm = csocket->shm;
+	void		*addr;
+	zbx_uint32_t	request[2], tx_size;
+
+	shm->state = ZBX_IPC_SHM_STATE_DISABLED;
+
+	if (-1 == (shm->shmid = shmget(IPC_PRIVATE, sizeof(zbx_ipc_shm_header_t) + shm->size,
+			IPC_CREAT | IPC_EXCL | 0600)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot allocate shared memory for IPC messages: %s",
+				zbx_strerror(errno));
+		return;
+	}
+
+	if ((void *)(-1) == (addr = shmat(shm->shmid, NULL, 0)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot attach shared memory for IPC messages: %s", zbx_strerror(errno));
+		(void)shmctl(shm->shmid, IPC_RMID, NULL);
+		return;
+	}
+
+	shm->header = (zbx_ipc_shm_header_t *)addr;
+	shm->buffer = (unsigned char *)addr + sizeof(zbx_ipc_shm_header_t);
+	memset(shm->header, 0, sizeof(zbx_ipc_shm_header_t));
+
+	/* service checks that the segment was created by the process connected to the socket */
+	request[0] = (zbx_uint32_t)shm->shmid;
+	request[1] = shm->size;
+
+	if (FAIL == ipc_socket_write_message(csocket, ZBX_IPC_CODE_SHM_ATTACH, (const unsigned char *)request,
+			sizeof(request), &tx_size) || sizeof(request) + ZBX_IPC_HEADER_SIZE != tx_size)
+	{
+		(void)shmdt(addr);
+		(void)shmctl(shm->shmid, IPC_RMID, NULL);
+		shm->header = NULL;
+		return;
+	}
+
+	shm->state = ZBX_IPC_SHM_STATE_PENDING;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_write                                                    *
+ *                                                                            *
+ * Purpose: writes message data into shared memory ring                       *
+ *                                                                            *
+ * Parameters: csocket - [IN/OUT] the IPC socket                              *
+ *             data    - [IN] the data                                        *
+ *             size    - [IN] the data size                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the data was written into ring, the caller must    *
+ *                         send doorbell message through socket               *
+ *               FAIL    - the ring cannot be used, the message must be sent  *
+ *                         through socket                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_write(zbx_ipc_socket_t *csocket, const unsigned char *data, zbx_uint32_t size)
+{
+	zbx_ipc_shm_t	*shm = csocket->shm;
+	zbx_uint32_t	offset, part;
+
+	if (NULL == shm || ZBX_IPC_SHM_MESSAGE_MIN > size)
+		return FAIL;
+
+	switch (shm->state)
+	{
+		case ZBX_IPC_SHM_STATE_NONE:
+			ipc_shm_create(csocket);
+			return FAIL;
+		case ZBX_IPC_SHM_STATE_PENDING:
+			if (0 == __atomic_load_n(&shm->header->attached, __ATOMIC_ACQUIRE))
+				return FAIL;
+
+			/* both sides are attached, make sure the segment is released when the last one detaches */
+			/* or exits even if service failed to mark it for removal                                  */
+			(void)shmctl(shm->shmid, IPC_RMID, NULL);
+			shm->state = ZBX_IPC_SHM_STATE_READY;
+			break;
+		case ZBX_IPC_SHM_STATE_DISABLED:
+			return FAIL;
+	}
+
+	/* the ring is full - fall back to socket, the doorbells keep messages ordered */
+	if (shm->size - (shm->position - __atomic_load_n(&shm->header->tail, __ATOMIC_ACQUIRE)) < size)
+		return FAIL;
+
+	offset = shm->position & (shm->size - 1);
+
+	if (size > (part = shm->size - offset))
+	{
+		memcpy(shm->buffer + offset, data, part);
+		memcpy(shm->buffer, data + part, size - part);
+	}
+	else
+		memcpy(shm->buffer + offset, data, size);
+
+	shm->position += size;
+
+	/* the data must be visible to service before it receives doorbell */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_get_peer_pid                                             *
+ *                                                                            *
+ * Purpose: gets identifier of the process connected to IPC socket            *
+ *                                                                            *
+ * Parameters: csocket - [IN] the IPC socket                                  *
+ *             pid     - [OUT] the peer process identifier                    *
+ *                                                                            *
+ * Return value: SUCCEED - the process identifier was returned                *
+ *               FAIL    - peer credentials are not available                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_get_peer_pid(const zbx_ipc_socket_t *csocket, pid_t *pid)
+{
+#if defined(__linux__) && defined(SO_PEERCRED)
+	struct ucred	cred;
+	socklen_t	len = sizeof(cred);
+
+	if (0 != getsockopt(csocket->fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) || sizeof(cred) != len)
+		return FAIL;
+
+	*pid = cred.pid;
+
+	return SUCCEED;
+#else
+	ZBX_UNUSED(csocket);
+	ZBX_UNUSED(pid);
+
+	return FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_attach                                                   *
+ *                                                                            *
+ * Purpose: attaches service side of the socket to client's shared memory     *
+ *          ring                                                              *
+ *                                                                            *
+ * Parameters: csocket - [IN/OUT] the IPC socket                              *
+ *             data    - [IN] the attach request data                         *
+ *             size    - [IN] the attach request data size                    *
+ *                                                                            *
+ * Comments: Only segments created by the process connected to the socket     *
+ *           are accepted, the process is identified by the kernel. Without   *
+ *           peer credentials the request is ignored and client keeps sending *
+ *           messages through socket.                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_shm_attach(zbx_ipc_socket_t *csocket, const unsigned char *data, zbx_uint32_t size)
+{
+	zbx_uint32_t	request[2];
+	struct shmid_ds	ds;
+	void		*addr;
+	int		shmid;
+	pid_t		pid;
+
+	if (sizeof(request) != size || NULL != csocket->shm)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "unexpected IPC shared memory attach request");
+		return;
+	}
+
+	if (SUCCEED != ipc_shm_get_peer_pid(csocket, &pid))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot get IPC peer credentials, shared memory transport is disabled");
+		return;
+	}
+
+	memcpy(request, data, sizeof(request));
+	shmid = (int)request[0];
+
+	/* accept only a segment of the expected size, created by the connected process */
+	if (-1 == shmctl(shmid, IPC_STAT, &ds) || ds.shm_cpid != pid || ds.shm_perm.cuid != geteuid() ||
+			sizeof(zbx_ipc_shm_header_t) + request[1] != ds.shm_segsz ||
+			0 == request[1] || 0 != (request[1] & (request[1] - 1)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "invalid IPC shared memory attach request");
+		return;
+	}
+
+	if ((void *)(-1) == (addr = shmat(shmid, NULL, 0)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot attach IPC shared memory: %s", zbx_strerror(errno));
+		return;
+	}
+
+	/* both sides are attached, the segment will be released when the last one detaches */
+	(void)shmctl(shmid, IPC_RMID, NULL);
+
+	csocket->shm = (zbx_ipc_shm_t *)zbx_malloc(NULL, sizeof(zbx_ipc_shm_t));
+	csocket->shm->shmid = shmid;
+	csocket->shm->header = (zbx_ipc_shm_header_t *)addr;
+	csocket->shm->buffer = (unsigned char *)addr + sizeof(zbx_ipc_shm_header_t);
+	csocket->shm->size = request[1];
+	csocket->shm->position = __atomic_load_n(&csocket->shm->header->tail, __ATOMIC_ACQUIRE);
+	csocket->shm->state = ZBX_IPC_SHM_STATE_READY;
+
+	__atomic_store_n(&csocket->shm->header->attached, 1, __ATOMIC_RELEASE);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_check_doorbell                                           *
+ *                                                                            *
+ * Purpose: validates doorbell message received through socket                *
+ *                                                                            *
+ * Parameters: csocket - [IN] the IPC socket                                  *
+ *             header  - [IN] the message header                              *
+ *             data    - [IN] the message data                                *
+ *                                                                            *
+ * Return value: SUCCEED - the doorbell refers to valid ring message          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_check_doorbell(const zbx_ipc_socket_t *csocket, const zbx_uint32_t *header,
+		const unsigned char *data)
+{
+	zbx_uint32_t	doorbell[2];
+
+	if (NULL == csocket->shm || sizeof(doorbell) != header[ZBX_IPC_MESSAGE_SIZE])
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "unexpected IPC shared memory message");
+		return FAIL;
+	}
+
+	memcpy(doorbell, data, sizeof(doorbell));
+
+	if (csocket->shm->size < doorbell[ZBX_IPC_MESSAGE_SIZE])
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "invalid IPC shared memory message size %u",
+				doorbell[ZBX_IPC_MESSAGE_SIZE]);
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_read_message                                             *
+ *                                                                            *
+ * Purpose: replaces doorbell message with the message it refers to           *
+ *                                                                            *
+ * Parameters: csocket - [IN/OUT] the IPC socket                              *
+ *             message - [IN/OUT] the doorbell message                        *
+ *                                                                            *
+ * Comments: This function is called when the message is returned to service  *
+ *           rather than when the doorbell is received, so the ring space is  *
+ *           held by queued messages and client falls back to socket when     *
+ *           service is busy.                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_shm_read_message(zbx_ipc_socket_t *csocket, zbx_ipc_message_t *message)
+{
+	zbx_ipc_shm_t	*shm = csocket->shm;
+	zbx_uint32_t	doorbell[2], offset, part, size;
+
+	memcpy(doorbell, message->data, sizeof(doorbell));
+	size = doorbell[ZBX_IPC_MESSAGE_SIZE];
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+	message->data = (unsigned char *)zbx_realloc(message->data, size);
+	offset = shm->position & (shm->size - 1);
+
+	if (size > (part = shm->size - offset))
+	{
+		memcpy(message->data, shm->buffer + offset, part);
+		memcpy(message->data + part, shm->buffer, size - part);
+	}
+	else
+		memcpy(message->data, shm->buffer + offset, size);
+
+	shm->position += size;
+	__atomic_store_n(&shm->header->tail, shm->position, __ATOMIC_RELEASE);
+
+	message->code = doorbell[ZBX_IPC_MESSAGE_CODE];
+	message->size = size;
+}
+#else
+static void	ipc_shm_free(zbx_ipc_socket_t *csocket)
+{
+	zbx_free(csocket->shm);
+}
+
+static int	ipc_shm_write(zbx_ipc_socket_t *csocket, const unsigned char *data, zbx_uint32_t size)
+{
+	ZBX_UNUSED(csocket);
+	ZBX_UNUSED(data);
+	ZBX_UNUSED(size);
+
+	return FAIL;
+}
+
+static void	ipc_shm_attach(zbx_ipc_socket_t *csocket, const unsigned char *data, zbx_uint32_t size)
+{
+	ZBX_UNUSED(csocket);
+	ZBX_UNUSED(data);
+	ZBX_UNUSED(size);
+
+	zabbix_log(LOG_LEVEL_WARNING, "IPC shared memory transport is not supported");
+}
+
+static int	ipc_shm_check_doorbell(const zbx_ipc_socket_t *csocket, const zbx_uint32_t *header,
+		const unsigned char *data)
+{
+	ZBX_UNUSED(csocket);
+	ZBX_UNUSED(header);
+	ZBX_UNUSED(data);
+
+	zabbix_log(LOG_LEVEL_WARNING, "unexpected IPC shared memory message");
+
+	return FAIL;
+}
+
+static void	ipc_shm_read_message(zbx_ipc_socket_t *csocket, zbx_ipc_message_t *message)
+{
+	ZBX_UNUSED(csocket);
+	ZBX_UNUSED(message);
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: ipc_client_free_event                                            *
@@ -646,8 +1076,26 @@ static int	ipc_client_read(zbx_ipc_client_t *client)
 			return FAIL;
 		}
 
-		if (SUCCEED == (rc = ipc_message_is_completed(client->rx_header, client->rx_bytes)))
-			ipc_client_push_rx_message(client);
+		if (SUCCEED != (rc = ipc_message_is_completed(client->rx_header, client->rx_bytes)))
+			continue;
+
+		if (ZBX_IPC_CODE_SHM_ATTACH == client->rx_header[ZBX_IPC_MESSAGE_CODE])
+		{
+			ipc_shm_attach(&client->csocket, client->rx_data, client->rx_header[ZBX_IPC_MESSAGE_SIZE]);
+			zbx_free(client->rx_data);
+			client->rx_bytes = 0;
+			continue;
+		}
+
+		if (ZBX_IPC_CODE_SHM_MESSAGE == client->rx_header[ZBX_IPC_MESSAGE_CODE] &&
+				SUCCEED != ipc_shm_check_doorbell(&client->csocket, client->rx_header, client->rx_data))
+		{
+			zbx_free(client->rx_data);
+			client->rx_bytes = 0;
+			return FAIL;
+		}
+
+		ipc_client_push_rx_message(client);
 	}
 
 	while (SUCCEED == rc);
@@ -1177,6 +1625,8 @@ int	zbx_ipc_socket_open(zbx_ipc_socket_t *csocket, const char *service_name, int
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	csocket->shm = NULL;
+
 	if (NULL == (socket_path = ipc_make_path(service_name, error)))
 		goto out;
 
@@ -1233,6 +1683,8 @@ void	zbx_ipc_socket_close(zbx_ipc_socket_t *csocket)
 		csocket->fd = -1;
 	}
 
+	ipc_shm_free(csocket);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
@@ -1254,10 +1706,20 @@ void	zbx_ipc_socket_close(zbx_ipc_socket_t *csocket)
 int	zbx_ipc_socket_write(zbx_ipc_socket_t *csocket, zbx_uint32_t code, const unsigned char *data, zbx_uint32_t size)
 {
 	int		ret;
-	zbx_uint32_t	size_sent;
+	zbx_uint32_t	size_sent, doorbell[2];
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	if (SUCCEED == ipc_shm_write(csocket, data, size))
+	{
+		doorbell[ZBX_IPC_MESSAGE_CODE] = code;
+		doorbell[ZBX_IPC_MESSAGE_SIZE] = size;
+
+		code = ZBX_IPC_CODE_SHM_MESSAGE;
+		data = (const unsigned char *)doorbell;
+		size = sizeof(doorbell);
+	}
+
 	if (SUCCEED == ipc_socket_write_message(csocket, code, data, size, &size_sent) &&
 			size_sent == size + ZBX_IPC_HEADER_SIZE)
 	{
@@ -1343,6 +1805,44 @@ int	zbx_ipc_socket_connected(const zbx_ipc_socket_t *csocket)
 	return 0 < csocket->fd ? SUCCEED : FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_socket_enable_shm                                        *
+ *                                                                            *
+ * Purpose: enables shared memory transport for large messages written to     *
+ *          IPC service                                                       *
+ *                                                                            *
+ * Parameters: csocket - [IN/OUT] an opened IPC socket to the service         *
+ *             size    - [IN] the shared memory ring size, rounded up to      *
+ *                            power of two                                    *
+ *                                                                            *
+ * Comments: The shared memory is allocated when the first large message is   *
+ *           written, so processes sending only small messages do not use it. *
+ *           Messages that do not fit the free ring space are sent through    *
+ *           socket.                                                          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_ipc_socket_enable_shm(zbx_ipc_socket_t *csocket, zbx_uint32_t size)
+{
+#if defined(ZBX_IPC_SHM_ENABLED)
+	if (NULL != csocket->shm)
+		return;
+
+	csocket->shm = (zbx_ipc_shm_t *)zbx_malloc(NULL, sizeof(zbx_ipc_shm_t));
+	memset(csocket->shm, 0, sizeof(zbx_ipc_shm_t));
+	csocket->shm->shmid = -1;
+	csocket->shm->state = ZBX_IPC_SHM_STATE_NONE;
+
+	csocket->shm->size = ZBX_IPC_SHM_MESSAGE_MIN * 2;
+
+	while (csocket->shm->size < size)
+		csocket->shm->size <<= 1;
+#else
+	ZBX_UNUSED(csocket);
+	ZBX_UNUSED(size);
+#endif
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_ipc_message_free                                             *
@@ -1700,6 +2200,9 @@ int	zbx_ipc_service_recv(zbx_ipc_service_t *service, const zbx_timespec_t *timeo
 	{
 		if (NULL != (*message = (zbx_ipc_message_t *)zbx_queue_ptr_pop(&(*client)->rx_queue)))
 		{
+			if (ZBX_IPC_CODE_SHM_MESSAGE == (*message)->code)
+				ipc_shm_read_message(&(*client)->csocket, *message);
+
 			if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_TRACE))
 			{
 				char	*data = NULL;
@@ -2196,4 +2699,8 @@ out:
 	return ret;
 }
 
+#ifdef HAVE_TESTS
+#	include "../../../tests/libs/zbxipcservice/ipcservice_test.c"
+#endif
+
 #endif
@@ -18,6 +18,7 @@
 **/
 
 #include "common.h"
+#include "zbxalgo.h"
 #include "zbxjson.h"
 #include "json_parser.h"
 #include "json.h"
@@ -1200,6 +1201,280 @@ int	zbx_json_brackets_by_name(const struct zbx_json_parse *jp, const char *name,
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_init                                              *
+ *                                                                            *
+ * Purpose: initializes json object member index                              *
+ *                                                                            *
+ * Parameters: index - [OUT] the index                                        *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_json_index_init(zbx_json_index_t *index)
+{
+	memset(index, 0, sizeof(zbx_json_index_t));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_clear                                             *
+ *                                                                            *
+ * Purpose: frees resources allocated by json object member index             *
+ *                                                                            *
+ * Parameters: index - [IN] the index                                         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_json_index_clear(zbx_json_index_t *index)
+{
+	zbx_free(index->pairs);
+	zbx_free(index->slots);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: json_index_find                                                  *
+ *                                                                            *
+ * Purpose: finds hash table slot of the member with the specified name       *
+ *                                                                            *
+ * Parameters: index - [IN] the index                                         *
+ *             name  - [IN] the member name                                   *
+ *             len   - [IN] the member name length                            *
+ *             hash  - [IN] the member name hash                              *
+ *                                                                            *
+ * Return value: the slot containing the member or the free slot where the    *
+ *               member would be stored                                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	json_index_find(const zbx_json_index_t *index, const char *name, size_t len, zbx_hash_t hash)
+{
+	int	slot, mask = index->slots_num - 1;
+
+	for (slot = (int)(hash & (zbx_hash_t)mask); 0 != index->slots[slot]; slot = (slot + 1) & mask)
+	{
+		const zbx_json_index_pair_t	*pair = &index->pairs[index->slots[slot] - 1];
+
+		if (pair->hash == hash && pair->name_len == len && 0 == memcmp(pair->name, name, len))
+			break;
+	}
+
+	return slot;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_load                                              *
+ *                                                                            *
+ * Purpose: indexes members of json object                                    *
+ *                                                                            *
+ * Parameters: index - [IN/OUT] the index                                     *
+ *             jp    - [IN] the json object                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the object was indexed successfully                *
+ *               FAIL    - the json is not an object or is malformed          *
+ *                                                                            *
+ * Comments: The object members are scanned once and their names and value    *
+ *           locations are stored in a hash table, so later lookups by name   *
+ *           do not need to scan the object again. The index refers to the    *
+ *           json text, which must not be changed or freed while the index    *
+ *           is used. Index buffers are reused when loading next object.      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_json_index_load(zbx_json_index_t *index, const struct zbx_json_parse *jp)
+{
+	const char		*p = NULL, *name;
+	int			i, slots_num;
+	zbx_json_index_pair_t	*pair;
+
+	index->jp = *jp;
+	index->pairs_num = 0;
+	index->linear = 0;
+
+	if ('{' != *jp->start)
+	{
+		zbx_set_json_strerror("cannot index JSON: not an object \"%.64s\"", jp->start);
+		return FAIL;
+	}
+
+	while (NULL != (p = zbx_json_next(jp, p)) && p != jp->end)
+	{
+		if ('"' != *p)
+			goto fail;
+
+		for (name = ++p; '"' != *p; p++)
+		{
+			if (p >= jp->end)
+				goto fail;
+
+			if ('\\' == *p)
+			{
+				/* escaped names are not decoded, fall back to linear lookup */
+				index->linear = 1;
+
+				if (++p >= jp->end)
+					goto fail;
+			}
+		}
+
+		if (index->pairs_num == index->pairs_alloc)
+		{
+			index->pairs_alloc = (0 == index->pairs_alloc ? 16 : index->pairs_alloc * 2);
+			index->pairs = (zbx_json_index_pair_t *)zbx_realloc(index->pairs,
+					sizeof(zbx_json_index_pair_t) * (size_t)index->pairs_alloc);
+		}
+
+		pair = &index->pairs[index->pairs_num++];
+		pair->name = name;
+		pair->name_len = (size_t)(p - name);
+
+		p++;
+		SKIP_WHITESPACE(p);
+
+		if (':' != *p++)
+			goto fail;
+
+		SKIP_WHITESPACE(p);
+
+		pair->value = p;
+	}
+
+	/* keep the hash table at most half full */
+	for (slots_num = 16; slots_num < index->pairs_num * 2; slots_num *= 2)
+		;
+
+	if (slots_num > index->slots_alloc)
+	{
+		index->slots_alloc = slots_num;
+		index->slots = (int *)zbx_realloc(index->slots, sizeof(int) * (size_t)index->slots_alloc);
+	}
+
+	index->slots_num = slots_num;
+	memset(index->slots, 0, sizeof(int) * (size_t)slots_num);
+
+	for (i = 0; i < index->pairs_num; i++)
+	{
+		int	slot;
+
+		pair = &index->pairs[i];
+		pair->hash = ZBX_DEFAULT_STRING_HASH_ALGO(pair->name, pair->name_len, ZBX_DEFAULT_HASH_SEED);
+
+		/* the first member wins in the case of duplicate names, same as with linear lookup */
+		if (0 == index->slots[slot = json_index_find(index, pair->name, pair->name_len, pair->hash)])
+			index->slots[slot] = i + 1;
+	}
+
+	return SUCCEED;
+fail:
+	index->pairs_num = 0;
+	index->slots_num = 0;
+	zbx_set_json_strerror("cannot index JSON object member \"%.64s\"", p);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_pair_by_name                                      *
+ *                                                                            *
+ * Purpose: find indexed object member by name and return pointer to value    *
+ *                                                                            *
+ * Parameters: index - [IN] the index                                         *
+ *             name  - [IN] the member name                                   *
+ *                                                                            *
+ * Return value: pointer to value or NULL if member was not found             *
+ *                                                                            *
+ ******************************************************************************/
+const char	*zbx_json_index_pair_by_name(const zbx_json_index_t *index, const char *name)
+{
+	size_t		len;
+	zbx_hash_t	hash;
+	int		slot;
+
+	if (0 != index->linear)
+		return zbx_json_pair_by_name(&index->jp, name);
+
+	if (0 != index->slots_num)
+	{
+		len = strlen(name);
+		hash = ZBX_DEFAULT_STRING_HASH_ALGO(name, len, ZBX_DEFAULT_HASH_SEED);
+
+		if (0 != index->slots[slot = json_index_find(index, name, len, hash)])
+			return index->pairs[index->slots[slot] - 1].value;
+	}
+
+	zbx_set_json_strerror("cannot find pair with name \"%s\"", name);
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_value_by_name                                     *
+ *                                                                            *
+ * Purpose: return indexed object member value by name                        *
+ *                                                                            *
+ * Return value: SUCCEED - if value successfully parsed, FAIL - otherwise     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_json_index_value_by_name(const zbx_json_index_t *index, const char *name, char *string, size_t len,
+		zbx_json_type_t *type)
+{
+	const char	*p;
+
+	if (NULL == (p = zbx_json_index_pair_by_name(index, name)))
+		return FAIL;
+
+	if (NULL == zbx_json_decodevalue(p, string, len, type))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_value_by_name_dyn                                 *
+ *                                                                            *
+ * Purpose: return indexed object member value by name                        *
+ *                                                                            *
+ * Return value: SUCCEED - if value successfully parsed, FAIL - otherwise     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_json_index_value_by_name_dyn(const zbx_json_index_t *index, const char *name, char **string,
+		size_t *string_alloc, zbx_json_type_t *type)
+{
+	const char	*p;
+
+	if (NULL == (p = zbx_json_index_pair_by_name(index, name)))
+		return FAIL;
+
+	if (NULL == zbx_json_decodevalue_dyn(p, string, string_alloc, type))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_brackets_by_name                                  *
+ *                                                                            *
+ * Purpose: open indexed object member value as json object or array          *
+ *                                                                            *
+ * Return value: SUCCESS - processed successfully                             *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_json_index_brackets_by_name(const zbx_json_index_t *index, const char *name, struct zbx_json_parse *out)
+{
+	const char	*p;
+
+	if (NULL == (p = zbx_json_index_pair_by_name(index, name)))
+		return FAIL;
+
+	if (FAIL == zbx_json_brackets_open(p, out))
+		return FAIL;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_json_object_is_empty                                         *
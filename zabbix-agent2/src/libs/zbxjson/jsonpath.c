@@ -2397,7 +2397,8 @@ static int	jsonpath_apply_functions(const struct zbx_json_parse *jp_root, const
  *               FAIL    - invalid result data (internal json error)          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_format_query_result(const zbx_vector_json_t *objects, zbx_jsonpath_t *jsonpath, char **output)
+static int	jsonpath_format_query_result(const zbx_vector_json_t *objects, const zbx_jsonpath_t *jsonpath,
+		char **output)
 {
 	size_t	output_offset = 0, output_alloc;
 	int	i;
@@ -2559,49 +2560,73 @@ int	zbx_jsonpath_compile(const char *path, zbx_jsonpath_t *jsonpath)
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_jsonpath_query                                               *
+ * Function: zbx_jsonpath_query_precompiled                                   *
  *                                                                            *
- * Purpose: perform jsonpath query on the specified json data                 *
+ * Purpose: perform compiled jsonpath query on the specified json data        *
  *                                                                            *
- * Parameters: jp     - [IN] the json data                                    *
- *             path   - [IN] the jsonpath                                     *
- *             output - [OUT] the output value                                *
+ * Parameters: jp       - [IN] the json data                                  *
+ *             jsonpath - [IN] the compiled jsonpath                          *
+ *             output   - [OUT] the output value                              *
  *                                                                            *
  * Return value: SUCCEED - the query was performed successfully (empty result *
  *                         being counted as successful query)                 *
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	zbx_jsonpath_query(const struct zbx_json_parse *jp, const char *path, char **output)
+int	zbx_jsonpath_query_precompiled(const struct zbx_json_parse *jp, const zbx_jsonpath_t *jsonpath, char **output)
 {
-	zbx_jsonpath_t		jsonpath;
 	int			path_depth = 0, ret = SUCCEED;
 	zbx_vector_json_t	objects;
 
-	if (FAIL == zbx_jsonpath_compile(path, &jsonpath))
-		return FAIL;
-
 	zbx_vector_json_create(&objects);
 
 	if ('{' == *jp->start)
-		ret = jsonpath_query_object(jp, jp, &jsonpath, path_depth, &objects);
+		ret = jsonpath_query_object(jp, jp, jsonpath, path_depth, &objects);
 	else if ('[' == *jp->start)
-		ret = jsonpath_query_array(jp, jp, &jsonpath, path_depth, &objects);
+		ret = jsonpath_query_array(jp, jp, jsonpath, path_depth, &objects);
 
 	if (SUCCEED == ret)
 	{
-		path_depth = jsonpath.segments_num;
-		while (0 < path_depth && ZBX_JSONPATH_SEGMENT_FUNCTION == jsonpath.segments[path_depth - 1].type)
+		path_depth = jsonpath->segments_num;
+		while (0 < path_depth && ZBX_JSONPATH_SEGMENT_FUNCTION == jsonpath->segments[path_depth - 1].type)
 			path_depth--;
 
-		if (path_depth < jsonpath.segments_num)
-			ret = jsonpath_apply_functions(jp, &objects, &jsonpath, path_depth, output);
+		if (path_depth < jsonpath->segments_num)
+			ret = jsonpath_apply_functions(jp, &objects, jsonpath, path_depth, output);
 		else
-			ret = jsonpath_format_query_result(&objects, &jsonpath, output);
+			ret = jsonpath_format_query_result(&objects, jsonpath, output);
 	}
 
 	zbx_vector_json_clear_ext(&objects);
 	zbx_vector_json_destroy(&objects);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_jsonpath_query                                               *
+ *                                                                            *
+ * Purpose: perform jsonpath query on the specified json data                 *
+ *                                                                            *
+ * Parameters: jp     - [IN] the json data                                    *
+ *             path   - [IN] the jsonpath                                     *
+ *             output - [OUT] the output value                                *
+ *                                                                            *
+ * Return value: SUCCEED - the query was performed successfully (empty result *
+ *                         being counted as successful query)                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_jsonpath_query(const struct zbx_json_parse *jp, const char *path, char **output)
+{
+	zbx_jsonpath_t	jsonpath;
+	int		ret;
+
+	if (FAIL == zbx_jsonpath_compile(path, &jsonpath))
+		return FAIL;
+
+	ret = zbx_jsonpath_query_precompiled(jp, &jsonpath, output);
 	zbx_jsonpath_clear(&jsonpath);
 
 	return ret;
@@ -56,6 +56,26 @@ int			zbx_log_level = LOG_LEVEL_WARNING;
 #	define ZBX_DEV_NULL	"/dev/null"
 #endif
 
+#ifndef _WINDOWS
+#	define ZBX_LOG_BUFFER_SIZE		(64 * ZBX_KIBIBYTE)
+#	define ZBX_LOG_BUFFER_FLUSH_DELAY	1	/* seconds */
+
+/* log file descriptor is kept open and shared by processes forked after opening log */
+static int		log_fd = -1;
+static dev_t		log_fd_dev;
+static ino_t		log_fd_ino;
+static time_t		log_check_time;
+
+/* per process buffer of debug and trace messages, written to log file in batches */
+static char		log_buffer[ZBX_LOG_BUFFER_SIZE];
+static size_t		log_buffer_offset;
+static time_t		log_buffer_time;
+static pid_t		log_buffer_pid;
+
+/* set while log buffer or descriptor is being updated, checked by signal handlers flushing log buffer */
+static volatile sig_atomic_t	log_busy;
+#endif
+
 #ifndef _WINDOWS
 const char	*zabbix_get_log_level_string(void)
 {
@@ -259,6 +279,269 @@ static void	unlock_log(void)
 	if (0 > sigprocmask(SIG_SETMASK, &orig_mask, NULL))
 		zbx_error("cannot restore sigprocmask");
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Function: log_file_open                                                    *
+ *                                                                            *
+ * Purpose: opens log file, replacing the currently opened log descriptor     *
+ *                                                                            *
+ * Parameters: filename - [IN] the log file name                              *
+ *                                                                            *
+ * Return value: SUCCEED - the log file was opened successfully               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	log_file_open(const char *filename)
+{
+	int		fd;
+	zbx_stat_t	buf;
+
+	if (-1 == (fd = open(filename, O_WRONLY | O_CREAT | O_APPEND, 0666)))
+		return FAIL;
+
+	/* the descriptor is kept open, it must not be inherited by executed scripts and utilities */
+	if (-1 == fcntl(fd, F_SETFD, FD_CLOEXEC) || 0 != zbx_fstat(fd, &buf))
+	{
+		close(fd);
+		return FAIL;
+	}
+
+	if (-1 != log_fd)
+		close(log_fd);
+
+	log_fd = fd;
+	log_fd_dev = buf.st_dev;
+	log_fd_ino = buf.st_ino;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: log_file_write                                                   *
+ *                                                                            *
+ * Purpose: writes data into the opened log file                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	log_file_write(const char *data, size_t size)
+{
+	ssize_t	n;
+
+	while (0 != size)
+	{
+		if (-1 == (n = write(log_fd, data, size)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			zbx_error("failed to write into log file: %s", zbx_strerror(errno));
+			return;
+		}
+
+		data += n;
+		size -= (size_t)n;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: log_buffer_flush                                                 *
+ *                                                                            *
+ * Purpose: writes buffered messages into log file                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	log_buffer_flush(void)
+{
+	if (0 == log_buffer_offset)
+		return;
+
+	/* messages buffered before fork are written by the parent process */
+	if (log_buffer_pid == getpid() && -1 != log_fd)
+		log_file_write(log_buffer, log_buffer_offset);
+
+	log_buffer_offset = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: log_file_reopen                                                  *
+ *                                                                            *
+ * Purpose: reopens log file if it was rotated by another process or          *
+ *          externally                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	log_file_reopen(void)
+{
+	zbx_stat_t	buf;
+
+	if (0 == zbx_stat(log_filename, &buf) && buf.st_dev == log_fd_dev && buf.st_ino == log_fd_ino)
+		return;
+
+	log_buffer_flush();
+
+	if (SUCCEED != log_file_open(log_filename))
+	{
+		zbx_error("failed to open log file: %s", zbx_strerror(errno));
+		return;
+	}
+
+	/* stdout and stderr of the process must follow the log file, like it's done in rotate_log() */
+	zbx_redirect_stdio(log_filename);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: log_file_check                                                   *
+ *                                                                            *
+ * Purpose: rotates log file if it has reached size limit and reopens it if   *
+ *          it was rotated by another process or externally                   *
+ *                                                                            *
+ * Parameters: now - [IN] the current time                                    *
+ *                                                                            *
+ * Comments: The check is done not more often than once per second.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	log_file_check(time_t now)
+{
+	zbx_stat_t	buf;
+
+	if (now == log_check_time)
+		return;
+
+	log_check_time = now;
+
+	if (0 != CONFIG_LOG_FILE_SIZE && 0 == zbx_fstat(log_fd, &buf) &&
+			(zbx_uint64_t)CONFIG_LOG_FILE_SIZE * ZBX_MEBIBYTE < (zbx_uint64_t)buf.st_size)
+	{
+		log_buffer_flush();
+
+		zbx_mutex_lock(log_access);
+		rotate_log(log_filename);
+		zbx_mutex_unlock(log_access);
+	}
+
+	log_file_reopen();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: log_file_message                                                 *
+ *                                                                            *
+ * Purpose: writes message into log file                                      *
+ *                                                                            *
+ * Parameters: level - [IN] the message log level                             *
+ *             fmt   - [IN] the message format                                *
+ *             args  - [IN] the message arguments                             *
+ *                                                                            *
+ * Comments: When enabled by LogBuffer configuration parameter debug and      *
+ *           trace messages are buffered and written in batches, other        *
+ *           messages are written immediately together with the buffered      *
+ *           ones.                                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	log_file_message(int level, const char *fmt, va_list args)
+{
+	char		message[MAX_BUFFER_LEN], *ptr = message;
+	size_t		offset, size;
+	int		len;
+	long		milliseconds;
+	struct tm	tm;
+	time_t		now;
+	va_list		args_copy;
+	sigset_t	mask, orig_mask_local;
+
+	zbx_get_time(&tm, &milliseconds, NULL);
+	now = time(NULL);
+
+	offset = zbx_snprintf(message, sizeof(message), "%6li:%.4d%.2d%.2d:%.2d%.2d%.2d.%03ld ",
+			zbx_get_thread_id(),
+			tm.tm_year + 1900,
+			tm.tm_mon + 1,
+			tm.tm_mday,
+			tm.tm_hour,
+			tm.tm_min,
+			tm.tm_sec,
+			milliseconds
+			);
+
+	va_copy(args_copy, args);
+
+	if (0 > (len = vsnprintf(message + offset, sizeof(message) - offset, fmt, args)))
+		len = 0;
+
+	/* allocate buffer for messages not fitting in the static buffer together with line feed */
+	if ((size_t)len >= sizeof(message) - offset - 1)
+	{
+		ptr = (char *)zbx_malloc(NULL, offset + len + 2);
+		memcpy(ptr, message, offset);
+		vsnprintf(ptr + offset, len + 1, fmt, args_copy);
+	}
+
+	va_end(args_copy);
+
+	size = offset + len;
+	ptr[size++] = '\n';
+
+	/* block signals to prevent signal handlers from logging while log buffer or descriptor is being updated */
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGUSR1);
+	sigaddset(&mask, SIGUSR2);
+	sigaddset(&mask, SIGTERM);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGQUIT);
+	sigaddset(&mask, SIGHUP);
+
+	if (0 > sigprocmask(SIG_BLOCK, &mask, &orig_mask_local))
+		zbx_error("cannot set sigprocmask to block the user signal");
+
+	log_busy = 1;
+
+	if (-1 == log_fd && SUCCEED != log_file_open(log_filename))
+	{
+		zbx_error("failed to open log file: %s", zbx_strerror(errno));
+		zbx_error("failed to write [%.*s] into log file", (int)(size - offset - 1), ptr + offset);
+		goto out;
+	}
+
+	log_file_check(now);
+
+	if (1 == CONFIG_LOG_BUFFER && (LOG_LEVEL_DEBUG == level || LOG_LEVEL_TRACE == level) &&
+			size <= sizeof(log_buffer))
+	{
+		if (log_buffer_pid != getpid())
+		{
+			/* discard messages buffered by the parent process before fork */
+			log_buffer_offset = 0;
+			log_buffer_pid = getpid();
+		}
+
+		if (sizeof(log_buffer) - log_buffer_offset < size)
+			log_buffer_flush();
+
+		if (0 == log_buffer_offset)
+			log_buffer_time = now;
+
+		memcpy(log_buffer + log_buffer_offset, ptr, size);
+		log_buffer_offset += size;
+
+		if (ZBX_LOG_BUFFER_FLUSH_DELAY <= now - log_buffer_time)
+			log_buffer_flush();
+	}
+	else
+	{
+		log_buffer_flush();
+		log_file_write(ptr, size);
+	}
+out:
+	log_busy = 0;
+
+	if (0 > sigprocmask(SIG_SETMASK, &orig_mask_local, NULL))
+		zbx_error("cannot restore sigprocmask");
+
+	if (ptr != message)
+		zbx_free(ptr);
+}
 #else
 static void	lock_log(void)
 {
@@ -287,6 +570,17 @@ void	zbx_handle_log(void)
 	rotate_log(log_filename);
 
 	UNLOCK_LOG;
+#ifndef _WINDOWS
+	log_busy = 1;
+
+	if (-1 != log_fd)
+	{
+		log_buffer_flush();
+		log_file_reopen();
+	}
+
+	log_busy = 0;
+#endif
 }
 
 int	zabbix_open_log(int type, int level, const char *filename, char **error)
@@ -308,7 +602,9 @@ int	zabbix_open_log(int type, int level, const char *filename, char **error)
 	}
 	else if (LOG_TYPE_FILE == type)
 	{
+#ifdef _WINDOWS
 		FILE	*log_file = NULL;
+#endif
 
 		if (MAX_STRING_LEN <= strlen(filename))
 		{
@@ -319,14 +615,22 @@ int	zabbix_open_log(int type, int level, const char *filename, char **error)
 		if (SUCCEED != zbx_mutex_create(&log_access, ZBX_MUTEX_LOG, error))
 			return FAIL;
 
+#ifndef _WINDOWS
+		if (SUCCEED != log_file_open(filename))
+#else
 		if (NULL == (log_file = fopen(filename, "a+")))
+#endif
 		{
 			*error = zbx_dsprintf(*error, "unable to open log file [%s]: %s", filename, zbx_strerror(errno));
 			return FAIL;
 		}
 
 		strscpy(log_filename, filename);
+#ifdef _WINDOWS
 		zbx_fclose(log_file);
+#else
+		atexit(zabbix_flush_log);
+#endif
 	}
 	else if (LOG_TYPE_CONSOLE == type || LOG_TYPE_UNDEFINED == type)
 	{
@@ -362,10 +666,45 @@ void	zabbix_close_log(void)
 	}
 	else if (LOG_TYPE_FILE == log_type || LOG_TYPE_CONSOLE == log_type || LOG_TYPE_UNDEFINED == log_type)
 	{
+#ifndef _WINDOWS
+		log_busy = 1;
+
+		if (-1 != log_fd)
+		{
+			log_buffer_flush();
+			close(log_fd);
+			log_fd = -1;
+		}
+
+		log_busy = 0;
+#endif
 		zbx_mutex_destroy(&log_access);
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zabbix_flush_log                                                 *
+ *                                                                            *
+ * Purpose: writes buffered log messages of the current process into log      *
+ *          file                                                              *
+ *                                                                            *
+ * Comments: This function is called when process exits, before process       *
+ *           blocks waiting for work and can be called from signal            *
+ *           handlers. When the log is being written by the code interrupted  *
+ *           by signal the buffer is not flushed.                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zabbix_flush_log(void)
+{
+#ifndef _WINDOWS
+	if (LOG_TYPE_FILE != log_type || 0 != log_busy)
+		return;
+
+	log_buffer_flush();
+#endif
+}
+
 void	__zbx_zabbix_log(int level, const char *fmt, ...)
 {
 	char		message[MAX_BUFFER_LEN];
@@ -381,6 +720,11 @@ void	__zbx_zabbix_log(int level, const char *fmt, ...)
 #endif
 	if (LOG_TYPE_FILE == log_type)
 	{
+#ifndef _WINDOWS
+		va_start(args, fmt);
+		log_file_message(level, fmt, args);
+		va_end(args);
+#else
 		FILE	*log_file;
 
 		LOCK_LOG;
@@ -427,7 +771,7 @@ void	__zbx_zabbix_log(int level, const char *fmt, ...)
 		}
 
 		UNLOCK_LOG;
-
+#endif
 		return;
 	}
 
@@ -45,6 +45,7 @@ static void	exit_with_failure(void)
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 	zbx_tls_free_on_signal();
 #endif
+	zabbix_flush_log();
 	_exit(EXIT_FAILURE);
 }
 
@@ -57,6 +58,9 @@ static void	exit_with_failure(void)
  ******************************************************************************/
 static void	fatal_signal_handler(int sig, siginfo_t *siginfo, void *context)
 {
+	/* write buffered debug messages first, logging crash details can fail */
+	zabbix_flush_log();
+
 	log_fatal_signal(sig, siginfo, context);
 	zbx_log_fatal_info(context, ZBX_FATAL_LOG_FULL_INFO);
 
@@ -73,12 +77,36 @@ static void	fatal_signal_handler(int sig, siginfo_t *siginfo, void *context)
  ******************************************************************************/
 static void	metric_thread_signal_handler(int sig, siginfo_t *siginfo, void *context)
 {
+	zabbix_flush_log();
+
 	log_fatal_signal(sig, siginfo, context);
 	zbx_log_fatal_info(context, (ZBX_FATAL_LOG_PC_REG_SF | ZBX_FATAL_LOG_BACKTRACE));
 
 	exit_with_failure();
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: abort_signal_handler                                             *
+ *                                                                            *
+ * Purpose: handle abort signal SIGABRT                                       *
+ *                                                                            *
+ * Comments: Writes buffered log messages and raises the signal again with    *
+ *           the default action, terminating the process with core dump.      *
+ *                                                                            *
+ ******************************************************************************/
+static void	abort_signal_handler(int sig, siginfo_t *siginfo, void *context)
+{
+	ZBX_UNUSED(sig);
+	ZBX_UNUSED(siginfo);
+	ZBX_UNUSED(context);
+
+	zabbix_flush_log();
+
+	signal(SIGABRT, SIG_DFL);
+	raise(SIGABRT);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: alarm_signal_handler                                             *
@@ -199,6 +227,9 @@ void	zbx_set_common_signal_handlers(void)
 
 	phan.sa_sigaction = alarm_signal_handler;
 	sigaction(SIGALRM, &phan, NULL);
+
+	phan.sa_sigaction = abort_signal_handler;
+	sigaction(SIGABRT, &phan, NULL);
 }
 
 /******************************************************************************
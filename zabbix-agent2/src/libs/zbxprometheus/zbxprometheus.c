@@ -34,6 +34,9 @@
 
 #define ZBX_PROMETHEUS_ERROR_ROW_NUM	10
 
+/* the minimum number of metric rows to build label index for */
+#define ZBX_PROMETHEUS_LABEL_INDEX_MIN	16
+
 typedef enum
 {
 	ZBX_PROMETHEUS_CONDITION_OP_EQUAL,
@@ -95,6 +98,25 @@ typedef struct
 }
 zbx_prometheus_hint_t;
 
+/* the prometheus data index - rows grouped by metric name */
+typedef struct
+{
+	const char		*metric;
+	zbx_vector_ptr_t	rows;
+	/* the metric rows grouped by label name and value, created on demand */
+	zbx_hashset_t		*labels;
+}
+zbx_prometheus_index_t;
+
+/* the prometheus label index - rows grouped by label name and value */
+typedef struct
+{
+	const char		*name;
+	const char		*value;
+	zbx_vector_ptr_t	rows;
+}
+zbx_prometheus_label_index_t;
+
 /* TYPE, HELP hint hashset support */
 
 static zbx_hash_t	prometheus_hint_hash(const void *d)
@@ -112,6 +134,65 @@ static int	prometheus_hint_compare(const void *d1, const void *d2)
 	return strcmp(hint1->metric, hint2->metric);
 }
 
+/* metric, label index hashset support */
+
+static zbx_hash_t	prometheus_index_hash(const void *d)
+{
+	const zbx_prometheus_index_t	*index = (const zbx_prometheus_index_t *)d;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(index->metric);
+}
+
+static int	prometheus_index_compare(const void *d1, const void *d2)
+{
+	const zbx_prometheus_index_t	*index1 = (const zbx_prometheus_index_t *)d1;
+	const zbx_prometheus_index_t	*index2 = (const zbx_prometheus_index_t *)d2;
+
+	return strcmp(index1->metric, index2->metric);
+}
+
+static zbx_hash_t	prometheus_label_index_hash(const void *d)
+{
+	const zbx_prometheus_label_index_t	*index = (const zbx_prometheus_label_index_t *)d;
+	zbx_hash_t				hash;
+
+	hash = ZBX_DEFAULT_STRING_HASH_FUNC(index->name);
+
+	return ZBX_DEFAULT_STRING_HASH_ALGO(index->value, strlen(index->value), hash);
+}
+
+static int	prometheus_label_index_compare(const void *d1, const void *d2)
+{
+	const zbx_prometheus_label_index_t	*index1 = (const zbx_prometheus_label_index_t *)d1;
+	const zbx_prometheus_label_index_t	*index2 = (const zbx_prometheus_label_index_t *)d2;
+	int					ret;
+
+	if (0 != (ret = strcmp(index1->name, index2->name)))
+		return ret;
+
+	return strcmp(index1->value, index2->value);
+}
+
+static void	prometheus_label_index_clear(void *d)
+{
+	zbx_prometheus_label_index_t	*index = (zbx_prometheus_label_index_t *)d;
+
+	zbx_vector_ptr_destroy(&index->rows);
+}
+
+static void	prometheus_index_clear(void *d)
+{
+	zbx_prometheus_index_t	*index = (zbx_prometheus_index_t *)d;
+
+	zbx_vector_ptr_destroy(&index->rows);
+
+	if (NULL != index->labels)
+	{
+		zbx_hashset_destroy(index->labels);
+		zbx_free(index->labels);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: str_loc_dup                                                      *
@@ -1711,6 +1792,303 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: prometheus_filter_match_row                                      *
+ *                                                                            *
+ * Purpose: matches parsed row against filter conditions                      *
+ *                                                                            *
+ * Parameters: filter - [IN] the prometheus filter                            *
+ *             row    - [IN] the parsed row                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the row matches all filter conditions              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	prometheus_filter_match_row(const zbx_prometheus_filter_t *filter, const zbx_prometheus_row_t *row)
+{
+	int	i, j;
+
+	if (NULL != filter->metric && SUCCEED != condition_match_key_value(filter->metric, NULL, row->metric))
+		return FAIL;
+
+	for (i = 0; i < filter->labels.values_num; i++)
+	{
+		const zbx_prometheus_condition_t	*condition = filter->labels.values[i];
+
+		for (j = 0; j < row->labels.values_num; j++)
+		{
+			const zbx_prometheus_label_t	*label = row->labels.values[j];
+
+			if (SUCCEED == condition_match_key_value(condition, label->name, label->value))
+				break;
+		}
+
+		if (j == row->labels.values_num)
+			return FAIL;
+	}
+
+	if (NULL != filter->value && SUCCEED != condition_match_metric_value(filter->value->pattern, row->value))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: prometheus_index_labels                                          *
+ *                                                                            *
+ * Purpose: indexes metric rows by label name and value                       *
+ *                                                                            *
+ * Parameters: index - [IN/OUT] the metric index                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	prometheus_index_labels(zbx_prometheus_index_t *index)
+{
+	int				i, j;
+	zbx_prometheus_label_index_t	*label_index, label_index_local;
+
+	index->labels = (zbx_hashset_t *)zbx_malloc(NULL, sizeof(zbx_hashset_t));
+	zbx_hashset_create_ext(index->labels, index->rows.values_num, prometheus_label_index_hash,
+			prometheus_label_index_compare, prometheus_label_index_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC,
+			ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	for (i = 0; i < index->rows.values_num; i++)
+	{
+		zbx_prometheus_row_t	*row = (zbx_prometheus_row_t *)index->rows.values[i];
+
+		for (j = 0; j < row->labels.values_num; j++)
+		{
+			const zbx_prometheus_label_t	*label = (const zbx_prometheus_label_t *)row->labels.values[j];
+
+			label_index_local.name = label->name;
+			label_index_local.value = label->value;
+
+			if (NULL == (label_index = (zbx_prometheus_label_index_t *)zbx_hashset_search(index->labels,
+					&label_index_local)))
+			{
+				label_index = (zbx_prometheus_label_index_t *)zbx_hashset_insert(index->labels,
+						&label_index_local, sizeof(label_index_local));
+				zbx_vector_ptr_create(&label_index->rows);
+			}
+
+			/* the same label can be repeated in row, but the row must be indexed only once */
+			if (0 == label_index->rows.values_num ||
+					row != label_index->rows.values[label_index->rows.values_num - 1])
+			{
+				zbx_vector_ptr_append(&label_index->rows, row);
+			}
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: prometheus_select_rows                                           *
+ *                                                                            *
+ * Purpose: selects the smallest set of indexed rows that can match filter    *
+ *                                                                            *
+ * Parameters: prom   - [IN] the parsed prometheus data                       *
+ *             filter - [IN] the prometheus filter                            *
+ *                                                                            *
+ * Return value: The rows to match against filter or NULL if filter cannot    *
+ *               match any rows.                                              *
+ *                                                                            *
+ * Comments: The returned rows are in the same order as in prometheus data.   *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_vector_ptr_t	*prometheus_select_rows(zbx_prometheus_t *prom, const zbx_prometheus_filter_t *filter)
+{
+	zbx_prometheus_index_t		*index, index_local;
+	zbx_prometheus_label_index_t	*label_index, label_index_local;
+	const zbx_vector_ptr_t		*rows;
+	int				i;
+
+	if (NULL == filter->metric || ZBX_PROMETHEUS_CONDITION_OP_EQUAL != filter->metric->op)
+		return &prom->rows;
+
+	index_local.metric = filter->metric->pattern;
+
+	if (NULL == (index = (zbx_prometheus_index_t *)zbx_hashset_search(&prom->index, &index_local)))
+		return NULL;
+
+	rows = &index->rows;
+
+	if (ZBX_PROMETHEUS_LABEL_INDEX_MIN > index->rows.values_num)
+		return rows;
+
+	for (i = 0; i < filter->labels.values_num; i++)
+	{
+		const zbx_prometheus_condition_t	*condition = filter->labels.values[i];
+
+		if (ZBX_PROMETHEUS_CONDITION_OP_EQUAL != condition->op)
+			continue;
+
+		if (NULL == index->labels)
+			prometheus_index_labels(index);
+
+		label_index_local.name = condition->key;
+		label_index_local.value = condition->pattern;
+
+		if (NULL == (label_index = (zbx_prometheus_label_index_t *)zbx_hashset_search(index->labels,
+				&label_index_local)))
+		{
+			return NULL;
+		}
+
+		if (label_index->rows.values_num < rows->values_num)
+			rows = &label_index->rows;
+	}
+
+	return rows;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_prometheus_init                                              *
+ *                                                                            *
+ * Purpose: parses and indexes prometheus data to be used with multiple       *
+ *          pattern queries                                                   *
+ *                                                                            *
+ * Parameters: prom  - [OUT] the parsed prometheus data                       *
+ *             data  - [IN] the prometheus data                               *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the data was parsed successfully                   *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Unlike pattern queries, which parse only rows of the requested   *
+ *           metrics, all rows must be valid for this function to succeed.    *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_prometheus_init(zbx_prometheus_t *prom, const char *data, char **error)
+{
+	zbx_prometheus_filter_t	filter;
+	zbx_prometheus_index_t	*index, index_local;
+	int			i, ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	memset(&filter, 0, sizeof(zbx_prometheus_filter_t));
+	zbx_vector_ptr_create(&filter.labels);
+
+	zbx_vector_ptr_create(&prom->rows);
+	zbx_hashset_create_ext(&prom->index, 100, prometheus_index_hash, prometheus_index_compare,
+			prometheus_index_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	if (SUCCEED != (ret = prometheus_parse_rows(&filter, data, &prom->rows, NULL, error)))
+	{
+		zbx_prometheus_clear(prom);
+		goto out;
+	}
+
+	for (i = 0; i < prom->rows.values_num; i++)
+	{
+		zbx_prometheus_row_t	*row = (zbx_prometheus_row_t *)prom->rows.values[i];
+
+		index_local.metric = row->metric;
+
+		if (NULL == (index = (zbx_prometheus_index_t *)zbx_hashset_search(&prom->index, &index_local)))
+		{
+			index = (zbx_prometheus_index_t *)zbx_hashset_insert(&prom->index, &index_local,
+					sizeof(index_local));
+			zbx_vector_ptr_create(&index->rows);
+			index->labels = NULL;
+		}
+
+		zbx_vector_ptr_append(&index->rows, row);
+	}
+out:
+	prometheus_filter_clear(&filter);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s metrics:%d", __func__, zbx_result_string(ret),
+			(SUCCEED == ret ? prom->index.num_data : 0));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_prometheus_clear                                             *
+ *                                                                            *
+ * Purpose: clears resources allocated by parsed prometheus data              *
+ *                                                                            *
+ * Parameters: prom - [IN] the parsed prometheus data                         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_prometheus_clear(zbx_prometheus_t *prom)
+{
+	zbx_hashset_destroy(&prom->index);
+	zbx_vector_ptr_clear_ext(&prom->rows, (zbx_clean_func_t)prometheus_row_free);
+	zbx_vector_ptr_destroy(&prom->rows);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_prometheus_pattern_ex                                        *
+ *                                                                            *
+ * Purpose: extracts value from parsed prometheus data by the specified       *
+ *          filter                                                            *
+ *                                                                            *
+ * Parameters: prom        - [IN] the parsed prometheus data                  *
+ *             fitler_data - [IN] the filter in text format                   *
+ *             output      - [IN] the output template                         *
+ *             value       - [OUT] the extracted value                        *
+ *             error       - [OUT] the error message                          *
+ *                                                                            *
+ * Return value: SUCCEED - the value was extracted successfully               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_prometheus_pattern_ex(zbx_prometheus_t *prom, const char *filter_data, const char *output, char **value,
+		char **error)
+{
+	zbx_prometheus_filter_t	filter;
+	char			*errmsg = NULL;
+	int			ret = FAIL, i;
+	zbx_vector_ptr_t	rows;
+	const zbx_vector_ptr_t	*rows_index;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (FAIL == prometheus_filter_init(&filter, filter_data, &errmsg))
+	{
+		*error = zbx_dsprintf(*error, "pattern error: %s", errmsg);
+		zbx_free(errmsg);
+		goto out;
+	}
+
+	zbx_vector_ptr_create(&rows);
+
+	if (NULL != (rows_index = prometheus_select_rows(prom, &filter)))
+	{
+		for (i = 0; i < rows_index->values_num; i++)
+		{
+			zbx_prometheus_row_t	*row = (zbx_prometheus_row_t *)rows_index->values[i];
+
+			if (SUCCEED == prometheus_filter_match_row(&filter, row))
+				zbx_vector_ptr_append(&rows, row);
+		}
+	}
+
+	if (FAIL == prometheus_extract_value(&rows, output, value, &errmsg))
+	{
+		*error = zbx_dsprintf(*error, "data extraction error: %s", errmsg);
+		zbx_free(errmsg);
+		goto cleanup;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s(): output:%s", __func__, *value);
+	ret = SUCCEED;
+cleanup:
+	zbx_vector_ptr_destroy(&rows);
+	prometheus_filter_clear(&filter);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+	return ret;
+}
+
 int	zbx_prometheus_validate_filter(const char *pattern, char **error)
 {
 	zbx_prometheus_filter_t	filter;
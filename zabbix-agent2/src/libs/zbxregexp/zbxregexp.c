@@ -39,6 +39,56 @@ zbx_regmatch_t;
 					/* Group \0 contains the matching part of string, groups \1 ...\9 */
 					/* contain captured groups (substrings).                          */
 
+#define ZBX_REGEXP_CACHE_SIZE	256	/* the maximum number of compiled regular expressions kept in cache */
+
+/* compiled regular expression cache entry, the entries are linked in the least recently used order */
+typedef struct zbx_regexp_cache_entry
+{
+	char				*pattern;
+	int				flags;
+	zbx_regexp_t			*regexp;
+	struct zbx_regexp_cache_entry	*prev;	/* more recently used entry */
+	struct zbx_regexp_cache_entry	*next;	/* less recently used entry */
+}
+zbx_regexp_cache_entry_t;
+
+typedef struct
+{
+	zbx_hashset_t			entries;
+	zbx_regexp_cache_entry_t	*head;	/* the most recently used entry */
+	zbx_regexp_cache_entry_t	*tail;	/* the least recently used entry */
+	zbx_uint64_t			hits;
+	zbx_uint64_t			misses;
+	zbx_uint64_t			evictions;
+}
+zbx_regexp_cache_t;
+
+static ZBX_THREAD_LOCAL zbx_regexp_cache_t	*regexp_cache = NULL;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: regexp_jit_supported                                             *
+ *                                                                            *
+ * Purpose: checks if the linked pcre library supports JIT compilation        *
+ *                                                                            *
+ * Return value: SUCCEED - JIT compilation is supported                       *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	regexp_jit_supported(void)
+{
+#if defined(PCRE_CONFIG_JIT) && defined(PCRE_STUDY_JIT_COMPILE)
+	static int	jit = -1;
+
+	if (-1 == jit && 0 != pcre_config(PCRE_CONFIG_JIT, &jit))
+		jit = 0;
+
+	return 1 == jit ? SUCCEED : FAIL;
+#else
+	return FAIL;
+#endif
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: regexp_compile                                                   *
@@ -94,7 +144,13 @@ static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp,
 
 	if (NULL != regexp)
 	{
-		if (NULL == (extra = pcre_study(pcre_regexp, 0, err_msg_static)) && NULL != *err_msg_static)
+		int	study_options = 0;
+
+#if defined(PCRE_CONFIG_JIT) && defined(PCRE_STUDY_JIT_COMPILE)
+		if (SUCCEED == regexp_jit_supported())
+			study_options |= PCRE_STUDY_JIT_COMPILE;
+#endif
+		if (NULL == (extra = pcre_study(pcre_regexp, study_options, err_msg_static)) && NULL != *err_msg_static)
 		{
 			pcre_free(pcre_regexp);
 			return FAIL;
@@ -138,43 +194,170 @@ int	zbx_regexp_compile_ext(const char *pattern, zbx_regexp_t **regexp, int flags
 	return regexp_compile(pattern, flags, regexp, err_msg_static);
 }
 
+static zbx_hash_t	regexp_cache_hash_func(const void *data)
+{
+	const zbx_regexp_cache_entry_t	*entry = (const zbx_regexp_cache_entry_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(entry->pattern, strlen(entry->pattern), ZBX_DEFAULT_HASH_SEED);
+
+	return ZBX_DEFAULT_HASH_ALGO(&entry->flags, sizeof(entry->flags), hash);
+}
+
+static int	regexp_cache_compare_func(const void *d1, const void *d2)
+{
+	const zbx_regexp_cache_entry_t	*e1 = (const zbx_regexp_cache_entry_t *)d1;
+	const zbx_regexp_cache_entry_t	*e2 = (const zbx_regexp_cache_entry_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(e1->flags, e2->flags);
+
+	return strcmp(e1->pattern, e2->pattern);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: regexp_cache_unlink                                              *
+ *                                                                            *
+ * Purpose: removes entry from the least recently used list                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	regexp_cache_unlink(zbx_regexp_cache_entry_t *entry)
+{
+	if (NULL != entry->prev)
+		entry->prev->next = entry->next;
+	else
+		regexp_cache->head = entry->next;
+
+	if (NULL != entry->next)
+		entry->next->prev = entry->prev;
+	else
+		regexp_cache->tail = entry->prev;
+
+	entry->prev = entry->next = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: regexp_cache_link_head                                           *
+ *                                                                            *
+ * Purpose: marks entry as the most recently used                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	regexp_cache_link_head(zbx_regexp_cache_entry_t *entry)
+{
+	entry->prev = NULL;
+	entry->next = regexp_cache->head;
+
+	if (NULL != regexp_cache->head)
+		regexp_cache->head->prev = entry;
+	else
+		regexp_cache->tail = entry;
+
+	regexp_cache->head = entry;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: regexp_cache_evict                                               *
+ *                                                                            *
+ * Purpose: removes the least recently used regular expression from cache     *
+ *                                                                            *
+ ******************************************************************************/
+static void	regexp_cache_evict(void)
+{
+	zbx_regexp_cache_entry_t	*entry;
+
+	if (NULL == (entry = regexp_cache->tail))
+		return;
+
+	regexp_cache_unlink(entry);
+
+	zbx_regexp_free(entry->regexp);
+	zbx_free(entry->pattern);
+	zbx_hashset_remove_direct(&regexp_cache->entries, entry);
+
+	regexp_cache->evictions++;
+}
+
 /****************************************************************************************************
  *                                                                                                  *
  * Function: regexp_prepare                                                                         *
  *                                                                                                  *
- * Purpose: wrapper for zbx_regexp_compile. Caches and reuses the last used regexp.                 *
+ * Purpose: wrapper for zbx_regexp_compile. Caches and reuses the recently used regexps.            *
+ *                                                                                                  *
+ * Comments: The returned regexp is owned by cache and stays valid until it is evicted by the       *
+ *           following regexp_prepare() calls, so it must not be freed or kept by the caller.       *
  *                                                                                                  *
  ****************************************************************************************************/
 static int	regexp_prepare(const char *pattern, int flags, zbx_regexp_t **regexp, const char **err_msg_static)
 {
-	static ZBX_THREAD_LOCAL zbx_regexp_t	*curr_regexp = NULL;
-	static ZBX_THREAD_LOCAL char		*curr_pattern = NULL;
-	static ZBX_THREAD_LOCAL int		curr_flags = 0;
-	int					ret = SUCCEED;
+	zbx_regexp_cache_entry_t	entry_local, *entry;
 
-	if (NULL == curr_regexp || 0 != strcmp(curr_pattern, pattern) || curr_flags != flags)
+	if (NULL == regexp_cache)
 	{
-		if (NULL != curr_regexp)
-		{
-			zbx_regexp_free(curr_regexp);
-			zbx_free(curr_pattern);
-		}
+		regexp_cache = (zbx_regexp_cache_t *)zbx_malloc(NULL, sizeof(zbx_regexp_cache_t));
+		memset(regexp_cache, 0, sizeof(zbx_regexp_cache_t));
+		zbx_hashset_create(&regexp_cache->entries, ZBX_REGEXP_CACHE_SIZE, regexp_cache_hash_func,
+				regexp_cache_compare_func);
+	}
+
+	entry_local.pattern = (char *)pattern;
+	entry_local.flags = flags;
 
-		curr_regexp = NULL;
-		curr_pattern = NULL;
-		curr_flags = 0;
+	if (NULL != (entry = (zbx_regexp_cache_entry_t *)zbx_hashset_search(&regexp_cache->entries, &entry_local)))
+	{
+		regexp_cache->hits++;
 
-		if (SUCCEED == regexp_compile(pattern, flags, &curr_regexp, err_msg_static))
+		if (entry != regexp_cache->head)
 		{
-			curr_pattern = zbx_strdup(curr_pattern, pattern);
-			curr_flags = flags;
+			regexp_cache_unlink(entry);
+			regexp_cache_link_head(entry);
 		}
-		else
-			ret = FAIL;
+
+		*regexp = entry->regexp;
+
+		return SUCCEED;
 	}
 
-	*regexp = curr_regexp;
-	return ret;
+	regexp_cache->misses++;
+
+	if (SUCCEED != regexp_compile(pattern, flags, &entry_local.regexp, err_msg_static))
+		return FAIL;
+
+	if (ZBX_REGEXP_CACHE_SIZE <= regexp_cache->entries.num_data)
+		regexp_cache_evict();
+
+	entry_local.pattern = zbx_strdup(NULL, pattern);
+	entry = (zbx_regexp_cache_entry_t *)zbx_hashset_insert(&regexp_cache->entries, &entry_local,
+			sizeof(entry_local));
+	regexp_cache_link_head(entry);
+
+	*regexp = entry->regexp;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_regexp_get_cache_stats                                       *
+ *                                                                            *
+ * Purpose: get compiled regular expression cache statistics of the calling   *
+ *          process/thread                                                    *
+ *                                                                            *
+ * Parameters: stats - [OUT] the cache statistics                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_regexp_get_cache_stats(zbx_regexp_cache_stats_t *stats)
+{
+	memset(stats, 0, sizeof(zbx_regexp_cache_stats_t));
+
+	if (NULL == regexp_cache)
+		return;
+
+	stats->entries = (zbx_uint64_t)regexp_cache->entries.num_data;
+	stats->hits = regexp_cache->hits;
+	stats->misses = regexp_cache->misses;
+	stats->evictions = regexp_cache->evictions;
 }
 
 /***********************************************************************************
@@ -245,7 +428,17 @@ static int	regexp_exec(const char *string, const zbx_regexp_t *regexp, int flags
 #endif
 #endif
 	/* see "man pcreapi" about pcre_exec() return value and 'ovector' size and layout */
-	if (0 <= (r = pcre_exec(regexp->pcre_regexp, pextra, string, strlen(string), flags, 0, ovector, ovecsize)))
+	r = pcre_exec(regexp->pcre_regexp, pextra, string, strlen(string), flags, 0, ovector, ovecsize);
+
+#if defined(PCRE_ERROR_JIT_STACKLIMIT) && defined(PCRE_EXTRA_EXECUTABLE_JIT)
+	if (PCRE_ERROR_JIT_STACKLIMIT == r && 0 != (pextra->flags & PCRE_EXTRA_EXECUTABLE_JIT))
+	{
+		/* default JIT stack is too small for this pattern, fall back to the interpreter for good */
+		pextra->flags &= ~PCRE_EXTRA_EXECUTABLE_JIT;
+		r = pcre_exec(regexp->pcre_regexp, pextra, string, strlen(string), flags, 0, ovector, ovecsize);
+	}
+#endif
+	if (0 <= r)
 	{
 		if (NULL != matches)
 			memcpy(matches, ovector, (size_t)((0 < r) ? MIN(r, count) : count) * sizeof(zbx_regmatch_t));
@@ -336,6 +336,10 @@ void	update_selfmon_counter(unsigned char state)
 	struct tms		buf;
 	int			i;
 
+	/* write buffered debug messages before process blocks waiting for work */
+	if (ZBX_PROCESS_STATE_IDLE == state)
+		zabbix_flush_log();
+
 	if (ZBX_PROCESS_TYPE_UNKNOWN == process_type)
 		return;
 
@@ -1245,6 +1245,7 @@ static int	evaluate_COUNT(zbx_variant_t *value, DC_ITEM *item, const char *param
 	zbx_vector_ptr_t		regexps;
 	zbx_vector_history_record_t	values;
 	zbx_timespec_t			ts_end = *ts;
+	zbx_vc_aggregate_t		aggregate;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -1424,6 +1425,19 @@ static int	evaluate_COUNT(zbx_variant_t *value, DC_ITEM *item, const char *param
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
+	/* the number of all values in time period is available without retrieving them */
+	if (0 != seconds && COUNT_ALL == unique && '\0' == *pattern && (NULL == operator || '\0' == *operator) &&
+			SUCCEED == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, &ts_end, 0,
+			&aggregate))
+	{
+		if ((count = aggregate.values_num) > limit)
+			count = limit;
+
+		zbx_variant_set_dbl(value, count);
+		ret = SUCCEED;
+		goto out;
+	}
+
 	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
@@ -1576,6 +1590,7 @@ static int	evaluate_SUM(zbx_variant_t *value, DC_ITEM *item, const char *paramet
 	zbx_vector_history_record_t	values;
 	history_value_t			result;
 	zbx_timespec_t			ts_end = *ts;
+	zbx_vc_aggregate_t		aggregate;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -1614,25 +1629,33 @@ static int	evaluate_SUM(zbx_variant_t *value, DC_ITEM *item, const char *paramet
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (0 != seconds && SUCCEED == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, &ts_end,
+			ZBX_VC_AGGREGATE_SUM, &aggregate))
 	{
-		*error = zbx_strdup(*error, "cannot get values from value cache");
-		goto out;
-	}
-
-	if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-	{
-		result.dbl = 0;
-
-		for (i = 0; i < values.values_num; i++)
-			result.dbl += values.values[i].value.dbl;
+		result = aggregate.sum;
 	}
 	else
 	{
-		result.ui64 = 0;
+		if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+		{
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto out;
+		}
 
-		for (i = 0; i < values.values_num; i++)
-			result.ui64 += values.values[i].value.ui64;
+		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
+		{
+			result.dbl = 0;
+
+			for (i = 0; i < values.values_num; i++)
+				result.dbl += values.values[i].value.dbl;
+		}
+		else
+		{
+			result.ui64 = 0;
+
+			for (i = 0; i < values.values_num; i++)
+				result.ui64 += values.values[i].value.ui64;
+		}
 	}
 
 	zbx_history_value2variant(&result, item->value_type, value);
@@ -1665,10 +1688,12 @@ out:
 static int	evaluate_AVG(zbx_variant_t *value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
 		char **error)
 {
-	int				arg1, ret = FAIL, i, seconds = 0, nvalues = 0, time_shift;
+	int				arg1, ret = FAIL, i, seconds = 0, nvalues = 0, time_shift, values_num;
 	zbx_value_type_t		arg1_type;
 	zbx_vector_history_record_t	values;
 	zbx_timespec_t			ts_end = *ts;
+	zbx_vc_aggregate_t		aggregate;
+	double				avg = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -1707,28 +1732,39 @@ static int	evaluate_AVG(zbx_variant_t *value, DC_ITEM *item, const char *paramet
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (0 != seconds && SUCCEED == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, &ts_end,
+			ZBX_VC_AGGREGATE_SUM, &aggregate))
 	{
-		*error = zbx_strdup(*error, "cannot get values from value cache");
-		goto out;
+		values_num = aggregate.values_num;
+		avg = aggregate.avg;
 	}
-
-	if (0 < values.values_num)
+	else
 	{
-		double	avg = 0;
-
-		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
+		if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
 		{
-			for (i = 0; i < values.values_num; i++)
-				avg += values.values[i].value.dbl / (i + 1) - avg / (i + 1);
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto out;
 		}
-		else
+
+		if (0 < (values_num = values.values_num))
 		{
-			for (i = 0; i < values.values_num; i++)
-				avg += (double)values.values[i].value.ui64;
+			if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
+			{
+				for (i = 0; i < values.values_num; i++)
+					avg += values.values[i].value.dbl / (i + 1) - avg / (i + 1);
+			}
+			else
+			{
+				for (i = 0; i < values.values_num; i++)
+					avg += (double)values.values[i].value.ui64;
 
-			avg = avg / values.values_num;
+				avg = avg / values.values_num;
+			}
 		}
+	}
+
+	if (0 < values_num)
+	{
 		zbx_variant_set_dbl(value, avg);
 
 		ret = SUCCEED;
@@ -1805,6 +1841,7 @@ static int	evaluate_MIN(zbx_variant_t *value, DC_ITEM *item, const char *paramet
 	zbx_value_type_t		arg1_type;
 	zbx_vector_history_record_t	values;
 	zbx_timespec_t			ts_end = *ts;
+	zbx_vc_aggregate_t		aggregate;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -1843,6 +1880,23 @@ static int	evaluate_MIN(zbx_variant_t *value, DC_ITEM *item, const char *paramet
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
+	if (0 != seconds && SUCCEED == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, &ts_end,
+			ZBX_VC_AGGREGATE_MIN, &aggregate))
+	{
+		if (0 < aggregate.values_num)
+		{
+			zbx_history_value2variant(&aggregate.min, item->value_type, value);
+			ret = SUCCEED;
+		}
+		else
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "result for MIN is empty");
+			*error = zbx_strdup(*error, "not enough data");
+		}
+
+		goto out;
+	}
+
 	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
@@ -1910,6 +1964,7 @@ static int	evaluate_MAX(zbx_variant_t *value, DC_ITEM *item, const char *paramet
 	zbx_value_type_t		arg1_type;
 	zbx_vector_history_record_t	values;
 	zbx_timespec_t			ts_end = *ts;
+	zbx_vc_aggregate_t		aggregate;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -1948,6 +2003,23 @@ static int	evaluate_MAX(zbx_variant_t *value, DC_ITEM *item, const char *paramet
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
+	if (0 != seconds && SUCCEED == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, &ts_end,
+			ZBX_VC_AGGREGATE_MAX, &aggregate))
+	{
+		if (0 < aggregate.values_num)
+		{
+			zbx_history_value2variant(&aggregate.max, item->value_type, value);
+			ret = SUCCEED;
+		}
+		else
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "result for MAX is empty");
+			*error = zbx_strdup(*error, "not enough data");
+		}
+
+		goto out;
+	}
+
 	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
@@ -2989,6 +3061,55 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_prefetch_function                                            *
+ *                                                                            *
+ * Purpose: register trend function data to be retrieved by batched query     *
+ *          before the function is evaluated                                  *
+ *                                                                            *
+ * Parameters: item      - [IN] item to calculate function for                *
+ *             function  - [IN] function (for example, 'trendavg')            *
+ *             parameter - [IN] parameter of the function                     *
+ *             ts        - [IN] the starting timestamp                        *
+ *                                                                            *
+ * Comments: Invalid functions are ignored here, they will fail during        *
+ *           evaluation.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_prefetch_function(const DC_ITEM *item, const char *function, const char *parameter,
+		const zbx_timespec_t *ts)
+{
+	int		start, end;
+	char		*period = NULL, *error = NULL;
+	const char	*table;
+
+	if (0 != strncmp(function, "trend", ZBX_CONST_STRLEN("trend")) || 1 != num_param(parameter))
+		return;
+
+	switch (item->value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			table = "trends";
+			break;
+		case ITEM_VALUE_TYPE_UINT64:
+			table = "trends_uint";
+			break;
+		default:
+			return;
+	}
+
+	if (SUCCEED != get_function_parameter_str(parameter, 1, &period))
+		return;
+
+	if (SUCCEED == zbx_trends_parse_range(ts->sec, period, &start, &end, &error))
+		zbx_trends_prefetch_add(table, item->itemid, start, end, function + ZBX_CONST_STRLEN("trend"));
+	else
+		zbx_free(error);
+
+	zbx_free(period);
+}
+
 static int	validate_params_and_get_data(DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
 		zbx_vector_history_record_t *values, char **error)
 {
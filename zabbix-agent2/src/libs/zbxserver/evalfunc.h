@@ -23,5 +23,7 @@
 int	zbx_evaluatable_for_notsupported(const char *fn);
 int	zbx_evaluate_RATE(zbx_variant_t *value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
 		char **error);
+void	zbx_prefetch_function(const DC_ITEM *item, const char *function, const char *parameter,
+		const zbx_timespec_t *ts);
 
 #endif
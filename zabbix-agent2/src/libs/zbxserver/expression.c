@@ -25,6 +25,7 @@
 #include "zbxeval.h"
 
 #include "valuecache.h"
+#include "zbxtrends.h"
 #include "macrofunc.h"
 #include "../zbxalgo/vectorimpl.h"
 #ifdef HAVE_LIBXML2
@@ -5252,6 +5253,39 @@ static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, const zbx_vector_u
 				ZBX_ITEM_GET_SYNC);
 	}
 
+	/* retrieve trend function values missing from trend function cache with batched queries */
+	zbx_hashset_iter_reset(funcs, &iter);
+	while (NULL != (func = (zbx_func_t *)zbx_hashset_iter_next(&iter)))
+	{
+		const DC_ITEM	*item;
+
+		if (0 != strncmp(func->function, "trend", ZBX_CONST_STRLEN("trend")))
+			continue;
+
+		if (FAIL != (i = zbx_vector_uint64_bsearch(history_itemids, func->itemid,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+		{
+			if (SUCCEED != history_errcodes[i])
+				continue;
+
+			item = history_items + i;
+		}
+		else
+		{
+			i = zbx_vector_uint64_bsearch(&itemids, func->itemid, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+			if (SUCCEED != errcodes[i])
+				continue;
+
+			item = items + i;
+		}
+
+		if (ITEM_STATUS_ACTIVE == item->status && HOST_STATUS_MONITORED == item->host.status)
+			zbx_prefetch_function(item, func->function, func->parameter, &func->timespec);
+	}
+
+	zbx_trends_prefetch();
+
 	zbx_hashset_iter_reset(funcs, &iter);
 	while (NULL != (func = (zbx_func_t *)zbx_hashset_iter_next(&iter)))
 	{
@@ -312,99 +312,77 @@ static void	expression_init_query_one(zbx_expression_eval_t *eval, zbx_expressio
 	query->data = data;
 }
 
-/******************************************************************************
- *                                                                            *
- * Function: replace_key_param_wildcard_cb                                    *
- *                                                                            *
- * Purpose: replace wildcards '*'in key parameters with % and escape existing *
- *          %, \ characters for SQL like operation                            *
- *                                                                            *
- ******************************************************************************/
-static int	replace_key_param_wildcard_cb(const char *data, int key_type, int level, int num, int quoted, void *cb_data,
-		char **param)
+typedef struct
 {
-	char	*tmp;
-
-	ZBX_UNUSED(key_type);
-	ZBX_UNUSED(num);
-	ZBX_UNUSED(cb_data);
-
-	if (0 == level)
-		return SUCCEED;
-
-	if ('*' == data[0] && '\0' == data[1])
-	{
-		*param = zbx_strdup(NULL, "%");
-		return SUCCEED;
-	}
-
-	if (NULL == strchr(data, '%') && NULL == strchr(data, '\\'))
-		return SUCCEED;
-
-	tmp = zbx_strdup(NULL, data);
-	unquote_key_param(tmp);
-	*param = zbx_dyn_escape_string(tmp, "\\%%");
-	zbx_free(tmp);
-
-	/* escaping cannot result in unquotable parameter */
-	if (FAIL == quote_key_param(param, quoted))
-	{
-		THIS_SHOULD_NEVER_HAPPEN;
-		zbx_free(*param);
-	}
-
-	return SUCCEED;
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	hostid;
+	zbx_expression_eval_t	*eval;
 }
+zbx_expression_eval_many_t;
 
 /******************************************************************************
  *                                                                            *
- * Function: expression_match_item_key                                        *
+ * Function: expression_get_filter_hostids                                    *
  *                                                                            *
- * Purpose: check if item key matches the pattern                             *
+ * Purpose: get hosts the item candidates are restricted to by group filter   *
  *                                                                            *
- * Parameters: item_key - [IN] the item key to match                          *
- *             pattern  - [IN] the pattern                                    *
+ * Parameters: eval            - [IN] the evaluation data                     *
+ *             groups          - [IN] the groups in filter template           *
+ *             filter_template - [IN] the group filter template with {index}  *
+ *                                    placeholders referring to a group in    *
+ *                                    groups vector                           *
+ *             hostids         - [OUT] the sorted hostids                     *
+ *                                                                            *
+ * Return value: SUCCEED - the item candidates must belong to returned hosts  *
+ *               FAIL    - the filter does not restrict item candidate hosts  *
+ *                                                                            *
+ * Comments: Only group filters combined with 'or' operator are converted to  *
+ *           hosts, other filters are checked when evaluating the full item   *
+ *           query filter for each candidate.                                 *
  *                                                                            *
  ******************************************************************************/
-static int	expression_match_item_key(const char *item_key, const AGENT_REQUEST *pattern)
+static int	expression_get_filter_hostids(zbx_expression_eval_t *eval, const zbx_vector_str_t *groups,
+		const char *filter_template, zbx_vector_uint64_t *hostids)
 {
-	AGENT_REQUEST	key;
-	int		i, ret = FAIL;
-
-	init_request(&key);
-
-	if (SUCCEED != parse_item_key(item_key, &key))
-		goto out;
-
-	if (pattern->nparam != key.nparam)
-		goto out;
+	const char		*ptr, *end;
+	zbx_uint64_t		index;
+	zbx_expression_group_t	*group;
 
-	if (0 != strcmp(pattern->key, key.key))
-		goto out;
+	if (NULL == filter_template || '\0' == *filter_template)
+		return FAIL;
 
-	for (i = 0; i < key.nparam; i++)
+	for (ptr = filter_template; '\0' != *ptr;)
 	{
-		if (0 == strcmp(pattern->params[i], "*"))
+		if ('(' == *ptr || ')' == *ptr || ' ' == *ptr)
+		{
+			ptr++;
 			continue;
+		}
 
-		if (0 != strcmp(pattern->params[i], key.params[i]))
-			goto out;
-	}
+		if (0 == strncmp(ptr, "or ", ZBX_CONST_STRLEN("or ")))
+		{
+			ptr += ZBX_CONST_STRLEN("or ");
+			continue;
+		}
 
-	ret = SUCCEED;
-out:
-	free_request(&key);
+		if ('{' != *ptr || NULL == (end = strchr(ptr, '}')) ||
+				SUCCEED != is_uint64_n(ptr + 1, end - ptr - 1, &index) ||
+				(int)index >= groups->values_num)
+		{
+			zbx_vector_uint64_clear(hostids);
+			return FAIL;
+		}
 
-	return ret;
-}
+		group = expression_get_group(eval, groups->values[index]);
+		zbx_vector_uint64_append_array(hostids, group->hostids.values, group->hostids.values_num);
+		ptr = end + 1;
+	}
 
-typedef struct
-{
-	zbx_uint64_t	itemid;
-	zbx_uint64_t	hostid;
-	zbx_expression_eval_t	*eval;
+	zbx_vector_uint64_sort(hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	return SUCCEED;
 }
-zbx_expression_eval_many_t;
 
 /******************************************************************************
  *                                                                            *
@@ -421,134 +399,58 @@ zbx_expression_eval_many_t;
  *                                    groups vector                           *
  *             itemhosts       - [out] itemid+hostid pairs matching query     *
  *                                                                            *
+ * Comments: The item candidates are selected from configuration cache item   *
+ *           indexes. Items that are not in configuration cache are skipped   *
+ *           when evaluating the query anyway.                                *
+ *                                                                            *
  ******************************************************************************/
 static void	expression_get_item_candidates(zbx_expression_eval_t *eval, const zbx_expression_query_t *query,
 		const zbx_vector_str_t *groups, const char *filter_template, zbx_vector_uint64_pair_t *itemhosts)
 {
-	DB_RESULT	result;
-	DB_ROW		row;
-	char		*sql = NULL, *esc, *clause = "where";
-	size_t		sql_alloc = 0, sql_offset = 0;
-	AGENT_REQUEST	pattern;
+	AGENT_REQUEST		pattern, *ppattern = NULL;
+	zbx_vector_uint64_t	hostids, *phostids = NULL;
+	zbx_uint64_t		hostid;
+	const char		*key = NULL;
 
-	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select i.itemid,i.hostid");
-
-	if (0 != (query->flags & ZBX_ITEM_QUERY_KEY_SOME))
-	{
-		init_request(&pattern);
-		if (SUCCEED != parse_item_key(query->ref.key, &pattern))
-		{
-			THIS_SHOULD_NEVER_HAPPEN;
-			zbx_free(sql);
-			return;
-		}
-
-		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ",i.key_");
-	}
-
-	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " from items i");
+	zbx_vector_uint64_create(&hostids);
+	init_request(&pattern);
 
 	if (0 != (query->flags & ZBX_ITEM_QUERY_HOST_ONE))
 	{
-		esc = DBdyn_escape_string(query->ref.host);
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, ",hosts h"
-				" where h.hostid=i.hostid"
-				" and h.host='%s'", esc);
-		zbx_free(esc);
-		clause = "and";
+		if (SUCCEED != DCconfig_get_hostid_by_name(query->ref.host, &hostid))
+			goto out;
+
+		zbx_vector_uint64_append(&hostids, hostid);
+		phostids = &hostids;
 	}
 	else if (0 != (query->flags & ZBX_ITEM_QUERY_HOST_SELF))
 	{
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " where i.hostid=" ZBX_FS_UI64,
-				eval->hostid);
-		clause = "and";
-	}
-
-	if (0 != (query->flags & ZBX_ITEM_QUERY_KEY_SOME))
-	{
-		char	*key;
-
-		key = zbx_strdup(NULL, query->ref.key);
-		replace_key_params_dyn(&key, ZBX_KEY_TYPE_ITEM, replace_key_param_wildcard_cb, NULL, NULL, 0);
-
-		esc = DBdyn_escape_string(key);
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " %s i.key_ like '%s'", clause, esc);
-		zbx_free(esc);
-		zbx_free(key);
-		clause = "and";
+		zbx_vector_uint64_append(&hostids, eval->hostid);
+		phostids = &hostids;
 	}
-	else if (0 != (query->flags & ZBX_ITEM_QUERY_KEY_ONE))
+	else if (0 != (query->flags & ZBX_ITEM_QUERY_FILTER) &&
+			SUCCEED == expression_get_filter_hostids(eval, groups, filter_template, &hostids))
 	{
-		esc = DBdyn_escape_string(query->ref.key);
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " %s i.key_='%s'", clause, esc);
-		zbx_free(esc);
-		clause = "and";
+		phostids = &hostids;
 	}
 
-	if (0 != (query->flags & ZBX_ITEM_QUERY_FILTER) && NULL != filter_template && '\0' != *filter_template)
+	if (0 != (query->flags & ZBX_ITEM_QUERY_KEY_SOME))
 	{
-		zbx_uint64_t		index;
-		int			pos = 0, last_pos = 0;
-		zbx_token_t		token;
-		zbx_expression_group_t	*group;
-
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " %s ", clause);
-
-		for (; SUCCEED == zbx_token_find(filter_template, pos, &token, ZBX_TOKEN_SEARCH_FUNCTIONID); pos++)
+		if (SUCCEED != parse_item_key(query->ref.key, &pattern))
 		{
-			if (ZBX_TOKEN_OBJECTID != token.type)
-				continue;
-
-			if (SUCCEED != is_uint64_n(filter_template + token.loc.l + 1, token.loc.r - token.loc.l - 1,
-					&index) && (int)index < groups->values_num)
-			{
-				continue;
-			}
-
-			group = expression_get_group(eval, groups->values[index]);
-
-			zbx_strncpy_alloc(&sql, &sql_alloc, &sql_offset, filter_template + last_pos,
-					token.loc.l - last_pos);
-
-			if (' ' == sql[sql_offset - 1])
-				sql_offset--;
-
-			if (0 < group->hostids.values_num)
-			{
-				DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "i.hostid", group->hostids.values,
-						group->hostids.values_num);
-			}
-			else
-				zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " 1=0");
-
-			last_pos = token.loc.r + 1;
-			pos = token.loc.r;
+			THIS_SHOULD_NEVER_HAPPEN;
+			goto out;
 		}
 
-		if ('\0' != filter_template[last_pos])
-			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, filter_template + last_pos);
-	}
-
-	result = DBselect("%s", sql);
-
-	while (NULL != (row = DBfetch(result)))
-	{
-		zbx_uint64_pair_t	pair;
-
-		if (0 == (query->flags & ZBX_ITEM_QUERY_KEY_SOME) ||
-				(NULL != pattern.key && SUCCEED == expression_match_item_key(row[2], &pattern)))
-		{
-			ZBX_STR2UINT64(pair.first, row[0]);
-			ZBX_STR2UINT64(pair.second, row[1]);
-			zbx_vector_uint64_pair_append(itemhosts, pair);
-		}
+		ppattern = &pattern;
 	}
-	DBfree_result(result);
-
-	if (0 != (query->flags & ZBX_ITEM_QUERY_KEY_SOME))
-		free_request(&pattern);
+	else if (0 != (query->flags & ZBX_ITEM_QUERY_KEY_ONE))
+		key = query->ref.key;
 
-	zbx_free(sql);
+	zbx_dc_get_item_candidates(phostids, key, ppattern, itemhosts);
+out:
+	free_request(&pattern);
+	zbx_vector_uint64_destroy(&hostids);
 }
 
 /******************************************************************************
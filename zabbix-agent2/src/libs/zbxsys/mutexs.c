@@ -29,6 +29,10 @@ typedef struct
 {
 	pthread_mutex_t		mutexes[ZBX_MUTEX_COUNT];
 	pthread_rwlock_t	rwlocks[ZBX_RWLOCK_COUNT];
+	pthread_mutex_t		read_stats_lock;	/* protects rwlock read statistics */
+	zbx_lock_stats_t	mutex_stats[ZBX_MUTEX_COUNT];
+	zbx_lock_stats_t	rwlock_write_stats[ZBX_RWLOCK_COUNT];
+	zbx_lock_stats_t	rwlock_read_stats[ZBX_RWLOCK_COUNT];
 }
 zbx_shared_lock_t;
 
@@ -119,6 +123,12 @@ int	zbx_locks_create(char **error)
 		}
 	}
 
+	if (0 != pthread_mutex_init(&shared_lock->read_stats_lock, &mta))
+	{
+		*error = zbx_dsprintf(*error, "cannot create mutex: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
 	if (0 != pthread_rwlockattr_init(&rwa))
 	{
 		*error = zbx_dsprintf(*error, "cannot initialize read write lock attribute: %s", zbx_strerror(errno));
@@ -181,6 +191,8 @@ void	zbx_locks_destroy(void)
 	for (i = 0; i < ZBX_MUTEX_COUNT; i++)
 		(void)pthread_mutex_destroy(&shared_lock->mutexes[i]);
 
+	(void)pthread_mutex_destroy(&shared_lock->read_stats_lock);
+
 	for (i = 0; i < ZBX_RWLOCK_COUNT; i++)
 		(void)pthread_rwlock_destroy(&shared_lock->rwlocks[i]);
 
@@ -232,6 +244,78 @@ zbx_rwlock_t	zbx_rwlock_addr_get(zbx_rwlock_name_t rwlock_name)
 #endif
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mutex_get_stats                                              *
+ *                                                                            *
+ * Purpose: get lock contention statistics of the mutex                       *
+ *                                                                            *
+ * Parameters: mutex_name - [IN] name of the mutex                            *
+ *             stats      - [OUT] the mutex statistics                        *
+ *                                                                            *
+ * Return value: SUCCEED - the statistics were returned                       *
+ *               FAIL    - lock statistics are not supported                  *
+ *                                                                            *
+ * Comments: Statistics are collected only for pthread based locks.           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_mutex_get_stats(zbx_mutex_name_t mutex_name, zbx_lock_stats_t *stats)
+{
+#ifdef HAVE_PTHREAD_PROCESS_SHARED
+	if (NULL == shared_lock)
+		return FAIL;
+
+	*stats = shared_lock->mutex_stats[mutex_name];
+
+	return SUCCEED;
+#else
+	ZBX_UNUSED(mutex_name);
+	ZBX_UNUSED(stats);
+
+	return FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_rwlock_get_stats                                             *
+ *                                                                            *
+ * Purpose: get lock contention statistics of the read-write lock             *
+ *                                                                            *
+ * Parameters: rwlock_name - [IN] name of the read-write lock                 *
+ *             write_stats - [OUT] the write lock statistics                  *
+ *             read_stats  - [OUT] the read lock statistics, only waits are   *
+ *                                 counted                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the statistics were returned                       *
+ *               FAIL    - lock statistics are not supported                  *
+ *                                                                            *
+ * Comments: Statistics are collected only for pthread based locks.           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_rwlock_get_stats(zbx_rwlock_name_t rwlock_name, zbx_lock_stats_t *write_stats,
+		zbx_lock_stats_t *read_stats)
+{
+#ifdef HAVE_PTHREAD_PROCESS_SHARED
+	if (NULL == shared_lock)
+		return FAIL;
+
+	*write_stats = shared_lock->rwlock_write_stats[rwlock_name];
+
+	pthread_mutex_lock(&shared_lock->read_stats_lock);
+	*read_stats = shared_lock->rwlock_read_stats[rwlock_name];
+	pthread_mutex_unlock(&shared_lock->read_stats_lock);
+
+	return SUCCEED;
+#else
+	ZBX_UNUSED(rwlock_name);
+	ZBX_UNUSED(write_stats);
+	ZBX_UNUSED(read_stats);
+
+	return FAIL;
+#endif
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_rwlock_create                                                *
@@ -260,6 +344,47 @@ int	zbx_rwlock_create(zbx_rwlock_t *rwlock, zbx_rwlock_name_t name, char **error
 	return SUCCEED;
 }
 #ifdef HAVE_PTHREAD_PROCESS_SHARED
+/******************************************************************************
+ *                                                                            *
+ * Function: mutex_stats_get                                                  *
+ *                                                                            *
+ * Purpose: get statistics slot of the shared mutex                           *
+ *                                                                            *
+ * Parameters: mutex - handle of mutex                                        *
+ *                                                                            *
+ * Return value: statistics of the mutex or NULL if the mutex does not belong *
+ *               to the shared lock set                                       *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_lock_stats_t	*mutex_stats_get(zbx_mutex_t mutex)
+{
+	if (NULL == shared_lock || mutex < shared_lock->mutexes || mutex >= shared_lock->mutexes + ZBX_MUTEX_COUNT)
+		return NULL;
+
+	return &shared_lock->mutex_stats[mutex - shared_lock->mutexes];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: rwlock_stats_get                                                 *
+ *                                                                            *
+ * Purpose: get statistics slot of the shared read-write lock                 *
+ *                                                                            *
+ * Parameters: rwlock - handle of read-write lock                             *
+ *             stats  - [IN] write or read statistics array                   *
+ *                                                                            *
+ * Return value: statistics of the read-write lock or NULL if the lock does   *
+ *               not belong to the shared lock set                            *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_lock_stats_t	*rwlock_stats_get(zbx_rwlock_t rwlock, zbx_lock_stats_t *stats)
+{
+	if (NULL == shared_lock || rwlock < shared_lock->rwlocks || rwlock >= shared_lock->rwlocks + ZBX_RWLOCK_COUNT)
+		return NULL;
+
+	return &stats[rwlock - shared_lock->rwlocks];
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: __zbx_rwlock_wrlock                                              *
@@ -271,16 +396,45 @@ int	zbx_rwlock_create(zbx_rwlock_t *rwlock, zbx_rwlock_name_t name, char **error
  ******************************************************************************/
 void	__zbx_rwlock_wrlock(const char *filename, int line, zbx_rwlock_t rwlock)
 {
+	int			err;
+	double			time_start, wait_time = 0;
+	zbx_lock_stats_t	*stats;
+
 	if (ZBX_RWLOCK_NULL == rwlock)
 		return;
 
 	if (0 != locks_disabled)
 		return;
 
-	if (0 != pthread_rwlock_wrlock(rwlock))
+	if (0 != (err = pthread_rwlock_trywrlock(rwlock)))
 	{
-		zbx_error("[file:'%s',line:%d] write lock failed: %s", filename, line, zbx_strerror(errno));
-		exit(EXIT_FAILURE);
+		if (EBUSY != err)
+		{
+			zbx_error("[file:'%s',line:%d] write lock failed: %s", filename, line, zbx_strerror(err));
+			exit(EXIT_FAILURE);
+		}
+
+		time_start = zbx_time();
+
+		if (0 != pthread_rwlock_wrlock(rwlock))
+		{
+			zbx_error("[file:'%s',line:%d] write lock failed: %s", filename, line, zbx_strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+
+		wait_time = zbx_time() - time_start;
+	}
+
+	/* statistics are updated while holding the exclusive lock */
+	if (NULL != (stats = rwlock_stats_get(rwlock, shared_lock->rwlock_write_stats)))
+	{
+		stats->locks++;
+
+		if (0 != err)
+		{
+			stats->waits++;
+			stats->wait_time += wait_time;
+		}
 	}
 }
 
@@ -295,17 +449,43 @@ void	__zbx_rwlock_wrlock(const char *filename, int line, zbx_rwlock_t rwlock)
  ******************************************************************************/
 void	__zbx_rwlock_rdlock(const char *filename, int line, zbx_rwlock_t rwlock)
 {
+	int			err;
+	double			time_start, wait_time;
+	zbx_lock_stats_t	*stats;
+
 	if (ZBX_RWLOCK_NULL == rwlock)
 		return;
 
 	if (0 != locks_disabled)
 		return;
 
+	if (0 == (err = pthread_rwlock_tryrdlock(rwlock)))
+		return;
+
+	if (EBUSY != err)
+	{
+		zbx_error("[file:'%s',line:%d] read lock failed: %s", filename, line, zbx_strerror(err));
+		exit(EXIT_FAILURE);
+	}
+
+	time_start = zbx_time();
+
 	if (0 != pthread_rwlock_rdlock(rwlock))
 	{
 		zbx_error("[file:'%s',line:%d] read lock failed: %s", filename, line, zbx_strerror(errno));
 		exit(EXIT_FAILURE);
 	}
+
+	/* uncontended read locks are not counted to keep the fast path free of extra locking */
+	if (NULL != (stats = rwlock_stats_get(rwlock, shared_lock->rwlock_read_stats)))
+	{
+		wait_time = zbx_time() - time_start;
+
+		pthread_mutex_lock(&shared_lock->read_stats_lock);
+		stats->waits++;
+		stats->wait_time += wait_time;
+		pthread_mutex_unlock(&shared_lock->read_stats_lock);
+	}
 }
 
 /******************************************************************************
@@ -428,7 +608,11 @@ int	zbx_mutex_create(zbx_mutex_t *mutex, zbx_mutex_name_t name, char **error)
 void	__zbx_mutex_lock(const char *filename, int line, zbx_mutex_t mutex)
 {
 #ifndef _WINDOWS
-#ifndef	HAVE_PTHREAD_PROCESS_SHARED
+#ifdef	HAVE_PTHREAD_PROCESS_SHARED
+	int			err;
+	double			time_start, wait_time = 0;
+	zbx_lock_stats_t	*stats;
+#else
 	struct sembuf	sem_lock;
 #endif
 #else
@@ -466,10 +650,34 @@ void	__zbx_mutex_lock(const char *filename, int line, zbx_mutex_t mutex)
 	if (0 != locks_disabled)
 		return;
 
-	if (0 != pthread_mutex_lock(mutex))
+	if (0 != (err = pthread_mutex_trylock(mutex)))
 	{
-		zbx_error("[file:'%s',line:%d] lock failed: %s", filename, line, zbx_strerror(errno));
-		exit(EXIT_FAILURE);
+		if (EBUSY != err)
+		{
+			zbx_error("[file:'%s',line:%d] lock failed: %s", filename, line, zbx_strerror(err));
+			exit(EXIT_FAILURE);
+		}
+
+		time_start = zbx_time();
+
+		if (0 != pthread_mutex_lock(mutex))
+		{
+			zbx_error("[file:'%s',line:%d] lock failed: %s", filename, line, zbx_strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+
+		wait_time = zbx_time() - time_start;
+	}
+
+	if (NULL != (stats = mutex_stats_get(mutex)))
+	{
+		stats->locks++;
+
+		if (0 != err)
+		{
+			stats->waits++;
+			stats->wait_time += wait_time;
+		}
 	}
 #else
 	sem_lock.sem_num = mutex;
@@ -26,6 +26,12 @@
 #include "trends.h"
 
 extern zbx_uint64_t	CONFIG_TREND_FUNC_CACHE_SIZE;
+extern char		*CONFIG_TREND_FUNC_CACHE_FILE;
+
+#define ZBX_TFC_FILE_MAGIC	"ZBXTFC"
+#define ZBX_TFC_FILE_VERSION	1
+
+#define ZBX_TFC_FILE_LOAD_BATCH_SIZE	1000
 
 typedef struct
 {
@@ -64,6 +70,28 @@ typedef struct
 }
 zbx_tfc_t;
 
+/* trend function cache snapshot file header */
+typedef struct
+{
+	char		magic[8];
+	zbx_uint32_t	version;
+	zbx_uint32_t	records_num;
+	int		clock;
+}
+zbx_tfc_file_header_t;
+
+/* trend function cache snapshot file record */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	int		start;
+	int		end;
+	int		function;
+	int		state;
+	double		value;
+}
+zbx_tfc_file_record_t;
+
 static zbx_tfc_t	*cache = NULL;
 static int		alloc_num = 0;
 
@@ -546,6 +574,46 @@ int	zbx_tfc_get_value(zbx_uint64_t itemid, int start, int end, zbx_trend_functio
 	return NULL != data ? SUCCEED : FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tfc_check_value                                              *
+ *                                                                            *
+ * Purpose: check if trend function value is cached                           *
+ *                                                                            *
+ * Parameters: itemid   - [IN] the itemid                                     *
+ *             start    - [IN] the period start time (including)              *
+ *             end      - [IN] the period end time (including)                *
+ *             function - [IN] the trend function                             *
+ *                                                                            *
+ * Return value: SUCCEED - the value is cached                                *
+ *               FAIL - no cached item value of the function over the range   *
+ *                                                                            *
+ * Comments: Unlike zbx_tfc_get_value() this function does not update cache   *
+ *           statistics, so it can be used to find values to prefetch.        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tfc_check_value(zbx_uint64_t itemid, int start, int end, zbx_trend_function_t function)
+{
+	zbx_tfc_data_t	data_local;
+	int		ret;
+
+	if (NULL == cache)
+		return FAIL;
+
+	data_local.itemid = itemid;
+	data_local.start = start;
+	data_local.end = end;
+	data_local.function = function;
+
+	LOCK_CACHE;
+
+	ret = (NULL != zbx_hashset_search(&cache->index, &data_local) ? SUCCEED : FAIL);
+
+	UNLOCK_CACHE;
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_tfc_put_value                                                *
@@ -668,6 +736,250 @@ void	zbx_tfc_invalidate_trends(ZBX_DC_TREND *trends, int trends_num)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tfc_save                                                     *
+ *                                                                            *
+ * Purpose: write trend function cache contents to the snapshot file          *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the cache was saved or snapshot file is not        *
+ *                         configured                                         *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ * Comments: The values are written in least recently used order, so loading  *
+ *           them into smaller cache drops the oldest values. The snapshot    *
+ *           is written to temporary file and renamed to the target file.     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tfc_save(char **error)
+{
+	FILE			*f;
+	char			*tmp_path;
+	zbx_tfc_file_header_t	header;
+	zbx_tfc_file_record_t	record;
+	zbx_uint32_t		index;
+	int			ret = FAIL;
+
+	if (NULL == cache || NULL == CONFIG_TREND_FUNC_CACHE_FILE)
+		return SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	tmp_path = zbx_dsprintf(NULL, "%s.tmp", CONFIG_TREND_FUNC_CACHE_FILE);
+
+	if (NULL == (f = fopen(tmp_path, "wb")))
+	{
+		*error = zbx_dsprintf(*error, "cannot open file \"%s\": %s", tmp_path, zbx_strerror(errno));
+		goto out;
+	}
+
+	memset(&header, 0, sizeof(header));
+	zbx_strlcpy(header.magic, ZBX_TFC_FILE_MAGIC, sizeof(header.magic));
+	header.version = ZBX_TFC_FILE_VERSION;
+	header.clock = (int)time(NULL);
+
+	LOCK_CACHE;
+
+	header.records_num = (zbx_uint32_t)(cache->index.num_data - cache->items_num);
+
+	if (1 != fwrite(&header, sizeof(header), 1, f))
+		goto unlock;
+
+	memset(&record, 0, sizeof(record));
+
+	for (index = cache->lru_head; UINT32_MAX != index; index = cache->slots[index].data.next)
+	{
+		const zbx_tfc_data_t	*data = &cache->slots[index].data;
+
+		record.itemid = data->itemid;
+		record.start = data->start;
+		record.end = data->end;
+		record.function = data->function;
+		record.state = data->state;
+		record.value = data->value;
+
+		if (1 != fwrite(&record, sizeof(record), 1, f))
+			goto unlock;
+	}
+
+	ret = SUCCEED;
+unlock:
+	UNLOCK_CACHE;
+
+	if (0 != fclose(f))
+		ret = FAIL;
+
+	if (SUCCEED != ret)
+	{
+		*error = zbx_dsprintf(*error, "cannot write file \"%s\": %s", tmp_path, zbx_strerror(errno));
+		unlink(tmp_path);
+		goto out;
+	}
+
+	if (0 != rename(tmp_path, CONFIG_TREND_FUNC_CACHE_FILE))
+	{
+		*error = zbx_dsprintf(*error, "cannot rename file \"%s\" to \"%s\": %s", tmp_path,
+				CONFIG_TREND_FUNC_CACHE_FILE, zbx_strerror(errno));
+		unlink(tmp_path);
+		ret = FAIL;
+		goto out;
+	}
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "saved %u trend function cache values to \"%s\"", header.records_num,
+			CONFIG_TREND_FUNC_CACHE_FILE);
+out:
+	zbx_free(tmp_path);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tfc_load                                                     *
+ *                                                                            *
+ * Purpose: warm up trend function cache from the snapshot file               *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the cache was loaded or there is no snapshot file  *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ * Comments: The snapshot file is removed after loading. Trends written while *
+ *           the server is running invalidate the cached values, so a         *
+ *           snapshot left by a crashed server must not be reused.            *
+ *           Values of periods including the hour the snapshot was saved are  *
+ *           skipped, as trends of that hour could be updated later.          *
+ *           Values of items having trends of hours after the snapshot are    *
+ *           skipped too - those trends were written by another HA node,      *
+ *           which could also have updated trends of older hours with late    *
+ *           values. Must be called with database connection.                 *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tfc_load(char **error)
+{
+	FILE			*f;
+	zbx_tfc_file_header_t	header;
+	zbx_tfc_file_record_t	*records;
+	zbx_uint32_t		i, j, num, loaded = 0;
+	int			ret = FAIL, hour;
+	zbx_vector_uint64_t	itemids, updated;
+
+	if (NULL == cache || NULL == CONFIG_TREND_FUNC_CACHE_FILE)
+		return SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL == (f = fopen(CONFIG_TREND_FUNC_CACHE_FILE, "rb")))
+	{
+		if (ENOENT == errno)
+		{
+			ret = SUCCEED;
+		}
+		else
+		{
+			*error = zbx_dsprintf(*error, "cannot open file \"%s\": %s", CONFIG_TREND_FUNC_CACHE_FILE,
+					zbx_strerror(errno));
+		}
+
+		goto out;
+	}
+
+	if (1 != fread(&header, sizeof(header), 1, f) ||
+			0 != strncmp(header.magic, ZBX_TFC_FILE_MAGIC, sizeof(header.magic)))
+	{
+		*error = zbx_dsprintf(*error, "file \"%s\" is not a trend function cache snapshot",
+				CONFIG_TREND_FUNC_CACHE_FILE);
+		goto close;
+	}
+
+	if (ZBX_TFC_FILE_VERSION != header.version)
+	{
+		*error = zbx_dsprintf(*error, "unsupported trend function cache snapshot version %u",
+				header.version);
+		goto close;
+	}
+
+	hour = header.clock - header.clock % SEC_PER_HOUR;
+
+	records = (zbx_tfc_file_record_t *)zbx_malloc(NULL, sizeof(zbx_tfc_file_record_t) *
+			ZBX_TFC_FILE_LOAD_BATCH_SIZE);
+	zbx_vector_uint64_create(&itemids);
+	zbx_vector_uint64_create(&updated);
+
+	for (i = 0; i < header.records_num; i += num)
+	{
+		num = MIN(header.records_num - i, ZBX_TFC_FILE_LOAD_BATCH_SIZE);
+
+		if (num != fread(records, sizeof(zbx_tfc_file_record_t), num, f))
+		{
+			*error = zbx_dsprintf(*error, "file \"%s\" is truncated", CONFIG_TREND_FUNC_CACHE_FILE);
+			goto clean;
+		}
+
+		zbx_vector_uint64_clear(&itemids);
+		zbx_vector_uint64_clear(&updated);
+
+		for (j = 0; j < num; j++)
+			zbx_vector_uint64_append(&itemids, records[j].itemid);
+
+		zbx_vector_uint64_sort(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		if (SUCCEED != trends_get_updated_itemids(&itemids, hour, &updated))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot check trends of %u trend function cache values,"
+					" skipping them", num);
+			continue;
+		}
+
+		for (j = 0; j < num; j++)
+		{
+			const zbx_tfc_file_record_t	*record = &records[j];
+
+			if (ZBX_TREND_FUNCTION_UNKNOWN >= record->function ||
+					ZBX_TREND_FUNCTION_SUM < record->function ||
+					ZBX_TREND_STATE_UNKNOWN >= record->state ||
+					ZBX_TREND_STATE_COUNT <= record->state || record->end >= hour)
+			{
+				continue;
+			}
+
+			if (FAIL != zbx_vector_uint64_bsearch(&updated, record->itemid, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+				continue;
+
+			zbx_tfc_put_value(record->itemid, record->start, record->end,
+					(zbx_trend_function_t)record->function, record->value,
+					(zbx_trend_state_t)record->state);
+			loaded++;
+		}
+	}
+
+	ret = SUCCEED;
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "loaded %u trend function cache values from \"%s\"", loaded,
+			CONFIG_TREND_FUNC_CACHE_FILE);
+clean:
+	zbx_vector_uint64_destroy(&updated);
+	zbx_vector_uint64_destroy(&itemids);
+	zbx_free(records);
+close:
+	fclose(f);
+
+	if (0 != unlink(CONFIG_TREND_FUNC_CACHE_FILE))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot remove file \"%s\": %s", CONFIG_TREND_FUNC_CACHE_FILE,
+				zbx_strerror(errno));
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
 int	zbx_tfc_get_stats(zbx_tfc_stats_t *stats, char **error)
 {
 	if (NULL == cache)
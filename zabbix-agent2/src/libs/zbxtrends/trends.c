@@ -23,6 +23,23 @@
 #include "zbxtrends.h"
 #include "trends.h"
 
+extern zbx_uint64_t	CONFIG_TREND_FUNC_CACHE_SIZE;
+
+/* trend function value missing from trend function cache, to be retrieved with batched query */
+typedef struct
+{
+	const char		*table;
+	zbx_uint64_t		itemid;
+	int			start;
+	int			end;
+	zbx_trend_function_t	function;
+	int			done;
+}
+zbx_trend_request_t;
+
+static zbx_vector_ptr_t	trend_requests;
+static int		trend_requests_init = 0;
+
 static char	*trends_errors[ZBX_TREND_STATE_COUNT] = {
 		"unknown error",
 		NULL,
@@ -586,6 +603,312 @@ static zbx_trend_state_t	trends_eval_sum(const char *table, zbx_uint64_t itemid,
 	return ZBX_TREND_STATE_NORMAL;
 }
 
+static int	trend_request_compare_func(const void *d1, const void *d2)
+{
+	const zbx_trend_request_t	*r1 = *(const zbx_trend_request_t * const *)d1;
+	const zbx_trend_request_t	*r2 = *(const zbx_trend_request_t * const *)d2;
+	int				ret;
+
+	if (0 != (ret = strcmp(r1->table, r2->table)))
+		return ret;
+
+	ZBX_RETURN_IF_NOT_EQUAL(r1->start, r2->start);
+	ZBX_RETURN_IF_NOT_EQUAL(r1->end, r2->end);
+	ZBX_RETURN_IF_NOT_EQUAL(r1->itemid, r2->itemid);
+	ZBX_RETURN_IF_NOT_EQUAL(r1->function, r2->function);
+
+	return 0;
+}
+
+static int	trend_request_itemid_compare_func(const void *d1, const void *d2)
+{
+	const zbx_uint64_t		*itemid = (const zbx_uint64_t *)d1;
+	const zbx_trend_request_t	*r2 = *(const zbx_trend_request_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(*itemid, r2->itemid);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trends_function_by_name                                          *
+ *                                                                            *
+ * Purpose: get trend function by its name without 'trend' prefix             *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_trend_function_t	trends_function_by_name(const char *name)
+{
+	if (0 == strcmp(name, "avg"))
+		return ZBX_TREND_FUNCTION_AVG;
+	if (0 == strcmp(name, "count"))
+		return ZBX_TREND_FUNCTION_COUNT;
+	if (0 == strcmp(name, "max"))
+		return ZBX_TREND_FUNCTION_MAX;
+	if (0 == strcmp(name, "min"))
+		return ZBX_TREND_FUNCTION_MIN;
+	if (0 == strcmp(name, "sum"))
+		return ZBX_TREND_FUNCTION_SUM;
+
+	return ZBX_TREND_FUNCTION_UNKNOWN;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trends_prefetch_set_values                                       *
+ *                                                                            *
+ * Purpose: cache trend function values of the requests for one item          *
+ *                                                                            *
+ * Parameters: requests - [IN] the requests of the same item, table and       *
+ *                             period                                         *
+ *             num      - [IN] the number of requests                         *
+ *             row      - [IN] the aggregated trends data of the item or NULL *
+ *                             if there are no trends in the period           *
+ *                                                                            *
+ * Comments: The row contains itemid, number of trend records, number of      *
+ *           values, minimum, maximum, sum of values and the average value    *
+ *           of the last record. The states and values match the ones         *
+ *           calculated by single item trend functions.                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	trends_prefetch_set_values(zbx_trend_request_t **requests, int num, DB_ROW row)
+{
+	int			i;
+	double			value, num_values, sum;
+	zbx_trend_state_t	state;
+
+	for (i = 0; i < num; i++)
+	{
+		zbx_trend_request_t	*request = requests[i];
+
+		value = 0;
+
+		if (NULL == row)
+		{
+			if (ZBX_TREND_FUNCTION_COUNT == request->function || ZBX_TREND_FUNCTION_SUM == request->function)
+				state = ZBX_TREND_STATE_NORMAL;
+			else
+				state = ZBX_TREND_STATE_NODATA;
+		}
+		else
+		{
+			state = ZBX_TREND_STATE_NORMAL;
+
+			switch (request->function)
+			{
+				case ZBX_TREND_FUNCTION_AVG:
+					num_values = atof(row[2]);
+
+					if (1 == atoi(row[1]))
+						value = atof(row[6]);
+					else if (0 != num_values)
+						value = atof(row[5]) / num_values;
+					else
+						state = ZBX_TREND_STATE_NODATA;
+					break;
+				case ZBX_TREND_FUNCTION_COUNT:
+					value = atof(row[2]);
+					break;
+				case ZBX_TREND_FUNCTION_MIN:
+					value = atof(row[3]);
+					break;
+				case ZBX_TREND_FUNCTION_MAX:
+					value = atof(row[4]);
+					break;
+				case ZBX_TREND_FUNCTION_SUM:
+					if (ZBX_INFINITY == (sum = atof(row[5])))
+						state = ZBX_TREND_STATE_OVERFLOW;
+					else
+						value = sum;
+					break;
+				default:
+					THIS_SHOULD_NEVER_HAPPEN;
+					continue;
+			}
+		}
+
+		zbx_tfc_put_value(request->itemid, request->start, request->end, request->function, value, state);
+		request->done = 1;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trends_prefetch_period                                           *
+ *                                                                            *
+ * Purpose: retrieve trend function values of all items requested for the     *
+ *          same table and period with a single query                         *
+ *                                                                            *
+ * Parameters: requests - [IN] the requests sorted by itemid                  *
+ *             num      - [IN] the number of requests                         *
+ *                                                                            *
+ * Comments: If the query fails the requests are left uncached and will be    *
+ *           evaluated by the single item trend functions.                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	trends_prefetch_period(zbx_trend_request_t **requests, int num)
+{
+	DB_RESULT		result;
+	DB_ROW			row;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			i, j;
+	zbx_uint64_t		itemid;
+	zbx_vector_uint64_t	itemids;
+	zbx_trend_request_t	**request;
+
+	zbx_vector_uint64_create(&itemids);
+
+	for (i = 0; i < num; i++)
+		zbx_vector_uint64_append(&itemids, requests[i]->itemid);
+
+	zbx_vector_uint64_uniq(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+			"select itemid,count(*),sum(num),min(value_min),max(value_max),sum(value_avg*num),"
+				"max(value_avg)"
+			" from %s"
+			" where clock>=%d"
+				" and clock<=%d"
+				" and",
+			requests[0]->table, requests[0]->start, requests[0]->end);
+	DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids.values, itemids.values_num);
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " group by itemid");
+
+	result = DBselect("%s", sql);
+	zbx_free(sql);
+
+	if (NULL == result)
+		goto out;
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		ZBX_STR2UINT64(itemid, row[0]);
+
+		if (NULL == (request = (zbx_trend_request_t **)bsearch(&itemid, requests, (size_t)num,
+				sizeof(zbx_trend_request_t *), trend_request_itemid_compare_func)))
+		{
+			continue;
+		}
+
+		for (i = (int)(request - requests); 0 < i && requests[i - 1]->itemid == itemid; i--)
+			;
+
+		for (j = i + 1; j < num && requests[j]->itemid == itemid; j++)
+			;
+
+		trends_prefetch_set_values(requests + i, j - i, row);
+	}
+
+	DBfree_result(result);
+
+	for (i = 0; i < num; i++)
+	{
+		if (0 == requests[i]->done)
+			trends_prefetch_set_values(requests + i, 1, NULL);
+	}
+out:
+	zbx_vector_uint64_destroy(&itemids);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_trends_prefetch_add                                          *
+ *                                                                            *
+ * Purpose: register trend function value to be retrieved by the next         *
+ *          zbx_trends_prefetch() call                                        *
+ *                                                                            *
+ * Parameters: table    - [IN] the trends table name                          *
+ *             itemid   - [IN] the itemid                                     *
+ *             start    - [IN] the period start time                          *
+ *             end      - [IN] the period end time                            *
+ *             function - [IN] the trend function name without 'trend'        *
+ *                             prefix (avg, count, max, min, sum)             *
+ *                                                                            *
+ * Comments: Values already in trend function cache are ignored. Without the  *
+ *           cache the prefetched values could not be kept, so nothing is     *
+ *           registered when the cache is disabled.                           *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_trends_prefetch_add(const char *table, zbx_uint64_t itemid, int start, int end, const char *function)
+{
+	zbx_trend_request_t	*request;
+	zbx_trend_function_t	trend_function;
+
+	if (0 == CONFIG_TREND_FUNC_CACHE_SIZE)
+		return;
+
+	if (ZBX_TREND_FUNCTION_UNKNOWN == (trend_function = trends_function_by_name(function)))
+		return;
+
+	if (SUCCEED == zbx_tfc_check_value(itemid, start, end, trend_function))
+		return;
+
+	if (0 == trend_requests_init)
+	{
+		zbx_vector_ptr_create(&trend_requests);
+		trend_requests_init = 1;
+	}
+
+	request = (zbx_trend_request_t *)zbx_malloc(NULL, sizeof(zbx_trend_request_t));
+	request->table = table;
+	request->itemid = itemid;
+	request->start = start;
+	request->end = end;
+	request->function = trend_function;
+	request->done = 0;
+
+	zbx_vector_ptr_append(&trend_requests, request);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_trends_prefetch                                              *
+ *                                                                            *
+ * Purpose: retrieve registered trend function values into trend function     *
+ *          cache                                                             *
+ *                                                                            *
+ * Comments: The requests are grouped by table and period, each group is      *
+ *           retrieved with one query aggregating trends by itemid. This      *
+ *           replaces one query per item, period and function when many       *
+ *           trend functions miss the cache at once, for example after        *
+ *           restart or at the beginning of an hour.                          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_trends_prefetch(void)
+{
+	int	i, j;
+
+	if (0 == trend_requests_init || 0 == trend_requests.values_num)
+		return;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() requests:%d", __func__, trend_requests.values_num);
+
+	zbx_vector_ptr_sort(&trend_requests, trend_request_compare_func);
+
+	for (i = 0; i < trend_requests.values_num; i = j)
+	{
+		zbx_trend_request_t	*request = (zbx_trend_request_t *)trend_requests.values[i];
+
+		for (j = i + 1; j < trend_requests.values_num; j++)
+		{
+			zbx_trend_request_t	*next = (zbx_trend_request_t *)trend_requests.values[j];
+
+			if (request->start != next->start || request->end != next->end ||
+					0 != strcmp(request->table, next->table))
+			{
+				break;
+			}
+		}
+
+		trends_prefetch_period((zbx_trend_request_t **)trend_requests.values + i, j - i);
+	}
+
+	zbx_vector_ptr_clear_ext(&trend_requests, zbx_ptr_free);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 int	zbx_trends_eval_avg(const char *table, zbx_uint64_t itemid, int start, int end, double *value, char **error)
 {
 	zbx_trend_state_t	state;
@@ -682,6 +1005,59 @@ int	zbx_trends_eval_sum(const char *table, zbx_uint64_t itemid, int start, int e
 	return FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: trends_get_updated_itemids                                       *
+ *                                                                            *
+ * Purpose: gets items having trends of hours after the specified time        *
+ *                                                                            *
+ * Parameters: itemids - [IN] the items to check                              *
+ *             clock   - [IN] the time                                        *
+ *             updated - [OUT] the items having trends after the specified    *
+ *                             time                                           *
+ *                                                                            *
+ * Return value: SUCCEED - the items were checked successfully                *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	trends_get_updated_itemids(const zbx_vector_uint64_t *itemids, int clock, zbx_vector_uint64_t *updated)
+{
+	const char	*tables[] = {"trends", "trends_uint"};
+	char		*sql = NULL;
+	size_t		sql_alloc = 0, sql_offset;
+	DB_RESULT	result;
+	DB_ROW		row;
+	zbx_uint64_t	itemid;
+	int		i, ret = SUCCEED;
+
+	for (i = 0; i < (int)ARRSIZE(tables); i++)
+	{
+		sql_offset = 0;
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select distinct itemid from %s where clock>%d and",
+				tables[i], clock);
+		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids->values, itemids->values_num);
+
+		if (NULL == (result = DBselect("%s", sql)))
+		{
+			ret = FAIL;
+			break;
+		}
+
+		while (NULL != (row = DBfetch(result)))
+		{
+			ZBX_STR2UINT64(itemid, row[0]);
+			zbx_vector_uint64_append(updated, itemid);
+		}
+		DBfree_result(result);
+	}
+
+	zbx_free(sql);
+
+	zbx_vector_uint64_sort(updated, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	return ret;
+}
+
 zbx_trend_state_t	zbx_trends_get_avg(const char *table, zbx_uint64_t itemid, int start, int end, double *value)
 {
 	zbx_trend_state_t	state;
@@ -18,6 +18,7 @@
 **/
 
 #include "common.h"
+#include "zbxalgo.h"
 
 #ifndef ZABBIX_TRENDS_H
 #define ZABBIX_TRENDS_H
@@ -34,9 +35,12 @@ typedef enum
 }
 zbx_trend_function_t;
 
+int	zbx_tfc_check_value(zbx_uint64_t itemid, int start, int end, zbx_trend_function_t function);
 int	zbx_tfc_get_value(zbx_uint64_t itemid, int start, int end, zbx_trend_function_t function, double *value,
 		zbx_trend_state_t *state);
 void	zbx_tfc_put_value(zbx_uint64_t itemid, int start, int end, zbx_trend_function_t function, double value,
 		zbx_trend_state_t state);
 
+int	trends_get_updated_itemids(const zbx_vector_uint64_t *itemids, int clock, zbx_vector_uint64_t *updated);
+
 #endif
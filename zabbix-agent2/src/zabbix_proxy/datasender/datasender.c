@@ -93,7 +93,7 @@ static void	get_hist_upload_state(const char *buffer, int *state)
  ******************************************************************************/
 static int	proxy_data_sender(int *more, int now, int *hist_upload_state)
 {
-	static int		data_timestamp = 0, task_timestamp = 0, upload_state = SUCCEED;
+	static int		data_timestamp = 0, task_timestamp = 0, upload_state = SUCCEED, history_binary = 0;
 
 	zbx_socket_t		sock;
 	struct zbx_json		j;
@@ -120,7 +120,7 @@ static int	proxy_data_sender(int *more, int now, int *hist_upload_state)
 		if (SUCCEED == get_interface_availability_data(&j, &availability_ts))
 			flags |= ZBX_DATASENDER_AVAILABILITY;
 
-		history_records = proxy_get_hist_data(&j, &history_lastid, &more_history);
+		history_records = proxy_get_hist_data(&j, history_binary, &history_lastid, &more_history);
 		if (0 != history_lastid)
 			flags |= ZBX_DATASENDER_HISTORY;
 
@@ -215,6 +215,9 @@ static int	proxy_data_sender(int *more, int now, int *hist_upload_state)
 
 			if (SUCCEED == zbx_json_open(sock.buffer, &jp))
 			{
+				/* server tells in every response if it accepts binary history data */
+				history_binary = zbx_get_history_binary_version(&jp);
+
 				if (SUCCEED == zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_TASKS, &jp_tasks))
 					flags |= ZBX_DATASENDER_TASKS_RECV;
 			}
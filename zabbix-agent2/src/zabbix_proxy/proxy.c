@@ -217,13 +217,20 @@ zbx_uint64_t	CONFIG_HISTORY_CACHE_SIZE	= 16 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_TRENDS_CACHE_SIZE	= 0;
 zbx_uint64_t	CONFIG_TREND_FUNC_CACHE_SIZE	= 0;
+char	*CONFIG_TREND_FUNC_CACHE_FILE	= NULL;
 zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE		= 0;
 zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * ZBX_MEBIBYTE;
+zbx_uint64_t	CONFIG_PROXY_MEMORY_BUFFER_SIZE	= 0;
 zbx_uint64_t	CONFIG_EXPORT_FILE_SIZE;
 
+int	CONFIG_VALUE_CACHE_COMPRESSION	= 0;
+int	CONFIG_VALUE_CACHE_AGGREGATES	= 0;
+char	*CONFIG_VALUE_CACHE_FILE	= NULL;
+
 int	CONFIG_UNREACHABLE_PERIOD	= 45;
 int	CONFIG_UNREACHABLE_DELAY	= 15;
 int	CONFIG_UNAVAILABLE_DELAY	= 60;
+int	CONFIG_ASYNC_AGENT_CHECKS	= 0;
 int	CONFIG_LOG_LEVEL		= LOG_LEVEL_WARNING;
 char	*CONFIG_ALERT_SCRIPTS_PATH	= NULL;
 char	*CONFIG_EXTERNALSCRIPTS		= NULL;
@@ -308,6 +315,8 @@ static char	*CONFIG_SOCKET_PATH	= NULL;
 char	*CONFIG_HISTORY_STORAGE_URL		= NULL;
 char	*CONFIG_HISTORY_STORAGE_OPTS		= NULL;
 int	CONFIG_HISTORY_STORAGE_PIPELINES	= 0;
+int	CONFIG_HISTORY_BULK_LOAD		= 0;
+int	CONFIG_HISTORY_PIPELINED_COMMIT	= 0;
 
 char	*CONFIG_STATS_ALLOWED_IP	= NULL;
 int	CONFIG_TCP_MAX_BACKLOG_SIZE	= SOMAXCONN;
@@ -596,6 +605,13 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
+	if (0 != CONFIG_PROXY_MEMORY_BUFFER_SIZE && 128 * ZBX_KIBIBYTE > CONFIG_PROXY_MEMORY_BUFFER_SIZE)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"ProxyMemoryBufferSize\" configuration parameter must be either 0"
+				" or greater than 128KB");
+		err = 1;
+	}
+
 	if (ZBX_PROXYMODE_ACTIVE == CONFIG_PROXYMODE)
 	{
 		if (NULL != strchr(CONFIG_SERVER, ','))
@@ -745,6 +761,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&CONFIG_HISTORY_INDEX_CACHE_SIZE,	TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"ProxyMemoryBufferSize",	&CONFIG_PROXY_MEMORY_BUFFER_SIZE,	TYPE_UINT64,
+			PARM_OPT,	0,			__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HousekeepingFrequency",	&CONFIG_HOUSEKEEPING_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	0,			24},
 		{"ProxyLocalBuffer",		&CONFIG_PROXY_LOCAL_BUFFER,		TYPE_INT,
@@ -773,6 +791,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	1,			SEC_PER_HOUR},
 		{"UnavailableDelay",		&CONFIG_UNAVAILABLE_DELAY,		TYPE_INT,
 			PARM_OPT,	1,			SEC_PER_HOUR},
+		{"AsyncAgentChecks",		&CONFIG_ASYNC_AGENT_CHECKS,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"ListenIP",			&CONFIG_LISTEN_IP,			TYPE_STRING_LIST,
 			PARM_OPT,	0,			0},
 		{"ListenPort",			&CONFIG_LISTEN_PORT,			TYPE_INT,
@@ -789,6 +809,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"LogFileSize",			&CONFIG_LOG_FILE_SIZE,			TYPE_INT,
 			PARM_OPT,	0,			1024},
+		{"LogBuffer",			&CONFIG_LOG_BUFFER,			TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"ExternalScripts",		&CONFIG_EXTERNALSCRIPTS,		TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"DBHost",			&CONFIG_DBHOST,				TYPE_STRING,
@@ -1206,6 +1228,13 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 		exit(EXIT_FAILURE);
 	}
 
+	if (SUCCEED != zbx_pb_init(&error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize proxy memory buffer: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
 	if (SUCCEED != init_proxy_history_lock(&error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize lock for passive proxy history: %s", error);
@@ -1447,9 +1476,12 @@ void	zbx_on_exit(int ret)
 
 	DBconnect(ZBX_DB_CONNECT_EXIT);
 	free_database_cache(ZBX_SYNC_ALL);
+	zbx_pb_flush();
 	free_configuration_cache();
 	DBclose();
 
+	zbx_pb_destroy();
+
 	DBdeinit();
 
 	/* free vmware support */
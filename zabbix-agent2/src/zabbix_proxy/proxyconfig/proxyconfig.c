@@ -39,6 +39,9 @@ extern char		*CONFIG_HOSTNAME;
 extern char		*CONFIG_SOURCE_IP;
 extern unsigned int	configured_tls_connect_mode;
 
+/* the configuration revision applied by the last successful synchronization */
+static char	*proxyconfig_revision = NULL;
+
 static void	zbx_proxyconfig_sigusr_handler(int flags)
 {
 	if (ZBX_RTC_CONFIG_CACHE_RELOAD == ZBX_RTC_GET_MSG(flags))
@@ -64,7 +67,7 @@ static void	process_configuration_sync(size_t *data_size)
 	struct	zbx_json_parse	jp;
 	char			value[16], *error = NULL, *buffer = NULL;
 	size_t			buffer_size, reserved;
-	struct zbx_json		j;
+	struct zbx_json		j, revision;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -76,6 +79,10 @@ static void	process_configuration_sync(size_t *data_size)
 	zbx_json_addstring(&j, "host", CONFIG_HOSTNAME, ZBX_JSON_TYPE_STRING);
 	zbx_json_addstring(&j, ZBX_PROTO_TAG_VERSION, ZABBIX_VERSION, ZBX_JSON_TYPE_STRING);
 
+	/* server sends only the configuration changed since the acknowledged revision */
+	if (NULL != proxyconfig_revision)
+		zbx_json_addraw(&j, ZBX_PROTO_TAG_CONFIG_REVISION, proxyconfig_revision);
+
 	if (SUCCEED != zbx_compress(j.buffer, j.buffer_size, &buffer, &buffer_size))
 	{
 		zabbix_log(LOG_LEVEL_ERR,"cannot compress data: %s", zbx_compress_strerror());
@@ -134,7 +141,15 @@ static void	process_configuration_sync(size_t *data_size)
 	zabbix_log(LOG_LEVEL_WARNING, "received configuration data from server at \"%s\", datalen " ZBX_FS_SIZE_T,
 			sock.peer, (zbx_fs_size_t)*data_size);
 
-	process_proxyconfig(&jp);
+	zbx_json_init(&revision, ZBX_JSON_STAT_BUF_LEN);
+
+	/* fall back to full synchronization if the configuration could not be applied */
+	zbx_free(proxyconfig_revision);
+
+	if (SUCCEED == process_proxyconfig(&jp, &revision))
+		proxyconfig_revision = zbx_strdup(NULL, revision.buffer);
+
+	zbx_json_free(&revision);
 error:
 	disconnect_server(&sock);
 out:
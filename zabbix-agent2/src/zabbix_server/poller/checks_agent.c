@@ -18,8 +18,18 @@
 **/
 
 #include "common.h"
+
+#ifdef HAVE_LIBEVENT
+#	include <event.h>
+#	if defined(LIBEVENT_VERSION_NUMBER) && LIBEVENT_VERSION_NUMBER >= 0x2000000
+#		include <event2/dns.h>
+#		define ZBX_AGENT_ASYNC_DNS
+#	endif
+#endif
+
 #include "comms.h"
 #include "log.h"
+#include "zbxcompress.h"
 #include "../../libs/zbxcrypto/tls_tcp_active.h"
 
 #include "checks_agent.h"
@@ -28,6 +38,175 @@
 extern unsigned char	program_type;
 #endif
 
+#ifndef SOCK_CLOEXEC
+#	define SOCK_CLOEXEC 0	/* SOCK_CLOEXEC is Linux-specific, available since 2.6.23 */
+#endif
+
+#define ZBX_AGENT_STATE_IDLE	0
+#define ZBX_AGENT_STATE_RESOLVE	1
+#define ZBX_AGENT_STATE_CONNECT	2
+#define ZBX_AGENT_STATE_SEND	3
+#define ZBX_AGENT_STATE_RECV	4
+/* the check is finished, but the connection waits for callback of the cancelled name resolution */
+#define ZBX_AGENT_STATE_CANCEL	5
+/* the check waits until another check of the same interface finishes */
+#define ZBX_AGENT_STATE_WAIT	6
+
+#define ZBX_AGENT_AGAIN		1
+
+/* the minimum number of free connections to request more items for */
+#define ZBX_AGENT_REFILL_MIN	(MAX_AGENT_ITEMS / 8)
+
+/* the maximum number of concurrent connections to the same agent interface, matches the default */
+/* number of agent listeners (StartAgents), so connections are not queued in agent listen backlog */
+#define ZBX_AGENT_INTERFACE_CONNS_MAX	3
+
+/* items requested from poller at once */
+typedef struct
+{
+	DC_ITEM		*items;
+	AGENT_RESULT	*results;
+	int		*errcodes;
+	/* the number of items not reported to poller yet */
+	int		pending;
+	/* 1 if the arrays were allocated by asynchronous poller and must be freed after all items are reported */
+	unsigned char	allocated;
+}
+zbx_agent_batch_t;
+
+typedef struct zbx_agent_poll zbx_agent_poll_t;
+
+/* passive agent check connection, used by asynchronous poller */
+typedef struct
+{
+	DC_ITEM			*item;
+	AGENT_RESULT		*result;
+	zbx_agent_batch_t	*batch;
+	zbx_agent_poll_t	*poll;
+
+	struct event		*event;
+#ifdef ZBX_AGENT_ASYNC_DNS
+	struct evdns_getaddrinfo_request	*dns_request;
+#endif
+	ZBX_SOCKET		socket;
+	unsigned char		state;
+	double			deadline;
+	/* copy of item interface identifier, available after the item is reported */
+	zbx_uint64_t		interfaceid;
+
+	/* request data when sending, response data when receiving */
+	char			*buffer;
+	size_t			buffer_alloc;
+	size_t			buffer_offset;
+	/* size of request or expected size of response, 0 if response header is not received yet */
+	size_t			buffer_len;
+	zbx_tcp_header_t	header;
+}
+zbx_agent_conn_t;
+
+/* asynchronous passive agent checks */
+struct zbx_agent_poll
+{
+	struct event_base	*base;
+#ifdef ZBX_AGENT_ASYNC_DNS
+	struct evdns_base	*dnsbase;
+#endif
+	zbx_agent_conn_t	*conns;
+	int			conns_max;
+	/* the number of connections in use, including connections waiting for interface */
+	int			conns_num;
+
+	zbx_agent_value_func_t	value_cb;
+	void			*cb_data;
+};
+
+/* event and DNS bases are kept between polls, so resolver configuration is read only once */
+static struct event_base	*agent_base = NULL;
+#ifdef ZBX_AGENT_ASYNC_DNS
+static struct evdns_base	*agent_dnsbase = NULL;
+#endif
+static unsigned char		agent_base_initialized = 0;
+
+#if !defined(LIBEVENT_VERSION_NUMBER) || LIBEVENT_VERSION_NUMBER < 0x2000000
+typedef int evutil_socket_t;
+
+static struct event	*event_new(struct event_base *ev, evutil_socket_t fd, short what,
+		void(*cb_func)(int, short, void *), void *cb_arg)
+{
+	struct event	*event;
+
+	event = zbx_malloc(NULL, sizeof(struct event));
+	event_set(event, fd, what, cb_func, cb_arg);
+	event_base_set(ev, event);
+
+	return event;
+}
+
+static void	event_free(struct event *event)
+{
+	event_del(event);
+	zbx_free(event);
+}
+
+#endif
+
+static void	agent_conn_event_cb(evutil_socket_t fd, short what, void *arg);
+static void	agent_conn_run(zbx_agent_conn_t *conn);
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_process_response                                           *
+ *                                                                            *
+ * Purpose: convert agent response into item result                           *
+ *                                                                            *
+ * Parameters: item         - [IN] the item                                   *
+ *             buffer       - [IN] the response data                          *
+ *             read_bytes   - [IN] the response data size                     *
+ *             received_len - [IN] the number of bytes received, including    *
+ *                                 protocol header                            *
+ *             result       - [OUT] the item result                           *
+ *                                                                            *
+ * Return value: SUCCEED - value was retrieved and stored in result           *
+ *               NETWORK_ERROR - agent dropped connection without response    *
+ *               NOTSUPPORTED - item not supported by the agent               *
+ *               AGENT_ERROR - uncritical error on agent side occurred        *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_process_response(const DC_ITEM *item, char *buffer, size_t read_bytes,
+		ssize_t received_len, AGENT_RESULT *result)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "get value from agent result: '%s'", buffer);
+
+	if (0 == strcmp(buffer, ZBX_NOTSUPPORTED))
+	{
+		/* 'ZBX_NOTSUPPORTED\0<error message>' */
+		if (sizeof(ZBX_NOTSUPPORTED) < read_bytes)
+			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s", buffer + sizeof(ZBX_NOTSUPPORTED)));
+		else
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+
+		return NOTSUPPORTED;
+	}
+
+	if (0 == strcmp(buffer, ZBX_ERROR))
+	{
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Zabbix Agent non-critical error"));
+		return AGENT_ERROR;
+	}
+
+	if (0 == received_len)
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
+				" Assuming that agent dropped connection because of access permissions.",
+				item->interface.addr));
+		return NETWORK_ERROR;
+	}
+
+	set_result_type(result, ITEM_VALUE_TYPE_TEXT, buffer);
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: get_value_agent                                                  *
@@ -107,40 +286,996 @@ int	get_value_agent(const DC_ITEM *item, AGENT_RESULT *result)
 		ret = NETWORK_ERROR;
 
 	if (SUCCEED == ret)
+		ret = agent_process_response(item, s.buffer, s.read_bytes, received_len, result);
+	else
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror()));
+
+	zbx_tcp_close(&s);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_conn_release                                               *
+ *                                                                            *
+ * Purpose: make agent connection available for the next item                 *
+ *                                                                            *
+ * Parameters: conn - [IN] the agent connection                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_conn_release(zbx_agent_conn_t *conn)
+{
+	conn->state = ZBX_AGENT_STATE_IDLE;
+	conn->poll->conns_num--;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_poll_interface_conns                                       *
+ *                                                                            *
+ * Purpose: count connections to the specified interface                      *
+ *                                                                            *
+ * Parameters: poll        - [IN] the asynchronous agent checks               *
+ *             interfaceid - [IN] the interface identifier                    *
+ *                                                                            *
+ * Return value: the number of connections being resolved, established or     *
+ *               used for the check                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_poll_interface_conns(const zbx_agent_poll_t *poll, zbx_uint64_t interfaceid)
+{
+	int	i, num = 0;
+
+	for (i = 0; i < poll->conns_max; i++)
+	{
+		const zbx_agent_conn_t	*conn = &poll->conns[i];
+
+		if (interfaceid != conn->interfaceid)
+			continue;
+
+		switch (conn->state)
+		{
+			case ZBX_AGENT_STATE_RESOLVE:
+			case ZBX_AGENT_STATE_CONNECT:
+			case ZBX_AGENT_STATE_SEND:
+			case ZBX_AGENT_STATE_RECV:
+				num++;
+		}
+	}
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_poll_resume                                                *
+ *                                                                            *
+ * Purpose: start the next check waiting for the specified interface          *
+ *                                                                            *
+ * Parameters: poll        - [IN] the asynchronous agent checks               *
+ *             interfaceid - [IN] the interface identifier                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_poll_resume(zbx_agent_poll_t *poll, zbx_uint64_t interfaceid)
+{
+	int	i;
+
+	for (i = 0; i < poll->conns_max; i++)
+	{
+		zbx_agent_conn_t	*conn = &poll->conns[i];
+
+		if (ZBX_AGENT_STATE_WAIT == conn->state && interfaceid == conn->interfaceid)
+		{
+			agent_conn_run(conn);
+			return;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_conn_finish                                                *
+ *                                                                            *
+ * Purpose: close agent connection and report the check result to poller      *
+ *                                                                            *
+ * Parameters: conn  - [IN] the agent connection                              *
+ *             ret   - [IN] the check result code                             *
+ *             error - [IN] the error message, can be NULL. The message is    *
+ *                          freed by this function.                           *
+ *                                                                            *
+ * Comments: The item and its result must not be accessed after this call,    *
+ *           they can be freed by the poller callback.                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_conn_finish(zbx_agent_conn_t *conn, int ret, char *error)
+{
+	zbx_agent_batch_t	*batch = conn->batch;
+	unsigned char		active = (ZBX_AGENT_STATE_WAIT != conn->state);
+
+	if (NULL != error)
+	{
+		SET_MSG_RESULT(conn->result, zbx_dsprintf(NULL, "Get value from agent failed: %s", error));
+		zbx_free(error);
+	}
+
+	if (NULL != conn->event)
+	{
+		event_free(conn->event);
+		conn->event = NULL;
+	}
+
+	if (ZBX_SOCKET_ERROR != conn->socket)
+	{
+		zbx_socket_close(conn->socket);
+		conn->socket = ZBX_SOCKET_ERROR;
+	}
+
+	zbx_free(conn->buffer);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() host:'%s' key:'%s' result:%s", __func__, conn->item->host.host,
+			conn->item->key, zbx_result_string(ret));
+
+	conn->poll->value_cb(conn->item, conn->result, ret, conn->poll->cb_data);
+
+	if (0 == --batch->pending && 0 != batch->allocated)
+	{
+		zbx_free(batch->items);
+		zbx_free(batch->results);
+		zbx_free(batch->errcodes);
+		zbx_free(batch);
+	}
+
+#ifdef ZBX_AGENT_ASYNC_DNS
+	/* the connection is released by callback of the cancelled name resolution */
+	if (NULL != conn->dns_request)
+		conn->state = ZBX_AGENT_STATE_CANCEL;
+	else
+#endif
+		agent_conn_release(conn);
+
+	if (0 != active)
+		agent_poll_resume(conn->poll, conn->interfaceid);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_conn_wait                                                  *
+ *                                                                            *
+ * Purpose: wait until agent connection socket is ready for the specified     *
+ *          operation or the check times out                                  *
+ *                                                                            *
+ * Parameters: conn - [IN] the agent connection                               *
+ *             what - [IN] EV_READ, EV_WRITE or 0 to wait for timeout only    *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_conn_wait(zbx_agent_conn_t *conn, short what)
+{
+	struct timeval	tv;
+	double		timeout;
+
+	if (NULL != conn->event)
+		event_free(conn->event);
+
+	conn->event = event_new(conn->poll->base, conn->socket, what, agent_conn_event_cb, (void *)conn);
+
+	if (0.0 > (timeout = conn->deadline - zbx_time()))
+		timeout = 0.0;
+
+	tv.tv_sec = (time_t)timeout;
+	tv.tv_usec = (suseconds_t)((timeout - (double)tv.tv_sec) * 1000000.0);
+
+	event_add(conn->event, &tv);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_conn_connect                                               *
+ *                                                                            *
+ * Purpose: start nonblocking connection to agent                             *
+ *                                                                            *
+ * Parameters: conn  - [IN] the agent connection                              *
+ *             ai    - [IN] the agent address                                 *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the connection is being established                *
+ *               FAIL    - an error occurred                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_conn_connect(zbx_agent_conn_t *conn, const struct addrinfo *ai, char **error)
+{
+	struct addrinfo	hints, *ai_bind = NULL;
+	int		flags, ret = FAIL;
+	const char	*ip = conn->item->interface.addr;
+	unsigned short	port = conn->item->interface.port;
+
+	if (ZBX_SOCKET_ERROR == (conn->socket = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC,
+			ai->ai_protocol)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot create socket [[%s]:%hu]: %s", ip, port,
+				strerror_from_system(zbx_socket_last_error()));
+		goto out;
+	}
+
+#if !SOCK_CLOEXEC
+	if (-1 == fcntl(conn->socket, F_SETFD, FD_CLOEXEC))
 	{
-		zabbix_log(LOG_LEVEL_DEBUG, "get value from agent result: '%s'", s.buffer);
+		zabbix_log(LOG_LEVEL_DEBUG, "failed to set the FD_CLOEXEC file descriptor flag on socket"
+				" [[%s]:%hu]: %s", ip, port, strerror_from_system(zbx_socket_last_error()));
+	}
+#endif
+	if (-1 == (flags = fcntl(conn->socket, F_GETFL, 0)) ||
+			-1 == fcntl(conn->socket, F_SETFL, flags | O_NONBLOCK))
+	{
+		*error = zbx_dsprintf(NULL, "cannot set nonblocking mode on socket [[%s]:%hu]: %s", ip, port,
+				strerror_from_system(zbx_socket_last_error()));
+		goto out;
+	}
 
-		if (0 == strcmp(s.buffer, ZBX_NOTSUPPORTED))
+	if (NULL != CONFIG_SOURCE_IP)
+	{
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = ai->ai_family;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = AI_NUMERICHOST;
+
+		if (0 != getaddrinfo(CONFIG_SOURCE_IP, NULL, &hints, &ai_bind))
 		{
-			/* 'ZBX_NOTSUPPORTED\0<error message>' */
-			if (sizeof(ZBX_NOTSUPPORTED) < s.read_bytes)
-				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s", s.buffer + sizeof(ZBX_NOTSUPPORTED)));
+			*error = zbx_dsprintf(NULL, "invalid source IP address [%s]", CONFIG_SOURCE_IP);
+			goto out;
+		}
+
+		if (ZBX_PROTO_ERROR == zbx_bind(conn->socket, ai_bind->ai_addr, ai_bind->ai_addrlen))
+		{
+			*error = zbx_dsprintf(NULL, "bind() failed: %s", strerror_from_system(zbx_socket_last_error()));
+			goto out;
+		}
+	}
+
+	if (ZBX_PROTO_ERROR == connect(conn->socket, ai->ai_addr, (socklen_t)ai->ai_addrlen) &&
+			EINPROGRESS != zbx_socket_last_error())
+	{
+		*error = zbx_dsprintf(NULL, "cannot connect to [[%s]:%hu]: %s", ip, port,
+				strerror_from_system(zbx_socket_last_error()));
+		goto out;
+	}
+
+	ret = SUCCEED;
+out:
+	if (NULL != ai_bind)
+		freeaddrinfo(ai_bind);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_conn_start                                                 *
+ *                                                                            *
+ * Purpose: connect to the resolved agent address and wait until connected    *
+ *                                                                            *
+ * Parameters: conn - [IN] the agent connection                               *
+ *             ai   - [IN] the agent address                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_conn_start(zbx_agent_conn_t *conn, const struct addrinfo *ai)
+{
+	char	*error = NULL;
+
+	if (SUCCEED != agent_conn_connect(conn, ai, &error))
+	{
+		agent_conn_finish(conn, NETWORK_ERROR, error);
+		return;
+	}
+
+	conn->state = ZBX_AGENT_STATE_CONNECT;
+	agent_conn_wait(conn, EV_WRITE);
+}
+
+#ifdef ZBX_AGENT_ASYNC_DNS
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_conn_resolve_cb                                            *
+ *                                                                            *
+ * Purpose: connect to agent when its name has been resolved                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_conn_resolve_cb(int result, struct evutil_addrinfo *ai, void *arg)
+{
+	zbx_agent_conn_t	*conn = (zbx_agent_conn_t *)arg;
+
+	conn->dns_request = NULL;
+
+	if (ZBX_AGENT_STATE_CANCEL == conn->state)
+	{
+		agent_conn_release(conn);
+	}
+	else if (0 != result)
+	{
+		agent_conn_finish(conn, NETWORK_ERROR, zbx_dsprintf(NULL, "cannot resolve [%s]: %s",
+				conn->item->interface.addr, evutil_gai_strerror(result)));
+	}
+	else
+		agent_conn_start(conn, ai);
+
+	if (NULL != ai)
+		evutil_freeaddrinfo(ai);
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_conn_resolve                                               *
+ *                                                                            *
+ * Purpose: resolve agent address and connect to it                           *
+ *                                                                            *
+ * Parameters: conn - [IN] the agent connection                               *
+ *                                                                            *
+ * Comments: IP addresses are converted without name resolution. Names are    *
+ *           resolved asynchronously when DNS base is available, otherwise    *
+ *           blocking getaddrinfo() is used.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_conn_resolve(zbx_agent_conn_t *conn)
+{
+	struct addrinfo	hints, *ai = NULL;
+	char		service[8];
+	const char	*addr = conn->item->interface.addr;
+
+	zbx_snprintf(service, sizeof(service), "%hu", conn->item->interface.port);
+	memset(&hints, 0, sizeof(hints));
+#ifdef HAVE_IPV6
+	hints.ai_family = PF_UNSPEC;
+#else
+	hints.ai_family = AF_INET;
+#endif
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_NUMERICHOST;
+
+	if (0 == getaddrinfo(addr, service, &hints, &ai))
+	{
+		agent_conn_start(conn, ai);
+		freeaddrinfo(ai);
+		return;
+	}
+
+	hints.ai_flags = 0;
+
+#ifdef ZBX_AGENT_ASYNC_DNS
+	if (NULL != conn->poll->dnsbase)
+	{
+		struct evdns_getaddrinfo_request	*request;
+
+		conn->state = ZBX_AGENT_STATE_RESOLVE;
+
+		/* the callback is called before returning when the name is resolved without DNS query */
+		request = evdns_getaddrinfo(conn->poll->dnsbase, addr, service, &hints, agent_conn_resolve_cb,
+				(void *)conn);
+
+		if (NULL != request && ZBX_AGENT_STATE_RESOLVE == conn->state)
+		{
+			conn->dns_request = request;
+			agent_conn_wait(conn, 0);
+		}
+
+		return;
+	}
+#endif
+	if (0 != getaddrinfo(addr, service, &hints, &ai))
+	{
+		agent_conn_finish(conn, NETWORK_ERROR, zbx_dsprintf(NULL, "cannot resolve [%s]", addr));
+		return;
+	}
+
+	agent_conn_start(conn, ai);
+	freeaddrinfo(ai);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_conn_prepare_request                                       *
+ *                                                                            *
+ * Purpose: prepare Zabbix protocol request with the item key                 *
+ *                                                                            *
+ * Parameters: conn - [IN] the agent connection                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_conn_prepare_request(zbx_agent_conn_t *conn)
+{
+	size_t	key_len;
+
+	key_len = strlen(conn->item->key);
+
+	conn->buffer_alloc = ZBX_TCP_HEADER_SIZE_MAX + key_len;
+	conn->buffer = (char *)zbx_malloc(NULL, conn->buffer_alloc);
+	conn->buffer_len = zbx_tcp_header_write(conn->buffer, ZBX_TCP_PROTOCOL, key_len, 0);
+
+	memcpy(conn->buffer + conn->buffer_len, conn->item->key, key_len);
+	conn->buffer_len += key_len;
+	conn->buffer_offset = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_conn_send                                                  *
+ *                                                                            *
+ * Purpose: send as much of the request as the socket accepts                 *
+ *                                                                            *
+ * Parameters: conn  - [IN] the agent connection                              *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the request was sent                               *
+ *               FAIL    - an error occurred                                  *
+ *               ZBX_AGENT_AGAIN - the socket buffer is full, wait until the  *
+ *                                 socket becomes writable                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_conn_send(zbx_agent_conn_t *conn, char **error)
+{
+	ssize_t	n;
+
+	while (conn->buffer_offset < conn->buffer_len)
+	{
+		if (ZBX_PROTO_ERROR == (n = ZBX_TCP_WRITE(conn->socket, conn->buffer + conn->buffer_offset,
+				conn->buffer_len - conn->buffer_offset)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			if (EAGAIN == errno || EWOULDBLOCK == errno)
+				return ZBX_AGENT_AGAIN;
+
+			*error = zbx_dsprintf(NULL, "ZBX_TCP_WRITE() failed: %s", strerror_from_system(errno));
+			return FAIL;
+		}
+
+		conn->buffer_offset += (size_t)n;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_conn_recv                                                  *
+ *                                                                            *
+ * Purpose: read available response data                                      *
+ *                                                                            *
+ * Parameters: conn  - [IN] the agent connection                              *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the whole response was received or the agent       *
+ *                         closed connection                                  *
+ *               FAIL    - an error occurred                                  *
+ *               ZBX_AGENT_AGAIN - wait until more data is available          *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_conn_recv(zbx_agent_conn_t *conn, char **error)
+{
+	ssize_t	n;
+
+	while (0 == conn->buffer_len || conn->buffer_offset < conn->buffer_len)
+	{
+		if (conn->buffer_alloc - conn->buffer_offset < ZBX_STAT_BUF_LEN)
+		{
+			if (0 != conn->buffer_len)
+				conn->buffer_alloc = conn->buffer_len + 1;
+			else
+				conn->buffer_alloc = conn->buffer_offset + ZBX_STAT_BUF_LEN;
+
+			conn->buffer = (char *)zbx_realloc(conn->buffer, conn->buffer_alloc);
+		}
+
+		if (ZBX_PROTO_ERROR == (n = ZBX_TCP_READ(conn->socket, conn->buffer + conn->buffer_offset,
+				conn->buffer_alloc - conn->buffer_offset - 1)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			if (EAGAIN == errno || EWOULDBLOCK == errno)
+				return ZBX_AGENT_AGAIN;
+
+			*error = zbx_dsprintf(NULL, "ZBX_TCP_READ() failed: %s", strerror_from_system(errno));
+			return FAIL;
+		}
+
+		if (0 == n)
+			break;
+
+		conn->buffer_offset += (size_t)n;
+
+		if (0 != conn->buffer_len)
+			continue;
+
+		if (SUCCEED != zbx_tcp_header_read(conn->buffer, conn->buffer_offset, 0, &conn->header))
+		{
+			if (ZBX_TCP_EXPECT_VERSION_VALIDATE == conn->header.expect)
+			{
+				*error = zbx_dsprintf(NULL, "message from %s is using unsupported protocol version"
+						" \"%d\"", conn->item->interface.addr, (int)conn->header.protocol);
+			}
 			else
-				SET_MSG_RESULT(result, zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+				*error = zbx_dsprintf(NULL, "message from %s is missing header", conn->item->interface.addr);
 
-			ret = NOTSUPPORTED;
+			return FAIL;
 		}
-		else if (0 == strcmp(s.buffer, ZBX_ERROR))
+
+		if (ZBX_TCP_EXPECT_SIZE != conn->header.expect)
+			continue;
+
+		if (ZBX_MAX_RECV_DATA_SIZE < conn->header.len || ZBX_MAX_RECV_DATA_SIZE < conn->header.reserved)
 		{
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Zabbix Agent non-critical error"));
-			ret = AGENT_ERROR;
+			*error = zbx_dsprintf(NULL, "message size " ZBX_FS_UI64 " from %s exceeds the maximum size "
+					ZBX_FS_UI64 " bytes", MAX(conn->header.len, conn->header.reserved),
+					conn->item->interface.addr, (zbx_uint64_t)ZBX_MAX_RECV_DATA_SIZE);
+			return FAIL;
 		}
-		else if (0 == received_len)
+
+		conn->buffer_len = conn->header.size + (size_t)conn->header.len;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_conn_process_response                                      *
+ *                                                                            *
+ * Purpose: validate received response and convert it into item result        *
+ *                                                                            *
+ * Parameters: conn - [IN] the agent connection                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_conn_process_response(zbx_agent_conn_t *conn)
+{
+	char	*data, *out = NULL, *error = NULL;
+	size_t	data_len;
+	int	ret;
+
+	if (0 == conn->buffer_offset)
+	{
+		*conn->buffer = '\0';
+		ret = agent_process_response(conn->item, conn->buffer, 0, 0, conn->result);
+		goto out;
+	}
+
+	if (0 == conn->buffer_len)
+	{
+		const char	*part;
+
+		if (ZBX_TCP_EXPECT_HEADER == conn->header.expect)
+			part = "header";
+		else if (ZBX_TCP_EXPECT_VERSION == conn->header.expect)
+			part = "protocol version";
+		else
+			part = "data length";
+
+		error = zbx_dsprintf(NULL, "message from %s is missing %s", conn->item->interface.addr, part);
+		ret = NETWORK_ERROR;
+		goto out;
+	}
+
+	if (conn->buffer_offset != conn->buffer_len)
+	{
+		error = zbx_dsprintf(NULL, "message from %s is %s than expected " ZBX_FS_SIZE_T " bytes",
+				conn->item->interface.addr, conn->buffer_offset < conn->buffer_len ? "shorter" :
+				"longer", (zbx_fs_size_t)conn->header.len);
+		ret = NETWORK_ERROR;
+		goto out;
+	}
+
+	data = conn->buffer + conn->header.size;
+	data_len = conn->buffer_len - conn->header.size;
+
+	if (0 != (conn->header.protocol & ZBX_TCP_COMPRESS))
+	{
+		size_t	out_size = (size_t)conn->header.reserved;
+
+		out = (char *)zbx_malloc(NULL, out_size + 1);
+
+		if (FAIL == zbx_uncompress(data, data_len, out, &out_size))
 		{
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
-					" Assuming that agent dropped connection because of access permissions.",
-					item->interface.addr));
+			error = zbx_dsprintf(NULL, "cannot uncompress data: %s", zbx_compress_strerror());
 			ret = NETWORK_ERROR;
+			goto out;
 		}
-		else
-			set_result_type(result, ITEM_VALUE_TYPE_TEXT, s.buffer);
+
+		data = out;
+		data_len = out_size;
 	}
-	else
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror()));
 
-	zbx_tcp_close(&s);
+	data[data_len] = '\0';
+	ret = agent_process_response(conn->item, data, data_len, (ssize_t)conn->buffer_offset, conn->result);
 out:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+	zbx_free(out);
+	agent_conn_finish(conn, ret, error);
+}
 
-	return ret;
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_conn_event_cb                                              *
+ *                                                                            *
+ * Purpose: advance agent connection state when its socket is ready or the    *
+ *          check has timed out                                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_conn_event_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_agent_conn_t	*conn = (zbx_agent_conn_t *)arg;
+	char			*error = NULL;
+	int			ret, socket_error = 0;
+	socklen_t		socket_error_len = sizeof(socket_error);
+
+	ZBX_UNUSED(fd);
+
+	switch (conn->state)
+	{
+#ifdef ZBX_AGENT_ASYNC_DNS
+		case ZBX_AGENT_STATE_RESOLVE:
+		{
+			struct evdns_getaddrinfo_request	*request = conn->dns_request;
+
+			/* only timeout is expected, resolved name is handled by agent_conn_resolve_cb() */
+			error = zbx_dsprintf(NULL, "cannot resolve [%s]: timed out", conn->item->interface.addr);
+			agent_conn_finish(conn, NETWORK_ERROR, error);
+
+			/* the cancelled request callback releases the connection */
+			evdns_getaddrinfo_cancel(request);
+			return;
+		}
+#endif
+		case ZBX_AGENT_STATE_CONNECT:
+			if (0 != (what & EV_TIMEOUT))
+			{
+				error = zbx_dsprintf(NULL, "cannot connect to [[%s]:%hu]: connection timed out",
+						conn->item->interface.addr, conn->item->interface.port);
+				agent_conn_finish(conn, NETWORK_ERROR, error);
+				return;
+			}
+
+			if (ZBX_PROTO_ERROR == getsockopt(conn->socket, SOL_SOCKET, SO_ERROR, &socket_error,
+					&socket_error_len))
+			{
+				socket_error = zbx_socket_last_error();
+			}
+
+			if (0 != socket_error)
+			{
+				error = zbx_dsprintf(NULL, "cannot connect to [[%s]:%hu]: %s",
+						conn->item->interface.addr, conn->item->interface.port,
+						zbx_strerror(socket_error));
+				agent_conn_finish(conn, NETWORK_ERROR, error);
+				return;
+			}
+
+			zabbix_log(LOG_LEVEL_DEBUG, "Sending [%s]", conn->item->key);
+
+			agent_conn_prepare_request(conn);
+			conn->state = ZBX_AGENT_STATE_SEND;
+			ZBX_FALLTHROUGH;
+		case ZBX_AGENT_STATE_SEND:
+			if (0 != (what & EV_TIMEOUT))
+			{
+				agent_conn_finish(conn, NETWORK_ERROR, zbx_strdup(NULL, "ZBX_TCP_WRITE() timed out"));
+				return;
+			}
+
+			if (ZBX_AGENT_AGAIN == (ret = agent_conn_send(conn, &error)))
+			{
+				agent_conn_wait(conn, EV_WRITE);
+				return;
+			}
+
+			if (SUCCEED != ret)
+			{
+				agent_conn_finish(conn, NETWORK_ERROR, error);
+				return;
+			}
+
+			conn->state = ZBX_AGENT_STATE_RECV;
+			conn->buffer_offset = 0;
+			conn->buffer_len = 0;
+			agent_conn_wait(conn, EV_READ);
+			return;
+		case ZBX_AGENT_STATE_RECV:
+			if (0 != (what & EV_TIMEOUT))
+			{
+				agent_conn_finish(conn, TIMEOUT_ERROR, zbx_strdup(NULL, "ZBX_TCP_READ() timed out"));
+				return;
+			}
+
+			if (ZBX_AGENT_AGAIN == (ret = agent_conn_recv(conn, &error)))
+			{
+				agent_conn_wait(conn, EV_READ);
+				return;
+			}
+
+			if (SUCCEED != ret)
+			{
+				agent_conn_finish(conn, NETWORK_ERROR, error);
+				return;
+			}
+
+			agent_conn_process_response(conn);
+			return;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			agent_conn_finish(conn, NETWORK_ERROR, zbx_strdup(NULL, "invalid connection state"));
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_conn_run                                                   *
+ *                                                                            *
+ * Purpose: start checking item with unencrypted connection                   *
+ *                                                                            *
+ * Parameters: conn - [IN] the agent connection                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_conn_run(zbx_agent_conn_t *conn)
+{
+	conn->state = ZBX_AGENT_STATE_CONNECT;
+	conn->deadline = zbx_time() + CONFIG_TIMEOUT;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() host:'%s' addr:'%s' key:'%s'", __func__, conn->item->host.host,
+			conn->item->interface.addr, conn->item->key);
+
+	agent_conn_resolve(conn);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_conn_begin                                                 *
+ *                                                                            *
+ * Purpose: start checking batch item using a free agent connection           *
+ *                                                                            *
+ * Parameters: poll  - [IN] the asynchronous agent checks                     *
+ *             batch - [IN] the item batch                                    *
+ *             index - [IN] the item index in batch                           *
+ *                                                                            *
+ * Comments: Items with error code already set are reported without check.    *
+ *           Items using TLS connections are retrieved synchronously with     *
+ *           get_value_agent(). When ZBX_AGENT_INTERFACE_CONNS_MAX            *
+ *           connections to the item interface are already open, the check   *
+ *           waits until one of them is finished.                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_conn_begin(zbx_agent_poll_t *poll, zbx_agent_batch_t *batch, int index)
+{
+	zbx_agent_conn_t	*conn;
+	int			ret;
+
+	for (conn = poll->conns; ZBX_AGENT_STATE_IDLE != conn->state; conn++)
+		;
+
+	memset(conn, 0, sizeof(zbx_agent_conn_t));
+	conn->item = &batch->items[index];
+	conn->result = &batch->results[index];
+	conn->batch = batch;
+	conn->poll = poll;
+	conn->socket = ZBX_SOCKET_ERROR;
+	conn->state = ZBX_AGENT_STATE_WAIT;
+	conn->interfaceid = conn->item->interface.interfaceid;
+	poll->conns_num++;
+
+	if (SUCCEED != batch->errcodes[index])
+	{
+		agent_conn_finish(conn, batch->errcodes[index], NULL);
+		return;
+	}
+
+	if (NULL == poll->base || ZBX_TCP_SEC_UNENCRYPTED != conn->item->host.tls_connect)
+	{
+		zbx_alarm_on(CONFIG_TIMEOUT);
+		ret = get_value_agent(conn->item, conn->result);
+		zbx_alarm_off();
+
+		agent_conn_finish(conn, ret, NULL);
+		return;
+	}
+
+	if (ZBX_AGENT_INTERFACE_CONNS_MAX > agent_poll_interface_conns(poll, conn->interfaceid))
+		agent_conn_run(conn);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_poll_refill                                                *
+ *                                                                            *
+ * Purpose: request more items from poller and start checking them            *
+ *                                                                            *
+ * Parameters: poll      - [IN] the asynchronous agent checks                 *
+ *             items_cb  - [IN] the callback returning due items              *
+ *             max_items - [IN] the maximum number of items to request        *
+ *             cb_data   - [IN] the callback data                             *
+ *                                                                            *
+ * Return value: the number of items returned by poller                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_poll_refill(zbx_agent_poll_t *poll, zbx_agent_items_func_t items_cb, int max_items,
+		void *cb_data)
+{
+	zbx_agent_batch_t	*batch;
+	int			i, num;
+
+	batch = (zbx_agent_batch_t *)zbx_malloc(NULL, sizeof(zbx_agent_batch_t));
+	batch->items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * (size_t)max_items);
+	batch->results = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT) * (size_t)max_items);
+	batch->errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)max_items);
+	batch->allocated = 1;
+
+	if (0 == (num = items_cb(batch->items, batch->results, batch->errcodes, max_items, cb_data)))
+	{
+		zbx_free(batch->items);
+		zbx_free(batch->results);
+		zbx_free(batch->errcodes);
+		zbx_free(batch);
+
+		return 0;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() num:%d", __func__, num);
+
+	/* the batch is freed when its last item is reported */
+	batch->pending = num;
+
+	for (i = 0; i < num; i++)
+		agent_conn_begin(poll, batch, i);
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_poll_timer_cb                                              *
+ *                                                                            *
+ * Purpose: wake up event loop to request more items from poller              *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_poll_timer_cb(evutil_socket_t fd, short what, void *arg)
+{
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+	ZBX_UNUSED(arg);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_poll_init                                                  *
+ *                                                                            *
+ * Purpose: create event and DNS bases on the first asynchronous poll         *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_poll_init(void)
+{
+	if (0 != agent_base_initialized)
+		return;
+
+	agent_base_initialized = 1;
+
+	if (NULL == (agent_base = event_base_new()))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot initialize event base, checking agent items one at a time");
+		return;
+	}
+
+#ifdef ZBX_AGENT_ASYNC_DNS
+#	ifdef EVDNS_BASE_DISABLE_WHEN_INACTIVE
+	agent_dnsbase = evdns_base_new(agent_base, EVDNS_BASE_INITIALIZE_NAMESERVERS |
+			EVDNS_BASE_DISABLE_WHEN_INACTIVE);
+#	else
+	agent_dnsbase = evdns_base_new(agent_base, EVDNS_BASE_INITIALIZE_NAMESERVERS);
+#	endif
+	if (NULL == agent_dnsbase)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot initialize asynchronous DNS resolver, agent names will be"
+				" resolved one at a time");
+	}
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_values_agent                                                 *
+ *                                                                            *
+ * Purpose: retrieve values of multiple passive agent items concurrently      *
+ *                                                                            *
+ * Parameters: items    - [IN] the items to check                             *
+ *             results  - [OUT] the item results                              *
+ *             errcodes - [IN] the item error codes. Only items with SUCCEED  *
+ *                             error code are checked.                        *
+ *             num      - [IN] the number of items                            *
+ *             value_cb - [IN] the callback called with each item result as   *
+ *                             soon as its check finishes                     *
+ *             items_cb - [IN] the callback returning more due items to fill  *
+ *                             free connections, can be NULL                  *
+ *             cb_data  - [IN] the callback data                              *
+ *                                                                            *
+ * Comments: Unencrypted connections are multiplexed with libevent, each of   *
+ *           them being limited by Timeout configuration parameter. Agent     *
+ *           names are resolved asynchronously when libevent provides DNS     *
+ *           resolver. While checks are running and at least                  *
+ *           ZBX_AGENT_REFILL_MIN connections are free, more items are        *
+ *           requested with items_cb for up to Timeout seconds, so a slow     *
+ *           agent does not hold back checks of other items. At most          *
+ *           ZBX_AGENT_INTERFACE_CONNS_MAX connections are open to the same   *
+ *           interface at a time. Items using TLS connections are retrieved   *
+ *           one at a time with get_value_agent().                            *
+ *                                                                            *
+ ******************************************************************************/
+void	get_values_agent(DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num,
+		zbx_agent_value_func_t value_cb, zbx_agent_items_func_t items_cb, void *cb_data)
+{
+	zbx_agent_poll_t	poll;
+	zbx_agent_batch_t	batch;
+	struct event		*timer;
+	struct timeval		tv;
+	double			now, refill_next, refill_end;
+	int			i, free_num;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __func__, num);
+
+	agent_poll_init();
+
+	memset(&poll, 0, sizeof(poll));
+	poll.base = agent_base;
+#ifdef ZBX_AGENT_ASYNC_DNS
+	poll.dnsbase = agent_dnsbase;
+#endif
+	poll.value_cb = value_cb;
+	poll.cb_data = cb_data;
+
+	poll.conns_max = MAX(num, MAX_AGENT_ITEMS);
+	poll.conns = (zbx_agent_conn_t *)zbx_calloc(NULL, (size_t)poll.conns_max, sizeof(zbx_agent_conn_t));
+
+	batch.items = items;
+	batch.results = results;
+	batch.errcodes = errcodes;
+	batch.pending = num;
+	batch.allocated = 0;
+
+	for (i = 0; i < num; i++)
+		agent_conn_begin(&poll, &batch, i);
+
+	if (NULL != poll.base)
+	{
+		timer = event_new(poll.base, -1, 0, agent_poll_timer_cb, NULL);
+		refill_next = zbx_time();
+		refill_end = refill_next + CONFIG_TIMEOUT;
+
+		while (1)
+		{
+			if (NULL != items_cb && ZBX_AGENT_REFILL_MIN <= (free_num = poll.conns_max - poll.conns_num) &&
+					(now = zbx_time()) < refill_end)
+			{
+				/* when poller has no more due items, check again after the next second */
+				if (now >= refill_next && free_num > agent_poll_refill(&poll, items_cb, free_num,
+						cb_data))
+				{
+					refill_next = floor(now) + 1;
+				}
+
+				if (refill_next > now)
+				{
+					tv.tv_sec = (time_t)(refill_next - now);
+					tv.tv_usec = (suseconds_t)((refill_next - now - (double)tv.tv_sec) * 1000000.0);
+					event_add(timer, &tv);
+				}
+			}
+
+			if (0 == poll.conns_num)
+				break;
+
+			event_base_loop(poll.base, EVLOOP_ONCE);
+		}
+
+		event_free(timer);
+	}
+
+	zbx_free(poll.conns);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -25,6 +25,14 @@
 
 extern char	*CONFIG_SOURCE_IP;
 
+/* called with the item result as soon as the check finishes */
+typedef void	(*zbx_agent_value_func_t)(DC_ITEM *item, AGENT_RESULT *result, int errcode, void *data);
+/* returns the number of due items, prepared for checking, to fill free agent connections */
+typedef int	(*zbx_agent_items_func_t)(DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int max_items,
+		void *data);
+
 int	get_value_agent(const DC_ITEM *item, AGENT_RESULT *result);
+void	get_values_agent(DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num,
+		zbx_agent_value_func_t value_cb, zbx_agent_items_func_t items_cb, void *cb_data);
 
 #endif
@@ -177,6 +177,8 @@ int	zbx_get_value_internal_ext(const char *param1, const AGENT_REQUEST *request,
 				SET_UI64_RESULT(result, stats.misses);
 			else if (0 == strcmp(param3, "mode"))
 				SET_UI64_RESULT(result, stats.mode);
+			else if (0 == strcmp(param3, "compression_ratio"))
+				SET_DBL_RESULT(result, stats.compression_ratio);
 			else
 			{
 				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
@@ -782,6 +782,238 @@ void	zbx_clean_items(DC_ITEM *items, int num, AGENT_RESULT *results)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: process_item_value                                               *
+ *                                                                            *
+ * Purpose: update interface availability and pass the check result to        *
+ *          preprocessing                                                     *
+ *                                                                            *
+ * Parameters: item           - [IN] the checked item                         *
+ *             result         - [IN] the check result                         *
+ *             errcode        - [IN] the check result code                    *
+ *             timespec       - [IN] the check timestamp                      *
+ *             add_results    - [IN] the additional results of the check      *
+ *             last_available - [IN/OUT] the interface availability set by    *
+ *                                       the previous item of the same        *
+ *                                       interface                            *
+ *             data           - [IN/OUT] the availability data                *
+ *             data_alloc     - [IN/OUT] the availability data size           *
+ *             data_offset    - [IN/OUT] the availability data offset         *
+ *                                                                            *
+ ******************************************************************************/
+static void	process_item_value(DC_ITEM *item, AGENT_RESULT *result, int errcode, zbx_timespec_t *timespec,
+		const zbx_vector_ptr_t *add_results, int *last_available, unsigned char **data, size_t *data_alloc,
+		size_t *data_offset)
+{
+	switch (errcode)
+	{
+		case SUCCEED:
+		case NOTSUPPORTED:
+		case AGENT_ERROR:
+			if (INTERFACE_AVAILABLE_TRUE != *last_available)
+			{
+				zbx_activate_item_interface(timespec, item, data, data_alloc, data_offset);
+				*last_available = INTERFACE_AVAILABLE_TRUE;
+			}
+			break;
+		case NETWORK_ERROR:
+		case GATEWAY_ERROR:
+		case TIMEOUT_ERROR:
+			if (INTERFACE_AVAILABLE_FALSE != *last_available)
+			{
+				zbx_deactivate_item_interface(timespec, item, data, data_alloc, data_offset,
+						result->msg);
+				*last_available = INTERFACE_AVAILABLE_FALSE;
+			}
+			break;
+		case CONFIG_ERROR:
+			/* nothing to do */
+			break;
+		default:
+			zbx_error("unknown response code returned: %d", errcode);
+			THIS_SHOULD_NEVER_HAPPEN;
+	}
+
+	if (SUCCEED == errcode)
+	{
+		if (0 == add_results->values_num)
+		{
+			item->state = ITEM_STATE_NORMAL;
+			zbx_preprocess_item_value(item->itemid, item->host.hostid, item->value_type, item->flags,
+					result, timespec, item->state, NULL);
+		}
+		else
+		{
+			/* vmware.eventlog item returns vector of AGENT_RESULT representing events */
+
+			int		j;
+			zbx_timespec_t	ts_tmp = *timespec;
+
+			for (j = 0; j < add_results->values_num; j++)
+			{
+				AGENT_RESULT	*add_result = (AGENT_RESULT *)add_results->values[j];
+
+				if (ISSET_MSG(add_result))
+				{
+					item->state = ITEM_STATE_NOTSUPPORTED;
+					zbx_preprocess_item_value(item->itemid, item->host.hostid, item->value_type,
+							item->flags, NULL, &ts_tmp, item->state, add_result->msg);
+				}
+				else
+				{
+					item->state = ITEM_STATE_NORMAL;
+					zbx_preprocess_item_value(item->itemid, item->host.hostid, item->value_type,
+							item->flags, add_result, &ts_tmp, item->state, NULL);
+				}
+
+				/* ensure that every log item value timestamp is unique */
+				if (++ts_tmp.ns == 1000000000)
+				{
+					ts_tmp.sec++;
+					ts_tmp.ns = 0;
+				}
+			}
+		}
+	}
+	else if (NOTSUPPORTED == errcode || AGENT_ERROR == errcode || CONFIG_ERROR == errcode)
+	{
+		item->state = ITEM_STATE_NOTSUPPORTED;
+		zbx_preprocess_item_value(item->itemid, item->host.hostid, item->value_type, item->flags, NULL,
+				timespec, item->state, result->msg);
+	}
+}
+
+/* asynchronous passive agent checks of poller */
+typedef struct
+{
+	unsigned char		poller_type;
+	int			*nextcheck;
+	/* the number of processed items */
+	int			num;
+	int			last_available;
+	zbx_uint64_t		last_interfaceid;
+	/* agent checks do not return additional results */
+	zbx_vector_ptr_t	add_results;
+	unsigned char		*data;
+	size_t			data_alloc;
+	size_t			data_offset;
+}
+zbx_agent_poller_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_poller_flush                                               *
+ *                                                                            *
+ * Purpose: send the processed values and interface availability changes      *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_poller_flush(zbx_agent_poller_t *poller)
+{
+	zbx_preprocessor_flush();
+
+	if (0 != poller->data_offset)
+	{
+		zbx_availability_flush(poller->data, poller->data_offset);
+		poller->data_offset = 0;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_poller_value_cb                                            *
+ *                                                                            *
+ * Purpose: process passive agent check result as soon as the check finishes  *
+ *          and return the item to the queue                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_poller_value_cb(DC_ITEM *item, AGENT_RESULT *result, int errcode, void *data)
+{
+	zbx_agent_poller_t	*poller = (zbx_agent_poller_t *)data;
+	zbx_timespec_t		timespec;
+
+	zbx_timespec(&timespec);
+
+	/* results of different interfaces are returned in any order */
+	if (item->interface.interfaceid != poller->last_interfaceid)
+	{
+		poller->last_available = INTERFACE_AVAILABLE_UNKNOWN;
+		poller->last_interfaceid = item->interface.interfaceid;
+	}
+
+	process_item_value(item, result, errcode, &timespec, &poller->add_results, &poller->last_available,
+			&poller->data, &poller->data_alloc, &poller->data_offset);
+
+	DCpoller_requeue_items(&item->itemid, &timespec.sec, &errcode, 1, poller->poller_type, poller->nextcheck);
+
+	zbx_clean_items(item, 1, result);
+	DCconfig_clean_items(item, NULL, 1);
+
+	poller->num++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_poller_items_cb                                            *
+ *                                                                            *
+ * Purpose: get more due passive agent items for free agent connections       *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_poller_items_cb(DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int max_items,
+		void *data)
+{
+	zbx_agent_poller_t	*poller = (zbx_agent_poller_t *)data;
+	int			num;
+
+	agent_poller_flush(poller);
+
+	if (!ZBX_IS_RUNNING())
+		return 0;
+
+	if (0 != (num = DCconfig_get_agent_poller_items(poller->poller_type, items, max_items)))
+		zbx_prepare_items(items, errcodes, num, results, MACRO_EXPAND_YES);
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_values_agent_async                                           *
+ *                                                                            *
+ * Purpose: check unencrypted passive agent items concurrently, taking more   *
+ *          due agent items from the queue as connections become free         *
+ *                                                                            *
+ * Parameters: poller_type - [IN] poller type (ZBX_POLLER_TYPE_...)           *
+ *             items       - [IN] the prepared items                          *
+ *             results     - [IN] the item results                            *
+ *             errcodes    - [IN] the item error codes                        *
+ *             num         - [IN] the number of items                         *
+ *             nextcheck   - [OUT] item nextcheck                             *
+ *                                                                            *
+ * Return value: number of items processed                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_values_agent_async(unsigned char poller_type, DC_ITEM *items, AGENT_RESULT *results,
+		int *errcodes, int num, int *nextcheck)
+{
+	zbx_agent_poller_t	poller;
+
+	memset(&poller, 0, sizeof(poller));
+	poller.poller_type = poller_type;
+	poller.nextcheck = nextcheck;
+	poller.last_available = INTERFACE_AVAILABLE_UNKNOWN;
+	zbx_vector_ptr_create(&poller.add_results);
+
+	get_values_agent(items, results, errcodes, num, agent_poller_value_cb, agent_poller_items_cb, &poller);
+
+	agent_poller_flush(&poller);
+
+	zbx_vector_ptr_destroy(&poller.add_results);
+	zbx_free(poller.data);
+
+	return poller.num;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: get_values                                                       *
@@ -795,8 +1027,10 @@ void	zbx_clean_items(DC_ITEM *items, int num, AGENT_RESULT *results)
  *                                                                            *
  * Author: Alexei Vladishev                                                   *
  *                                                                            *
- * Comments: processes single item at a time except for Java, SNMP items,     *
- *           see DCconfig_get_poller_items()                                  *
+ * Comments: processes single item at a time except for Java, SNMP and        *
+ *           unencrypted passive agent items of normal pollers when enabled   *
+ *           by AsyncAgentChecks configuration parameter, see                 *
+ *           DCconfig_get_poller_items() and get_values_agent_async()         *
  *                                                                            *
  ******************************************************************************/
 static int	get_values(unsigned char poller_type, int *nextcheck)
@@ -821,9 +1055,18 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 		goto exit;
 	}
 
+	zbx_prepare_items(items, errcodes, num, results, MACRO_EXPAND_YES);
+
+	if (1 == CONFIG_ASYNC_AGENT_CHECKS && ZBX_POLLER_TYPE_NORMAL == poller_type &&
+			ITEM_TYPE_ZABBIX == items[0].type && ZBX_TCP_SEC_UNENCRYPTED == items[0].host.tls_connect)
+	{
+		/* asynchronous agent checks use their own timeouts */
+		num = get_values_agent_async(poller_type, items, results, errcodes, num, nextcheck);
+		goto out;
+	}
+
 	zbx_vector_ptr_create(&add_results);
 
-	zbx_prepare_items(items, errcodes, num, results, MACRO_EXPAND_YES);
 	zbx_check_items(items, errcodes, num, results, &add_results, poller_type);
 
 	zbx_timespec(&timespec);
@@ -831,85 +1074,8 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 	/* process item values */
 	for (i = 0; i < num; i++)
 	{
-		switch (errcodes[i])
-		{
-			case SUCCEED:
-			case NOTSUPPORTED:
-			case AGENT_ERROR:
-				if (INTERFACE_AVAILABLE_TRUE != last_available)
-				{
-					zbx_activate_item_interface(&timespec, &items[i], &data, &data_alloc,
-							&data_offset);
-					last_available = INTERFACE_AVAILABLE_TRUE;
-				}
-				break;
-			case NETWORK_ERROR:
-			case GATEWAY_ERROR:
-			case TIMEOUT_ERROR:
-				if (INTERFACE_AVAILABLE_FALSE != last_available)
-				{
-					zbx_deactivate_item_interface(&timespec, &items[i], &data, &data_alloc,
-							&data_offset, results[i].msg);
-					last_available = INTERFACE_AVAILABLE_FALSE;
-				}
-				break;
-			case CONFIG_ERROR:
-				/* nothing to do */
-				break;
-			default:
-				zbx_error("unknown response code returned: %d", errcodes[i]);
-				THIS_SHOULD_NEVER_HAPPEN;
-		}
-
-		if (SUCCEED == errcodes[i])
-		{
-			if (0 == add_results.values_num)
-			{
-				items[i].state = ITEM_STATE_NORMAL;
-				zbx_preprocess_item_value(items[i].itemid, items[i].host.hostid, items[i].value_type,
-						items[i].flags, &results[i], &timespec, items[i].state, NULL);
-			}
-			else
-			{
-				/* vmware.eventlog item returns vector of AGENT_RESULT representing events */
-
-				int		j;
-				zbx_timespec_t	ts_tmp = timespec;
-
-				for (j = 0; j < add_results.values_num; j++)
-				{
-					AGENT_RESULT	*add_result = (AGENT_RESULT *)add_results.values[j];
-
-					if (ISSET_MSG(add_result))
-					{
-						items[i].state = ITEM_STATE_NOTSUPPORTED;
-						zbx_preprocess_item_value(items[i].itemid, items[i].host.hostid,
-						items[i].value_type, items[i].flags, NULL, &ts_tmp, items[i].state,
-								add_result->msg);
-					}
-					else
-					{
-						items[i].state = ITEM_STATE_NORMAL;
-						zbx_preprocess_item_value(items[i].itemid, items[i].host.hostid,
-								items[i].value_type, items[i].flags, add_result,
-								&ts_tmp, items[i].state, NULL);
-					}
-
-					/* ensure that every log item value timestamp is unique */
-					if (++ts_tmp.ns == 1000000000)
-					{
-						ts_tmp.sec++;
-						ts_tmp.ns = 0;
-					}
-				}
-			}
-		}
-		else if (NOTSUPPORTED == errcodes[i] || AGENT_ERROR == errcodes[i] || CONFIG_ERROR == errcodes[i])
-		{
-			items[i].state = ITEM_STATE_NOTSUPPORTED;
-			zbx_preprocess_item_value(items[i].itemid, items[i].host.hostid, items[i].value_type,
-					items[i].flags, NULL, &timespec, items[i].state, results[i].msg);
-		}
+		process_item_value(&items[i], &results[i], errcodes[i], &timespec, &add_results, &last_available,
+				&data, &data_alloc, &data_offset);
 
 		DCpoller_requeue_items(&items[i].itemid, &timespec.sec, &errcodes[i], 1, poller_type,
 				nextcheck);
@@ -926,7 +1092,7 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 		zbx_availability_flush(data, data_offset);
 		zbx_free(data);
 	}
-
+out:
 	if (items != &item)
 		zbx_free(items);
 exit:
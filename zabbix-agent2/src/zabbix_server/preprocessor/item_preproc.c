@@ -35,6 +35,46 @@
 
 extern zbx_es_t	es_engine;
 
+#define ZBX_PREPROC_JSONPATH_CACHE_MAX	10000
+
+/* compiled JSONPath cache entry */
+typedef struct
+{
+	char		*path;
+	zbx_jsonpath_t	jsonpath;
+}
+zbx_preproc_jsonpath_t;
+
+/* the last successfully validated JSON document, used to skip revalidation */
+/* of the same master item value in sibling dependent item steps            */
+typedef struct
+{
+	char	*data;
+	size_t	size;
+	size_t	start;
+	size_t	end;
+}
+zbx_preproc_json_doc_t;
+
+#define ZBX_PREPROC_PROMETHEUS_NEW	0
+#define ZBX_PREPROC_PROMETHEUS_PARSED	1
+#define ZBX_PREPROC_PROMETHEUS_INVALID	2
+
+/* the last Prometheus pattern input value, parsed and indexed when it is     */
+/* queried again, so sibling dependent item steps share the same parsed data */
+typedef struct
+{
+	char			*data;
+	size_t			size;
+	zbx_prometheus_t	prom;
+	int			state;
+}
+zbx_preproc_prometheus_doc_t;
+
+static zbx_hashset_t			*jsonpath_cache = NULL;
+static zbx_preproc_json_doc_t		json_doc_last;
+static zbx_preproc_prometheus_doc_t	prometheus_doc_last;
+
 /******************************************************************************
  *                                                                            *
  * Function: item_preproc_numeric_type_hint                                   *
@@ -860,6 +900,127 @@ static int	item_preproc_regsub(zbx_variant_t *value, const char *params, char **
 	return FAIL;
 }
 
+static zbx_hash_t	preproc_jsonpath_hash_func(const void *d)
+{
+	const zbx_preproc_jsonpath_t	*jsonpath = (const zbx_preproc_jsonpath_t *)d;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(jsonpath->path);
+}
+
+static int	preproc_jsonpath_compare_func(const void *d1, const void *d2)
+{
+	const zbx_preproc_jsonpath_t	*jsonpath1 = (const zbx_preproc_jsonpath_t *)d1;
+	const zbx_preproc_jsonpath_t	*jsonpath2 = (const zbx_preproc_jsonpath_t *)d2;
+
+	return strcmp(jsonpath1->path, jsonpath2->path);
+}
+
+static void	preproc_jsonpath_clear(void *d)
+{
+	zbx_preproc_jsonpath_t	*jsonpath = (zbx_preproc_jsonpath_t *)d;
+
+	zbx_free(jsonpath->path);
+	zbx_jsonpath_clear(&jsonpath->jsonpath);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: item_preproc_jsonpath_get                                        *
+ *                                                                            *
+ * Purpose: get compiled jsonpath from cache, compiling and caching it if     *
+ *          necessary                                                         *
+ *                                                                            *
+ * Parameters: path - [IN] the jsonpath                                       *
+ *                                                                            *
+ * Return value: the compiled jsonpath or NULL if the path is invalid, in     *
+ *               which case the error is available with zbx_json_strerror()   *
+ *                                                                            *
+ * Comments: The cache is local to preprocessing worker and is reset when it  *
+ *           reaches ZBX_PREPROC_JSONPATH_CACHE_MAX entries.                  *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_jsonpath_t	*item_preproc_jsonpath_get(const char *path)
+{
+	zbx_preproc_jsonpath_t	jsonpath_local, *jsonpath;
+
+	if (NULL == jsonpath_cache)
+	{
+		jsonpath_cache = (zbx_hashset_t *)zbx_malloc(NULL, sizeof(zbx_hashset_t));
+		zbx_hashset_create_ext(jsonpath_cache, 100, preproc_jsonpath_hash_func, preproc_jsonpath_compare_func,
+				preproc_jsonpath_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+				ZBX_DEFAULT_MEM_FREE_FUNC);
+	}
+
+	jsonpath_local.path = (char *)path;
+
+	if (NULL != (jsonpath = (zbx_preproc_jsonpath_t *)zbx_hashset_search(jsonpath_cache, &jsonpath_local)))
+		return &jsonpath->jsonpath;
+
+	if (FAIL == zbx_jsonpath_compile(path, &jsonpath_local.jsonpath))
+		return NULL;
+
+	if (ZBX_PREPROC_JSONPATH_CACHE_MAX <= jsonpath_cache->num_data)
+		zbx_hashset_clear(jsonpath_cache);
+
+	jsonpath_local.path = zbx_strdup(NULL, path);
+	jsonpath = (zbx_preproc_jsonpath_t *)zbx_hashset_insert(jsonpath_cache, &jsonpath_local,
+			sizeof(jsonpath_local));
+
+	return &jsonpath->jsonpath;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: item_preproc_json_cached                                         *
+ *                                                                            *
+ * Purpose: check if json document is the same as the last validated one      *
+ *                                                                            *
+ * Parameters: data - [IN] the json document                                  *
+ *             size - [IN] the json document length                           *
+ *             jp   - [OUT] the json parse structure                          *
+ *                                                                            *
+ * Return value: SUCCEED - the document is the same, jp is set from the       *
+ *                         validation results of the last document            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Dependent items of the same master item receive identical input  *
+ *           values, so only the first of them needs to validate the whole    *
+ *           document. Contents are compared only for documents of the same   *
+ *           length and the comparison stops at the first differing byte.     *
+ *                                                                            *
+ ******************************************************************************/
+static int	item_preproc_json_cached(const char *data, size_t size, struct zbx_json_parse *jp)
+{
+	if (NULL == json_doc_last.data || size != json_doc_last.size || 0 != memcmp(data, json_doc_last.data, size))
+		return FAIL;
+
+	jp->start = data + json_doc_last.start;
+	jp->end = data + json_doc_last.end;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: item_preproc_json_cache                                          *
+ *                                                                            *
+ * Purpose: remember validated json document for the following steps          *
+ *                                                                            *
+ * Parameters: data - [IN] the json document, owned by the cache afterwards   *
+ *             size - [IN] the json document length                           *
+ *             jp   - [IN] the json parse structure of the document           *
+ *                                                                            *
+ ******************************************************************************/
+static void	item_preproc_json_cache(char *data, size_t size, const struct zbx_json_parse *jp)
+{
+	zbx_free(json_doc_last.data);
+
+	json_doc_last.data = data;
+	json_doc_last.size = size;
+	json_doc_last.start = (size_t)(jp->start - data);
+	json_doc_last.end = (size_t)(jp->end - data);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: item_preproc_jsonpath_op                                         *
@@ -877,12 +1038,20 @@ static int	item_preproc_regsub(zbx_variant_t *value, const char *params, char **
 static int	item_preproc_jsonpath_op(zbx_variant_t *value, const char *params, char **errmsg)
 {
 	struct zbx_json_parse	jp;
+	const zbx_jsonpath_t	*jsonpath;
 	char			*data = NULL;
+	size_t			size;
+	int			cached;
 
 	if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
 		return FAIL;
 
-	if (FAIL == zbx_json_open(value->data.str, &jp) || FAIL == zbx_jsonpath_query(&jp, params, &data))
+	size = strlen(value->data.str);
+
+	if ((SUCCEED != (cached = item_preproc_json_cached(value->data.str, size, &jp)) &&
+			FAIL == zbx_json_open(value->data.str, &jp)) ||
+			NULL == (jsonpath = item_preproc_jsonpath_get(params)) ||
+			FAIL == zbx_jsonpath_query_precompiled(&jp, jsonpath, &data))
 	{
 		*errmsg = zbx_strdup(*errmsg, zbx_json_strerror());
 		return FAIL;
@@ -894,7 +1063,13 @@ static int	item_preproc_jsonpath_op(zbx_variant_t *value, const char *params, ch
 		return FAIL;
 	}
 
-	zbx_variant_clear(value);
+	/* the input value is replaced by query result, so newly validated document */
+	/* is moved to cache instead of being copied                                */
+	if (SUCCEED != cached)
+		item_preproc_json_cache(value->data.str, size, &jp);
+	else
+		zbx_variant_clear(value);
+
 	zbx_variant_set_str(value, data);
 
 	return SUCCEED;
@@ -1519,6 +1694,79 @@ fail:
 	return FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: item_preproc_prometheus_get                                      *
+ *                                                                            *
+ * Purpose: get parsed Prometheus data for pattern queries                    *
+ *                                                                            *
+ * Parameters: data   - [IN] the Prometheus data                              *
+ *             size   - [IN] the Prometheus data length                       *
+ *             cached - [OUT] SUCCEED - the data is the same as the last one  *
+ *                            FAIL    - otherwise                             *
+ *                                                                            *
+ * Return value: the parsed Prometheus data or NULL if the data must be       *
+ *               queried directly                                             *
+ *                                                                            *
+ * Comments: Dependent items of the same master item receive identical input  *
+ *           values. The data is parsed into an indexed row table when the    *
+ *           same value is queried the second time, so a single query does    *
+ *           not pay for parsing all rows. The data is compared with the last *
+ *           one in place, without copying it.                                *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_prometheus_t	*item_preproc_prometheus_get(const char *data, size_t size, int *cached)
+{
+	char	*error = NULL;
+
+	if (NULL == prometheus_doc_last.data || size != prometheus_doc_last.size ||
+			0 != memcmp(data, prometheus_doc_last.data, size))
+	{
+		*cached = FAIL;
+		return NULL;
+	}
+
+	*cached = SUCCEED;
+
+	if (ZBX_PREPROC_PROMETHEUS_NEW == prometheus_doc_last.state)
+	{
+		if (SUCCEED == zbx_prometheus_init(&prometheus_doc_last.prom, data, &error))
+		{
+			prometheus_doc_last.state = ZBX_PREPROC_PROMETHEUS_PARSED;
+		}
+		else
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot index Prometheus data: %s", error);
+			zbx_free(error);
+			prometheus_doc_last.state = ZBX_PREPROC_PROMETHEUS_INVALID;
+		}
+	}
+
+	return ZBX_PREPROC_PROMETHEUS_PARSED == prometheus_doc_last.state ? &prometheus_doc_last.prom : NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: item_preproc_prometheus_cache                                    *
+ *                                                                            *
+ * Purpose: remember Prometheus data for the following pattern queries        *
+ *                                                                            *
+ * Parameters: data - [IN] the Prometheus data, owned by the cache afterwards *
+ *             size - [IN] the Prometheus data length                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	item_preproc_prometheus_cache(char *data, size_t size)
+{
+	if (ZBX_PREPROC_PROMETHEUS_PARSED == prometheus_doc_last.state)
+		zbx_prometheus_clear(&prometheus_doc_last.prom);
+
+	zbx_free(prometheus_doc_last.data);
+
+	prometheus_doc_last.data = data;
+	prometheus_doc_last.size = size;
+	prometheus_doc_last.state = ZBX_PREPROC_PROMETHEUS_NEW;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: item_preproc_prometheus_pattern                                  *
@@ -1535,8 +1783,11 @@ fail:
  ******************************************************************************/
 static int	item_preproc_prometheus_pattern(zbx_variant_t *value, const char *params, char **errmsg)
 {
-	char	pattern[ITEM_PREPROC_PARAMS_LEN * ZBX_MAX_BYTES_IN_UTF8_CHAR + 1], *output, *value_out = NULL,
-		*err = NULL;
+	char			pattern[ITEM_PREPROC_PARAMS_LEN * ZBX_MAX_BYTES_IN_UTF8_CHAR + 1], *output,
+				*value_out = NULL, *err = NULL;
+	int			ret, cached;
+	size_t			size;
+	zbx_prometheus_t	*prom;
 
 	if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
 		return FAIL;
@@ -1551,14 +1802,26 @@ static int	item_preproc_prometheus_pattern(zbx_variant_t *value, const char *par
 
 	*output++ = '\0';
 
-	if (FAIL == zbx_prometheus_pattern(value->data.str, pattern, output, &value_out, &err))
+	size = strlen(value->data.str);
+
+	if (NULL != (prom = item_preproc_prometheus_get(value->data.str, size, &cached)))
+		ret = zbx_prometheus_pattern_ex(prom, pattern, output, &value_out, &err);
+	else
+		ret = zbx_prometheus_pattern(value->data.str, pattern, output, &value_out, &err);
+
+	if (FAIL == ret)
 	{
 		*errmsg = zbx_dsprintf(*errmsg, "cannot apply Prometheus pattern: %s", err);
 		zbx_free(err);
 		return FAIL;
 	}
 
-	zbx_variant_clear(value);
+	/* the input value is replaced by pattern result, so new data is moved to cache instead of being copied */
+	if (SUCCEED != cached)
+		item_preproc_prometheus_cache(value->data.str, size);
+	else
+		zbx_variant_clear(value);
+
 	zbx_variant_set_str(value, value_out);
 
 	return SUCCEED;
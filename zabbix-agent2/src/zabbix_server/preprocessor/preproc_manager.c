@@ -70,8 +70,10 @@ zbx_preprocessing_request_t;
 /* preprocessing worker data */
 typedef struct
 {
-	zbx_ipc_client_t	*client;	/* the connected preprocessing worker client */
-	void			*task;		/* the current task data */
+	zbx_ipc_client_t		*client;	/* the connected preprocessing worker client */
+	void				*task;		/* the current task data */
+	zbx_regexp_cache_stats_t	regexp_stats;	/* the last reported regular expression cache */
+							/* statistics                                  */
 }
 zbx_preprocessing_worker_t;
 
@@ -1232,21 +1234,52 @@ static	void	preprocessor_get_items_totals(zbx_preprocessing_manager_t *manager,
  ******************************************************************************/
 static void	preprocessor_get_diag_stats(zbx_preprocessing_manager_t *manager, zbx_ipc_client_t *client)
 {
-	unsigned char	*data;
-	zbx_uint32_t	data_len;
-	int		total, queued, processing, done, pending;
+	unsigned char			*data;
+	zbx_uint32_t			data_len;
+	int				total, queued, processing, done, pending, i;
+	zbx_regexp_cache_stats_t	regexp_stats = {0};
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	preprocessor_get_items_totals(manager, &total, &queued, &processing, &done, &pending);
 
-	data_len = zbx_preprocessor_pack_diag_stats(&data, total, queued, processing, done, pending);
+	for (i = 0; i < manager->worker_count; i++)
+	{
+		const zbx_regexp_cache_stats_t	*stats = &manager->workers[i].regexp_stats;
+
+		regexp_stats.entries += stats->entries;
+		regexp_stats.hits += stats->hits;
+		regexp_stats.misses += stats->misses;
+		regexp_stats.evictions += stats->evictions;
+	}
+
+	data_len = zbx_preprocessor_pack_diag_stats(&data, total, queued, processing, done, pending, &regexp_stats);
 	zbx_ipc_client_send(client, ZBX_IPC_PREPROCESSOR_DIAG_STATS_RESULT, data, data_len);
 	zbx_free(data);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_update_worker_stats                                 *
+ *                                                                            *
+ * Purpose: update statistics reported by preprocessing worker                *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             client  - [IN] IPC client                                      *
+ *             message - [IN] the message with worker statistics              *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_update_worker_stats(zbx_preprocessing_manager_t *manager, zbx_ipc_client_t *client,
+		const zbx_ipc_message_t *message)
+{
+	zbx_preprocessing_worker_t	*worker;
+
+	worker = preprocessor_get_worker_by_client(manager, client);
+	zbx_preprocessor_unpack_worker_stats(&worker->regexp_stats, message->data);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: preproc_sort_item_by_values_desc                                 *
@@ -1560,6 +1593,9 @@ ZBX_THREAD_ENTRY(preprocessing_manager_thread, args)
 				case ZBX_IPC_PREPROCESSOR_RESULT:
 					preprocessor_add_result(&manager, client, message);
 					break;
+				case ZBX_IPC_PREPROCESSOR_WORKER_STATS:
+					preprocessor_update_worker_stats(&manager, client, message);
+					break;
 				case ZBX_IPC_PREPROCESSOR_QUEUE:
 					zbx_ipc_client_send(client, message->code, (unsigned char *)&manager.queued_num,
 							sizeof(zbx_uint64_t));
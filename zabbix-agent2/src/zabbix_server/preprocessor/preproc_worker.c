@@ -36,6 +36,7 @@ extern unsigned char			program_type;
 extern ZBX_THREAD_LOCAL int		server_num, process_num;
 
 #define ZBX_PREPROC_VALUE_PREVIEW_LEN		100
+#define ZBX_PREPROC_WORKER_STATS_INTERVAL	5	/* how often to report statistics to manager, in seconds */
 
 zbx_es_t	es_engine;
 
@@ -423,12 +424,40 @@ static void	worker_test_value(zbx_ipc_socket_t *socket, zbx_ipc_message_t *messa
 	zbx_vector_ptr_destroy(&history_in);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: worker_send_stats                                                *
+ *                                                                            *
+ * Purpose: report worker statistics to preprocessing manager                 *
+ *                                                                            *
+ * Parameters: socket - [IN] IPC socket                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	worker_send_stats(zbx_ipc_socket_t *socket)
+{
+	unsigned char			*data;
+	zbx_uint32_t			size;
+	zbx_regexp_cache_stats_t	regexp_stats;
+
+	zbx_regexp_get_cache_stats(&regexp_stats);
+	size = zbx_preprocessor_pack_worker_stats(&data, &regexp_stats);
+
+	if (FAIL == zbx_ipc_socket_write(socket, ZBX_IPC_PREPROCESSOR_WORKER_STATS, data, size))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot send preprocessing worker statistics");
+		exit(EXIT_FAILURE);
+	}
+
+	zbx_free(data);
+}
+
 ZBX_THREAD_ENTRY(preprocessing_worker_thread, args)
 {
 	pid_t			ppid;
 	char			*error = NULL;
 	zbx_ipc_socket_t	socket;
 	zbx_ipc_message_t	message;
+	double			time_now, time_stats = 0;
 
 	process_type = ((zbx_thread_args_t *)args)->process_type;
 	server_num = ((zbx_thread_args_t *)args)->server_num;
@@ -447,6 +476,8 @@ ZBX_THREAD_ENTRY(preprocessing_worker_thread, args)
 		exit(EXIT_FAILURE);
 	}
 
+	zbx_ipc_socket_enable_shm(&socket, ZBX_PREPROCESSING_SHM_SIZE);
+
 	ppid = getppid();
 	zbx_ipc_socket_write(&socket, ZBX_IPC_PREPROCESSOR_WORKER, (unsigned char *)&ppid, sizeof(ppid));
 
@@ -468,7 +499,8 @@ ZBX_THREAD_ENTRY(preprocessing_worker_thread, args)
 		}
 
 		update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
-		zbx_update_env(zbx_time());
+		time_now = zbx_time();
+		zbx_update_env(time_now);
 
 		switch (message.code)
 		{
@@ -481,6 +513,12 @@ ZBX_THREAD_ENTRY(preprocessing_worker_thread, args)
 		}
 
 		zbx_ipc_message_clean(&message);
+
+		if (ZBX_PREPROC_WORKER_STATS_INTERVAL <= time_now - time_stats)
+		{
+			worker_send_stats(&socket);
+			time_stats = time_now;
+		}
 	}
 
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
@@ -629,11 +629,12 @@ zbx_uint32_t	zbx_preprocessor_pack_test_result(unsigned char **data, const zbx_p
  *                               preprocessed after previous value for        *
  *                               example delta, throttling depends on         *
  *                               previous value                               *
- *             data       - [IN] IPC data buffer                              *
+ *             regexp_stats - [IN] the regular expression cache statistics    *
+ *                                 summed over preprocessing workers          *
  *                                                                            *
  ******************************************************************************/
 zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, int total, int queued, int processing, int done,
-		int pending)
+		int pending, const zbx_regexp_cache_stats_t *regexp_stats)
 {
 	unsigned char	*ptr;
 	zbx_uint32_t	data_len = 0;
@@ -643,6 +644,10 @@ zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, int total, i
 	zbx_serialize_prepare_value(data_len, processing);
 	zbx_serialize_prepare_value(data_len, done);
 	zbx_serialize_prepare_value(data_len, pending);
+	zbx_serialize_prepare_value(data_len, regexp_stats->entries);
+	zbx_serialize_prepare_value(data_len, regexp_stats->hits);
+	zbx_serialize_prepare_value(data_len, regexp_stats->misses);
+	zbx_serialize_prepare_value(data_len, regexp_stats->evictions);
 
 	*data = (unsigned char *)zbx_malloc(NULL, data_len);
 
@@ -651,7 +656,44 @@ zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, int total, i
 	ptr += zbx_serialize_value(ptr, queued);
 	ptr += zbx_serialize_value(ptr, processing);
 	ptr += zbx_serialize_value(ptr, done);
-	(void)zbx_serialize_value(ptr, pending);
+	ptr += zbx_serialize_value(ptr, pending);
+	ptr += zbx_serialize_value(ptr, regexp_stats->entries);
+	ptr += zbx_serialize_value(ptr, regexp_stats->hits);
+	ptr += zbx_serialize_value(ptr, regexp_stats->misses);
+	(void)zbx_serialize_value(ptr, regexp_stats->evictions);
+
+	return data_len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_pack_worker_stats                               *
+ *                                                                            *
+ * Purpose: pack preprocessing worker statistics data into a single buffer    *
+ *          that can be used in IPC                                           *
+ *                                                                            *
+ * Parameters: data         - [OUT] memory buffer for packed data             *
+ *             regexp_stats - [IN] the worker regular expression cache        *
+ *                                 statistics                                 *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_preprocessor_pack_worker_stats(unsigned char **data, const zbx_regexp_cache_stats_t *regexp_stats)
+{
+	unsigned char	*ptr;
+	zbx_uint32_t	data_len = 0;
+
+	zbx_serialize_prepare_value(data_len, regexp_stats->entries);
+	zbx_serialize_prepare_value(data_len, regexp_stats->hits);
+	zbx_serialize_prepare_value(data_len, regexp_stats->misses);
+	zbx_serialize_prepare_value(data_len, regexp_stats->evictions);
+
+	*data = (unsigned char *)zbx_malloc(NULL, data_len);
+
+	ptr = *data;
+	ptr += zbx_serialize_value(ptr, regexp_stats->entries);
+	ptr += zbx_serialize_value(ptr, regexp_stats->hits);
+	ptr += zbx_serialize_value(ptr, regexp_stats->misses);
+	(void)zbx_serialize_value(ptr, regexp_stats->evictions);
 
 	return data_len;
 }
@@ -916,11 +958,13 @@ void	zbx_preprocessor_unpack_test_result(zbx_vector_ptr_t *results, zbx_vector_p
  *                                preprocessed after previous value for       *
  *                                example delta, throttling depends on        *
  *                                previous value                              *
+ *             regexp_stats - [OUT] the regular expression cache statistics   *
+ *                                  summed over preprocessing workers         *
  *             data       - [IN] IPC data buffer                              *
  *                                                                            *
  ******************************************************************************/
 void	zbx_preprocessor_unpack_diag_stats(int *total, int *queued, int *processing, int *done,
-		int *pending, const unsigned char *data)
+		int *pending, zbx_regexp_cache_stats_t *regexp_stats, const unsigned char *data)
 {
 	const unsigned char	*offset = data;
 
@@ -928,7 +972,32 @@ void	zbx_preprocessor_unpack_diag_stats(int *total, int *queued, int *processing
 	offset += zbx_deserialize_int(offset, queued);
 	offset += zbx_deserialize_int(offset, processing);
 	offset += zbx_deserialize_int(offset, done);
-	(void)zbx_deserialize_int(offset, pending);
+	offset += zbx_deserialize_int(offset, pending);
+	offset += zbx_deserialize_uint64(offset, &regexp_stats->entries);
+	offset += zbx_deserialize_uint64(offset, &regexp_stats->hits);
+	offset += zbx_deserialize_uint64(offset, &regexp_stats->misses);
+	(void)zbx_deserialize_uint64(offset, &regexp_stats->evictions);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_unpack_worker_stats                             *
+ *                                                                            *
+ * Purpose: unpack preprocessing worker statistics from IPC data buffer       *
+ *                                                                            *
+ * Parameters: regexp_stats - [OUT] the worker regular expression cache       *
+ *                                  statistics                                *
+ *             data         - [IN] IPC data buffer                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_preprocessor_unpack_worker_stats(zbx_regexp_cache_stats_t *regexp_stats, const unsigned char *data)
+{
+	const unsigned char	*offset = data;
+
+	offset += zbx_deserialize_uint64(offset, &regexp_stats->entries);
+	offset += zbx_deserialize_uint64(offset, &regexp_stats->hits);
+	offset += zbx_deserialize_uint64(offset, &regexp_stats->misses);
+	(void)zbx_deserialize_uint64(offset, &regexp_stats->evictions);
 }
 
 /******************************************************************************
@@ -999,11 +1068,15 @@ static void	preprocessor_send(zbx_uint32_t code, unsigned char *data, zbx_uint32
 	static zbx_ipc_socket_t	socket = {0};
 
 	/* each process has a permanent connection to preprocessing manager */
-	if (0 == socket.fd && FAIL == zbx_ipc_socket_open(&socket, ZBX_IPC_SERVICE_PREPROCESSING, SEC_PER_MIN,
-			&error))
+	if (0 == socket.fd)
 	{
-		zabbix_log(LOG_LEVEL_CRIT, "cannot connect to preprocessing service: %s", error);
-		exit(EXIT_FAILURE);
+		if (FAIL == zbx_ipc_socket_open(&socket, ZBX_IPC_SERVICE_PREPROCESSING, SEC_PER_MIN, &error))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot connect to preprocessing service: %s", error);
+			exit(EXIT_FAILURE);
+		}
+
+		zbx_ipc_socket_enable_shm(&socket, ZBX_PREPROCESSING_SHM_SIZE);
 	}
 
 	if (FAIL == zbx_ipc_socket_write(&socket, code, data, size))
@@ -1274,7 +1347,7 @@ out:
  *                                                                            *
  ******************************************************************************/
 int	zbx_preprocessor_get_diag_stats(int *total, int *queued, int *processing, int *done,
-		int *pending, char **error)
+		int *pending, zbx_regexp_cache_stats_t *regexp_stats, char **error)
 {
 	unsigned char	*result;
 
@@ -1284,7 +1357,7 @@ int	zbx_preprocessor_get_diag_stats(int *total, int *queued, int *processing, in
 		return FAIL;
 	}
 
-	zbx_preprocessor_unpack_diag_stats(total, queued, processing, done, pending, result);
+	zbx_preprocessor_unpack_diag_stats(total, queued, processing, done, pending, regexp_stats, result);
 	zbx_free(result);
 
 	return SUCCEED;
@@ -25,9 +25,13 @@
 #include "dbcache.h"
 #include "preproc.h"
 #include "zbxalgo.h"
+#include "zbxregexp.h"
 
 #define ZBX_IPC_SERVICE_PREPROCESSING	"preprocessing"
 
+/* the shared memory ring size for large values sent to preprocessing manager */
+#define ZBX_PREPROCESSING_SHM_SIZE	ZBX_MEBIBYTE
+
 #define ZBX_IPC_PREPROCESSOR_WORKER			1
 #define ZBX_IPC_PREPROCESSOR_REQUEST			2
 #define ZBX_IPC_PREPROCESSOR_RESULT			3
@@ -39,6 +43,7 @@
 #define ZBX_IPC_PREPROCESSOR_TOP_ITEMS			9
 #define ZBX_IPC_PREPROCESSOR_TOP_ITEMS_RESULT		10
 #define ZBX_IPC_PREPROCESSOR_TOP_OLDEST_PREPROC_ITEMS	11
+#define ZBX_IPC_PREPROCESSOR_WORKER_STATS		12
 
 typedef struct {
 	AGENT_RESULT	*result;
@@ -82,10 +87,14 @@ void	zbx_preprocessor_unpack_test_result(zbx_vector_ptr_t *results, zbx_vector_p
 		char **error, const unsigned char *data);
 
 zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, int total, int queued, int processing, int done,
-		int pending);
+		int pending, const zbx_regexp_cache_stats_t *regexp_stats);
 
 void	zbx_preprocessor_unpack_diag_stats(int *total, int *queued, int *processing, int *done,
-		int *pending, const unsigned char *data);
+		int *pending, zbx_regexp_cache_stats_t *regexp_stats, const unsigned char *data);
+
+zbx_uint32_t	zbx_preprocessor_pack_worker_stats(unsigned char **data, const zbx_regexp_cache_stats_t *regexp_stats);
+
+void	zbx_preprocessor_unpack_worker_stats(zbx_regexp_cache_stats_t *regexp_stats, const unsigned char *data);
 
 zbx_uint32_t	zbx_preprocessor_pack_top_items_request(unsigned char **data, int limit);
 
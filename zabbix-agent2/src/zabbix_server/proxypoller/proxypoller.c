@@ -167,6 +167,9 @@ static int	get_data_from_proxy(DC_PROXY *proxy, const char *request, char **data
 
 	zbx_json_addstring(&j, "request", request, ZBX_JSON_TYPE_STRING);
 
+	if (0 == strcmp(request, ZBX_PROTO_VALUE_PROXY_DATA))
+		zbx_json_adduint64(&j, ZBX_PROTO_TAG_HISTORY_BINARY, ZBX_HISTORY_BINARY_VERSION);
+
 	if (0 != proxy->auto_compress)
 	{
 		if (SUCCEED != zbx_compress(j.buffer, j.buffer_size, &buffer, &buffer_size))
@@ -268,7 +271,7 @@ static int	proxy_send_configuration(DC_PROXY *proxy)
 	zbx_json_addstring(&j, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_PROXY_CONFIG, ZBX_JSON_TYPE_STRING);
 	zbx_json_addobject(&j, ZBX_PROTO_TAG_DATA);
 
-	if (SUCCEED != (ret = get_proxyconfig_data(proxy->hostid, &j, &error)))
+	if (SUCCEED != (ret = get_proxyconfig_data(proxy->hostid, NULL, &j, &error)))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot collect configuration data for proxy \"%s\": %s",
 				proxy->host, error);
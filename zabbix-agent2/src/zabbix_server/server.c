@@ -248,11 +248,19 @@ zbx_uint64_t	CONFIG_TRENDS_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_TREND_FUNC_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE		= 8 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * ZBX_MEBIBYTE;
+zbx_uint64_t	CONFIG_PROXY_MEMORY_BUFFER_SIZE	= 0;
 zbx_uint64_t	CONFIG_EXPORT_FILE_SIZE		= ZBX_GIBIBYTE;
 
+int	CONFIG_VALUE_CACHE_COMPRESSION	= 0;
+int	CONFIG_VALUE_CACHE_AGGREGATES	= 0;
+char	*CONFIG_VALUE_CACHE_FILE	= NULL;
+
+char	*CONFIG_TREND_FUNC_CACHE_FILE	= NULL;
+
 int	CONFIG_UNREACHABLE_PERIOD	= 45;
 int	CONFIG_UNREACHABLE_DELAY	= 15;
 int	CONFIG_UNAVAILABLE_DELAY	= 60;
+int	CONFIG_ASYNC_AGENT_CHECKS	= 0;
 int	CONFIG_LOG_LEVEL		= LOG_LEVEL_WARNING;
 char	*CONFIG_ALERT_SCRIPTS_PATH	= NULL;
 char	*CONFIG_EXTERNALSCRIPTS		= NULL;
@@ -344,6 +352,8 @@ static char	*CONFIG_SOCKET_PATH	= NULL;
 char	*CONFIG_HISTORY_STORAGE_URL		= NULL;
 char	*CONFIG_HISTORY_STORAGE_OPTS		= NULL;
 int	CONFIG_HISTORY_STORAGE_PIPELINES	= 0;
+int	CONFIG_HISTORY_BULK_LOAD		= 0;
+int	CONFIG_HISTORY_PIPELINED_COMMIT	= 0;
 
 char	*CONFIG_STATS_ALLOWED_IP	= NULL;
 int	CONFIG_TCP_MAX_BACKLOG_SIZE	= SOMAXCONN;
@@ -697,6 +707,12 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 	err |= (FAIL == check_cfg_feature_int("StartReportWriters", CONFIG_REPORTWRITER_FORKS, "cURL library"));
 #endif
 
+#if !defined(HAVE_POSTGRESQL)
+	err |= (FAIL == check_cfg_feature_int("HistoryBulkLoad", CONFIG_HISTORY_BULK_LOAD, "PostgreSQL support"));
+	err |= (FAIL == check_cfg_feature_int("HistoryPipelinedCommit", CONFIG_HISTORY_PIPELINED_COMMIT,
+			"PostgreSQL support"));
+#endif
+
 #if !defined(HAVE_LIBXML2) || !defined(HAVE_LIBCURL)
 	err |= (FAIL == check_cfg_feature_int("StartVMwareCollectors", CONFIG_VMWARE_FORKS, "VMware support"));
 
@@ -800,8 +816,16 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"TrendFunctionCacheSize",	&CONFIG_TREND_FUNC_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	0,			__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"TrendFunctionCacheFile",	&CONFIG_TREND_FUNC_CACHE_FILE,		TYPE_STRING,
+			PARM_OPT,	0,			0},
 		{"ValueCacheSize",		&CONFIG_VALUE_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	0,			__UINT64_C(64) * ZBX_GIBIBYTE},
+		{"ValueCacheCompression",	&CONFIG_VALUE_CACHE_COMPRESSION,	TYPE_INT,
+			PARM_OPT,	0,			1},
+		{"ValueCacheAggregates",	&CONFIG_VALUE_CACHE_AGGREGATES,		TYPE_INT,
+			PARM_OPT,	0,			1},
+		{"ValueCacheFile",		&CONFIG_VALUE_CACHE_FILE,		TYPE_STRING,
+			PARM_OPT,	0,			0},
 		{"CacheUpdateFrequency",	&CONFIG_CONFSYNCER_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	1,			SEC_PER_HOUR},
 		{"HousekeepingFrequency",	&CONFIG_HOUSEKEEPING_FREQUENCY,		TYPE_INT,
@@ -824,6 +848,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	1,			SEC_PER_HOUR},
 		{"UnavailableDelay",		&CONFIG_UNAVAILABLE_DELAY,		TYPE_INT,
 			PARM_OPT,	1,			SEC_PER_HOUR},
+		{"AsyncAgentChecks",		&CONFIG_ASYNC_AGENT_CHECKS,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"ListenIP",			&CONFIG_LISTEN_IP,			TYPE_STRING_LIST,
 			PARM_OPT,	0,			0},
 		{"ListenPort",			&CONFIG_LISTEN_PORT,			TYPE_INT,
@@ -840,6 +866,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"LogFileSize",			&CONFIG_LOG_FILE_SIZE,			TYPE_INT,
 			PARM_OPT,	0,			1024},
+		{"LogBuffer",			&CONFIG_LOG_BUFFER,			TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"AlertScriptsPath",		&CONFIG_ALERT_SCRIPTS_PATH,		TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"ExternalScripts",		&CONFIG_EXTERNALSCRIPTS,		TYPE_STRING,
@@ -944,6 +972,10 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"HistoryStorageDateIndex",	&CONFIG_HISTORY_STORAGE_PIPELINES,	TYPE_INT,
 			PARM_OPT,	0,			1},
+		{"HistoryBulkLoad",		&CONFIG_HISTORY_BULK_LOAD,		TYPE_INT,
+			PARM_OPT,	0,			1},
+		{"HistoryPipelinedCommit",	&CONFIG_HISTORY_PIPELINED_COMMIT,	TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"ExportDir",			&CONFIG_EXPORT_DIR,			TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"ExportType",			&CONFIG_EXPORT_TYPE,			TYPE_STRING_LIST,
@@ -1341,6 +1373,18 @@ static int	server_startup(zbx_socket_t *listen_sock)
 				/* update maintenance states */
 				zbx_dc_update_maintenances();
 
+				if (SUCCEED != zbx_vc_load(&error))
+				{
+					zabbix_log(LOG_LEVEL_WARNING, "cannot load value cache: %s", error);
+					zbx_free(error);
+				}
+
+				if (SUCCEED != zbx_tfc_load(&error))
+				{
+					zabbix_log(LOG_LEVEL_WARNING, "cannot load trend function cache: %s", error);
+					zbx_free(error);
+				}
+
 				DBclose();
 
 				zbx_vc_enable();
@@ -1916,6 +1960,18 @@ void	zbx_on_exit(int ret)
 
 		free_configuration_cache();
 
+		if (SUCCEED != zbx_tfc_save(&error))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot save trend function cache: %s", error);
+			zbx_free(error);
+		}
+
+		if (SUCCEED != zbx_vc_save(&error))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot save value cache: %s", error);
+			zbx_free(error);
+		}
+
 		/* free history value cache */
 		zbx_vc_destroy();
 
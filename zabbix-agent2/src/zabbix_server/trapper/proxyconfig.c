@@ -39,11 +39,12 @@
  ******************************************************************************/
 void	send_proxyconfig(zbx_socket_t *sock, struct zbx_json_parse *jp)
 {
-	char		*error = NULL, *buffer = NULL;
-	struct zbx_json	j;
-	DC_PROXY	proxy;
-	int		ret, flags = ZBX_TCP_PROTOCOL;
-	size_t		buffer_size, reserved = 0;
+	char			*error = NULL, *buffer = NULL;
+	struct zbx_json		j;
+	struct zbx_json_parse	jp_revision, *jp_revision_ptr = NULL;
+	DC_PROXY		proxy;
+	int			ret, flags = ZBX_TCP_PROTOCOL;
+	size_t			buffer_size, reserved = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -67,9 +68,13 @@ void	send_proxyconfig(zbx_socket_t *sock, struct zbx_json_parse *jp)
 	if (0 != proxy.auto_compress)
 		flags |= ZBX_TCP_COMPRESS;
 
+	/* proxy acknowledges the configuration revision it has applied to receive only the changes */
+	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_CONFIG_REVISION, &jp_revision))
+		jp_revision_ptr = &jp_revision;
+
 	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
 
-	if (SUCCEED != get_proxyconfig_data(proxy.hostid, &j, &error))
+	if (SUCCEED != get_proxyconfig_data(proxy.hostid, jp_revision_ptr, &j, &error))
 	{
 		zbx_send_response_ext(sock, FAIL, error, NULL, flags, CONFIG_TIMEOUT);
 		zabbix_log(LOG_LEVEL_WARNING, "cannot collect configuration data for proxy \"%s\" at \"%s\": %s",
@@ -147,7 +152,7 @@ void	recv_proxyconfig(zbx_socket_t *sock, struct zbx_json_parse *jp)
 	if (SUCCEED != check_access_passive_proxy(sock, ZBX_SEND_RESPONSE, "configuration update"))
 		goto out;
 
-	process_proxyconfig(&jp_data);
+	process_proxyconfig(&jp_data, NULL);
 	zbx_send_proxy_response(sock, ret, NULL, CONFIG_TIMEOUT);
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -31,6 +31,7 @@ AC_DEFUN([CONF_TESTS],[
 		tests/libs/zbxdbhigh/Makefile
 		tests/libs/zbxeval/Makefile
 		tests/libs/zbxhistory/Makefile
+		tests/libs/zbxipcservice/Makefile
 		tests/libs/zbxjson/Makefile
 		tests/libs/zbxprometheus/Makefile
 		tests/libs/zbxregexp/Makefile
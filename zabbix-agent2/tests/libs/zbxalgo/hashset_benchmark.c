@@ -0,0 +1,177 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+/* Compares chained and open addressing hashsets. Memory usage is calculated as if the hashsets */
+/* were allocated in shared memory, where every allocation has two size fields of overhead.      */
+
+#define BENCH_ALLOC_OVERHEAD	(2 * sizeof(zbx_uint64_t))
+#define BENCH_HEADER_SIZE	(2 * sizeof(size_t))
+
+static size_t	bench_mem_used;
+
+static void	*bench_malloc(void *old, size_t size)
+{
+	size_t	*ptr;
+
+	ZBX_UNUSED(old);
+
+	ptr = (size_t *)zbx_malloc(NULL, size + BENCH_HEADER_SIZE);
+	*ptr = ZBX_SIZE_T_ALIGN8(size) + BENCH_ALLOC_OVERHEAD;
+	bench_mem_used += *ptr;
+
+	return (char *)ptr + BENCH_HEADER_SIZE;
+}
+
+static void	bench_free(void *ptr)
+{
+	size_t	*header;
+
+	if (NULL == ptr)
+		return;
+
+	header = (size_t *)((char *)ptr - BENCH_HEADER_SIZE);
+	bench_mem_used -= *header;
+	zbx_free(header);
+}
+
+static void	*bench_realloc(void *old, size_t size)
+{
+	size_t	*header;
+
+	if (NULL != old)
+	{
+		header = (size_t *)((char *)old - BENCH_HEADER_SIZE);
+		bench_mem_used -= *header;
+		old = header;
+	}
+
+	header = (size_t *)zbx_realloc(old, size + BENCH_HEADER_SIZE);
+	*header = ZBX_SIZE_T_ALIGN8(size) + BENCH_ALLOC_OVERHEAD;
+	bench_mem_used += *header;
+
+	return (char *)header + BENCH_HEADER_SIZE;
+}
+
+static zbx_uint64_t	bench_rand(zbx_uint64_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 7;
+	*seed ^= *seed << 17;
+
+	return *seed;
+}
+
+static void	bench_print(const char *name, int entries, size_t mem, int lookups, double time)
+{
+	printf("%-24s entries:%d bytes/entry:%.1f lookup:%.1f ns\n", name, entries, (double)mem / entries,
+			time * 1e9 / lookups);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_hashset_t	hs;
+	zbx_ohashset_t	ohs;
+	zbx_uint64_t	seed, *keys, *entry, found = 0, ofound = 0;
+	size_t		data_size, mem;
+	int		i, entries, lookups, *lookup_index;
+	char		*data;
+	double		time_start, time_hs, time_ohs;
+
+	ZBX_UNUSED(state);
+
+	entries = (int)zbx_mock_get_parameter_uint64("in.entries");
+	lookups = (int)zbx_mock_get_parameter_uint64("in.lookups");
+	data_size = (size_t)zbx_mock_get_parameter_uint64("in.data_size");
+	seed = zbx_mock_get_parameter_uint64("in.seed");
+
+	if (data_size < sizeof(zbx_uint64_t))
+		fail_msg("data size must fit the key");
+
+	data = (char *)zbx_malloc(NULL, data_size);
+	memset(data, 0, data_size);
+
+	/* every second lookup uses a key that is not in the hashsets */
+	keys = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * entries * 2);
+	for (i = 0; i < entries * 2; i++)
+		keys[i] = bench_rand(&seed);
+
+	lookup_index = (int *)zbx_malloc(NULL, sizeof(int) * lookups);
+	for (i = 0; i < lookups; i++)
+		lookup_index[i] = (int)(bench_rand(&seed) % (zbx_uint64_t)(entries * 2));
+
+	zbx_hashset_create_ext(&hs, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+			bench_malloc, bench_realloc, bench_free);
+
+	for (i = 0; i < entries; i++)
+	{
+		*(zbx_uint64_t *)data = keys[i];
+		zbx_hashset_insert(&hs, data, data_size);
+	}
+
+	mem = bench_mem_used;
+
+	time_start = zbx_time();
+	for (i = 0; i < lookups; i++)
+	{
+		if (NULL != (entry = (zbx_uint64_t *)zbx_hashset_search(&hs, &keys[lookup_index[i]])))
+			found += *entry;
+	}
+	time_hs = zbx_time() - time_start;
+
+	bench_print("hashset", entries, mem, lookups, time_hs);
+	zbx_hashset_destroy(&hs);
+
+	zbx_mock_assert_uint64_eq("released memory", 0, bench_mem_used);
+
+	zbx_ohashset_create_ext(&ohs, 0, data_size, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+			NULL, bench_malloc, bench_realloc, bench_free);
+
+	for (i = 0; i < entries; i++)
+	{
+		*(zbx_uint64_t *)data = keys[i];
+		zbx_ohashset_insert(&ohs, data, data_size);
+	}
+
+	mem = bench_mem_used;
+
+	time_start = zbx_time();
+	for (i = 0; i < lookups; i++)
+	{
+		if (NULL != (entry = (zbx_uint64_t *)zbx_ohashset_search(&ohs, &keys[lookup_index[i]])))
+			ofound += *entry;
+	}
+	time_ohs = zbx_time() - time_start;
+
+	bench_print("open addressing hashset", entries, mem, lookups, time_ohs);
+	zbx_ohashset_destroy(&ohs);
+
+	zbx_mock_assert_uint64_eq("released memory", 0, bench_mem_used);
+	zbx_mock_assert_uint64_eq("sum of found keys", found, ofound);
+
+	zbx_free(lookup_index);
+	zbx_free(keys);
+	zbx_free(data);
+}
@@ -0,0 +1,185 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+typedef struct
+{
+	zbx_uint64_t	key;
+	zbx_uint64_t	value;
+}
+ohs_entry_t;
+
+static zbx_hash_t	hash_mask;
+static int		clean_num;
+
+static zbx_hash_t	ohs_hash(const void *data)
+{
+	return ZBX_DEFAULT_UINT64_HASH_FUNC(data) & hash_mask;
+}
+
+static void	ohs_clean(void *data)
+{
+	ZBX_UNUSED(data);
+	clean_num++;
+}
+
+static zbx_uint64_t	ohs_rand(zbx_uint64_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 7;
+	*seed ^= *seed << 17;
+
+	return *seed;
+}
+
+/* check that open addressing hashset has exactly the same entries as the reference hashset */
+static void	ohs_compare(zbx_ohashset_t *ohs, zbx_hashset_t *hs)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_ohashset_iter_t	oiter;
+	ohs_entry_t		*entry, *oentry;
+	int			num = 0;
+
+	zbx_mock_assert_int_eq("number of entries", hs->num_data, ohs->num_data);
+
+	zbx_hashset_iter_reset(hs, &iter);
+	while (NULL != (entry = (ohs_entry_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (NULL == (oentry = (ohs_entry_t *)zbx_ohashset_search(ohs, entry)))
+			fail_msg("cannot find key " ZBX_FS_UI64, entry->key);
+
+		zbx_mock_assert_uint64_eq("entry value", entry->value, oentry->value);
+	}
+
+	zbx_ohashset_iter_reset(ohs, &oiter);
+	while (NULL != (oentry = (ohs_entry_t *)zbx_ohashset_iter_next(&oiter)))
+	{
+		if (NULL == zbx_hashset_search(hs, oentry))
+			fail_msg("unexpected key " ZBX_FS_UI64, oentry->key);
+		num++;
+	}
+
+	zbx_mock_assert_int_eq("number of iterated entries", hs->num_data, num);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_ohashset_t		ohs;
+	zbx_hashset_t		hs;
+	zbx_ohashset_iter_t	oiter;
+	ohs_entry_t		entry, *oentry;
+	zbx_uint64_t		seed, keys_num;
+	int			i, steps, removed = 0;
+
+	ZBX_UNUSED(state);
+
+	hash_mask = (zbx_hash_t)zbx_mock_get_parameter_uint64("in.hash_mask");
+	keys_num = zbx_mock_get_parameter_uint64("in.keys");
+	steps = (int)zbx_mock_get_parameter_uint64("in.steps");
+	seed = zbx_mock_get_parameter_uint64("in.seed");
+
+	zbx_hashset_create(&hs, 0, ohs_hash, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_ohashset_create_ext(&ohs, 0, sizeof(ohs_entry_t), ohs_hash, ZBX_DEFAULT_UINT64_COMPARE_FUNC, ohs_clean,
+			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	for (i = 0; i < steps; i++)
+	{
+		zbx_uint64_t	op = ohs_rand(&seed);
+
+		entry.key = ohs_rand(&seed) % keys_num;
+		entry.value = ohs_rand(&seed);
+
+		switch (op % 4)
+		{
+			case 0:
+				if (NULL == zbx_hashset_search(&hs, &entry))
+				{
+					zbx_ohashset_remove(&ohs, &entry);
+					break;
+				}
+				zbx_hashset_remove(&hs, &entry);
+
+				if (0 == (op & 4))
+				{
+					zbx_ohashset_remove(&ohs, &entry);
+				}
+				else
+				{
+					if (NULL == (oentry = (ohs_entry_t *)zbx_ohashset_search(&ohs, &entry)))
+						fail_msg("cannot find key " ZBX_FS_UI64 " to remove", entry.key);
+
+					zbx_ohashset_remove_direct(&ohs, oentry);
+				}
+				removed++;
+				break;
+			default:
+				if (NULL == (oentry = (ohs_entry_t *)zbx_ohashset_insert(&ohs, &entry, sizeof(entry))))
+					fail_msg("cannot insert key " ZBX_FS_UI64, entry.key);
+
+				oentry->value = ((ohs_entry_t *)zbx_hashset_insert(&hs, &entry, sizeof(entry)))->value;
+		}
+
+		if (0 == i % 1000)
+			ohs_compare(&ohs, &hs);
+	}
+
+	ohs_compare(&ohs, &hs);
+	zbx_mock_assert_int_eq("number of cleaned entries", removed, clean_num);
+
+	/* remove odd keys while iterating, every remaining entry must be visited exactly once */
+	zbx_ohashset_iter_reset(&ohs, &oiter);
+	while (NULL != (oentry = (ohs_entry_t *)zbx_ohashset_iter_next(&oiter)))
+	{
+		if (NULL == zbx_hashset_search(&hs, oentry))
+			fail_msg("key " ZBX_FS_UI64 " was already visited", oentry->key);
+
+		zbx_hashset_remove(&hs, oentry);
+
+		if (0 != (oentry->key & 1))
+		{
+			zbx_ohashset_iter_remove(&oiter);
+			removed++;
+		}
+	}
+
+	zbx_mock_assert_int_eq("number of unvisited entries", 0, hs.num_data);
+	zbx_mock_assert_int_eq("number of cleaned entries", removed, clean_num);
+
+	zbx_ohashset_iter_reset(&ohs, &oiter);
+	while (NULL != (oentry = (ohs_entry_t *)zbx_ohashset_iter_next(&oiter)))
+	{
+		if (0 != (oentry->key & 1))
+			fail_msg("key " ZBX_FS_UI64 " was not removed", oentry->key);
+
+		zbx_hashset_insert(&hs, oentry, sizeof(ohs_entry_t));
+	}
+
+	ohs_compare(&ohs, &hs);
+
+	zbx_ohashset_destroy(&ohs);
+	zbx_mock_assert_int_eq("number of cleaned entries", removed + hs.num_data, clean_num);
+
+	zbx_hashset_destroy(&hs);
+}
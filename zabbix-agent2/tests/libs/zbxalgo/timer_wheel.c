@@ -0,0 +1,140 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+#define TIMER_WHEEL_TEST_KEYS	100
+
+typedef struct
+{
+	zbx_uint64_t	key;
+	int		time;
+}
+tw_elem_t;
+
+static tw_elem_t	elems[TIMER_WHEEL_TEST_KEYS];
+
+static int	tw_elem_compare(const void *d1, const void *d2)
+{
+	const tw_elem_t	*e1 = (const tw_elem_t *)((const zbx_binary_heap_elem_t *)d1)->data;
+	const tw_elem_t	*e2 = (const tw_elem_t *)((const zbx_binary_heap_elem_t *)d2)->data;
+
+	ZBX_RETURN_IF_NOT_EQUAL(e1->time, e2->time);
+	ZBX_RETURN_IF_NOT_EQUAL(e1->key, e2->key);
+
+	return 0;
+}
+
+static tw_elem_t	*tw_get_elem(zbx_mock_handle_t hstep)
+{
+	zbx_uint64_t	key;
+
+	if (TIMER_WHEEL_TEST_KEYS <= (key = zbx_mock_get_object_member_uint64(hstep, "key")))
+		fail_msg("key " ZBX_FS_UI64 " is out of range", key);
+
+	elems[key].key = key;
+
+	return &elems[key];
+}
+
+static void	tw_pop_ready(zbx_timer_wheel_t *wheel, zbx_mock_handle_t hkeys)
+{
+	zbx_mock_handle_t	hkey;
+	zbx_binary_heap_elem_t	*min;
+	zbx_uint64_t		key;
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hkeys, &hkey))
+	{
+		if (ZBX_MOCK_SUCCESS != zbx_mock_uint64(hkey, &key))
+			fail_msg("cannot read expected key");
+
+		if (NULL == (min = zbx_timer_wheel_find_min(wheel)))
+			fail_msg("expected key " ZBX_FS_UI64 " but ready heap is empty", key);
+
+		zbx_mock_assert_uint64_eq("ready element key", key, min->key);
+		zbx_timer_wheel_remove_min(wheel);
+	}
+
+	zbx_mock_assert_ptr_eq("ready element", NULL, zbx_timer_wheel_find_min(wheel));
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_timer_wheel_t	wheel;
+	zbx_mock_handle_t	hsteps, hstep;
+	zbx_binary_heap_elem_t	elem;
+	tw_elem_t		*tw_elem;
+	const char		*op;
+
+	ZBX_UNUSED(state);
+
+	zbx_timer_wheel_create(&wheel, tw_elem_compare);
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hsteps, &hstep))
+	{
+		op = zbx_mock_get_object_member_string(hstep, "op");
+
+		if (0 == strcmp(op, "insert") || 0 == strcmp(op, "update"))
+		{
+			tw_elem = tw_get_elem(hstep);
+			tw_elem->time = zbx_mock_get_object_member_int(hstep, "time");
+
+			elem.key = tw_elem->key;
+			elem.data = tw_elem;
+
+			if ('i' == *op)
+				zbx_timer_wheel_insert(&wheel, &elem, tw_elem->time);
+			else
+				zbx_timer_wheel_update(&wheel, &elem, tw_elem->time);
+		}
+		else if (0 == strcmp(op, "remove"))
+		{
+			zbx_timer_wheel_remove(&wheel, tw_get_elem(hstep)->key);
+		}
+		else if (0 == strcmp(op, "advance"))
+		{
+			zbx_timer_wheel_advance(&wheel, zbx_mock_get_object_member_int(hstep, "now"));
+		}
+		else if (0 == strcmp(op, "pop"))
+		{
+			tw_pop_ready(&wheel, zbx_mock_get_object_member_handle(hstep, "keys"));
+		}
+		else if (0 == strcmp(op, "min"))
+		{
+			zbx_mock_assert_int_eq("minimum time", zbx_mock_get_object_member_int(hstep, "time"),
+					zbx_timer_wheel_min_time(&wheel));
+		}
+		else if (0 == strcmp(op, "count"))
+		{
+			zbx_mock_assert_int_eq("number of elements", zbx_mock_get_object_member_int(hstep, "num"),
+					zbx_timer_wheel_elems_num(&wheel));
+		}
+		else
+			fail_msg("unknown operation \"%s\"", op);
+	}
+
+	zbx_timer_wheel_destroy(&wheel);
+}
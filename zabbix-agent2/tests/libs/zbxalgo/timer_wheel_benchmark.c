@@ -0,0 +1,254 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+/* Compares binary heap and timer wheel used as poller queue. Polling is simulated second by second:  */
+/* due items are taken from the queue and requeued with their interval, then the specified share of   */
+/* items is rescheduled like after configuration changes. Only the simulation is timed.               */
+
+typedef struct
+{
+	zbx_uint64_t	key;
+	int		nextcheck;
+	int		interval;
+}
+bench_item_t;
+
+typedef struct
+{
+	int		items_num;
+	int		interval_min;
+	int		interval_max;
+	int		seconds;
+	int		reschedules;
+	zbx_uint64_t	seed;
+}
+bench_params_t;
+
+static zbx_uint64_t	bench_rand(zbx_uint64_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 7;
+	*seed ^= *seed << 17;
+
+	return *seed;
+}
+
+static int	bench_item_compare(const void *d1, const void *d2)
+{
+	const bench_item_t	*i1 = (const bench_item_t *)((const zbx_binary_heap_elem_t *)d1)->data;
+	const bench_item_t	*i2 = (const bench_item_t *)((const zbx_binary_heap_elem_t *)d2)->data;
+
+	ZBX_RETURN_IF_NOT_EQUAL(i1->nextcheck, i2->nextcheck);
+	ZBX_RETURN_IF_NOT_EQUAL(i1->key, i2->key);
+
+	return 0;
+}
+
+static void	bench_init_items(bench_item_t *items, const bench_params_t *params, zbx_uint64_t *seed)
+{
+	int	i;
+
+	*seed = params->seed;
+
+	for (i = 0; i < params->items_num; i++)
+	{
+		items[i].key = (zbx_uint64_t)i + 1;
+		items[i].interval = params->interval_min + (int)(bench_rand(seed) %
+				(zbx_uint64_t)(params->interval_max - params->interval_min + 1));
+		items[i].nextcheck = (int)(bench_rand(seed) % (zbx_uint64_t)items[i].interval);
+	}
+}
+
+static bench_item_t	*bench_reschedule_item(bench_item_t *items, const bench_params_t *params, int now,
+		zbx_uint64_t *seed)
+{
+	bench_item_t	*item;
+
+	item = &items[bench_rand(seed) % (zbx_uint64_t)params->items_num];
+	item->nextcheck = now + 1 + (int)(bench_rand(seed) % (zbx_uint64_t)item->interval);
+
+	return item;
+}
+
+static void	bench_print(const char *name, const bench_params_t *params, zbx_uint64_t ops, double time)
+{
+	printf("%-12s items:%d operations:" ZBX_FS_UI64 " time:%.3f s per operation:%.1f ns\n", name,
+			params->items_num, ops, time, time * 1e9 / (double)ops);
+}
+
+static zbx_uint64_t	bench_binary_heap(bench_item_t *items, const bench_params_t *params, zbx_uint64_t *checksum)
+{
+	zbx_binary_heap_t	heap;
+	zbx_binary_heap_elem_t	elem, *min;
+	bench_item_t		*item;
+	zbx_uint64_t		seed, ops = 0;
+	int			i, now;
+	double			time_start;
+
+	bench_init_items(items, params, &seed);
+
+	zbx_binary_heap_create(&heap, bench_item_compare, ZBX_BINARY_HEAP_OPTION_DIRECT);
+
+	for (i = 0; i < params->items_num; i++)
+	{
+		elem.key = items[i].key;
+		elem.data = (const void *)&items[i];
+		zbx_binary_heap_insert(&heap, &elem);
+	}
+
+	time_start = zbx_time();
+
+	for (now = 0; now < params->seconds; now++)
+	{
+		while (FAIL == zbx_binary_heap_empty(&heap))
+		{
+			min = zbx_binary_heap_find_min(&heap);
+			item = (bench_item_t *)min->data;
+
+			if (item->nextcheck > now)
+				break;
+
+			zbx_binary_heap_remove_min(&heap);
+
+			*checksum += item->key * (zbx_uint64_t)(now + 1);
+			item->nextcheck += item->interval;
+
+			elem.key = item->key;
+			elem.data = (const void *)item;
+			zbx_binary_heap_insert(&heap, &elem);
+			ops += 2;
+		}
+
+		for (i = 0; i < params->reschedules; i++)
+		{
+			item = bench_reschedule_item(items, params, now, &seed);
+
+			elem.key = item->key;
+			elem.data = (const void *)item;
+			zbx_binary_heap_update_direct(&heap, &elem);
+			ops++;
+		}
+	}
+
+	bench_print("binary heap", params, ops, zbx_time() - time_start);
+
+	zbx_binary_heap_destroy(&heap);
+
+	return ops;
+}
+
+static zbx_uint64_t	bench_timer_wheel(bench_item_t *items, const bench_params_t *params, zbx_uint64_t *checksum)
+{
+	zbx_timer_wheel_t	wheel;
+	zbx_binary_heap_elem_t	elem, *min;
+	bench_item_t		*item;
+	zbx_uint64_t		seed, ops = 0;
+	int			i, now;
+	double			time_start;
+
+	bench_init_items(items, params, &seed);
+
+	zbx_timer_wheel_create(&wheel, bench_item_compare);
+
+	for (i = 0; i < params->items_num; i++)
+	{
+		elem.key = items[i].key;
+		elem.data = (const void *)&items[i];
+		zbx_timer_wheel_insert(&wheel, &elem, items[i].nextcheck);
+	}
+
+	time_start = zbx_time();
+
+	for (now = 0; now < params->seconds; now++)
+	{
+		zbx_timer_wheel_advance(&wheel, now);
+
+		while (NULL != (min = zbx_timer_wheel_find_min(&wheel)))
+		{
+			item = (bench_item_t *)min->data;
+
+			if (item->nextcheck > now)
+				break;
+
+			zbx_timer_wheel_remove_min(&wheel);
+
+			*checksum += item->key * (zbx_uint64_t)(now + 1);
+			item->nextcheck += item->interval;
+
+			elem.key = item->key;
+			elem.data = (const void *)item;
+			zbx_timer_wheel_insert(&wheel, &elem, item->nextcheck);
+			ops += 2;
+		}
+
+		for (i = 0; i < params->reschedules; i++)
+		{
+			item = bench_reschedule_item(items, params, now, &seed);
+
+			elem.key = item->key;
+			elem.data = (const void *)item;
+			zbx_timer_wheel_update(&wheel, &elem, item->nextcheck);
+			ops++;
+		}
+	}
+
+	bench_print("timer wheel", params, ops, zbx_time() - time_start);
+
+	zbx_timer_wheel_destroy(&wheel);
+
+	return ops;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	bench_params_t	params;
+	bench_item_t	*items;
+	zbx_uint64_t	ops_heap, ops_wheel, checksum_heap = 0, checksum_wheel = 0;
+
+	ZBX_UNUSED(state);
+
+	params.items_num = (int)zbx_mock_get_parameter_uint64("in.items");
+	params.interval_min = (int)zbx_mock_get_parameter_uint64("in.interval_min");
+	params.interval_max = (int)zbx_mock_get_parameter_uint64("in.interval_max");
+	params.seconds = (int)zbx_mock_get_parameter_uint64("in.seconds");
+	params.reschedules = (int)((zbx_uint64_t)params.items_num *
+			zbx_mock_get_parameter_uint64("in.reschedule_permille") / 1000);
+	params.seed = zbx_mock_get_parameter_uint64("in.seed");
+
+	if (0 >= params.interval_min || params.interval_min > params.interval_max)
+		fail_msg("invalid item interval range");
+
+	items = (bench_item_t *)zbx_malloc(NULL, sizeof(bench_item_t) * (size_t)params.items_num);
+
+	ops_heap = bench_binary_heap(items, &params, &checksum_heap);
+	ops_wheel = bench_timer_wheel(items, &params, &checksum_wheel);
+
+	/* both queues must return the same items at the same time */
+	zbx_mock_assert_uint64_eq("number of operations", ops_heap, ops_wheel);
+	zbx_mock_assert_uint64_eq("checksum of due items", checksum_heap, checksum_wheel);
+
+	zbx_free(items);
+}
@@ -0,0 +1,165 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "log.h"
+#include "comms.h"
+#include "zbxcompress.h"
+
+/* the chunk size used by zbx_tcp_send_ext() to compress data */
+#define MOCK_CHUNK_SIZE	(64 * ZBX_KIBIBYTE)
+
+/* fills buffer with text that compresses well or with pseudo-random bytes that do not compress */
+static char	*mock_get_data(size_t size, const char *content)
+{
+	char		*data;
+	size_t		i;
+	zbx_uint32_t	seed = 1;
+
+	data = (char *)zbx_malloc(NULL, size + 1);
+
+	if (0 == strcmp(content, "text"))
+	{
+		for (i = 0; i < size; i++)
+			data[i] = "{\"host\":\"Zabbix server\",\"key\":\"system.cpu.load\"}"[i % 48];
+	}
+	else if (0 == strcmp(content, "random"))
+	{
+		for (i = 0; i < size; i++)
+		{
+			seed = seed * 1103515245 + 12345;
+			data[i] = (char)(seed >> 16);
+		}
+	}
+	else
+		fail_msg("unknown data content \"%s\"", content);
+
+	data[size] = '\0';
+
+	return data;
+}
+
+/* checks that compressed chunks are filled completely and uncompress into the original data */
+static void	mock_check_chunks(const char *data, size_t size)
+{
+	zbx_vector_ptr_t	chunks;
+	size_t			size_out, out_size = size;
+	char			*compressed, *out;
+	int			i;
+
+	zbx_vector_ptr_create(&chunks);
+
+	zbx_mock_assert_result_eq("zbx_compress_chunks() return value", SUCCEED,
+			zbx_compress_chunks(data, size, MOCK_CHUNK_SIZE, &chunks, &size_out));
+
+	zbx_mock_assert_int_eq("number of chunks", (int)((size_out + MOCK_CHUNK_SIZE - 1) / MOCK_CHUNK_SIZE),
+			chunks.values_num);
+
+	compressed = (char *)zbx_malloc(NULL, (size_t)chunks.values_num * MOCK_CHUNK_SIZE);
+
+	for (i = 0; i < chunks.values_num; i++)
+		memcpy(compressed + (size_t)i * MOCK_CHUNK_SIZE, chunks.values[i], MOCK_CHUNK_SIZE);
+
+	out = (char *)zbx_malloc(NULL, size + 1);
+
+	zbx_mock_assert_result_eq("zbx_uncompress() return value", SUCCEED,
+			zbx_uncompress(compressed, size_out, out, &out_size));
+	zbx_mock_assert_uint64_eq("uncompressed data size", size, out_size);
+
+	if (0 != memcmp(data, out, size))
+		fail_msg("uncompressed data does not match the original data");
+
+	zbx_free(out);
+	zbx_free(compressed);
+	zbx_vector_ptr_clear_ext(&chunks, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&chunks);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	int		fds[2], status;
+	pid_t		pid;
+	size_t		size;
+	char		*data;
+	unsigned char	flags = ZBX_TCP_PROTOCOL;
+	zbx_socket_t	s;
+	ssize_t		received;
+
+	ZBX_UNUSED(state);
+
+	size = (size_t)zbx_mock_get_parameter_uint64("in.size");
+	data = mock_get_data(size, zbx_mock_get_parameter_string("in.content"));
+
+	if (0 == strcmp(zbx_mock_get_parameter_string("in.compress"), "yes"))
+	{
+		flags |= ZBX_TCP_COMPRESS;
+		mock_check_chunks(data, size);
+	}
+
+	if (-1 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+		fail_msg("cannot create socket pair: %s", zbx_strerror(errno));
+
+	/* the sender runs in a child process, so messages larger than socket buffer can be sent */
+	if (-1 == (pid = fork()))
+		fail_msg("cannot fork process: %s", zbx_strerror(errno));
+
+	if (0 == pid)
+	{
+		close(fds[0]);
+		memset(&s, 0, sizeof(s));
+		s.socket = fds[1];
+
+		_exit(SUCCEED == zbx_tcp_send_ext(&s, data, size, 0, flags, 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	close(fds[1]);
+	memset(&s, 0, sizeof(s));
+	s.socket = fds[0];
+
+	zbx_mock_read_passthrough(fds[0]);
+	received = zbx_tcp_recv_ext(&s, 0, 0);
+	zbx_mock_read_passthrough(-1);
+
+	/* unblock the sender if the message was not received completely */
+	close(fds[0]);
+
+	if (pid != waitpid(pid, &status, 0))
+		fail_msg("cannot wait for process: %s", zbx_strerror(errno));
+
+	if (FAIL == received)
+		fail_msg("zbx_tcp_recv_ext() failed: %s", zbx_socket_strerror());
+
+	zbx_mock_assert_int_eq("sender exit status", EXIT_SUCCESS, WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+
+	zbx_mock_assert_int_eq("received protocol flags", flags, s.protocol);
+	zbx_mock_assert_uint64_eq("received data size", size, s.read_bytes);
+
+	if (0 != memcmp(data, s.buffer, size))
+		fail_msg("received data does not match the sent data");
+
+	if (ZBX_BUF_TYPE_DYN == s.buf_type)
+		zbx_free(s.buffer);
+
+	zbx_free(data);
+}
@@ -0,0 +1,187 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "log.h"
+#include "mutexs.h"
+#include "dbcache.h"
+#include "dc_flush_history_test.h"
+
+/* Runs steps adding values from the test process and forked processes through history cache ingestion */
+/* rings and checks ring ownership, draining and falling back to the locked path when ring is full.     */
+/* Values of the test process item are increasing numbers, so their order in history cache is checked.  */
+
+#define MOCK_ITEMID		1
+#define MOCK_CHILD_ITEMID	1000
+
+extern unsigned char	program_type;
+extern zbx_uint64_t	CONFIG_HISTORY_CACHE_SIZE;
+extern zbx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE;
+
+static zbx_uint64_t	mock_value = 0;
+
+static void	mock_add_values(zbx_uint64_t itemid, int values_num, zbx_uint64_t *value)
+{
+	int		i;
+	AGENT_RESULT	result;
+	zbx_timespec_t	ts;
+
+	for (i = 0; i < values_num; i++)
+	{
+		init_result(&result);
+		SET_UI64_RESULT(&result, ++(*value));
+
+		ts.sec = 1000000000 + (int)*value;
+		ts.ns = 0;
+
+		dc_add_history(itemid, ITEM_VALUE_TYPE_UINT64, 0, &result, &ts, ITEM_STATE_NORMAL, NULL);
+		free_result(&result);
+	}
+
+	dc_flush_history();
+}
+
+static void	mock_fork_processes(int processes_num, int values_num)
+{
+	int	i, status;
+	pid_t	pid;
+
+	for (i = 0; i < processes_num; i++)
+	{
+		if (-1 == (pid = fork()))
+			fail_msg("cannot fork process: %s", zbx_strerror(errno));
+
+		if (0 == pid)
+		{
+			zbx_uint64_t	value = 0;
+
+			mock_add_values(MOCK_CHILD_ITEMID + (zbx_uint64_t)i, values_num, &value);
+			_exit(EXIT_SUCCESS);
+		}
+
+		if (pid != waitpid(pid, &status, 0))
+			fail_msg("cannot wait for process: %s", zbx_strerror(errno));
+
+		if (0 == WIFEXITED(status) || EXIT_SUCCESS != WEXITSTATUS(status))
+			fail_msg("process terminated with status %d", status);
+	}
+}
+
+static int	mock_get_flag(zbx_mock_handle_t handle, const char *name)
+{
+	return 0 == strcmp(zbx_mock_get_object_member_string(handle, name), "yes") ? SUCCEED : FAIL;
+}
+
+static void	mock_check(zbx_mock_handle_t hstep, const char *prefix)
+{
+	zbx_mock_handle_t	hvalue;
+	zbx_vector_uint64_t	values;
+	char			msg[MAX_STRING_LEN];
+	int			i;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "owned", &hvalue))
+	{
+		zbx_snprintf(msg, sizeof(msg), "%s: ring owned", prefix);
+		zbx_mock_assert_result_eq(msg, mock_get_flag(hstep, "owned"), hc_ring_owned_test());
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "pending", &hvalue))
+	{
+		zbx_snprintf(msg, sizeof(msg), "%s: values pending in rings", prefix);
+		zbx_mock_assert_result_eq(msg, mock_get_flag(hstep, "pending"), hc_rings_pending_test());
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "free", &hvalue))
+	{
+		zbx_snprintf(msg, sizeof(msg), "%s: free rings", prefix);
+		zbx_mock_assert_int_eq(msg, zbx_mock_get_object_member_int(hstep, "free"), hc_rings_free_test());
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "cached", &hvalue))
+	{
+		zbx_snprintf(msg, sizeof(msg), "%s: values in history cache", prefix);
+		zbx_mock_assert_int_eq(msg, zbx_mock_get_object_member_int(hstep, "cached"),
+				hc_get_history_num_test());
+	}
+
+	/* values of the test process item must be queued in the order they were added */
+	zbx_vector_uint64_create(&values);
+	hc_get_item_values_test(MOCK_ITEMID, &values);
+
+	for (i = 0; i < values.values_num; i++)
+	{
+		zbx_snprintf(msg, sizeof(msg), "%s: value #%d", prefix, i);
+		zbx_mock_assert_uint64_eq(msg, (zbx_uint64_t)i + 1, values.values[i]);
+	}
+
+	zbx_vector_uint64_destroy(&values);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	char			*error = NULL, prefix[MAX_STRING_LEN];
+	const char		*action;
+	zbx_mock_handle_t	hsteps, hstep;
+	int			step = 0;
+
+	ZBX_UNUSED(state);
+
+	program_type = ZBX_PROGRAM_TYPE_PROXY;
+	CONFIG_HISTORY_CACHE_SIZE = zbx_mock_get_parameter_uint64("in.cache_size");
+	CONFIG_HISTORY_INDEX_CACHE_SIZE = 4 * ZBX_MEBIBYTE;
+
+	zbx_mock_assert_result_eq("Lock initialization failed", SUCCEED, zbx_locks_create(&error));
+	zbx_mock_assert_result_eq("History cache initialization failed", SUCCEED, init_database_cache(&error));
+
+	/* ingestion rings are not available without atomic memory access builtins */
+	if (0 == hc_rings_num_test())
+	{
+		free_database_cache(ZBX_SYNC_NONE);
+		skip();
+	}
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hsteps, &hstep))
+	{
+		action = zbx_mock_get_object_member_string(hstep, "action");
+		zbx_snprintf(prefix, sizeof(prefix), "step #%d %s", ++step, action);
+
+		if (0 == strcmp(action, "add"))
+			mock_add_values(MOCK_ITEMID, zbx_mock_get_object_member_int(hstep, "values"), &mock_value);
+		else if (0 == strcmp(action, "fork"))
+		{
+			mock_fork_processes(zbx_mock_get_object_member_int(hstep, "processes"),
+					zbx_mock_get_object_member_int(hstep, "values"));
+		}
+		else if (0 == strcmp(action, "drain"))
+			hc_drain_rings_test();
+		else if (0 != strcmp(action, "check"))
+			fail_msg("unknown action \"%s\"", action);
+
+		mock_check(hstep, prefix);
+	}
+
+	free_database_cache(ZBX_SYNC_NONE);
+}
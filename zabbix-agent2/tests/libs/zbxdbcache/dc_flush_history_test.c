@@ -0,0 +1,101 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "dc_flush_history_test.h"
+
+int	hc_rings_num_test(void)
+{
+	return cache->rings_num;
+}
+
+/* returns the number of rings not claimed by any process */
+int	hc_rings_free_test(void)
+{
+	int	i, free_num = 0;
+
+	for (i = 0; i < cache->rings_num; i++)
+	{
+		if (0 == cache->rings[i].owner)
+			free_num++;
+	}
+
+	return free_num;
+}
+
+/* checks if the current process owns a ring */
+int	hc_ring_owned_test(void)
+{
+	int	i;
+	pid_t	pid = getpid();
+
+	for (i = 0; i < cache->rings_num; i++)
+	{
+		if (pid == cache->rings[i].owner)
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
+int	hc_rings_pending_test(void)
+{
+	int	ret;
+
+	LOCK_CACHE;
+	ret = hc_rings_pending();
+	UNLOCK_CACHE;
+
+	return ret;
+}
+
+/* drains rings the same way as history syncer does before popping items */
+void	hc_drain_rings_test(void)
+{
+	LOCK_CACHE;
+	hc_drain_rings();
+	UNLOCK_CACHE;
+}
+
+int	hc_get_history_num_test(void)
+{
+	int	history_num;
+
+	LOCK_CACHE;
+	history_num = cache->history_num;
+	UNLOCK_CACHE;
+
+	return history_num;
+}
+
+/* returns unsigned integer values of the item in the order they are queued in history cache */
+void	hc_get_item_values_test(zbx_uint64_t itemid, zbx_vector_uint64_t *values)
+{
+	zbx_hc_item_t	*item;
+	zbx_hc_data_t	*data;
+
+	LOCK_CACHE;
+
+	if (NULL != (item = hc_get_item(itemid)))
+	{
+		for (data = item->tail; NULL != data; data = data->next)
+			zbx_vector_uint64_append(values, data->value.ui64);
+	}
+
+	UNLOCK_CACHE;
+}
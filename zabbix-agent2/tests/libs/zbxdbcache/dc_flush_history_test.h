@@ -0,0 +1,31 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef DC_FLUSH_HISTORY_TEST_H
+#define DC_FLUSH_HISTORY_TEST_H
+
+int	hc_rings_num_test(void);
+int	hc_rings_free_test(void);
+int	hc_ring_owned_test(void);
+int	hc_rings_pending_test(void);
+void	hc_drain_rings_test(void);
+int	hc_get_history_num_test(void);
+void	hc_get_item_values_test(zbx_uint64_t itemid, zbx_vector_uint64_t *values);
+
+#endif /* DC_FLUSH_HISTORY_TEST_H */
@@ -0,0 +1,275 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "mutexs.h"
+#include "dbcache.h"
+#include "dc_item_index_test.h"
+
+/* Adds items to configuration cache and compares item candidates found in the configuration cache item */
+/* indexes with candidates found by scanning all items. The items are then partially removed and moved  */
+/* to other keys to check that the indexes are updated.                                                 */
+
+extern zbx_uint64_t	CONFIG_CONF_CACHE_SIZE;
+
+typedef struct
+{
+	zbx_uint64_t	hostid;
+	const char	*key;
+}
+dc_test_item_t;
+
+static zbx_uint64_t	dc_rand(zbx_uint64_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 7;
+	*seed ^= *seed << 17;
+
+	return *seed;
+}
+
+static int	dc_match_key(const char *item_key, const AGENT_REQUEST *pattern)
+{
+	AGENT_REQUEST	key;
+	int		i, ret = FAIL;
+
+	init_request(&key);
+
+	if (SUCCEED == parse_item_key(item_key, &key) && 0 == strcmp(key.key, pattern->key) &&
+			key.nparam == pattern->nparam)
+	{
+		for (i = 0; i < key.nparam; i++)
+		{
+			if (0 != strcmp(pattern->params[i], "*") && 0 != strcmp(pattern->params[i], key.params[i]))
+				break;
+		}
+
+		if (i == key.nparam)
+			ret = SUCCEED;
+	}
+
+	free_request(&key);
+
+	return ret;
+}
+
+/* finds item candidates by scanning all items */
+static void	dc_scan_item_candidates(const dc_test_item_t *items, int items_num, const zbx_vector_uint64_t *hostids,
+		const char *key, const AGENT_REQUEST *pattern, zbx_vector_uint64_pair_t *itemhosts)
+{
+	int			i;
+	zbx_uint64_pair_t	pair;
+
+	for (i = 0; i < items_num; i++)
+	{
+		if (NULL == items[i].key)
+			continue;
+
+		if (NULL != hostids && FAIL == zbx_vector_uint64_bsearch(hostids, items[i].hostid,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+		{
+			continue;
+		}
+
+		if (NULL != key && 0 != strcmp(items[i].key, key))
+			continue;
+
+		if (NULL != pattern && SUCCEED != dc_match_key(items[i].key, pattern))
+			continue;
+
+		pair.first = (zbx_uint64_t)i + 1;
+		pair.second = items[i].hostid;
+		zbx_vector_uint64_pair_append(itemhosts, pair);
+	}
+}
+
+static void	dc_compare_item_candidates(zbx_vector_uint64_pair_t *expected, zbx_vector_uint64_pair_t *returned)
+{
+	int	i;
+
+	zbx_vector_uint64_pair_sort(expected, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_pair_sort(returned, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_mock_assert_int_eq("number of item candidates", expected->values_num, returned->values_num);
+
+	for (i = 0; i < expected->values_num; i++)
+	{
+		zbx_mock_assert_uint64_eq("itemid", expected->values[i].first, returned->values[i].first);
+		zbx_mock_assert_uint64_eq("hostid", expected->values[i].second, returned->values[i].second);
+	}
+}
+
+static void	dc_check_item_candidates(const dc_test_item_t *items, int items_num, const zbx_vector_uint64_t *hostids,
+		const char *key, const AGENT_REQUEST *pattern, int lookups)
+{
+	zbx_vector_uint64_pair_t	expected, returned;
+	int				i;
+	double				time_start, time_index, time_scan;
+
+	zbx_vector_uint64_pair_create(&expected);
+	zbx_vector_uint64_pair_create(&returned);
+
+	time_start = zbx_time();
+	for (i = 0; i < lookups; i++)
+	{
+		zbx_vector_uint64_pair_clear(&expected);
+		dc_scan_item_candidates(items, items_num, hostids, key, pattern, &expected);
+	}
+	time_scan = zbx_time() - time_start;
+
+	time_start = zbx_time();
+	for (i = 0; i < lookups; i++)
+	{
+		zbx_vector_uint64_pair_clear(&returned);
+		zbx_dc_get_item_candidates(hostids, key, pattern, &returned);
+	}
+	time_index = zbx_time() - time_start;
+
+	printf("items:%d candidates:%d scan:%.1f us index:%.1f us\n", items_num, returned.values_num,
+			time_scan * 1e6 / lookups, time_index * 1e6 / lookups);
+
+	dc_compare_item_candidates(&expected, &returned);
+
+	zbx_vector_uint64_pair_destroy(&returned);
+	zbx_vector_uint64_pair_destroy(&expected);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	char			*error = NULL;
+	const char		*key_param, *pattern_param, **keys = NULL, *key = NULL;
+	int			i, hosts_num, keys_num = 0, keys_alloc = 0, items_num, lookups, remove, query_hosts;
+	zbx_uint64_t		seed, items_expected;
+	zbx_mock_handle_t	hkeys, hkey;
+	zbx_mock_error_t	err;
+	zbx_vector_uint64_t	hostids;
+	zbx_vector_uint64_pair_t	itemhosts;
+	AGENT_REQUEST		pattern, *ppattern = NULL;
+	dc_test_item_t		*items;
+
+	ZBX_UNUSED(state);
+
+	hosts_num = (int)zbx_mock_get_parameter_uint64("in.hosts");
+	query_hosts = (int)zbx_mock_get_parameter_uint64("in.query_hosts");
+	key_param = zbx_mock_get_parameter_string("in.key");
+	pattern_param = zbx_mock_get_parameter_string("in.pattern");
+	lookups = (int)zbx_mock_get_parameter_uint64("in.lookups");
+	remove = (int)zbx_mock_get_parameter_uint64("in.remove");
+	seed = zbx_mock_get_parameter_uint64("in.seed");
+	items_expected = zbx_mock_get_parameter_uint64("out.items");
+
+	hkeys = zbx_mock_get_parameter_handle("in.keys");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hkeys, &hkey)))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hkey, &key)))
+			fail_msg("Cannot read item key: %s", zbx_mock_error_string(err));
+
+		if (keys_num == keys_alloc)
+		{
+			keys_alloc += 8;
+			keys = (const char **)zbx_realloc(keys, sizeof(const char *) * keys_alloc);
+		}
+
+		keys[keys_num++] = key;
+	}
+
+	key = ('\0' != *key_param ? key_param : NULL);
+
+	init_request(&pattern);
+
+	if ('\0' != *pattern_param)
+	{
+		if (SUCCEED != parse_item_key(pattern_param, &pattern))
+			fail_msg("Cannot parse item key pattern \"%s\"", pattern_param);
+
+		ppattern = &pattern;
+	}
+
+	CONFIG_CONF_CACHE_SIZE = 256 * ZBX_MEBIBYTE;
+
+	zbx_mock_assert_result_eq("Lock initialization failed", SUCCEED, zbx_locks_create(&error));
+	zbx_mock_assert_result_eq("Configuration cache initialization failed", SUCCEED,
+			init_configuration_cache(&error));
+
+	/* every host has items with all keys */
+	items_num = hosts_num * keys_num;
+	items = (dc_test_item_t *)zbx_malloc(NULL, sizeof(dc_test_item_t) * items_num);
+
+	for (i = 0; i < items_num; i++)
+	{
+		items[i].hostid = (zbx_uint64_t)(i / keys_num) + 1;
+		items[i].key = keys[i % keys_num];
+		dc_item_index_add_test((zbx_uint64_t)i + 1, items[i].hostid, items[i].key);
+	}
+
+	zbx_vector_uint64_create(&hostids);
+
+	for (i = 0; i < query_hosts; i++)
+		zbx_vector_uint64_append(&hostids, (zbx_uint64_t)i + 1);
+
+	zbx_vector_uint64_pair_create(&itemhosts);
+	zbx_dc_get_item_candidates(0 != query_hosts ? &hostids : NULL, key, ppattern, &itemhosts);
+	zbx_mock_assert_uint64_eq("number of item candidates", items_expected, (zbx_uint64_t)itemhosts.values_num);
+	zbx_vector_uint64_pair_destroy(&itemhosts);
+
+	dc_check_item_candidates(items, items_num, 0 != query_hosts ? &hostids : NULL, key, ppattern, lookups);
+
+	/* remove random items and move other random items to different host and key */
+	for (i = 0; i < remove; i++)
+	{
+		int	index = (int)(dc_rand(&seed) % (zbx_uint64_t)items_num);
+
+		if (0 == (i & 1))
+		{
+			dc_item_index_remove_test((zbx_uint64_t)index + 1);
+			items[index].key = NULL;
+			continue;
+		}
+
+		if (NULL == items[index].key)
+			continue;
+
+		/* keys are unique within a host, so every moved item gets its own host */
+		items[index].hostid = (zbx_uint64_t)(hosts_num + index) + 1;
+		items[index].key = keys[dc_rand(&seed) % (zbx_uint64_t)keys_num];
+		dc_item_index_add_test((zbx_uint64_t)index + 1, items[index].hostid, items[index].key);
+	}
+
+	dc_check_item_candidates(items, items_num, 0 != query_hosts ? &hostids : NULL, key, ppattern, 1);
+
+	for (i = 0; i < hosts_num * 2; i += 2)
+		zbx_vector_uint64_append(&hostids, (zbx_uint64_t)i + 1);
+
+	zbx_vector_uint64_sort(&hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	dc_check_item_candidates(items, items_num, &hostids, key, ppattern, 1);
+
+	zbx_vector_uint64_destroy(&hostids);
+	free_request(&pattern);
+	zbx_free(items);
+	zbx_free(keys);
+
+	free_configuration_cache();
+}
@@ -0,0 +1,86 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "dc_item_index_test.h"
+
+/* adds or updates item in configuration cache the same way as DCsync_items() updates item indexes */
+void	dc_item_index_add_test(zbx_uint64_t itemid, zbx_uint64_t hostid, const char *key)
+{
+	ZBX_DC_ITEM	*item;
+	ZBX_DC_ITEM_HK	*item_hk, item_hk_local;
+	int		found;
+
+	WRLOCK_CACHE;
+
+	item = (ZBX_DC_ITEM *)DCfind_id(&config->items, itemid, sizeof(ZBX_DC_ITEM), &found);
+
+	if (1 == found)
+	{
+		dc_item_index_remove(item);
+
+		item_hk_local.hostid = item->hostid;
+		item_hk_local.key = item->key;
+
+		if (NULL != (item_hk = (ZBX_DC_ITEM_HK *)zbx_hashset_search(&config->items_hk, &item_hk_local)))
+		{
+			zbx_strpool_release(item_hk->key);
+			zbx_hashset_remove_direct(&config->items_hk, item_hk);
+		}
+	}
+
+	item->hostid = hostid;
+	DCstrpool_replace(found, &item->key, key);
+
+	item_hk_local.hostid = item->hostid;
+	item_hk_local.key = zbx_strpool_acquire(item->key);
+	item_hk_local.item_ptr = item;
+	zbx_hashset_insert(&config->items_hk, &item_hk_local, sizeof(ZBX_DC_ITEM_HK));
+
+	dc_item_index_add(item);
+
+	UNLOCK_CACHE;
+}
+
+/* removes item from configuration cache the same way as DCsync_items() updates item indexes */
+void	dc_item_index_remove_test(zbx_uint64_t itemid)
+{
+	ZBX_DC_ITEM	*item;
+	ZBX_DC_ITEM_HK	*item_hk, item_hk_local;
+
+	WRLOCK_CACHE;
+
+	if (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemid)))
+	{
+		item_hk_local.hostid = item->hostid;
+		item_hk_local.key = item->key;
+
+		if (NULL != (item_hk = (ZBX_DC_ITEM_HK *)zbx_hashset_search(&config->items_hk, &item_hk_local)))
+		{
+			zbx_strpool_release(item_hk->key);
+			zbx_hashset_remove_direct(&config->items_hk, item_hk);
+		}
+
+		dc_item_index_remove(item);
+
+		zbx_strpool_release(item->key);
+		zbx_hashset_remove_direct(&config->items, item);
+	}
+
+	UNLOCK_CACHE;
+}
@@ -21,8 +21,13 @@
 
 void	zbx_vc_set_mode(int mode)
 {
-	vc_cache->mode = mode;
-	vc_cache->mode_time = time(NULL);
+	int	i;
+
+	for (i = 0; i < vc_stripes_num; i++)
+	{
+		vc_stripes[i].cache->mode = mode;
+		vc_stripes[i].cache->mode_time = time(NULL);
+	}
 }
 
 int	zbx_vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_history_record_t *values)
@@ -31,6 +36,8 @@ int	zbx_vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_
 	int		i;
 	zbx_vc_chunk_t	*chunk;
 
+	vc_select_item_stripe(itemid);
+
 	if (NULL == (item = zbx_hashset_search(&vc_cache->items, &itemid)))
 		return FAIL;
 
@@ -52,6 +59,8 @@ int	zbx_vc_precache_values(zbx_uint64_t itemid, int value_type, int seconds, int
 	int				ret;
 	zbx_vector_history_record_t	values;
 
+	vc_select_item_stripe(itemid);
+
 	/* add item to cache if necessary */
 	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
 	{
@@ -68,6 +77,7 @@ int	zbx_vc_precache_values(zbx_uint64_t itemid, int value_type, int seconds, int
 	zbx_history_record_vector_destroy(&values, value_type);
 
 	/* reset cache statistics */
+	vc_select_item_stripe(itemid);
 	vc_cache->hits = 0;
 	vc_cache->misses = 0;
 
@@ -80,6 +90,8 @@ int	zbx_vc_get_item_state(zbx_uint64_t itemid, int *status, int *active_range, i
 	zbx_vc_item_t	*item;
 	int		ret = FAIL;
 
+	vc_select_item_stripe(itemid);
+
 	if (NULL != (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
 	{
 		*status = item->status;
@@ -95,12 +107,23 @@ int	zbx_vc_get_item_state(zbx_uint64_t itemid, int *status, int *active_range, i
 
 int	zbx_vc_get_cache_state(int *mode, zbx_uint64_t *hits, zbx_uint64_t *misses)
 {
+	int	i;
+
 	if (NULL == vc_cache)
 		return FAIL;
 
-	*mode = vc_cache->mode;
-	*hits = vc_cache->hits;
-	*misses = vc_cache->misses;
+	*mode = ZBX_VC_MODE_NORMAL;
+	*hits = 0;
+	*misses = 0;
+
+	for (i = 0; i < vc_stripes_num; i++)
+	{
+		if (ZBX_VC_MODE_LOWMEM == vc_stripes[i].cache->mode)
+			*mode = ZBX_VC_MODE_LOWMEM;
+
+		*hits += vc_stripes[i].cache->hits;
+		*misses += vc_stripes[i].cache->misses;
+	}
 
 	return SUCCEED;
 }
@@ -0,0 +1,168 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "mutexs.h"
+#include "dbcache.h"
+
+/* Fills proxy memory buffer until it switches to database mode, reads the buffered values back and checks */
+/* that after acknowledging them the buffer returns to memory mode with record identifiers greater than   */
+/* the identifiers already sent from database.                                                            */
+
+extern zbx_uint64_t	CONFIG_PROXY_MEMORY_BUFFER_SIZE;
+
+typedef struct
+{
+	zbx_uint64_t	lastid;
+	int		records_num;
+	int		errors_num;
+	const char	*value;
+}
+pb_test_read_t;
+
+static void	pb_test_read_cb(const zbx_pb_history_t *history, void *cb_data)
+{
+	pb_test_read_t	*read = (pb_test_read_t *)cb_data;
+
+	if (history->id != read->lastid + 1 || 0 != strcmp(history->value, read->value))
+		read->errors_num++;
+
+	read->lastid = history->id;
+	read->records_num++;
+}
+
+static void	pb_test_add(ZBX_DC_HISTORY *history, int history_num, int expected_ret)
+{
+	int	ret;
+
+	ret = zbx_pb_history_add(history, history_num);
+	zbx_mock_assert_result_eq("zbx_pb_history_add() return value", expected_ret, ret);
+
+	if (SUCCEED != ret)
+		zbx_pb_history_db_end();
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_uint64_t	db_offset, db_lastid, db_lastid_out, first_id;
+	int		i, batch, value_size, stored_num = 0, mode;
+	char		*error = NULL, *value;
+	ZBX_DC_HISTORY	*history;
+	pb_test_read_t	read;
+
+	ZBX_UNUSED(state);
+
+	CONFIG_PROXY_MEMORY_BUFFER_SIZE = zbx_mock_get_parameter_uint64("in.size");
+	batch = (int)zbx_mock_get_parameter_uint64("in.batch");
+	value_size = (int)zbx_mock_get_parameter_uint64("in.value_size");
+	db_lastid = zbx_mock_get_parameter_uint64("in.db_lastid");
+
+	value = (char *)zbx_malloc(NULL, (size_t)value_size + 1);
+	memset(value, 'x', (size_t)value_size);
+	value[value_size] = '\0';
+
+	history = (ZBX_DC_HISTORY *)zbx_malloc(NULL, sizeof(ZBX_DC_HISTORY) * (size_t)batch);
+	memset(history, 0, sizeof(ZBX_DC_HISTORY) * (size_t)batch);
+
+	for (i = 0; i < batch; i++)
+	{
+		history[i].itemid = (zbx_uint64_t)i + 1;
+		history[i].ts.sec = 1000000000 + i;
+		history[i].value_type = ITEM_VALUE_TYPE_STR;
+		history[i].value.str = value;
+		history[i].state = ITEM_STATE_NORMAL;
+	}
+
+	zbx_mock_assert_result_eq("Lock initialization failed", SUCCEED, zbx_locks_create(&error));
+	zbx_mock_assert_result_eq("Proxy memory buffer initialization failed", SUCCEED, zbx_pb_init(&error));
+
+	/* the buffer starts in database mode until database has been drained */
+	zbx_mock_assert_int_eq("initial mode", ZBX_PB_MODE_DATABASE, zbx_pb_history_read_start(&db_offset));
+	pb_test_add(history, batch, FAIL);
+
+	/* database was written after reading started, so the mode must not be switched */
+	zbx_pb_history_read_end(0, 0, db_lastid, 0, 1);
+	zbx_mock_assert_int_eq("mode after concurrent write", ZBX_PB_MODE_DATABASE,
+			zbx_pb_history_read_start(&db_offset));
+
+	zbx_pb_history_read_end(0, 0, db_lastid, 0, 1);
+	zbx_mock_assert_int_eq("mode after draining database", ZBX_PB_MODE_MEMORY,
+			zbx_pb_history_read_start(&db_offset));
+
+	/* fill the buffer until it switches back to database mode */
+	while (SUCCEED == zbx_pb_history_add(history, batch))
+		stored_num += batch;
+
+	zbx_pb_history_db_end();
+
+	if (0 == stored_num)
+		fail_msg("no values were stored in proxy memory buffer");
+
+	zbx_mock_assert_int_eq("number of buffered values", stored_num, zbx_pb_history_get_count());
+
+	mode = zbx_pb_history_read_start(&db_offset);
+	zbx_mock_assert_int_eq("mode after filling buffer", ZBX_PB_MODE_DATABASE, mode);
+
+	first_id = db_lastid + 1;
+	if (ZBX_PB_HISTORY_ID_MIN > first_id)
+		first_id = ZBX_PB_HISTORY_ID_MIN;
+
+	zbx_mock_assert_uint64_eq("database record identifier offset", first_id + (zbx_uint64_t)stored_num - 1,
+			db_offset);
+
+	read.lastid = first_id - 1;
+	read.records_num = 0;
+	read.errors_num = 0;
+	read.value = value;
+
+	zbx_pb_history_get(0, stored_num + batch, pb_test_read_cb, &read);
+	zbx_mock_assert_int_eq("number of read values", stored_num, read.records_num);
+	zbx_mock_assert_int_eq("number of invalid read values", 0, read.errors_num);
+
+	/* nothing is freed until server acknowledges the sent values */
+	zbx_pb_history_read_end(read.lastid, read.lastid, db_lastid, 0, 1);
+	zbx_mock_assert_int_eq("number of values before acknowledgement", stored_num, zbx_pb_history_get_count());
+
+	zbx_mock_assert_result_eq("zbx_pb_history_set_lastid() return value", SUCCEED,
+			zbx_pb_history_set_lastid(read.lastid, &db_lastid_out));
+	zbx_mock_assert_uint64_eq("returned database last identifier", 0, db_lastid_out);
+	zbx_mock_assert_int_eq("number of values after acknowledgement", 0, zbx_pb_history_get_count());
+
+	zbx_mock_assert_int_eq("mode after acknowledgement", ZBX_PB_MODE_MEMORY,
+			zbx_pb_history_read_start(&db_offset));
+
+	/* identifiers of new buffer records must be greater than already sent database record identifiers */
+	pb_test_add(history, 1, SUCCEED);
+
+	read.lastid = db_lastid + db_offset;
+	read.records_num = 0;
+	zbx_pb_history_get(0, batch, pb_test_read_cb, &read);
+	zbx_mock_assert_int_eq("number of values read after switching mode", 1, read.records_num);
+	zbx_mock_assert_int_eq("number of invalid values read after switching mode", 0, read.errors_num);
+
+	zbx_pb_destroy();
+
+	zbx_free(history);
+	zbx_free(value);
+}
@@ -0,0 +1,353 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "dbcache.h"
+#include "valuecache.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+/* Compares trigger function evaluation by scanning cached values with evaluation from value cache sliding */
+/* windows. Every second a new value is added to each item, then avg(), min(), max(), sum() and count()    */
+/* functions of all triggers are evaluated like in evalfunc.c - with zbx_vc_get_aggregate() and falling    */
+/* back to zbx_vc_get_values() scan. The same simulation is run with ValueCacheAggregates disabled and     */
+/* enabled, adding values to cache and evaluating functions are timed.                                     */
+
+#define BENCH_FUNC_AVG		0
+#define BENCH_FUNC_MIN		1
+#define BENCH_FUNC_MAX		2
+#define BENCH_FUNC_SUM		3
+#define BENCH_FUNC_COUNT	4
+#define BENCH_FUNC_NUM		5
+
+extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
+extern int		CONFIG_VALUE_CACHE_AGGREGATES;
+
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	unsigned char	value_type;
+	int		func;
+	int		seconds;
+}
+bench_function_t;
+
+typedef struct
+{
+	int		items_num;
+	int		functions_num;
+	int		item_periods;
+	int		period_min;
+	int		period_max;
+	int		steps;
+	zbx_uint64_t	seed;
+}
+bench_params_t;
+
+typedef struct
+{
+	double		time_add;
+	double		time_eval;
+	zbx_uint64_t	evals;
+	zbx_uint64_t	fallbacks;
+	double		checksum;
+}
+bench_result_t;
+
+static zbx_uint64_t	bench_rand(zbx_uint64_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 7;
+	*seed ^= *seed << 17;
+
+	return *seed;
+}
+
+static unsigned char	bench_item_value_type(zbx_uint64_t itemid)
+{
+	return 0 == itemid % 2 ? ITEM_VALUE_TYPE_FLOAT : ITEM_VALUE_TYPE_UINT64;
+}
+
+static void	bench_init_functions(bench_function_t *functions, const bench_params_t *params)
+{
+	int		i, *periods, periods_num;
+	zbx_uint64_t	seed = params->seed;
+
+	/* functions of the same item use a few periods, so they share the item windows */
+	periods_num = params->items_num * params->item_periods;
+	periods = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)periods_num);
+
+	for (i = 0; i < periods_num; i++)
+	{
+		periods[i] = params->period_min + (int)(bench_rand(&seed) %
+				(zbx_uint64_t)(params->period_max - params->period_min + 1));
+	}
+
+	for (i = 0; i < params->functions_num; i++)
+	{
+		int	index = i % params->items_num;
+
+		functions[i].itemid = (zbx_uint64_t)index + 1;
+		functions[i].value_type = bench_item_value_type(functions[i].itemid);
+		functions[i].func = (int)(bench_rand(&seed) % BENCH_FUNC_NUM);
+		functions[i].seconds = periods[index * params->item_periods +
+				(int)(bench_rand(&seed) % (zbx_uint64_t)params->item_periods)];
+	}
+
+	zbx_free(periods);
+}
+
+static int	bench_function_flags(int func)
+{
+	switch (func)
+	{
+		case BENCH_FUNC_AVG:
+		case BENCH_FUNC_SUM:
+			return ZBX_VC_AGGREGATE_SUM;
+		case BENCH_FUNC_MIN:
+			return ZBX_VC_AGGREGATE_MIN;
+		case BENCH_FUNC_MAX:
+			return ZBX_VC_AGGREGATE_MAX;
+		default:
+			return 0;
+	}
+}
+
+static double	bench_value_to_dbl(unsigned char value_type, const history_value_t *value)
+{
+	return ITEM_VALUE_TYPE_FLOAT == value_type ? value->dbl : (double)value->ui64;
+}
+
+static double	bench_scan_function(const bench_function_t *function, const zbx_timespec_t *ts)
+{
+	zbx_vector_history_record_t	values;
+	int				i;
+	double				value, result = 0;
+
+	zbx_history_record_vector_create(&values);
+
+	zbx_mock_assert_result_eq("zbx_vc_get_values() return value", SUCCEED, zbx_vc_get_values(function->itemid,
+			function->value_type, &values, function->seconds, 0, ts));
+
+	for (i = 0; i < values.values_num; i++)
+	{
+		value = bench_value_to_dbl(function->value_type, &values.values[i].value);
+
+		switch (function->func)
+		{
+			case BENCH_FUNC_AVG:
+			case BENCH_FUNC_SUM:
+				result += value;
+				break;
+			case BENCH_FUNC_MIN:
+				if (0 == i || value < result)
+					result = value;
+				break;
+			case BENCH_FUNC_MAX:
+				if (0 == i || value > result)
+					result = value;
+				break;
+		}
+	}
+
+	if (BENCH_FUNC_COUNT == function->func)
+		result = values.values_num;
+	else if (BENCH_FUNC_AVG == function->func && 0 != values.values_num)
+		result /= values.values_num;
+
+	zbx_history_record_vector_destroy(&values, function->value_type);
+
+	return result;
+}
+
+static double	bench_eval_function(const bench_function_t *function, const zbx_timespec_t *ts,
+		zbx_uint64_t *fallbacks)
+{
+	zbx_vc_aggregate_t	aggregate;
+
+	if (SUCCEED != zbx_vc_get_aggregate(function->itemid, function->value_type, function->seconds, ts,
+			bench_function_flags(function->func), &aggregate))
+	{
+		(*fallbacks)++;
+		return bench_scan_function(function, ts);
+	}
+
+	switch (function->func)
+	{
+		case BENCH_FUNC_AVG:
+			return 0 == aggregate.values_num ? 0 : aggregate.avg;
+		case BENCH_FUNC_MIN:
+			return 0 == aggregate.values_num ? 0 : bench_value_to_dbl(function->value_type, &aggregate.min);
+		case BENCH_FUNC_MAX:
+			return 0 == aggregate.values_num ? 0 : bench_value_to_dbl(function->value_type, &aggregate.max);
+		case BENCH_FUNC_SUM:
+			return 0 == aggregate.values_num ? 0 : bench_value_to_dbl(function->value_type, &aggregate.sum);
+		default:
+			return aggregate.values_num;
+	}
+}
+
+static void	bench_add_values(const bench_params_t *params, const zbx_timespec_t *ts, zbx_uint64_t *seed)
+{
+	zbx_vector_ptr_t	history;
+	ZBX_DC_HISTORY		*h;
+	zbx_uint64_t		value;
+	int			i, ret_flush;
+
+	zbx_vector_ptr_create(&history);
+	zbx_vector_ptr_reserve(&history, (size_t)params->items_num);
+
+	for (i = 0; i < params->items_num; i++)
+	{
+		h = (ZBX_DC_HISTORY *)zbx_malloc(NULL, sizeof(ZBX_DC_HISTORY));
+		memset(h, 0, sizeof(ZBX_DC_HISTORY));
+
+		h->itemid = (zbx_uint64_t)i + 1;
+		h->value_type = bench_item_value_type(h->itemid);
+		h->ts = *ts;
+
+		value = bench_rand(seed) % 1000;
+
+		if (ITEM_VALUE_TYPE_FLOAT == h->value_type)
+			h->value.dbl = (double)value / 10 - 50;
+		else
+			h->value.ui64 = value;
+
+		zbx_vector_ptr_append(&history, h);
+	}
+
+	zbx_mock_assert_result_eq("zbx_vc_add_values() return value", SUCCEED, zbx_vc_add_values(&history,
+			&ret_flush));
+
+	zbx_vector_ptr_clear_ext(&history, zbx_vcmock_free_dc_history);
+	zbx_vector_ptr_destroy(&history);
+}
+
+static void	bench_run(const bench_function_t *functions, const bench_params_t *params, int aggregates,
+		bench_result_t *result)
+{
+	zbx_timespec_t	ts, now;
+	zbx_uint64_t	seed = params->seed, fallbacks = 0;
+	int		i, step;
+	double		time_start;
+
+	memset(result, 0, sizeof(bench_result_t));
+
+	CONFIG_VALUE_CACHE_AGGREGATES = aggregates;
+
+	zbx_vc_reset();
+	zbx_vcmock_ds_init();
+
+	/* cache the items with empty history before adding values, the windows are registered meanwhile */
+	now = zbx_vcmock_get_ts();
+	ts.sec = now.sec - params->steps - 1;
+	ts.ns = 0;
+
+	for (i = 0; i < params->functions_num; i++)
+		bench_eval_function(&functions[i], &ts, &fallbacks);
+
+	zbx_vc_flush_stats();
+
+	for (step = 0; step < params->steps; step++)
+	{
+		ts.sec++;
+		ts.ns = (int)(bench_rand(&seed) % 1000000000);
+
+		time_start = zbx_time();
+		bench_add_values(params, &ts, &seed);
+		result->time_add += zbx_time() - time_start;
+
+		time_start = zbx_time();
+
+		for (i = 0; i < params->functions_num; i++)
+			result->checksum += bench_eval_function(&functions[i], &ts, &result->fallbacks);
+
+		zbx_vc_flush_stats();
+		result->time_eval += zbx_time() - time_start;
+		result->evals += (zbx_uint64_t)params->functions_num;
+	}
+
+	zbx_vcmock_ds_destroy();
+
+	printf("%-8s items:%d functions:%d add:%.3f s evaluate:%.3f s per function:%.1f ns fallbacks:" ZBX_FS_UI64
+			"\n", 0 == aggregates ? "scan" : "window", params->items_num, params->functions_num,
+			result->time_add, result->time_eval, result->time_eval * 1e9 / (double)result->evals,
+			result->fallbacks);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	bench_params_t		params;
+	bench_function_t	*functions;
+	bench_result_t		scan, window;
+	char			*error = NULL;
+
+	ZBX_UNUSED(state);
+
+	params.items_num = (int)zbx_mock_get_parameter_uint64("in.items");
+	params.functions_num = (int)zbx_mock_get_parameter_uint64("in.functions");
+	params.item_periods = (int)zbx_mock_get_parameter_uint64("in.item_periods");
+	params.period_min = (int)zbx_mock_get_parameter_uint64("in.period_min");
+	params.period_max = (int)zbx_mock_get_parameter_uint64("in.period_max");
+	params.steps = (int)zbx_mock_get_parameter_uint64("in.steps");
+	params.seed = zbx_mock_get_parameter_uint64("in.seed");
+
+	if (0 >= params.items_num || params.functions_num < params.items_num)
+		fail_msg("invalid number of items or functions");
+
+	if (0 >= params.item_periods || 0 >= params.period_min || params.period_min > params.period_max)
+		fail_msg("invalid function periods");
+
+	CONFIG_VALUE_CACHE_SIZE = zbx_mock_get_parameter_uint64("in.cache_size");
+
+	zbx_mock_assert_result_eq("Lock initialization failed", SUCCEED, zbx_locks_create(&error));
+	zbx_mock_assert_result_eq("Value cache initialization failed", SUCCEED, zbx_vc_init(&error));
+
+	zbx_vc_enable();
+	zbx_vcmock_set_time(zbx_mock_get_parameter_handle("in"), "time");
+
+	functions = (bench_function_t *)zbx_malloc(NULL, sizeof(bench_function_t) * (size_t)params.functions_num);
+	bench_init_functions(functions, &params);
+
+	bench_run(functions, &params, 0, &scan);
+	bench_run(functions, &params, 1, &window);
+
+	/* window sums are updated incrementally, so they can differ from the scanned sums by rounding errors */
+	if (1e-9 * MAX(1, fabs(scan.checksum)) < fabs(scan.checksum - window.checksum))
+		fail_msg("expected checksum \"%.15g\" while got \"%.15g\"", scan.checksum, window.checksum);
+
+	/* windows are created after the first evaluation, so only it must fall back to scanning values */
+	zbx_mock_assert_uint64_eq("number of scan fallbacks", scan.evals, scan.fallbacks);
+
+	if (window.fallbacks > (zbx_uint64_t)params.functions_num)
+	{
+		fail_msg("expected at most %d window fallbacks while got " ZBX_FS_UI64, params.functions_num,
+				window.fallbacks);
+	}
+
+	zbx_free(functions);
+
+	zbx_vc_reset();
+	zbx_vc_destroy();
+}
@@ -0,0 +1,201 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "dbcache.h"
+#include "valuecache.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+/* Adds values to a cached item with value cache compression enabled and checks that values read */
+/* from cache match the added values exactly.                                                    */
+
+#define VC_COMPRESSION_ITEMID	1
+
+extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
+extern int		CONFIG_VALUE_CACHE_COMPRESSION;
+
+static zbx_uint64_t	vc_rand(zbx_uint64_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 7;
+	*seed ^= *seed << 17;
+
+	return *seed;
+}
+
+static void	vc_add_value(const zbx_history_record_t *record, unsigned char value_type)
+{
+	zbx_vector_ptr_t	history;
+	ZBX_DC_HISTORY		*h;
+	int			ret_flush;
+
+	h = (ZBX_DC_HISTORY *)zbx_malloc(NULL, sizeof(ZBX_DC_HISTORY));
+	memset(h, 0, sizeof(ZBX_DC_HISTORY));
+
+	h->itemid = VC_COMPRESSION_ITEMID;
+	h->value_type = value_type;
+	h->ts = record->timestamp;
+	h->value = record->value;
+
+	zbx_vector_ptr_create(&history);
+	zbx_vector_ptr_append(&history, h);
+
+	zbx_mock_assert_result_eq("zbx_vc_add_values() return value", SUCCEED, zbx_vc_add_values(&history,
+			&ret_flush));
+
+	zbx_vector_ptr_clear_ext(&history, zbx_vcmock_free_dc_history);
+	zbx_vector_ptr_destroy(&history);
+}
+
+/* packing must be lossless, so the values are compared by their bit representation */
+static void	vc_compare_record(const char *prefix, const zbx_history_record_t *expected,
+		const zbx_history_record_t *returned)
+{
+	zbx_mock_assert_timespec_eq(prefix, &expected->timestamp, &returned->timestamp);
+	zbx_mock_assert_uint64_eq(prefix, expected->value.ui64, returned->value.ui64);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	int				err, i, j, steps, delay, seconds, reorder, lookups;
+	char				*error;
+	unsigned char			value_type;
+	zbx_uint64_t			seed, jitter;
+	zbx_timespec_t			ts, now;
+	zbx_history_record_t		record, swapped, value;
+	zbx_vector_history_record_t	values;
+	zbx_vcmock_ds_item_t		*ds_item;
+	zbx_vc_stats_t			stats;
+	double				ratio_min;
+
+	ZBX_UNUSED(state);
+
+	CONFIG_VALUE_CACHE_SIZE = 64 * ZBX_MEBIBYTE;
+	CONFIG_VALUE_CACHE_COMPRESSION = 1;
+
+	err = zbx_locks_create(&error);
+	zbx_mock_assert_result_eq("Lock initialization failed", SUCCEED, err);
+
+	err = zbx_vc_init(&error);
+	zbx_mock_assert_result_eq("Value cache initialization failed", SUCCEED, err);
+
+	zbx_vc_enable();
+	zbx_vcmock_ds_init();
+	zbx_history_record_vector_create(&values);
+
+	zbx_vcmock_set_time(zbx_mock_get_parameter_handle("in"), "time");
+	value_type = zbx_mock_str_to_value_type(zbx_mock_get_parameter_string("in.value_type"));
+	steps = (int)zbx_mock_get_parameter_uint64("in.steps");
+	delay = (int)zbx_mock_get_parameter_uint64("in.delay");
+	jitter = zbx_mock_get_parameter_uint64("in.jitter");
+	reorder = (int)zbx_mock_get_parameter_uint64("in.reorder");
+	lookups = (int)zbx_mock_get_parameter_uint64("in.lookups");
+	seed = zbx_mock_get_parameter_uint64("in.seed");
+	ratio_min = atof(zbx_mock_get_parameter_string("out.compression_ratio"));
+
+	/* cache the item with the period covering all values */
+	now = zbx_vcmock_get_ts();
+	seconds = (steps + 1) * delay + 1;
+
+	zbx_mock_assert_result_eq("zbx_vc_get_values() return value", SUCCEED,
+			zbx_vc_get_values(VC_COMPRESSION_ITEMID, value_type, &values, seconds, 0, &now));
+	zbx_vc_flush_stats();
+
+	ts.sec = now.sec - seconds + 1;
+	ts.ns = 0;
+	memset(&record, 0, sizeof(record));
+
+	for (i = 0; i < steps; i++)
+	{
+		ts.sec += delay;
+
+		if (0 != jitter)
+			ts.ns = (int)(vc_rand(&seed) % jitter);
+
+		record.timestamp = ts;
+
+		if (ITEM_VALUE_TYPE_FLOAT == value_type)
+			record.value.dbl = (double)(int)(vc_rand(&seed) % 1000) / 10;
+		else
+			record.value.ui64 += vc_rand(&seed) % 100;
+
+		/* add every reorder-th value after the next value */
+		if (0 != reorder && 0 == i % reorder && i + 1 < steps)
+		{
+			swapped = record;
+			continue;
+		}
+
+		vc_add_value(&record, value_type);
+
+		if (0 != reorder && 1 == i % reorder)
+			vc_add_value(&swapped, value_type);
+	}
+
+	zbx_vc_get_statistics(&stats);
+	printf("values:%d compression ratio:%.2f\n", steps, stats.compression_ratio);
+
+	if (ratio_min > stats.compression_ratio)
+		fail_msg("expected compression ratio at least %.2f while got %.2f", ratio_min, stats.compression_ratio);
+
+	/* check all values */
+
+	ds_item = zbx_vcmock_ds_first_item();
+
+	zbx_history_record_vector_destroy(&values, value_type);
+	zbx_history_record_vector_create(&values);
+
+	zbx_mock_assert_result_eq("zbx_vc_get_values() return value", SUCCEED,
+			zbx_vc_get_values(VC_COMPRESSION_ITEMID, value_type, &values, seconds, 0, &now));
+
+	zbx_mock_assert_int_eq("number of values", ds_item->data.values_num, values.values_num);
+
+	for (i = 0, j = values.values_num - 1; i < ds_item->data.values_num; i++, j--)
+		vc_compare_record("cached value", &ds_item->data.values[i], &values.values[j]);
+
+	/* check values at random timestamps */
+
+	for (i = 0; i < lookups; i++)
+	{
+		j = (int)(vc_rand(&seed) % (zbx_uint64_t)ds_item->data.values_num);
+
+		zbx_mock_assert_result_eq("zbx_vc_get_value() return value", SUCCEED,
+				zbx_vc_get_value(VC_COMPRESSION_ITEMID, value_type, &ds_item->data.values[j].timestamp,
+				&value));
+
+		vc_compare_record("value at timestamp", &ds_item->data.values[j], &value);
+	}
+
+	zbx_vc_flush_stats();
+	zbx_history_record_vector_destroy(&values, value_type);
+	zbx_vcmock_ds_destroy();
+
+	zbx_vc_reset();
+
+	zbx_vc_get_statistics(&stats);
+	zbx_mock_assert_double_eq("compression ratio of empty cache", 1, stats.compression_ratio);
+
+	zbx_vc_destroy();
+}
@@ -0,0 +1,227 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "dbcache.h"
+#include "valuecache.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+/* Adds values to a cached item one by one and after every value compares sliding window aggregates */
+/* with the aggregates calculated by scanning the values returned by zbx_vc_get_values() function.   */
+
+#define VC_AGGREGATE_ITEMID	1
+
+extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
+extern int		CONFIG_VALUE_CACHE_AGGREGATES;
+
+static zbx_uint64_t	vc_rand(zbx_uint64_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 7;
+	*seed ^= *seed << 17;
+
+	return *seed;
+}
+
+static void	vc_add_value(unsigned char value_type, const zbx_timespec_t *ts, zbx_uint64_t value)
+{
+	zbx_vector_ptr_t	history;
+	ZBX_DC_HISTORY		*h;
+	int			ret_flush;
+
+	h = (ZBX_DC_HISTORY *)zbx_malloc(NULL, sizeof(ZBX_DC_HISTORY));
+	memset(h, 0, sizeof(ZBX_DC_HISTORY));
+
+	h->itemid = VC_AGGREGATE_ITEMID;
+	h->value_type = value_type;
+	h->ts = *ts;
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		h->value.dbl = (double)value / 10 - 50;
+	else
+		h->value.ui64 = value;
+
+	zbx_vector_ptr_create(&history);
+	zbx_vector_ptr_append(&history, h);
+
+	zbx_mock_assert_result_eq("zbx_vc_add_values() return value", SUCCEED, zbx_vc_add_values(&history,
+			&ret_flush));
+
+	zbx_vector_ptr_clear_ext(&history, zbx_vcmock_free_dc_history);
+	zbx_vector_ptr_destroy(&history);
+}
+
+static void	vc_scan_aggregate(unsigned char value_type, int seconds, const zbx_timespec_t *ts,
+		zbx_vc_aggregate_t *aggregate)
+{
+	zbx_vector_history_record_t	values;
+	int				i;
+	double				sum = 0;
+
+	zbx_history_record_vector_create(&values);
+
+	zbx_mock_assert_result_eq("zbx_vc_get_values() return value", SUCCEED,
+			zbx_vc_get_values(VC_AGGREGATE_ITEMID, value_type, &values, seconds, 0, ts));
+
+	memset(aggregate, 0, sizeof(zbx_vc_aggregate_t));
+
+	for (i = 0; i < values.values_num; i++)
+	{
+		const history_value_t	*value = &values.values[i].value;
+
+		if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		{
+			aggregate->sum.dbl += value->dbl;
+			sum += value->dbl;
+
+			if (0 == i || value->dbl < aggregate->min.dbl)
+				aggregate->min.dbl = value->dbl;
+
+			if (0 == i || value->dbl > aggregate->max.dbl)
+				aggregate->max.dbl = value->dbl;
+		}
+		else
+		{
+			aggregate->sum.ui64 += value->ui64;
+			sum += (double)value->ui64;
+
+			if (0 == i || value->ui64 < aggregate->min.ui64)
+				aggregate->min.ui64 = value->ui64;
+
+			if (0 == i || value->ui64 > aggregate->max.ui64)
+				aggregate->max.ui64 = value->ui64;
+		}
+	}
+
+	if (0 != (aggregate->values_num = values.values_num))
+		aggregate->avg = sum / values.values_num;
+
+	zbx_history_record_vector_destroy(&values, value_type);
+}
+
+/* the window sums are updated incrementally, so they can differ from the scanned sums by rounding errors */
+static void	vc_assert_double_eq(const char *prefix, double expected, double returned)
+{
+	if (1e-9 * MAX(1, fabs(expected)) < fabs(expected - returned))
+		fail_msg("%s: expected value \"%.15g\" while got \"%.15g\"", prefix, expected, returned);
+}
+
+static void	vc_compare_aggregate(unsigned char value_type, const zbx_vc_aggregate_t *expected,
+		const zbx_vc_aggregate_t *returned)
+{
+	zbx_mock_assert_int_eq("number of values", expected->values_num, returned->values_num);
+
+	if (0 == expected->values_num)
+		return;
+
+	vc_assert_double_eq("average", expected->avg, returned->avg);
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+	{
+		vc_assert_double_eq("sum", expected->sum.dbl, returned->sum.dbl);
+		zbx_mock_assert_double_eq("minimum", expected->min.dbl, returned->min.dbl);
+		zbx_mock_assert_double_eq("maximum", expected->max.dbl, returned->max.dbl);
+	}
+	else
+	{
+		zbx_mock_assert_uint64_eq("sum", expected->sum.ui64, returned->sum.ui64);
+		zbx_mock_assert_uint64_eq("minimum", expected->min.ui64, returned->min.ui64);
+		zbx_mock_assert_uint64_eq("maximum", expected->max.ui64, returned->max.ui64);
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	int			err, i, seconds, steps, fallbacks = 0, flags;
+	char			*error;
+	unsigned char		value_type;
+	zbx_uint64_t		seed, fallbacks_max;
+	zbx_timespec_t		ts, now;
+	zbx_vc_aggregate_t	expected, returned;
+	double			time_start, time_scan = 0, time_window = 0;
+
+	ZBX_UNUSED(state);
+
+	CONFIG_VALUE_CACHE_SIZE = 64 * ZBX_MEBIBYTE;
+	CONFIG_VALUE_CACHE_AGGREGATES = 1;
+
+	err = zbx_locks_create(&error);
+	zbx_mock_assert_result_eq("Lock initialization failed", SUCCEED, err);
+
+	err = zbx_vc_init(&error);
+	zbx_mock_assert_result_eq("Value cache initialization failed", SUCCEED, err);
+
+	zbx_vc_enable();
+	zbx_vcmock_ds_init();
+
+	zbx_vcmock_set_time(zbx_mock_get_parameter_handle("in"), "time");
+	value_type = zbx_mock_str_to_value_type(zbx_mock_get_parameter_string("in.value_type"));
+	seconds = (int)zbx_mock_get_parameter_uint64("in.seconds");
+	steps = (int)zbx_mock_get_parameter_uint64("in.steps");
+	seed = zbx_mock_get_parameter_uint64("in.seed");
+	fallbacks_max = zbx_mock_get_parameter_uint64("out.fallbacks");
+
+	flags = ZBX_VC_AGGREGATE_SUM | ZBX_VC_AGGREGATE_MIN | ZBX_VC_AGGREGATE_MAX;
+
+	/* values are added before the current time, starting with an empty cached period */
+	now = zbx_vcmock_get_ts();
+	ts.sec = now.sec - steps - 1;
+	ts.ns = 0;
+	vc_scan_aggregate(value_type, seconds, &ts, &expected);
+	zbx_vc_flush_stats();
+
+	for (i = 0; i < steps; i++)
+	{
+		ts.sec++;
+		ts.ns = (int)(vc_rand(&seed) % 1000000000);
+		vc_add_value(value_type, &ts, vc_rand(&seed) % 1000);
+
+		time_start = zbx_time();
+		vc_scan_aggregate(value_type, seconds, &ts, &expected);
+		time_scan += zbx_time() - time_start;
+
+		time_start = zbx_time();
+		err = zbx_vc_get_aggregate(VC_AGGREGATE_ITEMID, value_type, seconds, &ts, flags, &returned);
+		time_window += zbx_time() - time_start;
+
+		if (SUCCEED == err)
+			vc_compare_aggregate(value_type, &expected, &returned);
+		else
+			fallbacks++;
+
+		zbx_vc_flush_stats();
+	}
+
+	printf("values:%d period:%d scan:%.1f ns window:%.1f ns fallbacks:%d\n", steps, seconds,
+			time_scan * 1e9 / steps, time_window * 1e9 / steps, fallbacks);
+
+	if ((zbx_uint64_t)fallbacks > fallbacks_max)
+		fail_msg("expected at most " ZBX_FS_UI64 " fallbacks while got %d", fallbacks_max, fallbacks);
+
+	zbx_vcmock_ds_destroy();
+
+	zbx_vc_reset();
+	zbx_vc_destroy();
+}
@@ -0,0 +1,183 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxhistory.h"
+#include "valuecache.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
+extern char		*CONFIG_VALUE_CACHE_FILE;
+
+typedef struct
+{
+	zbx_uint64_t			itemid;
+	unsigned char			value_type;
+	int				status;
+	int				active_range;
+	int				values_total;
+	int				db_cached_from;
+	zbx_vector_history_record_t	values;
+}
+zbx_vcmock_saved_item_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mock_test_entry                                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	int				err, seconds, count, status, active_range, values_total, db_cached_from, i,
+					ret_flush;
+	char				*error = NULL;
+	zbx_mock_handle_t		handle, hitem, hitems;
+	zbx_mock_error_t		mock_err;
+	zbx_uint64_t			itemid;
+	unsigned char			value_type;
+	zbx_vector_ptr_t		history, saved;
+	zbx_vector_history_record_t	returned;
+	zbx_vcmock_saved_item_t		*item;
+	zbx_timespec_t			ts;
+	zbx_stat_t			buf;
+
+	ZBX_UNUSED(state);
+
+	CONFIG_VALUE_CACHE_SIZE = ZBX_MEBIBYTE;
+	CONFIG_VALUE_CACHE_FILE = zbx_dsprintf(NULL, "zbx_vc_save_load.%d", (int)getpid());
+	zbx_mock_file_passthrough(CONFIG_VALUE_CACHE_FILE);
+
+	err = zbx_locks_create(&error);
+	zbx_mock_assert_result_eq("Lock initialization failed", SUCCEED, err);
+
+	err = zbx_vc_init(&error);
+	zbx_mock_assert_result_eq("Value cache initialization failed", SUCCEED, err);
+
+	zbx_vc_enable();
+
+	zbx_vcmock_ds_init();
+	zbx_vector_ptr_create(&saved);
+	zbx_history_record_vector_create(&returned);
+
+	/* precache values */
+	handle = zbx_mock_get_parameter_handle("in.precache");
+	while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(handle, &hitem))))
+	{
+		zbx_vcmock_set_time(hitem, "time");
+		zbx_vcmock_set_mode(hitem, "cache mode");
+		zbx_vcmock_set_cache_size(hitem, "cache size");
+
+		zbx_vcmock_get_request_params(hitem, &itemid, &value_type, &seconds, &count, &ts);
+		zbx_vc_precache_values(itemid, value_type, seconds, count, &ts);
+	}
+
+	/* save cache and remember the saved item states */
+
+	zbx_vcmock_set_time(zbx_mock_get_parameter_handle("in.save"), "time");
+
+	hitems = zbx_mock_get_parameter_handle("out.items");
+	while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(hitems, &hitem))))
+	{
+		item = (zbx_vcmock_saved_item_t *)zbx_malloc(NULL, sizeof(zbx_vcmock_saved_item_t));
+
+		if (SUCCEED != is_uint64(zbx_mock_get_object_member_string(hitem, "itemid"), &item->itemid))
+			fail_msg("Invalid itemid");
+
+		item->value_type = zbx_mock_str_to_value_type(zbx_mock_get_object_member_string(hitem, "value type"));
+
+		err = zbx_vc_get_item_state(item->itemid, &item->status, &item->active_range, &item->values_total,
+				&item->db_cached_from);
+		zbx_mock_assert_result_eq("zbx_vc_get_item_state() before save", SUCCEED, err);
+
+		zbx_history_record_vector_create(&item->values);
+		zbx_vc_get_cached_values(item->itemid, item->value_type, &item->values);
+
+		zbx_vector_ptr_append(&saved, item);
+	}
+
+	err = zbx_vc_save(&error);
+	zbx_mock_assert_result_eq("zbx_vc_save()", SUCCEED, err);
+
+	zbx_vc_reset();
+
+	/* write values to history storage after the snapshot was saved */
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.updates", &handle))
+	{
+		zbx_vcmock_set_time(handle, "time");
+
+		zbx_vector_ptr_create(&history);
+		zbx_vcmock_get_dc_history(zbx_mock_get_object_member_handle(handle, "values"), &history);
+		zbx_history_add_values(&history, &ret_flush);
+		zbx_vector_ptr_clear_ext(&history, zbx_vcmock_free_dc_history);
+		zbx_vector_ptr_destroy(&history);
+	}
+
+	err = zbx_vc_load(&error);
+	zbx_mock_assert_result_eq("zbx_vc_load()", SUCCEED, err);
+	zbx_mock_assert_int_eq("snapshot file removed", -1, zbx_stat(CONFIG_VALUE_CACHE_FILE, &buf));
+
+	/* validate loaded cache contents */
+
+	i = 0;
+	hitems = zbx_mock_get_parameter_handle("out.items");
+	while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(hitems, &hitem))))
+	{
+		item = (zbx_vcmock_saved_item_t *)saved.values[i++];
+
+		err = zbx_vc_get_item_state(item->itemid, &status, &active_range, &values_total, &db_cached_from);
+
+		if (0 == strcmp(zbx_mock_get_object_member_string(hitem, "loaded"), "yes"))
+		{
+			zbx_mock_assert_result_eq("zbx_vc_get_item_state() after load", SUCCEED, err);
+			zbx_mock_assert_int_eq("item.status", item->status, status);
+			zbx_mock_assert_int_eq("item.active_range", item->active_range, active_range);
+			zbx_mock_assert_int_eq("item.values_total", item->values_total, values_total);
+			zbx_mock_assert_int_eq("item.db_cached_from", item->db_cached_from, db_cached_from);
+
+			zbx_vc_get_cached_values(item->itemid, item->value_type, &returned);
+			zbx_vcmock_check_records("Loaded values", item->value_type, &item->values, &returned);
+			zbx_history_record_vector_clean(&returned, item->value_type);
+		}
+		else
+			zbx_mock_assert_result_eq("zbx_vc_get_item_state() after load", FAIL, err);
+
+		zbx_history_record_vector_destroy(&item->values, item->value_type);
+		zbx_free(item);
+	}
+
+	/* cleanup */
+
+	zbx_vector_history_record_destroy(&returned);
+	zbx_vector_ptr_destroy(&saved);
+
+	zbx_vcmock_ds_destroy();
+
+	zbx_vc_reset();
+	zbx_vc_destroy();
+
+	zbx_mock_file_passthrough(NULL);
+	zbx_free(CONFIG_VALUE_CACHE_FILE);
+}
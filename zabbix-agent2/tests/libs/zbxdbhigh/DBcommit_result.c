@@ -0,0 +1,275 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "db.h"
+#include "zbxdb.h"
+
+#ifdef HAVE_POSTGRESQL
+#include <libpq-fe.h>
+
+/* Transaction is started and the test case statements are executed with libpq functions replaced by mocks,  */
+/* then commit is sent with DBcommit_send() and its result is retrieved with DBcommit_result() as history    */
+/* syncer does. Results of commit and connection status after commit are taken from the test case data.      */
+
+/* libpq declares the result structure as opaque, mocked results contain only what the tests need */
+struct pg_result
+{
+	ExecStatusType	status;
+	char		*sqlstate;
+};
+
+static zbx_vector_str_t		queries;
+static zbx_mock_handle_t	hstatement, hresults;
+static int			results_num, commit_attempted, commit_sent;
+
+PGresult	*__wrap_PQexec(PGconn *conn, const char *query);
+int	__wrap_PQsendQuery(PGconn *conn, const char *query);
+PGresult	*__wrap_PQgetResult(PGconn *conn);
+ExecStatusType	__wrap_PQresultStatus(const PGresult *res);
+char	*__wrap_PQresultErrorMessage(const PGresult *res);
+char	*__wrap_PQresultErrorField(const PGresult *res, int fieldcode);
+char	*__wrap_PQcmdTuples(PGresult *res);
+void	__wrap_PQclear(PGresult *res);
+ConnStatusType	__wrap_PQstatus(const PGconn *conn);
+
+int	__real_zbx_db_vexecute(const char *fmt, va_list args);
+
+static ExecStatusType	mock_str_to_exec_status(const char *str)
+{
+	if (0 == strcmp(str, "PGRES_COMMAND_OK"))
+		return PGRES_COMMAND_OK;
+
+	if (0 == strcmp(str, "PGRES_NONFATAL_ERROR"))
+		return PGRES_NONFATAL_ERROR;
+
+	if (0 == strcmp(str, "PGRES_FATAL_ERROR"))
+		return PGRES_FATAL_ERROR;
+
+	fail_msg("unknown result status \"%s\"", str);
+	return PGRES_FATAL_ERROR;
+}
+
+static int	mock_str_to_db_code(const char *str)
+{
+	if (0 == strcmp(str, "ZBX_DB_OK"))
+		return ZBX_DB_OK;
+
+	if (0 == strcmp(str, "ZBX_DB_FAIL"))
+		return ZBX_DB_FAIL;
+
+	if (0 == strcmp(str, "ZBX_DB_DOWN"))
+		return ZBX_DB_DOWN;
+
+	fail_msg("unknown database return code \"%s\"", str);
+	return ZBX_DB_FAIL;
+}
+
+static PGresult	*mock_result_create(ExecStatusType status, const char *sqlstate)
+{
+	PGresult	*result;
+
+	result = (PGresult *)zbx_malloc(NULL, sizeof(PGresult));
+	result->status = status;
+	result->sqlstate = (NULL != sqlstate ? zbx_strdup(NULL, sqlstate) : NULL);
+	results_num++;
+
+	return result;
+}
+
+/* creates result from test case object with status and optional sqlstate members */
+static PGresult	*mock_result_read(zbx_mock_handle_t hresult)
+{
+	zbx_mock_handle_t	hsqlstate;
+	const char		*sqlstate = NULL;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hresult, "sqlstate", &hsqlstate) &&
+			ZBX_MOCK_SUCCESS != zbx_mock_string(hsqlstate, &sqlstate))
+	{
+		fail_msg("invalid result sqlstate");
+	}
+
+	return mock_result_create(mock_str_to_exec_status(zbx_mock_get_object_member_string(hresult, "status")),
+			sqlstate);
+}
+
+PGresult	*__wrap_PQexec(PGconn *conn, const char *query)
+{
+	ZBX_UNUSED(conn);
+
+	zbx_vector_str_append(&queries, zbx_strdup(NULL, query));
+
+	if (0 == strcmp(query, "begin;") || 0 == strcmp(query, "rollback;"))
+		return mock_result_create(PGRES_COMMAND_OK, NULL);
+
+	return mock_result_read(hstatement);
+}
+
+int	__wrap_PQsendQuery(PGconn *conn, const char *query)
+{
+	ZBX_UNUSED(conn);
+
+	zbx_vector_str_append(&queries, zbx_strdup(NULL, query));
+	commit_attempted = 1;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.commit.send") &&
+			SUCCEED != zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("in.commit.send")))
+	{
+		return 0;
+	}
+
+	commit_sent = 1;
+
+	return 1;
+}
+
+PGresult	*__wrap_PQgetResult(PGconn *conn)
+{
+	zbx_mock_handle_t	hresult;
+
+	ZBX_UNUSED(conn);
+
+	if (0 == commit_sent)
+		fail_msg("results are retrieved without sending the query");
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_vector_element(hresults, &hresult))
+		return NULL;
+
+	return mock_result_read(hresult);
+}
+
+ExecStatusType	__wrap_PQresultStatus(const PGresult *res)
+{
+	return res->status;
+}
+
+char	*__wrap_PQresultErrorMessage(const PGresult *res)
+{
+	return PGRES_COMMAND_OK == res->status ? "" : "ERROR:  mock error\n";
+}
+
+char	*__wrap_PQresultErrorField(const PGresult *res, int fieldcode)
+{
+	return PG_DIAG_SQLSTATE == fieldcode ? res->sqlstate : NULL;
+}
+
+char	*__wrap_PQcmdTuples(PGresult *res)
+{
+	ZBX_UNUSED(res);
+
+	return "";
+}
+
+void	__wrap_PQclear(PGresult *res)
+{
+	zbx_free(res->sqlstate);
+	zbx_free(res);
+	results_num--;
+}
+
+/* connection is lost only after commit, so statements of the transaction are not affected */
+ConnStatusType	__wrap_PQstatus(const PGconn *conn)
+{
+	ZBX_UNUSED(conn);
+
+	if (0 != commit_attempted && ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.commit.connection") &&
+			0 == strcmp(zbx_mock_get_parameter_string("in.commit.connection"), "CONNECTION_BAD"))
+	{
+		return CONNECTION_BAD;
+	}
+
+	return CONNECTION_OK;
+}
+
+static void	mock_execute(const char *fmt, ...)
+{
+	va_list	args;
+
+	va_start(args, fmt);
+	(void)__real_zbx_db_vexecute(fmt, args);
+	va_end(args);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hstatements, hqueries, hquery, hresult;
+	zbx_mock_error_t	err;
+	const char		*query;
+	int			i, ret;
+
+	ZBX_UNUSED(state);
+
+	zbx_vector_str_create(&queries);
+
+	hstatements = zbx_mock_get_parameter_handle("in.statements");
+	hresults = zbx_mock_get_parameter_handle("in.commit.results");
+
+	zbx_mock_assert_int_eq("zbx_db_begin() return value", ZBX_DB_OK, zbx_db_begin());
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hstatements, &hstatement)))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read statement: %s", zbx_mock_error_string(err));
+
+		mock_execute("%s", zbx_mock_get_object_member_string(hstatement, "sql"));
+	}
+
+	DBcommit_send();
+	ret = DBcommit_result();
+
+	zbx_mock_assert_int_eq("DBcommit_result() return value",
+			mock_str_to_db_code(zbx_mock_get_parameter_string("out.return")), ret);
+	zbx_mock_assert_int_eq("transaction level", 0, zbx_db_txn_level());
+	zbx_mock_assert_int_eq("unreleased results", 0, results_num);
+
+	/* connection cannot be used for the next query until all results are retrieved */
+	if (0 != commit_sent && ZBX_MOCK_END_OF_VECTOR != zbx_mock_vector_element(hresults, &hresult))
+		fail_msg("not all commit results were retrieved");
+
+	hqueries = zbx_mock_get_parameter_handle("out.queries");
+
+	for (i = 0; ZBX_MOCK_END_OF_VECTOR != (err = zbx_mock_vector_element(hqueries, &hquery)); i++)
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hquery, &query)))
+			fail_msg("Cannot read query: %s", zbx_mock_error_string(err));
+
+		if (i >= queries.values_num)
+			fail_msg("expected query \"%s\" was not executed", query);
+
+		zbx_mock_assert_str_eq("executed query", query, queries.values[i]);
+	}
+
+	zbx_mock_assert_int_eq("number of executed queries", i, queries.values_num);
+
+	zbx_vector_str_clear_ext(&queries, zbx_str_free);
+	zbx_vector_str_destroy(&queries);
+}
+#else
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+	skip();
+}
+#endif
@@ -0,0 +1,207 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+#include "zbxmockdb.h"
+
+#include "common.h"
+#include "db.h"
+#include "zbxjson.h"
+#include "proxyconfig_test.h"
+
+/* Prepares table data for proxy with the revision acknowledged by proxy and applies the result to the proxy */
+/* records returned by mocked database. When test case has previous table data, the acknowledged revision    */
+/* is the revision server has sent with the previous table data.                                              */
+
+static void	mock_read_uint64_vector(const char *path, zbx_vector_uint64_t *values)
+{
+	zbx_mock_handle_t	hvalues, hvalue;
+	zbx_mock_error_t	err;
+	zbx_uint64_t		value;
+
+	hvalues = zbx_mock_get_parameter_handle(path);
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hvalues, &hvalue))))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hvalue, &value)))
+			fail_msg("Cannot read \"%s\" element: %s", path, zbx_mock_error_string(err));
+
+		zbx_vector_uint64_append(values, value);
+	}
+}
+
+static void	json_read_uint64_vector(const struct zbx_json_parse *jp, zbx_vector_uint64_t *values)
+{
+	const char	*p = NULL;
+	char		buf[MAX_ID_LEN + 1];
+	zbx_uint64_t	value;
+
+	while (NULL != (p = zbx_json_next_value(jp, p, buf, sizeof(buf), NULL)))
+	{
+		if (SUCCEED != is_uint64(buf, &value))
+			fail_msg("invalid unsigned integer value \"%s\"", buf);
+
+		zbx_vector_uint64_append(values, value);
+	}
+}
+
+static void	mock_compare_uint64_vector(const char *prefix, const zbx_vector_uint64_t *expected,
+		const zbx_vector_uint64_t *returned)
+{
+	int	i;
+
+	zbx_mock_assert_int_eq(prefix, expected->values_num, returned->values_num);
+
+	for (i = 0; i < expected->values_num; i++)
+		zbx_mock_assert_uint64_eq(prefix, expected->values[i], returned->values[i]);
+}
+
+/* makes revision object acknowledged by proxy from the table revision sent by server */
+static void	get_table_revision(const char *tablename, const char *data, struct zbx_json *revision)
+{
+	struct zbx_json_parse	jp, jp_obj, jp_revision;
+	char			*buf = NULL;
+	size_t			buf_alloc = 0, buf_offset = 0;
+
+	if (SUCCEED != zbx_json_open(data, &jp) || SUCCEED != zbx_json_brackets_by_name(&jp, tablename, &jp_obj) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp_obj, "revision", &jp_revision))
+	{
+		fail_msg("cannot find table revision in \"%s\"", data);
+	}
+
+	zbx_strncpy_alloc(&buf, &buf_alloc, &buf_offset, jp_revision.start,
+			(size_t)(jp_revision.end - jp_revision.start + 1));
+	zbx_json_addraw(revision, tablename, buf);
+
+	zbx_free(buf);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char		*tablename;
+	struct zbx_json		j, revision;
+	struct zbx_json_parse	jp, jp_obj, jp_data, jp_buckets, jp_revision, *jp_revision_ptr = NULL;
+	zbx_vector_uint64_t	expected, returned;
+	char			*buf = NULL, *error = NULL;
+	size_t			buf_alloc = 0, buf_offset = 0;
+	int			ret;
+
+	ZBX_UNUSED(state);
+
+	zbx_mockdb_init();
+
+	zbx_vector_uint64_create(&expected);
+	zbx_vector_uint64_create(&returned);
+
+	tablename = zbx_mock_get_parameter_string("in.table");
+
+	zbx_json_init(&revision, ZBX_JSON_STAT_BUF_LEN);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.revision"))
+		zbx_json_addraw(&revision, tablename, zbx_mock_get_parameter_string("in.revision"));
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.previous"))
+	{
+		zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+
+		if (SUCCEED != zbx_json_open(revision.buffer, &jp_revision))
+			fail_msg("invalid revision \"%s\"", revision.buffer);
+
+		if (SUCCEED != proxyconfig_add_table_test(&j, tablename, zbx_mock_get_parameter_string("in.previous"),
+				&jp_revision))
+		{
+			fail_msg("cannot add previous table data");
+		}
+
+		zbx_json_clean(&revision);
+		get_table_revision(tablename, j.buffer, &revision);
+
+		zbx_json_free(&j);
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.revision") ||
+			ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.previous"))
+	{
+		if (SUCCEED != zbx_json_open(revision.buffer, &jp_revision))
+			fail_msg("invalid revision \"%s\"", revision.buffer);
+
+		jp_revision_ptr = &jp_revision;
+	}
+
+	/* prepare table data on server */
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+
+	if (SUCCEED != proxyconfig_add_table_test(&j, tablename, zbx_mock_get_parameter_string("in.data"),
+			jp_revision_ptr))
+	{
+		fail_msg("cannot add table data");
+	}
+
+	if (SUCCEED != zbx_json_open(j.buffer, &jp) || SUCCEED != zbx_json_brackets_by_name(&jp, tablename, &jp_obj))
+		fail_msg("cannot find table in \"%s\"", j.buffer);
+
+	if (SUCCEED != zbx_json_brackets_by_name(&jp_obj, ZBX_PROTO_TAG_DATA, &jp_data))
+		fail_msg("cannot find table data in \"%s\"", j.buffer);
+
+	zbx_strncpy_alloc(&buf, &buf_alloc, &buf_offset, jp_data.start, (size_t)(jp_data.end - jp_data.start + 1));
+	zbx_mock_assert_str_eq("sent rows", zbx_mock_get_parameter_string("out.data"), buf);
+
+	if (SUCCEED != zbx_json_brackets_by_name(&jp_obj, "revision", &jp_revision))
+		fail_msg("cannot find table revision in \"%s\"", j.buffer);
+
+	json_read_uint64_vector(&jp_revision, &returned);
+	zbx_mock_assert_int_eq("revision buckets", (int)zbx_mock_get_parameter_uint64("out.revision"),
+			returned.values_num);
+	zbx_vector_uint64_clear(&returned);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("out.buckets"))
+	{
+		if (SUCCEED != zbx_json_brackets_by_name(&jp_obj, "buckets", &jp_buckets))
+			fail_msg("expected incremental table data, but got \"%s\"", j.buffer);
+
+		mock_read_uint64_vector("out.buckets", &expected);
+		json_read_uint64_vector(&jp_buckets, &returned);
+		mock_compare_uint64_vector("changed buckets", &expected, &returned);
+		zbx_vector_uint64_clear(&expected);
+		zbx_vector_uint64_clear(&returned);
+	}
+	else if (SUCCEED == zbx_json_brackets_by_name(&jp_obj, "buckets", &jp_buckets))
+		fail_msg("expected full table data, but got \"%s\"", j.buffer);
+
+	/* apply table data to proxy records */
+
+	ret = process_proxyconfig_table_test(tablename, &jp_obj, &returned, &error);
+	zbx_mock_assert_result_eq("process_proxyconfig_table() return value", SUCCEED, ret);
+
+	mock_read_uint64_vector("out.deleted", &expected);
+	mock_compare_uint64_vector("deleted records", &expected, &returned);
+
+	zbx_free(error);
+	zbx_free(buf);
+	zbx_json_free(&j);
+	zbx_json_free(&revision);
+	zbx_vector_uint64_destroy(&returned);
+	zbx_vector_uint64_destroy(&expected);
+
+	zbx_mockdb_destroy();
+}
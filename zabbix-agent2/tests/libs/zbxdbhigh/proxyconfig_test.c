@@ -0,0 +1,43 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "proxyconfig_test.h"
+
+/* adds table data prepared the same way as get_proxyconfig_data() prepares it for proxyconfig_add_table() */
+int	proxyconfig_add_table_test(struct zbx_json *j, const char *tablename, const char *table_data,
+		const struct zbx_json_parse *jp_revision)
+{
+	struct zbx_json	j_table;
+	int		ret;
+
+	zbx_json_init(&j_table, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addraw(&j_table, tablename, table_data);
+
+	ret = proxyconfig_add_table(j, DBget_table(tablename), &j_table, jp_revision);
+
+	zbx_json_free(&j_table);
+
+	return ret;
+}
+
+int	process_proxyconfig_table_test(const char *tablename, struct zbx_json_parse *jp_obj, zbx_vector_uint64_t *del,
+		char **error)
+{
+	return process_proxyconfig_table(DBget_table(tablename), jp_obj, del, error);
+}
@@ -0,0 +1,31 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef PROXYCONFIG_TEST_H
+#define PROXYCONFIG_TEST_H
+
+#include "zbxjson.h"
+#include "zbxalgo.h"
+
+int	proxyconfig_add_table_test(struct zbx_json *j, const char *tablename, const char *table_data,
+		const struct zbx_json_parse *jp_revision);
+int	process_proxyconfig_table_test(const char *tablename, struct zbx_json_parse *jp_obj, zbx_vector_uint64_t *del,
+		char **error);
+
+#endif /* PROXYCONFIG_TEST_H */
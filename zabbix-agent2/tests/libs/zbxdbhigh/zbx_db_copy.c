@@ -0,0 +1,189 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "db.h"
+#include "zbxdb.h"
+
+#ifdef HAVE_POSTGRESQL
+
+static char	*copy_sql = NULL;
+static char	*copy_data = NULL;
+
+int	__wrap_zbx_db_copy_from(const char *sql, const char *data, size_t data_len);
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_hex_encode                                                  *
+ *                                                                            *
+ * Purpose: encodes binary data as hexadecimal string                         *
+ *                                                                            *
+ ******************************************************************************/
+static char	*mock_hex_encode(const char *data, size_t data_len)
+{
+	char	*hex = NULL;
+	size_t	hex_alloc = 0, hex_offset = 0, i;
+
+	zbx_strcpy_alloc(&hex, &hex_alloc, &hex_offset, "");
+
+	for (i = 0; i < data_len; i++)
+		zbx_snprintf_alloc(&hex, &hex_alloc, &hex_offset, "%02x", (unsigned char)data[i]);
+
+	return hex;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_hex_normalize                                               *
+ *                                                                            *
+ * Purpose: removes whitespace from hexadecimal string in test case data      *
+ *                                                                            *
+ ******************************************************************************/
+static char	*mock_hex_normalize(const char *text)
+{
+	char	*hex = NULL;
+	size_t	hex_alloc = 0, hex_offset = 0;
+
+	zbx_strcpy_alloc(&hex, &hex_alloc, &hex_offset, "");
+
+	for (; '\0' != *text; text++)
+	{
+		if (0 == isspace((unsigned char)*text))
+			zbx_chrcpy_alloc(&hex, &hex_alloc, &hex_offset, (char)tolower((unsigned char)*text));
+	}
+
+	return hex;
+}
+
+int	__wrap_zbx_db_copy_from(const char *sql, const char *data, size_t data_len)
+{
+	zbx_free(copy_sql);
+	zbx_free(copy_data);
+
+	copy_sql = zbx_strdup(NULL, sql);
+	copy_data = mock_hex_encode(data, data_len);
+
+	return ZBX_DB_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_copy_add_row                                                *
+ *                                                                            *
+ * Purpose: adds row from test case data to the bulk load data                *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_copy_add_row(zbx_db_copy_t *copy, zbx_mock_handle_t hrow)
+{
+	zbx_uint64_t	itemid;
+	int		clock, ns;
+	const char	*table = copy->table->table;
+
+	itemid = zbx_mock_get_object_member_uint64(hrow, "itemid");
+	clock = zbx_mock_get_object_member_int(hrow, "clock");
+	ns = zbx_mock_get_object_member_int(hrow, "ns");
+
+	if (0 == strcmp(table, "history"))
+	{
+		zbx_db_copy_add_values(copy, itemid, clock, ns,
+				atof(zbx_mock_get_object_member_string(hrow, "value")));
+	}
+	else if (0 == strcmp(table, "history_uint"))
+	{
+		zbx_db_copy_add_values(copy, itemid, clock, ns, zbx_mock_get_object_member_uint64(hrow, "value"));
+	}
+	else if (0 == strcmp(table, "history_str") || 0 == strcmp(table, "history_text"))
+	{
+		zbx_db_copy_add_values(copy, itemid, clock, ns, zbx_mock_get_object_member_string(hrow, "value"));
+	}
+	else if (0 == strcmp(table, "history_log"))
+	{
+		zbx_db_copy_add_values(copy, itemid, clock, ns, zbx_mock_get_object_member_int(hrow, "timestamp"),
+				zbx_mock_get_object_member_string(hrow, "source"),
+				zbx_mock_get_object_member_int(hrow, "severity"),
+				zbx_mock_get_object_member_string(hrow, "value"),
+				zbx_mock_get_object_member_int(hrow, "logeventid"));
+	}
+	else
+		fail_msg("unsupported table \"%s\"", table);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_db_copy_t		copy;
+	const char		*table;
+	char			*expected;
+	zbx_mock_handle_t	hrows, hrow, hsql;
+	int			i;
+
+	ZBX_UNUSED(state);
+
+	table = zbx_mock_get_parameter_string("in.table");
+
+	if (0 == strcmp(table, "history_log"))
+	{
+		zbx_db_copy_prepare(&copy, table, "itemid", "clock", "ns", "timestamp", "source", "severity", "value",
+				"logeventid", NULL);
+	}
+	else
+		zbx_db_copy_prepare(&copy, table, "itemid", "clock", "ns", "value", NULL);
+
+	hrows = zbx_mock_get_parameter_handle("in.rows");
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrows, &hrow))
+		mock_copy_add_row(&copy, hrow);
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_parameter("out.sql", &hsql))
+	{
+		zbx_mock_assert_result_eq("zbx_db_copy_execute()", SUCCEED, zbx_db_copy_execute(&copy));
+		zbx_mock_assert_ptr_eq("copy statement", NULL, copy_sql);
+		goto out;
+	}
+
+	expected = mock_hex_normalize(zbx_mock_get_parameter_string("out.data"));
+
+	/* the data must be the same when the operation is repeated after a failed transaction */
+	for (i = 0; i < 2; i++)
+	{
+		zbx_mock_assert_result_eq("zbx_db_copy_execute()", SUCCEED, zbx_db_copy_execute(&copy));
+
+		zbx_mock_assert_ptr_ne("copy statement", NULL, copy_sql);
+		zbx_mock_assert_str_eq("copy statement", zbx_mock_get_parameter_string("out.sql"), copy_sql);
+		zbx_mock_assert_str_eq("copy data", expected, copy_data);
+
+		zbx_free(copy_sql);
+		zbx_free(copy_data);
+	}
+
+	zbx_free(expected);
+out:
+	zbx_db_copy_clean(&copy);
+}
+#else
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+	skip();
+}
+#endif
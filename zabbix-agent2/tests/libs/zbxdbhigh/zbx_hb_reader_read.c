@@ -0,0 +1,175 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "../../../src/libs/zbxdbhigh/history_binary.h"
+
+static const char	*mock_get_optional_string(zbx_mock_handle_t object, const char *name)
+{
+	zbx_mock_handle_t	handle;
+	const char		*value;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(object, name, &handle))
+		return NULL;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_string(handle, &value))
+		fail_msg("invalid record field \"%s\"", name);
+
+	return value;
+}
+
+static zbx_uint64_t	mock_get_optional_uint64(zbx_mock_handle_t object, const char *name)
+{
+	const char	*value;
+
+	if (NULL == (value = mock_get_optional_string(object, name)))
+		return 0;
+
+	return (zbx_uint64_t)strtoull(value, NULL, 10);
+}
+
+static int	mock_get_optional_int(zbx_mock_handle_t object, const char *name)
+{
+	const char	*value;
+
+	if (NULL == (value = mock_get_optional_string(object, name)))
+		return 0;
+
+	return atoi(value);
+}
+
+static void	mock_read_record(zbx_mock_handle_t handle, zbx_hb_record_t *record)
+{
+	memset(record, 0, sizeof(zbx_hb_record_t));
+
+	record->id = mock_get_optional_uint64(handle, "id");
+	record->itemid = mock_get_optional_uint64(handle, "itemid");
+	record->clock = mock_get_optional_int(handle, "clock");
+	record->ns = mock_get_optional_int(handle, "ns");
+	record->value = mock_get_optional_string(handle, "value");
+	record->source = mock_get_optional_string(handle, "source");
+	record->timestamp = mock_get_optional_int(handle, "timestamp");
+	record->severity = mock_get_optional_int(handle, "severity");
+	record->logeventid = mock_get_optional_int(handle, "logeventid");
+	record->state = (unsigned char)mock_get_optional_int(handle, "state");
+	record->meta = (unsigned char)mock_get_optional_int(handle, "meta");
+	record->lastlogsize = mock_get_optional_uint64(handle, "lastlogsize");
+	record->mtime = mock_get_optional_int(handle, "mtime");
+}
+
+static void	mock_compare_record(int index, const zbx_hb_record_t *record, zbx_uint64_t itemid,
+		const zbx_agent_value_t *av)
+{
+	char	prefix[MAX_STRING_LEN];
+
+	zbx_snprintf(prefix, sizeof(prefix), "record #%d ", index);
+
+	zbx_mock_assert_uint64_eq(prefix, record->id, av->id);
+	zbx_mock_assert_uint64_eq(prefix, record->itemid, itemid);
+	zbx_mock_assert_int_eq(prefix, record->clock, av->ts.sec);
+	zbx_mock_assert_int_eq(prefix, record->ns, av->ts.ns);
+	zbx_mock_assert_int_eq(prefix, record->state, av->state);
+
+	if (NULL == record->value)
+		zbx_mock_assert_ptr_eq(prefix, NULL, av->value);
+	else
+		zbx_mock_assert_str_eq(prefix, record->value, av->value);
+
+	if (NULL == record->source || '\0' == *record->source)
+		zbx_mock_assert_ptr_eq(prefix, NULL, av->source);
+	else
+		zbx_mock_assert_str_eq(prefix, record->source, av->source);
+
+	zbx_mock_assert_int_eq(prefix, record->timestamp, av->timestamp);
+	zbx_mock_assert_int_eq(prefix, record->severity, av->severity);
+	zbx_mock_assert_int_eq(prefix, record->logeventid, av->logeventid);
+	zbx_mock_assert_int_eq(prefix, record->meta, av->meta);
+	zbx_mock_assert_uint64_eq(prefix, record->lastlogsize, av->lastlogsize);
+	zbx_mock_assert_int_eq(prefix, record->mtime, av->mtime);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hrecords, hrecord;
+	zbx_hb_writer_t		writer;
+	zbx_hb_reader_t		reader;
+	zbx_hb_record_t		*records = NULL;
+	zbx_agent_value_t	av;
+	zbx_uint64_t		itemid;
+	char			*text, *error = NULL;
+	int			i, records_num = 0, expected_ret, ret, raw_data;
+
+	ZBX_UNUSED(state);
+
+	expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.return"));
+
+	raw_data = (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.data", &hrecord) ? SUCCEED : FAIL);
+
+	if (SUCCEED == raw_data)
+	{
+		text = zbx_strdup(NULL, zbx_mock_get_parameter_string("in.data"));
+	}
+	else
+	{
+		hrecords = zbx_mock_get_parameter_handle("in.records");
+		zbx_hb_writer_init(&writer);
+
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrecords, &hrecord))
+		{
+			records = (zbx_hb_record_t *)zbx_realloc(records, sizeof(zbx_hb_record_t) * (records_num + 1));
+			mock_read_record(hrecord, &records[records_num]);
+			zbx_hb_writer_add(&writer, &records[records_num++]);
+		}
+
+		text = zbx_hb_writer_encode(&writer);
+		zbx_hb_writer_clear(&writer);
+	}
+
+	if (SUCCEED == (ret = zbx_hb_reader_open(&reader, text, &error)))
+	{
+		for (i = 0; 0 != reader.records_left; i++)
+		{
+			if (SUCCEED != (ret = zbx_hb_reader_read(&reader, &itemid, &av, &error)))
+				break;
+
+			if (i < records_num)
+				mock_compare_record(i, &records[i], itemid, &av);
+
+			zbx_free(av.value);
+			zbx_free(av.source);
+		}
+
+		if (SUCCEED == ret && SUCCEED != raw_data)
+			zbx_mock_assert_int_eq("number of records read", records_num, i);
+
+		zbx_hb_reader_close(&reader);
+	}
+
+	zbx_mock_assert_result_eq("zbx_hb_reader_read() return value", expected_ret, ret);
+
+	zbx_free(error);
+	zbx_free(text);
+	zbx_free(records);
+}
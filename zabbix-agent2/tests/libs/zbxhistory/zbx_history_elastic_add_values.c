@@ -0,0 +1,508 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxalgo.h"
+#include "log.h"
+#include "dbcache.h"
+#include "zbxhistory.h"
+#include "../../../src/libs/zbxhistory/history.h"
+
+#ifdef HAVE_LIBCURL
+
+#include <pthread.h>
+#include <poll.h>
+#include <zlib.h>
+
+#define MOCK_CLIENTS_MAX	16
+
+extern char	*CONFIG_HISTORY_STORAGE_URL;
+
+unsigned int	__wrap_sleep(unsigned int seconds);
+void	__wrap_zbx_sleep_loop(int sleeptime);
+zbx_uint64_t	__wrap_DCget_nextid(const char *table_name, int num);
+int	__wrap_zbx_interface_availability_is_set(const zbx_interface_availability_t *ha);
+int	__wrap_zbx_add_event(unsigned char source, unsigned char object, zbx_uint64_t objectid,
+		const zbx_timespec_t *timespec, int value, const char *trigger_description,
+		const char *trigger_expression, const char *trigger_recovery_expression, unsigned char trigger_priority,
+		unsigned char trigger_type, const zbx_vector_ptr_t *trigger_tags,
+		unsigned char trigger_correlation_mode, const char *trigger_correlation_tag,
+		unsigned char trigger_value, const char *trigger_opdata, const char *error);
+int	__wrap_zbx_process_events(zbx_vector_ptr_t *trigger_diff, zbx_vector_uint64_t *triggerids_lock);
+void	__wrap_zbx_clean_events(void);
+
+/* the client connection of the mocked elasticsearch server */
+typedef struct
+{
+	int	fd;
+	char	*data;
+	size_t	data_alloc;
+	size_t	data_offset;
+	int	continued;	/* 1 if 100-continue response was sent for the current request */
+}
+mock_client_t;
+
+/* the mocked elasticsearch server answering bulk requests with the configured responses */
+typedef struct
+{
+	int			fd;
+	unsigned short		port;
+	zbx_vector_str_t	responses;	/* the response bodies, the last one is repeated */
+	zbx_vector_str_t	requests;	/* the received request bodies, uncompressed */
+	int			gzip_num;	/* the number of requests with gzip encoded body */
+	mock_client_t		clients[MOCK_CLIENTS_MAX];
+	int			clients_num;
+	volatile int		stop;
+}
+mock_server_t;
+
+void	__wrap_zbx_sleep_loop(int sleeptime)
+{
+	ZBX_UNUSED(sleeptime);
+}
+
+zbx_uint64_t	__wrap_DCget_nextid(const char *table_name, int num)
+{
+	ZBX_UNUSED(table_name);
+	ZBX_UNUSED(num);
+	return 0;
+}
+
+int	__wrap_zbx_interface_availability_is_set(const zbx_interface_availability_t *ha)
+{
+	ZBX_UNUSED(ha);
+	return SUCCEED;
+}
+
+int	__wrap_zbx_add_event(unsigned char source, unsigned char object, zbx_uint64_t objectid,
+		const zbx_timespec_t *timespec, int value, const char *trigger_description,
+		const char *trigger_expression, const char *trigger_recovery_expression, unsigned char trigger_priority,
+		unsigned char trigger_type, const zbx_vector_ptr_t *trigger_tags,
+		unsigned char trigger_correlation_mode, const char *trigger_correlation_tag,
+		unsigned char trigger_value, const char *trigger_opdata, const char *error)
+{
+	ZBX_UNUSED(source);
+	ZBX_UNUSED(object);
+	ZBX_UNUSED(objectid);
+	ZBX_UNUSED(timespec);
+	ZBX_UNUSED(value);
+	ZBX_UNUSED(trigger_description);
+	ZBX_UNUSED(trigger_expression);
+	ZBX_UNUSED(trigger_recovery_expression);
+	ZBX_UNUSED(trigger_priority);
+	ZBX_UNUSED(trigger_type);
+	ZBX_UNUSED(trigger_tags);
+	ZBX_UNUSED(trigger_correlation_mode);
+	ZBX_UNUSED(trigger_correlation_tag);
+	ZBX_UNUSED(trigger_value);
+	ZBX_UNUSED(trigger_opdata);
+	ZBX_UNUSED(error);
+	return SUCCEED;
+
+}
+
+int	__wrap_zbx_process_events(zbx_vector_ptr_t *trigger_diff, zbx_vector_uint64_t *triggerids_lock)
+{
+	ZBX_UNUSED(trigger_diff);
+	ZBX_UNUSED(triggerids_lock);
+	return SUCCEED;
+}
+
+void	__wrap_zbx_clean_events(void)
+{
+}
+
+unsigned int	__wrap_sleep(unsigned int seconds)
+{
+	ZBX_UNUSED(seconds);
+
+	return 0;
+}
+
+static char	*mock_gunzip(const char *in, size_t size_in)
+{
+	z_stream	strm;
+	char		*out = NULL;
+	size_t		out_alloc = 0, out_offset = 0;
+	char		buf[4096];
+	int		ret;
+
+	memset(&strm, 0, sizeof(strm));
+
+	if (Z_OK != inflateInit2(&strm, MAX_WBITS + 16))
+		fail_msg("cannot initialize zlib stream");
+
+	strm.next_in = (Bytef *)in;
+	strm.avail_in = size_in;
+
+	do
+	{
+		strm.next_out = (Bytef *)buf;
+		strm.avail_out = sizeof(buf);
+
+		if (Z_OK != (ret = inflate(&strm, Z_NO_FLUSH)) && Z_STREAM_END != ret)
+			fail_msg("cannot decompress gzip request body: %d", ret);
+
+		zbx_strncpy_alloc(&out, &out_alloc, &out_offset, buf, sizeof(buf) - strm.avail_out);
+	}
+	while (Z_STREAM_END != ret);
+
+	inflateEnd(&strm);
+
+	if (NULL == out)
+		out = zbx_strdup(NULL, "");
+
+	return out;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_client_append                                               *
+ *                                                                            *
+ * Purpose: appends received data to client buffer, the data can contain      *
+ *          zero bytes (gzip encoded request body)                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_client_append(mock_client_t *client, const char *data, size_t size)
+{
+	if (client->data_alloc < client->data_offset + size + 1)
+	{
+		client->data_alloc = client->data_offset + size + 1;
+		client->data = (char *)zbx_realloc(client->data, client->data_alloc);
+	}
+
+	memcpy(client->data + client->data_offset, data, size);
+	client->data_offset += size;
+	client->data[client->data_offset] = '\0';
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_client_process                                              *
+ *                                                                            *
+ * Purpose: answers complete requests received from client                    *
+ *                                                                            *
+ * Return value: SUCCEED - the client data was processed                      *
+ *               FAIL    - the client request is malformed                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	mock_client_process(mock_server_t *server, mock_client_t *client)
+{
+	char		*end, *ptr, response[1024];
+	const char	*body;
+	size_t		headers_len, body_len;
+	int		index;
+
+	while (NULL != client->data && NULL != (end = strstr(client->data, "\r\n\r\n")))
+	{
+		headers_len = (size_t)(end - client->data) + 4;
+		*end = '\0';
+
+		if (NULL == (ptr = zbx_strcasestr(client->data, "\r\nContent-Length:")))
+			return FAIL;
+
+		body_len = (size_t)strtoul(ptr + ZBX_CONST_STRLEN("\r\nContent-Length:"), NULL, 10);
+
+		if (client->data_offset < headers_len + body_len)
+		{
+			/* let the client send body if it waits for confirmation */
+			if (0 == client->continued && NULL != zbx_strcasestr(client->data, "\r\nExpect: 100-continue"))
+			{
+				zbx_snprintf(response, sizeof(response), "HTTP/1.1 100 Continue\r\n\r\n");
+
+				if (-1 == send(client->fd, response, strlen(response), MSG_NOSIGNAL))
+					return FAIL;
+
+				client->continued = 1;
+			}
+
+			*end = '\r';
+			break;
+		}
+
+		if (NULL != zbx_strcasestr(client->data, "\r\nContent-Encoding: gzip"))
+		{
+			server->gzip_num++;
+			zbx_vector_str_append(&server->requests, mock_gunzip(client->data + headers_len, body_len));
+		}
+		else
+			zbx_vector_str_append(&server->requests, zbx_dsprintf(NULL, "%.*s", (int)body_len,
+					client->data + headers_len));
+
+		if (server->requests.values_num <= (index = server->responses.values_num))
+			index = server->requests.values_num;
+
+		body = server->responses.values[index - 1];
+
+		zbx_snprintf(response, sizeof(response), "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+				"Content-Length: " ZBX_FS_SIZE_T "\r\n\r\n", (zbx_fs_size_t)strlen(body));
+
+		if (-1 == send(client->fd, response, strlen(response), MSG_NOSIGNAL) ||
+				-1 == send(client->fd, body, strlen(body), MSG_NOSIGNAL))
+		{
+			return FAIL;
+		}
+
+		client->continued = 0;
+		client->data_offset -= headers_len + body_len;
+		memmove(client->data, client->data + headers_len + body_len, client->data_offset);
+		client->data[client->data_offset] = '\0';
+	}
+
+	return SUCCEED;
+}
+
+static void	*mock_server_run(void *arg)
+{
+	mock_server_t	*server = (mock_server_t *)arg;
+	struct pollfd	pfds[MOCK_CLIENTS_MAX + 1];
+	char		buf[65536];
+	int		i, fd;
+	ssize_t		n;
+
+	while (0 == server->stop)
+	{
+		pfds[0].fd = server->fd;
+		pfds[0].events = POLLIN;
+
+		for (i = 0; i < server->clients_num; i++)
+		{
+			pfds[i + 1].fd = server->clients[i].fd;
+			pfds[i + 1].events = POLLIN;
+		}
+
+		if (0 >= poll(pfds, (nfds_t)server->clients_num + 1, 100))
+			continue;
+
+		for (i = server->clients_num - 1; i >= 0; i--)
+		{
+			mock_client_t	*client = &server->clients[i];
+
+			if (0 == (pfds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)))
+				continue;
+
+			/* read() is wrapped for all tests, receive data from socket directly */
+			if (0 >= (n = recv(client->fd, buf, sizeof(buf), 0)))
+				goto close;
+
+			mock_client_append(client, buf, (size_t)n);
+
+			if (SUCCEED == mock_client_process(server, client))
+				continue;
+close:
+			close(client->fd);
+			zbx_free(client->data);
+			*client = server->clients[--server->clients_num];
+		}
+
+		if (0 != (pfds[0].revents & POLLIN) && -1 != (fd = accept(server->fd, NULL, NULL)))
+		{
+			if (MOCK_CLIENTS_MAX == server->clients_num)
+			{
+				close(fd);
+				continue;
+			}
+
+			memset(&server->clients[server->clients_num], 0, sizeof(mock_client_t));
+			server->clients[server->clients_num++].fd = fd;
+		}
+	}
+
+	for (i = 0; i < server->clients_num; i++)
+	{
+		close(server->clients[i].fd);
+		zbx_free(server->clients[i].data);
+	}
+
+	return NULL;
+}
+
+static void	mock_server_start(mock_server_t *server, pthread_t *thread)
+{
+	struct sockaddr_in	addr;
+	socklen_t		addr_len = sizeof(addr);
+
+	if (-1 == (server->fd = socket(AF_INET, SOCK_STREAM, 0)))
+		fail_msg("cannot create socket: %s", zbx_strerror(errno));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if (0 != bind(server->fd, (struct sockaddr *)&addr, sizeof(addr)) || 0 != listen(server->fd, 16) ||
+			0 != getsockname(server->fd, (struct sockaddr *)&addr, &addr_len))
+	{
+		fail_msg("cannot listen on loopback interface: %s", zbx_strerror(errno));
+	}
+
+	server->port = ntohs(addr.sin_port);
+
+	if (0 != pthread_create(thread, NULL, mock_server_run, server))
+		fail_msg("cannot create server thread");
+}
+
+static void	mock_read_values(zbx_vector_ptr_t *history)
+{
+	zbx_mock_handle_t	hvalues, hvalue;
+	ZBX_DC_HISTORY		*h;
+	int			i, num;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.generate", &hvalue))
+	{
+		num = atoi(zbx_mock_get_parameter_string("in.generate"));
+
+		for (i = 0; i < num; i++)
+		{
+			h = (ZBX_DC_HISTORY *)zbx_malloc(NULL, sizeof(ZBX_DC_HISTORY));
+			memset(h, 0, sizeof(ZBX_DC_HISTORY));
+			h->itemid = (zbx_uint64_t)(i % 100 + 1);
+			h->value_type = ITEM_VALUE_TYPE_UINT64;
+			h->value.ui64 = (zbx_uint64_t)i;
+			h->ts.sec = 1600000000 + i;
+			zbx_vector_ptr_append(history, h);
+		}
+
+		return;
+	}
+
+	hvalues = zbx_mock_get_parameter_handle("in.values");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hvalues, &hvalue))
+	{
+		h = (ZBX_DC_HISTORY *)zbx_malloc(NULL, sizeof(ZBX_DC_HISTORY));
+		memset(h, 0, sizeof(ZBX_DC_HISTORY));
+		h->itemid = zbx_mock_get_object_member_uint64(hvalue, "itemid");
+		h->value_type = ITEM_VALUE_TYPE_UINT64;
+		h->value.ui64 = zbx_mock_get_object_member_uint64(hvalue, "value");
+		h->ts.sec = zbx_mock_get_object_member_int(hvalue, "clock");
+		h->ts.ns = zbx_mock_get_object_member_int(hvalue, "ns");
+		zbx_vector_ptr_append(history, h);
+	}
+}
+
+static int	mock_count_lines(const char *text)
+{
+	int	num = 0;
+
+	for (; NULL != (text = strchr(text, '\n')); text++)
+		num++;
+
+	return num;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hresponses, hrequests, handle;
+	zbx_history_iface_t	hist;
+	zbx_vector_ptr_t	history;
+	mock_server_t		server;
+	pthread_t		thread;
+	char			*error = NULL;
+	const char		*response;
+	int			i, ret, docs_num = 0;
+
+	ZBX_UNUSED(state);
+
+	memset(&server, 0, sizeof(server));
+	zbx_vector_str_create(&server.responses);
+	zbx_vector_str_create(&server.requests);
+
+	hresponses = zbx_mock_get_parameter_handle("in.responses");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hresponses, &handle))
+	{
+		if (ZBX_MOCK_SUCCESS != zbx_mock_string(handle, &response))
+			fail_msg("invalid response");
+
+		zbx_vector_str_append(&server.responses, zbx_strdup(NULL, response));
+	}
+
+	mock_server_start(&server, &thread);
+
+	CONFIG_HISTORY_STORAGE_URL = zbx_dsprintf(NULL, "http://127.0.0.1:%hu", server.port);
+
+	ret = zbx_history_elastic_init(&hist, ITEM_VALUE_TYPE_UINT64, &error);
+	zbx_mock_assert_result_eq("zbx_history_elastic_init() return value", SUCCEED, ret);
+
+	zbx_vector_ptr_create(&history);
+	mock_read_values(&history);
+
+	zbx_mock_assert_int_eq("number of added values", history.values_num, hist.add_values(&hist, &history));
+	zbx_mock_assert_result_eq("flush return value", SUCCEED, hist.flush(&hist));
+
+	server.stop = 1;
+	pthread_join(thread, NULL);
+	close(server.fd);
+
+	zbx_mock_assert_int_eq("number of gzip encoded requests", server.requests.values_num, server.gzip_num);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("out.requests", &hrequests))
+	{
+		for (i = 0; ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrequests, &handle); i++)
+		{
+			const char	*expected;
+
+			if (i >= server.requests.values_num)
+				fail_msg("expected more than %d requests", server.requests.values_num);
+
+			if (ZBX_MOCK_SUCCESS != zbx_mock_string(handle, &expected))
+				fail_msg("invalid expected request");
+
+			zbx_mock_assert_str_eq("request body", expected, server.requests.values[i]);
+		}
+
+		zbx_mock_assert_int_eq("number of requests", i, server.requests.values_num);
+	}
+	else
+	{
+		for (i = 0; i < server.requests.values_num; i++)
+			docs_num += mock_count_lines(server.requests.values[i]) / 2;
+
+		zbx_mock_assert_int_eq("number of requests",
+				atoi(zbx_mock_get_parameter_string("out.requests_num")), server.requests.values_num);
+		zbx_mock_assert_int_eq("number of sent documents", history.values_num, docs_num);
+	}
+
+	hist.destroy(&hist);
+
+	zbx_vector_ptr_clear_ext(&history, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&history);
+	zbx_vector_str_clear_ext(&server.requests, zbx_str_free);
+	zbx_vector_str_destroy(&server.requests);
+	zbx_vector_str_clear_ext(&server.responses, zbx_str_free);
+	zbx_vector_str_destroy(&server.responses);
+	zbx_free(CONFIG_HISTORY_STORAGE_URL);
+	zbx_free(error);
+}
+
+#else
+
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+	skip();
+}
+
+#endif
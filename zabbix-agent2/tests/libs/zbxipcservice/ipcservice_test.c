@@ -0,0 +1,62 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "ipcservice_test.h"
+
+/* returns the shared memory ring attached by service for the client and the number of bytes read from it */
+int	ipc_client_shm_test(const zbx_ipc_client_t *client, int *shmid, zbx_uint32_t *position)
+{
+#if defined(ZBX_IPC_SHM_ENABLED)
+	if (NULL == client->csocket.shm)
+		return FAIL;
+
+	*shmid = client->csocket.shm->shmid;
+	*position = client->csocket.shm->position;
+
+	return SUCCEED;
+#else
+	ZBX_UNUSED(client);
+	ZBX_UNUSED(shmid);
+	ZBX_UNUSED(position);
+
+	return FAIL;
+#endif
+}
+
+/* returns the size of shared memory segment with ring of the specified size */
+size_t	ipc_shm_segment_size_test(zbx_uint32_t size)
+{
+#if defined(ZBX_IPC_SHM_ENABLED)
+	return sizeof(zbx_ipc_shm_header_t) + size;
+#else
+	return size;
+#endif
+}
+
+/* sends shared memory attach request for the specified segment the same way as ipc_shm_create() does */
+int	ipc_socket_shm_attach_test(zbx_ipc_socket_t *csocket, int shmid, zbx_uint32_t size)
+{
+	zbx_uint32_t	request[2], tx_size;
+
+	request[0] = (zbx_uint32_t)shmid;
+	request[1] = size;
+
+	return ipc_socket_write_message(csocket, ZBX_IPC_CODE_SHM_ATTACH, (const unsigned char *)request,
+			sizeof(request), &tx_size);
+}
@@ -0,0 +1,29 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef IPCSERVICE_TEST_H
+#define IPCSERVICE_TEST_H
+
+#include "zbxipcservice.h"
+
+int	ipc_client_shm_test(const zbx_ipc_client_t *client, int *shmid, zbx_uint32_t *position);
+int	ipc_socket_shm_attach_test(zbx_ipc_socket_t *csocket, int shmid, zbx_uint32_t size);
+size_t	ipc_shm_segment_size_test(zbx_uint32_t size);
+
+#endif /* IPCSERVICE_TEST_H */
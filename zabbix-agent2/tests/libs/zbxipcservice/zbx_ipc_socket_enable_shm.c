@@ -0,0 +1,258 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "log.h"
+#include "zbxipcservice.h"
+#include "ipcservice_test.h"
+
+/* Forked client sends messages to IPC service running in the test process. The client waits for */
+/* acknowledgement of the first message, so the service has processed the shared memory attach */
+/* request before the rest of messages are sent. With "ack" option every message is acknowledged. */
+
+#define TEST_SERVICE		"shmtest"
+#define TEST_CODE_ACK		1
+#define TEST_TIMEOUT		10
+
+static void	mock_fill_message(unsigned char *data, zbx_uint32_t size, int index)
+{
+	zbx_uint32_t	i;
+
+	for (i = 0; i < size; i++)
+		data[i] = (unsigned char)(index * 31 + i);
+}
+
+static int	mock_read_messages(zbx_uint32_t **sizes)
+{
+	zbx_mock_handle_t	hmessages, hmessage;
+	zbx_mock_error_t	err;
+	zbx_uint64_t		size;
+	int			num = 0;
+
+	hmessages = zbx_mock_get_parameter_handle("in.messages");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hmessages, &hmessage))))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hmessage, &size)))
+			fail_msg("Cannot read message size: %s", zbx_mock_error_string(err));
+
+		*sizes = (zbx_uint32_t *)zbx_realloc(*sizes, sizeof(zbx_uint32_t) * (size_t)(num + 1));
+		(*sizes)[num++] = (zbx_uint32_t)size;
+	}
+
+	return num;
+}
+
+static void	client_wait_ack(zbx_ipc_socket_t *csocket)
+{
+	zbx_ipc_message_t	message;
+
+	if (SUCCEED != zbx_ipc_socket_read(csocket, &message) || TEST_CODE_ACK != message.code)
+		_exit(EXIT_FAILURE);
+
+	zbx_ipc_message_clean(&message);
+}
+
+/* sends messages to service, using shared memory ring or attach request for the specified segment */
+static void	client_run(zbx_uint32_t ring, int shmid, const zbx_uint32_t *sizes, int num, int ack)
+{
+	zbx_ipc_socket_t	csocket;
+	unsigned char		*data;
+	char			*error = NULL;
+	int			i;
+
+	if (SUCCEED != zbx_ipc_socket_open(&csocket, TEST_SERVICE, TEST_TIMEOUT, &error))
+		_exit(EXIT_FAILURE);
+
+	if (-1 != shmid)
+	{
+		if (SUCCEED != ipc_socket_shm_attach_test(&csocket, shmid, ring))
+			_exit(EXIT_FAILURE);
+	}
+	else
+		zbx_ipc_socket_enable_shm(&csocket, ring);
+
+	for (i = 0; i < num; i++)
+	{
+		data = (unsigned char *)zbx_malloc(NULL, sizes[i]);
+		mock_fill_message(data, sizes[i], i);
+
+		if (SUCCEED != zbx_ipc_socket_write(&csocket, (zbx_uint32_t)i + 2, data, sizes[i]))
+			_exit(EXIT_FAILURE);
+
+		zbx_free(data);
+
+		if (0 == i || 0 != ack)
+			client_wait_ack(&csocket);
+	}
+
+	/* stay attached until service has checked the segment */
+	client_wait_ack(&csocket);
+
+	zbx_ipc_socket_close(&csocket);
+
+	_exit(EXIT_SUCCESS);
+}
+
+/* receives the next client message, skipping event loop iterations that only accept connections */
+static zbx_ipc_client_t	*service_recv(zbx_ipc_service_t *service, zbx_ipc_message_t **message)
+{
+	zbx_ipc_client_t	*client;
+	zbx_timespec_t		timeout = {1, 0};
+	time_t			deadline;
+
+	deadline = time(NULL) + TEST_TIMEOUT;
+
+	do
+	{
+		if (time(NULL) > deadline)
+			fail_msg("timeout while waiting for message");
+
+		zbx_ipc_service_recv(service, &timeout, &client, message);
+	}
+	while (NULL == client);
+
+	return client;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	char			path[] = "/tmp/zbx_ipc_shm_XXXXXX", *error = NULL;
+	zbx_ipc_service_t	service;
+	zbx_ipc_client_t	*client;
+	zbx_ipc_message_t	*message;
+	zbx_uint32_t		*sizes = NULL, ring, position;
+	unsigned char		*data;
+	int			i, num, ack, shmid, foreign_shmid = -1, status;
+	pid_t			pid;
+	struct shmid_ds		ds;
+
+	ZBX_UNUSED(state);
+
+	num = mock_read_messages(&sizes);
+	ring = (zbx_uint32_t)zbx_mock_get_parameter_uint64("in.ring");
+	ack = ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.ack") ?
+			(0 == strcmp(zbx_mock_get_parameter_string("in.ack"), "yes")) : 0;
+
+	if (NULL == mkdtemp(path))
+		fail_msg("cannot create temporary directory: %s", zbx_strerror(errno));
+
+	zbx_mock_file_passthrough(path);
+	zbx_mock_socket_passthrough(1);
+
+	if (SUCCEED != zbx_ipc_service_init_env(path, &error))
+		fail_msg("cannot initialize IPC service environment: %s", error);
+
+	if (SUCCEED != zbx_ipc_service_start(&service, TEST_SERVICE, &error))
+		fail_msg("cannot start IPC service: %s", error);
+
+	/* the segment is created by this process, so client is not allowed to use it */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.foreign") &&
+			-1 == (foreign_shmid = shmget(IPC_PRIVATE, ipc_shm_segment_size_test(ring),
+			IPC_CREAT | IPC_EXCL | 0600)))
+	{
+		fail_msg("cannot allocate shared memory: %s", zbx_strerror(errno));
+	}
+
+	if (0 == (pid = fork()))
+		client_run(ring, foreign_shmid, sizes, num, ack);
+
+	if (-1 == pid)
+		fail_msg("cannot fork: %s", zbx_strerror(errno));
+
+	for (i = 0; i < num;)
+	{
+		client = service_recv(&service, &message);
+
+		if (NULL == message)
+			fail_msg("client disconnected before sending message #%d", i + 1);
+
+		zbx_mock_assert_uint64_eq("message code", (zbx_uint64_t)i + 2, message->code);
+		zbx_mock_assert_uint64_eq("message size", sizes[i], message->size);
+
+		data = (unsigned char *)zbx_malloc(NULL, sizes[i]);
+		mock_fill_message(data, sizes[i], i);
+
+		if (0 != memcmp(data, message->data, sizes[i]))
+			fail_msg("message #%d contents differ", i + 1);
+
+		zbx_free(data);
+		zbx_ipc_message_free(message);
+
+		if (0 == i || 0 != ack)
+			zbx_ipc_client_send(client, TEST_CODE_ACK, NULL, 0);
+
+		if (++i == num)
+			break;
+
+		zbx_ipc_client_release(client);
+	}
+
+	if (SUCCEED == ipc_client_shm_test(client, &shmid, &position))
+	{
+		if (ZBX_MOCK_SUCCESS != zbx_mock_parameter_exists("out.ring"))
+			fail_msg("unexpected shared memory ring attached");
+
+		zbx_mock_assert_uint64_eq("bytes sent through ring", zbx_mock_get_parameter_uint64("out.ring"),
+				position);
+
+		/* both sides are attached and the segment is already marked for removal */
+		if (0 != shmctl(shmid, IPC_STAT, &ds))
+			fail_msg("cannot get shared memory status: %s", zbx_strerror(errno));
+
+		zbx_mock_assert_int_eq("attached processes", 2, (int)ds.shm_nattch);
+#ifdef SHM_DEST
+		zbx_mock_assert_int_ne("segment marked for removal", 0, ds.shm_perm.mode & SHM_DEST);
+#endif
+	}
+	else if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("out.ring"))
+		fail_msg("shared memory ring was not attached");
+	else
+		shmid = -1;
+
+	zbx_ipc_client_send(client, TEST_CODE_ACK, NULL, 0);
+	zbx_ipc_client_release(client);
+
+	if (-1 == waitpid(pid, &status, 0))
+		fail_msg("cannot wait for client process: %s", zbx_strerror(errno));
+
+	zbx_mock_assert_int_eq("client exit status", EXIT_SUCCESS, WEXITSTATUS(status));
+
+	zbx_ipc_service_close(&service);
+
+	/* the segment is released after the last process detaches */
+	if (-1 != shmid && 0 == shmctl(shmid, IPC_STAT, &ds))
+		fail_msg("shared memory segment was not released");
+
+	if (-1 != foreign_shmid)
+		(void)shmctl(foreign_shmid, IPC_RMID, NULL);
+
+	zbx_free(sizes);
+	zbx_ipc_service_free_env();
+
+	zbx_mock_socket_passthrough(0);
+	zbx_mock_file_passthrough(NULL);
+
+	rmdir(path);
+}
@@ -0,0 +1,78 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxjson.h"
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char		*json, *result, *name, *p_index, *p_linear;
+	struct zbx_json_parse	jp;
+	zbx_json_index_t	index;
+	zbx_mock_handle_t	hlookups, hlookup, hvalue;
+	char			*value = NULL;
+	size_t			value_alloc = 0;
+	int			ret;
+
+	ZBX_UNUSED(state);
+
+	json = zbx_mock_get_parameter_string("in.json");
+	result = zbx_mock_get_parameter_string("out.result");
+
+	ret = zbx_json_open(json, &jp);
+	zbx_mock_assert_result_eq("Invalid zbx_json_open() return value", SUCCEED, ret);
+
+	zbx_json_index_init(&index);
+
+	if (FAIL == (ret = zbx_json_index_load(&index, &jp)))
+	{
+		printf("zbx_json_index_load() error: %s\n", zbx_json_strerror());
+		zbx_mock_assert_str_eq("Invalid zbx_json_index_load() return value", result, "fail");
+		goto out;
+	}
+
+	zbx_mock_assert_str_eq("Invalid zbx_json_index_load() return value", result, "succeed");
+
+	hlookups = zbx_mock_get_parameter_handle("in.lookups");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hlookups, &hlookup))
+	{
+		name = zbx_mock_get_object_member_string(hlookup, "name");
+
+		/* indexed lookup must find the same member as linear scan */
+		p_index = zbx_json_index_pair_by_name(&index, name);
+		p_linear = zbx_json_pair_by_name(&jp, name);
+		zbx_mock_assert_ptr_eq("Invalid zbx_json_index_pair_by_name() return value", p_linear, p_index);
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hlookup, "value", &hvalue))
+			continue;
+
+		ret = zbx_json_index_value_by_name_dyn(&index, name, &value, &value_alloc, NULL);
+		zbx_mock_assert_result_eq("Invalid zbx_json_index_value_by_name_dyn() return value", SUCCEED, ret);
+		zbx_mock_assert_str_eq("Invalid value", zbx_mock_get_object_member_string(hlookup, "value"), value);
+	}
+out:
+	zbx_json_index_clear(&index);
+	zbx_free(value);
+}
@@ -0,0 +1,175 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxjson.h"
+
+/* Compares linear and indexed object member lookups on generated proxy data message. Each history  */
+/* row is looked up by the same names as parse_history_data_row_value() and                         */
+/* parse_history_data_row_itemid() do, top level lookups are the ones made by process_proxy_data(). */
+
+static const char	*row_names[] = {ZBX_PROTO_TAG_CLOCK, ZBX_PROTO_TAG_NS, ZBX_PROTO_TAG_STATE,
+		ZBX_PROTO_TAG_LASTLOGSIZE, ZBX_PROTO_TAG_MTIME, ZBX_PROTO_TAG_VALUE, ZBX_PROTO_TAG_LOGTIMESTAMP,
+		ZBX_PROTO_TAG_LOGSOURCE, ZBX_PROTO_TAG_LOGSEVERITY, ZBX_PROTO_TAG_LOGEVENTID, ZBX_PROTO_TAG_ID,
+		ZBX_PROTO_TAG_ITEMID, NULL};
+
+static const char	*top_names[] = {ZBX_PROTO_TAG_MORE, ZBX_PROTO_TAG_PROXY_DELAY,
+		ZBX_PROTO_TAG_INTERFACE_AVAILABILITY, ZBX_PROTO_TAG_HISTORY_DATA, ZBX_PROTO_TAG_SESSION,
+		ZBX_PROTO_TAG_DISCOVERY_DATA, ZBX_PROTO_TAG_AUTOREGISTRATION, ZBX_PROTO_TAG_TASKS, NULL};
+
+static zbx_uint64_t	bench_rand(zbx_uint64_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 7;
+	*seed ^= *seed << 17;
+
+	return *seed;
+}
+
+static void	bench_proxy_data(struct zbx_json *j, int rows, zbx_uint64_t seed)
+{
+	char	value[64];
+	int	i;
+
+	zbx_json_addstring(j, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_PROXY_DATA, ZBX_JSON_TYPE_STRING);
+	zbx_json_addstring(j, ZBX_PROTO_TAG_HOST, "Zabbix proxy", ZBX_JSON_TYPE_STRING);
+	zbx_json_addstring(j, ZBX_PROTO_TAG_SESSION, "3e4ebc9a2c4b6d3fa1b5f5e6b1e0c2d7", ZBX_JSON_TYPE_STRING);
+
+	zbx_json_addobject(j, ZBX_PROTO_TAG_INTERFACE_AVAILABILITY);
+	zbx_json_close(j);
+
+	zbx_json_addarray(j, ZBX_PROTO_TAG_HISTORY_DATA);
+
+	for (i = 0; i < rows; i++)
+	{
+		zbx_json_addobject(j, NULL);
+		zbx_json_adduint64(j, ZBX_PROTO_TAG_ID, (zbx_uint64_t)i + 1);
+		zbx_json_adduint64(j, ZBX_PROTO_TAG_ITEMID, 100000 + bench_rand(&seed) % 100000);
+		zbx_json_adduint64(j, ZBX_PROTO_TAG_CLOCK, 1634000000 + (zbx_uint64_t)i / 100);
+		zbx_json_adduint64(j, ZBX_PROTO_TAG_NS, bench_rand(&seed) % 1000000000);
+		zbx_snprintf(value, sizeof(value), "%.6f", (double)(bench_rand(&seed) % 100000000) / 1000);
+		zbx_json_addstring(j, ZBX_PROTO_TAG_VALUE, value, ZBX_JSON_TYPE_STRING);
+		zbx_json_close(j);
+	}
+
+	zbx_json_close(j);
+
+	zbx_json_addstring(j, ZBX_PROTO_TAG_VERSION, ZABBIX_VERSION, ZBX_JSON_TYPE_STRING);
+	zbx_json_adduint64(j, ZBX_PROTO_TAG_CLOCK, 1634000000);
+	zbx_json_adduint64(j, ZBX_PROTO_TAG_NS, 0);
+	zbx_json_close(j);
+}
+
+/* looks up members the same way as proxy data processing, returns checksum of found values */
+static zbx_uint64_t	bench_lookup(const struct zbx_json_parse *jp, zbx_json_index_t *index, char **value,
+		size_t *value_alloc)
+{
+	struct zbx_json_parse	jp_data, jp_row;
+	const char		*p = NULL, **name, *pair;
+	zbx_uint64_t		sum = 0;
+
+	if (NULL != index && SUCCEED != zbx_json_index_load(index, jp))
+		fail_msg("cannot index proxy data: %s", zbx_json_strerror());
+
+	for (name = top_names; NULL != *name; name++)
+	{
+		pair = (NULL != index ? zbx_json_index_pair_by_name(index, *name) : zbx_json_pair_by_name(jp, *name));
+
+		if (NULL != pair)
+			sum += (zbx_uint64_t)(pair - jp->start);
+	}
+
+	if (SUCCEED != (NULL != index ? zbx_json_index_brackets_by_name(index, ZBX_PROTO_TAG_HISTORY_DATA, &jp_data) :
+			zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_HISTORY_DATA, &jp_data)))
+	{
+		fail_msg("cannot find history data");
+	}
+
+	while (NULL != (p = zbx_json_next(&jp_data, p)))
+	{
+		if (SUCCEED != zbx_json_brackets_open(p, &jp_row))
+			fail_msg("cannot open history data row");
+
+		if (NULL != index && SUCCEED != zbx_json_index_load(index, &jp_row))
+			fail_msg("cannot index history data row: %s", zbx_json_strerror());
+
+		for (name = row_names; NULL != *name; name++)
+		{
+			if (SUCCEED == (NULL != index ?
+					zbx_json_index_value_by_name_dyn(index, *name, value, value_alloc, NULL) :
+					zbx_json_value_by_name_dyn(&jp_row, *name, value, value_alloc, NULL)))
+			{
+				sum += strlen(*value) + (unsigned char)**value;
+			}
+		}
+	}
+
+	return sum;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	struct zbx_json		j;
+	struct zbx_json_parse	jp;
+	zbx_json_index_t	index;
+	zbx_uint64_t		sum_linear = 0, sum_index = 0;
+	char			*value = NULL;
+	size_t			value_alloc = 0;
+	int			i, rows, iterations;
+	double			time_start, time_linear, time_index;
+
+	ZBX_UNUSED(state);
+
+	rows = (int)zbx_mock_get_parameter_uint64("in.rows");
+	iterations = (int)zbx_mock_get_parameter_uint64("in.iterations");
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	bench_proxy_data(&j, rows, zbx_mock_get_parameter_uint64("in.seed"));
+
+	if (SUCCEED != zbx_json_open(j.buffer, &jp))
+		fail_msg("cannot open proxy data: %s", zbx_json_strerror());
+
+	time_start = zbx_time();
+	for (i = 0; i < iterations; i++)
+		sum_linear += bench_lookup(&jp, NULL, &value, &value_alloc);
+	time_linear = zbx_time() - time_start;
+
+	zbx_json_index_init(&index);
+
+	time_start = zbx_time();
+	for (i = 0; i < iterations; i++)
+		sum_index += bench_lookup(&jp, &index, &value, &value_alloc);
+	time_index = zbx_time() - time_start;
+
+	zbx_json_index_clear(&index);
+
+	printf("rows:%d size:" ZBX_FS_SIZE_T " bytes linear:%.2f ms index:%.2f ms per message\n", rows,
+			(zbx_fs_size_t)j.buffer_offset, time_linear * 1000 / iterations, time_index * 1000 / iterations);
+
+	/* both lookups must find the same members and values */
+	zbx_mock_assert_uint64_eq("checksum of found values", sum_linear, sum_index);
+
+	zbx_free(value);
+	zbx_json_free(&j);
+}
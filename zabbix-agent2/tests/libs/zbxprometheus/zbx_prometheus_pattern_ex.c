@@ -0,0 +1,114 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxprometheus.h"
+
+/* generates prometheus data with the specified number of metrics and rows per metric, */
+/* where value of metric M row R is M * rows + R                                        */
+static char	*generate_data(int metrics, int rows)
+{
+	char	*data = NULL;
+	size_t	data_alloc = 0, data_offset = 0;
+	int	i, j;
+
+	for (i = 0; i < metrics; i++)
+	{
+		zbx_snprintf_alloc(&data, &data_alloc, &data_offset, "# HELP test_metric_%d Test metric\n", i);
+		zbx_snprintf_alloc(&data, &data_alloc, &data_offset, "# TYPE test_metric_%d gauge\n", i);
+
+		for (j = 0; j < rows; j++)
+		{
+			zbx_snprintf_alloc(&data, &data_alloc, &data_offset,
+					"test_metric_%d{instance=\"localhost:9100\",id=\"%d\"} %d\n", i, j,
+					i * rows + j);
+		}
+	}
+
+	return data;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	int			i, metrics, rows, filters, ret;
+	char			*data, filter[MAX_STRING_LEN], expected[MAX_ID_LEN], **results, *value, *error = NULL;
+	double			time_start, time_pattern, time_pattern_ex;
+	zbx_prometheus_t	prom;
+
+	ZBX_UNUSED(state);
+
+	metrics = (int)zbx_mock_get_parameter_uint64("in.metrics");
+	rows = (int)zbx_mock_get_parameter_uint64("in.rows");
+	filters = (int)zbx_mock_get_parameter_uint64("in.filters");
+
+	data = generate_data(metrics, rows);
+	results = (char **)zbx_malloc(NULL, sizeof(char *) * filters);
+
+	/* query every filter by parsing data */
+
+	time_start = zbx_time();
+
+	for (i = 0; i < filters; i++)
+	{
+		zbx_snprintf(filter, sizeof(filter), "test_metric_%d{id=\"%d\"}", i % metrics, i % rows);
+
+		if (SUCCEED != zbx_prometheus_pattern(data, filter, "", &results[i], &error))
+			fail_msg("zbx_prometheus_pattern() failed with: %s", error);
+	}
+
+	time_pattern = zbx_time() - time_start;
+
+	/* query every filter from data parsed once */
+
+	time_start = zbx_time();
+
+	if (SUCCEED != zbx_prometheus_init(&prom, data, &error))
+		fail_msg("zbx_prometheus_init() failed with: %s", error);
+
+	for (i = 0; i < filters; i++)
+	{
+		zbx_snprintf(filter, sizeof(filter), "test_metric_%d{id=\"%d\"}", i % metrics, i % rows);
+
+		ret = zbx_prometheus_pattern_ex(&prom, filter, "", &value, &error);
+		zbx_mock_assert_result_eq("zbx_prometheus_pattern_ex() return value", SUCCEED, ret);
+
+		zbx_snprintf(expected, sizeof(expected), "%d", (i % metrics) * rows + i % rows);
+		zbx_mock_assert_str_eq("zbx_prometheus_pattern() returned value", expected, results[i]);
+		zbx_mock_assert_str_eq("zbx_prometheus_pattern_ex() returned value", expected, value);
+
+		zbx_free(value);
+	}
+
+	zbx_prometheus_clear(&prom);
+
+	time_pattern_ex = zbx_time() - time_start;
+
+	printf("\t%d filters on %d rows: zbx_prometheus_pattern() %.6f sec, zbx_prometheus_pattern_ex() %.6f sec\n",
+			filters, metrics * rows, time_pattern, time_pattern_ex);
+
+	for (i = 0; i < filters; i++)
+		zbx_free(results[i]);
+	zbx_free(results);
+	zbx_free(data);
+}
@@ -0,0 +1,99 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxregexp.h"
+
+static void	regexp_cache_check_sub(const char *value, const char *pattern, const char *output_template,
+		const char *expected)
+{
+	char	*out = NULL;
+
+	if (SUCCEED != zbx_regexp_sub(value, pattern, output_template, &out))
+		fail_msg("cannot compile regular expression \"%s\"", pattern);
+
+	if (NULL == expected)
+		zbx_mock_assert_ptr_eq("regular expression substitution result", NULL, out);
+	else
+		zbx_mock_assert_str_eq("regular expression substitution result", expected, out);
+
+	zbx_free(out);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t		hsteps, hstep;
+	zbx_regexp_cache_stats_t	stats;
+	int				i, iterations, patterns_num;
+
+	ZBX_UNUSED(state);
+
+	iterations = atoi(zbx_mock_get_parameter_string("in.iterations"));
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.steps", &hsteps))
+	{
+		for (i = 0; i < iterations; i++)
+		{
+			hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+			while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hsteps, &hstep))
+			{
+				zbx_mock_handle_t	hresult;
+				const char		*expected = NULL;
+
+				if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "result", &hresult))
+					expected = zbx_mock_get_object_member_string(hstep, "result");
+
+				regexp_cache_check_sub(zbx_mock_get_object_member_string(hstep, "value"),
+						zbx_mock_get_object_member_string(hstep, "pattern"),
+						zbx_mock_get_object_member_string(hstep, "template"), expected);
+			}
+		}
+	}
+	else
+	{
+		/* generate distinct patterns matching the same value */
+		patterns_num = atoi(zbx_mock_get_parameter_string("in.patterns"));
+
+		for (i = 0; i < iterations; i++)
+		{
+			int	j;
+
+			for (j = 0; j < patterns_num; j++)
+			{
+				char	pattern[64];
+
+				zbx_snprintf(pattern, sizeof(pattern), "^value ([0-9]+)|%d$", j);
+				regexp_cache_check_sub("value 42", pattern, "\\1", "42");
+			}
+		}
+	}
+
+	zbx_regexp_get_cache_stats(&stats);
+
+	zbx_mock_assert_uint64_eq("cache entries", zbx_mock_get_parameter_uint64("out.entries"), stats.entries);
+	zbx_mock_assert_uint64_eq("cache hits", zbx_mock_get_parameter_uint64("out.hits"), stats.hits);
+	zbx_mock_assert_uint64_eq("cache misses", zbx_mock_get_parameter_uint64("out.misses"), stats.misses);
+	zbx_mock_assert_uint64_eq("cache evictions", zbx_mock_get_parameter_uint64("out.evictions"),
+			stats.evictions);
+}
@@ -29,6 +29,8 @@
 int	__wrap_DBis_null(const char *field);
 DB_ROW	__wrap_DBfetch(DB_RESULT result);
 DB_RESULT	__wrap_DBselect(const char *fmt, ...);
+void	__wrap_DBadd_condition_alloc(char **sql, size_t *sql_alloc, size_t *sql_offset, const char *fieldname,
+		const zbx_uint64_t *values, const int num);
 
 int	__wrap_DBis_null(const char *field)
 {
@@ -48,6 +50,17 @@ DB_RESULT	__wrap_DBselect(const char *fmt, ...)
 	return NULL;
 }
 
+void	__wrap_DBadd_condition_alloc(char **sql, size_t *sql_alloc, size_t *sql_offset, const char *fieldname,
+		const zbx_uint64_t *values, const int num)
+{
+	ZBX_UNUSED(sql);
+	ZBX_UNUSED(sql_alloc);
+	ZBX_UNUSED(sql_offset);
+	ZBX_UNUSED(fieldname);
+	ZBX_UNUSED(values);
+	ZBX_UNUSED(num);
+}
+
 static	zbx_mock_handle_t	hout;
 static int			iteration;
 
@@ -0,0 +1,161 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+#include "zbxmockdb.h"
+
+#include "common.h"
+#include "zbxtrends.h"
+#include "log.h"
+#include "db.h"
+#include "mutexs.h"
+
+/* Registers trend function requests, retrieves them with zbx_trends_prefetch() and evaluates the functions. */
+/* The mocked database provides data for a single trends query, so any query done by evaluation fails.       */
+
+extern zbx_uint64_t	CONFIG_TREND_FUNC_CACHE_SIZE;
+
+int	__wrap_DBis_null(const char *field);
+DB_ROW	__wrap_DBfetch(DB_RESULT result);
+DB_RESULT	__wrap_DBselect(const char *fmt, ...);
+void	__wrap_DBadd_condition_alloc(char **sql, size_t *sql_alloc, size_t *sql_offset, const char *fieldname,
+		const zbx_uint64_t *values, const int num);
+
+DB_RESULT	__wrap_zbx_db_vselect(const char *fmt, va_list args);
+DB_ROW	__wrap_zbx_db_fetch(DB_RESULT result);
+
+int	__wrap_DBis_null(const char *field)
+{
+	return NULL == field ? SUCCEED : FAIL;
+}
+
+DB_ROW	__wrap_DBfetch(DB_RESULT result)
+{
+	return __wrap_zbx_db_fetch(result);
+}
+
+DB_RESULT	__wrap_DBselect(const char *fmt, ...)
+{
+	va_list		args;
+	DB_RESULT	result;
+
+	va_start(args, fmt);
+	result = __wrap_zbx_db_vselect(fmt, args);
+	va_end(args);
+
+	return result;
+}
+
+void	__wrap_DBadd_condition_alloc(char **sql, size_t *sql_alloc, size_t *sql_offset, const char *fieldname,
+		const zbx_uint64_t *values, const int num)
+{
+	int	i;
+
+	zbx_snprintf_alloc(sql, sql_alloc, sql_offset, " %s in (", fieldname);
+
+	for (i = 0; i < num; i++)
+		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%s" ZBX_FS_UI64, 0 == i ? "" : ",", values[i]);
+
+	zbx_chrcpy_alloc(sql, sql_alloc, sql_offset, ')');
+}
+
+static int	trend_function_eval(const char *function, zbx_uint64_t itemid, int start, int end, double *value,
+		char **error)
+{
+	if (0 == strcmp(function, "avg"))
+		return zbx_trends_eval_avg("trends", itemid, start, end, value, error);
+	if (0 == strcmp(function, "count"))
+		return zbx_trends_eval_count("trends", itemid, start, end, value, error);
+	if (0 == strcmp(function, "max"))
+		return zbx_trends_eval_max("trends", itemid, start, end, value, error);
+	if (0 == strcmp(function, "min"))
+		return zbx_trends_eval_min("trends", itemid, start, end, value, error);
+	if (0 == strcmp(function, "sum"))
+		return zbx_trends_eval_sum("trends", itemid, start, end, value, error);
+
+	fail_msg("unknown trend function \"%s\"", function);
+
+	return FAIL;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	int			start, end, ret;
+	char			*error = NULL;
+	double			value;
+	zbx_uint64_t		itemid;
+	const char		*function;
+	zbx_mock_handle_t	hrequests, hrequest, herror;
+
+	ZBX_UNUSED(state);
+
+	zbx_mockdb_init();
+
+	CONFIG_TREND_FUNC_CACHE_SIZE = ZBX_MEBIBYTE;
+
+	if (SUCCEED != zbx_locks_create(&error))
+		fail_msg("cannot create locks: %s", error);
+
+	if (SUCCEED != zbx_tfc_init(&error))
+		fail_msg("cannot initialize trend function cache: %s", error);
+
+	start = (int)zbx_mock_get_parameter_uint64("in.start");
+	end = (int)zbx_mock_get_parameter_uint64("in.end");
+
+	hrequests = zbx_mock_get_parameter_handle("in.requests");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrequests, &hrequest))
+	{
+		itemid = zbx_mock_get_object_member_uint64(hrequest, "itemid");
+		function = zbx_mock_get_object_member_string(hrequest, "function");
+		zbx_trends_prefetch_add("trends", itemid, start, end, function);
+	}
+
+	zbx_trends_prefetch();
+
+	hrequests = zbx_mock_get_parameter_handle("out.values");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrequests, &hrequest))
+	{
+		itemid = zbx_mock_get_object_member_uint64(hrequest, "itemid");
+		function = zbx_mock_get_object_member_string(hrequest, "function");
+
+		ret = trend_function_eval(function, itemid, start, end, &value, &error);
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hrequest, "error", &herror))
+		{
+			zbx_mock_assert_result_eq("trend function result", FAIL, ret);
+			zbx_mock_assert_str_eq("trend function error", zbx_mock_get_object_member_string(hrequest,
+					"error"), error);
+			zbx_free(error);
+		}
+		else
+		{
+			zbx_mock_assert_result_eq("trend function result", SUCCEED, ret);
+			zbx_mock_assert_double_eq("trend function value", zbx_mock_get_object_member_float(hrequest,
+					"value"), value);
+		}
+	}
+
+	zbx_tfc_destroy();
+	zbx_mockdb_destroy();
+}
@@ -53,6 +53,8 @@ void	__wrap_zbx_mem_dump_stats(int level, zbx_mem_info_t *info);
 int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
 		zbx_vector_history_record_t *values);
 int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history);
+int	__wrap_zbx_history_get_updated_itemids(int value_type, const zbx_vector_uint64_t *itemids, int clock,
+		zbx_vector_uint64_t *updated);
 int	__wrap_zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
 int	__wrap_zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
 void	__wrap_zbx_elastic_version_extract(void);
@@ -507,7 +509,9 @@ void	zbx_vcmock_free_dc_history(void *ptr)
  */
 
 static zbx_mutex_t	*vc_mutex = NULL;
-zbx_mem_info_t		*vc_meminfo = NULL;
+/* the memory info block is only used to identify the allocator and to report cache statistics */
+static zbx_mem_info_t	vcmock_meminfo;
+zbx_mem_info_t		*vc_meminfo = &vcmock_meminfo;
 
 static size_t		vcmock_mem = ZBX_MEBIBYTE * 1024;
 
@@ -540,7 +544,7 @@ int	__wrap_zbx_mem_create(zbx_mem_info_t **info, zbx_uint64_t size, const char *
 
 void	__wrap_zbx_mem_destroy(zbx_mem_info_t *info)
 {
-	zbx_free(info);
+	zbx_mock_assert_ptr_eq("Attempting to destroy unknown memory info block", vc_meminfo, info);
 }
 
 void	*__wrap___zbx_mem_malloc(const char *file, int line, zbx_mem_info_t *info, const void *old, size_t size)
@@ -669,7 +673,32 @@ int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history)
 		src.timestamp = h->ts;
 		zbx_vcmock_ds_clone_record(&src, h->value_type, &dst);
 		zbx_vector_history_record_append_ptr(&item->data, &dst);
-		zbx_vector_history_record_sort(&item->data, history_compare);
+
+		if (1 < item->data.values_num && 0 < zbx_timespec_compare(
+				&item->data.values[item->data.values_num - 2].timestamp, &dst.timestamp))
+		{
+			zbx_vector_history_record_sort(&item->data, history_compare);
+		}
+	}
+
+	return SUCCEED;
+}
+
+int	__wrap_zbx_history_get_updated_itemids(int value_type, const zbx_vector_uint64_t *itemids, int clock,
+		zbx_vector_uint64_t *updated)
+{
+	zbx_vcmock_ds_item_t	*item;
+	int			i;
+
+	ZBX_UNUSED(value_type);
+
+	for (i = 0; i < itemids->values_num; i++)
+	{
+		if (NULL == (item = zbx_hashset_search(&vc_ds.items, &itemids->values[i])))
+			continue;
+
+		if (0 != item->data.values_num && item->data.values[item->data.values_num - 1].timestamp.sec > clock)
+			zbx_vector_uint64_append(updated, item->itemid);
 	}
 
 	return SUCCEED;
@@ -0,0 +1,76 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2021 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockutil.h"
+#include "zbxmockassert.h"
+#include "common.h"
+#include "zbxvariant.h"
+
+#include "item_preproc_test.h"
+#include "zbxembed.h"
+
+zbx_es_t	es_engine;
+
+/* Steps are executed in the same process one after another, so each step can reuse */
+/* the JSON document validated by the previous steps.                               */
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hsteps, hstep;
+	zbx_mock_error_t	err;
+	zbx_variant_t		value;
+	const char		*path;
+	char			*errmsg = NULL, prefix[MAX_STRING_LEN];
+	int			act_ret, exp_ret, i = 0;
+
+	ZBX_UNUSED(state);
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hsteps, &hstep))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read step #%d: %s", i + 1, zbx_mock_error_string(err));
+
+		zbx_snprintf(prefix, sizeof(prefix), "step #%d", ++i);
+
+		zbx_variant_set_str(&value, zbx_strdup(NULL, zbx_mock_get_object_member_string(hstep, "value")));
+		path = zbx_mock_get_object_member_string(hstep, "path");
+
+		act_ret = zbx_item_preproc_jsonpath(&value, path, &errmsg);
+
+		exp_ret = zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hstep, "return"));
+		zbx_mock_assert_int_eq(prefix, exp_ret, act_ret);
+
+		if (FAIL == act_ret)
+		{
+			zbx_mock_assert_ptr_ne(prefix, NULL, errmsg);
+			zbx_free(errmsg);
+		}
+		else
+		{
+			zbx_mock_assert_str_eq(prefix, zbx_mock_get_object_member_string(hstep, "result"),
+					value.data.str);
+		}
+
+		zbx_variant_clear(&value);
+	}
+}
@@ -28,3 +28,8 @@ int	zbx_item_preproc_csv_to_json(zbx_variant_t *value, const char *params, char
 {
 	return item_preproc_csv_to_json(value, params, errmsg);
 }
+
+int	zbx_item_preproc_jsonpath(zbx_variant_t *value, const char *params, char **errmsg)
+{
+	return item_preproc_jsonpath(value, params, errmsg);
+}
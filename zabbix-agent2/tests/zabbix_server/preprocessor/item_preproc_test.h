@@ -21,5 +21,6 @@
 
 int	zbx_item_preproc_xpath(zbx_variant_t *value, const char *params, char **errmsg);
 int	zbx_item_preproc_csv_to_json(zbx_variant_t *value, const char *params, char **errmsg);
+int	zbx_item_preproc_jsonpath(zbx_variant_t *value, const char *params, char **errmsg);
 
 #endif
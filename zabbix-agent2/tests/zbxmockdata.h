@@ -55,6 +55,9 @@ zbx_mock_error_t	zbx_mock_in_parameter(const char *name, zbx_mock_handle_t *para
 zbx_mock_error_t	zbx_mock_out_parameter(const char *name, zbx_mock_handle_t *parameter);
 zbx_mock_error_t	zbx_mock_db_rows(const char *data_source, zbx_mock_handle_t *rows);
 zbx_mock_error_t	zbx_mock_file(const char *path, zbx_mock_handle_t *file);
+void			zbx_mock_file_passthrough(const char *prefix);
+void			zbx_mock_read_passthrough(int fd);
+void			zbx_mock_socket_passthrough(int enable);
 zbx_mock_error_t	zbx_mock_exit_code(int *status);
 zbx_mock_error_t	zbx_mock_object_member(zbx_mock_handle_t object, const char *name, zbx_mock_handle_t *member);
 zbx_mock_error_t	zbx_mock_vector_element(zbx_mock_handle_t vector, zbx_mock_handle_t *element);
@@ -25,10 +25,12 @@
 
 #define zbx_db_vselect	__wrap_zbx_db_vselect
 #define zbx_db_fetch	__wrap_zbx_db_fetch
+#define zbx_db_vexecute	__wrap_zbx_db_vexecute
 #define DBfree_result	__wrap_DBfree_result
 #include "zbxdb.h"
 #undef zbx_db_vselect
 #undef zbx_db_fetch
+#undef zbx_db_vexecute
 #undef DBfree_result
 
 #define __zbx_DBexecute			__wrap___zbx_DBexecute
@@ -131,6 +133,9 @@ static char	*generate_data_source(const char *sql)
 			break;
 	}
 
+	if (0 != found)
+		*(ptr_ds++) = ' ';	/* the last table name ends the query */
+
 	if (ptr_ds == data_source)
 		zbx_free(data_source);	/* failed to generate data_source */
 	else
@@ -274,6 +279,17 @@ int	__wrap___zbx_DBexecute(const char *fmt, ...)
 	return 0;
 }
 
+int	__wrap_zbx_db_vexecute(const char *fmt, va_list args)
+{
+	char	*sql;
+
+	sql = zbx_dvsprintf(NULL, fmt, args);
+	printf("\tSQL: %s\n", sql);
+	zbx_free(sql);
+
+	return ZBX_DB_OK;
+}
+
 int	__wrap_DBexecute_multiple_query(const char *query, const char *field_name, zbx_vector_uint64_t *ids)
 {
 	ZBX_UNUSED(query);
@@ -36,6 +36,9 @@
 void	*mock_streams[ZBX_MOCK_MAX_FILES];
 
 static zbx_mock_handle_t	fragments;
+static const char		*passthrough_prefix = NULL;
+static int			passthrough_fd = -1;
+static int			passthrough_sockets = 0;
 
 struct zbx_mock_IO_FILE
 {
@@ -52,7 +55,9 @@ int	__wrap_stat(const char *path, struct stat *buf);
 int	__wrap___xstat(int ver, const char *pathname, struct stat *buf);
 int	__wrap___fxstat(int __ver, int __fildes, struct stat *__stat_buf);
 
+int	__real_connect(int socket, __CONST_SOCKADDR_ARG addr, socklen_t address_len);
 int	__real_open(const char *path, int oflag, ...);
+ssize_t	__real_read(int fildes, void *buf, size_t nbyte);
 int	__real_stat(const char *path, struct stat *buf);
 int	__real___fxstat(int __ver, int __fildes, struct stat *__stat_buf);
 
@@ -72,6 +77,58 @@ static int	is_profiler_path(const char *path)
 	return FAIL;
 }
 
+static int	is_real_path(const char *path)
+{
+	if (NULL != passthrough_prefix && 0 == strncmp(path, passthrough_prefix, strlen(passthrough_prefix)))
+		return SUCCEED;
+
+	return is_profiler_path(path);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mock_file_passthrough                                        *
+ *                                                                            *
+ * Purpose: sets path prefix of files that are accessed in file system        *
+ *          instead of test case data                                         *
+ *                                                                            *
+ * Parameters: prefix - [IN] the path prefix, NULL to disable pass-through    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_file_passthrough(const char *prefix)
+{
+	passthrough_prefix = prefix;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mock_read_passthrough                                        *
+ *                                                                            *
+ * Purpose: sets file descriptor that is read from instead of test case data  *
+ *                                                                            *
+ * Parameters: fd - [IN] the file descriptor, -1 to disable pass-through      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_read_passthrough(int fd)
+{
+	passthrough_fd = fd;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mock_socket_passthrough                                      *
+ *                                                                            *
+ * Purpose: makes connect() and read() use system calls for all descriptors   *
+ *          instead of test case data                                         *
+ *                                                                            *
+ * Parameters: enable - [IN] 1 to enable pass-through, 0 to disable           *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_socket_passthrough(int enable)
+{
+	passthrough_sockets = enable;
+}
+
 static int	is_mock_stream(FILE *stream)
 {
 	int	i;
@@ -92,7 +149,7 @@ FILE	*__wrap_fopen(const char *path, const char *mode)
 	const char		*contents;
 	struct zbx_mock_IO_FILE	*file = NULL;
 
-	if (SUCCEED == is_profiler_path(path))
+	if (SUCCEED == is_real_path(path))
 		return __real_fopen(path, mode);
 
 	if (0 != strcmp(mode, "r"))
@@ -172,9 +229,8 @@ int	__wrap_connect(int socket, __CONST_SOCKADDR_ARG addr, socklen_t address_len)
 {
 	zbx_mock_error_t	error;
 
-	ZBX_UNUSED(socket);
-	ZBX_UNUSED(addr);
-	ZBX_UNUSED(address_len);
+	if (0 != passthrough_sockets)
+		return __real_connect(socket, addr, address_len);
 
 	if (ZBX_MOCK_SUCCESS != (error = zbx_mock_in_parameter("fragments", &fragments)))
 		fail_msg("Cannot get fragments handle: %s", zbx_mock_error_string(error));
@@ -184,7 +240,7 @@ int	__wrap_connect(int socket, __CONST_SOCKADDR_ARG addr, socklen_t address_len)
 
 int	__wrap_open(const char *path, int oflag, ...)
 {
-	if (SUCCEED == is_profiler_path(path))
+	if (SUCCEED == is_real_path(path))
 	{
 		va_list	args;
 		int	fd;
@@ -208,6 +264,10 @@ int	__wrap_open(const char *path, int oflag, ...)
  *           functionality like it's done with open/fxstat etc functions for  *
  *           coverage builds.                                                 *
  *                                                                            *
+ *           File descriptor set by zbx_mock_read_passthrough() and all       *
+ *           descriptors after zbx_mock_socket_passthrough() are read         *
+ *           directly.                                                        *
+ *                                                                            *
  ******************************************************************************/
 ssize_t	__wrap_read(int fildes, void *buf, size_t nbyte)
 {
@@ -217,7 +277,8 @@ ssize_t	__wrap_read(int fildes, void *buf, size_t nbyte)
 	zbx_mock_handle_t	fragment;
 	size_t			length;
 
-	ZBX_UNUSED(fildes);
+	if (0 != passthrough_sockets || (-1 != passthrough_fd && fildes == passthrough_fd))
+		return __real_read(fildes, buf, nbyte);
 
 	if (0 == remaining_length)
 	{
@@ -251,7 +312,7 @@ int	__wrap_stat(const char *path, struct stat *buf)
 	zbx_mock_error_t	error;
 	zbx_mock_handle_t	handle;
 
-	if (SUCCEED == is_profiler_path(path))
+	if (SUCCEED == is_real_path(path))
 		return __real_stat(path, buf);
 
 	if (ZBX_MOCK_SUCCESS == (error = zbx_mock_file(path, &handle)))
@@ -277,7 +338,7 @@ int	__wrap___xstat(int ver, const char *pathname, struct stat *buf)
 {
 	ZBX_UNUSED(ver);
 
-	if (SUCCEED == is_profiler_path(pathname))
+	if (SUCCEED == is_real_path(pathname))
 		return __real_stat(pathname, buf);
 
 	return __wrap_stat(pathname, buf);
@@ -62,6 +62,7 @@ int	CONFIG_PROBLEMHOUSEKEEPER_FORKS = 0;
 int	CONFIG_LISTEN_PORT		= 0;
 char	*CONFIG_LISTEN_IP		= NULL;
 char	*CONFIG_SOURCE_IP		= NULL;
+char	*CONFIG_SERVER			= NULL;
 int	CONFIG_TRAPPER_TIMEOUT		= 300;
 
 int	CONFIG_HOUSEKEEPING_FREQUENCY	= 1;
@@ -83,12 +84,19 @@ zbx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE	= 4 * 0;
 zbx_uint64_t	CONFIG_TRENDS_CACHE_SIZE	= 4 * 0;
 zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE		= 8 * 0;
 zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * 0;
+zbx_uint64_t	CONFIG_PROXY_MEMORY_BUFFER_SIZE	= 0;
 zbx_uint64_t	CONFIG_EXPORT_FILE_SIZE;
 zbx_uint64_t	CONFIG_TREND_FUNC_CACHE_SIZE	= 0;
+char	*CONFIG_TREND_FUNC_CACHE_FILE	= NULL;
+
+int	CONFIG_VALUE_CACHE_COMPRESSION	= 0;
+int	CONFIG_VALUE_CACHE_AGGREGATES	= 0;
+char	*CONFIG_VALUE_CACHE_FILE	= NULL;
 
 int	CONFIG_UNREACHABLE_PERIOD	= 45;
 int	CONFIG_UNREACHABLE_DELAY	= 15;
 int	CONFIG_UNAVAILABLE_DELAY	= 60;
+int	CONFIG_ASYNC_AGENT_CHECKS	= 0;
 int	CONFIG_LOG_LEVEL		= 0;
 char	*CONFIG_ALERT_SCRIPTS_PATH	= NULL;
 char	*CONFIG_EXTERNALSCRIPTS		= NULL;
@@ -176,6 +184,8 @@ char	*CONFIG_SOCKET_PATH			= NULL;
 char	*CONFIG_HISTORY_STORAGE_URL		= NULL;
 char	*CONFIG_HISTORY_STORAGE_OPTS		= NULL;
 int	CONFIG_HISTORY_STORAGE_PIPELINES	= 0;
+int	CONFIG_HISTORY_BULK_LOAD		= 0;
+int	CONFIG_HISTORY_PIPELINED_COMMIT	= 0;
 
 /* not used in tests, defined for linking with comms.c */
 int	CONFIG_TCP_MAX_BACKLOG_SIZE	= SOMAXCONN;